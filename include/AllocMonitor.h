@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cstdint>
+
+#define ALLOC_MONITOR_SLOT_COUNT 16
+
+// Steady-state allocation budget. The whole firmware idling with MQTT
+// and one websocket client connected should stay well below this;
+// exceeding it for a full accounting window indicates heap churn
+// sneaked into a hot path (pass-by-value Strings and the like).
+#ifndef ALLOC_MONITOR_BUDGET_PER_SECOND
+#define ALLOC_MONITOR_BUDGET_PER_SECOND 200
+#endif
+
+// Heap churn accounting. malloc/calloc/realloc are intercepted at link
+// time (-Wl,--wrap, same mechanism CrashRecorder uses for the panic
+// handler) and attributed to the calling FreeRTOS task, which maps the
+// counters onto subsystems: the main loop task carries the scheduler
+// callbacks, async_tcp the web handlers, the radio loop tasks the
+// polling path. A once-a-minute check compares the global rate against
+// the steady-state budget and logs the top allocating task when it is
+// exceeded. Counts cover everything linked into the application;
+// allocations made internally by the prebuilt IDF libraries bypass the
+// wrap and are not seen. Results are exposed on /api/system/tasks.
+class AllocMonitorClass {
+public:
+    AllocMonitorClass();
+    void init(Scheduler& scheduler);
+
+    // Called from the malloc wrappers; must be ISR- and pre-scheduler-safe
+    void count();
+
+    uint32_t getTotalAllocations() const { return _totalAllocations.load(std::memory_order_relaxed); }
+
+    void serialize(JsonObject root);
+
+private:
+    void loop();
+
+    Task _loopTask;
+
+    struct Slot {
+        std::atomic<TaskHandle_t> handle = nullptr;
+        std::atomic<uint32_t> allocations = 0;
+    };
+
+    Slot _slots[ALLOC_MONITOR_SLOT_COUNT];
+    std::atomic<uint32_t> _totalAllocations = 0;
+    std::atomic<uint32_t> _unattributed = 0;
+
+    uint32_t _windowBaseline = 0;
+    uint32_t _slotWindowBaseline[ALLOC_MONITOR_SLOT_COUNT] = {};
+};
+
+extern AllocMonitorClass AllocMonitor;
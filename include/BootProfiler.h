@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstdint>
+
+#define BOOT_PROFILE_MAX_STAGES 24
+#define BOOT_PROFILE_NAME_STRLEN 23
+
+// Per-stage boot timing. Each mark() records the microsecond timestamp
+// at which an init stage in setup() completed. The profile lives in RTC
+// noinit memory, so after a watchdog or software reset the (possibly
+// partial) profile of the previous boot is still available and exposed
+// via /api/system/status alongside the current one.
+class BootProfilerClass {
+public:
+    struct Stage {
+        char name[BOOT_PROFILE_NAME_STRLEN + 1];
+        uint32_t timestampUs;
+    };
+
+    struct Profile {
+        uint32_t magic;
+        uint32_t count;
+        Stage stages[BOOT_PROFILE_MAX_STAGES];
+    };
+
+    // Must be called first thing in setup(): saves the previous boot's
+    // profile and starts recording the current one
+    void begin();
+    void mark(const char* name);
+
+    void serialize(JsonObject root) const;
+
+private:
+    static void serializeProfile(const Profile& profile, JsonArray stages);
+
+    Profile _previousBoot;
+    bool _previousBootValid = false;
+};
+
+extern BootProfilerClass BootProfiler;
@@ -2,12 +2,24 @@
 #pragma once
 
 #include "PinMapping.h"
+#include <ArduinoJson.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #define CONFIG_FILENAME "/config.json"
+#define CONFIG_EXPORT_FILENAME "/config_export.json" // backup download staging, never imported
+#define CONFIG_SNAPSHOT_FILENAME "/config.bin" // legacy single-slot snapshot, removed at boot
+#define CONFIG_SNAPSHOT_SLOT_A "/config.a.bin"
+#define CONFIG_SNAPSHOT_SLOT_B "/config.b.bin"
+#define CONFIG_SECTION_FILENAME_PREFIX "/cfg_"
+#define CONFIG_SECTION_COUNT 12
 #define CONFIG_VERSION 0x00011e00 // 0.1.30 // make sure to clean all after change
 
 #define WIFI_MAX_SSID_STRLEN 32
@@ -16,6 +28,8 @@
 
 #define SYSLOG_MAX_HOSTNAME_STRLEN 128
 
+#define FEDERATION_MAX_HOSTNAME_STRLEN 128
+
 #define NTP_MAX_SERVER_STRLEN 31
 #define NTP_MAX_TIMEZONE_STRLEN 50
 #define NTP_MAX_TIMEZONEDESCR_STRLEN 50
@@ -91,6 +105,13 @@ struct CONFIG_T {
         uint16_t Port;
     } Syslog;
 
+    struct {
+        bool Enabled;
+        uint8_t Role; // 0 = primary (receives), 1 = secondary (streams)
+        char PeerHostname[FEDERATION_MAX_HOSTNAME_STRLEN + 1];
+        uint16_t Port;
+    } Federation;
+
     struct {
         char Server[NTP_MAX_SERVER_STRLEN + 1];
         char Timezone[NTP_MAX_TIMEZONE_STRLEN + 1];
@@ -110,7 +131,11 @@ struct CONFIG_T {
         char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
         bool Retain;
         uint32_t PublishInterval;
+        uint32_t FullPublishInterval;
         bool CleanSession;
+        bool CompactJson;
+        bool CompactJsonCompress;
+        uint32_t LimitCoalesceWindow;
 
         struct {
             char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
@@ -182,14 +207,67 @@ struct CONFIG_T {
     } Logging;
 };
 
+// Scopes for the config change bus. Inverter events carry the slot
+// index, every other scope passes -1.
+enum class ConfigScope : uint8_t {
+    All,
+    Wifi,
+    Mdns,
+    Syslog,
+    Ntp,
+    Mqtt,
+    Dtu,
+    Security,
+    Device,
+    Inverter,
+    Logging,
+};
+
 class ConfigurationClass {
 public:
     void init(Scheduler& scheduler);
     bool read();
     bool write();
+
+    // Change notification bus: subsystems register once at init and are
+    // called synchronously from notifyConfigChanged(), so they can
+    // reconfigure only what a settings edit actually touched instead of
+    // tearing everything down. Callbacks are never unregistered.
+    using ConfigChangeCallback = std::function<void(const ConfigScope scope, const int8_t index)>;
+    void onConfigChanged(const ConfigChangeCallback& cb);
+    void notifyConfigChanged(const ConfigScope scope, const int8_t index = -1);
+
+    // Write-behind: marks the configuration dirty and returns
+    // immediately; the loop task commits to flash once the debounce
+    // window has passed, coalescing rapid successive edits (e.g. a bulk
+    // channel rename) into a single commit.
+    void requestWrite();
+    // Commits a pending write-behind save synchronously, used before a
+    // restart
+    void flushPendingWrites();
+
+    // Regenerates the monolithic backup document for download, under
+    // CONFIG_EXPORT_FILENAME. The persistent store is the per-section
+    // files; a monolith at CONFIG_FILENAME is treated as a fresh
+    // import at boot and wins over them, so the export deliberately
+    // lives under a name read() never scans - otherwise downloading a
+    // backup would arm a silent config rollback for the next reboot.
+    bool writeExportFile();
+
     void migrate();
     CONFIG_T const& get();
 
+    // Copy-on-write snapshot: an immutable, refcounted copy of the
+    // configuration, rebuilt and swapped atomically whenever a writer
+    // commits. Hot loops hold the pointer for the duration of one pass
+    // and get a consistent view for the price of a pointer load,
+    // without serializing against writers.
+    std::shared_ptr<const CONFIG_T> getSnapshot() const;
+
+    // Serial lookup against a snapshot; returns nullptr when the serial
+    // is not configured
+    static const INVERTER_CONFIG_T* getInverterConfig(const CONFIG_T& cfg, const uint64_t serial);
+
     class WriteGuard {
     public:
         WriteGuard();
@@ -209,9 +287,50 @@ public:
     int8_t getIndexForLogModule(const String& moduleName) const;
 
 private:
+    void serializeSections(JsonDocument& doc);
+    // Fills doc from the monolithic config.json when it exists (returns
+    // true), otherwise from the per-section files (returns false)
+    bool loadDocument(JsonDocument& doc);
+    static String sectionFilename(const uint8_t section);
+
+    // Binary boot fast path: a checksummed dump of the CONFIG_T struct,
+    // loaded instead of parsing JSON when magic, version, size and CRC
+    // match. Two slots are written alternately with a rising sequence
+    // number; a commit never truncates the currently valid slot, so a
+    // power loss mid-write leaves either the previous or the new
+    // configuration fully intact. Boot picks the newest valid slot.
+    bool readSnapshot();
+    bool writeSnapshot();
+    void ensureDtuSerial();
+
     void loop();
 
     Task _loopTask;
+
+    // CRC of each section as last written, so an unchanged section
+    // never touches flash again
+    uint32_t _sectionCrc[CONFIG_SECTION_COUNT] = { 0 };
+    std::atomic<bool> _snapshotDirty = false;
+    uint32_t _snapshotSequence = 0;
+    uint8_t _snapshotSlot = 0; // slot holding the newest valid snapshot
+
+    std::atomic<bool> _writePending = false;
+    std::atomic<uint32_t> _lastWriteRequest = 0;
+
+    // Serial -> inverter slot lookup, rebuilt whenever the config
+    // changes so getInverterConfig() stays constant-time in the
+    // aggregation hot loops
+    void rebuildInverterIndex();
+    std::unordered_map<uint64_t, uint8_t> _inverterIndex;
+    std::mutex _inverterIndexMutex;
+
+    // Rebuilds the copy-on-write snapshot from the live struct; called
+    // from rebuildInverterIndex() since that already marks every
+    // mutation site
+    void refreshSnapshot();
+    std::shared_ptr<const CONFIG_T> _snapshot;
+
+    std::vector<ConfigChangeCallback> _changeCallbacks;
 };
 
 extern ConfigurationClass Configuration;
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+
+#define CRASH_RECORDER_BACKTRACE_DEPTH 16
+#define CRASH_RECORDER_TASK_SLOTS 8
+#define CRASH_RECORDER_EVENT_SLOTS 16
+#define CRASH_RECORDER_TASK_NAME_STRLEN 15
+#define CRASH_RECORDER_EVENT_STRLEN 31
+#define CRASH_RECORDER_REASON_STRLEN 31
+
+// Lightweight crash forensics. A record in RTC noinit memory carries
+// the panic backtrace (written by a wrapped esp_panic_handler, see
+// -Wl,--wrap in platformio.ini), a periodically refreshed heap/task
+// health snapshot and a small ring of lifecycle events. After a panic
+// or watchdog reset the previous boot's record is exposed via
+// /api/system/status, so field crashes no longer have to be reproduced
+// to at least know where the device died and how the heap looked.
+class CrashRecorderClass {
+public:
+    struct TaskWatermark {
+        char name[CRASH_RECORDER_TASK_NAME_STRLEN + 1];
+        uint32_t stackWatermark;
+    };
+
+    struct Event {
+        uint32_t uptimeMs;
+        char text[CRASH_RECORDER_EVENT_STRLEN + 1];
+    };
+
+    struct Record {
+        uint32_t magic;
+        uint8_t flags;
+
+        // written by the panic handler
+        char reason[CRASH_RECORDER_REASON_STRLEN + 1];
+        uint32_t faultAddr;
+        uint32_t backtrace[CRASH_RECORDER_BACKTRACE_DEPTH];
+        uint8_t backtraceDepth;
+        bool backtraceCorrupt;
+
+        // periodic health snapshot (watchdog resets skip the panic
+        // handler - this is all we get for those)
+        uint32_t uptimeS;
+        uint32_t heapFree;
+        uint32_t heapMinFree;
+        uint32_t heapMaxBlock;
+        TaskWatermark tasks[CRASH_RECORDER_TASK_SLOTS];
+        uint8_t taskCount;
+
+        // flight recorder of recent lifecycle events
+        Event events[CRASH_RECORDER_EVENT_SLOTS];
+        uint32_t eventSequence;
+    };
+
+    static constexpr uint8_t FLAG_CLEAN_SHUTDOWN = 1 << 0;
+    static constexpr uint8_t FLAG_PANIC = 1 << 1;
+
+    CrashRecorderClass();
+
+    // Must be called early in setup(): saves the previous boot's record
+    // if it did not end in a clean restart, then starts a fresh one
+    void init(Scheduler& scheduler);
+
+    // Appends a lifecycle event to the flight recorder, e.g. "network
+    // connected". Not synchronized: concurrent callers may overwrite
+    // each other's slot, which is acceptable for rare lifecycle events.
+    void note(const char* text);
+
+    bool hasReport() const { return _previousValid; }
+    void serialize(JsonObject root) const;
+
+private:
+    void loop();
+
+    Task _snapshotTask;
+    Record _previous;
+    bool _previousValid = false;
+};
+
+extern CrashRecorderClass CrashRecorder;
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <Hoymiles.h>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+// Daily per-channel statistics in constant space: minimum and maximum
+// with their time of day for DC power and voltage, plus a P-squared
+// median sketch for power - no sample storage, O(channels) memory.
+// Samples are taken whenever the statistics parser received a fresh
+// payload; everything resets at local midnight once the clock is
+// synced.
+class DailyStatsClass {
+public:
+    struct ChannelDailyStats_t {
+        uint32_t samples;
+        float powerMin;
+        float powerMax;
+        float powerMedian;
+        time_t powerMinAt;
+        time_t powerMaxAt;
+        float voltageMin;
+        float voltageMax;
+        time_t voltageMinAt;
+        time_t voltageMaxAt;
+    };
+
+    // Registers the sampling visitor with FleetWalk
+    void init();
+
+    // Copies the running day's statistics of one DC channel; false if
+    // no sample was recorded for it yet today
+    bool getChannelStats(const uint64_t serial, const uint8_t channel, ChannelDailyStats_t& stats);
+
+    // Start of the running accumulation day (epoch); 0 before the
+    // first midnight rollover or clock sync
+    time_t getDayStart();
+
+private:
+    // FleetWalk visitor: beginPass handles the midnight rollover and
+    // pins the sample timestamp, visit samples one inverter
+    bool beginPass();
+    void visit(std::shared_ptr<InverterAbstract>& inv, const uint8_t pos);
+
+    struct Extreme_t {
+        float min = 0;
+        float max = 0;
+        time_t minAt = 0;
+        time_t maxAt = 0;
+    };
+
+    // P-squared single-quantile estimator (median); five markers,
+    // constant space regardless of sample count
+    struct QuantileSketch_t {
+        float q[5] = {};
+        int32_t n[5] = {};
+        float np[5] = {};
+        uint32_t count = 0;
+    };
+
+    struct ChannelDaily_t {
+        uint32_t samples = 0;
+        Extreme_t power;
+        Extreme_t voltage;
+        QuantileSketch_t powerSketch;
+    };
+
+    struct InverterDaily_t {
+        uint64_t serial = 0;
+        uint32_t lastUpdate = 0;
+        ChannelDaily_t channels[CH_CNT];
+    };
+
+    // Returns the slot of the serial, claiming a free one on first
+    // sight; nullptr once all slots are taken
+    InverterDaily_t* getSlot(const uint64_t serial);
+    void resetAll();
+
+    static void recordExtreme(Extreme_t& extreme, const float value, const time_t now, const bool first);
+    static void sketchAdd(QuantileSketch_t& sketch, const float value);
+    static float sketchEstimate(const QuantileSketch_t& sketch);
+
+    std::mutex _mutex;
+    InverterDaily_t _slots[INV_MAX_COUNT];
+    int _lastDay = -1;
+    time_t _dayStart = 0;
+    time_t _passNow = 0;
+};
+
+extern DailyStatsClass DailyStats;
@@ -2,7 +2,10 @@
 #pragma once
 
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <functional>
 #include <mutex>
+#include <vector>
 
 class DatastoreClass {
 public:
@@ -57,6 +60,69 @@ public:
     // True if all enabled inverters are reachable
     bool getIsAllEnabledReachable();
 
+    // Invoked from the main loop whenever one of the aggregate fleet
+    // state booleans above changed; listeners may call the getters.
+    void onFleetStateChanged(std::function<void()> listener);
+
+    // Coherent copy of all fleet totals and aggregate flags from one
+    // producer pass. Readers never touch the datastore mutex: the copy
+    // is guarded by a sequence counter instead, so display, MQTT and
+    // websocket consumers can take a full snapshot without blocking on
+    // (or serializing behind) the aggregation loop.
+    struct TotalsSnapshot_t {
+        float AcPowerEnabled = 0;
+        float AcYieldDayEnabled = 0;
+        float AcYieldTotalEnabled = 0;
+        float DcPowerEnabled = 0;
+        float DcIrradiation = 0;
+        float DcPowerIrradiation = 0;
+        float DcIrradiationInstalled = 0;
+        uint32_t AcPowerDigits = 0;
+        uint32_t AcYieldDayDigits = 0;
+        uint32_t AcYieldTotalDigits = 0;
+        uint32_t DcPowerDigits = 0;
+        bool IsAtLeastOneReachable = false;
+        bool IsAtLeastOneProducing = false;
+        bool IsAllEnabledReachable = false;
+        bool IsAllEnabledProducing = false;
+        bool IsAtLeastOnePollEnabled = false;
+    };
+
+    TotalsSnapshot_t getTotalsSnapshot() const;
+
+    // Inputs a derived metric may depend on. Each aggregation pass
+    // tracks which of them actually changed and only recomputes the
+    // metrics whose dependency mask intersects the changed set.
+    enum DerivedMetricInput : uint32_t {
+        METRIC_INPUT_AC_POWER = 1 << 0,
+        METRIC_INPUT_DC_POWER = 1 << 1,
+        METRIC_INPUT_AC_YIELD_DAY = 1 << 2,
+        METRIC_INPUT_AC_YIELD_TOTAL = 1 << 3,
+        METRIC_INPUT_DC_IRRADIATION = 1 << 4,
+        METRIC_INPUT_FLEET_STATE = 1 << 5,
+    };
+
+    struct DerivedMetricValue_t {
+        const char* name;
+        const char* unit;
+        float value;
+        bool valid;
+    };
+
+    static constexpr size_t MAX_DERIVED_METRICS = 16;
+
+    // Registers a derived metric computed on the aggregation pass. name
+    // and unit must be string literals (they end up as MQTT topic and
+    // Prometheus label); compute must be a pure function of the passed
+    // snapshot. Call during setup() - registration is not guarded
+    // against a concurrently running aggregation pass.
+    void registerDerivedMetric(const char* name, const char* unit, const uint32_t dependsOn,
+        std::function<float(const TotalsSnapshot_t&)> compute);
+
+    // Copies the current derived metric values; entries stay invalid
+    // until the first aggregation pass after registration
+    size_t copyDerivedMetrics(DerivedMetricValue_t out[], const size_t maxCount);
+
 private:
     void loop();
 
@@ -80,6 +146,23 @@ private:
     bool _isAllEnabledProducing = false;
     bool _isAllEnabledReachable = false;
     bool _isAtLeastOnePollEnabled = false;
+
+    std::vector<std::function<void()>> _fleetStateListeners;
+
+    struct DerivedMetric_t {
+        const char* name;
+        const char* unit;
+        uint32_t dependsOn;
+        std::function<float(const TotalsSnapshot_t&)> compute;
+        float value = 0;
+        bool valid = false;
+    };
+
+    std::vector<DerivedMetric_t> _derivedMetrics;
+
+    // seqlock guarding _totalsSnapshot; odd while the producer writes
+    std::atomic<uint32_t> _snapshotSeq = 0;
+    TotalsSnapshot_t _totalsSnapshot;
 };
 
 extern DatastoreClass Datastore;
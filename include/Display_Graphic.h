@@ -50,13 +50,24 @@ public:
     bool enableScreensaver = true;
 
 private:
-    void loop();
+    void composeLoop();
+    void blitLoop();
     void printText(const char* text, const uint8_t line);
     void calcLineHeights();
     void setFont(const uint8_t line);
     bool isValidDisplay();
-
-    Task _loopTask;
+    void markRowsDirty(const uint8_t yTop, const uint8_t yBottom, uint8_t& rowMask);
+    bool supportsPartialUpdate();
+    void pushDirtyRows(const uint8_t rowMask);
+    void rebuildScreensaverTable();
+    void wakeFromNightBlank();
+
+    // composition and blit run as separate tasks: the compose tick
+    // renders into the RAM framebuffer, the blit task pushes the result
+    // over I2C/SPI in its own slice, so the bus transfer never extends
+    // the tick that also did the drawing.
+    Task _composeTask;
+    Task _blitTask;
 
     U8G2* _display;
     DisplayGraphicDiagramClass _diagram;
@@ -70,9 +81,42 @@ private:
     const uint16_t _period = 1000;
     const uint16_t _interval = 60000; // interval at which to power save (milliseconds)
     uint32_t _previousMillis = 0;
-    char _fmtText[32];
     bool _isLarge = false;
+    uint8_t _rotation = DISPLAY_ROTATION;
     uint8_t _lineOffsets[5];
+    uint8_t _lineTop[4];
+    uint8_t _lineBottom[4];
+
+    // the frame as last pushed to the glass. comparing the freshly
+    // composed frame against it tells us which tile rows changed - on
+    // most ticks nothing does and the bus transfer is skipped entirely.
+    char _renderedLines[4][32] = {};
+
+    // per-line memo of the computed base x position, so the U8g2
+    // string width calculation only runs when a line's text changes.
+    // invalidated on rotation and diagram mode changes (the centering
+    // geometry depends on both); locale changes alter the text itself.
+    char _layoutText[4][32] = {};
+    uint8_t _layoutX[4] = {};
+    bool _renderedShowDiagram = false;
+    bool _renderedDiagramFullscreen = false;
+    uint32_t _renderedDiagramGeneration = 0;
+    bool _forceFullRedraw = true;
+
+    // handoff from compose to blit; dirty rows accumulate in case the
+    // blit did not run yet when the next frame is composed
+    uint8_t _pendingRows = 0;
+    bool _pendingFullPush = false;
+    bool _lastPowerSave = false;
+
+    // anti-burn-in pixel-shift pattern, rebuilt on orientation changes;
+    // the per-frame work is a single table lookup indexed by _mExtra
+    int8_t _screensaverOffsets[16] = {};
+    uint8_t _screensaverPeriod = 16;
+
+    // true while the display is blanked for the night period and the
+    // compose task is suspended
+    bool _nightBlank = false;
 
     String _i18n_offline;
     String _i18n_yield_today_kwh;
@@ -4,6 +4,8 @@
 #include <TaskSchedulerDeclarations.h>
 #include <U8g2lib.h>
 #include <array>
+#include <deque>
+#include <utility>
 
 #define MAX_DATAPOINTS 128
 
@@ -16,6 +18,10 @@ public:
 
     void updatePeriod();
 
+    // bumped whenever the chart contents change; lets the caller skip
+    // redrawing an unchanged diagram
+    uint32_t getGeneration() const { return _generation; }
+
 private:
     void averageLoop();
     void dataPointLoop();
@@ -33,4 +39,19 @@ private:
 
     float _iRunningAverage = 0;
     uint16_t _iRunningAverageCnt = 0;
+
+    uint32_t _generation = 0;
+
+    // running maximum over the visible history as a monotonic deque of
+    // (sample number, value) pairs: amortized O(1) per appended or
+    // evicted sample instead of rescanning the whole array on redraw
+    std::deque<std::pair<uint32_t, float>> _maxDeque;
+    uint32_t _sampleNumber = 0; // absolute number of the next sample
+
+    // chart column heights in pixels, scaled once per sample and only
+    // rescaled when the y-scale (maximum or chart height) changes
+    std::array<uint8_t, MAX_DATAPOINTS> _scaledValues = {};
+    uint8_t _scaledCount = 0;
+    float _scaledMax = -1;
+    uint8_t _scaledHeight = 0;
 };
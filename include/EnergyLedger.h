@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <Hoymiles.h>
+#include <Preferences.h>
+#include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <mutex>
+
+// Commit a channel's accumulator to NVS once it advanced this far past
+// the stored value. The threshold bounds write amplification: flash
+// sees one small write per produced energy quantum, independent of
+// uptime and polling rate. After an unplanned reboot at most this much
+// energy per channel is missing from the restored value.
+#ifndef ENERGY_LEDGER_COMMIT_DELTA_WH
+#define ENERGY_LEDGER_COMMIT_DELTA_WH 25.0
+#endif
+
+// Upper bound of one integration step; a longer gap (scheduler stall,
+// radio outage) is skipped instead of integrated as constant power
+#define ENERGY_LEDGER_MAX_STEP_MS 10000
+
+// Local energy ledger: monotonic Wh accumulators per inverter DC
+// channel, integrated from the power snapshots the statistics parser
+// keeps current. Unlike YieldDay/YieldTotal these counters do not
+// depend on the inverter's own counters surviving resets, and they
+// survive our reboots via NVS-backed delta commits.
+class EnergyLedgerClass {
+public:
+    EnergyLedgerClass();
+    void init(Scheduler& scheduler);
+
+    // Monotonic accumulated energy of one DC channel in Wh
+    double getChannelEnergyWh(const uint64_t serial, const uint8_t channel) const;
+
+    // Sum over all DC channels of the inverter
+    double getInverterEnergyWh(const uint64_t serial) const;
+
+    // Writes every accumulator with uncommitted progress out,
+    // regardless of the commit threshold; called before a planned
+    // restart
+    void commitAll();
+
+private:
+    void loop();
+
+    struct ChannelLedger_t {
+        double energyWh = 0;
+        double committedWh = 0;
+    };
+
+    struct InverterLedger_t {
+        uint64_t serial = 0;
+        uint32_t lastIntegration = 0;
+        bool loaded = false;
+        ChannelLedger_t channels[CH_CNT];
+    };
+
+    // Returns the ledger of the serial, claiming a free slot on first
+    // sight; nullptr once all slots are taken
+    InverterLedger_t* getLedger(const uint64_t serial);
+    void load(InverterLedger_t& ledger);
+    void commitChannel(InverterLedger_t& ledger, const uint8_t channel);
+    static void makeKey(char* buffer, const size_t size, const uint64_t serial, const uint8_t channel);
+
+    Task _loopTask;
+    Preferences _prefs;
+
+    // Serializes the 1 Hz integration step against the getters, which
+    // the Prometheus handler calls from the async_tcp task - a double
+    // is two word stores on Xtensa, so an unguarded read could observe
+    // a torn accumulator
+    mutable std::mutex _mutex;
+    InverterLedger_t _ledgers[INV_MAX_COUNT];
+};
+
+extern EnergyLedgerClass EnergyLedger;
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Hoymiles.h>
+#include <TaskSchedulerDeclarations.h>
+#include <WiFiUdp.h>
+#include <map>
+
+// Multi-DTU federation: sites whose inverter count exceeds one radio's
+// capacity run several DTUs, and without federation the head-end has to
+// merge several APIs. In secondary role this module streams every
+// completed statistics snapshot to the primary as one compact UDP
+// datagram (FederationDatagramHeader followed by the raw statistics
+// payload). In primary role it listens for those datagrams and feeds
+// them through the normal parser ingestion path of the matching
+// inverter, so /api/livedata, MQTT and Prometheus present the merged
+// fleet without any further merge logic.
+//
+// Remote inverters are configured on the primary like local ones but
+// with polling disabled; that flag is also the injection guard, so a
+// datagram can never override data the primary polls itself.
+
+struct __attribute__((packed)) FederationDatagramHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint64_t serial;
+    uint32_t age; // milliseconds since the sender received the snapshot
+    uint8_t statisticLength;
+};
+
+class FederationClass {
+public:
+    FederationClass();
+    void init(Scheduler& scheduler);
+
+private:
+    void loop();
+    void sendSnapshots();
+    void receiveSnapshots();
+
+    Task _loopTask;
+    WiFiUDP _udp;
+    bool _listening = false;
+
+    // Secondary role: resolved once and reused, a blocking DNS lookup
+    // per datagram would stall the cooperative loop
+    IPAddress _peerAddress = INADDR_NONE;
+
+    // Secondary role: last streamed lastUpdate per serial, so only
+    // fresh snapshots go out when the loop is woken up
+    std::map<uint64_t, uint32_t> _lastStreamed;
+
+    uint8_t _buffer[sizeof(FederationDatagramHeader) + STATISTIC_PACKET_SIZE];
+};
+
+extern FederationClass Federation;
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Hoymiles.h>
+#include <TaskSchedulerDeclarations.h>
+#include <functional>
+#include <vector>
+
+// One shared fleet iteration per second instead of one per consumer:
+// the inverter list is resolved once per pass and every registered
+// visitor is dispatched with the shared_ptr already in hand, so adding
+// a consumer no longer adds another full walk with its own list
+// locking. Visitors run on the main loop in registration order; a
+// consumer with a slower cadence sits passes out via beginPass.
+// Event-driven push paths (the live websocket, the alarm push) keep
+// their own triggers - this service is for the periodic pollers.
+class FleetWalkClass {
+public:
+    struct Visitor {
+        // shows up nowhere yet, but keeps registrations greppable
+        const char* name;
+        // Return false to skip this pass entirely; nullptr runs always
+        std::function<bool()> beginPass;
+        std::function<void(std::shared_ptr<InverterAbstract>&, const uint8_t pos)> visit;
+        // Runs after the last inverter of a pass; may be nullptr
+        std::function<void()> endPass;
+    };
+
+    FleetWalkClass();
+    void init(Scheduler& scheduler);
+
+    // Call from the consumers' init(); not safe once the scheduler runs
+    void registerVisitor(Visitor visitor);
+
+    // Pulls the next pass forward, e.g. after a config change
+    void forceNextIteration();
+
+private:
+    void loop();
+
+    Task _loopTask;
+    std::vector<Visitor> _visitors;
+};
+
+extern FleetWalkClass FleetWalk;
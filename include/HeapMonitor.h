@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Free heap below which load shedding fires. The radio path needs
+// working allocations more than any websocket or MQTT backlog does.
+#ifndef HEAP_MONITOR_LOW_HEAP_BYTES
+#define HEAP_MONITOR_LOW_HEAP_BYTES (16 * 1024)
+#endif
+
+// Largest-block threshold: even with plenty of total free heap, a
+// badly fragmented heap fails the first larger allocation
+#ifndef HEAP_MONITOR_LOW_BLOCK_BYTES
+#define HEAP_MONITOR_LOW_BLOCK_BYTES (8 * 1024)
+#endif
+
+// Heap health watchdog. Samples total free heap and the largest free
+// block periodically, derives a fragmentation figure, and fires the
+// registered load shedders once when the heap runs low - before
+// allocation failures hit paths that cannot tolerate them. Subsystems
+// holding large buffers can register a usage callback so a low-heap
+// log line names the likely culprits instead of just the symptom.
+class HeapMonitorClass {
+public:
+    HeapMonitorClass();
+    void init(Scheduler& scheduler);
+
+    // usage() must be callable from the main task and cheap; it reports
+    // the subsystem's currently reserved bytes
+    void registerConsumer(const char* name, std::function<size_t()> usage);
+
+    // shed() is called from the main task when the heap runs low and
+    // should release memory that can be regenerated (close websocket
+    // clients, drop queued messages, ...)
+    void registerLoadShedder(const char* name, std::function<void()> shed);
+
+    uint8_t getFragmentationPercent() const { return _fragmentationPercent; }
+    uint32_t getShedCount() const { return _shedCount; }
+
+    void serialize(JsonObject root) const;
+
+private:
+    void loop();
+
+    struct Consumer {
+        const char* name;
+        std::function<size_t()> usage;
+    };
+
+    struct Shedder {
+        const char* name;
+        std::function<void()> shed;
+    };
+
+    Task _loopTask;
+    std::vector<Consumer> _consumers;
+    std::vector<Shedder> _shedders;
+
+    uint8_t _fragmentationPercent = 0;
+    uint32_t _minMaxBlock = UINT32_MAX;
+    uint32_t _shedCount = 0;
+    bool _lowHeap = false; // hysteresis: shed once per low-heap episode
+
+    // Lowest free heap observed per configured fleet size, indexed by
+    // inverter count. Serialized alongside the heap stats, this turns
+    // "how does memory scale with fleet size" into a curve that can be
+    // read off any device instead of discovered through field reports.
+    uint32_t _fleetMinFreeHeap[INV_MAX_COUNT + 1];
+};
+
+extern HeapMonitorClass HeapMonitor;
@@ -9,6 +9,21 @@ struct LanguageInfo_t {
     String code;
     String name;
     String filename;
+
+    // Precomputed at pack scan time, so conditional requests are
+    // answered without re-reading and re-hashing the file
+    String etag;
+
+    // Display strings resolved once at pack scan; empty when the pack
+    // does not override them
+    String displayDateFormat;
+    String displayOffline;
+    String displayPowerW;
+    String displayPowerKw;
+    String displayYieldTodayWh;
+    String displayYieldTodayKwh;
+    String displayYieldTotalKwh;
+    String displayYieldTotalMwh;
 };
 
 class I18nClass {
@@ -17,6 +32,7 @@ public:
     void init(Scheduler& scheduler);
     std::list<LanguageInfo_t> getAvailableLanguages();
     String getFilenameByLocale(const String& locale) const;
+    const LanguageInfo_t* getLanguageInfoByLocale(const String& locale) const;
     void readDisplayStrings(
         const String& locale,
         String& date_format,
@@ -3,20 +3,33 @@
 
 #include <TaskSchedulerDeclarations.h>
 #include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #define INVERTER_UPDATE_SETTINGS_INTERVAL 60000l
 
 class InverterSettingsClass {
 public:
     InverterSettingsClass();
+
+    // Starts the radio bring-up (SPI probe and radio settings) on a
+    // worker task. It only depends on Configuration and PinMapping, so
+    // it can overlap the remaining setup() work; init() joins the
+    // worker before configuring the inverters.
+    void beginRadioInit();
     void init(Scheduler& scheduler);
 
 private:
+    void initRadios();
+    static void radioInitTask(void* arg);
+
     void settingsLoop();
     void hoyLoop();
 
     Task _settingsTask;
     Task _hoyTask;
+    SemaphoreHandle_t _radioInitDone = nullptr;
+    bool _radioInitSuccess = false;
 };
 
 extern InverterSettingsClass InverterSettings;
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size bump arena used as ArduinoJson allocator for short-lived
+// payload documents. Blocks are handed out from one preallocated buffer
+// and released all at once via reset(), so steady-state payload assembly
+// does not churn the heap. If the arena is exhausted, allocations fall
+// back to the heap transparently.
+//
+// The arena is not thread-safe: a document must be built, serialized and
+// destroyed before reset() is called for the next one, all on the same
+// task.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    explicit JsonArena(const size_t size);
+    ~JsonArena();
+
+    void* allocate(size_t size) override;
+    void deallocate(void* pointer) override;
+    void* reallocate(void* pointer, size_t new_size) override;
+
+    // Invalidates all arena blocks. Call before building a new document
+    void reset();
+
+    size_t size() const { return _size; }
+
+    // Largest offset ever reached, for sizing telemetry
+    size_t highWaterMark() const { return _highWater; }
+
+    // Allocations that overflowed to the heap because the arena was
+    // full; a steadily rising count means the arena is undersized
+    uint32_t heapFallbacks() const { return _heapFallbacks; }
+
+private:
+    bool ownsPointer(const void* pointer) const;
+
+    uint8_t* _buffer;
+    size_t _size;
+    size_t _offset = 0;
+    size_t _highWater = 0;
+    uint32_t _heapFallbacks = 0;
+    void* _lastAllocation = nullptr;
+};
+
+// Shared arena for MQTT payload assembly. Only used from the main
+// TaskScheduler loop (MqttHandleHass, MqttHandleInverter)
+extern JsonArena MqttPayloadArena;
+
+// Shared arena for livedata JSON assembly. Callers serialize access
+// via WebApiWsLiveClass::_mutex
+extern JsonArena LivedataArena;
@@ -3,9 +3,7 @@
 
 #include "PinMapping.h"
 #include <TaskSchedulerDeclarations.h>
-#include <TimeoutHelper.h>
-
-#define LEDSINGLE_UPDATE_INTERVAL 2000
+#include <atomic>
 
 class LedSingleClass {
 public:
@@ -16,13 +14,8 @@ public:
     void turnAllOn();
 
 private:
-    void setLoop();
-    void outputLoop();
-
-    void setLed(const uint8_t ledNo, const bool ledState);
-
-    Task _setTask;
-    Task _outputTask;
+    void applyLoop();
+    void recompute();
 
     enum class LedState_t {
         On,
@@ -30,10 +23,21 @@ private:
         Blink,
     };
 
+    void applyMode(const uint8_t ledNo, const LedState_t state);
+
+    Task _applyTask;
+
     LedState_t _ledMode[PINMAPPING_LED_COUNT];
     LedState_t _allMode;
-    bool _ledStateCurrent[PINMAPPING_LED_COUNT];
-    TimeoutHelper _blinkTimeout;
+
+    // the event handlers run in foreign task contexts (network, MQTT
+    // client, SNTP) and only update these flags; the apply task picks
+    // them up on the main loop, where the LEDC calls are made.
+    std::atomic<bool> _dirty = true;
+    std::atomic<bool> _forceApply = true;
+    std::atomic<bool> _timeSynced = false;
+    std::atomic<bool> _mqttConnected = false;
+    std::atomic<bool> _networkConnected = false;
 };
 
-extern LedSingleClass LedSingle;
\ No newline at end of file
+extern LedSingleClass LedSingle;
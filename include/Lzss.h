@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LZSS compression in the heatshrink bitstream format with the common
+// static parameters (window 2^8 = 256 bytes, lookahead 2^4 = 16 bytes),
+// so consumers can decode with any stock heatshrink decoder configured
+// as (8, 4). Chosen over deflate because it needs no dictionary
+// allocations and no external dependency - the encoder below is the
+// whole implementation.
+//
+// Bitstream, MSB first: '1' + 8 bits for a literal byte; '0' + 8 bits
+// backward distance minus one + 4 bits match length minus one for a
+// back-reference.
+
+// Compresses input into output. Returns the compressed size, or 0 when
+// the result would not fit outputCap (callers then send uncompressed).
+size_t lzssCompress(const uint8_t* input, const size_t inputLen, uint8_t* output, const size_t outputCap);
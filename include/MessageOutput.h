@@ -1,15 +1,20 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
-#include <AsyncWebSocket.h>
 #include <TaskSchedulerDeclarations.h>
 #include <Print.h>
 #include <freertos/task.h>
-#include <mutex>
+#include <array>
+#include <atomic>
 #include <vector>
-#include <unordered_map>
-#include <queue>
-#include <memory>
+
+// consumer-side sink for finished log lines, implemented by the
+// websocket console. writeLine() is only ever called from the main
+// loop task, one complete line at a time.
+class MessageOutputLineSink {
+public:
+    virtual void writeLine(const uint8_t* buffer, size_t size) = 0;
+};
 
 class MessageOutputClass : public Print {
 public:
@@ -17,7 +22,7 @@ public:
     void init(Scheduler& scheduler);
     size_t write(uint8_t c) override;
     size_t write(const uint8_t* buffer, size_t size) override;
-    void register_ws_output(AsyncWebSocket* output);
+    void register_line_sink(MessageOutputLineSink* sink);
 
     static int log_vprintf(const char *fmt, va_list arguments);
 
@@ -28,30 +33,59 @@ private:
 
     using message_t = std::vector<uint8_t>;
 
-    // we keep a buffer for every task and only write complete lines to the
-    // serial output and then move them to be pushed through the websocket.
-    // this way we prevent mangling of messages from different contexts.
-    std::unordered_map<TaskHandle_t, message_t> _task_messages;
-    std::queue<message_t> _lines;
-
-    // we chunk the websocket output to circumvent issues with TCP delayed ACKs:
-    // if the websocket client (Windows in particular) is using delayed ACKs,
-    // and since we wait for an ACK before sending the next chunk, we will
-    // accumulate way too many messages and we won't be able to send them out
-    // fast enough as the rate of produced messages is higher than the rate of
-    // ACKs received. by chunking and waiting in between chunks, we either
-    // "motivate" the client to send out ACKs immediately as the TCP packets are
-    // "large", or we will wait long enough for the TCP stack to send out the
-    // ACK anyways.
-    void send_ws_chunk(message_t&& line);
-    static constexpr size_t WS_CHUNK_SIZE_BYTES = 512;
-    static constexpr uint32_t WS_CHUNK_INTERVAL_MS = 250;
-    std::shared_ptr<message_t> _ws_chunk = nullptr;
-    uint32_t _last_ws_chunk_sent = 0;
-
-    AsyncWebSocket* _ws = nullptr;
-
-    std::mutex _msgLock;
+    static constexpr size_t LOG_LINE_SIZE_BYTES = 512;
+
+    // every task assembles its lines in its own slot and hands finished
+    // lines to the main loop through a fixed-depth single-producer/
+    // single-consumer ring. this way we prevent mangling of messages
+    // from different contexts and logging never blocks a producer task:
+    // there is no shared lock, a full ring just drops the line (counted
+    // and reported). only the main task writes to the serial port - its
+    // own lines synchronously so early boot output shows up immediately,
+    // everyone else's from the consumer loop.
+    static constexpr size_t TASK_SLOT_COUNT = 16;
+    static constexpr size_t LINE_QUEUE_DEPTH = 8;
+
+    // a ring entry is either a rendered text line (fmt == nullptr) or a
+    // deferred log record: the format string pointer (a flash literal,
+    // valid forever) plus the packed argument values, rendered by the
+    // consumer. deferring the vsnprintf makes an ESP_LOGx call on a hot
+    // path cost little more than copying the argument words.
+    struct LineEntry {
+        message_t data;
+        const char* fmt = nullptr;
+    };
+
+    struct TaskSlot {
+        std::atomic<TaskHandle_t> owner = nullptr;
+        message_t pending; // line being assembled, touched only by the owner
+        std::array<LineEntry, LINE_QUEUE_DEPTH> lines;
+        std::atomic<uint32_t> head = 0; // consumer position
+        std::atomic<uint32_t> tail = 0; // producer position
+        std::atomic<uint32_t> dropped = 0;
+    };
+
+    // deferred-format argument capture. formats that exceed these
+    // limits (or use %n, %*, long strings, ...) fall back to immediate
+    // rendering in the producer task.
+    static constexpr size_t DEFERRED_MAX_ARGS = 8;
+    static constexpr size_t DEFERRED_MAX_STRING = 64;
+
+    enum class ArgClass : uint8_t { Int32, Int64, Pointer, Double, String };
+
+    static bool parseSpec(const char*& p, char* spec, size_t specSize, ArgClass& cls);
+    static bool captureLogArgs(const char* fmt, va_list args, message_t& packed);
+    static void renderDeferred(const char* fmt, const message_t& packed, message_t& line);
+
+    TaskSlot* claimSlot();
+    void pushLine(TaskSlot& slot);
+    void pushDeferred(TaskSlot& slot, const char* fmt, message_t&& packed);
+    void drainSlot(TaskSlot& slot);
+
+    std::array<TaskSlot, TASK_SLOT_COUNT> _slots;
+    TaskHandle_t _mainTask = nullptr;
+
+    MessageOutputLineSink* _sink = nullptr;
 
     void serialWrite(message_t const& m);
 };
@@ -1,10 +1,15 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "Scheduler.h"
 #include <ArduinoJson.h>
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
 #include <TimeoutHelper.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
 
 // mqtt discovery device classes
 enum DeviceClassType {
@@ -93,16 +98,51 @@ private:
     static void createInverterInfo(JsonDocument& doc, std::shared_ptr<InverterAbstract> inv);
     static void createDtuInfo(JsonDocument& doc);
 
-    static void createDeviceInfo(JsonDocument& doc, const String& name, const String& identifiers, const String& configuration_url, const String& manufacturer, const String& model, const String& sw_version, const String& via_device = "");
+    static String renderDeviceInfo(const String& name, const String& identifiers, const String& configuration_url, const String& manufacturer, const String& model, const String& sw_version, const String& via_device = "");
 
     static String getDtuUniqueId();
     static String getDtuUrl();
 
+    void startPublishWork();
+
     Task _loopTask;
     TimeoutHelper _publishConfigTimeout;
 
     bool _wasConnected = false;
     bool _updateForced = false;
+
+    // Pending discovery configs, drained time-budgeted by _publishWork
+    std::list<std::function<void()>> _publishQueue;
+    ChunkedWork _publishWork;
+
+    // topic hash -> payload hash of the last published config, used to
+    // skip configs the broker already retains
+    static std::map<uint32_t, uint32_t> _sentConfigHashes;
+
+    // Discovery documents as rendered by the last full builder pass.
+    // While the cache is valid, publishConfig() replays these buffers
+    // instead of re-running topic assembly and JSON serialization for
+    // every entity, so the discovery storm after an MQTT reconnect is
+    // a plain buffer replay. The buffers ride the 512 byte
+    // heap_caps_malloc_extmem_enable() threshold into PSRAM where
+    // available. Invalidated on config change and for the nightly
+    // refresh.
+    struct RenderedConfig {
+        String subtopic;
+        String payload;
+    };
+    static std::vector<RenderedConfig> _renderedConfigs;
+
+    // Device block ("dev" object) serialized once per device and
+    // spliced verbatim into every entity document of a builder pass
+    // via serialized(); keyed by the device identifier. Cleared at the
+    // start of each pass so it never outlives the values it embeds
+    static std::map<String, String> _deviceBlockCache;
+
+    static bool _renderedValid;
+    static bool _rendering;
+    static bool _renderSkippedEntities;
+    static String _renderedDtuUrl;
 };
 
 extern MqttHandleHassClass MqttHandleHass;
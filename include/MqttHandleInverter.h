@@ -7,24 +7,71 @@
 #include <espMqttClient.h>
 #include <frozen/map.h>
 #include <frozen/string.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
 
 class MqttHandleInverterClass {
 public:
     MqttHandleInverterClass();
     void init(Scheduler& scheduler);
 
-    static String getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    static const String& getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    static void clearTopicCache();
 
     void subscribeTopics();
     void unsubscribeTopics();
 
+    // Cost and yield of the optional compact-JSON payload compression
+    struct CompressionStats {
+        std::atomic<uint32_t> published = 0; // compressed publishes
+        std::atomic<uint32_t> skipped = 0; // incompressible, sent plain
+        std::atomic<uint64_t> bytesIn = 0;
+        std::atomic<uint64_t> bytesOut = 0;
+        std::atomic<uint64_t> cpuMicros = 0;
+    };
+
+    const CompressionStats& getCompressionStats() const { return _compressionStats; }
+
 private:
-    void loop();
+    // FleetWalk visitor: beginPass gates on the publish interval, the
+    // MQTT connection and idle radios, visit publishes one inverter
+    bool beginPass();
+    void visit(std::shared_ptr<InverterAbstract>& inv, const uint8_t i);
+    void endPass();
+    void coalesceLoop();
+    void publishCompactJson(std::shared_ptr<InverterAbstract> inv);
     void publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    void scheduleLimitCommand(std::shared_ptr<InverterAbstract> inv, const float limit, const PowerLimitControlType type);
+
+    Task _coalesceTask;
 
-    Task _loopTask;
+    // Pass state of the FleetWalk visitor: config snapshot pinned in
+    // beginPass, end of the last completed publish pass
+    std::shared_ptr<const CONFIG_T> _passCfg;
+    uint32_t _lastPass = 0;
+
+    // Newest limit setpoint per inverter serial, held back until the
+    // coalesce window expires. Guarded by _pendingLimitsMutex, written
+    // from the MQTT client task and drained from the main loop
+    struct PendingLimit {
+        float limit;
+        PowerLimitControlType type;
+        uint32_t lastSent = 0;
+        bool armed = false;
+    };
+    std::map<uint64_t, PendingLimit> _pendingLimits;
+    std::mutex _pendingLimitsMutex;
+
+    CompressionStats _compressionStats;
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
+    uint32_t _lastFullPublishStats[INV_MAX_COUNT] = { 0 };
+    uint32_t _lastPublishedLimitVersion[INV_MAX_COUNT] = { 0 };
+
+    // Pre-rendered field topics, keyed by serial and (type, channel, field)
+    static std::map<std::pair<uint64_t, uint32_t>, String> _topicCache;
 
     FieldId_t _publishFields[14] = {
         FLD_UDC,
@@ -4,26 +4,83 @@
 #include "NetworkSettings.h"
 #include <MqttSubscribeParser.h>
 #include <Ticker.h>
+#include <atomic>
+#include <deque>
 #include <espMqttClient.h>
 #include <mutex>
 #include <map>
 #include <vector>
 
+// Outbox priority classes. During broker hiccups the higher classes are
+// drained first and the telemetry class sheds its oldest entries, so
+// availability and control traffic keeps flowing while memory stays
+// bounded.
+enum class PublishPriority : uint8_t {
+    Critical = 0, // availability / LWT
+    Control, // limits, power state
+    Telemetry, // live statistics
+};
+
 class MqttSettingsClass {
 public:
     MqttSettingsClass();
     void init();
     void performReconnect();
     bool getConnected();
-    void publish(const String& subtopic, const String& payload);
-    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0);
+    void publish(const String& subtopic, const String& payload, const PublishPriority priority = PublishPriority::Telemetry);
+    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0, const PublishPriority priority = PublishPriority::Telemetry);
+
+    // Batched publishing: queuePublish() only collects messages,
+    // flushPublishQueue() hands them to the client back-to-back under a
+    // single lock so they leave as one write burst instead of one
+    // TCP push per publish. Not thread-safe, callers queue and flush
+    // from the same task.
+    void queuePublish(const String& subtopic, const String& payload, const PublishPriority priority = PublishPriority::Telemetry);
+
+    // Same as queuePublish, but the payload is taken verbatim with an
+    // explicit length - no trimming, embedded NUL bytes survive (used
+    // for compressed payloads)
+    void queuePublishBinary(const String& subtopic, const uint8_t* payload, const size_t len, const PublishPriority priority = PublishPriority::Telemetry);
+
+    void flushPublishQueue();
+
+    // Drops all queued telemetry publishes; called by the heap monitor
+    // when memory runs low. Fresh samples repopulate the queue.
+    void shedTelemetryBacklog();
 
     void subscribe(const String& topic, const uint8_t qos, const OnMessageCallback& cb);
     void unsubscribe(const String& topic);
 
+    // Broker connect/disconnect notifications. Listeners are invoked
+    // from the MQTT client task, so they should only flip flags or
+    // defer real work to their own task.
+    void onConnectionChanged(std::function<void(const bool connected)> listener);
+
     String getPrefix() const;
     String getClientId() const;
 
+    // Publish pipeline counters, updated with relaxed atomics so the
+    // web server task can read them without taking _clientLock. All
+    // per-priority arrays are indexed by PublishPriority.
+    struct PublishStats {
+        static constexpr uint32_t latencyBucketBoundsMs[5] = { 1, 10, 100, 1000, 10000 };
+
+        std::atomic<uint32_t> published[3] {}; // handed to the client
+        std::atomic<uint32_t> coalesced[3] {}; // replaced a queued payload of the same topic
+        std::atomic<uint32_t> dropped[3] {}; // shed on outbox overflow or client teardown
+        std::atomic<uint32_t> outboxDepth[3] {}; // current queue sizes
+        std::atomic<uint32_t> deferred { 0 }; // publish attempts rejected by a full TX buffer
+        std::atomic<uint32_t> connects { 0 };
+        std::atomic<uint32_t> disconnects { 0 };
+
+        // Queue-to-wire latency, cumulative buckets "<= bound" plus overflow
+        std::atomic<uint32_t> latencyBuckets[6] {};
+        std::atomic<uint64_t> latencySumMs { 0 };
+        std::atomic<uint32_t> latencyCount { 0 };
+    };
+
+    const PublishStats& getPublishStats() const { return _stats; }
+
 private:
     void NetworkEvent(network_event event);
 
@@ -36,11 +93,43 @@ private:
 
     void createMqttClientObject();
 
+    // Applies server, credentials, TLS material and callbacks to the
+    // client object. Expects _clientLock to be held by the caller.
+    void configureMqttClientObject();
+
+    // Checksum over the connection-relevant config fields, so a config
+    // change event only forces a reconnect when host, credentials, TLS
+    // or session parameters actually changed
+    uint32_t connectionSettingsCrc() const;
+
+    struct QueuedPublish {
+        String topic;
+        String payload;
+        bool retain;
+        uint8_t qos;
+        PublishPriority priority;
+        uint32_t enqueuedAt;
+    };
+
+    // Both expect _clientLock to be held by the caller
+    void enqueueOutbox(QueuedPublish&& item);
+    void drainOutbox();
+
     MqttClient* _mqttClient = nullptr;
     Ticker _mqttReconnectTimer;
+    std::vector<QueuedPublish> _publishQueue;
+    std::deque<QueuedPublish> _outbox[3];
     std::map<String, std::vector<uint8_t>> _fragments;
     MqttSubscribeParser _mqttSubscribeParser;
     std::mutex _clientLock;
+    PublishStats _stats;
+    uint32_t _connectionSettingsCrc = 0;
+    std::vector<std::function<void(const bool)>> _connectionListeners;
+
+    // Own the storage behind the pointers handed to the client - the
+    // client keeps referencing them until the next reconfiguration
+    String _willTopic;
+    String _clientId;
 };
 
 extern MqttSettingsClass MqttSettings;
@@ -5,6 +5,7 @@
 #include <DNSServer.h>
 #include <TaskSchedulerDeclarations.h>
 #include <WiFi.h>
+#include <atomic>
 #include <vector>
 
 enum class network_mode {
@@ -78,6 +79,7 @@ private:
     uint32_t _connectTimeoutTimer = 0;
     uint32_t _connectRedoTimer = 0;
     uint32_t _lastReconnectAttempt = 0;
+    uint32_t _reconnectWatchdogDelay;
     uint32_t _lastTimerCall = 0;
     IPAddress _apIp;
     IPAddress _apNetmask;
@@ -86,7 +88,14 @@ private:
     network_mode _networkMode = network_mode::Undefined;
     bool _ethConnected = false;
     std::vector<DtuNetworkEventCbList_t> _cbEventList;
+
+    // mDNS is handled change-driven: the responder is only evaluated
+    // when a relevant config scope was saved, and only restarted when
+    // the announced state (enabled, hostname) actually differs.
+    // Address changes are tracked by the IDF mDNS component itself.
+    std::atomic<bool> _mdnsSettingsDirty = true;
     bool _lastMdnsEnabled = false;
+    String _lastMdnsHostname;
     std::unique_ptr<W5500> _w5500;
 };
 
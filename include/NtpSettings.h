@@ -1,13 +1,51 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 class NtpSettingsClass {
 public:
     NtpSettingsClass();
-    void init();
+    void init(Scheduler& scheduler);
 
     void setServer();
     void setTimezone();
+    void resync();
+
+    // SNTP sync notifications. Listeners are invoked from the SNTP
+    // task, so they should only flip flags or defer real work to their
+    // own task.
+    void onTimeSynced(std::function<void()> listener);
+
+    // Clock quality, derived from the corrections successive SNTP
+    // syncs applied to the local clock
+    bool hasDriftEstimate() const { return _driftValid; }
+    float getDriftPpm() const { return _driftPpm; }
+    uint32_t getSecondsSinceSync() const;
+
+    // Worst-case clock error accumulated since the last sync, from the
+    // estimated drift plus a crystal tolerance margin
+    uint32_t getEstimatedErrorMs() const;
+
+private:
+    void driftLoop();
+    static void timeSyncCallback(struct timeval* tv);
+
+    Task _driftTask;
+
+    std::vector<std::function<void()>> _timeSyncedListeners;
+
+    // Written by the SNTP task, read from the main loop and web
+    // handlers. The anchor is (epoch - uptime) at sync time; its change
+    // between two syncs is the correction SNTP had to apply.
+    std::atomic<int64_t> _lastSyncAnchorUs = 0;
+    std::atomic<int64_t> _lastSyncUptimeUs = 0;
+    std::atomic<bool> _driftValid = false;
+    std::atomic<float> _driftPpm = 0;
 };
 
-extern NtpSettingsClass NtpSettings;
\ No newline at end of file
+extern NtpSettingsClass NtpSettings;
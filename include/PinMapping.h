@@ -51,6 +51,13 @@ struct PinMapping_t {
     gpio_num_t display_reset;
 
     gpio_num_t led[PINMAPPING_LED_COUNT];
+
+    // Instrumentation outputs for logic-analyzer correlation; only
+    // driven in builds with -DHOYMILES_PROFILING_PINS=1 (see
+    // lib/Hoymiles/src/ProfilingPins.h)
+    gpio_num_t radio_profiling_tx;
+    gpio_num_t radio_profiling_rx;
+    gpio_num_t radio_profiling_fragment;
 };
 
 class PinMappingClass {
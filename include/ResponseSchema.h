@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+
+// Field descriptor table driven response serialization. An endpoint
+// declares its response shape once as a SchemaField table over a POD
+// snapshot struct (see ResponseSchemas.h); the same table drives the
+// JSON serializer here and, at build time, the generated TypeScript
+// types of the webapp - so a shape change happens in exactly one place
+// and serializer optimizations benefit every table-driven endpoint.
+
+enum class SchemaFieldType : uint8_t {
+    UInt8,
+    UInt32,
+    Int8,
+    Float,
+    Bool,
+};
+
+struct SchemaField {
+    const char* key;
+    SchemaFieldType type;
+    size_t offset;
+};
+
+// Keeps key, member and type adjacent so the table stays greppable and
+// machine-parsable for the type generator
+#define SCHEMA_FIELD(structType, member, jsonKey, fieldType) \
+    SchemaField { jsonKey, SchemaFieldType::fieldType, offsetof(structType, member) }
+
+// Serializes one snapshot struct into obj according to the field table
+void serializeWithSchema(JsonObject obj, const SchemaField* fields, const size_t fieldCount, const void* data);
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "ResponseSchema.h"
+#include <Hoymiles.h>
+
+// Response descriptor tables. Each table is the single source of truth
+// for one response shape: serializeWithSchema() walks it at runtime and
+// pio-scripts/generate_response_types.py parses this file at build time
+// to emit the matching TypeScript interfaces into webapp/src/types/.
+// Bump the version constant whenever a table changes shape; the webapp
+// receives it as schema_version in the response.
+//
+// The generator relies on the SCHEMA: begin/end marker comments and the
+// one-SCHEMA_FIELD-per-line layout - keep both intact when editing.
+
+// SCHEMA: RadioStatsChannel version=RADIO_STATS_SCHEMA_VERSION
+constexpr uint16_t RADIO_STATS_SCHEMA_VERSION = 1;
+constexpr SchemaField RADIO_STATS_CHANNEL_FIELDS[] = {
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, channel, "channel", UInt8),
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, deprioritized, "deprioritized", Bool),
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, txCount, "tx", UInt32),
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, rxCount, "rx", UInt32),
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, rxCrcErrorCount, "rx_crc_error", UInt32),
+    SCHEMA_FIELD(HoymilesRadio_NRF::ChannelStats_t, listenTurnsSkipped, "listen_turns_skipped", UInt32),
+};
+// SCHEMA: end
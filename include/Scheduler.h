@@ -2,5 +2,44 @@
 #pragma once
 
 #include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <functional>
 
-extern Scheduler scheduler;
\ No newline at end of file
+extern Scheduler scheduler;
+
+// Time budget of one ChunkedWork invocation. The cap on worst-case
+// loop latency added by a chunked job is this budget plus one step.
+#ifndef CHUNKED_WORK_BUDGET_US
+#define CHUNKED_WORK_BUDGET_US 4000
+#endif
+
+// Resumable work token for long-running callbacks: start() hands over
+// a step callback that is invoked repeatedly until it returns false.
+// Once the time budget of one scheduler pass is spent, the remaining
+// steps resume on the next pass, so a job of any length (publishing
+// hundreds of MQTT discovery documents, rendering a large export)
+// cannot stall the cooperative loop beyond the budget. Steps run on
+// the main loop in order; no locking is implied.
+class ChunkedWork {
+public:
+    ChunkedWork();
+
+    // Call once from the owner's init(); the name must be a string
+    // literal, it feeds the scheduler monitor
+    void init(Scheduler& scheduler, const char* name, const uint32_t budgetUs = CHUNKED_WORK_BUDGET_US);
+
+    // (Re)starts the job; a still-running job is replaced
+    void start(std::function<bool()> step);
+
+    // Drops the remaining steps
+    void cancel();
+
+    bool busy() const;
+
+private:
+    void loop();
+
+    Task _task;
+    std::function<bool()> _step;
+    uint32_t _budgetUs = CHUNKED_WORK_BUDGET_US;
+};
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#define SCHEDULER_MONITOR_SLOT_COUNT 24
+
+// Every callback sharing the cooperative scheduler delays all others
+// while it runs; anything holding the loop longer than this budget
+// counts as an overrun, regardless of the task's own interval.
+#ifndef SCHEDULER_MONITOR_BUDGET_US
+#define SCHEDULER_MONITOR_BUDGET_US 50000
+#endif
+
+// A full scheduler pass taking longer than this is a stall: every
+// task, including the display refresh and the websocket push, was
+// blocked for that long. Stalls are counted, logged and exported to
+// Prometheus so they can be alerted on instead of being diagnosed
+// from a frozen display after the fact.
+#ifndef SCHEDULER_MONITOR_STALL_BUDGET_US
+#define SCHEDULER_MONITOR_STALL_BUDGET_US 500000
+#endif
+
+// Per-Task execution-time accounting for the cooperative TaskScheduler
+// loop. Modules opt in by routing their callback through instrument(),
+// which wraps it with a stopwatch; max/mean runtime and overruns per
+// task are exposed on /api/system/tasks, and the worst offender of
+// each reporting window is logged. Complements TaskMonitor, which
+// attributes CPU between FreeRTOS tasks but sees the whole main loop
+// as one opaque task.
+class SchedulerMonitorClass {
+public:
+    SchedulerMonitorClass();
+    void init(Scheduler& scheduler);
+
+    // Replaces the task's callback with a timed wrapper around the
+    // given callback. The name must outlive the monitor (string
+    // literals). Call from init(), after the task was constructed.
+    // Latency-sensitive tasks can pass a budget tighter than the
+    // default; everything beyond it counts as an overrun.
+    void instrument(const char* name, Task& task, std::function<void()> callback,
+        const uint32_t budgetUs = SCHEDULER_MONITOR_BUDGET_US);
+
+    // Called once per pass from loop(); measures the pass-to-pass gap
+    // and raises the stall counter when it blows the stall budget
+    void loopTick();
+
+    void serialize(JsonObject root);
+
+    // Accessors for the Prometheus exporter
+    uint32_t getLoopStalls() const { return _loopStalls.load(std::memory_order_relaxed); }
+    uint32_t getLoopMaxGapUs() const { return _loopMaxGapUs.load(std::memory_order_relaxed); }
+    size_t getTaskCount() const { return _slotCount; }
+    const char* getTaskName(const size_t index) const { return _slots[index].name; }
+    uint32_t getTaskOverruns(const size_t index) const { return _slots[index].overruns.load(std::memory_order_relaxed); }
+
+private:
+    void reportLoop();
+
+    struct Slot {
+        const char* name = nullptr;
+        uint32_t budgetUs = SCHEDULER_MONITOR_BUDGET_US;
+        // Written only from the main loop task; atomics make the reads
+        // from the web server task safe.
+        std::atomic<uint32_t> runs = 0;
+        std::atomic<uint32_t> overruns = 0;
+        std::atomic<uint32_t> maxUs = 0;
+        std::atomic<uint64_t> totalUs = 0;
+        uint32_t windowMaxUs = 0; // main loop task only
+    };
+
+    Task _reportTask;
+
+    Slot _slots[SCHEDULER_MONITOR_SLOT_COUNT];
+    size_t _slotCount = 0;
+
+    // Loop watchdog state; written only from the main loop task
+    uint32_t _lastTickUs = 0;
+    uint32_t _windowMaxGapUs = 0;
+    std::atomic<uint32_t> _loopStalls = 0;
+    std::atomic<uint32_t> _loopMaxGapUs = 0;
+};
+
+extern SchedulerMonitorClass SchedulerMonitor;
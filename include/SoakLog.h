@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+
+// Long-run soak telemetry: while running, one aggregate record per hour
+// is written into a fixed-size circular file on LittleFS, so a week of
+// heap decay, loop latency, radio success and MQTT throughput survives
+// reboots and can be fetched through the file API (/api/file/get) and
+// compared between firmware builds. Started/stopped at runtime via
+// /api/soaklog; the state is derived from the file itself, so a soak
+// run resumes automatically after a reboot.
+//
+// Set -DSOAKLOG_ENABLE=0 to compile the feature out.
+
+#ifndef SOAKLOG_ENABLE
+#define SOAKLOG_ENABLE 1
+#endif
+
+#define SOAKLOG_FILENAME "/soaklog.bin"
+
+// Circular capacity; 168 hourly records cover one week
+#ifndef SOAKLOG_RECORD_COUNT
+#define SOAKLOG_RECORD_COUNT 168
+#endif
+
+#ifndef SOAKLOG_FLUSH_INTERVAL
+#define SOAKLOG_FLUSH_INTERVAL (60 * TASK_MINUTE)
+#endif
+
+// Loop latency histogram: bin i counts scheduler passes shorter than
+// 2^(i+5) us, the last bin collects everything longer
+#define SOAKLOG_LOOP_BIN_COUNT 12
+
+// File layout: SoakLogHeader followed by SOAKLOG_RECORD_COUNT record
+// slots. Slot of record n is n % SOAKLOG_RECORD_COUNT; once sequence
+// exceeds the capacity the oldest record is at slot sequence % capacity.
+// Everything is little endian.
+struct __attribute__((packed)) SoakLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t sequence; // total records written over the soak run
+};
+
+struct __attribute__((packed)) SoakLogRecord {
+    uint32_t timestamp; // epoch seconds, 0 before NTP sync
+    uint32_t uptimeSeconds;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap; // since boot
+    uint32_t maxAllocHeap;
+    uint8_t heapFragmentationPercent;
+    uint8_t inverterCount;
+    uint16_t bootCount; // increments let reboots stand out in the plot
+    uint32_t loopIterations; // scheduler passes this hour
+    uint32_t loopMaxUs; // longest pass this hour
+    uint32_t loopP99Us; // bin upper bound covering 99% of passes
+    uint32_t radioTxRequests; // fleet-wide deltas for this hour
+    uint32_t radioRxSuccess;
+    uint32_t radioRxFailures;
+    uint32_t mqttPublished;
+    uint32_t mqttDropped;
+};
+
+class SoakLogClass {
+public:
+    SoakLogClass();
+    void init(Scheduler& scheduler);
+
+    // Creates the log file and begins sampling; returns false when the
+    // feature is compiled out or the file cannot be created
+    bool start();
+    void stop();
+
+    bool isRunning() const { return _running; }
+    uint32_t getSequence() const { return _sequence; }
+
+private:
+    void sampleLoop();
+    void flushLoop();
+    bool writeHeader();
+
+    Task _sampleTask;
+    Task _flushTask;
+
+    bool _running = false;
+    uint32_t _sequence = 0;
+    uint16_t _bootCount = 0;
+
+    // Hourly aggregation state, touched only from the main loop task
+    uint32_t _lastSampleUs = 0;
+    uint32_t _loopIterations = 0;
+    uint32_t _loopMaxUs = 0;
+    uint32_t _loopBins[SOAKLOG_LOOP_BIN_COUNT] = {};
+
+    // Previous fleet totals for delta calculation
+    uint32_t _lastRadioTxRequests = 0;
+    uint32_t _lastRadioRxSuccess = 0;
+    uint32_t _lastRadioRxFailures = 0;
+    uint32_t _lastMqttPublished = 0;
+    uint32_t _lastMqttDropped = 0;
+};
+
+extern SoakLogClass SoakLog;
@@ -3,7 +3,9 @@
 
 #include <TaskSchedulerDeclarations.h>
 #include <atomic>
+#include <functional>
 #include <sunset.h>
+#include <vector>
 
 class SunPositionClass {
 public:
@@ -16,6 +18,12 @@ public:
     bool sunriseTime(struct tm* info) const;
     void setDoRecalc(const bool doRecalc);
 
+    // Load shaping: subsystems with deferrable heavy work register here
+    // and shift it to the night period, when inverter polling is
+    // (usually) off and radio and CPU are idle. Listeners are invoked
+    // from the main loop on every day/night transition.
+    void onDayPeriodChanged(std::function<void(const bool isDay)> listener);
+
 private:
     void loop();
     void updateSunData();
@@ -31,6 +39,10 @@ private:
     bool _isValidInfo = false;
     std::atomic_bool _doRecalc = true;
     uint32_t _lastSunPositionCalculatedYMD = 0;
+
+    std::vector<std::function<void(const bool)>> _dayPeriodListeners;
+    bool _lastIsDay = true;
+    bool _lastIsDayValid = false;
 };
 
 extern SunPositionClass SunPosition;
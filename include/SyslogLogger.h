@@ -2,6 +2,8 @@
 #pragma once
 #include <WiFiUdp.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <deque>
 #include <mutex>
 
 class SyslogLogger {
@@ -11,6 +13,10 @@ public:
     void updateSettings(const String&& hostname);
     void write(const uint8_t *buffer, size_t size);
 
+    // lines dropped because the queue was full, since the last settings
+    // change
+    uint32_t getDroppedLines() const { return _droppedLines; }
+
 private:
     void loop();
     void disable();
@@ -29,7 +35,20 @@ private:
     String _proc_id;
     String _header;
     uint16_t _port;
-    bool _enabled;
+    // atomic so write() can bail out without the mutex while disabled
+    std::atomic<bool> _enabled = false;
+
+    // write() only formats the line and appends it to this bounded
+    // queue - all UDP I/O happens in loop(), which coalesces queued
+    // lines into MTU-sized datagrams. A full queue drops the line and
+    // counts it, so syslog can never backpressure the producing task.
+    static constexpr size_t BATCH_SIZE_BYTES = 1400; // fits a standard MTU
+    static constexpr size_t QUEUE_MAX_BYTES = 8192;
+    static constexpr uint8_t MAX_BATCHES_PER_LOOP = 4;
+    std::deque<String> _queue;
+    size_t _queueBytes = 0;
+    uint32_t _droppedLines = 0;
+    uint32_t _droppedPending = 0;
 };
 
 extern SyslogLogger Syslog;
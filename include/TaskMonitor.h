@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cstdint>
+
+#define TASK_MONITOR_SLOT_COUNT 24
+
+// Sampling period of the statistical profiler. A prime number of
+// microseconds avoids phase-locking with the 1 kHz FreeRTOS tick,
+// which would otherwise always observe the same point of the schedule.
+#ifndef TASK_MONITOR_SAMPLE_INTERVAL_US
+#define TASK_MONITOR_SAMPLE_INTERVAL_US 1009
+#endif
+
+// Size of the raw sample trace in bytes; one byte per core per tick,
+// so the default covers ~32 seconds of both cores at the 1 kHz rate
+#ifndef TASK_MONITOR_TRACE_BYTES
+#define TASK_MONITOR_TRACE_BYTES (64 * 1024)
+#endif
+
+// Statistical per-task CPU accounting. A hardware timer interrupt
+// samples the task currently running on each core roughly 1000 times
+// per second and attributes the sample to that task's slot; a task's
+// CPU share is its fraction of all samples. This works without the
+// FreeRTOS run time stats hooks, which are disabled in the prebuilt
+// Arduino core. Results are exposed on /api/system/tasks and as
+// Prometheus metrics.
+class TaskMonitorClass {
+public:
+    struct TaskStats {
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t samples;
+        uint32_t samplesDelta; // since the previous baselined collect()
+        uint32_t stackWatermark;
+        uint32_t priority;
+        char state;
+        bool live; // false for the aggregate of exited tasks
+    };
+
+    void init();
+
+    uint32_t getTotalSamples() const { return _totalSamples.load(std::memory_order_relaxed); }
+
+    // Fills stats with one entry per live task plus an aggregate entry
+    // for samples attributed to tasks that have exited since boot. With
+    // updateBaseline set, samplesDelta covers the window since the
+    // previous baselined call (used for the CPU share in the web API).
+    size_t collect(TaskStats* stats, size_t maxCount, bool updateBaseline);
+
+    void serialize(JsonObject root);
+
+    // Raw sample trace: while active, every tick additionally appends
+    // the sampled slot index per core into a bounded buffer (PSRAM
+    // first), preserving the time order that the aggregate counters
+    // lose. The capture stops itself when the buffer is full; the
+    // profiler API dumps it for offline flamegraph-style folding
+    // (see tools/fold_task_samples.py).
+    bool startTrace();
+    void stopTrace() { _traceActive.store(false, std::memory_order_relaxed); }
+    bool isTraceActive() const { return _traceActive.load(std::memory_order_relaxed); }
+    uint32_t getTraceBytes() const;
+    const uint8_t* getTraceBuffer() const { return _traceBuffer; }
+
+    // Resolves a sampled slot index to the owning task's name; stale
+    // handles of exited tasks resolve to "exited", empty slots to ""
+    void getSlotTaskName(const size_t slot, char* name, const size_t len) const;
+
+private:
+    static void sampleTimer();
+
+    struct SampleSlot {
+        std::atomic<TaskHandle_t> handle = nullptr;
+        std::atomic<uint32_t> samples = 0;
+    };
+
+    SampleSlot _slots[TASK_MONITOR_SLOT_COUNT];
+    std::atomic<uint32_t> _totalSamples = 0;
+    uint32_t _slotBaseline[TASK_MONITOR_SLOT_COUNT] = {};
+    uint32_t _totalBaseline = 0;
+
+    uint8_t* _traceBuffer = nullptr;
+    std::atomic<bool> _traceActive = false;
+    std::atomic<uint32_t> _traceWriteIdx = 0;
+};
+
+extern TaskMonitorClass TaskMonitor;
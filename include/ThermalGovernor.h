@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ArduinoJson.h>
+#include <TaskSchedulerDeclarations.h>
+#include <functional>
+#include <vector>
+
+// Predicted die temperature at which optional load is shed, and the
+// level below which it is restored. The gap provides hysteresis so the
+// throttles do not flap around the threshold.
+#ifndef THERMAL_GOVERNOR_HOT_CELSIUS
+#define THERMAL_GOVERNOR_HOT_CELSIUS 80.0f
+#endif
+#ifndef THERMAL_GOVERNOR_CLEAR_CELSIUS
+#define THERMAL_GOVERNOR_CLEAR_CELSIUS 72.0f
+#endif
+
+// Reference for the headroom metric: above this die temperature the
+// radio and WiFi are known to degrade regardless of what we shed.
+#ifndef THERMAL_GOVERNOR_CRITICAL_CELSIUS
+#define THERMAL_GOVERNOR_CRITICAL_CELSIUS 90.0f
+#endif
+
+// Watches the die temperature and sheds optional load before the heat
+// degrades the radio and control path. Subsystems register a throttle
+// callback; it is invoked with true when the governor engages and with
+// false when the temperature recovered. The decision uses a smoothed
+// reading plus the current trend (one minute lookahead), so a fast rise
+// in an outdoor enclosure engages the throttles proactively.
+class ThermalGovernorClass {
+public:
+    ThermalGovernorClass();
+    void init(Scheduler& scheduler);
+
+    // apply() is called from the main loop on engage (true) / release
+    // (false); it must be reversible.
+    void registerThrottle(const char* name, std::function<void(const bool active)> apply);
+
+    bool isThrottling() const { return _throttling; }
+    float getTemperature() const { return _filteredCelsius; }
+    float getTrendPerMinute() const { return _trendCelsiusPerMinute; }
+    float getHeadroomCelsius() const { return THERMAL_GOVERNOR_CRITICAL_CELSIUS - _filteredCelsius; }
+    uint32_t getActivations() const { return _activations; }
+
+    void serialize(JsonObject obj) const;
+
+private:
+    void loop();
+
+    Task _loopTask;
+
+    struct Throttle {
+        const char* name;
+        std::function<void(const bool)> apply;
+    };
+
+    std::vector<Throttle> _throttles;
+
+    bool _haveSample = false;
+    bool _throttling = false;
+    float _filteredCelsius = 0;
+    float _lastCelsius = 0;
+    float _trendCelsiusPerMinute = 0;
+    uint32_t _activations = 0;
+};
+
+extern ThermalGovernorClass ThermalGovernor;
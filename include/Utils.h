@@ -5,6 +5,8 @@
 #include <LittleFS.h>
 #include <cstdint>
 
+class Task;
+
 class Utils {
 public:
     static uint32_t getChipId();
@@ -14,4 +16,46 @@ public:
     static void removeAllFiles();
     static String generateMd5FromFile(String file);
     static void skipBom(File& f);
+
+    // Allocation tiers: small hot objects stay in internal SRAM (the
+    // 512 byte heap_caps_malloc_extmem_enable() threshold set in
+    // setup() takes care of plain malloc/new), DMA and flash-write
+    // buffers request internal RAM explicitly, and bulk buffers go
+    // through allocBulk(): PSRAM first, internal heap as fallback on
+    // boards without PSRAM. Returns nullptr only when both tiers are
+    // exhausted; free with free()/heap_caps_free().
+    static void* allocBulk(const size_t size);
+
+    // Enables a periodic task with a deterministic phase offset inside
+    // its period. The many 1-second housekeeping loops are all enabled
+    // during setup() and would otherwise fire in the same scheduler
+    // pass forever, turning every full second into a latency spike;
+    // staggered enables spread them across the period instead.
+    static void enableStaggered(Task& task);
+
+    // RAII checkout of a recycled JSON document. The document is backed
+    // by one of a small set of pre-sized arenas that live for the whole
+    // uptime, so request parsing does not allocate and destroy a heap
+    // document per operation. When every arena is checked out the
+    // document transparently falls back to the heap; serializeStats()
+    // reports checkouts that missed, high water marks and arena
+    // overflows to guide sizing.
+    class PooledJsonDocument {
+    public:
+        PooledJsonDocument();
+        ~PooledJsonDocument();
+
+        PooledJsonDocument(const PooledJsonDocument&) = delete;
+        PooledJsonDocument& operator=(const PooledJsonDocument&) = delete;
+
+        operator JsonDocument&() { return _doc; }
+        JsonDocument& operator*() { return _doc; }
+        JsonDocument* operator->() { return &_doc; }
+
+        static void serializeStats(JsonObject root);
+
+    private:
+        int8_t _slot; // -1: pool exhausted, _doc is heap backed
+        JsonDocument _doc;
+    };
 };
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Hoymiles.h>
+#include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <vector>
+
+// Cross-reboot warm start: the raw statistics payload, the yield-day
+// correction state and the DevInfo payloads of every inverter are
+// persisted to LittleFS and restored at boot, so consumers see
+// plausible data at t+0 instead of zeros until the first successful
+// poll. Restored statistics carry a warm-start marker (cleared by the
+// first real update and visible on /api/inverter/health); the yield-day
+// state is only re-applied once NTP time is available and the snapshot
+// stems from the same local day, so counters never glitch across an
+// OTA restart but a stale snapshot cannot inflate today's yield.
+//
+// Set -DWARMSTART_ENABLE=0 to compile the feature out.
+
+#ifndef WARMSTART_ENABLE
+#define WARMSTART_ENABLE 1
+#endif
+
+#define WARMSTART_FILENAME "/warmstart.bin"
+
+#ifndef WARMSTART_SAVE_INTERVAL
+#define WARMSTART_SAVE_INTERVAL (5 * TASK_MINUTE)
+#endif
+
+// File layout: WarmStartHeader followed by count records, little endian.
+struct __attribute__((packed)) WarmStartHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+};
+
+struct __attribute__((packed)) WarmStartRecord {
+    uint64_t serial;
+    uint32_t savedAt; // epoch seconds, 0 before NTP sync
+    uint8_t statisticLength;
+    uint8_t statistic[STATISTIC_PACKET_SIZE];
+    float lastYieldDay[CH_CNT];
+    float yieldDayOffset[CH_CNT];
+    uint8_t devInfoSimpleLength;
+    uint8_t devInfoSimple[DEV_INFO_SIZE];
+    uint8_t devInfoAllLength;
+    uint8_t devInfoAll[DEV_INFO_SIZE];
+};
+
+class WarmStartClass {
+public:
+    WarmStartClass();
+    void init(Scheduler& scheduler);
+
+private:
+    void restore();
+    void saveLoop();
+    void yieldRestoreLoop();
+
+    Task _saveTask;
+    Task _yieldRestoreTask;
+
+    // Records loaded at boot whose yield-day state still waits for NTP
+    std::vector<WarmStartRecord> _pendingYieldRestore;
+
+    uint32_t _lastSaveAt = 0;
+};
+
+extern WarmStartClass WarmStart;
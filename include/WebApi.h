@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "WebApi_dailystats.h"
 #include "WebApi_device.h"
 #include "WebApi_devinfo.h"
 #include "WebApi_dtu.h"
@@ -9,6 +10,7 @@
 #include "WebApi_file.h"
 #include "WebApi_firmware.h"
 #include "WebApi_gridprofile.h"
+#include "WebApi_history.h"
 #include "WebApi_i18n.h"
 #include "WebApi_inverter.h"
 #include "WebApi_limit.h"
@@ -18,8 +20,13 @@
 #include "WebApi_network.h"
 #include "WebApi_ntp.h"
 #include "WebApi_power.h"
+#include "WebApi_profiler.h"
 #include "WebApi_prometheus.h"
+#include "WebApi_radiostats.h"
+#include "WebApi_radiotrace.h"
+#include "WebApi_tasks.h"
 #include "WebApi_security.h"
+#include "WebApi_soaklog.h"
 #include "WebApi_sysstatus.h"
 #include "WebApi_webapp.h"
 #include "WebApi_ws_console.h"
@@ -27,6 +34,7 @@
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <map>
 
 class WebApiClass {
 public:
@@ -37,17 +45,78 @@ public:
     static bool checkCredentials(AsyncWebServerRequest* request);
     static bool checkCredentialsReadonly(AsyncWebServerRequest* request);
 
+    // Session-token fast path: issued after one successful credential
+    // handshake, presented in the X-Auth-Token header afterwards and
+    // validated with a constant-time compare instead of re-running the
+    // Authorization header verification on every request. Tokens
+    // expire after a fixed lifetime and are dropped when the security
+    // configuration changes.
+    static String issueAuthToken();
+    static void invalidateAuthTokens();
+    static uint32_t getAuthTokenLifetimeSeconds();
+
     static void sendTooManyRequests(AsyncWebServerRequest* request);
 
+    // Validator support: returns true when the client's If-None-Match
+    // header matches the current payload version and a 304 was sent, so
+    // the caller can skip generating the response entirely. On false the
+    // caller passes the same tag to sendJsonResponse() for the client to
+    // cache.
+    static bool checkETag(AsyncWebServerRequest* request, const String& etag);
+
+    // Closes clients whose websocket send queue has been full for
+    // longer than the stall timeout, so one unresponsive client cannot
+    // pile up frames until the heap collapses. stalledSince carries the
+    // per-client state between calls
+    static void evictStalledClients(AsyncWebSocket& ws, std::map<uint32_t, uint32_t>& stalledSince);
+
     static void writeConfig(JsonVariant& retMsg, const WebApiError code = WebApiError::GenericSuccess, const String& message = "Settings saved!");
 
     static bool parseRequestData(AsyncWebServerRequest* request, AsyncJsonResponse* response, JsonDocument& json_document);
     static uint64_t parseSerialFromRequest(AsyncWebServerRequest* request, String param_name = "inv");
     static bool sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line);
+    static bool sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line, const String& etag);
+
+    // Per-route request statistics, recorded by a middleware wrapped
+    // around every handler. Updates and reads both happen on the
+    // async_tcp task, so no locking is required.
+    struct RouteStats {
+        static constexpr uint32_t durationBucketBoundsUs[5] = { 100, 1000, 10000, 100000, 1000000 };
+
+        uint32_t invocations = 0;
+        uint64_t bytesOut = 0; // JSON payload bytes, streamed responses are not accounted
+
+        // Handler execution time, cumulative buckets "<= bound" plus overflow
+        uint32_t durationBuckets[6] = {};
+        uint64_t durationSumUs = 0;
+    };
+
+    const std::map<String, RouteStats>& getRouteStats() const { return _routeStats; }
+    uint32_t getActiveRequests() const { return _activeRequests; }
+
+    // Connection reuse accounting for keep-alive tuning: how many TCP
+    // connections served their first request vs. how many requests rode
+    // an already-open connection
+    uint32_t getConnectionsOpened() const { return _connectionsOpened; }
+    uint32_t getReusedConnectionRequests() const { return _reusedRequests; }
 
 private:
+    void onWebApiStats(AsyncWebServerRequest* request);
+    RouteStats& routeStats(AsyncWebServerRequest* request);
+    void trackConnection(AsyncWebServerRequest* request);
+
     AsyncWebServer _server;
+    AsyncMiddlewareFunction _statsMiddleware;
+    std::map<String, RouteStats> _routeStats;
+    uint32_t _activeRequests = 0;
+
+    // Recently seen connections, keyed by client object and remote
+    // port; only touched on the async_tcp task like _routeStats
+    std::map<uintptr_t, uint32_t> _connectionLastSeen;
+    uint32_t _connectionsOpened = 0;
+    uint32_t _reusedRequests = 0;
 
+    WebApiDailyStatsClass _webApiDailyStats;
     WebApiDeviceClass _webApiDevice;
     WebApiDevInfoClass _webApiDevInfo;
     WebApiDtuClass _webApiDtu;
@@ -57,6 +126,7 @@ private:
     WebApiGridProfileClass _webApiGridprofile;
     WebApiI18nClass _webApiI18n;
     WebApiInverterClass _webApiInverter;
+    WebApiHistoryClass _webApiHistory;
     WebApiLimitClass _webApiLimit;
     WebApiLoggingClass _webApiLogging;
     WebApiMaintenanceClass _webApiMaintenance;
@@ -64,8 +134,13 @@ private:
     WebApiNetworkClass _webApiNetwork;
     WebApiNtpClass _webApiNtp;
     WebApiPowerClass _webApiPower;
+    WebApiProfilerClass _webApiProfiler;
     WebApiPrometheusClass _webApiPrometheus;
+    WebApiRadioStatsClass _webApiRadioStats;
+    WebApiRadioTraceClass _webApiRadioTrace;
+    WebApiTasksClass _webApiTasks;
     WebApiSecurityClass _webApiSecurity;
+    WebApiSoakLogClass _webApiSoakLog;
     WebApiSysstatusClass _webApiSysstatus;
     WebApiWebappClass _webApiWebapp;
     WebApiWsConsoleClass _webApiWsConsole;
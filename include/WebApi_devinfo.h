@@ -10,4 +10,5 @@ public:
 
 private:
     void onDevInfoStatus(AsyncWebServerRequest* request);
+    void onDevInfoRawdataBin(AsyncWebServerRequest* request);
 };
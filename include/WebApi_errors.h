@@ -63,6 +63,8 @@ enum WebApiError {
     MqttHassTopicCharacter,
     MqttLwtQos,
     MqttClientIdLength,
+    MqttFullPublishInterval,
+    MqttLimitCoalesceWindow,
 
     NetworkBase = 8000,
     NetworkIpInvalid,
@@ -96,4 +98,9 @@ enum WebApiError {
 
     HardwareBase = 12000,
     HardwarePinMappingLength,
+
+    FirmwareBase = 13000,
+    FirmwarePullBusy,
+    FirmwarePullUrlInvalid,
+    FirmwarePullStarted,
 };
@@ -3,11 +3,37 @@
 
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <map>
 
 class WebApiEventlogClass {
 public:
+    WebApiEventlogClass();
     void init(AsyncWebServer& server, Scheduler& scheduler);
+    void reload();
 
 private:
     void onEventlogStatus(AsyncWebServerRequest* request);
+    void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+
+    AsyncWebSocket _ws;
+    AsyncAuthenticationMiddleware _simpleDigestAuth;
+
+    // Newest alarm timestamp already pushed per inverter serial; the
+    // next push only carries entries newer than this cursor
+    std::map<uint64_t, time_t> _pushedCursor;
+
+    // Start of the alarm burst currently arriving (0: none); written
+    // from the radio task via the alarm log listener
+    std::atomic<uint32_t> _alarmBurstSince = 0;
+
+    // Clients whose send queue ran full, keyed by id with the first
+    // observed stall time
+    std::map<uint32_t, uint32_t> _stalledClients;
+
+    Task _wsCleanupTask;
+    void wsCleanupTaskCb();
+
+    Task _sendAlarmsTask;
+    void sendAlarmsTaskCb();
 };
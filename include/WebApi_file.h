@@ -2,17 +2,45 @@
 #pragma once
 
 #include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
 #include <TaskSchedulerDeclarations.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class WebApiFileClass {
 public:
+    WebApiFileClass();
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
+    // State shared between the async_tcp response callback and the
+    // scheduler-driven refill task. The response callback only copies
+    // out of the read-ahead buffer; all flash reads happen in
+    // refillLoop() on the main loop so a download never stalls the
+    // async_tcp task (and with it the live websockets).
+    struct FileStream {
+        File file;
+        size_t remaining = 0; // bytes left to read from flash
+        std::vector<uint8_t> buffer; // read-ahead chunk
+        size_t fill = 0; // valid bytes in buffer
+        size_t offset = 0; // bytes of buffer already sent
+        bool aborted = false; // client went away
+        std::mutex mutex;
+    };
+
     void onFileGet(AsyncWebServerRequest* request);
     void onFileDelete(AsyncWebServerRequest* request);
     void onFileDeleteAll(AsyncWebServerRequest* request);
     void onFileListGet(AsyncWebServerRequest* request);
     void onFileUploadFinish(AsyncWebServerRequest* request);
     void onFileUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final);
+
+    static bool parseRangeHeader(const String& value, const size_t fileSize, size_t& start, size_t& end);
+    void refillLoop();
+
+    Task _refillTask;
+    std::list<std::shared_ptr<FileStream>> _streams;
+    std::mutex _streamsMutex;
 };
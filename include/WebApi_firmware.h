@@ -3,12 +3,68 @@
 
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 class WebApiFirmwareClass {
 public:
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
+    // One filled buffer travelling from the upload callback to the
+    // flash writer task
+    struct FlashChunk {
+        uint8_t* data;
+        size_t len;
+        bool final;
+    };
+
     void onFirmwareUpdateFinish(AsyncWebServerRequest* request);
     void onFirmwareUpdateUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final);
+    void onFirmwareUpdateUrl(AsyncWebServerRequest* request);
+    void onFirmwareUpdateStatus(AsyncWebServerRequest* request);
+    static void pullTask(void* arg);
+    String runPull();
+
+    bool startFlashPipeline();
+    void stopFlashPipeline();
+    void abortFlashPipeline();
+    bool stageData(const uint8_t* data, size_t len);
+    bool submitFillBuffer(const bool final);
+    static void flashWriterTask(void* arg);
+
+    // Double-buffered OTA pipeline state. The async_tcp task owns
+    // _fillBuffer, the writer task owns whatever travels through
+    // _workQueue; buffers rotate back via _freeQueue.
+    QueueHandle_t _freeQueue = nullptr;
+    QueueHandle_t _workQueue = nullptr;
+    SemaphoreHandle_t _flashDone = nullptr;
+    uint8_t* _buffers[2] = { nullptr, nullptr };
+    uint8_t* _fillBuffer = nullptr;
+    size_t _fillLen = 0;
+    std::atomic<bool> _flashError = false;
+    bool _pipelineActive = false;
+
+    // OTA-pull state: the device fetches the image itself so a fleet
+    // can be upgraded in parallel off one HTTP server. Progress is
+    // exposed via /api/firmware/status for the orchestration tool.
+    enum class PullState : uint8_t {
+        Idle,
+        Downloading,
+        Finishing,
+        Success,
+        Failed,
+    };
+
+    std::atomic<PullState> _pullState = PullState::Idle;
+    std::atomic<bool> _pullActive = false;
+    std::atomic<size_t> _pullBytesFetched = 0;
+    std::atomic<int32_t> _pullBytesTotal = -1; // -1: unknown length
+    String _pullUrl;
+    String _pullMd5;
+    String _pullError;
+
+    static const char* pullStateName(const PullState state);
 };
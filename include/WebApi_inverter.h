@@ -15,4 +15,5 @@ private:
     void onInverterDelete(AsyncWebServerRequest* request);
     void onInverterOrder(AsyncWebServerRequest* request);
     void onInverterStatReset(AsyncWebServerRequest* request);
+    void onInverterHealth(AsyncWebServerRequest* request);
 };
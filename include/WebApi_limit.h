@@ -2,13 +2,51 @@
 #pragma once
 
 #include <ESPAsyncWebServer.h>
+#include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
 
 class WebApiLimitClass {
 public:
+    WebApiLimitClass();
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
+    // A limit POST only validates and drops the command here; the
+    // intake task hands it to the inverter from the main loop. The
+    // HTTP round-trip is acknowledged with a ticket id the caller can
+    // poll on /api/limit/status.
+    enum class TicketState : uint8_t {
+        Queued, // accepted, not yet handed to the command queue
+        Submitted, // handed to the inverter command queue
+        Rejected, // inverter disappeared before submission
+    };
+
+    struct LimitOrder {
+        uint32_t ticket;
+        uint64_t serial;
+        float limit;
+        PowerLimitControlType type;
+    };
+
+    struct TicketInfo {
+        uint32_t ticket;
+        TicketState state;
+        // Completion token of the submitted command; set once the
+        // order was handed to the command queue
+        std::shared_ptr<CommandResult> result;
+    };
+
     void onLimitStatus(AsyncWebServerRequest* request);
     void onLimitPost(AsyncWebServerRequest* request);
+    void intakeLoop();
+
+    Task _intakeTask;
+    std::deque<LimitOrder> _intake;
+    std::map<uint64_t, TicketInfo> _lastTicket;
+    uint32_t _nextTicket = 1;
+    std::mutex _intakeMutex;
 };
@@ -10,6 +10,7 @@ public:
 
 private:
     void onMqttStatus(AsyncWebServerRequest* request);
+    void onMqttStats(AsyncWebServerRequest* request);
     void onMqttAdminGet(AsyncWebServerRequest* request);
     void onMqttAdminPost(AsyncWebServerRequest* request);
     String getTlsCertInfo(const char* cert);
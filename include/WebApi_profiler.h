@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <TaskSchedulerDeclarations.h>
+
+class WebApiProfilerClass {
+public:
+    void init(AsyncWebServer& server, Scheduler& scheduler);
+
+private:
+    void onProfilerStatus(AsyncWebServerRequest* request);
+    void onLockReport(AsyncWebServerRequest* request);
+    void onSamplesDump(AsyncWebServerRequest* request);
+    void onSamplesStart(AsyncWebServerRequest* request);
+    void onSamplesStop(AsyncWebServerRequest* request);
+    void onJsonBench(AsyncWebServerRequest* request);
+};
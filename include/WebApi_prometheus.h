@@ -5,6 +5,7 @@
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
 #include <map>
+#include <memory>
 
 class WebApiPrometheusClass {
 public:
@@ -12,11 +13,26 @@ public:
 
 private:
     void onPrometheusMetricsGet(AsyncWebServerRequest* request);
+    void sendProtobufMetrics(AsyncWebServerRequest* request);
 
-    void addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
+    // Pre-rendered metric/label prefixes per inverter. Validated against
+    // the inverter's position and name on every scrape and rebuilt
+    // lazily, so config changes need no explicit invalidation.
+    struct MetricPrefixes {
+        uint8_t idx = 0xff;
+        String name;
+        String inverterLabels; // {serial="..",unit="..",name=".."}
+        std::map<uint32_t, String> fields; // keyed by packed (type, channel, field)
+    };
+
+    MetricPrefixes& getMetricPrefixes(std::shared_ptr<InverterAbstract> inv, const uint8_t idx);
+
+    void addField(AsyncResponseStream* stream, MetricPrefixes& prefixes, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
 
     void addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel);
 
+    std::map<uint64_t, MetricPrefixes> _metricPrefixCache;
+
     enum MetricType_t {
         NONE = 0,
         GAUGE,
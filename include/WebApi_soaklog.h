@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <TaskSchedulerDeclarations.h>
+
+class WebApiSoakLogClass {
+public:
+    void init(AsyncWebServer& server, Scheduler& scheduler);
+
+private:
+    void onSoakLogStatus(AsyncWebServerRequest* request);
+    void onSoakLogStart(AsyncWebServerRequest* request);
+    void onSoakLogStop(AsyncWebServerRequest* request);
+};
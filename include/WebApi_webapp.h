@@ -3,11 +3,42 @@
 
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <cstdint>
+#include <vector>
 
 class WebApiWebappClass {
 public:
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
-    void responseBinaryDataWithETagCache(AsyncWebServerRequest* request, const String& contentType, const String& contentEncoding, const uint8_t* content, size_t len);
+    enum class AssetEncoding : uint8_t {
+        Identity = 0,
+        Gzip = 1,
+        Brotli = 2,
+    };
+
+    // One entry per file in the webapp partition image. The data
+    // pointer aims straight into the memory-mapped flash partition, so
+    // assets are served without copying them into RAM first. The same
+    // path may appear once per encoding; findAsset picks the best one
+    // the client accepts.
+    struct WebappAsset {
+        String path;
+        String contentType;
+        AssetEncoding encoding;
+        const uint8_t* data;
+        size_t size;
+        // Hashed once at image load, so a request only compares strings
+        String etag;
+    };
+
+    bool loadAssetTable();
+    const WebappAsset* findAsset(const String& url, const bool acceptsBrotli) const;
+    void serveAsset(AsyncWebServerRequest* request, const WebappAsset& asset);
+    void onWebappUpdateFinish(AsyncWebServerRequest* request);
+    void onWebappUpdateUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final);
+
+    std::vector<WebappAsset> _assets;
+    const uint8_t* _imageBase = nullptr;
+    uint32_t _imageCrc = 0;
 };
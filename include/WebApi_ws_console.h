@@ -1,19 +1,69 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "MessageOutput.h"
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
-class WebApiWsConsoleClass {
+class WebApiWsConsoleClass : public MessageOutputLineSink {
 public:
     WebApiWsConsoleClass();
     void init(AsyncWebServer& server, Scheduler& scheduler);
     void reload();
 
+    // receives finished log lines from MessageOutput's consumer loop
+    void writeLine(const uint8_t* buffer, size_t size) override;
+
 private:
+    using message_t = std::vector<uint8_t>;
+
+    // per-client console state. the severity/TAG filter is negotiated
+    // once at connect time through query parameters on the websocket
+    // URL (/console?level=W&tag=mqtt,yieldday) and applied server-side,
+    // so lines the client is not interested in never hit its TCP queue.
+    struct ClientState {
+        uint8_t maxSeverity = 0; // least important severity wanted, 0 = no filter
+        String tagFilter; // comma-separated allow-list, empty = no filter
+        std::shared_ptr<message_t> chunk; // filtered lines awaiting send
+        uint32_t lastSent = 0;
+        bool dropped = false; // a chunk was discarded due to a full send queue
+    };
+
+    // we chunk the websocket output to circumvent issues with TCP delayed ACKs:
+    // if the websocket client (Windows in particular) is using delayed ACKs,
+    // and since we wait for an ACK before sending the next chunk, we will
+    // accumulate way too many messages and we won't be able to send them out
+    // fast enough as the rate of produced messages is higher than the rate of
+    // ACKs received. by chunking and waiting in between chunks, we either
+    // "motivate" the client to send out ACKs immediately as the TCP packets are
+    // "large", or we will wait long enough for the TCP stack to send out the
+    // ACK anyways.
+    static constexpr size_t WS_CHUNK_SIZE_BYTES = 512;
+    static constexpr uint32_t WS_CHUNK_INTERVAL_MS = 250;
+
+    void onEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
+        AwsEventType type, void* arg, uint8_t* data, size_t len);
+    void flushClient(AsyncWebSocketClient& client, ClientState& state);
+    static uint8_t severityRank(char level);
+    static bool parseLine(const uint8_t* buffer, size_t size, uint8_t& severity, String& tag);
+    static bool tagMatches(const String& filter, const String& tag);
+
     AsyncWebSocket _ws;
     AsyncAuthenticationMiddleware _simpleDigestAuth;
 
+    // guards _clients: onEvent() runs in the async_tcp task, while
+    // writeLine() and the cleanup task run on the main task
+    std::mutex _clientMutex;
+    std::map<uint32_t, ClientState> _clients;
+
+    // Clients whose send queue ran full, keyed by id with the first
+    // observed stall time
+    std::map<uint32_t, uint32_t> _stalledClients;
+
     Task _wsCleanupTask;
     void wsCleanupTaskCb();
 };
@@ -6,6 +6,8 @@
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
+#include <set>
+#include <vector>
 
 class WebApiWsLiveClass {
 public:
@@ -13,12 +15,24 @@ public:
     void init(AsyncWebServer& server, Scheduler& scheduler);
     void reload();
 
-private:
+    // Stateless payload builders, also used by the serialization
+    // benchmark on /api/profiler/jsonbench
     static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
-    static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
+    // fieldMask is a bitmask over FieldId_t: non-zero restricts the
+    // emitted channel fields to the set bits (field projection), zero
+    // emits everything. maxPrecision caps the number of decimals per
+    // value below the field's own digits metadata
+    static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const uint32_t changedSince = 0, const bool compact = false, const uint32_t fieldMask = 0, const uint8_t maxPrecision = 0xff);
     static void generateCommonJsonResponse(JsonVariant& root);
 
-    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "");
+    // Field metadata for compact clients, keyed by numeric field id.
+    // Everything static per inverter model and config (names, units,
+    // digits, panel names) moves into this one-time frame so data
+    // frames can carry bare id/value pairs.
+    static void generateInverterSchemaJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
+
+private:
+    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const uint32_t changedSince = 0, const bool compact = false, const uint8_t maxPrecision = 0xff, String topic = "");
     static void addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits);
 
     void onLivedataStatus(AsyncWebServerRequest* request);
@@ -29,6 +43,41 @@ private:
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
 
+    // Baseline for delta frames: internal statistics timestamp of the
+    // last frame pushed per inverter, 0 forces a full frame
+    uint32_t _lastPublishedStatsVersion[INV_MAX_COUNT] = { 0 };
+
+    // Clients that opted into delta frames via "?delta=1". Guarded by
+    // _mutex, written from the websocket event handler
+    std::set<uint32_t> _deltaClients;
+
+    // Clients that opted into the compact protocol via "?compact=1":
+    // they receive a schema frame once after connecting and bare
+    // field-id/value data frames afterwards. Both guarded by _mutex
+    std::set<uint32_t> _compactClients;
+    std::set<uint32_t> _schemaPending;
+
+    // Clients whose send queue ran full, keyed by id with the first
+    // observed stall time
+    std::map<uint32_t, uint32_t> _stalledClients;
+
+    // Admission control: a newly connected client does not trigger a
+    // fleet-wide full push but is queued here and receives its initial
+    // snapshot one inverter at a time, a bounded number of clients and
+    // inverters per tick. Guarded by _mutex
+    struct AdmittingClient {
+        uint32_t id;
+        uint8_t nextInverter;
+    };
+    std::vector<AdmittingClient> _admissionQueue;
+
+    // 0: full rate, 1: reduced, 2: degraded - derived from the viewer
+    // count and the thermal throttle, echoed in every frame as
+    // "quality" so clients can show why updates slowed down
+    uint8_t _qualityLevel = 0;
+    bool _thermalThrottled = false;
+    uint32_t _lastFleetPass = 0;
+
     std::mutex _mutex;
 
     Task _wsCleanupTask;
@@ -36,4 +85,8 @@ private:
 
     Task _sendDataTask;
     void sendDataTaskCb();
+    void sendSchemaFrames();
+    void admitClients();
+    void updatePushQuality();
+    bool isAdmitting(const uint32_t clientId) const;
 };
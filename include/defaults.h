@@ -15,6 +15,8 @@
 
 #define WIFI_RECONNECT_TIMEOUT 60
 #define WIFI_RECONNECT_REDO_TIMEOUT 600
+#define WIFI_RECONNECT_WATCHDOG_MIN_TIMEOUT 10
+#define WIFI_RECONNECT_WATCHDOG_MAX_TIMEOUT 60
 
 #define WIFI_SSID ""
 #define WIFI_PASSWORD ""
@@ -25,6 +27,10 @@
 #define SYSLOG_ENABLED false
 #define SYSLOG_PORT 514
 
+#define FEDERATION_ENABLED false
+#define FEDERATION_ROLE 0U
+#define FEDERATION_PORT 8220
+
 #define NTP_SERVER_OLD "pool.ntp.org"
 #define NTP_SERVER "opendtu.pool.ntp.org"
 #define NTP_TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"
@@ -81,6 +87,10 @@
 #define MQTT_LWT_OFFLINE "offline"
 #define MQTT_LWT_QOS 2U
 #define MQTT_PUBLISH_INTERVAL 5U
+#define MQTT_FULL_PUBLISH_INTERVAL 60U
+#define MQTT_COMPACT_JSON false
+#define MQTT_COMPACT_JSON_COMPRESS false
+#define MQTT_LIMIT_COALESCE_WINDOW 500U
 #define MQTT_CLEAN_SESSION true
 
 #define DTU_SERIAL 0x99978563412U
@@ -1,6 +1,8 @@
 #include "cmt_spi3.h"
 #include <Arduino.h>
+#include <SpiBatch.h>
 #include <SpiManager.h>
+#include <algorithm>
 #include <driver/spi_master.h>
 
 SemaphoreHandle_t paramLock = NULL;
@@ -43,7 +45,7 @@ void cmt_spi3_init(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin
         .input_delay_ns = 0,
         .spics_io_num = -1, // CS handled by callbacks
         .flags = SPI_DEVICE_HALFDUPLEX | SPI_DEVICE_3WIRE,
-        .queue_size = 1,
+        .queue_size = SPI_MANAGER_BATCH_SIZE, // FIFO access queues chains of per-byte transactions
         .pre_cb = pre_cb,
         .post_cb = post_cb,
     };
@@ -109,48 +111,62 @@ uint8_t cmt_spi3_read(const uint8_t addr)
     return data;
 }
 
+// The FIFO interface requires one FCSB-framed 8-bit transaction per
+// byte, but nothing forces a full polling round trip for each of them:
+// the per-byte transactions are queued as a chain and the driver
+// pipelines them, paying the setup cost once per chain
 void cmt_spi3_write_fifo(const uint8_t* buf, const uint16_t len)
 {
-    spi_transaction_t trans {
-        .flags = 0,
-        .cmd = 0,
-        .addr = 0,
-        .length = 8,
-        .rxlength = 0,
-        .user = &cs_fifo, // CS for FIFO access
-        .tx_buffer = nullptr,
-        .rx_buffer = nullptr,
-    };
+    spi_transaction_t trans[SPI_MANAGER_BATCH_SIZE];
 
     SPI_PARAM_LOCK();
-    spi_device_acquire_bus(spi, portMAX_DELAY);
-    for (uint8_t i = 0; i < len; i++) {
-        trans.tx_buffer = buf + i;
-        ESP_ERROR_CHECK(spi_device_polling_transmit(spi, &trans));
+    uint16_t done = 0;
+    while (done < len) {
+        const uint16_t n = std::min<uint16_t>(len - done, SPI_MANAGER_BATCH_SIZE);
+        for (uint16_t i = 0; i < n; i++) {
+            trans[i] = spi_transaction_t {
+                .flags = SPI_TRANS_USE_TXDATA,
+                .cmd = 0,
+                .addr = 0,
+                .length = 8,
+                .rxlength = 0,
+                .user = &cs_fifo, // CS for FIFO access
+                .tx_buffer = nullptr,
+                .rx_buffer = nullptr,
+            };
+            trans[i].tx_data[0] = buf[done + i];
+        }
+        ESP_ERROR_CHECK(SpiBatch::transmit(spi, trans, n));
+        done += n;
     }
-    spi_device_release_bus(spi);
     SPI_PARAM_UNLOCK();
 }
 
 void cmt_spi3_read_fifo(uint8_t* buf, const uint16_t len)
 {
-    spi_transaction_t trans {
-        .flags = 0,
-        .cmd = 0,
-        .addr = 0,
-        .length = 0,
-        .rxlength = 8,
-        .user = &cs_fifo, // CS for FIFO access
-        .tx_buffer = nullptr,
-        .rx_buffer = nullptr,
-    };
+    spi_transaction_t trans[SPI_MANAGER_BATCH_SIZE];
 
     SPI_PARAM_LOCK();
-    spi_device_acquire_bus(spi, portMAX_DELAY);
-    for (uint8_t i = 0; i < len; i++) {
-        trans.rx_buffer = buf + i;
-        ESP_ERROR_CHECK(spi_device_polling_transmit(spi, &trans));
+    uint16_t done = 0;
+    while (done < len) {
+        const uint16_t n = std::min<uint16_t>(len - done, SPI_MANAGER_BATCH_SIZE);
+        for (uint16_t i = 0; i < n; i++) {
+            trans[i] = spi_transaction_t {
+                .flags = SPI_TRANS_USE_RXDATA,
+                .cmd = 0,
+                .addr = 0,
+                .length = 0,
+                .rxlength = 8,
+                .user = &cs_fifo, // CS for FIFO access
+                .tx_buffer = nullptr,
+                .rx_buffer = nullptr,
+            };
+        }
+        ESP_ERROR_CHECK(SpiBatch::transmit(spi, trans, n));
+        for (uint16_t i = 0; i < n; i++) {
+            buf[done + i] = trans[i].rx_data[0];
+        }
+        done += n;
     }
-    spi_device_release_bus(spi);
     SPI_PARAM_UNLOCK();
 }
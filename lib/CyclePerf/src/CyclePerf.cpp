@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "CyclePerf.h"
+
+// Zero-initialized statics, safe to register into from constructors of
+// function-local static probes regardless of translation unit order
+static CyclePerfProbe* sProbes[CYCLE_PERF_MAX_PROBES];
+static std::atomic<size_t> sProbeCount { 0 };
+
+CyclePerfProbe::CyclePerfProbe(const char* name)
+    : _name(name)
+{
+    const size_t slot = sProbeCount.fetch_add(1, std::memory_order_acq_rel);
+    if (slot < CYCLE_PERF_MAX_PROBES) {
+        sProbes[slot] = this;
+    }
+}
+
+size_t CyclePerfProbe::getProbeCount()
+{
+    const size_t count = sProbeCount.load(std::memory_order_acquire);
+    return count < CYCLE_PERF_MAX_PROBES ? count : CYCLE_PERF_MAX_PROBES;
+}
+
+const CyclePerfProbe* CyclePerfProbe::getProbe(const size_t index)
+{
+    return sProbes[index];
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Cycle-accurate scope probes for paths where millis() is too coarse
+// (fragment handling, field decoding - work on the 100 microsecond
+// scale). A probe is declared once per site via CYCLE_PERF_SCOPE and
+// records the CPU cycle delta of each pass into fixed power-of-two
+// histogram bins, so the cost per hit is a cycle counter read and one
+// relaxed increment. Probes self-register into a fixed global table
+// that /api/profiler serializes.
+//
+// Set -DCYCLEPERF_ENABLE=0 to compile the probes out entirely.
+
+#ifndef CYCLEPERF_ENABLE
+#define CYCLEPERF_ENABLE 1
+#endif
+
+// Bin i counts passes shorter than 64 * 2^(i+1) cycles; the last bin
+// collects everything longer. At 240 MHz bin 0 ends at ~0.5 us and
+// bin 14 at ~8.7 ms.
+#define CYCLE_PERF_BIN_COUNT 16
+
+// Fixed probe table size; registration beyond this is dropped
+#define CYCLE_PERF_MAX_PROBES 16
+
+class CyclePerfProbe {
+public:
+    explicit CyclePerfProbe(const char* name);
+
+    void record(const uint32_t cycles)
+    {
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _bins[binForCycles(cycles)].fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t seen = _maxCycles.load(std::memory_order_relaxed);
+        while (cycles > seen && !_maxCycles.compare_exchange_weak(seen, cycles, std::memory_order_relaxed)) {
+        }
+    }
+
+    const char* getName() const { return _name; }
+    uint32_t getCount() const { return _count.load(std::memory_order_relaxed); }
+    uint32_t getMaxCycles() const { return _maxCycles.load(std::memory_order_relaxed); }
+    uint32_t getBin(const size_t bin) const { return _bins[bin].load(std::memory_order_relaxed); }
+
+    // Registry access for the profiler endpoint
+    static size_t getProbeCount();
+    static const CyclePerfProbe* getProbe(const size_t index);
+
+private:
+    static uint8_t binForCycles(uint32_t cycles)
+    {
+        uint8_t bin = 0;
+        cycles >>= 7;
+        while (cycles != 0 && bin < CYCLE_PERF_BIN_COUNT - 1) {
+            cycles >>= 1;
+            bin++;
+        }
+        return bin;
+    }
+
+    const char* _name;
+    std::atomic<uint32_t> _count { 0 };
+    std::atomic<uint32_t> _maxCycles { 0 };
+    std::atomic<uint32_t> _bins[CYCLE_PERF_BIN_COUNT] = {};
+};
+
+// Times the enclosing scope and records the delta on exit
+class CyclePerfScope {
+public:
+    explicit CyclePerfScope(CyclePerfProbe& probe)
+        : _probe(probe)
+        , _start(ESP.getCycleCount())
+    {
+    }
+
+    ~CyclePerfScope()
+    {
+        _probe.record(ESP.getCycleCount() - _start);
+    }
+
+private:
+    CyclePerfProbe& _probe;
+    const uint32_t _start;
+};
+
+#if CYCLEPERF_ENABLE
+#define CYCLE_PERF_CONCAT2(a, b) a##b
+#define CYCLE_PERF_CONCAT(a, b) CYCLE_PERF_CONCAT2(a, b)
+#define CYCLE_PERF_SCOPE(name)                                               \
+    static CyclePerfProbe CYCLE_PERF_CONCAT(_cyclePerfProbe, __LINE__)(name); \
+    CyclePerfScope CYCLE_PERF_CONCAT(_cyclePerfScope, __LINE__)(CYCLE_PERF_CONCAT(_cyclePerfProbe, __LINE__))
+#else
+#define CYCLE_PERF_SCOPE(name) \
+    do {                       \
+    } while (0)
+#endif
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+
+// Fixed-capacity vector with inline storage. Elements live inside the
+// object itself, so instances can be returned by value and iterated
+// without touching the heap - unlike std::vector or std::list, which
+// allocate per use and can fail mid-exchange. Capacity is a compile
+// time bound; push_back() beyond it drops the element and reports
+// failure instead of growing.
+//
+// Only meant for small trivially copyable element types (enums, ids,
+// PODs); elements are default-constructed with the container.
+template <typename T, size_t N>
+class FixedVector {
+public:
+    using value_type = T;
+
+    bool push_back(const T& value)
+    {
+        if (_size >= N) {
+            return false;
+        }
+        _data[_size++] = value;
+        return true;
+    }
+
+    // Membership helper for the small-N dedup loops
+    bool contains(const T& value) const
+    {
+        for (size_t i = 0; i < _size; i++) {
+            if (_data[i] == value) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() { _size = 0; }
+
+    size_t size() const { return _size; }
+    static constexpr size_t capacity() { return N; }
+    bool empty() const { return _size == 0; }
+
+    T& operator[](const size_t idx) { return _data[idx]; }
+    const T& operator[](const size_t idx) const { return _data[idx]; }
+
+    T* begin() { return _data; }
+    T* end() { return _data + _size; }
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+
+private:
+    T _data[N] = {};
+    size_t _size = 0;
+};
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "CommandSequence.h"
+#include "HoymilesRadio.h"
+
+std::shared_ptr<CommandSequence> CommandSequence::create(HoymilesRadio* radio)
+{
+    // not make_shared: the constructor is private
+    return std::shared_ptr<CommandSequence>(new CommandSequence(radio));
+}
+
+CommandSequence::CommandSequence(HoymilesRadio* radio)
+    : _radio(radio)
+{
+}
+
+CommandSequence& CommandSequence::addStep(StepFactory factory, const uint8_t maxRetries)
+{
+    _steps.push_back(Step { std::move(factory), maxRetries });
+    return *this;
+}
+
+void CommandSequence::start(DoneCallback onDone)
+{
+    if (_running || _cancelled || _steps.empty()) {
+        return;
+    }
+
+    _onDone = std::move(onDone);
+    _running = true;
+    _currentStep = 0;
+    _attempt = 0;
+    runCurrentStep();
+}
+
+void CommandSequence::cancel()
+{
+    _cancelled = true;
+    _running = false;
+    _onDone = nullptr;
+}
+
+void CommandSequence::runCurrentStep()
+{
+    auto cmd = _steps[_currentStep].factory();
+    if (!cmd) {
+        finish(CMD_NOK);
+        return;
+    }
+
+    // The callback keeps the sequence alive while a command of it is
+    // in flight. It also fires when the command is dropped from the
+    // queue before transmission, so a sequence never stalls.
+    auto self = shared_from_this();
+    cmd->setCompletionCallback([self](CommandAbstract&, const LastCommandSuccess status) {
+        self->onStepCompleted(status);
+    });
+
+    _radio->enqueCommand(cmd);
+}
+
+void CommandSequence::onStepCompleted(const LastCommandSuccess status)
+{
+    if (!_running || _cancelled) {
+        return;
+    }
+
+    if (status == CMD_OK) {
+        _currentStep++;
+        _attempt = 0;
+        if (_currentStep >= _steps.size()) {
+            finish(CMD_OK);
+            return;
+        }
+        runCurrentStep();
+        return;
+    }
+
+    if (_attempt < _steps[_currentStep].maxRetries) {
+        _attempt++;
+        runCurrentStep();
+        return;
+    }
+
+    finish(status);
+}
+
+void CommandSequence::finish(const LastCommandSuccess status)
+{
+    _running = false;
+    if (_onDone) {
+        _onDone(status);
+        _onDone = nullptr;
+    }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "commands/CommandAbstract.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class HoymilesRadio;
+
+// Linear multi-step protocol over the command queue. Each step is a
+// factory that builds a fresh command for every attempt; the sequence
+// advances (or retries a failed step) from the command's completion
+// callback, which fires on the radio loop task the moment an exchange
+// ends. A follow-up or retry therefore hits the queue immediately
+// instead of waiting for the next pass of a poll-granularity state
+// machine. The sequence keeps itself alive through the callbacks of
+// its in-flight command, so the creator may drop its reference after
+// start().
+class CommandSequence : public std::enable_shared_from_this<CommandSequence> {
+public:
+    using StepFactory = std::function<std::shared_ptr<CommandAbstract>()>;
+    using DoneCallback = std::function<void(const LastCommandSuccess)>;
+
+    static std::shared_ptr<CommandSequence> create(HoymilesRadio* radio);
+
+    // Appends a step. maxRetries counts additional attempts of this
+    // step after a failed exchange, on top of the frame resends the
+    // radio performs within one exchange.
+    CommandSequence& addStep(StepFactory factory, const uint8_t maxRetries = 0);
+
+    // Runs the steps in order. onDone receives CMD_OK after the last
+    // step succeeded, or the failing status once a step exhausted its
+    // retries. A sequence can only be started once.
+    void start(DoneCallback onDone = nullptr);
+
+    // Detaches the sequence: pending completion events are ignored and
+    // no further commands are enqueued. Required before an inverter
+    // that step factories point into is removed.
+    void cancel();
+
+private:
+    explicit CommandSequence(HoymilesRadio* radio);
+
+    void runCurrentStep();
+    void onStepCompleted(const LastCommandSuccess status);
+    void finish(const LastCommandSuccess status);
+
+    struct Step {
+        StepFactory factory;
+        uint8_t maxRetries;
+    };
+
+    HoymilesRadio* _radio;
+    std::vector<Step> _steps;
+    DoneCallback _onDone;
+
+    size_t _currentStep = 0;
+    uint8_t _attempt = 0;
+    bool _running = false;
+    bool _cancelled = false;
+};
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "EventCounters.h"
+
+EventCountersClass EventCounters;
+
+const char* EventCountersClass::name(const size_t index)
+{
+    static const char* names[counterCount] = {
+        "fragment_crc_error",
+        "fragment_invalid",
+        "retransmit",
+        "rx_timeout",
+        "packet_error",
+        "rx_buffer_full",
+        "unknown_inverter",
+        "parse_error",
+        "tx_timeout",
+    };
+
+    return index < counterCount ? names[index] : "unknown";
+}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Global registry of radio/parser health counters. The conditions were
+// previously only visible as log text; counting them in fixed atomic
+// slots makes fleet health monitorable without log scraping. Increments
+// are a single relaxed fetch_add and safe from any task, so call sites
+// simply add a count() next to their existing log statement.
+class EventCountersClass {
+public:
+    enum class Counter : uint8_t {
+        FragmentCrcError = 0, // received frame failed the CRC check
+        FragmentInvalid, // fragment too short/too large/bad id
+        Retransmit, // single fragment or whole request re-requested
+        RxTimeout, // gave up waiting for an answer
+        PacketError, // fragment verification failed permanently
+        RxBufferFull, // received frame dropped, RX ring full
+        UnknownInverter, // frame for a serial we do not manage
+        ParseError, // payload rejected by a parser
+        TxTimeout, // radio did not finish transmitting in time
+        CounterCount
+    };
+
+    static constexpr size_t counterCount = static_cast<size_t>(Counter::CounterCount);
+
+    void count(const Counter counter)
+    {
+        _counters[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t get(const Counter counter) const
+    {
+        return _counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    uint32_t get(const size_t index) const
+    {
+        return _counters[index].load(std::memory_order_relaxed);
+    }
+
+    // Stable metric label for the counter, e.g. "fragment_crc_error"
+    static const char* name(const size_t index);
+
+private:
+    std::atomic<uint32_t> _counters[counterCount] = {};
+};
+
+extern EventCountersClass EventCounters;
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "FleetStore.h"
+
+size_t FleetStore::acquireRow()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Reuse a released row before growing the columns
+    for (size_t row = 0; row < _rowFlags.size(); row++) {
+        if ((_rowFlags[row] & ROW_USED) == 0) {
+            _rowFlags[row] = ROW_USED | ROW_CONFIG_ENABLED | ROW_POLL_ENABLED;
+            for (auto& column : _columns) {
+                column[row] = 0;
+            }
+            return row;
+        }
+    }
+
+    _rowFlags.push_back(ROW_USED | ROW_CONFIG_ENABLED | ROW_POLL_ENABLED);
+    for (auto& column : _columns) {
+        column.push_back(0);
+    }
+    return _rowFlags.size() - 1;
+}
+
+void FleetStore::releaseRow(const size_t row)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (row >= _rowFlags.size()) {
+        return;
+    }
+    _rowFlags[row] = 0;
+    for (auto& column : _columns) {
+        column[row] = 0;
+    }
+}
+
+void FleetStore::setRowConfigEnabled(const size_t row, const bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (row >= _rowFlags.size()) {
+        return;
+    }
+    if (enabled) {
+        _rowFlags[row] |= ROW_CONFIG_ENABLED;
+    } else {
+        _rowFlags[row] &= ~ROW_CONFIG_ENABLED;
+    }
+}
+
+void FleetStore::setRowPollEnabled(const size_t row, const bool enabled)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (row >= _rowFlags.size()) {
+        return;
+    }
+    if (enabled) {
+        _rowFlags[row] |= ROW_POLL_ENABLED;
+    } else {
+        _rowFlags[row] &= ~ROW_POLL_ENABLED;
+    }
+}
+
+void FleetStore::updateRow(const size_t row, const float (&values)[FLEET_COL_CNT])
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (row >= _rowFlags.size() || (_rowFlags[row] & ROW_USED) == 0) {
+        return;
+    }
+    for (uint8_t col = 0; col < FLEET_COL_CNT; col++) {
+        _columns[col][row] = values[col];
+    }
+}
+
+bool FleetStore::usesConfigGate(const FleetColumn_t col)
+{
+    return col == FLEET_COL_AC_YIELD_TOTAL
+        || col == FLEET_COL_AC_YIELD_DAY
+        || col == FLEET_COL_AC_YIELD_TOTAL_DIGITS
+        || col == FLEET_COL_AC_YIELD_DAY_DIGITS;
+}
+
+bool FleetStore::isRowIncluded(const size_t row, const FleetColumn_t col) const
+{
+    const uint8_t gate = usesConfigGate(col) ? ROW_CONFIG_ENABLED : ROW_POLL_ENABLED;
+    return (_rowFlags[row] & ROW_USED) && (_rowFlags[row] & gate);
+}
+
+float FleetStore::sum(const FleetColumn_t col) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float result = 0;
+    const auto& column = _columns[col];
+    for (size_t row = 0; row < column.size(); row++) {
+        if (isRowIncluded(row, col)) {
+            result += column[row];
+        }
+    }
+    return result;
+}
+
+float FleetStore::minValue(const FleetColumn_t col) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float result = 0;
+    bool first = true;
+    const auto& column = _columns[col];
+    for (size_t row = 0; row < column.size(); row++) {
+        if (isRowIncluded(row, col) && (first || column[row] < result)) {
+            result = column[row];
+            first = false;
+        }
+    }
+    return result;
+}
+
+float FleetStore::maxValue(const FleetColumn_t col) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float result = 0;
+    bool first = true;
+    const auto& column = _columns[col];
+    for (size_t row = 0; row < column.size(); row++) {
+        if (isRowIncluded(row, col) && (first || column[row] > result)) {
+            result = column[row];
+            first = false;
+        }
+    }
+    return result;
+}
+
+float FleetStore::average(const FleetColumn_t col) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float result = 0;
+    size_t count = 0;
+    const auto& column = _columns[col];
+    for (size_t row = 0; row < column.size(); row++) {
+        if (isRowIncluded(row, col)) {
+            result += column[row];
+            count++;
+        }
+    }
+    return count > 0 ? result / count : 0;
+}
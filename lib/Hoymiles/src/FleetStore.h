@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Columns of the fleet-wide statistics store. Each value is aggregated
+// over all channels of one inverter, the digit columns carry the maximum
+// number of decimal digits of the contributing fields.
+enum FleetColumn_t : uint8_t {
+    FLEET_COL_AC_YIELD_TOTAL = 0,
+    FLEET_COL_AC_YIELD_DAY,
+    FLEET_COL_AC_POWER,
+    FLEET_COL_DC_POWER,
+    FLEET_COL_DC_POWER_IRR,
+    FLEET_COL_DC_IRR_INSTALLED,
+    FLEET_COL_AC_YIELD_TOTAL_DIGITS,
+    FLEET_COL_AC_YIELD_DAY_DIGITS,
+    FLEET_COL_AC_POWER_DIGITS,
+    FLEET_COL_DC_POWER_DIGITS,
+    FLEET_COL_CNT
+};
+
+// Columnar fleet-wide statistics store. Every inverter owns one row and
+// its StatisticsParser refreshes it on payload completion, so consumers
+// aggregate over one contiguous float array per column instead of
+// walking inverters and channels through parser calls.
+class FleetStore {
+public:
+    size_t acquireRow();
+    void releaseRow(const size_t row);
+
+    // The config gate applies to the energy counters (an inverter that
+    // is merely not polled at night keeps contributing its yield), the
+    // poll gate to the momentary values.
+    void setRowConfigEnabled(const size_t row, const bool enabled);
+    void setRowPollEnabled(const size_t row, const bool enabled);
+
+    void updateRow(const size_t row, const float (&values)[FLEET_COL_CNT]);
+
+    float sum(const FleetColumn_t col) const;
+    float minValue(const FleetColumn_t col) const;
+    float maxValue(const FleetColumn_t col) const;
+    float average(const FleetColumn_t col) const;
+
+private:
+    enum RowFlags : uint8_t {
+        ROW_USED = 0x01,
+        ROW_CONFIG_ENABLED = 0x02,
+        ROW_POLL_ENABLED = 0x04,
+    };
+
+    static bool usesConfigGate(const FleetColumn_t col);
+    bool isRowIncluded(const size_t row, const FleetColumn_t col) const;
+
+    // One contiguous array per column, rows are reused after release
+    std::array<std::vector<float>, FLEET_COL_CNT> _columns;
+    std::vector<uint8_t> _rowFlags;
+
+    mutable std::mutex _mutex;
+};
@@ -3,6 +3,9 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "Hoymiles.h"
+#include "RadioTrace.h"
+#include "Replay.h"
+#include "Simulator.h"
 #include "Utils.h"
 #include "inverters/HERF_1CH.h"
 #include "inverters/HERF_2CH.h"
@@ -17,16 +20,31 @@
 #include "inverters/HM_2CH.h"
 #include "inverters/HM_4CH.h"
 #include <Arduino.h>
-#include <esp_log.h>
+#include <algorithm>
+#include "HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
+// Core the radio loop tasks are pinned to. On dual-core chips the
+// timing-sensitive RF path (polling, RX fragments, packet parsing) is
+// kept off the Arduino loop core, where the cooperative scheduler, JSON
+// serialization and the web server task run, so RF timing jitter does
+// not correlate with dashboard activity.
+#ifndef HOYMILES_RADIO_CORE
+#if CONFIG_FREERTOS_UNICORE
+#define HOYMILES_RADIO_CORE tskNO_AFFINITY
+#else
+#define HOYMILES_RADIO_CORE 0
+#endif
+#endif
+
 HoymilesClass Hoymiles;
 
 void HoymilesClass::init()
 {
     _pollInterval = 0;
+    RadioTrace.init();
     _radioNrf.reset(new HoymilesRadio_NRF());
     _radioCmt.reset(new HoymilesRadio_CMT());
 }
@@ -34,102 +52,152 @@ void HoymilesClass::init()
 void HoymilesClass::initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ)
 {
     _radioNrf->init(initialisedSpiBus, pinCE, pinIRQ);
+    if (_radioNrf->isInitialized()) {
+        _radioNrf->startLoopTask("HoymilesNRF", HOYMILES_RADIO_CORE);
+        _radioNrf->startRxTask("HoymilesNRFRx", HOYMILES_RADIO_CORE);
+    }
 }
 
 void HoymilesClass::initCMT(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin_cs, const int8_t pin_fcs, const int8_t pin_gpio2, const int8_t pin_gpio3)
 {
     _radioCmt->init(pin_sdio, pin_clk, pin_cs, pin_fcs, pin_gpio2, pin_gpio3);
+    if (_radioCmt->isInitialized()) {
+        _radioCmt->startLoopTask("HoymilesCMT", HOYMILES_RADIO_CORE);
+    }
 }
 
 void HoymilesClass::loop()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    _radioNrf->loop();
-    _radioCmt->loop();
-
-    if (getNumInverters() == 0 || millis() - _lastPoll <= (_pollInterval * 1000)) {
-        return;
+    // One consistent snapshot for the whole pass; list mutations from
+    // other tasks swap in a new list without disturbing this one
+    const auto inverters = getInverterList();
+
+#ifdef HOYMILES_SIMULATOR
+    // Fabricated statistics drive the real downstream pipeline; the
+    // radios stay uninitialized in simulator builds, so the poll
+    // dispatcher below marks every inverter as handled and stays inert
+    static uint32_t lastSimulatorUpdate = 0;
+    if (millis() - lastSimulatorUpdate > HOYMILES_SIMULATOR_INTERVAL_MS) {
+        lastSimulatorUpdate = millis();
+        for (auto& inv : *inverters) {
+            if (inv->getEnablePolling()) {
+                HoymilesSimulator::fillStatistics(*inv);
+            }
+        }
     }
-
-    static uint8_t inverterPos = 0;
-
-    std::shared_ptr<InverterAbstract> iv = getInverterByPos(inverterPos);
-    if ((iv == nullptr) || ((iv != nullptr) && (!iv->getRadio()->isInitialized()))) {
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+#endif
+
+#ifdef HOYMILES_REPLAY
+    // Captured production fragments drive the real verify/parse path
+    // with their original timing; the radios stay uninitialized
+    HoymilesReplay::loop();
+#endif
+
+    // Presence sweep: one lightweight statistics exchange per inverter,
+    // queued in rapid sequence. The trains drain back to back, so the
+    // whole fleet's reachability is answered within the first exchanges
+    // after boot - the regular dispatcher below would make the last of
+    // 16 inverters wait behind 15 full poll programs. Deliberately not
+    // gated on time sync: the probe only needs any response, and the
+    // full program follows once the clock is there.
+    if (!_pollingSuspended && _presenceSweepPending.exchange(false)) {
+        for (auto& iv : *inverters) {
+            if ((iv == nullptr) || (!iv->getRadio()->isInitialized())) {
+                continue;
+            }
+            if (iv->sendStatsRequest()) {
+                ESP_LOGI(TAG, "Presence probe: %s", iv->serialString().c_str());
+            }
         }
     }
 
-    if (iv != nullptr && iv->getRadio()->isInitialized()) {
-
-        if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
-            iv->Statistics()->zeroRuntimeData();
+    if (!_pollingSuspended && inverters->size() > 0 && millis() - _lastPoll > (_pollInterval * 1000)) {
+        // Interleaved fleet polling: all inverters of one pass are dispatched
+        // as soon as their radio has drained the previous exchange. This way
+        // the poll interval paces full fleet passes instead of single
+        // inverters and one band does not idle while the other one is busy.
+        if (_polledInverters.size() != inverters->size()) {
+            _polledInverters.assign(inverters->size(), false);
         }
 
-        if (iv->getEnablePolling() || iv->getEnableCommands()) {
-            ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
-
-            if (!iv->isReachable()) {
-                iv->sendChangeChannelRequest();
-            }
-
-            if (Utils::getTimeAvailable()) {
-                // Fetch statistics
-                iv->sendStatsRequest();
-
-                // Fetch event log
-                const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
-                iv->sendAlarmLogRequest(force);
-
-                // Fetch limit
-                if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
-                        && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
-                    ESP_LOGI(TAG, "Request SystemConfigPara");
-                    iv->sendSystemConfigParaRequest();
+        bool passComplete = true;
+        bool dispatched = true;
+        while (dispatched) {
+            dispatched = false;
+
+            // Collect every unpolled inverter whose radio is ready and
+            // within its airtime budget
+            std::vector<uint8_t> ready;
+            for (uint8_t pos = 0; pos < inverters->size(); pos++) {
+                if (_polledInverters[pos]) {
+                    continue;
                 }
 
-                // Fetch grid profile
-                if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
-                    iv->sendGridOnProFileParaRequest();
+                const std::shared_ptr<InverterAbstract>& iv = (*inverters)[pos];
+                if ((iv == nullptr) || (!iv->getRadio()->isInitialized())) {
+                    _polledInverters[pos] = true;
+                    continue;
                 }
 
-                // Fetch dev info (but first fetch stats)
-                if (iv->Statistics()->getLastUpdate() > 0) {
-                    const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
-                        && iv->DevInfo()->getLastUpdateAll() > 0
-                        && iv->DevInfo()->getLastUpdateSimple() > 0;
+                // Adaptive polling: an inverter whose output barely moves
+                // stretches its own interval, freeing airtime for the
+                // ones that are ramping. At the 1x scale this is a no-op
+                // so the configured interval stays the fleet pace.
+                const uint32_t scaledInterval = iv->getScaledPollInterval(_pollInterval * 1000);
+                if (iv->Statistics()->getLastUpdate() > 0
+                    && scaledInterval > _pollInterval * 1000
+                    && millis() - iv->Statistics()->getLastUpdate() < scaledInterval) {
+                    _polledInverters[pos] = true;
+                    continue;
+                }
 
-                    if (invalidDevInfo) {
-                        ESP_LOGW(TAG, "DevInfo: No Valid Data");
-                    }
+                if (!iv->getRadio()->isQueueEmpty()) {
+                    // This band is still busy with a previous exchange,
+                    // try again on the next loop iteration.
+                    passComplete = false;
+                    continue;
+                }
 
-                    if ((iv->DevInfo()->getLastUpdateAll() == 0)
-                        || (iv->DevInfo()->getLastUpdateSimple() == 0)
-                        || invalidDevInfo) {
-                        ESP_LOGI(TAG, "Request device info");
-                        iv->sendDevInfoRequest();
-                    }
+                if (iv->getRadio()->getAirtimeOccupancyPercent() >= _airtimeBudgetPercent) {
+                    // Band is saturated, defer until occupancy drops. The
+                    // staleness ordering keeps worst-case staleness bounded.
+                    passComplete = false;
+                    continue;
                 }
-            }
 
-            // Set limit if required
-            if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend ActivePowerControl");
-                iv->resendActivePowerControlRequest();
+                ready.push_back(pos);
             }
 
-            // Set power status if required
-            if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend PowerCommand");
-                iv->resendPowerControlRequest();
+            if (!ready.empty()) {
+                // Stalest statistics first; decides both which band goes
+                // first and the exchange order inside its train
+                std::sort(ready.begin(), ready.end(), [&inverters](const uint8_t a, const uint8_t b) {
+                    return (*inverters)[a]->Statistics()->getLastUpdate()
+                        < (*inverters)[b]->Statistics()->getLastUpdate();
+                });
+
+                // Queue the whole train of the stalest inverter's band in
+                // one go: the radio works the queued exchanges back to
+                // back inside a single wake window, amortizing PLL lock
+                // and channel setup across the fleet instead of paying
+                // them per inverter. The airtime budget gates train
+                // assembly; occupancy of a running train shows up when
+                // the next pass is assembled.
+                HoymilesRadio* radio = (*inverters)[ready.front()]->getRadio();
+                for (const uint8_t pos : ready) {
+                    if ((*inverters)[pos]->getRadio() != radio) {
+                        continue;
+                    }
+                    pollInverter((*inverters)[pos]);
+                    _polledInverters[pos] = true;
+                    dispatched = true;
+                }
             }
-
-            ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
-            _lastPoll = millis();
         }
 
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+        if (passComplete) {
+            _polledInverters.assign(inverters->size(), false);
+            _lastPoll = millis();
         }
     }
 
@@ -141,13 +209,87 @@ void HoymilesClass::loop()
     } else {
         if (currentWeekDay != lastWeekDay) {
 
-            for (auto& inv : _inverters) {
+            for (auto& inv : *inverters) {
                 inv->performDailyTask();
             }
 
             lastWeekDay = currentWeekDay;
         }
     }
+
+    // Keep the contiguous hot-state mirror roughly one second fresh
+    if (millis() - _lastSnapshotRefresh > 1000) {
+        _lastSnapshotRefresh = millis();
+        refreshInverterSnapshots();
+    }
+}
+
+void HoymilesClass::pollInverter(std::shared_ptr<InverterAbstract> iv)
+{
+    if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
+        iv->Statistics()->zeroRuntimeData();
+    }
+
+    if (iv->getEnablePolling() || iv->getEnableCommands()) {
+        ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
+
+        if (!iv->isReachable()) {
+            iv->sendChangeChannelRequest();
+        }
+
+        if (Utils::getTimeAvailable()) {
+            // Fetch statistics
+            iv->sendStatsRequest();
+
+            // Fetch event log
+            const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
+            iv->sendAlarmLogRequest(force);
+
+            // Fetch limit
+            if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
+                    && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
+                ESP_LOGI(TAG, "Request SystemConfigPara");
+                iv->sendSystemConfigParaRequest();
+            }
+
+            // Fetch grid profile
+            if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
+                iv->sendGridOnProFileParaRequest();
+            }
+
+            // Fetch dev info (but first fetch stats)
+            if (iv->Statistics()->getLastUpdate() > 0) {
+                const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
+                    && iv->DevInfo()->getLastUpdateAll() > 0
+                    && iv->DevInfo()->getLastUpdateSimple() > 0;
+
+                if (invalidDevInfo) {
+                    ESP_LOGW(TAG, "DevInfo: No Valid Data");
+                }
+
+                if ((iv->DevInfo()->getLastUpdateAll() == 0)
+                    || (iv->DevInfo()->getLastUpdateSimple() == 0)
+                    || invalidDevInfo) {
+                    ESP_LOGI(TAG, "Request device info");
+                    iv->sendDevInfoRequest();
+                }
+            }
+        }
+
+        // Set limit if required
+        if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
+            ESP_LOGI(TAG, "Resend ActivePowerControl");
+            iv->resendActivePowerControlRequest();
+        }
+
+        // Set power status if required
+        if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
+            ESP_LOGI(TAG, "Resend PowerCommand");
+            iv->resendPowerControlRequest();
+        }
+
+        ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
+    }
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, const uint64_t serial)
@@ -182,8 +324,16 @@ std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, c
     if (i) {
         i->setName(name);
         i->init();
-        _inverters.push_back(std::move(i));
-        return _inverters.back();
+        i->Statistics()->setFleetStore(&_fleetStore, _fleetStore.acquireRow());
+
+        // Copy-on-write publish: readers keep iterating the previous
+        // list until the swap, in-flight exchanges are not disturbed
+        std::lock_guard<std::mutex> lock(_listWriteMutex);
+        auto updated = std::make_shared<InverterList>(*getInverterList());
+        updated->push_back(i);
+        std::atomic_store(&_inverters, std::shared_ptr<const InverterList>(std::move(updated)));
+        refreshInverterSnapshots();
+        return i;
     }
 
     return nullptr;
@@ -191,16 +341,18 @@ std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, c
 
 std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByPos(const uint8_t pos)
 {
-    if (pos >= _inverters.size()) {
+    const auto inverters = getInverterList();
+    if (pos >= inverters->size()) {
         return nullptr;
     } else {
-        return _inverters[pos];
+        return (*inverters)[pos];
     }
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::getInverterBySerial(const uint64_t serial)
 {
-    for (auto& inv : _inverters) {
+    const auto inverters = getInverterList();
+    for (auto& inv : *inverters) {
         if (inv->serial() == serial) {
             return inv;
         }
@@ -214,7 +366,8 @@ std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByFragment(const fra
         return nullptr;
     }
 
-    for (auto& inv : _inverters) {
+    const auto inverters = getInverterList();
+    for (auto& inv : *inverters) {
         serial_u p;
         p.u64 = inv->serial();
 
@@ -231,19 +384,38 @@ std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByFragment(const fra
 
 void HoymilesClass::removeInverterBySerial(const uint64_t serial)
 {
-    for (uint8_t i = 0; i < _inverters.size(); i++) {
-        if (_inverters[i]->serial() == serial) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _inverters[i]->getRadio()->removeCommands(_inverters[i].get());
-            _inverters.erase(_inverters.begin() + i);
-            return;
+    std::lock_guard<std::mutex> lock(_listWriteMutex);
+
+    auto current = getInverterList();
+    auto updated = std::make_shared<InverterList>();
+    updated->reserve(current->size());
+
+    std::shared_ptr<InverterAbstract> removed = nullptr;
+    for (auto& inv : *current) {
+        if (inv->serial() == serial) {
+            removed = inv;
+        } else {
+            updated->push_back(inv);
         }
     }
+
+    if (removed == nullptr) {
+        return;
+    }
+
+    std::atomic_store(&_inverters, std::shared_ptr<const InverterList>(std::move(updated)));
+
+    // Unpublished now; readers still holding a reference finish their
+    // exchange on the stale object before it is destroyed
+    removed->cancelPendingSequences();
+    removed->getRadio()->removeCommands(removed.get());
+    removed->Statistics()->releaseFleetStore();
+    refreshInverterSnapshots();
 }
 
 size_t HoymilesClass::getNumInverters() const
 {
-    return _inverters.size();
+    return getInverterList()->size();
 }
 
 HoymilesRadio_NRF* HoymilesClass::getRadioNrf()
@@ -256,11 +428,58 @@ HoymilesRadio_CMT* HoymilesClass::getRadioCmt()
     return _radioCmt.get();
 }
 
+FleetStore& HoymilesClass::getFleetStore()
+{
+    return _fleetStore;
+}
+
+void HoymilesClass::refreshInverterSnapshots()
+{
+    const auto inverters = getInverterList();
+
+    std::lock_guard<std::mutex> lock(_snapshotMutex);
+    _inverterSnapshots.resize(inverters->size());
+    for (size_t i = 0; i < inverters->size(); i++) {
+        auto& inv = (*inverters)[i];
+        auto& s = _inverterSnapshots[i];
+        s.serial = inv->serial();
+        s.reachable = inv->isReachable();
+        s.producing = inv->isProducing();
+        s.pollEnabled = inv->getEnablePolling();
+        s.commandsEnabled = inv->getEnableCommands();
+        s.multiPhase = inv->getTraits().multiPhase;
+        s.dcChannelCount = inv->getTraits().dcChannelCount;
+    }
+}
+
+size_t HoymilesClass::copyInverterSnapshots(InverterSnapshot_t* snapshots, const size_t maxCount) const
+{
+    std::lock_guard<std::mutex> lock(_snapshotMutex);
+    const size_t count = std::min(maxCount, _inverterSnapshots.size());
+    std::copy_n(_inverterSnapshots.begin(), count, snapshots);
+    return count;
+}
+
 bool HoymilesClass::isAllRadioIdle() const
 {
     return _radioNrf.get()->isIdle() && _radioCmt.get()->isIdle();
 }
 
+void HoymilesClass::suspendPolling()
+{
+    _pollingSuspended = true;
+}
+
+void HoymilesClass::resumePolling()
+{
+    _pollingSuspended = false;
+}
+
+void HoymilesClass::startPresenceSweep()
+{
+    _presenceSweepPending = true;
+}
+
 uint32_t HoymilesClass::PollInterval() const
 {
     return _pollInterval;
@@ -270,3 +489,13 @@ void HoymilesClass::setPollInterval(const uint32_t interval)
 {
     _pollInterval = interval;
 }
+
+uint8_t HoymilesClass::getAirtimeBudgetPercent() const
+{
+    return _airtimeBudgetPercent;
+}
+
+void HoymilesClass::setAirtimeBudgetPercent(const uint8_t percent)
+{
+    _airtimeBudgetPercent = percent;
+}
@@ -1,17 +1,21 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "FleetStore.h"
 #include "HoymilesRadio_CMT.h"
 #include "HoymilesRadio_NRF.h"
 #include "inverters/InverterAbstract.h"
 #include "types.h"
 #include <Print.h>
 #include <SPI.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #define HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL (2 * 60 * 1000) // 2 minutes
 #define HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION (4 * 60 * 1000) // at least 4 minutes between sending limit command and read request. Otherwise eventlog entry
+#define HOY_AIRTIME_BUDGET_PERCENT 80 // default radio duty-cycle budget for statistics polling
 
 class HoymilesClass {
 public:
@@ -30,20 +34,81 @@ public:
     HoymilesRadio_NRF* getRadioNrf();
     HoymilesRadio_CMT* getRadioCmt();
 
+    FleetStore& getFleetStore();
+
+    // Per-inverter hot state mirrored into one contiguous array of
+    // structs, refreshed once a second from loop() and on add/remove.
+    // Fleet walks that only need flags and serials (Datastore and
+    // friends) read this copy instead of chasing shared_ptr and parser
+    // chains per inverter - and without contending on the radio mutex.
+    struct InverterSnapshot_t {
+        uint64_t serial;
+        bool reachable;
+        bool producing;
+        bool pollEnabled;
+        bool commandsEnabled;
+        bool multiPhase;
+        uint8_t dcChannelCount;
+    };
+
+    size_t copyInverterSnapshots(InverterSnapshot_t* snapshots, const size_t maxCount) const;
+
     uint32_t PollInterval() const;
     void setPollInterval(const uint32_t interval);
 
+    uint8_t getAirtimeBudgetPercent() const;
+    void setAirtimeBudgetPercent(const uint8_t percent);
+
     bool isAllRadioIdle() const;
 
+    // Gate for long flash operations (OTA, config commits): while
+    // suspended no new poll pass is dispatched, so flash-cache-disabled
+    // windows stop colliding with in-flight RF exchanges. In-flight
+    // exchanges still drain; callers that need full radio silence wait
+    // for isAllRadioIdle() afterwards.
+    void suspendPolling();
+    void resumePolling();
+
+    // Boot presence sweep: the next loop pass queues one statistics
+    // exchange per configured inverter back to back on both radios, so
+    // fleet reachability settles within the first exchanges instead of
+    // trailing the first full poll program. Call after the inverters
+    // were added.
+    void startPresenceSweep();
+
+    using InverterList = std::vector<std::shared_ptr<InverterAbstract>>;
+
+    // RCU-style published inverter list: readers (radio loop tasks, the
+    // poll dispatcher, consumers like the fleet walk) grab an immutable
+    // snapshot with atomic_load and never block. Writers copy the list,
+    // modify the copy and atomically swap it in under _listWriteMutex,
+    // so adding or removing one inverter does not disturb in-flight
+    // exchanges of the others. In-flight shared_ptr references keep a
+    // removed inverter alive until the last reader drops it.
+    std::shared_ptr<const InverterList> getInverterList() const
+    {
+        return std::atomic_load(&_inverters);
+    }
+
 private:
-    std::vector<std::shared_ptr<InverterAbstract>> _inverters;
+    void pollInverter(std::shared_ptr<InverterAbstract> iv);
+    void refreshInverterSnapshots();
+
+    std::shared_ptr<const InverterList> _inverters = std::make_shared<InverterList>();
+    std::mutex _listWriteMutex;
+    std::vector<InverterSnapshot_t> _inverterSnapshots;
+    mutable std::mutex _snapshotMutex;
+    uint32_t _lastSnapshotRefresh = 0;
+    std::vector<bool> _polledInverters;
+    FleetStore _fleetStore;
     std::unique_ptr<HoymilesRadio_NRF> _radioNrf;
     std::unique_ptr<HoymilesRadio_CMT> _radioCmt;
 
-    std::mutex _mutex;
-
     uint32_t _pollInterval = 0;
     uint32_t _lastPoll = 0;
+    std::atomic<bool> _pollingSuspended = false;
+    std::atomic<bool> _presenceSweepPending = false;
+    uint8_t _airtimeBudgetPercent = HOY_AIRTIME_BUDGET_PERCENT;
 };
 
 extern HoymilesClass Hoymiles;
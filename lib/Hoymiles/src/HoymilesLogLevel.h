@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Compile-time log site filtering for the radio hot path. Define
+// HOYMILES_LOG_LEVEL (0=none .. 5=verbose, matching esp_log_level_t) in
+// the platformio env to strip all log sites below that severity from
+// this library at compile time - the severity check constant-folds, so
+// the format strings and call overhead disappear from the binary
+// entirely. Without the define the global LOG_LOCAL_LEVEL applies and
+// every site stays runtime-switchable via the per-TAG log levels.
+//
+// LOG_LOCAL_LEVEL is expanded at every ESP_LOGx call site, not when
+// esp_log.h is included, so redefining it here takes effect for the
+// whole translation unit regardless of include order.
+#ifdef HOYMILES_LOG_LEVEL
+#undef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL HOYMILES_LOG_LEVEL
+#endif
+
+#include <esp_log.h>
@@ -3,18 +3,131 @@
  * Copyright (C) 2023-2025 Thomas Basler and others
  */
 #include "HoymilesRadio.h"
+#include "RadioTrace.h"
+#include "EventCounters.h"
 #include "crc.h"
 #include "Hoymiles.h"
-#include <esp_log.h>
+#include "HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
+// Length of the rolling window used for radio airtime accounting
+#define HOY_AIRTIME_WINDOW_MS 60000
+
 serial_u HoymilesRadio::DtuSerial() const
 {
     return _dtuSerial;
 }
 
+void HoymilesRadio::startLoopTask(const char* taskName, const BaseType_t coreId)
+{
+    if (_loopTaskHandle != nullptr) {
+        return;
+    }
+
+    xTaskCreatePinnedToCore(loopTask, taskName, 4096, this, 2, &_loopTaskHandle, coreId);
+}
+
+void HoymilesRadio::startRxTask(const char* taskName, const BaseType_t coreId)
+{
+    if (_rxTaskHandle != nullptr) {
+        return;
+    }
+
+    // One priority level above the loop task: the FIFO drain preempts
+    // a running parse/hop/TX pass instead of queueing behind it
+    xTaskCreatePinnedToCore(rxTask, taskName, 4096, this, 3, &_rxTaskHandle, coreId);
+}
+
+void HoymilesRadio::loopTask(void* arg)
+{
+    HoymilesRadio* radio = static_cast<HoymilesRadio*>(arg);
+    while (true) {
+        if (radio->serviceSleep()) {
+            continue;
+        }
+        radio->loop();
+        // Paced like the old vTaskDelay(1), but a radio IRQ or a newly
+        // queued command cuts the wait short so the pass that drains
+        // the RX FIFO starts immediately instead of next tick
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+}
+
+void HoymilesRadio::rxTask(void* arg)
+{
+    HoymilesRadio* radio = static_cast<HoymilesRadio*>(arg);
+    while (true) {
+        // Parked until the RX IRQ signals a frame; there is no periodic
+        // work on this task
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        radio->drainRx();
+    }
+}
+
+bool HoymilesRadio::serviceSleep()
+{
+    if (_sleepAllowed.load(std::memory_order_relaxed) && !_busyFlag && isQueueEmpty()) {
+        if (!_sleeping && millis() - _idleSince < HOYMILES_RADIO_SLEEP_LINGER_MS) {
+            // Linger briefly before powering down: a follow-up command
+            // of the same poll train reuses the warm radio instead of
+            // paying another wake cycle (PLL lock, channel setup).
+            return false;
+        }
+        if (!_sleeping) {
+            ESP_LOGI(TAG, "%s: Powering radio down for sleep", pcTaskGetName(nullptr));
+            suspendRadio();
+            _sleeping = true;
+        }
+        // Parked until a command wakes us; the timeout only re-checks
+        // the sleep condition, the hardware stays down
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        return true;
+    }
+
+    if (_sleeping) {
+        ESP_LOGI(TAG, "%s: Waking radio from sleep", pcTaskGetName(nullptr));
+        resumeRadio();
+        _sleeping = false;
+    }
+    _idleSince = millis();
+    return false;
+}
+
+void HoymilesRadio::setSleepAllowed(const bool allowed)
+{
+    _sleepAllowed.store(allowed, std::memory_order_relaxed);
+    if (!allowed) {
+        wakeLoopTask();
+    }
+}
+
+void HoymilesRadio::wakeLoopTask()
+{
+    if (_loopTaskHandle != nullptr) {
+        xTaskNotifyGive(_loopTaskHandle);
+    }
+}
+
+void ARDUINO_ISR_ATTR HoymilesRadio::wakeLoopTaskFromISR()
+{
+    if (_loopTaskHandle != nullptr) {
+        BaseType_t higherPrioWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(_loopTaskHandle, &higherPrioWoken);
+        portYIELD_FROM_ISR(higherPrioWoken);
+    }
+}
+
+void ARDUINO_ISR_ATTR HoymilesRadio::wakeRxTaskFromISR()
+{
+    if (_rxTaskHandle != nullptr) {
+        BaseType_t higherPrioWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(_rxTaskHandle, &higherPrioWoken);
+        portYIELD_FROM_ISR(higherPrioWoken);
+    }
+}
+
 void HoymilesRadio::setDtuSerial(const uint64_t serial)
 {
     _dtuSerial.u64 = serial;
@@ -55,8 +168,38 @@ void HoymilesRadio::sendLastPacketAgain()
     sendEsbPacket(*cmd);
 }
 
+uint8_t HoymilesRadio::getAirtimeOccupancyPercent() const
+{
+    return _airtimeOccupancy;
+}
+
+void HoymilesRadio::updateAirtimeAccounting()
+{
+    const uint32_t now = millis();
+
+    if (_busyFlag && !_airtimeWasBusy) {
+        _airtimeBusySince = now;
+    } else if (!_busyFlag && _airtimeWasBusy) {
+        _airtimeAccumulator += now - _airtimeBusySince;
+    }
+    _airtimeWasBusy = _busyFlag;
+
+    if (now - _airtimeWindowStart >= HOY_AIRTIME_WINDOW_MS) {
+        uint32_t busyTime = _airtimeAccumulator;
+        if (_busyFlag) {
+            busyTime += now - _airtimeBusySince;
+            _airtimeBusySince = now;
+        }
+        _airtimeOccupancy = (100 * busyTime) / (now - _airtimeWindowStart);
+        _airtimeAccumulator = 0;
+        _airtimeWindowStart = now;
+    }
+}
+
 void HoymilesRadio::handleReceivedPackage()
 {
+    updateAirtimeAccounting();
+
     if (_busyFlag && _rxTimeout.occured()) {
         ESP_LOGI(TAG, "RX Period End");
         std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterBySerial(_commandQueue.front().get()->getTargetAddress());
@@ -66,45 +209,69 @@ void HoymilesRadio::handleReceivedPackage()
             uint8_t verifyResult = inv->verifyAllFragments(*cmd);
             if (verifyResult == FRAGMENT_ALL_MISSING_RESEND) {
                 ESP_LOGW(TAG, "Nothing received, resend whole request");
+                EventCounters.count(EventCountersClass::Counter::Retransmit);
+                RadioTrace.record(RadioTraceClass::Event::Retransmit, cmd->getTargetAddress(), 0, 0, 0, nullptr, 0);
                 sendLastPacketAgain();
 
             } else if (verifyResult == FRAGMENT_ALL_MISSING_TIMEOUT) {
                 ESP_LOGW(TAG, "Nothing received, resend count exeeded");
+                EventCounters.count(EventCountersClass::Counter::RxTimeout);
+                RadioTrace.record(RadioTraceClass::Event::Timeout, cmd->getTargetAddress(), 0, 0, 0, nullptr, 0);
                 // Statistics: Count RX Fail No Answer
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailNoAnswer++;
                 }
+                inv->updateExchangeResult(false);
 
+                cmd->markCompleted(CMD_NOK);
                 _commandQueue.pop();
                 _busyFlag = false;
 
             } else if (verifyResult == FRAGMENT_RETRANSMIT_TIMEOUT) {
                 ESP_LOGW(TAG, "Retransmit timeout");
+                EventCounters.count(EventCountersClass::Counter::RxTimeout);
+                RadioTrace.record(RadioTraceClass::Event::Timeout, cmd->getTargetAddress(), 0, 0, 0, nullptr, 0);
                 // Statistics: Count RX Fail Partial Answer
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailPartialAnswer++;
                 }
+                inv->updateExchangeResult(false);
 
+                cmd->markCompleted(CMD_NOK);
                 _commandQueue.pop();
                 _busyFlag = false;
 
             } else if (verifyResult == FRAGMENT_HANDLE_ERROR) {
                 ESP_LOGW(TAG, "Packet handling error");
+                EventCounters.count(EventCountersClass::Counter::PacketError);
                 // Statistics: Count RX Fail Corrupt Data
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailCorruptData++;
                 }
+                inv->updateExchangeResult(false);
 
+                cmd->markCompleted(CMD_NOK);
                 _commandQueue.pop();
                 _busyFlag = false;
 
             } else if (verifyResult > 0) {
-                // Perform Retransmit
-                ESP_LOGI(TAG, "Request retransmit: %" PRIu8 "", verifyResult);
-                // Statistics: Count TX Re-Request Fragment
-                inv->RadioStats.TxReRequestFragment++;
-
-                sendRetransmitPacket(verifyResult);
+                // Perform Retransmit: re-request every missing index in
+                // one burst and collect the answers in a single RX
+                // window, instead of one full round trip per fragment
+                uint8_t missing[MAX_RF_FRAGMENT_COUNT];
+                uint8_t missingCount = inv->getMissingFragments(missing, sizeof(missing));
+                if (missingCount == 0) {
+                    missing[0] = verifyResult;
+                    missingCount = 1;
+                }
+                ESP_LOGI(TAG, "Request retransmit of %" PRIu8 " fragment(s), first: %" PRIu8 "", missingCount, missing[0]);
+                EventCounters.count(EventCountersClass::Counter::Retransmit);
+                for (uint8_t i = 0; i < missingCount; i++) {
+                    // Statistics: Count TX Re-Request Fragment
+                    inv->RadioStats.TxReRequestFragment++;
+                    RadioTrace.record(RadioTraceClass::Event::Retransmit, cmd->getTargetAddress(), 0, 0, missing[i], nullptr, 0);
+                    sendRetransmitPacket(missing[i]);
+                }
 
             } else {
                 // Successful received all packages
@@ -113,14 +280,18 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxSuccess++;
                 }
+                inv->updateExchangeResult(true);
 
+                cmd->markCompleted(CMD_OK);
                 _commandQueue.pop();
                 _busyFlag = false;
             }
         } else {
             // If inverter was not found, assume the command is invalid
             ESP_LOGW(TAG, "RX: Invalid inverter found");
+            EventCounters.count(EventCountersClass::Counter::UnknownInverter);
             // Statistics: Count RX Fail Unknown Data
+            _commandQueue.front().get()->markCompleted(CMD_NOK);
             _commandQueue.pop();
             _busyFlag = false;
         }
@@ -134,8 +305,12 @@ void HoymilesRadio::handleReceivedPackage()
                 inv->clearRxFragmentBuffer();
                 // Statistics: TX Requests
                 inv->RadioStats.TxRequestData++;
+                inv->noteExchangeStart();
 
                 sendEsbPacket(*cmd);
+                // Link-quality adapted RX window: strong links get a
+                // shorter timeout than the command default.
+                _rxTimeout.set(inv->getScaledTimeout(*cmd));
             } else {
                 ESP_LOGE(TAG, "TX: Invalid inverter found");
                 _commandQueue.pop();
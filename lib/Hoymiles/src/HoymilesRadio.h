@@ -3,12 +3,14 @@
 
 #include "Arduino.h"
 #include "commands/CommandAbstract.h"
+#include "commands/CommandPool.h"
 #include "queue/CommandQueue.h"
 #include "types.h"
 #include <TimeoutHelper.h>
+#include <atomic>
 
 #ifdef HOY_DEBUG_QUEUE
-#include <esp_log.h>
+#include "HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -18,21 +20,59 @@ static const char* TAG = "hoymiles";
 #define DEBUG_PRINT(fmt, args...) /* Don't do anything in release builds */
 #endif
 
+// How long the loop task keeps an idle radio powered before suspending
+// it. Long enough to bridge the gaps inside a queued poll train, short
+// against the multi-second poll interval so sleep still kicks in.
+#ifndef HOYMILES_RADIO_SLEEP_LINGER_MS
+#define HOYMILES_RADIO_SLEEP_LINGER_MS 100
+#endif
+
 class HoymilesRadio {
 public:
     serial_u DtuSerial() const;
     virtual void setDtuSerial(const uint64_t serial);
 
+    virtual void loop() = 0;
+
+    // Runs the radio loop in a dedicated FreeRTOS task so both bands can
+    // poll concurrently. SPI bus access is arbitrated by the SpiManager.
+    // With a core id given, the task is pinned to that core; RX fragment
+    // handling and packet parsing run in this task, so pinning isolates
+    // the complete RF timing path from work on the other core.
+    void startLoopTask(const char* taskName, const BaseType_t coreId = tskNO_AFFINITY);
+
+    // Runs drainRx() in a dedicated task one priority level above the
+    // loop task. The RX IRQ wakes it directly, so draining the radio
+    // FIFO and stamping fragment arrival times does not wait behind
+    // parsing, hopping or TX work of a loop pass - arrival timestamps
+    // stay within sub-millisecond of the interrupt.
+    void startRxTask(const char* taskName, const BaseType_t coreId = tskNO_AFFINITY);
+
     bool isIdle() const;
     bool isQueueEmpty() const;
     uint32_t getQueueSize() const;
     bool isInitialized() const;
 
+    // Deep duty cycling: while sleep is allowed and the band is idle
+    // with an empty queue, the transceiver is powered down and the loop
+    // task parks on a task notification instead of spinning over SPI.
+    // Enqueueing any command wakes the band instantly. May be called
+    // from any task.
+    void setSleepAllowed(const bool allowed);
+    bool isSleeping() const { return _sleeping; }
+
+    // TX/RX occupancy of this radio over the last accounting window
+    uint8_t getAirtimeOccupancyPercent() const;
+
     void removeCommands(InverterAbstract* inv);
     uint8_t countSimilarCommands(std::shared_ptr<CommandAbstract> cmd);
 
     void enqueCommand(std::shared_ptr<CommandAbstract> cmd)
     {
+        // Stamp the submission time up front so a token requested after
+        // this call measures true end-to-end latency
+        cmd->markEnqueued();
+
         DEBUG_PRINT("Queue size before: %ld", _commandQueue.size());
         DEBUG_PRINT("Handling command %s with type %d", cmd.get()->getCommandName().c_str(), static_cast<uint8_t>(cmd.get()->getQueueInsertType()));
         switch (cmd.get()->getQueueInsertType()) {
@@ -64,20 +104,49 @@ public:
 
         // Push the command into the queue if we reach this position of the code
         DEBUG_PRINT("    ... new entry will be appended");
-        _commandQueue.push(cmd);
+        _commandQueue.pushPrioritized(cmd);
 
         DEBUG_PRINT("Queue size after: %ld", _commandQueue.size());
+
+        // A sleeping band resumes immediately for the new command
+        wakeLoopTask();
     }
 
+    // Commands come out of the fixed-slot pool: object and shared_ptr
+    // control block share one slot, so steady-state polling does not
+    // touch the heap
     template <typename T>
     std::shared_ptr<T> prepareCommand(InverterAbstract* inv)
     {
-        return std::make_shared<T>(inv);
+        return std::allocate_shared<T>(CommandPoolAllocator<T>(), inv);
     }
 
 protected:
     static serial_u convertSerialToRadioId(const serial_u serial);
 
+    static void loopTask(void* arg);
+    static void rxTask(void* arg);
+
+    // Moves received frames out of the radio FIFO into the fragment
+    // ring and stamps their arrival time. Runs on the RX task when one
+    // was started, see startRxTask(); drivers without one keep draining
+    // from their loop().
+    virtual void drainRx() { }
+
+    // Sleep bookkeeping for the loop task; returns true while the band
+    // is parked and loop() must not touch the hardware
+    bool serviceSleep();
+    void wakeLoopTask();
+    // Same wake-up from interrupt context, e.g. the radio's RX IRQ
+    void ARDUINO_ISR_ATTR wakeLoopTaskFromISR();
+    void ARDUINO_ISR_ATTR wakeRxTaskFromISR();
+
+    // Power the transceiver down/up around a sleep period
+    virtual void suspendRadio() { }
+    virtual void resumeRadio() { }
+
+    void updateAirtimeAccounting();
+
     bool checkFragmentCrc(const fragment_t& fragment) const;
     virtual void sendEsbPacket(CommandAbstract& cmd) = 0;
     void sendRetransmitPacket(const uint8_t fragment_id);
@@ -90,4 +159,18 @@ protected:
     bool _busyFlag = false;
 
     TimeoutHelper _rxTimeout;
+
+    TaskHandle_t _loopTaskHandle = nullptr;
+    TaskHandle_t _rxTaskHandle = nullptr;
+
+    std::atomic<bool> _sleepAllowed = false;
+    bool _sleeping = false; // only touched by the loop task
+    uint32_t _idleSince = 0; // only touched by the loop task
+
+    // Airtime accounting over a rolling window
+    bool _airtimeWasBusy = false;
+    uint32_t _airtimeBusySince = 0;
+    uint32_t _airtimeWindowStart = 0;
+    uint32_t _airtimeAccumulator = 0;
+    uint8_t _airtimeOccupancy = 0;
 };
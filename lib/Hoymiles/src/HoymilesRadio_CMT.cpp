@@ -4,15 +4,31 @@
  */
 #include "HoymilesRadio_CMT.h"
 #include "Hoymiles.h"
+#include "ProfilingPins.h"
+#include "RadioTrace.h"
+#include "EventCounters.h"
 #include "Utils.h"
 #include "crc.h"
 #include <FunctionalInterrupt.h>
 #include <frozen/map.h>
-#include <esp_log.h>
+#include "HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
+// Channel cache for fast reacquisition. Lives in RTC memory so the
+// last-known-good channel of each inverter survives a reboot.
+#define CHANNEL_CACHE_SIZE 8
+#define CHANNEL_CACHE_MAGIC 0x43484e4c
+
+typedef struct {
+    uint64_t serial;
+    uint8_t channel;
+} channel_cache_entry_t;
+
+static RTC_NOINIT_ATTR uint32_t channelCacheMagic;
+static RTC_NOINIT_ATTR channel_cache_entry_t channelCache[CHANNEL_CACHE_SIZE];
+
 constexpr CountryFrequencyDefinition_t make_value(FrequencyBand_t Band, uint32_t Freq_Legal_Min, uint32_t Freq_Legal_Max, uint32_t Freq_Default, uint32_t Freq_StartUp)
 {
     // frequency can not be lower than actual initailized base freq + 250000
@@ -31,6 +47,42 @@ constexpr frozen::map<CountryModeId_t, CountryFrequencyDefinition_t, 3> countryD
     { CountryModeId_t::MODE_BR, make_value(FrequencyBand_t::BAND_900, 915e6, 928e6, 918e6, 915e6) },
 };
 
+uint8_t HoymilesRadio_CMT::getLastGoodChannel(const uint64_t serial) const
+{
+    if (channelCacheMagic != CHANNEL_CACHE_MAGIC) {
+        return 0xFF;
+    }
+
+    for (uint8_t i = 0; i < CHANNEL_CACHE_SIZE; i++) {
+        if (channelCache[i].serial == serial) {
+            return channelCache[i].channel;
+        }
+    }
+    return 0xFF;
+}
+
+void HoymilesRadio_CMT::setLastGoodChannel(const uint64_t serial, const uint8_t channel)
+{
+    if (channelCacheMagic != CHANNEL_CACHE_MAGIC) {
+        memset(channelCache, 0, sizeof(channelCache));
+        channelCacheMagic = CHANNEL_CACHE_MAGIC;
+    }
+
+    uint8_t freeIdx = 0;
+    for (uint8_t i = 0; i < CHANNEL_CACHE_SIZE; i++) {
+        if (channelCache[i].serial == serial) {
+            channelCache[i].channel = channel;
+            return;
+        }
+        if (channelCache[i].serial == 0) {
+            freeIdx = i;
+        }
+    }
+
+    channelCache[freeIdx].serial = serial;
+    channelCache[freeIdx].channel = channel;
+}
+
 uint32_t HoymilesRadio_CMT::getFrequencyFromChannel(const uint8_t channel) const
 {
     return (_radio->getBaseFrequency() + channel * getChannelWidth());
@@ -133,62 +185,88 @@ void HoymilesRadio_CMT::loop()
     if (_packetReceived) {
         ESP_LOGV(TAG, "Interrupt received");
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            fragment_t* f = getRxRingWriteSlot();
+            if (f == nullptr) {
                 ESP_LOGE(TAG, "CMT2300A: Buffer full");
+                EventCounters.count(EventCountersClass::Counter::RxBufferFull);
                 _radio->flush_rx();
                 continue;
             }
 
-            fragment_t f;
-            memset(f.fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
-            f.len = std::min<uint8_t>(_radio->getDynamicPayloadSize(), MAX_RF_PAYLOAD_SIZE);
-            f.channel = _radio->getChannel();
-            f.rssi = _radio->getRssiDBm();
-            f.wasReceived = false;
-            f.mainCmd = 0x00;
-            _radio->read(f.fragment, f.len);
-            _rxBuffer.push(f);
+            memset(f->fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
+            f->len = std::min<uint8_t>(_radio->getDynamicPayloadSize(), MAX_RF_PAYLOAD_SIZE);
+            f->channel = _radio->getChannel();
+            f->rssi = _radio->getRssiDBm();
+            f->wasReceived = false;
+            f->mainCmd = 0x00;
+            f->arrivalMicros = micros();
+            _radio->read(f->fragment, f->len);
+            commitRxRingWrite();
         }
         _radio->flush_rx();
         _packetReceived = false;
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
-            if (checkFragmentCrc(f)) {
+        fragment_t* f = getRxRingReadSlot();
+        if (f != nullptr) {
+            if (checkFragmentCrc(*f)) {
 
                 const serial_u dtuId = convertSerialToRadioId(_dtuSerial);
 
                 // The CMT RF module does not filter foreign packages by itself.
                 // Has to be done manually here.
-                if (memcmp(&f.fragment[5], &dtuId.b[1], 4) == 0) {
+                if (memcmp(&f->fragment[5], &dtuId.b[1], 4) == 0) {
 
-                    std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
+                    std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(*f);
 
                     if (nullptr != inv) {
                         // Save packet in inverter rx buffer
                         ESP_LOGD(TAG, "RX %.2f MHz --> %s | %" PRId8 " dBm",
-                            getFrequencyFromChannel(f.channel) / 1000000.0, Utils::dumpArray(f.fragment, f.len).c_str(), f.rssi);
+                            getFrequencyFromChannel(f->channel) / 1000000.0, Utils::dumpArray(f->fragment, f->len).c_str(), f->rssi);
 
-                        inv->addRxFragment(f.fragment, f.len, f.rssi);
+                        HoymilesProfilingPins::fragmentPulse();
+                        setLastGoodChannel(inv->serial(), f->channel);
+                        RadioTrace.record(RadioTraceClass::Event::Rx, inv->serial(), f->channel, f->rssi, 0,
+                            f->fragment, f->len);
+                        inv->addRxFragment(f->fragment, f->len, f->rssi);
                     } else {
                         ESP_LOGE(TAG, "Inverter Not found!");
+                        EventCounters.count(EventCountersClass::Counter::UnknownInverter);
                     }
                 }
 
             } else {
                 ESP_LOGW(TAG, "Frame kaputt"); // ;-)
+                EventCounters.count(EventCountersClass::Counter::FragmentCrcError);
             }
 
             // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
+            releaseRxRingRead();
         }
     }
 
     handleReceivedPackage();
 }
 
+void HoymilesRadio_CMT::suspendRadio()
+{
+    if (!_isInitialized) {
+        return;
+    }
+    // GoSleep keeps the register configuration, startListening brings
+    // the chip straight back to RX
+    _radio->stopListening();
+}
+
+void HoymilesRadio_CMT::resumeRadio()
+{
+    if (!_isInitialized) {
+        return;
+    }
+    _radio->startListening();
+}
+
 void HoymilesRadio_CMT::setPALevel(const int8_t paLevel)
 {
     if (!_isInitialized) {
@@ -254,6 +332,34 @@ uint32_t HoymilesRadio_CMT::getInvBootFrequency() const
     return countryDefinition.at(_countryMode).Freq_StartUp;
 }
 
+fragment_t* HoymilesRadio_CMT::getRxRingWriteSlot()
+{
+    const uint8_t nextIdx = (_rxRingWriteIdx + 1) % FRAGMENT_BUFFER_SIZE;
+    if (nextIdx == _rxRingReadIdx) {
+        // Ring is full, one slot is kept free to distinguish full from empty
+        return nullptr;
+    }
+    return &_rxRingBuffer[_rxRingWriteIdx];
+}
+
+void HoymilesRadio_CMT::commitRxRingWrite()
+{
+    _rxRingWriteIdx = (_rxRingWriteIdx + 1) % FRAGMENT_BUFFER_SIZE;
+}
+
+fragment_t* HoymilesRadio_CMT::getRxRingReadSlot()
+{
+    if (_rxRingReadIdx == _rxRingWriteIdx) {
+        return nullptr;
+    }
+    return &_rxRingBuffer[_rxRingReadIdx];
+}
+
+void HoymilesRadio_CMT::releaseRxRingRead()
+{
+    _rxRingReadIdx = (_rxRingReadIdx + 1) % FRAGMENT_BUFFER_SIZE;
+}
+
 void ARDUINO_ISR_ATTR HoymilesRadio_CMT::handleInt1()
 {
     _packetSent = true;
@@ -262,6 +368,7 @@ void ARDUINO_ISR_ATTR HoymilesRadio_CMT::handleInt1()
 void ARDUINO_ISR_ATTR HoymilesRadio_CMT::handleInt2()
 {
     _packetReceived = true;
+    wakeLoopTaskFromISR();
 }
 
 void HoymilesRadio_CMT::sendEsbPacket(CommandAbstract& cmd)
@@ -270,20 +377,43 @@ void HoymilesRadio_CMT::sendEsbPacket(CommandAbstract& cmd)
 
     cmd.setRouterAddress(DtuSerial().u64);
 
+    HoymilesProfilingPins::rxClose();
     _radio->stopListening();
 
     if (cmd.getDataPayload()[0] == 0x56) { // @todo(tbnobody) Bad hack to identify ChannelChange Command
+        // Fast reacquisition: sweep the boot frequency and the cached
+        // last-known-good channel in one batch instead of a single
+        // attempt per queue round trip.
+        const uint8_t lastGood = getLastGoodChannel(cmd.getTargetAddress());
+        if (lastGood != 0xFF && lastGood != getChannelFromFrequency(getInvBootFrequency())) {
+            _radio->setChannel(lastGood);
+
+            ESP_LOGD(TAG, "TX %s %.2f MHz --> %s",
+                cmd.getCommandName().c_str(), getFrequencyFromChannel(_radio->getChannel()) / 1000000.0, cmd.dumpDataPayload().c_str());
+
+            if (!_radio->write(cmd.getDataPayload(), cmd.getDataSize())) {
+                ESP_LOGE(TAG, "TX SPI Timeout");
+                EventCounters.count(EventCountersClass::Counter::TxTimeout);
+            }
+        }
+
         cmtSwitchDtuFreq(getInvBootFrequency());
     }
 
     ESP_LOGD(TAG, "TX %s %.2f MHz --> %s",
         cmd.getCommandName().c_str(), getFrequencyFromChannel(_radio->getChannel()) / 1000000.0, cmd.dumpDataPayload().c_str());
 
+    HoymilesProfilingPins::txStart();
     if (!_radio->write(cmd.getDataPayload(), cmd.getDataSize())) {
         ESP_LOGE(TAG, "TX SPI Timeout");
+        EventCounters.count(EventCountersClass::Counter::TxTimeout);
     }
+    HoymilesProfilingPins::txEnd();
+    RadioTrace.record(RadioTraceClass::Event::Tx, cmd.getTargetAddress(), _radio->getChannel(), 0, 0,
+        cmd.getDataPayload(), cmd.getDataSize());
     cmtSwitchDtuFreq(_inverterTargetFrequency);
     _radio->startListening();
+    HoymilesProfilingPins::rxOpen();
     _busyFlag = true;
     _rxTimeout.set(cmd.getTimeout());
 }
@@ -7,7 +7,6 @@
 #include <Arduino.h>
 #include <cmt2300wrapper.h>
 #include <memory>
-#include <queue>
 #include <vector>
 
 // number of fragments hold in buffer
@@ -66,6 +65,10 @@ public:
 
     std::vector<CountryFrequencyList_t> getCountryFrequencyList() const;
 
+protected:
+    void suspendRadio() override;
+    void resumeRadio() override;
+
 private:
     void ARDUINO_ISR_ATTR handleInt1();
     void ARDUINO_ISR_ATTR handleInt2();
@@ -80,12 +83,29 @@ private:
     bool _gpio2_configured = false;
     bool _gpio3_configured = false;
 
-    std::queue<fragment_t> _rxBuffer;
+    // In-place SPSC fragment ring, same layout as the NRF driver: the
+    // drain loop fills a slot directly and the parser reads it in
+    // place, so fragments are never copied through a heap-backed queue
+    fragment_t* getRxRingWriteSlot();
+    void commitRxRingWrite();
+    fragment_t* getRxRingReadSlot();
+    void releaseRxRingRead();
+
+    fragment_t _rxRingBuffer[FRAGMENT_BUFFER_SIZE];
+    volatile uint8_t _rxRingWriteIdx = 0;
+    volatile uint8_t _rxRingReadIdx = 0;
+
     TimeoutHelper _txTimeout;
 
     uint32_t _inverterTargetFrequency = HOYMILES_CMT_WORK_FREQ;
 
     bool cmtSwitchDtuFreq(const uint32_t to_frequency);
 
+    // Last-known-good working channel per inverter serial. Survives a
+    // reboot (RTC memory) so reacquisition can start on the cached
+    // channel instead of sweeping from scratch.
+    uint8_t getLastGoodChannel(const uint64_t serial) const;
+    void setLastGoodChannel(const uint64_t serial, const uint8_t channel);
+
     CountryModeId_t _countryMode;
 };
@@ -4,11 +4,14 @@
  */
 #include "HoymilesRadio_NRF.h"
 #include "Hoymiles.h"
+#include "ProfilingPins.h"
+#include "RadioTrace.h"
+#include "EventCounters.h"
 #include "Utils.h"
 #include "commands/RequestFrameCommand.h"
 #include <Every.h>
 #include <FunctionalInterrupt.h>
-#include <esp_log.h>
+#include "HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -52,52 +55,107 @@ void HoymilesRadio_NRF::loop()
         switchRxCh();
     }
 
-    if (_packetReceived) {
-        ESP_LOGV(TAG, "Interrupt received");
+    EVERY_N_MILLIS(CHANNEL_QUALITY_DECAY_MS)
+    {
+        // Halving keeps the error ratio but lets a channel recover once
+        // the interference source is gone
+        for (auto& quality : _channelQuality) {
+            quality.windowRx /= 2;
+            quality.windowCrcError /= 2;
+        }
+    }
+
+    // The FIFO drain runs on the dedicated RX task, see drainRx();
+    // this task only parses what the drain committed to the ring
+    fragment_t* f = getRxRingReadSlot();
+    if (f != nullptr) {
+        const bool crcOk = checkFragmentCrc(*f);
+        countRxFragment(f->channel, crcOk);
+
+        if (crcOk) {
+            std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(*f);
+
+            if (nullptr != inv) {
+                // Save packet in inverter rx buffer
+                ESP_LOGD(TAG, "RX Channel: %" PRIu8 " --> %s | %" PRId8 " dBm | parse delay %" PRIu32 " us",
+                    f->channel, Utils::dumpArray(f->fragment, f->len).c_str(), f->rssi,
+                    micros() - f->arrivalMicros);
+
+                HoymilesProfilingPins::fragmentPulse();
+                RadioTrace.record(RadioTraceClass::Event::Rx, inv->serial(), f->channel, f->rssi, 0,
+                    f->fragment, f->len);
+                inv->addRxFragment(f->fragment, f->len, f->rssi);
+            } else {
+                ESP_LOGE(TAG, "Inverter Not found!");
+                EventCounters.count(EventCountersClass::Counter::UnknownInverter);
+            }
+
+        } else {
+            ESP_LOGW(TAG, "Frame kaputt");
+            EventCounters.count(EventCountersClass::Counter::FragmentCrcError);
+        }
+
+        // Remove paket from buffer even it was corrupted
+        releaseRxRingRead();
+    }
+
+    handleReceivedPackage();
+}
+
+void HoymilesRadio_NRF::drainRx()
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    {
+        // The loop task touches the transceiver too (hopping, TX); the
+        // short critical sections keep the drain latency bounded
+        std::lock_guard<std::mutex> lock(_radioMutex);
+
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            fragment_t* f = getRxRingWriteSlot();
+            if (f == nullptr) {
                 ESP_LOGE(TAG, "NRF: Buffer full");
+                EventCounters.count(EventCountersClass::Counter::RxBufferFull);
                 _radio->flush_rx();
                 continue;
             }
 
-            fragment_t f;
-            memset(f.fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
-            f.len = std::min<uint8_t>(_radio->getDynamicPayloadSize(), MAX_RF_PAYLOAD_SIZE);
-            f.channel = _radio->getChannel();
-            f.rssi = _radio->testRPD() ? -30 : -80;
-            _radio->read(f.fragment, f.len);
-            _rxBuffer.push(f);
+            memset(f->fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
+            f->len = std::min<uint8_t>(_radio->getDynamicPayloadSize(), MAX_RF_PAYLOAD_SIZE);
+            f->channel = _radio->getChannel();
+            f->rssi = _radio->testRPD() ? -30 : -80;
+            f->arrivalMicros = micros();
+            _radio->read(f->fragment, f->len);
+            commitRxRingWrite();
         }
-        _packetReceived = false;
-
-    } else {
-        // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
-            if (checkFragmentCrc(f)) {
-                std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
-
-                if (nullptr != inv) {
-                    // Save packet in inverter rx buffer
-                    ESP_LOGD(TAG, "RX Channel: %" PRIu8 " --> %s | %" PRId8 " dBm",
-                        f.channel, Utils::dumpArray(f.fragment, f.len).c_str(), f.rssi);
-
-                    inv->addRxFragment(f.fragment, f.len, f.rssi);
-                } else {
-                    ESP_LOGE(TAG, "Inverter Not found!");
-                }
+    }
 
-            } else {
-                ESP_LOGW(TAG, "Frame kaputt");
-            }
+    // Hand the committed fragments over to the parser without waiting
+    // for the loop task's pacing tick
+    wakeLoopTask();
+}
 
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
-        }
+void HoymilesRadio_NRF::suspendRadio()
+{
+    if (!_isInitialized) {
+        return;
     }
+    std::lock_guard<std::mutex> lock(_radioMutex);
+    _radio->stopListening();
+    _radio->powerDown();
+}
 
-    handleReceivedPackage();
+void HoymilesRadio_NRF::resumeRadio()
+{
+    if (!_isInitialized) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_radioMutex);
+    _radio->powerUp();
+    openReadingPipe();
+    _radio->startListening();
 }
 
 void HoymilesRadio_NRF::setPALevel(const rf24_pa_dbm_e paLevel)
@@ -148,13 +206,62 @@ void HoymilesRadio_NRF::openWritingPipe(const serial_u serial)
 
 void ARDUINO_ISR_ATTR HoymilesRadio_NRF::handleIntr()
 {
-    _packetReceived = true;
+    // The SPI FIFO drain has to run in task context (shared bus,
+    // arbitrated access); the dedicated RX task takes it from here
+    // with sub-millisecond latency
+    wakeRxTaskFromISR();
+}
+
+fragment_t* HoymilesRadio_NRF::getRxRingWriteSlot()
+{
+    const uint8_t nextIdx = (_rxRingWriteIdx + 1) % FRAGMENT_BUFFER_SIZE;
+    if (nextIdx == _rxRingReadIdx) {
+        // Ring is full, one slot is kept free to distinguish full from empty
+        return nullptr;
+    }
+    return &_rxRingBuffer[_rxRingWriteIdx];
+}
+
+void HoymilesRadio_NRF::commitRxRingWrite()
+{
+    _rxRingWriteIdx = (_rxRingWriteIdx + 1) % FRAGMENT_BUFFER_SIZE;
+}
+
+fragment_t* HoymilesRadio_NRF::getRxRingReadSlot()
+{
+    if (_rxRingReadIdx == _rxRingWriteIdx) {
+        return nullptr;
+    }
+    return &_rxRingBuffer[_rxRingReadIdx];
+}
+
+void HoymilesRadio_NRF::releaseRxRingRead()
+{
+    _rxRingReadIdx = (_rxRingReadIdx + 1) % FRAGMENT_BUFFER_SIZE;
 }
 
 uint8_t HoymilesRadio_NRF::getRxNxtChannel()
 {
-    if (++_rxChIdx >= sizeof(_rxChLst))
-        _rxChIdx = 0;
+    // Round robin over the hop list, but a channel whose recent frames
+    // were mostly corrupt (a WiFi network sitting on it) only gets
+    // every CHANNEL_DEPRIORITIZED_DIVIDER-th of its listening turns.
+    // The channel is never blacklisted entirely: the inverter hops on
+    // its own schedule and the map has to notice when the interference
+    // disappears. One full pass bounds the loop, so if every channel
+    // looks bad the plain round robin behavior remains.
+    for (uint8_t hop = 0; hop < sizeof(_rxChLst); hop++) {
+        if (++_rxChIdx >= sizeof(_rxChLst)) {
+            _rxChIdx = 0;
+        }
+
+        ChannelQuality_t& quality = _channelQuality[_rxChIdx];
+        if (!isChannelDeprioritized(quality)) {
+            break;
+        }
+        if (++quality.listenTurnsSkipped % CHANNEL_DEPRIORITIZED_DIVIDER == 0) {
+            break;
+        }
+    }
     return _rxChLst[_rxChIdx];
 }
 
@@ -165,11 +272,64 @@ uint8_t HoymilesRadio_NRF::getTxNxtChannel()
     return _txChLst[_txChIdx];
 }
 
+bool HoymilesRadio_NRF::isChannelDeprioritized(const ChannelQuality_t& quality) const
+{
+    const uint32_t windowTotal = quality.windowRx + quality.windowCrcError;
+    return windowTotal >= CHANNEL_QUALITY_MIN_SAMPLES
+        && quality.windowCrcError * 2 > windowTotal;
+}
+
+int8_t HoymilesRadio_NRF::getChannelListIdx(const uint8_t channel) const
+{
+    for (uint8_t i = 0; i < sizeof(_rxChLst); i++) {
+        if (_rxChLst[i] == channel) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void HoymilesRadio_NRF::countRxFragment(const uint8_t channel, const bool crcOk)
+{
+    const int8_t idx = getChannelListIdx(channel);
+    if (idx < 0) {
+        return;
+    }
+
+    ChannelQuality_t& quality = _channelQuality[idx];
+    if (crcOk) {
+        quality.rxCount++;
+        quality.windowRx++;
+    } else {
+        quality.rxCrcErrorCount++;
+        quality.windowCrcError++;
+    }
+}
+
+uint8_t HoymilesRadio_NRF::getChannelStats(ChannelStats_t stats[], const uint8_t maxCount) const
+{
+    const uint8_t count = std::min<uint8_t>(maxCount, sizeof(_rxChLst));
+    for (uint8_t i = 0; i < count; i++) {
+        const ChannelQuality_t& quality = _channelQuality[i];
+        stats[i].channel = _rxChLst[i];
+        stats[i].deprioritized = isChannelDeprioritized(quality);
+        stats[i].txCount = quality.txCount;
+        stats[i].rxCount = quality.rxCount;
+        stats[i].rxCrcErrorCount = quality.rxCrcErrorCount;
+        stats[i].listenTurnsSkipped = quality.listenTurnsSkipped;
+    }
+    return count;
+}
+
 void HoymilesRadio_NRF::switchRxCh()
 {
+    std::lock_guard<std::mutex> lock(_radioMutex);
+
+    HoymilesProfilingPins::rxClose();
     _radio->stopListening();
     _radio->setChannel(getRxNxtChannel());
     _radio->startListening();
+    HoymilesProfilingPins::rxOpen();
 }
 
 void HoymilesRadio_NRF::sendEsbPacket(CommandAbstract& cmd)
@@ -178,9 +338,17 @@ void HoymilesRadio_NRF::sendEsbPacket(CommandAbstract& cmd)
 
     cmd.setRouterAddress(DtuSerial().u64);
 
+    std::lock_guard<std::mutex> lock(_radioMutex);
+
+    HoymilesProfilingPins::rxClose();
     _radio->stopListening();
     _radio->setChannel(getTxNxtChannel());
 
+    const int8_t txStatsIdx = getChannelListIdx(_txChLst[_txChIdx]);
+    if (txStatsIdx >= 0) {
+        _channelQuality[txStatsIdx].txCount++;
+    }
+
     serial_u s;
     s.u64 = cmd.getTargetAddress();
     openWritingPipe(s);
@@ -188,12 +356,17 @@ void HoymilesRadio_NRF::sendEsbPacket(CommandAbstract& cmd)
 
     ESP_LOGD(TAG, "TX %s Channel: %" PRIu8 " --> %s",
         cmd.getCommandName().c_str(), _radio->getChannel(), cmd.dumpDataPayload().c_str());
+    HoymilesProfilingPins::txStart();
     _radio->write(cmd.getDataPayload(), cmd.getDataSize());
+    HoymilesProfilingPins::txEnd();
+    RadioTrace.record(RadioTraceClass::Event::Tx, cmd.getTargetAddress(), _radio->getChannel(), 0, 0,
+        cmd.getDataPayload(), cmd.getDataSize());
 
     _radio->setRetries(0, 0);
     openReadingPipe();
     _radio->setChannel(getRxNxtChannel());
     _radio->startListening();
+    HoymilesProfilingPins::rxOpen();
     _busyFlag = true;
     _rxTimeout.set(cmd.getTimeout());
 }
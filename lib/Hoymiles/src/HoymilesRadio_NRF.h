@@ -5,14 +5,32 @@
 #include "commands/CommandAbstract.h"
 #include <RF24.h>
 #include <memory>
+#include <mutex>
 #include <nRF24L01.h>
-#include <queue>
 
 // number of fragments hold in buffer
 #define FRAGMENT_BUFFER_SIZE 30
 
+// Channel quality map, see getRxNxtChannel(): a channel is
+// deprioritized once this many frames of the decaying window ...
+#define CHANNEL_QUALITY_MIN_SAMPLES 16
+// ... were mostly corrupt; it then only gets every n-th listening turn
+#define CHANNEL_DEPRIORITIZED_DIVIDER 4
+// window counters are halved at this interval so old interference ages out
+#define CHANNEL_QUALITY_DECAY_MS (60 * 1000)
+
 class HoymilesRadio_NRF : public HoymilesRadio {
 public:
+    // Snapshot of one hop channel's quality counters for monitoring
+    struct ChannelStats_t {
+        uint8_t channel;
+        bool deprioritized;
+        uint32_t txCount;
+        uint32_t rxCount;
+        uint32_t rxCrcErrorCount;
+        uint32_t listenTurnsSkipped;
+    };
+
     void init(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ);
     void loop();
     void setPALevel(const rf24_pa_dbm_e paLevel);
@@ -22,6 +40,15 @@ public:
     bool isConnected() const;
     bool isPVariant() const;
 
+    // Copies up to maxCount entries of the channel quality map and
+    // returns the number of entries written
+    uint8_t getChannelStats(ChannelStats_t stats[], const uint8_t maxCount) const;
+
+protected:
+    void drainRx() override;
+    void suspendRadio() override;
+    void resumeRadio() override;
+
 private:
     void ARDUINO_ISR_ATTR handleIntr();
     uint8_t getRxNxtChannel();
@@ -40,7 +67,40 @@ private:
     uint8_t _txChLst[5] = { 3, 23, 40, 61, 75 };
     uint8_t _txChIdx = 0;
 
-    volatile bool _packetReceived = false;
+    // Serializes transceiver access between the RX drain task and the
+    // loop task (hopping, TX, power state)
+    std::mutex _radioMutex;
+
+    // Per-channel quality counters, indexed like _rxChLst (both hop
+    // lists carry the same channels). Totals feed the monitoring API;
+    // the decaying window pair drives the hop deprioritization. Written
+    // on the radio loop task, read as plain 32 bit loads like the
+    // RadioStats counters.
+    struct ChannelQuality_t {
+        uint32_t txCount = 0;
+        uint32_t rxCount = 0;
+        uint32_t rxCrcErrorCount = 0;
+        uint32_t listenTurnsSkipped = 0;
+        uint32_t windowRx = 0;
+        uint32_t windowCrcError = 0;
+    };
+
+    bool isChannelDeprioritized(const ChannelQuality_t& quality) const;
+    int8_t getChannelListIdx(const uint8_t channel) const;
+    void countRxFragment(const uint8_t channel, const bool crcOk);
+
+    ChannelQuality_t _channelQuality[5];
+
+    // Single-producer single-consumer fragment ring buffer. The RX
+    // drain task writes received fragments in place and the parser on
+    // the loop task reads them in place, so no fragment is ever copied
+    // through a heap-backed queue.
+    fragment_t* getRxRingWriteSlot();
+    void commitRxRingWrite();
+    fragment_t* getRxRingReadSlot();
+    void releaseRxRingRead();
 
-    std::queue<fragment_t> _rxBuffer;
+    fragment_t _rxRingBuffer[FRAGMENT_BUFFER_SIZE];
+    volatile uint8_t _rxRingWriteIdx = 0;
+    volatile uint8_t _rxRingReadIdx = 0;
 };
\ No newline at end of file
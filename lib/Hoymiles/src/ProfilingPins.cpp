@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#ifdef HOYMILES_PROFILING_PINS
+
+#include "ProfilingPins.h"
+#include <Arduino.h>
+#include <driver/gpio.h>
+
+namespace HoymilesProfilingPins {
+
+static gpio_num_t sTxPin = GPIO_NUM_NC;
+static gpio_num_t sRxPin = GPIO_NUM_NC;
+static gpio_num_t sFragmentPin = GPIO_NUM_NC;
+
+// gpio_set_level resolves to a register write, cheap enough for the
+// radio loop tasks and precise enough for a logic analyzer
+static inline void set(const gpio_num_t pin, const uint32_t level)
+{
+    if (pin != GPIO_NUM_NC) {
+        gpio_set_level(pin, level);
+    }
+}
+
+void init(const int8_t txPin, const int8_t rxPin, const int8_t fragmentPin)
+{
+    sTxPin = static_cast<gpio_num_t>(txPin);
+    sRxPin = static_cast<gpio_num_t>(rxPin);
+    sFragmentPin = static_cast<gpio_num_t>(fragmentPin);
+
+    for (const auto pin : { sTxPin, sRxPin, sFragmentPin }) {
+        if (pin != GPIO_NUM_NC) {
+            pinMode(pin, OUTPUT);
+            gpio_set_level(pin, 0);
+        }
+    }
+}
+
+void txStart() { set(sTxPin, 1); }
+void txEnd() { set(sTxPin, 0); }
+void rxOpen() { set(sRxPin, 1); }
+void rxClose() { set(sRxPin, 0); }
+
+void fragmentPulse()
+{
+    set(sFragmentPin, 1);
+    set(sFragmentPin, 0);
+}
+
+} // namespace HoymilesProfilingPins
+
+#endif
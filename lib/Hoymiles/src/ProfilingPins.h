@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+// Logic-analyzer ground truth for RF timing work: builds with
+// -DHOYMILES_PROFILING_PINS=1 toggle dedicated GPIOs at the radio
+// state transitions (TX start/end, RX window open/close, fragment
+// accepted), so firmware state can be correlated with an on-air
+// capture at microsecond resolution. The pins come from the device
+// profile ("radio_profiling" section, see src/PinMapping.cpp);
+// unassigned pins stay inert. In regular builds every hook compiles
+// to nothing.
+
+namespace HoymilesProfilingPins {
+
+#ifdef HOYMILES_PROFILING_PINS
+
+void init(const int8_t txPin, const int8_t rxPin, const int8_t fragmentPin);
+
+void txStart();
+void txEnd();
+void rxOpen();
+void rxClose();
+// Short pulse on every fragment that passed the CRC check
+void fragmentPulse();
+
+#else
+
+inline void init(const int8_t, const int8_t, const int8_t) { }
+inline void txStart() { }
+inline void txEnd() { }
+inline void rxOpen() { }
+inline void rxClose() { }
+inline void fragmentPulse() { }
+
+#endif
+
+} // namespace HoymilesProfilingPins
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "RadioTrace.h"
+#include "HoymilesLogLevel.h"
+#include <algorithm>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#undef TAG
+static const char* TAG = "hoymiles";
+
+RadioTraceClass RadioTrace;
+
+void RadioTraceClass::init()
+{
+    if (_records != nullptr) {
+        return;
+    }
+
+    _records = static_cast<Record*>(
+        heap_caps_calloc(RADIO_TRACE_CAPACITY, sizeof(Record), MALLOC_CAP_SPIRAM));
+    if (_records == nullptr) {
+        ESP_LOGI(TAG, "No PSRAM available, radio trace disabled");
+        return;
+    }
+
+    _capacity = RADIO_TRACE_CAPACITY;
+    ESP_LOGI(TAG, "Radio trace enabled: %u records (%u bytes PSRAM)",
+        RADIO_TRACE_CAPACITY, static_cast<unsigned>(RADIO_TRACE_CAPACITY * sizeof(Record)));
+}
+
+void RadioTraceClass::record(const Event event, const uint64_t serial, const uint8_t channel,
+    const int8_t rssi, const uint8_t fragmentId, const uint8_t* payload, const size_t len)
+{
+    if (_records == nullptr) {
+        return;
+    }
+
+    // Both radio loop tasks write concurrently: the atomic increment
+    // hands out unique slots, the record body itself is written
+    // unsynchronized. A reader may therefore see one torn record at the
+    // ring head - acceptable for post-hoc analysis, and the price of
+    // keeping this path lock-free.
+    const uint32_t seq = _sequence.fetch_add(1, std::memory_order_acq_rel);
+    Record& r = _records[seq % _capacity];
+
+    r.timestampUs = static_cast<uint32_t>(esp_timer_get_time());
+    r.event = static_cast<uint8_t>(event);
+    r.channel = channel;
+    r.fragmentId = fragmentId;
+    r.rssi = rssi;
+    r.serial = serial;
+    r.len = std::min(len, sizeof(r.payload));
+    if (payload != nullptr && r.len > 0) {
+        memcpy(r.payload, payload, r.len);
+    }
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "types.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define RADIO_TRACE_CAPACITY 2048
+
+// Binary flight recorder for radio exchanges. Fixed-size records are
+// written lock-free from the radio loop tasks into a PSRAM ring, so
+// tracing perturbs the RF timing far less than verbose text logging.
+// The ring is dumped via /api/radio/trace for post-hoc analysis.
+class RadioTraceClass {
+public:
+    enum class Event : uint8_t {
+        Tx = 1,
+        Rx = 2,
+        Timeout = 3,
+        Retransmit = 4,
+    };
+
+    struct __attribute__((packed)) Record {
+        uint32_t timestampUs;
+        uint8_t event; // Event
+        uint8_t channel;
+        uint8_t fragmentId; // requested fragment for retransmits
+        int8_t rssi; // RX only
+        uint64_t serial; // inverter serial
+        uint8_t len; // captured payload bytes
+        // Full frames, so saved captures can be replayed through the
+        // real fragment path (see Replay.h)
+        uint8_t payload[MAX_RF_PAYLOAD_SIZE];
+    };
+    static_assert(sizeof(Record) == 49, "record layout is part of the dump format");
+
+    // Allocates the ring in PSRAM; tracing stays disabled (records are
+    // dropped silently) when no PSRAM is available
+    void init();
+
+    void record(const Event event, const uint64_t serial, const uint8_t channel,
+        const int8_t rssi, const uint8_t fragmentId, const uint8_t* payload, const size_t len);
+
+    bool isEnabled() const { return _records != nullptr; }
+    uint32_t getCapacity() const { return _capacity; }
+    // total number of records ever written; the ring holds the last
+    // min(sequence, capacity) of them
+    uint32_t getSequence() const { return _sequence.load(std::memory_order_acquire); }
+    const Record* getRing() const { return _records; }
+
+private:
+    Record* _records = nullptr;
+    uint32_t _capacity = 0;
+    std::atomic<uint32_t> _sequence = 0;
+};
+
+extern RadioTraceClass RadioTrace;
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2026 Thomas Basler and others
+ */
+#ifdef HOYMILES_REPLAY
+
+#include "Replay.h"
+#include "Hoymiles.h"
+#include "HoymilesLogLevel.h"
+#include "RadioTrace.h"
+#include "commands/RealTimeRunDataCommand.h"
+#include "inverters/InverterAbstract.h"
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <cinttypes>
+
+#undef TAG
+static const char* TAG = "hoymiles";
+
+// Mirrors the dump header written by the web API; everything little
+// endian, records follow oldest first
+struct __attribute__((packed)) ReplayDumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+    uint32_t sequence;
+};
+
+static constexpr uint32_t replayDumpMagic = 0x4F445254; // "ODRT"
+static constexpr uint32_t replayDumpVersion = 2;
+
+// Gaps between captures or timestamp wraps must not stall the replay
+// for minutes; anything beyond this plays back as a fixed pause
+static constexpr uint32_t replayMaxGapUs = 2 * 1000 * 1000;
+
+namespace HoymilesReplay {
+
+enum class State : uint8_t {
+    Init,
+    Running,
+    Done,
+};
+
+static State state = State::Init;
+static RadioTraceClass::Record* records = nullptr;
+static uint32_t recordCount = 0;
+static uint32_t cursor = 0;
+static int64_t nextDueUs = 0;
+static uint64_t openExchangeSerial = 0;
+static uint32_t replayedFragments = 0;
+static uint32_t parsedExchanges = 0;
+
+static bool load()
+{
+    File f = LittleFS.open(HOYMILES_REPLAY_FILENAME, "r");
+    if (!f) {
+        ESP_LOGE(TAG, "Replay: %s not found", HOYMILES_REPLAY_FILENAME);
+        return false;
+    }
+
+    ReplayDumpHeader header;
+    if (f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header)
+        || header.magic != replayDumpMagic
+        || header.version != replayDumpVersion
+        || header.recordSize != sizeof(RadioTraceClass::Record)) {
+        ESP_LOGE(TAG, "Replay: capture rejected (need dump version %" PRIu32 " with %u byte records)",
+            replayDumpVersion, static_cast<unsigned>(sizeof(RadioTraceClass::Record)));
+        f.close();
+        return false;
+    }
+
+    const size_t totalSize = header.count * sizeof(RadioTraceClass::Record);
+    records = static_cast<RadioTraceClass::Record*>(
+        heap_caps_malloc(totalSize, MALLOC_CAP_SPIRAM));
+    if (records == nullptr) {
+        // internal RAM as fallback for short captures on PSRAM-less boards
+        records = static_cast<RadioTraceClass::Record*>(malloc(totalSize));
+    }
+    if (records == nullptr) {
+        ESP_LOGE(TAG, "Replay: no memory for %" PRIu32 " records", header.count);
+        f.close();
+        return false;
+    }
+
+    if (f.read(reinterpret_cast<uint8_t*>(records), totalSize) != totalSize) {
+        ESP_LOGE(TAG, "Replay: capture truncated");
+        free(records);
+        records = nullptr;
+        f.close();
+        return false;
+    }
+    f.close();
+
+    recordCount = header.count;
+    ESP_LOGI(TAG, "Replay: %" PRIu32 " records loaded from %s", recordCount, HOYMILES_REPLAY_FILENAME);
+    return true;
+}
+
+// Closes the exchange currently being reassembled, running the real
+// verify/CRC/parse path for statistics responses
+static void finishExchange()
+{
+    if (openExchangeSerial == 0) {
+        return;
+    }
+
+    auto inv = Hoymiles.getInverterBySerial(openExchangeSerial);
+    openExchangeSerial = 0;
+    if (inv == nullptr) {
+        return;
+    }
+
+    RealTimeRunDataCommand cmd(inv.get());
+    if (inv->verifyAllFragments(cmd) == FRAGMENT_OK) {
+        parsedExchanges++;
+    }
+    inv->clearRxFragmentBuffer();
+}
+
+static void playRecord(const RadioTraceClass::Record& r)
+{
+    switch (static_cast<RadioTraceClass::Event>(r.event)) {
+    case RadioTraceClass::Event::Rx: {
+        auto inv = Hoymiles.getInverterBySerial(r.serial);
+        if (inv == nullptr) {
+            // the capture's inverter has to be configured on the bench
+            // device; otherwise its fragments are paced but dropped
+            return;
+        }
+
+        if (openExchangeSerial != 0 && openExchangeSerial != r.serial) {
+            finishExchange();
+        }
+        if (openExchangeSerial == 0) {
+            inv->clearRxFragmentBuffer();
+            openExchangeSerial = r.serial;
+        }
+
+        // Only statistics responses (0x95) travel through the verify
+        // path below; everything else still exercises fragment intake
+        inv->addRxFragment(r.payload, r.len, r.rssi);
+        replayedFragments++;
+
+        if (r.len > 9 && (r.payload[9] & 0x80) == 0x80 && r.payload[0] == 0x95) {
+            finishExchange();
+        }
+        break;
+    }
+    case RadioTraceClass::Event::Tx:
+        // A new request implicitly ends whatever the capture was
+        // receiving; partial exchanges are discarded like on air
+        finishExchange();
+        break;
+    case RadioTraceClass::Event::Timeout:
+    case RadioTraceClass::Event::Retransmit:
+        // Pacing only; the retransmit answers show up as RX records
+        break;
+    }
+}
+
+void loop()
+{
+    if (state == State::Done) {
+        return;
+    }
+
+    if (state == State::Init) {
+        if (!load() || recordCount == 0) {
+            state = State::Done;
+            return;
+        }
+        nextDueUs = esp_timer_get_time();
+        state = State::Running;
+    }
+
+    while (cursor < recordCount && esp_timer_get_time() >= nextDueUs) {
+        playRecord(records[cursor]);
+
+        if (cursor + 1 < recordCount) {
+            // unsigned delta handles micros() wrap within the capture
+            uint32_t delta = records[cursor + 1].timestampUs - records[cursor].timestampUs;
+            if (delta > replayMaxGapUs) {
+                delta = replayMaxGapUs;
+            }
+            nextDueUs += delta;
+        }
+        cursor++;
+    }
+
+    if (cursor >= recordCount) {
+        finishExchange();
+        ESP_LOGI(TAG, "Replay finished: %" PRIu32 " fragments, %" PRIu32 " exchanges parsed",
+            replayedFragments, parsedExchanges);
+        free(records);
+        records = nullptr;
+        state = State::Done;
+    }
+}
+
+} // namespace HoymilesReplay
+
+#endif
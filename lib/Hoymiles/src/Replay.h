@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Deterministic replay of captured radio exchanges: builds with
+// -DHOYMILES_REPLAY=1 load a flight-recorder capture (saved via
+// /api/radio/trace/save, uploadable through the file API) and feed the
+// recorded RX fragments through the real fragment/verify/parse path
+// with the original inter-fragment timing. The radios stay
+// uninitialized like in simulator builds, while Datastore, MQTT, the
+// websocket and the scheduler see the exact fragment cadence of the
+// production trace - making timing-dependent anomalies reproducible
+// and bisectable on a bench device.
+//
+// Requires a version 2 capture (full frame payloads); older captures
+// are rejected with a log message.
+
+#ifndef HOYMILES_REPLAY_FILENAME
+#define HOYMILES_REPLAY_FILENAME "/radiotrace.bin"
+#endif
+
+namespace HoymilesReplay {
+
+// Drives the replay state machine; called once per Hoymiles loop pass
+void loop();
+
+} // namespace HoymilesReplay
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#ifdef HOYMILES_SIMULATOR
+
+#include "Simulator.h"
+#include "inverters/InverterAbstract.h"
+#include <Arduino.h>
+#include <cmath>
+#include <ctime>
+#include <esp_random.h>
+
+namespace HoymilesSimulator {
+
+// Encodes value * div big-endian into the payload at the field's
+// position; calculated fields have no payload bytes and are skipped
+static void encodeField(uint8_t* payload, const byteAssign_t* pos, const float value)
+{
+    if (pos == nullptr || pos->div == CMD_CALC) {
+        return;
+    }
+
+    const int32_t raw = lroundf(value * pos->div);
+    for (uint8_t i = 0; i < pos->num; i++) {
+        payload[pos->start + i] = (raw >> (8 * (pos->num - 1 - i))) & 0xFF;
+    }
+}
+
+// ±amplitude uniform noise
+static float noise(const float amplitude)
+{
+    return amplitude * ((static_cast<int32_t>(esp_random() % 2001) - 1000) / 1000.0f);
+}
+
+void fillStatistics(InverterAbstract& inv)
+{
+    auto* stats = inv.Statistics();
+
+    const uint8_t expectedBytes = stats->getExpectedByteCount();
+    if (expectedBytes == 0 || expectedBytes > STATISTIC_PACKET_SIZE) {
+        return;
+    }
+    uint8_t payload[STATISTIC_PACKET_SIZE] = {};
+
+    // Sun curve over the local day: zero before 06:00 and after 18:00,
+    // peaking at noon. Without NTP sync the bench rig runs at dawn.
+    const time_t now = time(nullptr);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    const float dayPhase = (timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec) / 86400.0f;
+    const float daylight = std::max(0.0f, sinf((dayPhase - 0.25f) * 2.0f * static_cast<float>(M_PI)));
+
+    float pdcTotal = 0;
+    for (auto& ch : stats->getChannelsByType(TYPE_DC)) {
+        const uint16_t configuredMax = stats->getStringMaxPower(static_cast<uint8_t>(ch));
+        const float maxPower = configuredMax > 0 ? configuredMax : 400.0f;
+
+        const float udc = 33.0f + 3.0f * daylight + noise(0.5f);
+        const float pdc = maxPower * daylight * (1.0f + noise(0.05f));
+        const float idc = udc > 0 ? pdc / udc : 0;
+
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_DC, ch, FLD_UDC), udc);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_DC, ch, FLD_IDC), idc);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_DC, ch, FLD_PDC), pdc);
+
+        // Yields accumulate across fabrication intervals
+        const float ydInc = pdc * HOYMILES_SIMULATOR_INTERVAL_MS / 3600000.0f; // Wh
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_DC, ch, FLD_YD),
+            stats->getChannelFieldValue(TYPE_DC, ch, FLD_YD) + ydInc);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_DC, ch, FLD_YT),
+            stats->getChannelFieldValue(TYPE_DC, ch, FLD_YT) + ydInc / 1000.0f); // kWh
+
+        pdcTotal += pdc;
+    }
+
+    const float pac = pdcTotal * 0.955f;
+    for (auto& ch : stats->getChannelsByType(TYPE_AC)) {
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_UAC), 230.0f + noise(1.5f));
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_IAC), pac / 230.0f);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_PAC), pac);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_F), 50.0f + noise(0.02f));
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_PF), 0.998f);
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, FLD_Q), pac * 0.02f);
+
+        // Three-phase models (HMT) carry per-phase fields instead of a
+        // single IAC; missing assignments are skipped by encodeField
+        for (const auto fld : { FLD_UAC_1N, FLD_UAC_2N, FLD_UAC_3N }) {
+            encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, fld), 230.0f + noise(1.5f));
+        }
+        for (const auto fld : { FLD_UAC_12, FLD_UAC_23, FLD_UAC_31 }) {
+            encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, fld), 400.0f + noise(2.0f));
+        }
+        for (const auto fld : { FLD_IAC_1, FLD_IAC_2, FLD_IAC_3 }) {
+            encodeField(payload, stats->getAssignmentByChannelField(TYPE_AC, ch, fld), pac / (3.0f * 230.0f));
+        }
+    }
+
+    for (auto& ch : stats->getChannelsByType(TYPE_INV)) {
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_INV, ch, FLD_T), 20.0f + 25.0f * daylight + noise(0.5f));
+        encodeField(payload, stats->getAssignmentByChannelField(TYPE_INV, ch, FLD_EVT_LOG), 0);
+    }
+
+    // Same ingestion sequence as a completed radio exchange
+    // (see RealTimeRunDataCommand::handleResponse)
+    stats->beginAppendFragment();
+    stats->clearBuffer();
+    stats->appendFragment(0, payload, expectedBytes);
+    stats->endAppendFragment();
+    stats->resetRxFailureCount();
+    stats->setLastUpdate(millis());
+
+    inv.RadioStats.TxRequestData++;
+    inv.RadioStats.RxSuccess++;
+}
+
+} // namespace HoymilesSimulator
+
+#endif
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+class InverterAbstract;
+
+// Bench load testing without sunlight or radio hardware: builds with
+// -DHOYMILES_SIMULATOR=1 fabricate realistic statistics payloads for
+// every configured inverter and feed them through the regular parser,
+// so Datastore, MQTT, the websocket and Prometheus see real-shaped
+// data at a configurable rate. Inverters are added through the normal
+// config UI; the serial prefix picks the simulated model as usual and
+// the radios simply stay uninitialized.
+
+// Fabrication interval per inverter in milliseconds
+#ifndef HOYMILES_SIMULATOR_INTERVAL_MS
+#define HOYMILES_SIMULATOR_INTERVAL_MS 5000
+#endif
+
+namespace HoymilesSimulator {
+
+// Synthesizes one full statistics payload (sun-curve DC power with
+// noise, derived AC values, accumulating yields) and runs it through
+// the inverter's StatisticsParser like a received radio exchange
+void fillStatistics(InverterAbstract& inv);
+
+} // namespace HoymilesSimulator
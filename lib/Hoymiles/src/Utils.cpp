@@ -6,18 +6,59 @@
 #include <Arduino.h>
 #include <time.h>
 
+std::mutex Utils::_timeMutex;
+uint32_t Utils::_lastRefreshMillis = 0;
+bool Utils::_cacheValid = false;
+bool Utils::_timeSynced = false;
+struct tm Utils::_localTime = {};
+int Utils::_timezoneOffset = 0;
+
+void Utils::refreshTimeCache()
+{
+    if (_cacheValid && millis() - _lastRefreshMillis < 1000) {
+        return;
+    }
+
+    const time_t now = time(NULL);
+    localtime_r(&now, &_localTime);
+
+    // see: https://stackoverflow.com/questions/13804095/get-the-time-zone-gmt-offset-in-c/44063597#44063597
+    struct tm gbuf;
+    gmtime_r(&now, &gbuf);
+
+    // Request that mktime() looksup dst in timezone database
+    gbuf.tm_isdst = -1;
+    const time_t gmt = mktime(&gbuf);
+    _timezoneOffset = static_cast<int>(difftime(now, gmt));
+
+    // SNTP steps the clock on the first sync; before that it runs from
+    // the epoch. Same plausibility check getLocalTime() uses, without
+    // its blocking wait.
+    _timeSynced = _localTime.tm_year > (2016 - 1900);
+
+    _lastRefreshMillis = millis();
+    _cacheValid = true;
+}
+
 uint8_t Utils::getWeekDay()
 {
-    time_t now = time(NULL);
-    struct tm tm;
-    localtime_r(&now, &tm);
-    return tm.tm_mday;
+    std::lock_guard<std::mutex> lock(_timeMutex);
+    refreshTimeCache();
+    return _localTime.tm_mday;
 }
 
 bool Utils::getTimeAvailable()
 {
-    struct tm timeinfo;
-    return getLocalTime(&timeinfo, 5);
+    std::lock_guard<std::mutex> lock(_timeMutex);
+    refreshTimeCache();
+    return _timeSynced;
+}
+
+int Utils::getTimezoneOffset()
+{
+    std::lock_guard<std::mutex> lock(_timeMutex);
+    refreshTimeCache();
+    return _timezoneOffset;
 }
 
 String Utils::dumpArray(const uint8_t data[], const uint8_t len)
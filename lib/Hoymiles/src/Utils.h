@@ -1,12 +1,30 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
-#include <cstdint>
 #include <WString.h>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
 
 class Utils {
 public:
     static uint8_t getWeekDay();
     static bool getTimeAvailable();
+    static int getTimezoneOffset();
     static String dumpArray(const uint8_t buf[], const uint8_t len);
+
+private:
+    // Cached civil-time breakdown and utc offset, refreshed at most
+    // once per second. localtime_r and mktime re-parse the TZ
+    // environment on every call, which is too expensive for the
+    // per-exchange paths that only need the day, the sync state or
+    // the timezone offset. The caller must hold _timeMutex.
+    static void refreshTimeCache();
+
+    static std::mutex _timeMutex;
+    static uint32_t _lastRefreshMillis;
+    static bool _cacheValid;
+    static bool _timeSynced;
+    static struct tm _localTime;
+    static int _timezoneOffset;
 };
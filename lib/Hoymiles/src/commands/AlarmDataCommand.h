@@ -11,4 +11,6 @@ public:
 
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
     virtual void gotTimeout();
+
+    virtual QueuePriority getQueuePriority() const { return QueuePriority::Alarm; }
 };
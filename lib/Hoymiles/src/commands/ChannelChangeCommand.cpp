@@ -39,6 +39,7 @@ String ChannelChangeCommand::getCommandName() const
 void ChannelChangeCommand::setChannel(const uint8_t channel)
 {
     _payload[12] = channel;
+    markPayloadDirty();
 }
 
 uint8_t ChannelChangeCommand::getChannel() const
@@ -65,6 +66,7 @@ void ChannelChangeCommand::setCountryMode(const CountryModeId_t mode)
         _payload[11] = 0x21;
         break;
     }
+    markPayloadDirty();
 }
 
 bool ChannelChangeCommand::handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id)
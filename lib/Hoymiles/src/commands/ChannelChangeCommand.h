@@ -18,4 +18,6 @@ public:
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
 
     virtual uint8_t getMaxResendCount() const;
+
+    virtual QueuePriority getQueuePriority() const { return QueuePriority::Control; }
 };
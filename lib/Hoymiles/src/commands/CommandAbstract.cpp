@@ -32,6 +32,41 @@ Source Address: 80 12 23 04
 #include "crc.h"
 #include <string.h>
 
+std::shared_ptr<CommandResult> CommandAbstract::getResultToken()
+{
+    if (!_result) {
+        _result = std::make_shared<CommandResult>();
+        _result->submittedAt = _enqueuedAt != 0 ? _enqueuedAt : millis();
+    }
+    return _result;
+}
+
+void CommandAbstract::markEnqueued()
+{
+    _enqueuedAt = millis();
+    if (_result) {
+        _result->submittedAt = _enqueuedAt;
+    }
+}
+
+void CommandAbstract::markCompleted(const LastCommandSuccess status)
+{
+    if (_result && _result->status == CMD_PENDING) {
+        _result->status = status;
+        _result->completedAt = millis();
+    }
+
+    if (_onCompleted && !_completionNotified) {
+        _completionNotified = true;
+        _onCompleted(*this, status);
+    }
+}
+
+void CommandAbstract::setCompletionCallback(std::function<void(CommandAbstract&, const LastCommandSuccess)> callback)
+{
+    _onCompleted = std::move(callback);
+}
+
 CommandAbstract::CommandAbstract(InverterAbstract* inv, const uint64_t router_address)
 {
     memset(_payload, 0, RF_LEN);
@@ -47,7 +82,10 @@ CommandAbstract::CommandAbstract(InverterAbstract* inv, const uint64_t router_ad
 
 const uint8_t* CommandAbstract::getDataPayload()
 {
-    _payload[_payload_size] = crc8(_payload, _payload_size);
+    if (!_payloadCrcValid) {
+        _payload[_payload_size] = crc8(_payload, _payload_size);
+        _payloadCrcValid = true;
+    }
     return _payload;
 }
 
@@ -66,6 +104,7 @@ void CommandAbstract::setTargetAddress(const uint64_t address)
 {
     convertSerialToPacketId(&_payload[1], address);
     _targetAddress = address;
+    markPayloadDirty();
 }
 uint64_t CommandAbstract::getTargetAddress() const
 {
@@ -74,8 +113,14 @@ uint64_t CommandAbstract::getTargetAddress() const
 
 void CommandAbstract::setRouterAddress(const uint64_t address)
 {
+    if (address == _routerAddress) {
+        // Hot TX path: the router address is set on every transmission
+        // but practically never changes, keep the cached frame valid.
+        return;
+    }
     convertSerialToPacketId(&_payload[5], address);
     _routerAddress = address;
+    markPayloadDirty();
 }
 
 uint64_t CommandAbstract::getRouterAddress() const
@@ -123,6 +168,11 @@ void CommandAbstract::convertSerialToPacketId(uint8_t buffer[], const uint64_t s
     buffer[0] = s.b[3];
 }
 
+void CommandAbstract::markPayloadDirty()
+{
+    _payloadCrcValid = false;
+}
+
 void CommandAbstract::gotTimeout()
 {
 }
@@ -1,10 +1,13 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "../parser/Parser.h"
 #include "types.h"
 #include <Stream.h>
 #include <WString.h>
 #include <cstdint>
+#include <functional>
+#include <memory>
 
 #define RF_LEN 32
 #define MAX_RESEND_COUNT 4 // Used if all packages are missing
@@ -12,6 +15,28 @@
 
 class InverterAbstract;
 
+// Completion token shared between a command submitter and the radio.
+// The radio stamps status and completion time when the exchange leaves
+// the queue; the submitter polls the token without touching the queue.
+// Latency is end-to-end: queue insertion to completion, including
+// queueing delay and all retransmits.
+struct CommandResult {
+    LastCommandSuccess status = CMD_PENDING;
+    uint32_t submittedAt = 0;
+    uint32_t completedAt = 0;
+
+    // Only meaningful once status is no longer CMD_PENDING
+    uint32_t latencyMs() const { return completedAt - submittedAt; }
+};
+
+// Priority lane of a command in the command queue. Lower value means
+// higher priority; commands of a higher priority lane are drained first.
+enum class QueuePriority {
+    Control,
+    Alarm,
+    Statistics,
+};
+
 enum class QueueInsertType {
     AllowMultiple,
     // Remove from  beginning of the queue
@@ -27,7 +52,24 @@ enum class QueueInsertType {
 class CommandAbstract {
 public:
     explicit CommandAbstract(InverterAbstract* inv, const uint64_t router_address = 0);
-    virtual ~CommandAbstract() { };
+    // A command destroyed while still pending (dropped as duplicate,
+    // replaced in the queue, or removed with its inverter) fails its
+    // token so no observer waits forever
+    virtual ~CommandAbstract() { markCompleted(CMD_NOK); };
+
+    // Returns the shared completion token, creating it on first use -
+    // commands without an observer pay nothing
+    std::shared_ptr<CommandResult> getResultToken();
+    void markEnqueued();
+    void markCompleted(const LastCommandSuccess status);
+
+    // Invoked exactly once when the command leaves the queue, right at
+    // the completion event: on the radio loop task when the exchange
+    // finishes, or from the destructor when a still pending command is
+    // dropped (deduplicated, replaced or removed with its inverter).
+    // In the destructor case only the CommandAbstract part of the
+    // command is still alive. The callback may enqueue new commands.
+    void setCompletionCallback(std::function<void(CommandAbstract&, const LastCommandSuccess)> callback);
 
     const uint8_t* getDataPayload();
     String dumpDataPayload();
@@ -61,20 +103,38 @@ public:
 
     // Returns whether multiple instances of this command are allowed in the command queue.
     virtual QueueInsertType getQueueInsertType() const { return QueueInsertType::RemoveNewest; }
+
+    // Returns the priority lane used when inserting the command into the queue.
+    virtual QueuePriority getQueuePriority() const { return QueuePriority::Statistics; }
     virtual bool areSameParameter(CommandAbstract* other);
 
 protected:
+    // Invalidates the cached frame CRC. Has to be called whenever payload
+    // bytes were modified outside of this base class.
+    void markPayloadDirty();
+
     uint8_t _payload[RF_LEN];
     uint8_t _payload_size;
     uint32_t _timeout;
     uint8_t _sendCount;
 
-    uint64_t _targetAddress;
-    uint64_t _routerAddress;
+    uint64_t _targetAddress = 0;
+    uint64_t _routerAddress = 0;
 
     InverterAbstract* _inv;
 
 private:
     void setTargetAddress(const uint64_t address);
     static void convertSerialToPacketId(uint8_t buffer[], const uint64_t serial);
+
+    // The assembled frame is immutable between sends. Only the CRC is
+    // patched in place once after a payload modification and the result
+    // is reused for every (re-)transmission.
+    bool _payloadCrcValid = false;
+
+    std::shared_ptr<CommandResult> _result;
+    uint32_t _enqueuedAt = 0;
+
+    std::function<void(CommandAbstract&, const LastCommandSuccess)> _onCompleted;
+    bool _completionNotified = false;
 };
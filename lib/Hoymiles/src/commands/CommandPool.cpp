@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "CommandPool.h"
+#include "../HoymilesLogLevel.h"
+#include <cstdlib>
+
+#undef TAG
+static const char* TAG = "hoymiles";
+
+CommandPool HoyCommandPool;
+
+CommandPool::CommandPool()
+{
+    for (uint32_t i = 0; i < HOY_COMMAND_POOL_SLOT_COUNT; i++) {
+        _freeStack[i] = i;
+    }
+    _freeCount = HOY_COMMAND_POOL_SLOT_COUNT;
+}
+
+bool CommandPool::ownsPointer(const void* ptr) const
+{
+    return ptr >= &_slots[0] && ptr < &_slots[HOY_COMMAND_POOL_SLOT_COUNT];
+}
+
+void* CommandPool::allocate(const size_t size)
+{
+    if (size <= HOY_COMMAND_POOL_SLOT_SIZE) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_freeCount > 0) {
+            return _slots[_freeStack[--_freeCount]].data;
+        }
+    }
+
+    // Pool exhausted or an unusually large command; both are legal but
+    // worth noticing when sizing the pool
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _heapFallbacks++;
+    }
+    ESP_LOGD(TAG, "Command pool fallback to heap (size %u)", static_cast<unsigned>(size));
+    return malloc(size);
+}
+
+void CommandPool::deallocate(void* ptr)
+{
+    if (!ownsPointer(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _freeStack[_freeCount++] = (static_cast<Slot*>(ptr) - &_slots[0]);
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Commands queued by the 24/7 polling loop are short-lived small
+// objects; allocating each one on the heap churns the allocator and
+// fragments it over weeks of uptime. This fixed-slot pool backs the
+// std::shared_ptr handed out by HoymilesRadio::prepareCommand() via
+// std::allocate_shared, so command object and control block land
+// together in one preallocated slot and steady-state polling performs
+// no dynamic allocation. Oversized or overflowing requests fall back
+// to the heap transparently.
+
+// Covers every command type plus the shared_ptr control block
+#ifndef HOY_COMMAND_POOL_SLOT_SIZE
+#define HOY_COMMAND_POOL_SLOT_SIZE 192
+#endif
+
+#ifndef HOY_COMMAND_POOL_SLOT_COUNT
+#define HOY_COMMAND_POOL_SLOT_COUNT 32
+#endif
+
+class CommandPool {
+public:
+    CommandPool();
+
+    // Thread-safe; commands are enqueued from the application tasks
+    // and released from the radio loop tasks
+    void* allocate(const size_t size);
+    void deallocate(void* ptr);
+
+    uint32_t getUsedSlots() const { return HOY_COMMAND_POOL_SLOT_COUNT - _freeCount; }
+    uint32_t getHeapFallbacks() const { return _heapFallbacks; }
+
+private:
+    bool ownsPointer(const void* ptr) const;
+
+    struct Slot {
+        alignas(alignof(max_align_t)) uint8_t data[HOY_COMMAND_POOL_SLOT_SIZE];
+    };
+
+    Slot _slots[HOY_COMMAND_POOL_SLOT_COUNT];
+    uint8_t _freeStack[HOY_COMMAND_POOL_SLOT_COUNT];
+    uint32_t _freeCount;
+    uint32_t _heapFallbacks = 0;
+
+    mutable std::mutex _mutex;
+};
+
+extern CommandPool HoyCommandPool;
+
+// Minimal allocator adapter for std::allocate_shared
+template <typename T>
+struct CommandPoolAllocator {
+    using value_type = T;
+
+    CommandPoolAllocator() = default;
+
+    template <typename U>
+    CommandPoolAllocator(const CommandPoolAllocator<U>&) { }
+
+    T* allocate(const size_t n)
+    {
+        return static_cast<T*>(HoyCommandPool.allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        HoyCommandPool.deallocate(ptr);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CommandPoolAllocator<T>&, const CommandPoolAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const CommandPoolAllocator<T>&, const CommandPoolAllocator<U>&) { return false; }
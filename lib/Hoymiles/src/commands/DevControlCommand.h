@@ -9,6 +9,8 @@ public:
 
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
 
+    virtual QueuePriority getQueuePriority() const { return QueuePriority::Control; }
+
 protected:
     void udpateCRC(const uint8_t len);
 };
@@ -114,6 +114,7 @@ void MultiDataCommand::udpateCRC()
     const uint16_t crc = crc16(&_payload[10], 14); // From data_type till password
     _payload[24] = static_cast<uint8_t>(crc >> 8);
     _payload[25] = static_cast<uint8_t>(crc);
+    markPayloadDirty();
 }
 
 uint8_t MultiDataCommand::getTotalFragmentSize(const fragment_t fragment[], const uint8_t max_fragment_id)
@@ -40,6 +40,7 @@ String RequestFrameCommand::getCommandName() const
 void RequestFrameCommand::setFrameNo(const uint8_t frame_no)
 {
     _payload[9] = frame_no | 0x80;
+    markPayloadDirty();
 }
 
 uint8_t RequestFrameCommand::getFrameNo() const
@@ -20,7 +20,7 @@ ID   Target Addr   Source Addr   Idx  DT   ?    Time          Gap             Pa
 */
 #include "SystemConfigParaCommand.h"
 #include "inverters/InverterAbstract.h"
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
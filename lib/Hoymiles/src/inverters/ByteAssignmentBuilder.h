@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "../parser/StatisticsParser.h"
+#include <array>
+#include <cstddef>
+
+// Constexpr builders for the per-model byteAssign_t tables. The
+// statistics payload of every model is composed of the same repeating
+// sections - a 6-row block per DC channel, one AC block and the
+// inverter status/totals block - which only differ in their byte
+// offsets. The model classes compose their table from these builders
+// instead of spelling out every near-identical row, so the tables stay
+// in flash (constexpr std::array), adding a model is a handful of
+// offsets, and a field-descriptor fix lands in all models at once.
+namespace ByteAssignment {
+
+template <typename T, std::size_t N1, std::size_t N2>
+constexpr std::array<T, N1 + N2> concat(const std::array<T, N1>& a, const std::array<T, N2>& b)
+{
+    std::array<T, N1 + N2> out {};
+    for (std::size_t i = 0; i < N1; i++) {
+        out[i] = a[i];
+    }
+    for (std::size_t i = 0; i < N2; i++) {
+        out[N1 + i] = b[i];
+    }
+    return out;
+}
+
+template <typename T, std::size_t N1, std::size_t N2, typename... Tail>
+constexpr auto concat(const std::array<T, N1>& a, const std::array<T, N2>& b, const Tail&... tail)
+{
+    return concat(concat(a, b), tail...);
+}
+
+// One DC channel: voltage, current, power, daily/total yield and the
+// calculated irradiation
+constexpr std::array<byteAssign_t, 6> dcChannel(const ChannelNum_t ch, const uint8_t udc, const uint8_t idc, const uint8_t pdc, const uint8_t yd, const uint8_t yt)
+{
+    return { {
+        { TYPE_DC, ch, FLD_UDC, UNIT_V, udc, 2, 10, false, 1 },
+        { TYPE_DC, ch, FLD_IDC, UNIT_A, idc, 2, 100, false, 2 },
+        { TYPE_DC, ch, FLD_PDC, UNIT_W, pdc, 2, 10, false, 1 },
+        { TYPE_DC, ch, FLD_YD, UNIT_WH, yd, 2, 1, false, 0 },
+        { TYPE_DC, ch, FLD_YT, UNIT_KWH, yt, 4, 1000, false, 3 },
+        { TYPE_DC, ch, FLD_IRR, UNIT_PCT, CALC_CH_IRR, static_cast<uint8_t>(ch), CMD_CALC, false, 3 },
+    } };
+}
+
+// DC channel whose voltage is not part of the payload but mirrored
+// from a paired channel (HM-4CH strings share an input per pair)
+constexpr std::array<byteAssign_t, 6> dcChannelSharedU(const ChannelNum_t ch, const ChannelNum_t uSource, const uint8_t idc, const uint8_t pdc, const uint8_t yd, const uint8_t yt)
+{
+    return { {
+        { TYPE_DC, ch, FLD_UDC, UNIT_V, CALC_CH_UDC, static_cast<uint8_t>(uSource), CMD_CALC, false, 1 },
+        { TYPE_DC, ch, FLD_IDC, UNIT_A, idc, 2, 100, false, 2 },
+        { TYPE_DC, ch, FLD_PDC, UNIT_W, pdc, 2, 10, false, 1 },
+        { TYPE_DC, ch, FLD_YD, UNIT_WH, yd, 2, 1, false, 0 },
+        { TYPE_DC, ch, FLD_YT, UNIT_KWH, yt, 4, 1000, false, 3 },
+        { TYPE_DC, ch, FLD_IRR, UNIT_PCT, CALC_CH_IRR, static_cast<uint8_t>(ch), CMD_CALC, false, 3 },
+    } };
+}
+
+// Single-phase AC block: UAC at base, F at +2, PAC at +4, reactive
+// power at q, IAC at +8, power factor at +10
+constexpr std::array<byteAssign_t, 6> acSinglePhase(const uint8_t base, const uint8_t q)
+{
+    return { {
+        { TYPE_AC, CH0, FLD_UAC, UNIT_V, base, 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_IAC, UNIT_A, static_cast<uint8_t>(base + 8), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_PAC, UNIT_W, static_cast<uint8_t>(base + 4), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_Q, UNIT_VAR, q, 2, 10, true, 1 },
+        { TYPE_AC, CH0, FLD_F, UNIT_HZ, static_cast<uint8_t>(base + 2), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_PF, UNIT_NONE, static_cast<uint8_t>(base + 10), 2, 1000, false, 3 },
+    } };
+}
+
+constexpr std::array<byteAssign_t, 6> acSinglePhase(const uint8_t base)
+{
+    return acSinglePhase(base, static_cast<uint8_t>(base + 6));
+}
+
+// Three-phase AC block (HMT family). FLD_UAC/FLD_IAC are kept as
+// aggregate placeholders so single-phase consumers keep working: UAC
+// mirrors the Ph1-Ph2 offset and IAC either mirrors phase 1 or is
+// calculated as the phase total.
+constexpr std::array<byteAssign_t, 15> acThreePhase(const uint8_t base, const bool iacFromCalc)
+{
+    std::array<byteAssign_t, 15> rows = { {
+        { TYPE_AC, CH0, FLD_UAC, UNIT_V, static_cast<uint8_t>(base + 6), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_1N, UNIT_V, base, 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_2N, UNIT_V, static_cast<uint8_t>(base + 2), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_3N, UNIT_V, static_cast<uint8_t>(base + 4), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_12, UNIT_V, static_cast<uint8_t>(base + 6), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_23, UNIT_V, static_cast<uint8_t>(base + 8), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_UAC_31, UNIT_V, static_cast<uint8_t>(base + 10), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_F, UNIT_HZ, static_cast<uint8_t>(base + 12), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_PAC, UNIT_W, static_cast<uint8_t>(base + 14), 2, 10, false, 1 },
+        { TYPE_AC, CH0, FLD_Q, UNIT_VAR, static_cast<uint8_t>(base + 16), 2, 10, true, 1 },
+        { TYPE_AC, CH0, FLD_IAC, UNIT_A, static_cast<uint8_t>(base + 18), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_IAC_1, UNIT_A, static_cast<uint8_t>(base + 18), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_IAC_2, UNIT_A, static_cast<uint8_t>(base + 20), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_IAC_3, UNIT_A, static_cast<uint8_t>(base + 22), 2, 100, false, 2 },
+        { TYPE_AC, CH0, FLD_PF, UNIT_NONE, static_cast<uint8_t>(base + 24), 2, 1000, false, 3 },
+    } };
+    if (iacFromCalc) {
+        rows[10] = { TYPE_AC, CH0, FLD_IAC, UNIT_A, CALC_TOTAL_IAC, 0, CMD_CALC, false, 2 };
+    }
+    return rows;
+}
+
+// Inverter status (temperature, event log counter) plus the four
+// calculated fleet totals shared verbatim by every model
+constexpr std::array<byteAssign_t, 6> invSection(const uint8_t temp, const uint8_t evtLog)
+{
+    return { {
+        { TYPE_INV, CH0, FLD_T, UNIT_C, temp, 2, 10, true, 1 },
+        { TYPE_INV, CH0, FLD_EVT_LOG, UNIT_NONE, evtLog, 2, 1, false, 0 },
+        { TYPE_INV, CH0, FLD_YD, UNIT_WH, CALC_TOTAL_YD, 0, CMD_CALC, false, 0 },
+        { TYPE_INV, CH0, FLD_YT, UNIT_KWH, CALC_TOTAL_YT, 0, CMD_CALC, false, 3 },
+        { TYPE_INV, CH0, FLD_PDC, UNIT_W, CALC_TOTAL_PDC, 0, CMD_CALC, false, 1 },
+        { TYPE_INV, CH0, FLD_EFF, UNIT_PCT, CALC_TOTAL_EFF, 0, CMD_CALC, false, 3 },
+    } };
+}
+
+constexpr std::array<byteAssign_t, 6> invSection(const uint8_t temp)
+{
+    return invSection(temp, static_cast<uint8_t>(temp + 2));
+}
+
+} // namespace ByteAssignment
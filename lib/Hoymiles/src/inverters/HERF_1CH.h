@@ -7,7 +7,7 @@ class HERF_1CH : public HM_Abstract {
 public:
     explicit HERF_1CH(HoymilesRadio* radio, const uint64_t serial);
     static bool isValidSerial(const uint64_t serial);
-    String typeName() const;
+    const char* typeName() const;
     const byteAssign_t* getByteAssignment() const;
     uint8_t getByteAssignmentSize() const;
 };
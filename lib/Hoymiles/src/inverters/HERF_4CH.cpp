@@ -7,6 +7,7 @@
 HERF_4CH::HERF_4CH(HoymilesRadio* radio, const uint64_t serial)
     : HM_4CH(radio, serial)
 {
+    _traits.dcChannelCount = 4;
 }
 
 bool HERF_4CH::isValidSerial(const uint64_t serial)
@@ -16,7 +17,7 @@ bool HERF_4CH::isValidSerial(const uint64_t serial)
     return preSerial == 0x2801;
 }
 
-String HERF_4CH::typeName() const
+const char* HERF_4CH::typeName() const
 {
     return "HERF-1600/1800-4T";
 }
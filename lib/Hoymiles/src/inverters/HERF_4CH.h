@@ -7,5 +7,5 @@ class HERF_4CH : public HM_4CH {
 public:
     explicit HERF_4CH(HoymilesRadio* radio, const uint64_t serial);
     static bool isValidSerial(const uint64_t serial);
-    String typeName() const;
+    const char* typeName() const;
 };
@@ -3,41 +3,18 @@
  * Copyright (C) 2023-2024 Thomas Basler and others
  */
 #include "HMS_2CH.h"
+#include "ByteAssignmentBuilder.h"
 
-static const byteAssign_t byteAssignment[] = {
-    { TYPE_DC, CH0, FLD_UDC, UNIT_V, 2, 2, 10, false, 1 },
-    { TYPE_DC, CH0, FLD_IDC, UNIT_A, 6, 2, 100, false, 2 },
-    { TYPE_DC, CH0, FLD_PDC, UNIT_W, 10, 2, 10, false, 1 },
-    { TYPE_DC, CH0, FLD_YT, UNIT_KWH, 14, 4, 1000, false, 3 },
-    { TYPE_DC, CH0, FLD_YD, UNIT_WH, 22, 2, 1, false, 0 },
-    { TYPE_DC, CH0, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH0, CMD_CALC, false, 3 },
-
-    { TYPE_DC, CH1, FLD_UDC, UNIT_V, 4, 2, 10, false, 1 },
-    { TYPE_DC, CH1, FLD_IDC, UNIT_A, 8, 2, 100, false, 2 },
-    { TYPE_DC, CH1, FLD_PDC, UNIT_W, 12, 2, 10, false, 1 },
-    { TYPE_DC, CH1, FLD_YT, UNIT_KWH, 18, 4, 1000, false, 3 },
-    { TYPE_DC, CH1, FLD_YD, UNIT_WH, 24, 2, 1, false, 0 },
-    { TYPE_DC, CH1, FLD_IRR, UNIT_PCT, CALC_CH_IRR, CH1, CMD_CALC, false, 3 },
-
-    { TYPE_AC, CH0, FLD_UAC, UNIT_V, 26, 2, 10, false, 1 },
-    { TYPE_AC, CH0, FLD_IAC, UNIT_A, 34, 2, 100, false, 2 },
-    { TYPE_AC, CH0, FLD_PAC, UNIT_W, 30, 2, 10, false, 1 },
-    { TYPE_AC, CH0, FLD_Q, UNIT_VAR, 32, 2, 10, true, 1 },
-    { TYPE_AC, CH0, FLD_F, UNIT_HZ, 28, 2, 100, false, 2 },
-    { TYPE_AC, CH0, FLD_PF, UNIT_NONE, 36, 2, 1000, false, 3 },
-
-    { TYPE_INV, CH0, FLD_T, UNIT_C, 38, 2, 10, true, 1 },
-    { TYPE_INV, CH0, FLD_EVT_LOG, UNIT_NONE, 40, 2, 1, false, 0 },
-
-    { TYPE_INV, CH0, FLD_YD, UNIT_WH, CALC_TOTAL_YD, 0, CMD_CALC, false, 0 },
-    { TYPE_INV, CH0, FLD_YT, UNIT_KWH, CALC_TOTAL_YT, 0, CMD_CALC, false, 3 },
-    { TYPE_INV, CH0, FLD_PDC, UNIT_W, CALC_TOTAL_PDC, 0, CMD_CALC, false, 1 },
-    { TYPE_INV, CH0, FLD_EFF, UNIT_PCT, CALC_TOTAL_EFF, 0, CMD_CALC, false, 3 }
-};
+static constexpr auto byteAssignment = ByteAssignment::concat(
+    ByteAssignment::dcChannel(CH0, 2, 6, 10, 22, 14),
+    ByteAssignment::dcChannel(CH1, 4, 8, 12, 24, 18),
+    ByteAssignment::acSinglePhase(26),
+    ByteAssignment::invSection(38));
 
 HMS_2CH::HMS_2CH(HoymilesRadio* radio, const uint64_t serial)
     : HMS_Abstract(radio, serial)
 {
+    _traits.dcChannelCount = 2;
 }
 
 bool HMS_2CH::isValidSerial(const uint64_t serial)
@@ -47,17 +24,17 @@ bool HMS_2CH::isValidSerial(const uint64_t serial)
     return preSerial == 0x1144 || preSerial == 0x1143 || preSerial == 0x1410;
 }
 
-String HMS_2CH::typeName() const
+const char* HMS_2CH::typeName() const
 {
     return "HMS-600/700/800/900/1000-2T";
 }
 
 const byteAssign_t* HMS_2CH::getByteAssignment() const
 {
-    return byteAssignment;
+    return byteAssignment.data();
 }
 
 uint8_t HMS_2CH::getByteAssignmentSize() const
 {
-    return sizeof(byteAssignment) / sizeof(byteAssignment[0]);
+    return byteAssignment.size();
 }
@@ -7,8 +7,7 @@ class HMS_4CH : public HMS_Abstract {
 public:
     explicit HMS_4CH(HoymilesRadio* radio, const uint64_t serial);
     static bool isValidSerial(const uint64_t serial);
-    String typeName() const;
+    const char* typeName() const;
     const byteAssign_t* getByteAssignment() const;
     uint8_t getByteAssignmentSize() const;
-    bool supportsPowerDistributionLogic() final;
 };
@@ -7,7 +7,7 @@ class HMT_4CH : public HMT_Abstract {
 public:
     explicit HMT_4CH(HoymilesRadio* radio, const uint64_t serial);
     static bool isValidSerial(const uint64_t serial);
-    String typeName() const;
+    const char* typeName() const;
     const byteAssign_t* getByteAssignment() const;
     uint8_t getByteAssignmentSize() const;
 };
\ No newline at end of file
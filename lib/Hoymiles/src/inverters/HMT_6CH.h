@@ -7,7 +7,7 @@ class HMT_6CH : public HMT_Abstract {
 public:
     explicit HMT_6CH(HoymilesRadio* radio, const uint64_t serial);
     static bool isValidSerial(const uint64_t serial);
-    String typeName() const;
+    const char* typeName() const;
     const byteAssign_t* getByteAssignment() const;
     uint8_t getByteAssignmentSize() const;
 };
\ No newline at end of file
@@ -12,6 +12,7 @@ HMT_Abstract::HMT_Abstract(HoymilesRadio* radio, const uint64_t serial)
     : HM_Abstract(radio, serial)
 {
     EventLog()->setMessageType(AlarmMessageType_t::HMT);
+    _traits.multiPhase = true;
 }
 
 bool HMT_Abstract::sendChangeChannelRequest()
@@ -111,10 +111,38 @@ bool HM_Abstract::sendActivePowerControlRequest(float limit, const PowerLimitCon
     _activePowerControlLimit = limit;
     _activePowerControlType = type;
 
-    auto cmd = _radio->prepareCommand<ActivePowerControlCommand>(this);
-    cmd->setActivePowerLimit(limit, type);
-    SystemConfigPara()->setLastLimitCommandSuccess(CMD_PENDING);
-    _radio->enqueCommand(cmd);
+    // A newer limit supersedes a sequence that is still in flight
+    if (_powerLimitSequence) {
+        _powerLimitSequence->cancel();
+    }
+    _powerLimitSequence = CommandSequence::create(_radio);
+
+    // Step 1: the limit set itself. The radio already resends missing
+    // frames within one exchange; the sequence retry covers a fully
+    // failed exchange and fires right at its completion event instead
+    // of the next pass of the poll loop.
+    _powerLimitSequence->addStep([this, limit, type]() {
+        auto cmd = _radio->prepareCommand<ActivePowerControlCommand>(this);
+        cmd->setActivePowerLimit(limit, type);
+        SystemConfigPara()->setLastLimitCommandSuccess(CMD_PENDING);
+        _lastControlCommandResult = cmd->getResultToken();
+        return cmd;
+    }, 1);
+
+    // Step 2: read the limit back so SystemConfigPara reflects what the
+    // inverter actually applied, without waiting for the next periodic
+    // config poll
+    _powerLimitSequence->addStep([this]() {
+        time_t now;
+        time(&now);
+
+        auto cmd = _radio->prepareCommand<SystemConfigParaCommand>(this);
+        cmd->setTime(now);
+        SystemConfigPara()->setLastLimitRequestSuccess(CMD_PENDING);
+        return cmd;
+    }, 1);
+
+    _powerLimitSequence->start();
 
     return true;
 }
@@ -140,6 +168,7 @@ bool HM_Abstract::sendPowerControlRequest(const bool turnOn)
     cmd->setPowerOn(turnOn);
     PowerCommand()->setLastPowerCommandSuccess(CMD_PENDING);
     _radio->enqueCommand(cmd);
+    _lastControlCommandResult = cmd->getResultToken();
 
     return true;
 }
@@ -156,6 +185,7 @@ bool HM_Abstract::sendRestartControlRequest()
     cmd->setRestart();
     PowerCommand()->setLastPowerCommandSuccess(CMD_PENDING);
     _radio->enqueCommand(cmd);
+    _lastControlCommandResult = cmd->getResultToken();
 
     return true;
 }
@@ -195,7 +225,10 @@ bool HM_Abstract::sendGridOnProFileParaRequest()
     return true;
 }
 
-bool HM_Abstract::supportsPowerDistributionLogic()
+void HM_Abstract::cancelPendingSequences()
 {
-    return false;
+    if (_powerLimitSequence) {
+        _powerLimitSequence->cancel();
+        _powerLimitSequence = nullptr;
+    }
 }
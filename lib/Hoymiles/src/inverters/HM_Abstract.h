@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "../CommandSequence.h"
 #include "InverterAbstract.h"
 
 class HM_Abstract : public InverterAbstract {
@@ -16,7 +17,8 @@ public:
     bool sendRestartControlRequest();
     bool resendPowerControlRequest();
     bool sendGridOnProFileParaRequest();
-    bool supportsPowerDistributionLogic() override;
+
+    void cancelPendingSequences() override;
 
 private:
     uint8_t _lastAlarmLogCnt = 0;
@@ -24,4 +26,8 @@ private:
     PowerLimitControlType _activePowerControlType = PowerLimitControlType::AbsolutNonPersistent;
 
     uint8_t _powerState = 1;
+
+    // Set limit plus read-back verification, see
+    // sendActivePowerControlRequest()
+    std::shared_ptr<CommandSequence> _powerLimitSequence;
 };
@@ -3,9 +3,11 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "InverterAbstract.h"
+#include "../EventCounters.h"
 #include "crc.h"
+#include <algorithm>
 #include <cstring>
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -27,6 +29,31 @@ InverterAbstract::InverterAbstract(HoymilesRadio* radio, const uint64_t serial)
     _powerCommandParser.reset(new PowerCommandParser());
     _statisticsParser.reset(new StatisticsParser());
     _systemConfigParaParser.reset(new SystemConfigParaParser());
+
+    _statisticsParser->setUpdateCallback([this]() {
+        updateActivity();
+        for (auto& listener : _statisticsUpdateListeners) {
+            listener(*this);
+        }
+    });
+    _alarmLogParser->setUpdateCallback([this]() {
+        for (auto& listener : _alarmLogUpdateListeners) {
+            listener(*this);
+        }
+    });
+}
+
+std::vector<std::function<void(InverterAbstract&)>> InverterAbstract::_statisticsUpdateListeners;
+std::vector<std::function<void(InverterAbstract&)>> InverterAbstract::_alarmLogUpdateListeners;
+
+void InverterAbstract::onStatisticsUpdated(std::function<void(InverterAbstract&)> listener)
+{
+    _statisticsUpdateListeners.push_back(std::move(listener));
+}
+
+void InverterAbstract::onAlarmLogUpdated(std::function<void(InverterAbstract&)> listener)
+{
+    _alarmLogUpdateListeners.push_back(std::move(listener));
 }
 
 void InverterAbstract::init()
@@ -83,6 +110,7 @@ bool InverterAbstract::isReachable()
 void InverterAbstract::setEnablePolling(const bool enabled)
 {
     _enablePolling = enabled;
+    Statistics()->setFleetRowPollEnabled(enabled);
 }
 
 bool InverterAbstract::getEnablePolling() const
@@ -145,11 +173,120 @@ int8_t InverterAbstract::getLastRssi() const
     return _lastRssi;
 }
 
+float InverterAbstract::getRssiEwma() const
+{
+    return _rssiEwma;
+}
+
+float InverterAbstract::getLossRateEwma() const
+{
+    return _lossRateEwma;
+}
+
+uint8_t InverterAbstract::getScaledRetransmitCount(const CommandAbstract& cmd) const
+{
+    // Weak links get a reduced retransmit budget so a single bad inverter
+    // does not hold the queue and delay the rest of the fleet.
+    const uint8_t max = cmd.getMaxRetransmitCount();
+    if (_lossRateEwma > 0.5f) {
+        return std::max<uint8_t>(1, max / 2);
+    }
+    return max;
+}
+
+uint32_t InverterAbstract::getScaledTimeout(const CommandAbstract& cmd) const
+{
+    // Strong links answer quickly, so the RX window can be shortened and
+    // the next exchange starts earlier. Weak links keep the full timeout.
+    const uint32_t timeout = cmd.getTimeout();
+    if (_rssiEwma > -60 && _lossRateEwma < 0.1f) {
+        return (timeout * 3) / 4;
+    }
+    return timeout;
+}
+
+void InverterAbstract::updateExchangeResult(const bool success)
+{
+    _lossRateEwma += 0.125f * ((success ? 0.0f : 1.0f) - _lossRateEwma);
+
+    if (_exchangeStartMs != 0) {
+        const uint32_t duration = millis() - _exchangeStartMs;
+        if (_exchangeDurationEwma == 0) {
+            _exchangeDurationEwma = duration;
+        } else {
+            _exchangeDurationEwma += 0.125f * (duration - _exchangeDurationEwma);
+        }
+        _exchangeStartMs = 0;
+    }
+}
+
+void InverterAbstract::noteExchangeStart()
+{
+    _exchangeStartMs = millis();
+}
+
+float InverterAbstract::getExchangeDurationEwma() const
+{
+    return _exchangeDurationEwma;
+}
+
+float InverterAbstract::getRssiTrend() const
+{
+    return _rssiEwma - _rssiEwmaSlow;
+}
+
+void InverterAbstract::updateActivity()
+{
+    const float power = _statisticsParser->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+    if (_lastActivityPower >= 0) {
+        // Relative change, floored at 10 W so idling around zero output
+        // does not read as activity
+        const float reference = std::max(std::max(power, _lastActivityPower), 10.0f);
+        const float change = fabsf(power - _lastActivityPower) / reference;
+        _activityEwma += 0.25f * (change - _activityEwma);
+    }
+    _lastActivityPower = power;
+}
+
+float InverterAbstract::getActivityEwma() const
+{
+    return _activityEwma;
+}
+
+uint32_t InverterAbstract::getScaledPollInterval(const uint32_t intervalMs) const
+{
+    // More than 5% change per update means a ramp is in progress; below
+    // 1% the output is effectively static.
+    if (_activityEwma > 0.05f) {
+        return intervalMs;
+    }
+    if (_activityEwma > 0.01f) {
+        return intervalMs * 2;
+    }
+    return intervalMs * 4;
+}
+
 bool InverterAbstract::sendChangeChannelRequest()
 {
     return false;
 }
 
+std::shared_ptr<CommandResult> InverterAbstract::getLastControlCommandResult() const
+{
+    return _lastControlCommandResult;
+}
+
+const InverterModelTraits_t& InverterAbstract::getTraits() const
+{
+    return _traits;
+}
+
+bool InverterAbstract::supportsPowerDistributionLogic()
+{
+    return _traits.powerDistributionLogic
+        && DevInfo()->getFwBuildVersion() >= _traits.pdlMinFwBuildVersion;
+}
+
 HoymilesRadio* InverterAbstract::getRadio()
 {
     return _radio;
@@ -196,14 +333,18 @@ void InverterAbstract::clearRxFragmentBuffer()
 void InverterAbstract::addRxFragment(const uint8_t fragment[], const uint8_t len, const int8_t rssi)
 {
     _lastRssi = rssi;
+    _rssiEwma += 0.125f * (rssi - _rssiEwma);
+    _rssiEwmaSlow += 0.015625f * (rssi - _rssiEwmaSlow);
 
     if (len < 11) {
         ESP_LOGE(TAG, "(%s, %d) fragment too short", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::FragmentInvalid);
         return;
     }
 
     if (len - 11 > MAX_RF_PAYLOAD_SIZE) {
         ESP_LOGE(TAG, "FATAL: (%s, %d) fragment too large", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::FragmentInvalid);
         return;
     }
 
@@ -214,11 +355,13 @@ void InverterAbstract::addRxFragment(const uint8_t fragment[], const uint8_t len
 
     if (fragmentId == 0) {
         ESP_LOGE(TAG, "Fragment id zero received and ignored");
+        EventCounters.count(EventCountersClass::Counter::FragmentInvalid);
         return;
     }
 
     if (fragmentId >= MAX_RF_FRAGMENT_COUNT) {
         ESP_LOGE(TAG, "Fragment id %" PRIu8 " is too large for buffer and ignored", fragmentId);
+        EventCounters.count(EventCountersClass::Counter::FragmentInvalid);
         return;
     }
 
@@ -254,7 +397,7 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract& cmd)
     // Last fragment is missing (the one with 0x80)
     if (_rxFragmentMaxPacketId == 0) {
         ESP_LOGW(TAG, "Last missing");
-        if (_rxFragmentRetransmitCnt++ < cmd.getMaxRetransmitCount()) {
+        if (_rxFragmentRetransmitCnt++ < getScaledRetransmitCount(cmd)) {
             return _rxFragmentLastPacketId + 1;
         } else {
             cmd.gotTimeout();
@@ -266,7 +409,7 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract& cmd)
     for (uint8_t i = 0; i < _rxFragmentMaxPacketId - 1; i++) {
         if (!_rxFragmentBuffer[i].wasReceived) {
             ESP_LOGW(TAG, "Middle missing");
-            if (_rxFragmentRetransmitCnt++ < cmd.getMaxRetransmitCount()) {
+            if (_rxFragmentRetransmitCnt++ < getScaledRetransmitCount(cmd)) {
                 return i + 1;
             } else {
                 cmd.gotTimeout();
@@ -283,6 +426,27 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract& cmd)
     return FRAGMENT_OK;
 }
 
+uint8_t InverterAbstract::getMissingFragments(uint8_t missing[], const uint8_t maxCount) const
+{
+    if (_rxFragmentLastPacketId == 0) {
+        return 0;
+    }
+
+    // With the end marker seen the sequence length is known; without it
+    // everything up to the highest id seen plus the next one is due
+    const uint8_t highest = _rxFragmentMaxPacketId != 0
+        ? _rxFragmentMaxPacketId
+        : _rxFragmentLastPacketId + 1;
+
+    uint8_t count = 0;
+    for (uint8_t id = 1; id <= highest && id < MAX_RF_FRAGMENT_COUNT && count < maxCount; id++) {
+        if (!_rxFragmentBuffer[id - 1].wasReceived) {
+            missing[count++] = id;
+        }
+    }
+    return count;
+}
+
 void InverterAbstract::performDailyTask()
 {
     // Have to reset the offets first, otherwise it will
@@ -12,7 +12,9 @@
 #include "types.h"
 #include <Arduino.h>
 #include <cstdint>
+#include <functional>
 #include <list>
+#include <vector>
 
 #define MAX_NAME_LENGTH 32
 
@@ -28,6 +30,16 @@ enum {
 
 class CommandAbstract;
 
+// Plain-data capability traits of a model class, filled in once by the
+// concrete model constructors. Fleet iteration code branches on these
+// cached flags instead of dispatching a virtual call per question.
+typedef struct {
+    uint8_t dcChannelCount;
+    bool multiPhase; // three-phase AC output (HMT family)
+    bool powerDistributionLogic; // model implements PDL in firmware
+    uint32_t pdlMinFwBuildVersion; // PDL requires at least this build
+} InverterModelTraits_t;
+
 class InverterAbstract {
 public:
     explicit InverterAbstract(HoymilesRadio* radio, const uint64_t serial);
@@ -36,7 +48,9 @@ public:
     const String& serialString() const;
     void setName(const char* name);
     const char* name() const;
-    virtual String typeName() const = 0;
+    // Returns a string literal; no allocation, callers in per-second
+    // fleet loops wrap it in String only at the web/MQTT boundary
+    virtual const char* typeName() const = 0;
     virtual const byteAssign_t* getByteAssignment() const = 0;
     virtual uint8_t getByteAssignmentSize() const = 0;
 
@@ -63,10 +77,40 @@ public:
 
     int8_t getLastRssi() const;
 
+    // Link quality model: EWMA of RSSI and exchange loss rate. Used to
+    // adapt the per-inverter retransmit budget and RX window so strong
+    // links finish exchanges faster and weak links stop hogging airtime.
+    float getRssiEwma() const;
+    float getLossRateEwma() const;
+    uint8_t getScaledRetransmitCount(const CommandAbstract& cmd) const;
+    uint32_t getScaledTimeout(const CommandAbstract& cmd) const;
+    void updateExchangeResult(const bool success);
+
+    // Health scorecard: exchange duration is measured from TX dispatch
+    // to exchange resolution (success or final timeout) and smoothed
+    // with the same EWMA constant as the loss rate. The RSSI trend is
+    // the fast EWMA minus a slow one; a negative value means the link
+    // has recently degraded.
+    void noteExchangeStart();
+    float getExchangeDurationEwma() const;
+    float getRssiTrend() const;
+
+    // Adaptive polling: an EWMA of the relative AC power change between
+    // consecutive statistics updates tracks how fast values actually
+    // move. Static output (night, clear-sky plateau) stretches the poll
+    // interval up to 4x; fast ramps keep the configured pace.
+    float getActivityEwma() const;
+    uint32_t getScaledPollInterval(const uint32_t intervalMs) const;
+
     void clearRxFragmentBuffer();
     void addRxFragment(const uint8_t fragment[], const uint8_t len, const int8_t rssi);
     uint8_t verifyAllFragments(CommandAbstract& cmd);
 
+    // Fills missing[] with the 1-based ids of all fragments still
+    // outstanding, so the radio can re-request them in one burst
+    // instead of one round trip per missing fragment.
+    uint8_t getMissingFragments(uint8_t missing[], const uint8_t maxCount) const;
+
     void performDailyTask();
 
     void resetRadioStats();
@@ -103,11 +147,34 @@ public:
     virtual bool sendChangeChannelRequest();
     virtual bool sendGridOnProFileParaRequest() = 0;
 
+    // Detaches any command sequences whose step factories reference
+    // this inverter. Must run before the inverter's queued commands are
+    // dropped on removal, so a drop callback cannot enqueue a follow-up
+    // command against an inverter that is about to be destroyed.
+    virtual void cancelPendingSequences() { }
+
+    // Token of the most recently submitted control command (power
+    // limit, power on/off, restart) of this inverter, nullptr until the
+    // first submission. Callers poll it for completion status and the
+    // measured end-to-end actuation latency.
+    std::shared_ptr<CommandResult> getLastControlCommandResult() const;
+
+    const InverterModelTraits_t& getTraits() const;
+
     // This feature will limit the AC output instead of limiting the DC inputs.
-    virtual bool supportsPowerDistributionLogic() = 0;
+    bool supportsPowerDistributionLogic();
 
     HoymilesRadio* getRadio();
 
+    // Observer registration for data availability. Listeners fire from
+    // the parser completion path on the main loop task, right after
+    // fresh data was ingested — consumers run exactly when data arrives
+    // instead of polling getLastUpdate. Keep listeners cheap (typically
+    // Task::forceNextIteration); they are registered once at startup
+    // and cover all inverters, including ones added later.
+    static void onStatisticsUpdated(std::function<void(InverterAbstract&)> listener);
+    static void onAlarmLogUpdated(std::function<void(InverterAbstract&)> listener);
+
     AlarmLogParser* EventLog();
     DevInfoParser* DevInfo();
     GridProfileParser* GridProfile();
@@ -117,6 +184,8 @@ public:
 
 protected:
     HoymilesRadio* _radio;
+    InverterModelTraits_t _traits = {};
+    std::shared_ptr<CommandResult> _lastControlCommandResult;
 
 private:
     serial_u _serial;
@@ -137,6 +206,19 @@ private:
     bool _clearEventlogOnMidnight = false;
 
     int8_t _lastRssi = -127;
+    float _rssiEwma = -80;
+    float _rssiEwmaSlow = -80;
+    float _lossRateEwma = 0;
+
+    uint32_t _exchangeStartMs = 0;
+    float _exchangeDurationEwma = 0;
+
+    void updateActivity();
+    float _activityEwma = 1.0f; // start active so new inverters poll at full rate
+    float _lastActivityPower = -1;
+
+    static std::vector<std::function<void(InverterAbstract&)>> _statisticsUpdateListeners;
+    static std::vector<std::function<void(InverterAbstract&)>> _alarmLogUpdateListeners;
 
     std::unique_ptr<AlarmLogParser> _alarmLogParser;
     std::unique_ptr<DevInfoParser> _devInfoParser;
@@ -23,8 +23,10 @@ Data structure:
 ID   Source Addr   Target Addr   Idx  ?       wcode   ?       Start   End     ?    ?    ?    ?    wcode   CRC8
 */
 #include "AlarmLogParser.h"
+#include "../EventCounters.h"
+#include "../Utils.h"
 #include <cstring>
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -203,24 +205,79 @@ void AlarmLogParser::clearBuffer()
 {
     memset(_payloadAlarmLog, 0, ALARM_LOG_PAYLOAD_SIZE);
     _alarmLogLength = 0;
+    _decodedEntryCount = 0;
 }
 
 void AlarmLogParser::appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len)
 {
     if (offset + len > ALARM_LOG_PAYLOAD_SIZE) {
         ESP_LOGE(TAG, "(%s, %d) stats packet too large for buffer (%d > %d)", __FILE__, __LINE__, offset + len, ALARM_LOG_PAYLOAD_SIZE);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
     memcpy(&_payloadAlarmLog[offset], payload, len);
     _alarmLogLength += len;
 }
 
-uint8_t AlarmLogParser::getEntryCount() const
+// Decodes the raw payload once per received alarm log. Timestamps are
+// resolved (AM/PM indicator, timezone) and the message table is scanned a
+// single time per entry here, so getLogEntry becomes a plain array lookup
+// for the eventlog endpoint and the MQTT publisher.
+void AlarmLogParser::endAppendFragment()
 {
-    if (_alarmLogLength < 2) {
-        return 0;
+    const int timezoneOffset = getTimezoneOffset();
+
+    uint8_t entryCount = 0;
+    if (_alarmLogLength >= 2) {
+        entryCount = (_alarmLogLength - 2) / ALARM_LOG_ENTRY_SIZE;
     }
-    return (_alarmLogLength - 2) / ALARM_LOG_ENTRY_SIZE;
+    if (entryCount > ALARM_LOG_ENTRY_COUNT) {
+        entryCount = ALARM_LOG_ENTRY_COUNT;
+    }
+
+    for (uint8_t entryId = 0; entryId < entryCount; entryId++) {
+        const uint8_t entryStartOffset = 2 + entryId * ALARM_LOG_ENTRY_SIZE;
+        AlarmLogDecodedEntry_t& entry = _decodedEntries[entryId];
+
+        const uint32_t wcode = static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset]) << 8 | _payloadAlarmLog[entryStartOffset + 1];
+        uint32_t startTimeOffset = 0;
+        if (((wcode >> 13) & 0x01) == 1) {
+            startTimeOffset = 12 * 60 * 60;
+        }
+
+        uint32_t endTimeOffset = 0;
+        if (((wcode >> 12) & 0x01) == 1) {
+            endTimeOffset = 12 * 60 * 60;
+        }
+
+        entry.MessageId = _payloadAlarmLog[entryStartOffset + 1];
+        entry.StartTime = ((static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 4]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 5])) + startTimeOffset + timezoneOffset;
+        entry.EndTime = (static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 6]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 7]);
+        if (entry.EndTime > 0) {
+            entry.EndTime += (endTimeOffset + timezoneOffset);
+        }
+
+        entry.Message = nullptr;
+        for (auto& msg : _alarmMessages) {
+            if (msg.MessageId == entry.MessageId) {
+                if (msg.InverterType == _messageType) {
+                    entry.Message = &msg;
+                    break;
+                } else if (msg.InverterType == AlarmMessageType_t::ALL) {
+                    entry.Message = &msg;
+                }
+            }
+        }
+    }
+
+    _decodedEntryCount = entryCount;
+
+    Parser::endAppendFragment();
+}
+
+uint8_t AlarmLogParser::getEntryCount() const
+{
+    return _decodedEntryCount;
 }
 
 void AlarmLogParser::setLastAlarmRequestSuccess(const LastCommandSuccess status)
@@ -240,31 +297,21 @@ void AlarmLogParser::setMessageType(const AlarmMessageType_t type)
 
 void AlarmLogParser::getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry, const AlarmMessageLocale_t locale)
 {
-    const uint8_t entryStartOffset = 2 + entryId * ALARM_LOG_ENTRY_SIZE;
-
-    const int timezoneOffset = getTimezoneOffset();
-
-    HOY_SEMAPHORE_TAKE();
-
-    const uint32_t wcode = static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset]) << 8 | _payloadAlarmLog[entryStartOffset + 1];
-    uint32_t startTimeOffset = 0;
-    if (((wcode >> 13) & 0x01) == 1) {
-        startTimeOffset = 12 * 60 * 60;
-    }
-
-    uint32_t endTimeOffset = 0;
-    if (((wcode >> 12) & 0x01) == 1) {
-        endTimeOffset = 12 * 60 * 60;
+    if (entryId >= _decodedEntryCount) {
+        return;
     }
 
-    entry.MessageId = _payloadAlarmLog[entryStartOffset + 1];
-    entry.StartTime = ((static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 4]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 5])) + startTimeOffset + timezoneOffset;
-    entry.EndTime = (static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 6]) << 8) | static_cast<uint16_t>(_payloadAlarmLog[entryStartOffset + 7]);
-
+    HOY_SEMAPHORE_TAKE();
+    const AlarmLogDecodedEntry_t decoded = _decodedEntries[entryId];
     HOY_SEMAPHORE_GIVE();
 
-    if (entry.EndTime > 0) {
-        entry.EndTime += (endTimeOffset + timezoneOffset);
+    entry.MessageId = decoded.MessageId;
+    entry.StartTime = decoded.StartTime;
+    entry.EndTime = decoded.EndTime;
+
+    if (decoded.Message != nullptr) {
+        entry.Message = getLocaleMessage(decoded.Message, locale);
+        return;
     }
 
     switch (locale) {
@@ -277,17 +324,6 @@ void AlarmLogParser::getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry,
     default:
         entry.Message = "Unknown";
     }
-
-    for (auto& msg : _alarmMessages) {
-        if (msg.MessageId == entry.MessageId) {
-            if (msg.InverterType == _messageType) {
-                entry.Message = getLocaleMessage(&msg, locale);
-                break;
-            } else if (msg.InverterType == AlarmMessageType_t::ALL) {
-                entry.Message = getLocaleMessage(&msg, locale);
-            }
-        }
-    }
 }
 
 String AlarmLogParser::getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale) const
@@ -305,17 +341,7 @@ String AlarmLogParser::getLocaleMessage(const AlarmMessage_t* msg, const AlarmMe
 
 int AlarmLogParser::getTimezoneOffset()
 {
-    // see: https://stackoverflow.com/questions/13804095/get-the-time-zone-gmt-offset-in-c/44063597#44063597
-
-    time_t gmt, rawtime = time(NULL);
-    struct tm* ptm;
-
-    struct tm gbuf;
-    ptm = gmtime_r(&rawtime, &gbuf);
-
-    // Request that mktime() looksup dst in timezone database
-    ptm->tm_isdst = -1;
-    gmt = mktime(ptm);
-
-    return static_cast<int>(difftime(rawtime, gmt));
+    // served from the cached civil-time breakdown instead of running
+    // gmtime_r/mktime for every received alarm log
+    return Utils::getTimezoneOffset();
 }
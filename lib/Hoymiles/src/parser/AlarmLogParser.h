@@ -41,6 +41,7 @@ public:
     AlarmLogParser();
     void clearBuffer();
     void appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len);
+    void endAppendFragment();
 
     uint8_t getEntryCount() const;
     void getLogEntry(const uint8_t entryId, AlarmLogEntry_t& entry, const AlarmMessageLocale_t locale = AlarmMessageLocale_t::EN);
@@ -51,12 +52,25 @@ public:
     void setMessageType(const AlarmMessageType_t type);
 
 private:
+    // Entry decoded once per received payload. The message is stored as a
+    // pointer into the static table so the locale can still be chosen per
+    // request without re-scanning the table.
+    struct AlarmLogDecodedEntry_t {
+        uint16_t MessageId;
+        time_t StartTime;
+        time_t EndTime;
+        const AlarmMessage_t* Message;
+    };
+
     static int getTimezoneOffset();
     String getLocaleMessage(const AlarmMessage_t* msg, const AlarmMessageLocale_t locale) const;
 
     uint8_t _payloadAlarmLog[ALARM_LOG_PAYLOAD_SIZE];
     uint8_t _alarmLogLength = 0;
 
+    std::array<AlarmLogDecodedEntry_t, ALARM_LOG_ENTRY_COUNT> _decodedEntries;
+    uint8_t _decodedEntryCount = 0;
+
     LastCommandSuccess _lastAlarmRequestSuccess = CMD_NOK; // Set to NOK to fetch at startup
 
     AlarmMessageType_t _messageType = AlarmMessageType_t::ALL;
@@ -28,67 +28,74 @@ Data structure (DevInfoSimpleCommand):
 ID   Source Addr   Target Addr   Idx  FW Version  HW Part No.   HW Version   ?       ?       ?       CRC16   CRC8
 */
 #include "DevInfoParser.h"
+#include "../EventCounters.h"
 #include <cstring>
 #include <ctime>
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
+#include <frozen/map.h>
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
-#define ALL 0xff
-
-typedef struct {
-    uint8_t hwPart[4];
+struct devInfo_t {
     uint16_t maxPower;
     const char* modelName;
-} devInfo_t;
-
-const devInfo_t devInfo[] = {
-    { { 0x10, 0x10, 0x10, ALL }, 300, "HM-300-1T" },
-    { { 0x10, 0x10, 0x20, ALL }, 350, "HM-350-1T" },
-    { { 0x10, 0x10, 0x30, ALL }, 400, "HM-400-1T" },
-    { { 0x10, 0x10, 0x40, ALL }, 400, "HM-400-1T" },
-    { { 0x10, 0x11, 0x10, ALL }, 600, "HM-600-2T" },
-    { { 0x10, 0x11, 0x20, ALL }, 700, "HM-700-2T" },
-    { { 0x10, 0x11, 0x30, ALL }, 800, "HM-800-2T" },
-    { { 0x10, 0x11, 0x40, ALL }, 800, "HM-800-2T" },
-    { { 0x10, 0x12, 0x10, ALL }, 1200, "HM-1200-4T" },
-    { { 0x10, 0x02, 0x30, ALL }, 1500, "MI-1500-4T Gen3" },
-    { { 0x10, 0x12, 0x30, ALL }, 1500, "HM-1500-4T" },
-    { { 0x10, 0x10, 0x10, 0x15 }, static_cast<uint16_t>(300 * 0.7), "HM-300-1T" }, // HM-300 factory limitted to 70%
-
-    { { 0x10, 0x20, 0x11, ALL }, 300, "HMS-300-1T" }, // 00
-    { { 0x10, 0x20, 0x21, ALL }, 350, "HMS-350-1T" }, // 00
-    { { 0x10, 0x20, 0x41, ALL }, 400, "HMS-400-1T" }, // 00
-    { { 0x10, 0x10, 0x51, ALL }, 450, "HMS-450-1T" }, // 01
-    { { 0x10, 0x20, 0x51, ALL }, 450, "HMS-450-1T" }, // 03
-    { { 0x10, 0x10, 0x71, ALL }, 500, "HMS-500-1T" }, // 02
-    { { 0x10, 0x20, 0x71, ALL }, 500, "HMS-500-1T v2" }, // 02
-    { { 0x10, 0x21, 0x11, ALL }, 600, "HMS-600-2T" }, // 01
-    { { 0x10, 0x21, 0x21, ALL }, 700, "HMS-700-2T" }, // 00
-    { { 0x10, 0x21, 0x41, ALL }, 800, "HMS-800-2T" }, // 00
-    { { 0x10, 0x11, 0x41, ALL }, 800, "HMS-800-2T-LV" }, // 00
-    { { 0x10, 0x11, 0x51, ALL }, 900, "HMS-900-2T" }, // 01
-    { { 0x10, 0x21, 0x51, ALL }, 900, "HMS-900-2T" }, // 03
-    { { 0x10, 0x21, 0x71, ALL }, 1000, "HMS-1000-2T" }, // 05
-    { { 0x10, 0x11, 0x71, ALL }, 1000, "HMS-1000-2T" }, // 01
-    { { 0x10, 0x22, 0x41, ALL }, 1600, "HMS-1600-4T" }, // 4
-    { { 0x10, 0x12, 0x51, ALL }, 1800, "HMS-1800-4T" }, // 01
-    { { 0x10, 0x22, 0x51, ALL }, 1800, "HMS-1800-4T" }, // 16
-    { { 0x10, 0x12, 0x71, ALL }, 2000, "HMS-2000-4T" }, // 01
-    { { 0x10, 0x22, 0x71, ALL }, 2000, "HMS-2000-4T" }, // 10
-
-    { { 0x10, 0x32, 0x41, ALL }, 1600, "HMT-1600-4T" }, // 00
-    { { 0x10, 0x32, 0x51, ALL }, 1800, "HMT-1800-4T" }, // 00
-    { { 0x10, 0x32, 0x71, ALL }, 2000, "HMT-2000-4T" }, // 0
-
-    { { 0x10, 0x33, 0x11, ALL }, 1800, "HMT-1800-6T" }, // 01
-    { { 0x10, 0x33, 0x31, ALL }, 2250, "HMT-2250-6T" }, // 01
-
-    { { 0xF1, 0x01, 0x10, ALL }, 600, "HERF-600" }, // 00
-    { { 0xF1, 0x01, 0x14, ALL }, 800, "HERF-800" }, // 00
-    { { 0xF1, 0x01, 0x24, ALL }, 1600, "HERF-1600" }, // 00
-    { { 0xF1, 0x01, 0x22, ALL }, 1800, "HERF-1800" }, // 00
+};
+
+// Hardware part numbers keyed by their first three bytes. frozen::map
+// sorts the table at compile time and rejects duplicate keys, lookup is
+// a binary search. Entries matching all four bytes live in the exact
+// map below and take precedence.
+constexpr frozen::map<uint32_t, devInfo_t, 40> devInfoPrefix = {
+    { 0x101010, { 300, "HM-300-1T" } },
+    { 0x101020, { 350, "HM-350-1T" } },
+    { 0x101030, { 400, "HM-400-1T" } },
+    { 0x101040, { 400, "HM-400-1T" } },
+    { 0x101110, { 600, "HM-600-2T" } },
+    { 0x101120, { 700, "HM-700-2T" } },
+    { 0x101130, { 800, "HM-800-2T" } },
+    { 0x101140, { 800, "HM-800-2T" } },
+    { 0x101210, { 1200, "HM-1200-4T" } },
+    { 0x100230, { 1500, "MI-1500-4T Gen3" } },
+    { 0x101230, { 1500, "HM-1500-4T" } },
+
+    { 0x102011, { 300, "HMS-300-1T" } }, // 00
+    { 0x102021, { 350, "HMS-350-1T" } }, // 00
+    { 0x102041, { 400, "HMS-400-1T" } }, // 00
+    { 0x101051, { 450, "HMS-450-1T" } }, // 01
+    { 0x102051, { 450, "HMS-450-1T" } }, // 03
+    { 0x101071, { 500, "HMS-500-1T" } }, // 02
+    { 0x102071, { 500, "HMS-500-1T v2" } }, // 02
+    { 0x102111, { 600, "HMS-600-2T" } }, // 01
+    { 0x102121, { 700, "HMS-700-2T" } }, // 00
+    { 0x102141, { 800, "HMS-800-2T" } }, // 00
+    { 0x101141, { 800, "HMS-800-2T-LV" } }, // 00
+    { 0x101151, { 900, "HMS-900-2T" } }, // 01
+    { 0x102151, { 900, "HMS-900-2T" } }, // 03
+    { 0x102171, { 1000, "HMS-1000-2T" } }, // 05
+    { 0x101171, { 1000, "HMS-1000-2T" } }, // 01
+    { 0x102241, { 1600, "HMS-1600-4T" } }, // 4
+    { 0x101251, { 1800, "HMS-1800-4T" } }, // 01
+    { 0x102251, { 1800, "HMS-1800-4T" } }, // 16
+    { 0x101271, { 2000, "HMS-2000-4T" } }, // 01
+    { 0x102271, { 2000, "HMS-2000-4T" } }, // 10
+
+    { 0x103241, { 1600, "HMT-1600-4T" } }, // 00
+    { 0x103251, { 1800, "HMT-1800-4T" } }, // 00
+    { 0x103271, { 2000, "HMT-2000-4T" } }, // 0
+
+    { 0x103311, { 1800, "HMT-1800-6T" } }, // 01
+    { 0x103331, { 2250, "HMT-2250-6T" } }, // 01
+
+    { 0xF10110, { 600, "HERF-600" } }, // 00
+    { 0xF10114, { 800, "HERF-800" } }, // 00
+    { 0xF10124, { 1600, "HERF-1600" } }, // 00
+    { 0xF10122, { 1800, "HERF-1800" } }, // 00
+};
+
+// Part numbers where the fourth byte carries a factory variant
+constexpr frozen::map<uint32_t, devInfo_t, 1> devInfoExact = {
+    { 0x10101015, { static_cast<uint16_t>(300 * 0.7), "HM-300-1T" } }, // HM-300 factory limitted to 70%
 };
 
 DevInfoParser::DevInfoParser()
@@ -108,6 +115,7 @@ void DevInfoParser::appendFragmentAll(const uint8_t offset, const uint8_t* paylo
 {
     if (offset + len > DEV_INFO_SIZE) {
         ESP_LOGE(TAG, "(%s, %d) dev info all packet too large for buffer", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
     memcpy(&_payloadDevInfoAll[offset], payload, len);
@@ -118,12 +126,15 @@ void DevInfoParser::clearBufferSimple()
 {
     memset(_payloadDevInfoSimple, 0, DEV_INFO_SIZE);
     _devInfoSimpleLength = 0;
+    _resolvedDevInfo = nullptr;
+    _devInfoResolved = false;
 }
 
 void DevInfoParser::appendFragmentSimple(const uint8_t offset, const uint8_t* payload, const uint8_t len)
 {
     if (offset + len > DEV_INFO_SIZE) {
         ESP_LOGE(TAG, "(%s, %d) dev info Simple packet too large for buffer", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
     memcpy(&_payloadDevInfoSimple[offset], payload, len);
@@ -213,20 +224,20 @@ String DevInfoParser::getHwVersion() const
 
 uint16_t DevInfoParser::getMaxPower() const
 {
-    const uint8_t idx = getDevIdx();
-    if (idx == 0xff) {
+    const devInfo_t* info = getDevInfo();
+    if (info == nullptr) {
         return 0;
     }
-    return devInfo[idx].maxPower;
+    return info->maxPower;
 }
 
 String DevInfoParser::getHwModelName() const
 {
-    const uint8_t idx = getDevIdx();
-    if (idx == 0xff) {
+    const devInfo_t* info = getDevInfo();
+    if (info == nullptr) {
         return "";
     }
-    return devInfo[idx].modelName;
+    return info->modelName;
 }
 
 bool DevInfoParser::containsValidData() const
@@ -239,39 +250,48 @@ bool DevInfoParser::containsValidData() const
     return info.tm_year > (2016 - 1900) && getHwPartNumber() != 124097;
 }
 
-uint8_t DevInfoParser::getDevIdx() const
+uint8_t DevInfoParser::getPayloadAll(uint8_t* buffer, const uint8_t maxLen) const
 {
-    uint8_t ret = 0xff;
-    uint8_t pos;
-
-    HOY_SEMAPHORE_TAKE();
+    if (_devInfoAllLength == 0 || _devInfoAllLength > maxLen) {
+        return 0;
+    }
+    memcpy(buffer, _payloadDevInfoAll, _devInfoAllLength);
+    return _devInfoAllLength;
+}
 
-    // Check for all 4 bytes first
-    for (pos = 0; pos < sizeof(devInfo) / sizeof(devInfo_t); pos++) {
-        if (devInfo[pos].hwPart[0] == _payloadDevInfoSimple[2]
-            && devInfo[pos].hwPart[1] == _payloadDevInfoSimple[3]
-            && devInfo[pos].hwPart[2] == _payloadDevInfoSimple[4]
-            && devInfo[pos].hwPart[3] == _payloadDevInfoSimple[5]) {
-            ret = pos;
-            break;
-        }
+uint8_t DevInfoParser::getPayloadSimple(uint8_t* buffer, const uint8_t maxLen) const
+{
+    if (_devInfoSimpleLength == 0 || _devInfoSimpleLength > maxLen) {
+        return 0;
     }
+    memcpy(buffer, _payloadDevInfoSimple, _devInfoSimpleLength);
+    return _devInfoSimpleLength;
+}
 
-    // Then only for 3 bytes but only if not already found
-    if (ret == 0xff) {
-        for (pos = 0; pos < sizeof(devInfo) / sizeof(devInfo_t); pos++) {
-            if (devInfo[pos].hwPart[0] == _payloadDevInfoSimple[2]
-                && devInfo[pos].hwPart[1] == _payloadDevInfoSimple[3]
-                && devInfo[pos].hwPart[2] == _payloadDevInfoSimple[4]) {
-                ret = pos;
-                break;
-            }
-        }
+const devInfo_t* DevInfoParser::getDevInfo() const
+{
+    if (_devInfoResolved) {
+        return _resolvedDevInfo;
     }
 
+    HOY_SEMAPHORE_TAKE();
+    const uint32_t hwPart = (static_cast<uint32_t>(_payloadDevInfoSimple[2]) << 24)
+        | (static_cast<uint32_t>(_payloadDevInfoSimple[3]) << 16)
+        | (static_cast<uint32_t>(_payloadDevInfoSimple[4]) << 8)
+        | _payloadDevInfoSimple[5];
     HOY_SEMAPHORE_GIVE();
 
-    return ret;
+    // Check for all 4 bytes first, then only for the first 3 bytes
+    const auto exact = devInfoExact.find(hwPart);
+    if (exact != devInfoExact.end()) {
+        _resolvedDevInfo = &exact->second;
+    } else {
+        const auto prefix = devInfoPrefix.find(hwPart >> 8);
+        _resolvedDevInfo = (prefix != devInfoPrefix.end()) ? &prefix->second : nullptr;
+    }
+    _devInfoResolved = true;
+
+    return _resolvedDevInfo;
 }
 
 /* struct tm to seconds since Unix epoch */
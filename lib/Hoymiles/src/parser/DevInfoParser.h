@@ -4,6 +4,8 @@
 
 #define DEV_INFO_SIZE 20
 
+struct devInfo_t;
+
 class DevInfoParser : public Parser {
 public:
     DevInfoParser();
@@ -32,9 +34,13 @@ public:
 
     bool containsValidData() const;
 
+    // Warm start support: raw payload export for persistence
+    uint8_t getPayloadAll(uint8_t* buffer, const uint8_t maxLen) const;
+    uint8_t getPayloadSimple(uint8_t* buffer, const uint8_t maxLen) const;
+
 private:
     static time_t timegm(const struct tm* tm);
-    uint8_t getDevIdx() const;
+    const devInfo_t* getDevInfo() const;
 
     uint32_t _lastUpdateAll = 0;
     uint32_t _lastUpdateSimple = 0;
@@ -44,4 +50,9 @@ private:
 
     uint8_t _payloadDevInfoSimple[DEV_INFO_SIZE] = {};
     uint8_t _devInfoSimpleLength = 0;
+
+    // Model metadata resolved once per received DevInfoSimple payload,
+    // points into the compile-time table. nullptr if unknown hardware.
+    mutable const devInfo_t* _resolvedDevInfo = nullptr;
+    mutable bool _devInfoResolved = false;
 };
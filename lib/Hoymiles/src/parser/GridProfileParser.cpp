@@ -20,26 +20,40 @@ ID   Source Addr   Target Addr   Idx  Profile ID   Profile Version   Section ID
 The number of values depends on the respective section and its version. After the last value of a section follows the next section id.
 */
 #include "GridProfileParser.h"
+#include "../EventCounters.h"
+#include <algorithm>
+#include <array>
 #include <cstring>
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
 #include <frozen/map.h>
 #include <frozen/string.h>
 
 #undef TAG
 static const char* TAG = "hoymiles";
 
-const std::array<const ProfileType_t, PROFILE_TYPE_COUNT> GridProfileParser::_profileTypes = { {
-    { 0x02, 0x00, "US - NA_IEEE1547_240V" },
-    { 0x03, 0x00, "DE - DE_VDE4105_2018" },
-    { 0x03, 0x01, "DE - DE_VDE4105_2011" },
-    { 0x0a, 0x00, "XX - EN 50549-1:2019" },
-    { 0x0c, 0x00, "AT - AT_TOR_Erzeuger_default" },
-    { 0x0d, 0x04, "XX - NF_EN_50549-1:2019" },
-    { 0x10, 0x00, "ES - ES_RD1699" },
-    { 0x12, 0x00, "PL - EU_EN50438" },
-    { 0x29, 0x00, "NL - NL_NEN-EN50549-1_2019" },
-    { 0x37, 0x00, "CH - CH_NA EEA-NE7-CH2020" },
-} };
+#define PROFILE_TYPE_COUNT 10
+#define SECTION_VALUE_COUNT 158
+
+struct GridProfileValue_t {
+    uint8_t Section;
+    uint8_t Version;
+    uint8_t ItemDefinition;
+};
+
+// Profile types keyed by (lIdx << 8) | hIdx. frozen::map sorts the table
+// at compile time and looks it up via binary search.
+constexpr frozen::map<uint16_t, const char*, PROFILE_TYPE_COUNT> profileTypes = {
+    { 0x0200, "US - NA_IEEE1547_240V" },
+    { 0x0300, "DE - DE_VDE4105_2018" },
+    { 0x0301, "DE - DE_VDE4105_2011" },
+    { 0x0a00, "XX - EN 50549-1:2019" },
+    { 0x0c00, "AT - AT_TOR_Erzeuger_default" },
+    { 0x0d04, "XX - NF_EN_50549-1:2019" },
+    { 0x1000, "ES - ES_RD1699" },
+    { 0x1200, "PL - EU_EN50438" },
+    { 0x2900, "NL - NL_NEN-EN50549-1_2019" },
+    { 0x3700, "CH - CH_NA EEA-NE7-CH2020" },
+};
 
 constexpr frozen::map<uint8_t, frozen::string, 12> profileSection = {
     { 0x00, "Voltage (H/LVRT)" },
@@ -137,7 +151,9 @@ constexpr frozen::map<uint8_t, GridProfileItemDefinition_t, 0x42> itemDefinition
     { 0xff, make_value("Unkown Value", "", 1) },
 };
 
-const std::array<const GridProfileValue_t, SECTION_VALUE_COUNT> GridProfileParser::_profileValues = { {
+// Ordered by (Section, Version) so the section index below can be built
+// and binary searched. A static_assert guards the ordering.
+constexpr std::array<GridProfileValue_t, SECTION_VALUE_COUNT> profileValues = { {
     // Voltage (H/LVRT)
     // Version 0x00
     { 0x00, 0x00, 0x01 },
@@ -365,6 +381,78 @@ const std::array<const GridProfileValue_t, SECTION_VALUE_COUNT> GridProfileParse
     { 0xb0, 0x00, 0x38 },
 } };
 
+// Start offset and length of every (section, version) run in profileValues,
+// generated at compile time. Replaces the former getSectionStart and
+// getSectionSize which scanned the whole table per section per request.
+struct SectionIndex_t {
+    uint16_t Key; // (Section << 8) | Version
+    uint8_t Start;
+    uint8_t Size;
+};
+
+constexpr uint16_t sectionKey(const GridProfileValue_t& value)
+{
+    return static_cast<uint16_t>(value.Section) << 8 | value.Version;
+}
+
+constexpr size_t countSectionRuns()
+{
+    size_t count = 0;
+    uint32_t lastKey = 0xffffffff;
+    for (const auto& value : profileValues) {
+        if (sectionKey(value) != lastKey) {
+            lastKey = sectionKey(value);
+            count++;
+        }
+    }
+    return count;
+}
+
+constexpr size_t SECTION_INDEX_COUNT = countSectionRuns();
+
+constexpr std::array<SectionIndex_t, SECTION_INDEX_COUNT> buildSectionIndex()
+{
+    std::array<SectionIndex_t, SECTION_INDEX_COUNT> index {};
+    size_t run = 0;
+    for (size_t i = 0; i < profileValues.size(); i++) {
+        const uint16_t key = sectionKey(profileValues[i]);
+        if (i == 0 || key != index[run - 1].Key) {
+            index[run] = { key, static_cast<uint8_t>(i), 1 };
+            run++;
+        } else {
+            index[run - 1].Size++;
+        }
+    }
+    return index;
+}
+
+constexpr auto sectionIndex = buildSectionIndex();
+
+constexpr bool isSectionIndexSorted()
+{
+    for (size_t i = 1; i < sectionIndex.size(); i++) {
+        if (sectionIndex[i - 1].Key >= sectionIndex[i].Key) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isSectionIndexSorted(), "profileValues must be ordered by (Section, Version)");
+
+static const SectionIndex_t* findSection(const uint8_t section_id, const uint8_t section_version)
+{
+    const uint16_t key = static_cast<uint16_t>(section_id) << 8 | section_version;
+    const auto it = std::lower_bound(sectionIndex.begin(), sectionIndex.end(), key,
+        [](const SectionIndex_t& entry, const uint16_t k) {
+            return entry.Key < k;
+        });
+    if (it == sectionIndex.end() || it->Key != key) {
+        return nullptr;
+    }
+    return &*it;
+}
+
 GridProfileParser::GridProfileParser()
     : Parser()
 {
@@ -375,12 +463,14 @@ void GridProfileParser::clearBuffer()
 {
     memset(_payloadGridProfile, 0, GRID_PROFILE_SIZE);
     _gridProfileLength = 0;
+    _profileCacheValid = false;
 }
 
 void GridProfileParser::appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len)
 {
     if (offset + len > GRID_PROFILE_SIZE) {
         ESP_LOGE(TAG, "(%s, %d) grid profile packet too large for buffer", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
     memcpy(&_payloadGridProfile[offset], payload, len);
@@ -389,10 +479,10 @@ void GridProfileParser::appendFragment(const uint8_t offset, const uint8_t* payl
 
 String GridProfileParser::getProfileName() const
 {
-    for (auto& ptype : _profileTypes) {
-        if (ptype.lIdx == _payloadGridProfile[0] && ptype.hIdx == _payloadGridProfile[1]) {
-            return ptype.Name;
-        }
+    const uint16_t key = static_cast<uint16_t>(_payloadGridProfile[0]) << 8 | _payloadGridProfile[1];
+    const auto it = profileTypes.find(key);
+    if (it != profileTypes.end()) {
+        return it->second;
     }
     return "Unknown";
 }
@@ -418,6 +508,19 @@ std::vector<uint8_t> GridProfileParser::getRawData() const
 }
 
 std::list<GridProfileSection_t> GridProfileParser::getProfile() const
+{
+    HOY_SEMAPHORE_TAKE();
+    if (!_profileCacheValid) {
+        _profileCache = parseProfile();
+        _profileCacheValid = true;
+    }
+    std::list<GridProfileSection_t> l = _profileCache;
+    HOY_SEMAPHORE_GIVE();
+
+    return l;
+}
+
+std::list<GridProfileSection_t> GridProfileParser::parseProfile() const
 {
     std::list<GridProfileSection_t> l;
 
@@ -426,8 +529,7 @@ std::list<GridProfileSection_t> GridProfileParser::getProfile() const
         do {
             const uint8_t section_id = _payloadGridProfile[pos];
             const uint8_t section_version = _payloadGridProfile[pos + 1];
-            const int16_t section_start = getSectionStart(section_id, section_version);
-            const uint8_t section_size = getSectionSize(section_id, section_version);
+            const SectionIndex_t* sectionRun = findSection(section_id, section_version);
             pos += 2;
 
             GridProfileSection_t section;
@@ -438,13 +540,13 @@ std::list<GridProfileSection_t> GridProfileParser::getProfile() const
                 break;
             }
 
-            if (section_start == -1) {
+            if (sectionRun == nullptr) {
                 section.SectionName = "Unknown";
                 break;
             }
 
-            for (uint8_t val_id = 0; val_id < section_size; val_id++) {
-                auto itemDefinition = itemDefinitions.at(_profileValues[section_start + val_id].ItemDefinition);
+            for (uint8_t val_id = 0; val_id < sectionRun->Size; val_id++) {
+                auto itemDefinition = itemDefinitions.at(profileValues[sectionRun->Start + val_id].ItemDefinition);
 
                 float value = static_cast<int16_t>((_payloadGridProfile[pos] << 8) | _payloadGridProfile[pos + 1]);
                 value /= itemDefinition.Divider;
@@ -470,26 +572,3 @@ bool GridProfileParser::containsValidData() const
 {
     return _gridProfileLength > 6;
 }
-
-uint8_t GridProfileParser::getSectionSize(const uint8_t section_id, const uint8_t section_version)
-{
-    uint8_t count = 0;
-    for (auto& values : _profileValues) {
-        if (values.Section == section_id && values.Version == section_version) {
-            count++;
-        }
-    }
-    return count;
-}
-
-int16_t GridProfileParser::getSectionStart(const uint8_t section_id, const uint8_t section_version)
-{
-    int16_t count = -1;
-    for (auto& values : _profileValues) {
-        count++;
-        if (values.Section == section_id && values.Version == section_version) {
-            break;
-        }
-    }
-    return count;
-}
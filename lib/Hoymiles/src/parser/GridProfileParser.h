@@ -4,20 +4,6 @@
 #include <list>
 
 #define GRID_PROFILE_SIZE 141
-#define PROFILE_TYPE_COUNT 10
-#define SECTION_VALUE_COUNT 158
-
-typedef struct {
-    uint8_t lIdx;
-    uint8_t hIdx;
-    const char* Name;
-} ProfileType_t;
-
-struct GridProfileValue_t {
-    uint8_t Section;
-    uint8_t Version;
-    uint8_t ItemDefinition;
-};
 
 struct GridProfileItem_t {
     String Name;
@@ -46,12 +32,13 @@ public:
     bool containsValidData() const;
 
 private:
-    static uint8_t getSectionSize(const uint8_t section_id, const uint8_t section_version);
-    static int16_t getSectionStart(const uint8_t section_id, const uint8_t section_version);
+    std::list<GridProfileSection_t> parseProfile() const;
 
     uint8_t _payloadGridProfile[GRID_PROFILE_SIZE] = {};
     uint8_t _gridProfileLength = 0;
 
-    static const std::array<const ProfileType_t, PROFILE_TYPE_COUNT> _profileTypes;
-    static const std::array<const GridProfileValue_t, SECTION_VALUE_COUNT> _profileValues;
+    // Parse result of the current payload. Rebuilt lazily on the first
+    // getProfile() call after a new GridOnProFilePara payload arrived.
+    mutable std::list<GridProfileSection_t> _profileCache;
+    mutable bool _profileCacheValid = false;
 };
@@ -18,6 +18,14 @@ uint32_t Parser::getLastUpdate() const
 void Parser::setLastUpdate(const uint32_t lastUpdate)
 {
     _lastUpdate = lastUpdate;
+    if (lastUpdate != 0 && _updateCallback) {
+        _updateCallback();
+    }
+}
+
+void Parser::setUpdateCallback(std::function<void()> callback)
+{
+    _updateCallback = std::move(callback);
 }
 
 void Parser::beginAppendFragment()
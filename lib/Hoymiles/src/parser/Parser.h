@@ -1,12 +1,35 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include <Arduino.h>
+#include <LockMonitor.h>
+#include <esp_timer.h>
 #include <cstdint>
+#include <functional>
 
+#if LOCKMONITOR_ENABLE
+// Each macro expansion is its own acquisition site; take and give
+// pair up through the lock name (see LockMonitor::released)
+#define HOY_SEMAPHORE_TAKE()                                                  \
+    do {                                                                      \
+        static LockMonitorSite _lockMonitorSite("hoy_semaphore",              \
+            __FILE__ ":" LOCK_MONITOR_STR(__LINE__));                         \
+        const int64_t _lockMonitorStart = esp_timer_get_time();               \
+        while (xSemaphoreTake(_xSemaphore, portMAX_DELAY) != pdPASS) {        \
+        }                                                                     \
+        LockMonitor::acquired(_lockMonitorSite,                               \
+            static_cast<uint32_t>(esp_timer_get_time() - _lockMonitorStart)); \
+    } while (0)
+#define HOY_SEMAPHORE_GIVE()                      \
+    do {                                          \
+        LockMonitor::released("hoy_semaphore");   \
+        xSemaphoreGive(_xSemaphore);              \
+    } while (0)
+#else
 #define HOY_SEMAPHORE_TAKE() \
     do {                     \
     } while (xSemaphoreTake(_xSemaphore, portMAX_DELAY) != pdPASS)
 #define HOY_SEMAPHORE_GIVE() xSemaphoreGive(_xSemaphore)
+#endif
 
 typedef enum {
     CMD_OK,
@@ -20,6 +43,11 @@ public:
     uint32_t getLastUpdate() const;
     void setLastUpdate(const uint32_t lastUpdate);
 
+    // Invoked whenever setLastUpdate records a fresh (non-zero)
+    // timestamp, i.e. from the command completion path right after
+    // new data was ingested.
+    void setUpdateCallback(std::function<void()> callback);
+
     void beginAppendFragment();
     void endAppendFragment();
 
@@ -28,4 +56,5 @@ protected:
 
 private:
     uint32_t _lastUpdate = 0;
+    std::function<void()> _updateCallback;
 };
\ No newline at end of file
@@ -3,7 +3,13 @@
  * Copyright (C) 2022 - 2025 Thomas Basler and others
  */
 #include "StatisticsParser.h"
-#include <esp_log.h>
+#include "../EventCounters.h"
+#include "Timeseries.h"
+#include <CyclePerf.h>
+#include <cmath>
+#include <ctime>
+#include "../HoymilesLogLevel.h"
+#include <utility>
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -70,7 +76,16 @@ void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, con
     _byteAssignment = byteAssignment;
     _byteAssignmentSize = size;
 
+    memset(_byteAssignmentIndex, 0xFF, sizeof(_byteAssignmentIndex));
+    _valueSnapshot.assign(size, 0);
+    _rawSnapshot.assign(size, 0);
+    // Mark everything as changed so the first payload is published in full
+    _valueChanged.assign(size, true);
+    _valueLastChange.assign(size, 0);
+
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        _byteAssignmentIndex[_byteAssignment[i].type][_byteAssignment[i].ch][_byteAssignment[i].fieldId] = i;
+
         if (_byteAssignment[i].div == CMD_CALC) {
             continue;
         }
@@ -85,26 +100,36 @@ uint8_t StatisticsParser::getExpectedByteCount()
 
 void StatisticsParser::clearBuffer()
 {
-    memset(_payloadStatistic, 0, STATISTIC_PACKET_SIZE);
+    memset(_payloadStatisticStaging, 0, STATISTIC_PACKET_SIZE);
     _statisticLength = 0;
 }
 
 void StatisticsParser::appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len)
 {
+    CYCLE_PERF_SCOPE("statistics_append_fragment");
+
     if (offset + len > STATISTIC_PACKET_SIZE) {
         ESP_LOGE(TAG, "(%s, %d) stats packet too large for buffer", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
-    memcpy(&_payloadStatistic[offset], payload, len);
+    memcpy(&_payloadStatisticStaging[offset], payload, len);
     _statisticLength += len;
 }
 
 void StatisticsParser::endAppendFragment()
 {
+    // Promote the staging buffer the radio just filled to the active
+    // buffer. Readers decode from the previous active buffer until here.
+    std::swap(_payloadStatistic, _payloadStatisticStaging);
+
     Parser::endAppendFragment();
 
+    updateSnapshot();
+
     if (!_enableYieldDayCorrection) {
         resetYieldDayCorrection();
+        recordTimeseries();
         return;
     }
 
@@ -121,16 +146,21 @@ void StatisticsParser::endAppendFragment()
             _lastYieldDay[static_cast<uint8_t>(c)] = getChannelFieldValue(TYPE_DC, c, FLD_YD);
         }
     }
+
+    recordTimeseries();
 }
 
 const byteAssign_t* StatisticsParser::getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
-    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type && _byteAssignment[i].ch == channel && _byteAssignment[i].fieldId == fieldId) {
-            return &_byteAssignment[i];
-        }
+    if (type >= TYPE_CNT || channel >= CH_CNT || fieldId >= FLD_CNT) {
+        return nullptr;
     }
-    return nullptr;
+
+    const uint8_t idx = _byteAssignmentIndex[type][channel][fieldId];
+    if (idx == 0xFF) {
+        return nullptr;
+    }
+    return &_byteAssignment[idx];
 }
 
 fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
@@ -144,11 +174,106 @@ fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t
 }
 
 float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    CYCLE_PERF_SCOPE("statistics_field_value");
+
+    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
+    if (pos == nullptr) {
+        return 0;
+    }
+
+    // Readers are served from the immutable decoded snapshot
+    return _valueSnapshot[pos - _byteAssignment];
+}
+
+bool StatisticsParser::isChannelFieldDirty(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
+    if (pos == nullptr) {
+        return false;
+    }
+    return _valueChanged[pos - _byteAssignment];
+}
+
+uint32_t StatisticsParser::getChannelFieldLastChange(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
     const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
     if (pos == nullptr) {
         return 0;
     }
+    return _valueLastChange[pos - _byteAssignment];
+}
+
+bool StatisticsParser::getChannelFieldScaledValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, scaledValue_t& scaled)
+{
+    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
+    if (pos == nullptr || pos->div == CMD_CALC) {
+        return false;
+    }
+
+    // All current tables keep digits == log10(div); verify anyway so a
+    // future non-decimal divisor silently takes the float path instead
+    // of rendering garbage
+    static constexpr uint16_t pow10[] = { 1, 10, 100, 1000, 10000 };
+    if (pos->digits >= sizeof(pow10) / sizeof(pow10[0]) || pow10[pos->digits] != pos->div) {
+        return false;
+    }
+
+    int64_t value = _rawSnapshot[pos - _byteAssignment];
+
+    const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
+    if (setting != nullptr && _statisticLength > 0) {
+        // Offsets are configured floats; quantizing them to the field's
+        // own resolution keeps the sum exact
+        value += llroundf(setting->offset * static_cast<float>(pos->div));
+    }
+
+    scaled.value = value;
+    scaled.exponent = pos->digits;
+    return true;
+}
+
+uint8_t StatisticsParser::renderScaledValue(const scaledValue_t& scaled, char* buffer, const uint8_t maxLen)
+{
+    // Digits are produced least-significant first into a scratch
+    // buffer, then reversed into the destination
+    char scratch[24];
+    uint8_t len = 0;
+    uint8_t digits = 0;
+
+    uint64_t remainder = scaled.value < 0
+        ? static_cast<uint64_t>(-scaled.value)
+        : static_cast<uint64_t>(scaled.value);
+
+    // At least one digit has to precede the decimal point
+    while (remainder != 0 || digits <= scaled.exponent) {
+        scratch[len++] = '0' + (remainder % 10);
+        remainder /= 10;
+        if (++digits == scaled.exponent && scaled.exponent > 0) {
+            scratch[len++] = '.';
+        }
+    }
+    if (scaled.value < 0) {
+        scratch[len++] = '-';
+    }
+
+    if (len + 1 > maxLen) {
+        if (maxLen > 0) {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < len; i++) {
+        buffer[i] = scratch[len - 1 - i];
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+float StatisticsParser::decodeChannelFieldValue(const byteAssign_t& assign)
+{
+    const byteAssign_t* pos = &assign;
 
     uint8_t ptr = pos->start;
     const uint8_t end = ptr + pos->num;
@@ -175,7 +300,7 @@ float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const Cha
 
         result /= static_cast<float>(div);
 
-        const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
+        const fieldSettings_t* setting = getSettingByChannelField(pos->type, pos->ch, pos->fieldId);
         if (setting != nullptr && _statisticLength > 0) {
             result += setting->offset;
         }
@@ -188,6 +313,57 @@ float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const Cha
     return 0;
 }
 
+int64_t StatisticsParser::decodeChannelFieldRaw(const byteAssign_t& assign)
+{
+    const byteAssign_t* pos = &assign;
+
+    uint8_t ptr = pos->start;
+    const uint8_t end = ptr + pos->num;
+
+    uint32_t val = 0;
+    HOY_SEMAPHORE_TAKE();
+    do {
+        val <<= 8;
+        val |= _payloadStatistic[ptr];
+    } while (++ptr != end);
+    HOY_SEMAPHORE_GIVE();
+
+    if (pos->isSigned && pos->num == 2) {
+        return static_cast<int16_t>(val);
+    } else if (pos->isSigned && pos->num == 4) {
+        return static_cast<int32_t>(val);
+    }
+    return val;
+}
+
+void StatisticsParser::updateSnapshot()
+{
+    // Static fields are decoded first, calculated fields afterwards so
+    // their calc functions read the freshly decoded values.
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        if (_byteAssignment[i].div != CMD_CALC) {
+            storeSnapshotValue(i, decodeChannelFieldValue(_byteAssignment[i]));
+            _rawSnapshot[i] = decodeChannelFieldRaw(_byteAssignment[i]);
+        }
+    }
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        if (_byteAssignment[i].div == CMD_CALC) {
+            storeSnapshotValue(i, decodeChannelFieldValue(_byteAssignment[i]));
+        }
+    }
+
+    updateFleetRow();
+}
+
+void StatisticsParser::storeSnapshotValue(const uint8_t idx, const float value)
+{
+    _valueChanged[idx] = (value != _valueSnapshot[idx]);
+    if (_valueChanged[idx]) {
+        _valueSnapshot[idx] = value;
+        _valueLastChange[idx] = millis();
+    }
+}
+
 bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
 {
     const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
@@ -225,11 +401,21 @@ bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const Chan
     } while (--ptr >= end);
     HOY_SEMAPHORE_GIVE();
 
+    updateSnapshot();
+
     return true;
 }
 
 String StatisticsParser::getChannelFieldValueString(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
+    scaledValue_t scaled;
+    if (getChannelFieldScaledValue(type, channel, fieldId, scaled)) {
+        char buffer[24];
+        renderScaledValue(scaled, buffer, sizeof(buffer));
+        return String(buffer);
+    }
+
+    // Calculated fields have no raw payload integer to render from
     return String(
         getChannelFieldValue(type, channel, fieldId),
         static_cast<unsigned int>(getChannelFieldDigits(type, channel, fieldId)));
@@ -253,6 +439,12 @@ const char* StatisticsParser::getChannelFieldName(const ChannelType_t type, cons
     return fields[pos->fieldId];
 }
 
+const char* StatisticsParser::getChannelFieldNameLower(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
+    return fieldsLower[pos->fieldId];
+}
+
 uint8_t StatisticsParser::getChannelFieldDigits(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
     const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
@@ -276,15 +468,16 @@ void StatisticsParser::setChannelFieldOffset(const ChannelType_t type, const Cha
     } else {
         _fieldSettings.push_back({ type, channel, fieldId, offset });
     }
+    updateSnapshot();
 }
 
-std::list<ChannelType_t> StatisticsParser::getChannelTypes() const
+FixedVector<ChannelType_t, TYPE_CNT> StatisticsParser::getChannelTypes() const
 {
-    return {
-        TYPE_AC,
-        TYPE_DC,
-        TYPE_INV
-    };
+    FixedVector<ChannelType_t, TYPE_CNT> types;
+    types.push_back(TYPE_AC);
+    types.push_back(TYPE_DC);
+    types.push_back(TYPE_INV);
+    return types;
 }
 
 const char* StatisticsParser::getChannelTypeName(const ChannelType_t type) const
@@ -292,16 +485,15 @@ const char* StatisticsParser::getChannelTypeName(const ChannelType_t type) const
     return channelsTypes[type];
 }
 
-std::list<ChannelNum_t> StatisticsParser::getChannelsByType(const ChannelType_t type) const
+FixedVector<ChannelNum_t, CH_CNT> StatisticsParser::getChannelsByType(const ChannelType_t type) const
 {
-    std::list<ChannelNum_t> l;
+    FixedVector<ChannelNum_t, CH_CNT> channels;
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type) {
-            l.push_back(_byteAssignment[i].ch);
+        if (_byteAssignment[i].type == type && !channels.contains(_byteAssignment[i].ch)) {
+            channels.push_back(_byteAssignment[i].ch);
         }
     }
-    l.unique();
-    return l;
+    return channels;
 }
 
 uint16_t StatisticsParser::getStringMaxPower(const uint8_t channel) const
@@ -316,6 +508,21 @@ void StatisticsParser::setStringMaxPower(const uint8_t channel, const uint16_t p
     }
 }
 
+const char* StatisticsParser::getChannelName(const uint8_t channel) const
+{
+    if (channel >= CH_CNT) {
+        return "";
+    }
+    return _channelName[channel];
+}
+
+void StatisticsParser::setChannelName(const uint8_t channel, const char* name)
+{
+    if (channel < CH_CNT) {
+        strlcpy(_channelName[channel], name, sizeof(_channelName[channel]));
+    }
+}
+
 void StatisticsParser::resetRxFailureCount()
 {
     _rxFailureCount = 0;
@@ -343,6 +550,7 @@ void StatisticsParser::zeroDailyData()
 
 void StatisticsParser::setLastUpdate(const uint32_t lastUpdate)
 {
+    _warmStart = false; // real data from the inverter supersedes a restored snapshot
     Parser::setLastUpdate(lastUpdate);
     setLastUpdateFromInternal(lastUpdate);
 }
@@ -362,11 +570,135 @@ bool StatisticsParser::getYieldDayCorrection() const
     return _enableYieldDayCorrection;
 }
 
+uint8_t StatisticsParser::getStatisticPayload(uint8_t* buffer, const uint8_t maxLen) const
+{
+    if (_statisticLength == 0 || _statisticLength > maxLen) {
+        return 0;
+    }
+    memcpy(buffer, _payloadStatistic, _statisticLength);
+    return _statisticLength;
+}
+
+float StatisticsParser::getLastYieldDay(const uint8_t channel) const
+{
+    return channel < CH_CNT ? _lastYieldDay[channel] : 0;
+}
+
+void StatisticsParser::setLastYieldDay(const uint8_t channel, const float value)
+{
+    if (channel < CH_CNT) {
+        _lastYieldDay[channel] = value;
+    }
+}
+
+bool StatisticsParser::isWarmStart() const
+{
+    return _warmStart;
+}
+
+void StatisticsParser::setWarmStart(const bool warmStart)
+{
+    _warmStart = warmStart;
+}
+
 void StatisticsParser::setYieldDayCorrection(const bool enabled)
 {
     _enableYieldDayCorrection = enabled;
 }
 
+void StatisticsParser::setFleetStore(FleetStore* store, const size_t row)
+{
+    _fleetStore = store;
+    _fleetRow = row;
+    updateFleetRow();
+}
+
+void StatisticsParser::releaseFleetStore()
+{
+    if (_fleetStore != nullptr) {
+        _fleetStore->releaseRow(_fleetRow);
+        _fleetStore = nullptr;
+    }
+}
+
+void StatisticsParser::setFleetRowConfigEnabled(const bool enabled)
+{
+    if (_fleetStore != nullptr) {
+        _fleetStore->setRowConfigEnabled(_fleetRow, enabled);
+    }
+}
+
+void StatisticsParser::setFleetRowPollEnabled(const bool enabled)
+{
+    if (_fleetStore != nullptr) {
+        _fleetStore->setRowPollEnabled(_fleetRow, enabled);
+    }
+}
+
+std::shared_ptr<TimeseriesBuffer> StatisticsParser::addTimeseries(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId,
+    const uint32_t sampleInterval, const size_t capacity)
+{
+    auto series = std::make_shared<TimeseriesBuffer>(type, channel, fieldId, sampleInterval, capacity);
+    if (!series->isValid()) {
+        ESP_LOGE(TAG, "Could not allocate time series buffer (%zu samples)", capacity);
+        return nullptr;
+    }
+    _timeseries.push_back(series);
+    return series;
+}
+
+const std::vector<std::shared_ptr<TimeseriesBuffer>>& StatisticsParser::getTimeseries() const
+{
+    return _timeseries;
+}
+
+void StatisticsParser::recordTimeseries()
+{
+    if (_timeseries.empty()) {
+        return;
+    }
+
+    // Only sample with a plausible wall clock (NTP synced)
+    const uint32_t now = time(nullptr);
+    if (now < 1577836800) { // 2020-01-01
+        return;
+    }
+
+    for (auto& series : _timeseries) {
+        series->push(now, getChannelFieldValue(series->getChannelType(), series->getChannel(), series->getFieldId()));
+    }
+}
+
+void StatisticsParser::updateFleetRow()
+{
+    if (_fleetStore == nullptr) {
+        return;
+    }
+
+    float values[FLEET_COL_CNT] = {};
+    for (auto& c : getChannelsByType(TYPE_INV)) {
+        values[FLEET_COL_AC_YIELD_TOTAL] += getChannelFieldValue(TYPE_INV, c, FLD_YT);
+        values[FLEET_COL_AC_YIELD_DAY] += getChannelFieldValue(TYPE_INV, c, FLD_YD);
+        values[FLEET_COL_AC_YIELD_TOTAL_DIGITS] = max<float>(values[FLEET_COL_AC_YIELD_TOTAL_DIGITS], getChannelFieldDigits(TYPE_INV, c, FLD_YT));
+        values[FLEET_COL_AC_YIELD_DAY_DIGITS] = max<float>(values[FLEET_COL_AC_YIELD_DAY_DIGITS], getChannelFieldDigits(TYPE_INV, c, FLD_YD));
+    }
+    for (auto& c : getChannelsByType(TYPE_AC)) {
+        values[FLEET_COL_AC_POWER] += getChannelFieldValue(TYPE_AC, c, FLD_PAC);
+        values[FLEET_COL_AC_POWER_DIGITS] = max<float>(values[FLEET_COL_AC_POWER_DIGITS], getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
+    }
+    for (auto& c : getChannelsByType(TYPE_DC)) {
+        values[FLEET_COL_DC_POWER] += getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+        values[FLEET_COL_DC_POWER_DIGITS] = max<float>(values[FLEET_COL_DC_POWER_DIGITS], getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
+
+        if (getStringMaxPower(c) > 0) {
+            values[FLEET_COL_DC_POWER_IRR] += getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+            values[FLEET_COL_DC_IRR_INSTALLED] += getStringMaxPower(c);
+        }
+    }
+
+    _fleetStore->updateRow(_fleetRow, values);
+}
+
 void StatisticsParser::zeroFields(const FieldId_t* fields)
 {
     // Loop all channels
@@ -1,10 +1,17 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
+#include "../FleetStore.h"
 #include "Parser.h"
+#include <FixedVector.h>
 #include <cstdint>
 #include <list>
+#include <memory>
+#include <vector>
+
+class TimeseriesBuffer;
 
 #define STATISTIC_PACKET_SIZE (7 * 16)
+#define CHANNEL_NAME_STRLEN 31
 
 // units
 enum UnitId_t {
@@ -47,12 +54,20 @@ enum FieldId_t {
     FLD_UAC_31,
     FLD_IAC_1,
     FLD_IAC_2,
-    FLD_IAC_3
+    FLD_IAC_3,
+    FLD_CNT
 };
 const char* const fields[] = { "Voltage", "Current", "Power", "YieldDay", "YieldTotal",
     "Voltage", "Current", "Power", "Frequency", "Temperature", "PowerFactor", "Efficiency", "Irradiation", "ReactivePower", "EventLogCount",
     "Voltage Ph1-N", "Voltage Ph2-N", "Voltage Ph3-N", "Voltage Ph1-Ph2", "Voltage Ph2-Ph3", "Voltage Ph3-Ph1", "Current Ph1", "Current Ph2", "Current Ph3" };
 
+// Interned lowercase variants for MQTT topic segments and compact JSON
+// keys; publishers reference these directly instead of lowercasing the
+// display name into a temporary String on every publish cycle
+const char* const fieldsLower[] = { "voltage", "current", "power", "yieldday", "yieldtotal",
+    "voltage", "current", "power", "frequency", "temperature", "powerfactor", "efficiency", "irradiation", "reactivepower", "eventlogcount",
+    "voltage ph1-n", "voltage ph2-n", "voltage ph3-n", "voltage ph1-ph2", "voltage ph2-ph3", "voltage ph3-ph1", "current ph1", "current ph2", "current ph3" };
+
 // indices to calculation functions, defined in hmInverter.h
 enum {
     CALC_TOTAL_YT = 0,
@@ -79,7 +94,8 @@ enum ChannelNum_t {
 enum ChannelType_t {
     TYPE_AC = 0,
     TYPE_DC,
-    TYPE_INV
+    TYPE_INV,
+    TYPE_CNT
 };
 const char* const channelsTypes[] = { "AC", "DC", "INV" };
 
@@ -102,6 +118,15 @@ typedef struct {
     float offset; // offset (positive/negative) to be applied on the fetched value
 } fieldSettings_t;
 
+// Exact fixed-point representation of a field: the raw payload integer
+// (offsets applied at the same scale) and the decimal exponent implied
+// by the divisor, i.e. the reading equals value / 10^exponent. Unlike
+// the float accessor this is lossless for large energy counters.
+typedef struct {
+    int64_t value;
+    uint8_t exponent;
+} scaledValue_t;
+
 class StatisticsParser : public Parser {
 public:
     StatisticsParser();
@@ -118,10 +143,29 @@ public:
     fieldSettings_t* getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
 
     float getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    // Change tracking: whether the field changed during the most recent
+    // snapshot update and the millis() timestamp of its last change.
+    // Publishers use this to skip fields that are static between frames.
+    bool isChannelFieldDirty(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+    uint32_t getChannelFieldLastChange(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+
+    // Typed fast path: returns the field as a scaled integer straight
+    // from the payload, skipping the float round-trip. Returns false
+    // for calculated fields and non-decimal divisors; callers fall back
+    // to getChannelFieldValue then.
+    bool getChannelFieldScaledValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, scaledValue_t& scaled);
+
+    // Renders a scaled value as a decimal string with exponent digits
+    // after the point, without going through printf's float path.
+    // Returns the number of characters written (excluding the NUL).
+    static uint8_t renderScaledValue(const scaledValue_t& scaled, char* buffer, const uint8_t maxLen);
+
     String getChannelFieldValueString(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
     bool hasChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     const char* getChannelFieldUnit(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     const char* getChannelFieldName(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+    const char* getChannelFieldNameLower(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     uint8_t getChannelFieldDigits(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
 
     bool setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value);
@@ -129,13 +173,23 @@ public:
     float getChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
     void setChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const float offset);
 
-    std::list<ChannelType_t> getChannelTypes() const;
+    // Inline fixed-capacity results: these run inside every per-field
+    // iteration loop (MQTT publish, websocket push, Prometheus scrape)
+    // and must not allocate per call
+    FixedVector<ChannelType_t, TYPE_CNT> getChannelTypes() const;
     const char* getChannelTypeName(const ChannelType_t type) const;
-    std::list<ChannelNum_t> getChannelsByType(const ChannelType_t type) const;
+    FixedVector<ChannelNum_t, CH_CNT> getChannelsByType(const ChannelType_t type) const;
 
     uint16_t getStringMaxPower(const uint8_t channel) const;
     void setStringMaxPower(const uint8_t channel, const uint16_t power);
 
+    // Channel display name, pushed down like the string max power:
+    // written at config-change time, so the render paths (MQTT,
+    // websocket, Prometheus) read a struct field per channel instead
+    // of scanning the configuration
+    const char* getChannelName(const uint8_t channel) const;
+    void setChannelName(const uint8_t channel, const char* name);
+
     void resetRxFailureCount();
     void incrementRxFailureCount();
     uint32_t getRxFailureCount() const;
@@ -154,21 +208,81 @@ public:
     bool getYieldDayCorrection() const;
     void setYieldDayCorrection(const bool enabled);
 
+    // Warm start support: raw payload export for persistence and the
+    // yield-day correction state, so a restored snapshot survives the
+    // midnight counter-reset logic. The warm start flag marks restored
+    // data and is cleared by the first real update from the inverter.
+    uint8_t getStatisticPayload(uint8_t* buffer, const uint8_t maxLen) const;
+    float getLastYieldDay(const uint8_t channel) const;
+    void setLastYieldDay(const uint8_t channel, const float value);
+    bool isWarmStart() const;
+    void setWarmStart(const bool warmStart);
+
+    // Attaches this parser to a row of the fleet-wide columnar store.
+    // The row is refreshed whenever the snapshot is rebuilt.
+    void setFleetStore(FleetStore* store, const size_t row);
+    void releaseFleetStore();
+    void setFleetRowConfigEnabled(const bool enabled);
+    void setFleetRowPollEnabled(const bool enabled);
+
+    // Attaches a historical ring-buffer time series to a field. Sampled
+    // on payload completion, returns nullptr if allocation failed.
+    std::shared_ptr<TimeseriesBuffer> addTimeseries(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId,
+        const uint32_t sampleInterval, const size_t capacity);
+    const std::vector<std::shared_ptr<TimeseriesBuffer>>& getTimeseries() const;
+
 private:
     void zeroFields(const FieldId_t* fields);
+    float decodeChannelFieldValue(const byteAssign_t& pos);
+    int64_t decodeChannelFieldRaw(const byteAssign_t& pos);
+    void updateSnapshot();
+    void storeSnapshotValue(const uint8_t idx, const float value);
+    void updateFleetRow();
+    void recordTimeseries();
 
-    uint8_t _payloadStatistic[STATISTIC_PACKET_SIZE] = {};
+    // Double buffered payload: the radio appends fragments into the
+    // staging buffer while readers decode from the active one. The
+    // buffers are swapped once the exchange completes, so the append
+    // path never contends with readers on a lock.
+    uint8_t _payloadStatisticBuffer[2][STATISTIC_PACKET_SIZE] = {};
+    uint8_t* _payloadStatistic = _payloadStatisticBuffer[0];
+    uint8_t* _payloadStatisticStaging = _payloadStatisticBuffer[1];
     uint8_t _statisticLength = 0;
     uint16_t _stringMaxPower[CH_CNT];
+    char _channelName[CH_CNT][CHANNEL_NAME_STRLEN + 1] = {};
 
     const byteAssign_t* _byteAssignment;
     uint8_t _byteAssignmentSize;
+
+    // Dense lookup index keyed by type/channel/field, built once in
+    // setByteAssignment. 0xFF marks a non-existing entry.
+    uint8_t _byteAssignmentIndex[TYPE_CNT][CH_CNT][FLD_CNT];
     uint8_t _expectedByteCount = 0;
     std::list<fieldSettings_t> _fieldSettings;
 
+    // Flat decoded snapshot, one float per byteAssignment entry. Rebuilt
+    // when a statistics exchange completes or a field is modified, so
+    // readers are served without taking the semaphore or re-decoding.
+    std::vector<float> _valueSnapshot;
+
+    // Undivided payload integers backing the scaled-value fast path,
+    // maintained next to the float snapshot. Calculated fields keep 0.
+    std::vector<int64_t> _rawSnapshot;
+
+    // Per-field dirty bitmap and last-change timestamps, maintained
+    // alongside the snapshot by comparing against the previous values.
+    std::vector<bool> _valueChanged;
+    std::vector<uint32_t> _valueLastChange;
+
+    FleetStore* _fleetStore = nullptr;
+    size_t _fleetRow = 0;
+
+    std::vector<std::shared_ptr<TimeseriesBuffer>> _timeseries;
+
     uint32_t _rxFailureCount = 0;
     uint32_t _lastUpdateFromInternal = 0;
 
     bool _enableYieldDayCorrection = false;
     float _lastYieldDay[CH_CNT] = {};
+    bool _warmStart = false;
 };
@@ -17,8 +17,9 @@ Data structure:
 ID   Source Addr   Target Addr   Idx  ?       Limit percent   ?       ?       ?       ?       ?       CRC16   CRC8
 */
 #include "SystemConfigParaParser.h"
+#include "../EventCounters.h"
 #include <cstring>
-#include <esp_log.h>
+#include "../HoymilesLogLevel.h"
 
 #undef TAG
 static const char* TAG = "hoymiles";
@@ -39,33 +40,63 @@ void SystemConfigParaParser::appendFragment(const uint8_t offset, const uint8_t*
 {
     if (offset + len > (SYSTEM_CONFIG_PARA_SIZE)) {
         ESP_LOGE(TAG, "(%s, %d) stats packet too large for buffer", __FILE__, __LINE__);
+        EventCounters.count(EventCountersClass::Counter::ParseError);
         return;
     }
     memcpy(&_payload[offset], payload, len);
     _payloadLength += len;
 }
 
-float SystemConfigParaParser::getLimitPercent() const
+void SystemConfigParaParser::endAppendFragment()
 {
-    HOY_SEMAPHORE_TAKE();
-    const float ret = ((static_cast<uint16_t>(_payload[2]) << 8) | _payload[3]) / 10.0;
-    HOY_SEMAPHORE_GIVE();
+    // Decode the limit while the semaphore is still held. Consumers read
+    // the cached value afterwards without taking the semaphore.
+    const float limit = ((static_cast<uint16_t>(_payload[2]) << 8) | _payload[3]) / 10.0;
 
     // don't pretend the inverter could produce more than its rated power,
     // even though it does process, accept, and even save limit values beyond
     // its rated power.
-    return min<float>(100, ret);
+    const float clamped = min<float>(100, limit);
+
+    if (!_limitDecoded || clamped != _limitPercent) {
+        _limitPercent = clamped;
+        _limitVersion++;
+        _limitDecoded = true;
+    }
+
+    Parser::endAppendFragment();
+}
+
+float SystemConfigParaParser::getLimitPercent() const
+{
+    return _limitPercent;
 }
 
 void SystemConfigParaParser::setLimitPercent(const float value)
 {
     const uint16_t val = static_cast<uint16_t>(value * 10);
+    const float clamped = min<float>(100, value);
     HOY_SEMAPHORE_TAKE();
     _payload[2] = val >> 8;
     _payload[3] = val & 0xFF;
+    if (!_limitDecoded || clamped != _limitPercent) {
+        _limitPercent = clamped;
+        _limitVersion++;
+        _limitDecoded = true;
+    }
     HOY_SEMAPHORE_GIVE();
 }
 
+uint32_t SystemConfigParaParser::getLimitVersion() const
+{
+    return _limitVersion;
+}
+
+bool SystemConfigParaParser::hasChangedSince(const uint32_t version) const
+{
+    return _limitVersion != version;
+}
+
 void SystemConfigParaParser::setLastLimitCommandSuccess(const LastCommandSuccess status)
 {
     _lastLimitCommandSuccess = status;
@@ -9,10 +9,17 @@ public:
     SystemConfigParaParser();
     void clearBuffer();
     void appendFragment(const uint8_t offset, const uint8_t* payload, const uint8_t len);
+    void endAppendFragment();
 
     float getLimitPercent() const;
     void setLimitPercent(const float value);
 
+    // The limit version is bumped whenever the decoded limit changes.
+    // Consumers can poll with a single integer compare instead of
+    // re-reading the payload under the semaphore.
+    uint32_t getLimitVersion() const;
+    bool hasChangedSince(const uint32_t version) const;
+
     void setLastLimitCommandSuccess(const LastCommandSuccess status);
     LastCommandSuccess getLastLimitCommandSuccess() const;
     uint32_t getLastUpdateCommand() const;
@@ -30,6 +37,10 @@ private:
     uint8_t _payload[SYSTEM_CONFIG_PARA_SIZE];
     uint8_t _payloadLength;
 
+    float _limitPercent = 0;
+    uint32_t _limitVersion = 0;
+    bool _limitDecoded = false;
+
     LastCommandSuccess _lastLimitCommandSuccess = CMD_OK; // Set to OK because we have to assume nothing is done at startup
     LastCommandSuccess _lastLimitRequestSuccess = CMD_NOK; // Set to NOK to fetch at startup
 
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "Timeseries.h"
+#include <cstdlib>
+#include <esp_heap_caps.h>
+
+TimeseriesBuffer::TimeseriesBuffer(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId,
+    const uint32_t sampleInterval, const size_t capacity)
+    : _type(type)
+    , _channel(channel)
+    , _fieldId(fieldId)
+    , _sampleInterval(sampleInterval)
+    , _capacity(capacity)
+{
+    // Prefer PSRAM, trend data does not need fast internal RAM
+    _samples = static_cast<timeseriesSample_t*>(
+        heap_caps_malloc(capacity * sizeof(timeseriesSample_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (_samples == nullptr) {
+        _samples = static_cast<timeseriesSample_t*>(malloc(capacity * sizeof(timeseriesSample_t)));
+    }
+    if (_samples == nullptr) {
+        _capacity = 0;
+    }
+}
+
+TimeseriesBuffer::~TimeseriesBuffer()
+{
+    free(_samples);
+}
+
+bool TimeseriesBuffer::isValid() const
+{
+    return _samples != nullptr;
+}
+
+ChannelType_t TimeseriesBuffer::getChannelType() const
+{
+    return _type;
+}
+
+ChannelNum_t TimeseriesBuffer::getChannel() const
+{
+    return _channel;
+}
+
+FieldId_t TimeseriesBuffer::getFieldId() const
+{
+    return _fieldId;
+}
+
+uint32_t TimeseriesBuffer::getSampleInterval() const
+{
+    return _sampleInterval;
+}
+
+size_t TimeseriesBuffer::getCapacity() const
+{
+    return _capacity;
+}
+
+size_t TimeseriesBuffer::getSampleCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+void TimeseriesBuffer::push(const uint32_t timestamp, const float value)
+{
+    if (!isValid()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_lastSampleTime != 0 && timestamp - _lastSampleTime < _sampleInterval) {
+        return;
+    }
+    _lastSampleTime = timestamp;
+
+    if (_count < _capacity) {
+        _samples[(_head + _count) % _capacity] = { timestamp, value };
+        _count++;
+    } else {
+        _samples[_head] = { timestamp, value };
+        _head = (_head + 1) % _capacity;
+    }
+}
+
+size_t TimeseriesBuffer::copySamples(timeseriesSample_t* dest, const size_t maxCount, const uint32_t since) const
+{
+    if (!isValid()) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t copied = 0;
+    for (size_t i = 0; i < _count && copied < maxCount; i++) {
+        const timeseriesSample_t& sample = _samples[(_head + i) % _capacity];
+        if (sample.timestamp <= since) {
+            continue;
+        }
+        dest[copied++] = sample;
+    }
+    return copied;
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+#include "StatisticsParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Packed so the buffer can be handed out verbatim by bulk binary readers
+struct __attribute__((packed)) timeseriesSample_t {
+    uint32_t timestamp; // unix epoch, seconds
+    float value;
+};
+
+// In-RAM ring buffer time series for one statistics field. Sample
+// storage is allocated from PSRAM when available and falls back to
+// internal RAM otherwise. Retention is defined by the capacity,
+// decimation by the per-series sample interval.
+class TimeseriesBuffer {
+public:
+    TimeseriesBuffer(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId,
+        const uint32_t sampleInterval, const size_t capacity);
+    ~TimeseriesBuffer();
+
+    TimeseriesBuffer(const TimeseriesBuffer&) = delete;
+    TimeseriesBuffer& operator=(const TimeseriesBuffer&) = delete;
+
+    // false if the sample storage could not be allocated
+    bool isValid() const;
+
+    ChannelType_t getChannelType() const;
+    ChannelNum_t getChannel() const;
+    FieldId_t getFieldId() const;
+    uint32_t getSampleInterval() const;
+    size_t getCapacity() const;
+    size_t getSampleCount() const;
+
+    // Appends a sample. Pushes arriving before the sample interval has
+    // elapsed are dropped, the oldest sample is overwritten when full.
+    void push(const uint32_t timestamp, const float value);
+
+    // Bulk read: copies up to maxCount samples newer than 'since' into
+    // dest in chronological order and returns the copied count.
+    size_t copySamples(timeseriesSample_t* dest, const size_t maxCount, const uint32_t since = 0) const;
+
+private:
+    const ChannelType_t _type;
+    const ChannelNum_t _channel;
+    const FieldId_t _fieldId;
+    const uint32_t _sampleInterval;
+
+    timeseriesSample_t* _samples = nullptr;
+    size_t _capacity;
+    size_t _head = 0; // oldest sample
+    size_t _count = 0;
+    uint32_t _lastSampleTime = 0;
+
+    mutable std::mutex _mutex;
+};
@@ -4,48 +4,180 @@
  */
 #include "CommandQueue.h"
 #include "../inverters/InverterAbstract.h"
+#include <LockMonitor.h>
 #include <algorithm>
 
+void CommandQueue::pushPrioritized(std::shared_ptr<CommandAbstract> cmd)
+{
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
+
+    CommandLane* lane = getLane(cmd->getTargetAddress());
+
+    // The lane front may already be in flight if it belongs to the current
+    // lane and is never touched, so a higher priority command preempts at
+    // the next frame boundary. Within one priority lane the insertion
+    // order is kept.
+    auto it = lane->commands.begin();
+    if (it != lane->commands.end()
+        && _lanes[_currentLane].targetAddress == lane->targetAddress) {
+        ++it;
+    }
+    while (it != lane->commands.end() && (*it)->getQueuePriority() <= cmd->getQueuePriority()) {
+        ++it;
+    }
+    lane->commands.insert(it, cmd);
+}
+
+std::shared_ptr<CommandAbstract> CommandQueue::front()
+{
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
+
+    if (_lanes.empty()) {
+        return nullptr;
+    }
+    return _lanes[_currentLane].commands.front();
+}
+
+void CommandQueue::pop()
+{
+    // destroyed after the lock is released, see eraseLane()
+    std::vector<std::shared_ptr<CommandAbstract>> retired;
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
+
+    if (_lanes.empty()) {
+        return;
+    }
+
+    CommandLane& lane = _lanes[_currentLane];
+    retired.push_back(std::move(lane.commands.front()));
+    lane.commands.pop_front();
+
+    if (lane.commands.empty()) {
+        // eraseLane leaves _currentLane pointing at the next lane
+        eraseLane(_currentLane, retired);
+    } else {
+        // Fair drain: hand the radio over to the next inverter's lane
+        _currentLane = (_currentLane + 1) % _lanes.size();
+    }
+}
+
+unsigned long CommandQueue::size() const
+{
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
+
+    unsigned long count = 0;
+    for (const auto& lane : _lanes) {
+        count += lane.commands.size();
+    }
+    return count;
+}
+
 void CommandQueue::removeAllEntriesForInverter(InverterAbstract* inv)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    // destroyed after the lock is released, see eraseLane()
+    std::vector<std::shared_ptr<CommandAbstract>> retired;
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
 
-    auto it = std::remove_if(_queue.begin(), _queue.end(),
-        [&](const auto& v) { return v->getTargetAddress() == inv->serial(); });
-    _queue.erase(it, _queue.end());
+    for (size_t i = 0; i < _lanes.size(); i++) {
+        if (_lanes[i].targetAddress == inv->serial()) {
+            eraseLane(i, retired);
+            return;
+        }
+    }
 }
 
 void CommandQueue::removeDuplicatedEntries(std::shared_ptr<CommandAbstract> cmd)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    // destroyed after the lock is released, see eraseLane()
+    std::vector<std::shared_ptr<CommandAbstract>> retired;
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
 
-    auto it = std::remove_if(_queue.begin() + 1, _queue.end(),
-        [&](const auto& v) {
-            return cmd->areSameParameter(v.get())
-                && cmd.get()->getQueueInsertType() == QueueInsertType::RemoveOldest;
-        });
-    _queue.erase(it, _queue.end());
+    for (size_t i = 0; i < _lanes.size(); i++) {
+        CommandLane& lane = _lanes[i];
+        if (lane.targetAddress != cmd->getTargetAddress()) {
+            continue;
+        }
+
+        // Skip the possibly in-flight front entry of the current lane
+        auto begin = lane.commands.begin() + ((i == _currentLane) ? 1 : 0);
+        auto it = std::remove_if(begin, lane.commands.end(),
+            [&](const auto& v) {
+                return cmd->areSameParameter(v.get())
+                    && cmd.get()->getQueueInsertType() == QueueInsertType::RemoveOldest;
+            });
+        retired.insert(retired.end(), std::make_move_iterator(it), std::make_move_iterator(lane.commands.end()));
+        lane.commands.erase(it, lane.commands.end());
+
+        if (lane.commands.empty()) {
+            eraseLane(i, retired);
+        }
+        return;
+    }
 }
 
 void CommandQueue::replaceEntries(std::shared_ptr<CommandAbstract> cmd)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    // destroyed after the lock is released, see eraseLane()
+    std::vector<std::shared_ptr<CommandAbstract>> retired;
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
 
-    std::replace_if(_queue.begin() + 1, _queue.end(),
-        [&](const auto& v) {
-            return cmd.get()->getQueueInsertType() == QueueInsertType::ReplaceExistent
-                && cmd->areSameParameter(v.get());
-            },
-        cmd
-    );
+    for (size_t i = 0; i < _lanes.size(); i++) {
+        CommandLane& lane = _lanes[i];
+        if (lane.targetAddress != cmd->getTargetAddress()) {
+            continue;
+        }
+
+        // Skip the possibly in-flight front entry of the current lane
+        auto begin = lane.commands.begin() + ((i == _currentLane) ? 1 : 0);
+        for (auto it = begin; it != lane.commands.end(); ++it) {
+            if (cmd.get()->getQueueInsertType() == QueueInsertType::ReplaceExistent
+                && cmd->areSameParameter(it->get())) {
+                retired.push_back(std::move(*it));
+                *it = cmd;
+            }
+        }
+        return;
+    }
 }
 
 uint8_t CommandQueue::countSimilarCommands(std::shared_ptr<CommandAbstract> cmd)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "commandqueue", _mutex);
+
+    uint8_t count = 0;
+    for (const auto& lane : _lanes) {
+        count += std::count_if(lane.commands.begin(), lane.commands.end(),
+            [&](const auto& v) {
+                return cmd->areSameParameter(v.get());
+            });
+    }
+    return count;
+}
+
+CommandQueue::CommandLane* CommandQueue::getLane(const uint64_t targetAddress)
+{
+    for (auto& lane : _lanes) {
+        if (lane.targetAddress == targetAddress) {
+            return &lane;
+        }
+    }
+
+    _lanes.push_back(CommandLane { targetAddress, {} });
+    return &_lanes.back();
+}
+
+void CommandQueue::eraseLane(const size_t idx, std::vector<std::shared_ptr<CommandAbstract>>& retired)
+{
+    auto& commands = _lanes[idx].commands;
+    retired.insert(retired.end(), std::make_move_iterator(commands.begin()), std::make_move_iterator(commands.end()));
 
-    return std::count_if(_queue.begin(), _queue.end(),
-        [&](const auto& v) {
-            return cmd->areSameParameter(v.get());
-        });
+    _lanes.erase(_lanes.begin() + idx);
+    if (_currentLane > idx) {
+        _currentLane--;
+    }
+    if (_lanes.empty()) {
+        _currentLane = 0;
+    } else {
+        _currentLane %= _lanes.size();
+    }
 }
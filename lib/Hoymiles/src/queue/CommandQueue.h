@@ -2,16 +2,46 @@
 #pragma once
 
 #include "../commands/CommandAbstract.h"
-#include <ThreadSafeQueue.h>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 class InverterAbstract;
 
-class CommandQueue : public ThreadSafeQueue<std::shared_ptr<CommandAbstract>> {
+// Commands are sharded into one lane per target serial and drained
+// round-robin, so the retry backlog of a single unreachable inverter
+// cannot starve commands destined for the other inverters.
+class CommandQueue {
 public:
+    void pushPrioritized(std::shared_ptr<CommandAbstract> cmd);
+    std::shared_ptr<CommandAbstract> front();
+    void pop();
+    unsigned long size() const;
+
     void removeAllEntriesForInverter(InverterAbstract* inv);
     void removeDuplicatedEntries(std::shared_ptr<CommandAbstract> cmd);
     void replaceEntries(std::shared_ptr<CommandAbstract> cmd);
 
     uint8_t countSimilarCommands(std::shared_ptr<CommandAbstract> cmd);
+
+private:
+    struct CommandLane {
+        uint64_t targetAddress;
+        std::deque<std::shared_ptr<CommandAbstract>> commands;
+    };
+
+    // Both helpers expect _mutex to be held by the caller. Erased
+    // commands are moved into retired instead of being destroyed in
+    // place: a still pending command fails its completion callback from
+    // the destructor, which may push a follow-up command - that must
+    // happen after _mutex is released.
+    CommandLane* getLane(const uint64_t targetAddress);
+    void eraseLane(const size_t idx, std::vector<std::shared_ptr<CommandAbstract>>& retired);
+
+    // Invariant: lanes only exist while they contain commands
+    std::vector<CommandLane> _lanes;
+    size_t _currentLane = 0;
+
+    mutable std::mutex _mutex;
 };
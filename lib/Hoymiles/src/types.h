@@ -18,4 +18,7 @@ typedef struct {
     uint8_t channel;
     int8_t rssi;
     bool wasReceived;
+    // Stamped when the frame is drained out of the radio FIFO. Wraps
+    // with micros(), only meaningful for deltas.
+    uint32_t arrivalMicros;
 } fragment_t;
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2026 Thomas Basler and others
+ */
+#include "LockMonitor.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <cstring>
+
+// Zero-initialized statics, safe to register into from constructors of
+// function-local static sites regardless of translation unit order
+static LockMonitorSite* sSites[LOCK_MONITOR_MAX_SITES];
+static std::atomic<size_t> sSiteCount { 0 };
+
+// Edge and stack bookkeeping runs under one spinlock. This is the
+// acquisition slow path of an opt-in debug build; a few hundred
+// nanoseconds of critical section beat torn stacks.
+static portMUX_TYPE sStateLock = portMUX_INITIALIZER_UNLOCKED;
+
+struct Edge {
+    const char* first; // held
+    const char* second; // then acquired
+    uint32_t count;
+};
+static Edge sEdges[LOCK_MONITOR_MAX_EDGES];
+static size_t sEdgeCount = 0;
+
+struct HeldLock {
+    const char* lockName;
+    LockMonitorSite* site;
+    int64_t acquiredUs;
+};
+
+struct TaskStack {
+    TaskHandle_t task;
+    HeldLock held[LOCK_MONITOR_MAX_DEPTH];
+    uint8_t depth;
+};
+static TaskStack sTasks[LOCK_MONITOR_MAX_TASKS];
+static size_t sTaskCount = 0;
+
+LockMonitorSite::LockMonitorSite(const char* lockName, const char* siteName)
+    : _lockName(lockName)
+    , _siteName(siteName)
+{
+    const size_t slot = sSiteCount.fetch_add(1, std::memory_order_acq_rel);
+    if (slot < LOCK_MONITOR_MAX_SITES) {
+        sSites[slot] = this;
+    }
+}
+
+size_t LockMonitorSite::getSiteCount()
+{
+    const size_t count = sSiteCount.load(std::memory_order_acquire);
+    return count < LOCK_MONITOR_MAX_SITES ? count : LOCK_MONITOR_MAX_SITES;
+}
+
+const LockMonitorSite* LockMonitorSite::getSite(const size_t index)
+{
+    return sSites[index];
+}
+
+// expects sStateLock to be held
+static TaskStack* findOrClaimStack(const TaskHandle_t task)
+{
+    for (size_t i = 0; i < sTaskCount; i++) {
+        if (sTasks[i].task == task) {
+            return &sTasks[i];
+        }
+    }
+    if (sTaskCount < LOCK_MONITOR_MAX_TASKS) {
+        sTasks[sTaskCount].task = task;
+        return &sTasks[sTaskCount++];
+    }
+    return nullptr;
+}
+
+// expects sStateLock to be held. Lock identity is the name string, so
+// sites in different translation units compare equal by content.
+static void countEdge(const char* first, const char* second)
+{
+    if (strcmp(first, second) == 0) {
+        // recursive/nested use of the same lock is not an order edge
+        return;
+    }
+
+    for (size_t i = 0; i < sEdgeCount; i++) {
+        if (strcmp(sEdges[i].first, first) == 0 && strcmp(sEdges[i].second, second) == 0) {
+            sEdges[i].count++;
+            return;
+        }
+    }
+    if (sEdgeCount < LOCK_MONITOR_MAX_EDGES) {
+        sEdges[sEdgeCount].first = first;
+        sEdges[sEdgeCount].second = second;
+        sEdges[sEdgeCount].count = 1;
+        sEdgeCount++;
+    }
+}
+
+namespace LockMonitor {
+
+void acquired(LockMonitorSite& site, const uint32_t waitUs)
+{
+    site.recordWait(waitUs);
+
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    const int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&sStateLock);
+    TaskStack* stack = findOrClaimStack(task);
+    if (stack != nullptr) {
+        for (uint8_t i = 0; i < stack->depth; i++) {
+            countEdge(stack->held[i].lockName, site.getLockName());
+        }
+        if (stack->depth < LOCK_MONITOR_MAX_DEPTH) {
+            stack->held[stack->depth++] = { site.getLockName(), &site, now };
+        }
+        // depth overflow: stats still count, the matching released()
+        // simply finds no entry and skips the hold attribution
+    }
+    portEXIT_CRITICAL(&sStateLock);
+}
+
+void released(const char* lockName)
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    const int64_t now = esp_timer_get_time();
+
+    LockMonitorSite* site = nullptr;
+    int64_t acquiredUs = 0;
+
+    portENTER_CRITICAL(&sStateLock);
+    for (size_t i = 0; i < sTaskCount; i++) {
+        if (sTasks[i].task != task) {
+            continue;
+        }
+        TaskStack& stack = sTasks[i];
+        for (int8_t d = stack.depth - 1; d >= 0; d--) {
+            if (strcmp(stack.held[d].lockName, lockName) != 0) {
+                continue;
+            }
+            site = stack.held[d].site;
+            acquiredUs = stack.held[d].acquiredUs;
+            // out-of-order release keeps the stack compact
+            for (uint8_t j = d; j + 1 < stack.depth; j++) {
+                stack.held[j] = stack.held[j + 1];
+            }
+            stack.depth--;
+            break;
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&sStateLock);
+
+    if (site != nullptr) {
+        site->recordHold(static_cast<uint32_t>(now - acquiredUs));
+    }
+}
+
+size_t getEdgeCount()
+{
+    portENTER_CRITICAL(&sStateLock);
+    const size_t count = sEdgeCount;
+    portEXIT_CRITICAL(&sStateLock);
+    return count;
+}
+
+bool getEdge(const size_t index, const char** first, const char** second, uint32_t* count)
+{
+    bool valid = false;
+    portENTER_CRITICAL(&sStateLock);
+    if (index < sEdgeCount) {
+        *first = sEdges[index].first;
+        *second = sEdges[index].second;
+        *count = sEdges[index].count;
+        valid = true;
+    }
+    portEXIT_CRITICAL(&sStateLock);
+    return valid;
+}
+
+} // namespace LockMonitor
+
+LockMonitorGuard::LockMonitorGuard(LockMonitorSite& site, std::mutex& mutex)
+    : _site(site)
+    , _mutex(mutex)
+    , _locked(true)
+{
+    const int64_t start = esp_timer_get_time();
+    _mutex.lock();
+    LockMonitor::acquired(_site, static_cast<uint32_t>(esp_timer_get_time() - start));
+}
+
+void LockMonitorGuard::unlock()
+{
+    if (!_locked) {
+        return;
+    }
+    _locked = false;
+    LockMonitor::released(_site.getLockName());
+    _mutex.unlock();
+}
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Lock contention instrumentation for the debug build. Each guarded
+// acquisition site registers a LockMonitorSite (same self-registration
+// scheme as the CyclePerf probes) recording wait time, hold time and
+// acquisition counts; on top of that a per-task stack of held locks
+// yields the observed lock acquisition orders, so priority-inversion
+// suspects show up as both (A, B) and (B, A) edges in the table.
+// /api/profiler/locks serializes sites and edges.
+//
+// The probes cost two timer reads plus a short critical section per
+// acquisition, which perturbs the very timings under investigation -
+// hence builds opt in with -DLOCKMONITOR_ENABLE=1 and release builds
+// compile the plain guards.
+
+#ifndef LOCKMONITOR_ENABLE
+#define LOCKMONITOR_ENABLE 0
+#endif
+
+// Fixed site table size; registration beyond this is dropped
+#define LOCK_MONITOR_MAX_SITES 32
+
+// Distinct ordered lock pairs ever observed held together
+#define LOCK_MONITOR_MAX_EDGES 32
+
+// Tasks tracked for held-lock stacks, and locks held at once per task
+#define LOCK_MONITOR_MAX_TASKS 12
+#define LOCK_MONITOR_MAX_DEPTH 4
+
+class LockMonitorSite {
+public:
+    LockMonitorSite(const char* lockName, const char* siteName);
+
+    void recordWait(const uint32_t waitUs)
+    {
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _totalWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+        if (waitUs > 0) {
+            _contended.fetch_add(1, std::memory_order_relaxed);
+        }
+        updateMax(_maxWaitUs, waitUs);
+    }
+
+    void recordHold(const uint32_t holdUs)
+    {
+        _totalHoldUs.fetch_add(holdUs, std::memory_order_relaxed);
+        updateMax(_maxHoldUs, holdUs);
+    }
+
+    const char* getLockName() const { return _lockName; }
+    const char* getSiteName() const { return _siteName; }
+    uint32_t getCount() const { return _count.load(std::memory_order_relaxed); }
+    uint32_t getContended() const { return _contended.load(std::memory_order_relaxed); }
+    uint64_t getTotalWaitUs() const { return _totalWaitUs.load(std::memory_order_relaxed); }
+    uint32_t getMaxWaitUs() const { return _maxWaitUs.load(std::memory_order_relaxed); }
+    uint64_t getTotalHoldUs() const { return _totalHoldUs.load(std::memory_order_relaxed); }
+    uint32_t getMaxHoldUs() const { return _maxHoldUs.load(std::memory_order_relaxed); }
+
+    // Registry access for the report endpoint
+    static size_t getSiteCount();
+    static const LockMonitorSite* getSite(const size_t index);
+
+private:
+    static void updateMax(std::atomic<uint32_t>& max, const uint32_t value)
+    {
+        uint32_t seen = max.load(std::memory_order_relaxed);
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    const char* _lockName;
+    const char* _siteName;
+    std::atomic<uint32_t> _count { 0 };
+    std::atomic<uint32_t> _contended { 0 }; // acquisitions with measurable wait
+    std::atomic<uint64_t> _totalWaitUs { 0 };
+    std::atomic<uint32_t> _maxWaitUs { 0 };
+    std::atomic<uint64_t> _totalHoldUs { 0 };
+    std::atomic<uint32_t> _maxHoldUs { 0 };
+};
+
+namespace LockMonitor {
+
+// Call right after the lock is taken: records the wait on the site,
+// pushes the lock onto the calling task's held stack and counts an
+// order edge against every lock this task already holds
+void acquired(LockMonitorSite& site, const uint32_t waitUs);
+
+// Call right before the lock is given back: pops the task's topmost
+// entry for this lock and attributes the hold time to the acquiring
+// site. Matched by name, so take and give may live in different scopes
+// (the Hoymiles semaphore macros do).
+void released(const char* lockName);
+
+// Observed acquisition-order edges, for the report endpoint
+size_t getEdgeCount();
+bool getEdge(const size_t index, const char** first, const char** second, uint32_t* count);
+
+} // namespace LockMonitor
+
+// RAII guard for std::mutex call sites; measures the wait and, via
+// LockMonitor::released, the hold. unlock() mirrors std::unique_lock
+// for sites that drop the lock early.
+class LockMonitorGuard {
+public:
+    LockMonitorGuard(LockMonitorSite& site, std::mutex& mutex);
+    ~LockMonitorGuard() { unlock(); }
+
+    void unlock();
+
+private:
+    LockMonitorSite& _site;
+    std::mutex& _mutex;
+    bool _locked;
+};
+
+#if LOCKMONITOR_ENABLE
+#define LOCK_MONITOR_STR2(x) #x
+#define LOCK_MONITOR_STR(x) LOCK_MONITOR_STR2(x)
+#define LOCK_MONITOR_CONCAT2(a, b) a##b
+#define LOCK_MONITOR_CONCAT(a, b) LOCK_MONITOR_CONCAT2(a, b)
+#define LOCK_MONITOR_GUARD(var, lockName, mutexRef)                      \
+    static LockMonitorSite LOCK_MONITOR_CONCAT(_lockMonitorSite, __LINE__)( \
+        lockName, __FILE__ ":" LOCK_MONITOR_STR(__LINE__));              \
+    LockMonitorGuard var(LOCK_MONITOR_CONCAT(_lockMonitorSite, __LINE__), mutexRef)
+#else
+#define LOCK_MONITOR_GUARD(var, lockName, mutexRef) \
+    std::unique_lock<std::mutex> var(mutexRef)
+#endif
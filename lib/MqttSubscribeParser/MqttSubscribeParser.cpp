@@ -3,14 +3,72 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MqttSubscribeParser.h"
+#include <cstring>
+
+bool MqttSubscribeParser::filter_is_valid(const std::string& topic)
+{
+    if (topic.empty()) {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos <= topic.size()) {
+        const size_t sep = topic.find('/', pos);
+        const std::string_view segment(topic.data() + pos,
+            (sep == std::string::npos ? topic.size() : sep) - pos);
+
+        // wildcards have to occupy a whole level, e.g. "foo+" is invalid
+        if (segment != "+" && segment != "#"
+            && segment.find_first_of("+#") != std::string_view::npos) {
+            return false;
+        }
+
+        // "#" is only allowed as the final level
+        if (segment == "#" && sep != std::string::npos) {
+            return false;
+        }
+
+        if (sep == std::string::npos) {
+            break;
+        }
+        pos = sep + 1;
+    }
+
+    return true;
+}
 
 void MqttSubscribeParser::register_callback(const std::string& topic, uint8_t qos, const OnMessageCallback& cb)
 {
+    if (!filter_is_valid(topic)) {
+        return;
+    }
+
     cb_filter_t cbf;
     cbf.topic = topic;
     cbf.qos = qos;
     cbf.cb = cb;
     _callbacks.push_back(cbf);
+
+    // Insert into the dispatch trie, one node per topic level
+    TrieNode* node = &_root;
+    size_t pos = 0;
+    while (pos <= topic.size()) {
+        const size_t sep = topic.find('/', pos);
+        const std::string_view segment(topic.data() + pos,
+            (sep == std::string::npos ? topic.size() : sep) - pos);
+
+        auto it = node->children.find(segment);
+        if (it == node->children.end()) {
+            it = node->children.emplace(std::string(segment), std::make_unique<TrieNode>()).first;
+        }
+        node = it->second.get();
+
+        if (sep == std::string::npos) {
+            break;
+        }
+        pos = sep + 1;
+    }
+    node->callbacks.push_back(cb);
 }
 
 void MqttSubscribeParser::unregister_callback(const std::string& topic)
@@ -22,150 +80,86 @@ void MqttSubscribeParser::unregister_callback(const std::string& topic)
             ++it;
         }
     }
-}
 
-void MqttSubscribeParser::handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
-{
-    bool result = false;
-    for (const auto& cb : _callbacks) {
-        if (mosquitto_topic_matches_sub(cb.topic.c_str(), topic, &result) == MOSQ_ERR_SUCCESS) {
-            if (result) {
-                cb.cb(properties, topic, payload, len);
-            }
+    // Drop the callbacks at the matching trie node. Empty intermediate
+    // nodes are kept, the handful of command filters does not warrant
+    // pruning logic
+    TrieNode* node = &_root;
+    size_t pos = 0;
+    while (pos <= topic.size()) {
+        const size_t sep = topic.find('/', pos);
+        const std::string_view segment(topic.data() + pos,
+            (sep == std::string::npos ? topic.size() : sep) - pos);
+
+        const auto it = node->children.find(segment);
+        if (it == node->children.end()) {
+            return;
+        }
+        node = it->second.get();
+
+        if (sep == std::string::npos) {
+            break;
         }
+        pos = sep + 1;
     }
+    node->callbacks.clear();
 }
 
-std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+void MqttSubscribeParser::handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
 {
-    return _callbacks;
+    if (topic == nullptr || topic[0] == 0 || strpbrk(topic, "+#") != nullptr) {
+        return; // wildcards are not allowed in a published topic
+    }
+
+    dispatch(_root, topic, true, properties, topic, payload, len);
 }
 
-/* Does a topic match a subscription? */
-int MqttSubscribeParser::mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result)
+// Walks the trie level by level instead of testing every registered
+// filter against the topic. "remaining" points at the part of the topic
+// not consumed yet, nullptr once all levels are matched.
+void MqttSubscribeParser::dispatch(const TrieNode& node, const char* remaining, const bool root,
+    const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len) const
 {
-    size_t spos;
-
-    if (!result)
-        return MOSQ_ERR_INVAL;
-    *result = false;
+    // Topics starting with '$' must not be caught by wildcards at the
+    // first level
+    const bool wildcardsAllowed = !(root && remaining != nullptr && remaining[0] == '$');
 
-    if (!sub || !topic || sub[0] == 0 || topic[0] == 0) {
-        return MOSQ_ERR_INVAL;
+    // "#" matches the remaining levels, including none at all
+    if (wildcardsAllowed) {
+        const auto hash = node.children.find(std::string_view("#"));
+        if (hash != node.children.end()) {
+            for (const auto& cb : hash->second->callbacks) {
+                cb(properties, topic, payload, len);
+            }
+        }
     }
 
-    if ((sub[0] == '$' && topic[0] != '$')
-        || (topic[0] == '$' && sub[0] != '$')) {
-
-        return MOSQ_ERR_SUCCESS;
+    if (remaining == nullptr) {
+        for (const auto& cb : node.callbacks) {
+            cb(properties, topic, payload, len);
+        }
+        return;
     }
 
-    spos = 0;
+    const char* sep = strchr(remaining, '/');
+    const std::string_view segment(remaining,
+        sep != nullptr ? static_cast<size_t>(sep - remaining) : strlen(remaining));
+    const char* rest = (sep != nullptr) ? sep + 1 : nullptr;
 
-    while (sub[0] != 0) {
-        if (topic[0] == '+' || topic[0] == '#') {
-            return MOSQ_ERR_INVAL;
-        }
-        if (sub[0] != topic[0] || topic[0] == 0) { /* Check for wildcard matches */
-            if (sub[0] == '+') {
-                /* Check for bad "+foo" or "a/+foo" subscription */
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                /* Check for bad "foo+" or "foo+/a" subscription */
-                if (sub[1] != 0 && sub[1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                spos++;
-                sub++;
-                while (topic[0] != 0 && topic[0] != '/') {
-                    if (topic[0] == '+' || topic[0] == '#') {
-                        return MOSQ_ERR_INVAL;
-                    }
-                    topic++;
-                }
-                if (topic[0] == 0 && sub[0] == 0) {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            } else if (sub[0] == '#') {
-                /* Check for bad "foo#" subscription */
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                /* Check for # not the final character of the sub, e.g. "#foo" */
-                if (sub[1] != 0) {
-                    return MOSQ_ERR_INVAL;
-                } else {
-                    while (topic[0] != 0) {
-                        if (topic[0] == '+' || topic[0] == '#') {
-                            return MOSQ_ERR_INVAL;
-                        }
-                        topic++;
-                    }
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            } else {
-                /* Check for e.g. foo/bar matching foo/+/# */
-                if (topic[0] == 0
-                    && spos > 0
-                    && sub[-1] == '+'
-                    && sub[0] == '/'
-                    && sub[1] == '#') {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-
-                /* There is no match at this point, but is the sub invalid? */
-                while (sub[0] != 0) {
-                    if (sub[0] == '#' && sub[1] != 0) {
-                        return MOSQ_ERR_INVAL;
-                    }
-                    spos++;
-                    sub++;
-                }
-
-                /* Valid input, but no match */
-                return MOSQ_ERR_SUCCESS;
-            }
-        } else {
-            /* sub[spos] == topic[tpos] */
-            if (topic[1] == 0) {
-                /* Check for e.g. foo matching foo/# */
-                if (sub[1] == '/'
-                    && sub[2] == '#'
-                    && sub[3] == 0) {
-                    *result = true;
-                    return MOSQ_ERR_SUCCESS;
-                }
-            }
-            spos++;
-            sub++;
-            topic++;
-            if (sub[0] == 0 && topic[0] == 0) {
-                *result = true;
-                return MOSQ_ERR_SUCCESS;
-            } else if (topic[0] == 0 && sub[0] == '+' && sub[1] == 0) {
-                if (spos > 0 && sub[-1] != '/') {
-                    return MOSQ_ERR_INVAL;
-                }
-                spos++;
-                sub++;
-                *result = true;
-                return MOSQ_ERR_SUCCESS;
-            }
-        }
+    const auto exact = node.children.find(segment);
+    if (exact != node.children.end()) {
+        dispatch(*exact->second, rest, false, properties, topic, payload, len);
     }
-    if ((topic[0] != 0 || sub[0] != 0)) {
-        *result = false;
-    }
-    while (topic[0] != 0) {
-        if (topic[0] == '+' || topic[0] == '#') {
-            return MOSQ_ERR_INVAL;
+
+    if (wildcardsAllowed) {
+        const auto plus = node.children.find(std::string_view("+"));
+        if (plus != node.children.end()) {
+            dispatch(*plus->second, rest, false, properties, topic, payload, len);
         }
-        topic++;
     }
+}
 
-    return MOSQ_ERR_SUCCESS;
+std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+{
+    return _callbacks;
 }
@@ -3,7 +3,10 @@
 
 #include <cstdint>
 #include <espMqttClient.h>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 typedef std::function<void(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)> OnMessageCallback;
@@ -22,12 +25,18 @@ public:
     std::vector<cb_filter_t> get_callbacks();
 
 private:
-    int mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result);
+    // One node per topic level. Wildcards are stored as the literal
+    // segments "+" and "#", the transparent comparator allows lookups
+    // with string_views into the incoming topic without allocating.
+    struct TrieNode {
+        std::map<std::string, std::unique_ptr<TrieNode>, std::less<>> children;
+        std::vector<OnMessageCallback> callbacks;
+    };
 
-    std::vector<cb_filter_t> _callbacks;
+    static bool filter_is_valid(const std::string& topic);
+    void dispatch(const TrieNode& node, const char* remaining, const bool root,
+        const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len) const;
 
-    enum mosq_err_t {
-        MOSQ_ERR_SUCCESS = 0,
-        MOSQ_ERR_INVAL = 3,
-    };
+    std::vector<cb_filter_t> _callbacks;
+    TrieNode _root;
 };
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "SpiBatch.h"
+
+namespace SpiBatch {
+
+esp_err_t transmit(spi_device_handle_t device, spi_transaction_t* trans, size_t count)
+{
+    if (count == 0)
+        return ESP_OK;
+
+    esp_err_t result = spi_device_acquire_bus(device, portMAX_DELAY);
+    if (result != ESP_OK)
+        return result;
+
+    size_t queued = 0;
+    size_t completed = 0;
+    while (completed < count) {
+        while (queued < count && queued - completed < SPI_MANAGER_BATCH_SIZE) {
+            const esp_err_t err = spi_device_queue_trans(device, &trans[queued], portMAX_DELAY);
+            if (err != ESP_OK) {
+                // Stop feeding the chain; the outer loop still drains
+                // what is already in flight
+                result = err;
+                count = queued;
+                break;
+            }
+            queued++;
+        }
+
+        if (completed == queued)
+            break;
+
+        spi_transaction_t* finished;
+        const esp_err_t err = spi_device_get_trans_result(device, &finished, portMAX_DELAY);
+        if (err != ESP_OK && result == ESP_OK)
+            result = err;
+        completed++;
+    }
+
+    spi_device_release_bus(device);
+    return result;
+}
+
+}
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <driver/spi_master.h>
+#include <cstddef>
+
+// Maximum number of transactions kept in flight per chain; devices that
+// use batching need a queue_size of at least this value
+#define SPI_MANAGER_BATCH_SIZE 8
+
+namespace SpiBatch {
+// Sends `count` prepared transactions as one chained transfer: the bus
+// is acquired once, transactions are queued up to the window size and
+// completions are collected while the driver's ISR moves through the
+// chain. Compared to one polling round trip per transaction this pays
+// the bus arbitration once per chain instead of once per register
+// access. All transaction structs must stay valid until the call
+// returns; results (rx_data) are available afterwards.
+esp_err_t transmit(spi_device_handle_t device, spi_transaction_t* trans, size_t count);
+}
@@ -0,0 +1,90 @@
+# Builds the webapp partition image from webapp_dist/.
+#
+# Image layout (all fields little endian, offsets relative to the start
+# of the image):
+#   header:  <magic u32> <version u32> <count u32> <size u32> <crc u32>
+#   entries: <path 32s> <offset u32> <size u32> <encoding u8> <pad 3x>
+#   payload: concatenated file contents
+# The crc32 covers everything after the header. Files ending in .gz are
+# stored under their name without the suffix with encoding 1 (gzip).
+# When the brotli module is available every gzip asset additionally gets
+# a brotli-compressed sibling entry (encoding 2) under the same path;
+# the firmware negotiates per request via Accept-Encoding. Brotli
+# variants that do not undercut gzip are not worth a table slot and are
+# dropped.
+#
+# The image is flashed to the 'webapp' partition (see
+# partitions_custom_*.csv), included in the factory image by
+# create_factory_bin.py and can be updated independently of the
+# firmware via POST to /api/webapp/update.
+
+Import("env")
+
+import struct
+import zlib
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+from os import makedirs, walk
+from os.path import join, relpath
+
+WEBAPP_DIST = "webapp_dist"
+IMAGE_MAGIC = 0x4F574150  # "OWAP"
+IMAGE_VERSION = 2
+HEADER_SIZE = 20
+ENTRY_SIZE = 44
+
+
+ENCODING_IDENTITY = 0
+ENCODING_GZIP = 1
+ENCODING_BROTLI = 2
+
+
+def build_webapp_image():
+    assets = []
+    for root, dirs, files in walk(WEBAPP_DIST):
+        dirs.sort()
+        for name in sorted(files):
+            full = join(root, name)
+            path = relpath(full, WEBAPP_DIST).replace("\\", "/")
+            gzip = path.endswith(".gz")
+            if gzip:
+                path = path[:-3]
+            if len(path.encode()) >= 32:
+                raise Exception("webapp asset path too long: %s" % path)
+            with open(full, "rb") as f:
+                data = f.read()
+            assets.append((path, ENCODING_GZIP if gzip else ENCODING_IDENTITY, data))
+            if gzip and brotli is not None:
+                raw = zlib.decompress(data, 16 + zlib.MAX_WBITS)
+                br = brotli.compress(raw, quality=11)
+                if len(br) < len(data):
+                    assets.append((path, ENCODING_BROTLI, br))
+    if brotli is None:
+        print("brotli module not available -> webapp image ships gzip only")
+
+    if not assets:
+        print("No webapp assets found -> will NOT create webapp.bin!")
+        return
+
+    offset = HEADER_SIZE + ENTRY_SIZE * len(assets)
+    table = b""
+    payload = b""
+    for path, encoding, data in assets:
+        table += struct.pack("<32sIIB3x", path.encode(), offset, len(data), encoding)
+        payload += data
+        offset += len(data)
+
+    body = table + payload
+    header = struct.pack("<IIIII", IMAGE_MAGIC, IMAGE_VERSION, len(assets), len(body), zlib.crc32(body) & 0xFFFFFFFF)
+
+    makedirs(env.subst("$BUILD_DIR"), exist_ok=True)
+    image_name = env.subst("$BUILD_DIR/webapp.bin")
+    with open(image_name, "wb") as f:
+        f.write(header + body)
+    print("Created %s (%d assets, %d bytes)" % (image_name, len(assets), HEADER_SIZE + len(body)))
+
+
+build_webapp_image()
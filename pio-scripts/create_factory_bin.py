@@ -56,6 +56,8 @@ def esp32_create_combined_bin(source, target, env):
     app_offset = 0x10000
     fs_offset = -1
     fs_name = env.subst("$BUILD_DIR/littlefs.bin")
+    webapp_offset = -1
+    webapp_name = env.subst("$BUILD_DIR/webapp.bin")
 
     with open(env.BoardConfig().get("build.partitions")) as csv_file:
         print("Read partitions from ", env.BoardConfig().get("build.partitions"))
@@ -76,6 +78,11 @@ def esp32_create_combined_bin(source, target, env):
                     partition_size = row[4]
                     if esp32_build_filesystem(fs_name, partition_size):
                         fs_offset = int(row[3], base=16)
+                elif(row[0] == 'webapp'):
+                    if exists(webapp_name):
+                        webapp_offset = int(row[3], base=16)
+                    else:
+                        print("No webapp.bin found -> webapp partition stays empty!")
 
     new_file_name = env.subst("$BUILD_DIR/${PROGNAME}.factory.bin")
     sections = env.subst(env.get("FLASH_EXTRA_IMAGES"))
@@ -121,6 +128,10 @@ def esp32_create_combined_bin(source, target, env):
     print(f" - {hex(app_offset)} | {firmware_name}")
     cmd += [hex(app_offset), firmware_name]
 
+    if webapp_offset != -1:
+        print(f" - {hex(webapp_offset)} | {webapp_name}")
+        cmd += [hex(webapp_offset), webapp_name]
+
     if fs_offset != -1:
         print(f" - {hex(fs_offset)} | {fs_name}")
         cmd += [hex(fs_offset), fs_name]
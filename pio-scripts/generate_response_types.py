@@ -0,0 +1,99 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2025 Thomas Basler and others
+#
+# Generates TypeScript interfaces for the webapp from the response
+# descriptor tables in include/ResponseSchemas.h, so the firmware
+# serializer and the webapp types can never drift apart.
+import os
+import re
+
+Import("env")
+
+SCHEMAS_HEADER = os.path.join(env.subst("$PROJECT_DIR"), "include", "ResponseSchemas.h")
+OUTPUT_DIR = os.path.join(env.subst("$PROJECT_DIR"), "webapp", "src", "types", "generated")
+
+TS_TYPES = {
+    "UInt8": "number",
+    "UInt32": "number",
+    "Int8": "number",
+    "Float": "number",
+    "Bool": "boolean",
+}
+
+SCHEMA_BEGIN_RE = re.compile(r"// SCHEMA: (\w+) version=(\w+)")
+VERSION_RE = re.compile(r"constexpr uint16_t (\w+) = (\d+);")
+FIELD_RE = re.compile(r'SCHEMA_FIELD\([^,]+,\s*\w+,\s*"([\w]+)",\s*(\w+)\)')
+
+
+def updateFileIfChanged(filename, content):
+    mustUpdate = True
+    try:
+        with open(filename, "rb") as fp:
+            if fp.read() == content:
+                mustUpdate = False
+    except:
+        pass
+    if mustUpdate:
+        with open(filename, "wb") as fp:
+            fp.write(content)
+    return mustUpdate
+
+
+def parse_schemas(header_path):
+    schemas = []
+    versions = {}
+    current = None
+    with open(header_path, "r") as fp:
+        for line in fp:
+            match = VERSION_RE.search(line)
+            if match:
+                versions[match.group(1)] = int(match.group(2))
+                continue
+            match = SCHEMA_BEGIN_RE.search(line)
+            if match:
+                if match.group(1) == "end":
+                    current = None
+                else:
+                    current = {"name": match.group(1), "version": match.group(2), "fields": []}
+                    schemas.append(current)
+                continue
+            if current is not None:
+                match = FIELD_RE.search(line)
+                if match:
+                    current["fields"].append((match.group(1), match.group(2)))
+    for schema in schemas:
+        schema["version"] = versions.get(schema["version"], schema["version"])
+    return schemas
+
+
+def emit_schema(schema):
+    lines = []
+    lines.append("// Generated from include/ResponseSchemas.h - Do NOT edit")
+    lines.append("")
+    lines.append("export const %s_SCHEMA_VERSION = %s;" % (to_snake(schema["name"]).upper(), schema["version"]))
+    lines.append("")
+    lines.append("export interface %s {" % schema["name"])
+    for key, field_type in schema["fields"]:
+        lines.append("    %s: %s;" % (key, TS_TYPES[field_type]))
+    lines.append("}")
+    lines.append("")
+    return bytes("\n".join(lines), "utf-8")
+
+
+def to_snake(name):
+    return re.sub(r"(?<!^)(?=[A-Z])", "_", name)
+
+
+def do_main():
+    schemas = parse_schemas(SCHEMAS_HEADER)
+    if not schemas:
+        return
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    for schema in schemas:
+        targetfile = os.path.join(OUTPUT_DIR, schema["name"] + ".ts")
+        if updateFileIfChanged(targetfile, emit_schema(schema)):
+            print("Response types: updated " + os.path.relpath(targetfile, env.subst("$PROJECT_DIR")))
+
+
+do_main()
@@ -0,0 +1,150 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2025 Thomas Basler and others
+#
+# Records per-section sizes and per-object flash/RAM contributions of
+# every build into build_size/<env>.jsonl and diffs them against the
+# previous build of the same env. Optional regression gates:
+#
+#     custom_size_max_flash_delta = 4096
+#     custom_size_max_ram_delta = 512
+#
+# (bytes of growth vs. the previous recorded build; unset = report only)
+#
+import json
+import os
+import subprocess
+import time
+
+Import("env")
+
+HISTORY_DIR = "build_size"
+HISTORY_KEEP = 50
+TOP_MOVERS = 10
+
+# Sections counting towards flash resp. static RAM. .data is in both:
+# it occupies flash (initializer image) and RAM (runtime copy).
+FLASH_SECTIONS = ("text", "rodata", "data")
+RAM_SECTIONS = ("data", "bss", "noinit")
+
+
+def run_size(size_tool, files, args=()):
+    output = ""
+    # chunk to stay below command line length limits
+    for i in range(0, len(files), 50):
+        output += subprocess.check_output(
+            [size_tool, *args, *files[i:i + 50]], universal_newlines=True)
+    return output
+
+
+def collect_sections(size_tool, elf):
+    sections = {}
+    for line in run_size(size_tool, [elf], ["-A"]).splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith("."):
+            try:
+                sections[parts[0].lstrip(".")] = int(parts[1])
+            except ValueError:
+                pass
+    return sections
+
+
+def collect_objects(size_tool, build_dir):
+    objects = []
+    for root, _, files in os.walk(build_dir):
+        objects.extend(os.path.join(root, f) for f in files if f.endswith(".o"))
+    if not objects:
+        return {}
+
+    contributions = {}
+    for line in run_size(size_tool, sorted(objects)).splitlines():
+        parts = line.split()
+        if len(parts) < 6 or not parts[0].isdigit():
+            continue  # header line
+        text, data, bss = int(parts[0]), int(parts[1]), int(parts[2])
+        name = os.path.relpath(parts[5], build_dir)
+        contributions[name] = {"flash": text + data, "ram": data + bss}
+    return contributions
+
+
+def get_revision():
+    try:
+        return subprocess.check_output(
+            ["git", "describe", "--always", "--dirty"],
+            universal_newlines=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def get_limit(option):
+    value = env.GetProjectOption(option, "")
+    return int(value) if str(value).strip() else None
+
+
+def print_movers(previous, current):
+    deltas = []
+    for name in set(previous) | set(current):
+        old = previous.get(name, {"flash": 0, "ram": 0})
+        new = current.get(name, {"flash": 0, "ram": 0})
+        if new["flash"] != old["flash"] or new["ram"] != old["ram"]:
+            deltas.append((name, new["flash"] - old["flash"], new["ram"] - old["ram"]))
+    deltas.sort(key=lambda d: -(abs(d[1]) + abs(d[2])))
+    for name, flash, ram in deltas[:TOP_MOVERS]:
+        print("  %+7d flash %+7d ram  %s" % (flash, ram, name))
+
+
+def track_build_size(source, target, env):
+    size_tool = env.subst("$SIZETOOL")
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    build_dir = env.subst("$BUILD_DIR")
+    env_name = env.subst("$PIOENV")
+
+    sections = collect_sections(size_tool, elf)
+    record = {
+        "timestamp": int(time.time()),
+        "revision": get_revision(),
+        "sections": sections,
+        "flash": sum(sections.get(s, 0) for s in FLASH_SECTIONS),
+        "ram": sum(sections.get(s, 0) for s in RAM_SECTIONS),
+        "objects": collect_objects(size_tool, build_dir),
+    }
+
+    os.makedirs(HISTORY_DIR, exist_ok=True)
+    history_file = os.path.join(HISTORY_DIR, env_name + ".jsonl")
+    history = []
+    if os.path.exists(history_file):
+        with open(history_file) as fp:
+            history = [json.loads(line) for line in fp if line.strip()]
+
+    print("Build size (%s): %d bytes flash, %d bytes static RAM"
+          % (env_name, record["flash"], record["ram"]))
+
+    failed = False
+    if history:
+        previous = history[-1]
+        flash_delta = record["flash"] - previous["flash"]
+        ram_delta = record["ram"] - previous["ram"]
+        print("Delta vs. %s: %+d bytes flash, %+d bytes static RAM"
+              % (previous["revision"], flash_delta, ram_delta))
+        if flash_delta or ram_delta:
+            print_movers(previous.get("objects", {}), record["objects"])
+
+        max_flash = get_limit("custom_size_max_flash_delta")
+        if max_flash is not None and flash_delta > max_flash:
+            print("ERROR: flash grew by %d bytes (limit %d)" % (flash_delta, max_flash))
+            failed = True
+        max_ram = get_limit("custom_size_max_ram_delta")
+        if max_ram is not None and ram_delta > max_ram:
+            print("ERROR: static RAM grew by %d bytes (limit %d)" % (ram_delta, max_ram))
+            failed = True
+
+    history = (history + [record])[-HISTORY_KEEP:]
+    with open(history_file, "w") as fp:
+        for entry in history:
+            fp.write(json.dumps(entry) + "\n")
+
+    if failed:
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", track_build_size)
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "AllocMonitor.h"
+#include <Arduino.h>
+
+#undef TAG
+static const char* TAG = "allocmonitor";
+
+// Length of one accounting window
+#define ALLOC_MONITOR_WINDOW_SECONDS 60
+
+AllocMonitorClass AllocMonitor;
+
+AllocMonitorClass::AllocMonitorClass()
+    : _loopTask(ALLOC_MONITOR_WINDOW_SECONDS * TASK_SECOND, TASK_FOREVER, std::bind(&AllocMonitorClass::loop, this))
+{
+}
+
+void AllocMonitorClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+}
+
+void AllocMonitorClass::count()
+{
+    _totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    TaskHandle_t handle = nullptr;
+    if (!xPortInIsrContext() && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        handle = xTaskGetCurrentTaskHandle();
+    }
+    if (handle == nullptr) {
+        _unattributed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    for (auto& slot : _slots) {
+        TaskHandle_t slotHandle = slot.handle.load(std::memory_order_relaxed);
+        if (slotHandle == nullptr) {
+            // claim the free slot; on a lost race fall through to the
+            // winner's slot
+            if (slot.handle.compare_exchange_strong(slotHandle, handle, std::memory_order_relaxed)) {
+                slotHandle = handle;
+            }
+        }
+        if (slotHandle == handle) {
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    _unattributed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocMonitorClass::loop()
+{
+    const uint32_t total = _totalAllocations.load(std::memory_order_relaxed);
+    const uint32_t windowAllocations = total - _windowBaseline;
+    _windowBaseline = total;
+
+    const Slot* top = nullptr;
+    uint32_t topDelta = 0;
+    for (size_t i = 0; i < ALLOC_MONITOR_SLOT_COUNT; i++) {
+        const uint32_t count = _slots[i].allocations.load(std::memory_order_relaxed);
+        const uint32_t delta = count - _slotWindowBaseline[i];
+        _slotWindowBaseline[i] = count;
+        if (delta > topDelta) {
+            topDelta = delta;
+            top = &_slots[i];
+        }
+    }
+
+    const uint32_t perSecond = windowAllocations / ALLOC_MONITOR_WINDOW_SECONDS;
+    if (perSecond <= ALLOC_MONITOR_BUDGET_PER_SECOND) {
+        return;
+    }
+
+    // The task handle may already belong to a respawned task, in which
+    // case the name is the best attribution available anyway
+    const char* topName = (top != nullptr && top->handle.load(std::memory_order_relaxed) != nullptr)
+        ? pcTaskGetName(top->handle.load(std::memory_order_relaxed))
+        : "unknown";
+    ESP_LOGW(TAG, "Heap churn over budget: %" PRIu32 " allocs/s (budget %d), top task %s with %" PRIu32 " in %ds",
+        perSecond, ALLOC_MONITOR_BUDGET_PER_SECOND, topName, topDelta, ALLOC_MONITOR_WINDOW_SECONDS);
+}
+
+void AllocMonitorClass::serialize(JsonObject root)
+{
+    root["total"] = _totalAllocations.load(std::memory_order_relaxed);
+    root["unattributed"] = _unattributed.load(std::memory_order_relaxed);
+    root["budget_per_second"] = ALLOC_MONITOR_BUDGET_PER_SECOND;
+
+    JsonArray tasks = root["tasks"].to<JsonArray>();
+    for (auto& slot : _slots) {
+        const TaskHandle_t handle = slot.handle.load(std::memory_order_relaxed);
+        if (handle == nullptr) {
+            continue;
+        }
+        JsonObject task = tasks.add<JsonObject>();
+        task["name"] = pcTaskGetName(handle);
+        task["allocations"] = slot.allocations.load(std::memory_order_relaxed);
+    }
+}
+
+// Link-time interception of the allocator entry points (see
+// platformio.ini). The wrappers only bump counters and must never
+// allocate themselves.
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t n, size_t size);
+extern "C" void* __real_realloc(void* ptr, size_t size);
+
+extern "C" void* __wrap_malloc(size_t size)
+{
+    AllocMonitor.count();
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t n, size_t size)
+{
+    AllocMonitor.count();
+    return __real_calloc(n, size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size)
+{
+    AllocMonitor.count();
+    return __real_realloc(ptr, size);
+}
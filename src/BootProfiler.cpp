@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "BootProfiler.h"
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <string.h>
+
+BootProfilerClass BootProfiler;
+
+static constexpr uint32_t bootProfileMagic = 0x4F445450; // "ODTP"
+
+// RTC noinit memory survives watchdog and software resets (not a power
+// cycle), so the profile written here can be read back on the next boot
+RTC_NOINIT_ATTR static BootProfilerClass::Profile rtcBootProfile;
+
+void BootProfilerClass::begin()
+{
+    _previousBootValid = rtcBootProfile.magic == bootProfileMagic
+        && rtcBootProfile.count <= BOOT_PROFILE_MAX_STAGES;
+    if (_previousBootValid) {
+        memcpy(&_previousBoot, &rtcBootProfile, sizeof(_previousBoot));
+    }
+
+    // Record straight into RTC memory so a crash mid-boot still leaves
+    // the partial profile behind for the next boot
+    rtcBootProfile.magic = bootProfileMagic;
+    rtcBootProfile.count = 0;
+}
+
+void BootProfilerClass::mark(const char* name)
+{
+    if (rtcBootProfile.count >= BOOT_PROFILE_MAX_STAGES) {
+        return;
+    }
+
+    Stage& stage = rtcBootProfile.stages[rtcBootProfile.count];
+    strlcpy(stage.name, name, sizeof(stage.name));
+    stage.timestampUs = static_cast<uint32_t>(esp_timer_get_time());
+    rtcBootProfile.count++;
+}
+
+void BootProfilerClass::serializeProfile(const Profile& profile, JsonArray stages)
+{
+    uint32_t previousUs = 0;
+    for (uint32_t i = 0; i < profile.count; i++) {
+        JsonObject stage = stages.add<JsonObject>();
+        stage["name"] = profile.stages[i].name;
+        stage["timestamp_us"] = profile.stages[i].timestampUs;
+        stage["duration_us"] = profile.stages[i].timestampUs - previousUs;
+        previousUs = profile.stages[i].timestampUs;
+    }
+}
+
+void BootProfilerClass::serialize(JsonObject root) const
+{
+    serializeProfile(rtcBootProfile, root["stages"].to<JsonArray>());
+
+    if (_previousBootValid) {
+        serializeProfile(_previousBoot, root["previous_boot_stages"].to<JsonArray>());
+    }
+}
@@ -7,8 +7,10 @@
 #include "Utils.h"
 #include "defaults.h"
 #include <ArduinoJson.h>
+#include <Hoymiles.h>
 #include <LittleFS.h>
 #include <esp_log.h>
+#include <esp_rom_crc.h>
 #include <nvs_flash.h>
 
 #undef TAG
@@ -16,6 +18,15 @@ static const char* TAG = "configuration";
 
 CONFIG_T config;
 
+// Top-level keys of the config document. Each one persists into its
+// own section file so saving a setting only rewrites the section it
+// lives in.
+static constexpr const char* sectionNames[CONFIG_SECTION_COUNT] = {
+    "cfg", "wifi", "mdns", "syslog", "ntp", "mqtt",
+    "dtu", "security", "device", "inverters", "logging",
+    "federation"
+};
+
 static std::condition_variable sWriterCv;
 static std::mutex sWriterMutex;
 static unsigned sWriterCount = 0;
@@ -30,16 +41,13 @@ void ConfigurationClass::init(Scheduler& scheduler)
     memset(&config, 0x0, sizeof(config));
 }
 
-bool ConfigurationClass::write()
+String ConfigurationClass::sectionFilename(const uint8_t section)
 {
-    File f = LittleFS.open(CONFIG_FILENAME, "w");
-    if (!f) {
-        return false;
-    }
-    config.Cfg.SaveCount++;
-
-    JsonDocument doc;
+    return String(CONFIG_SECTION_FILENAME_PREFIX) + sectionNames[section] + ".json";
+}
 
+void ConfigurationClass::serializeSections(JsonDocument& doc)
+{
     JsonObject cfg = doc["cfg"].to<JsonObject>();
     cfg["version"] = config.Cfg.Version;
     cfg["save_count"] = config.Cfg.SaveCount;
@@ -64,6 +72,12 @@ bool ConfigurationClass::write()
     syslog["hostname"] = config.Syslog.Hostname;
     syslog["port"] = config.Syslog.Port;
 
+    JsonObject federation = doc["federation"].to<JsonObject>();
+    federation["enabled"] = config.Federation.Enabled;
+    federation["role"] = config.Federation.Role;
+    federation["peer_hostname"] = config.Federation.PeerHostname;
+    federation["port"] = config.Federation.Port;
+
     JsonObject ntp = doc["ntp"].to<JsonObject>();
     ntp["server"] = config.Ntp.Server;
     ntp["timezone"] = config.Ntp.Timezone;
@@ -82,7 +96,11 @@ bool ConfigurationClass::write()
     mqtt["topic"] = config.Mqtt.Topic;
     mqtt["retain"] = config.Mqtt.Retain;
     mqtt["publish_interval"] = config.Mqtt.PublishInterval;
+    mqtt["full_publish_interval"] = config.Mqtt.FullPublishInterval;
     mqtt["clean_session"] = config.Mqtt.CleanSession;
+    mqtt["compact_json"] = config.Mqtt.CompactJson;
+    mqtt["compact_json_compress"] = config.Mqtt.CompactJsonCompress;
+    mqtt["limit_coalesce_window"] = config.Mqtt.LimitCoalesceWindow;
 
     JsonObject mqtt_lwt = mqtt["lwt"].to<JsonObject>();
     mqtt_lwt["topic"] = config.Mqtt.Lwt.Topic;
@@ -167,14 +185,189 @@ bool ConfigurationClass::write()
         module["level"] = config.Logging.Modules[i].Level;
         module["name"] = config.Logging.Modules[i].Name;
     }
+}
+
+bool ConfigurationClass::write()
+{
+    config.Cfg.SaveCount++;
+
+    // Commit the binary snapshot first. The dual-slot write only ever
+    // targets the stale slot, so this is the crash-consistent commit
+    // point - if a brownout interrupts the section rewrites below, boot
+    // restores the new configuration from the snapshot.
+    bool success = writeSnapshot();
+    _snapshotDirty = false;
+
+    JsonDocument doc;
+    serializeSections(doc);
+
+    if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
+        return false;
+    }
+
+    for (uint8_t s = 0; s < CONFIG_SECTION_COUNT; s++) {
+        String payload;
+        serializeJson(doc[sectionNames[s]], payload);
+
+        const uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length());
+        const String filename = sectionFilename(s);
+        if (crc == _sectionCrc[s] && LittleFS.exists(filename)) {
+            continue;
+        }
+
+        File f = LittleFS.open(filename, "w");
+        if (!f) {
+            ESP_LOGE(TAG, "Failed to open section file %s", filename.c_str());
+            success = false;
+            continue;
+        }
+        if (f.print(payload) != payload.length()) {
+            ESP_LOGE(TAG, "Failed to write section file %s", filename.c_str());
+            success = false;
+        } else {
+            _sectionCrc[s] = crc;
+        }
+        f.close();
+    }
+
+    return success;
+}
+
+// Layout of a snapshot slot: this header followed by the raw CONFIG_T
+// bytes. Struct layout changes must bump CONFIG_VERSION, the size field
+// only catches the obvious mismatches. The sequence number rises with
+// every commit; boot picks the slot carrying the highest one that still
+// checksums clean.
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t sequence;
+    uint32_t crc;
+};
+
+static constexpr uint32_t snapshotMagic = 0x4F445455; // "ODTU"
+static const char* const snapshotSlotNames[2] = { CONFIG_SNAPSHOT_SLOT_A, CONFIG_SNAPSHOT_SLOT_B };
+
+static bool readSnapshotHeader(const char* filename, SnapshotHeader& header)
+{
+    File f = LittleFS.open(filename, "r", false);
+    if (!f) {
+        return false;
+    }
+
+    const bool valid = f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && header.magic == snapshotMagic
+        && header.version == CONFIG_VERSION
+        && header.size == sizeof(CONFIG_T);
+    f.close();
+    return valid;
+}
+
+bool ConfigurationClass::readSnapshot()
+{
+    SnapshotHeader headers[2];
+    bool valid[2];
+    for (uint8_t s = 0; s < 2; s++) {
+        valid[s] = readSnapshotHeader(snapshotSlotNames[s], headers[s]);
+    }
+
+    // Try the newest slot first, the other one only as fallback
+    uint8_t order[2] = { 0, 1 };
+    if (valid[1] && (!valid[0] || headers[1].sequence > headers[0].sequence)) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        const uint8_t s = order[i];
+        if (!valid[s]) {
+            continue;
+        }
+
+        File f = LittleFS.open(snapshotSlotNames[s], "r", false);
+        if (!f) {
+            continue;
+        }
+        f.seek(sizeof(SnapshotHeader));
+        const size_t bytesRead = f.read(reinterpret_cast<uint8_t*>(&config), sizeof(config));
+        f.close();
+
+        if (bytesRead != sizeof(config)
+            || esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&config), sizeof(config)) != headers[s].crc) {
+            // config may be partially overwritten, restore the clean
+            // slate the JSON fallback expects
+            memset(&config, 0x0, sizeof(config));
+            ESP_LOGW(TAG, "Config snapshot slot %s checksum mismatch", snapshotSlotNames[s]);
+            continue;
+        }
+
+        _snapshotSlot = s;
+        _snapshotSequence = headers[s].sequence;
+        ESP_LOGI(TAG, "Configuration restored from binary snapshot slot %s (seq %" PRIu32 ")",
+            snapshotSlotNames[s], _snapshotSequence);
+        return true;
+    }
+
+    ESP_LOGW(TAG, "No valid config snapshot slot, falling back to JSON");
+    return false;
+}
+
+bool ConfigurationClass::writeSnapshot()
+{
+    if (config.Cfg.Version != CONFIG_VERSION) {
+        // Never snapshot an unmigrated configuration
+        return true;
+    }
+
+    SnapshotHeader header;
+    header.magic = snapshotMagic;
+    header.version = config.Cfg.Version;
+    header.size = sizeof(CONFIG_T);
+    header.sequence = _snapshotSequence + 1;
+    header.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&config), sizeof(config));
+
+    // Always overwrite the stale slot; the valid one stays untouched
+    // until the new commit is complete on flash
+    const uint8_t target = 1 - _snapshotSlot;
+    File f = LittleFS.open(snapshotSlotNames[target], "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open config snapshot slot %s", snapshotSlotNames[target]);
+        return false;
+    }
+
+    const bool success = f.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && f.write(reinterpret_cast<const uint8_t*>(&config), sizeof(config)) == sizeof(config);
+    f.close();
+
+    if (!success) {
+        ESP_LOGE(TAG, "Failed to write config snapshot slot %s", snapshotSlotNames[target]);
+        LittleFS.remove(snapshotSlotNames[target]);
+        return false;
+    }
+
+    _snapshotSlot = target;
+    _snapshotSequence = header.sequence;
+    return true;
+}
+
+bool ConfigurationClass::writeExportFile()
+{
+    JsonDocument doc;
+    serializeSections(doc);
 
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
         return false;
     }
 
-    // Serialize JSON to file
+    File f = LittleFS.open(CONFIG_EXPORT_FILENAME, "w");
+    if (!f) {
+        return false;
+    }
+
     if (serializeJson(doc, f) == 0) {
         ESP_LOGE(TAG, "Failed to write file");
+        f.close();
         return false;
     }
 
@@ -182,19 +375,59 @@ bool ConfigurationClass::write()
     return true;
 }
 
-bool ConfigurationClass::read()
+bool ConfigurationClass::loadDocument(JsonDocument& doc)
 {
-    File f = LittleFS.open(CONFIG_FILENAME, "r", false);
-    Utils::skipBom(f);
+    if (LittleFS.exists(CONFIG_FILENAME)) {
+        // Monolithic config.json: either a tree from before the
+        // per-section split or a freshly uploaded backup. Import it.
+        File f = LittleFS.open(CONFIG_FILENAME, "r", false);
+        Utils::skipBom(f);
+
+        const DeserializationError error = deserializeJson(doc, f);
+        if (error) {
+            ESP_LOGW(TAG, "Failed to read file, using default configuration");
+        }
+        f.close();
+        return true;
+    }
 
-    JsonDocument doc;
+    // Assemble the document from the section files; a missing or
+    // broken section falls back to its defaults
+    for (uint8_t s = 0; s < CONFIG_SECTION_COUNT; s++) {
+        File f = LittleFS.open(sectionFilename(s), "r", false);
+        if (!f) {
+            continue;
+        }
+
+        JsonDocument sectionDoc;
+        const DeserializationError error = deserializeJson(sectionDoc, f);
+        f.close();
+        if (error) {
+            ESP_LOGW(TAG, "Failed to read section %s, using default configuration", sectionNames[s]);
+            continue;
+        }
+        doc[sectionNames[s]] = sectionDoc.as<JsonVariantConst>();
+    }
+
+    return false;
+}
 
-    // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
-    if (error) {
-        ESP_LOGW(TAG, "Failed to read file, using default configuration");
+bool ConfigurationClass::read()
+{
+    // Drop the pre-dual-slot snapshot file; its layout no longer parses
+    LittleFS.remove(CONFIG_SNAPSHOT_FILENAME);
+
+    // A monolithic config.json is a fresh import and always wins over
+    // the snapshot
+    if (!LittleFS.exists(CONFIG_FILENAME) && readSnapshot()) {
+        rebuildInverterIndex();
+        ensureDtuSerial();
+        return true;
     }
 
+    JsonDocument doc;
+    const bool monolithImport = loadDocument(doc);
+
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
         return false;
     }
@@ -254,6 +487,12 @@ bool ConfigurationClass::read()
     strlcpy(config.Syslog.Hostname, syslog["hostname"] | "", sizeof(config.Syslog.Hostname));
     config.Syslog.Port = syslog["port"] | SYSLOG_PORT;
 
+    JsonObject federation = doc["federation"];
+    config.Federation.Enabled = federation["enabled"] | FEDERATION_ENABLED;
+    config.Federation.Role = federation["role"] | FEDERATION_ROLE;
+    strlcpy(config.Federation.PeerHostname, federation["peer_hostname"] | "", sizeof(config.Federation.PeerHostname));
+    config.Federation.Port = federation["port"] | FEDERATION_PORT;
+
     JsonObject ntp = doc["ntp"];
     strlcpy(config.Ntp.Server, ntp["server"] | NTP_SERVER, sizeof(config.Ntp.Server));
     strlcpy(config.Ntp.Timezone, ntp["timezone"] | NTP_TIMEZONE, sizeof(config.Ntp.Timezone));
@@ -272,7 +511,11 @@ bool ConfigurationClass::read()
     strlcpy(config.Mqtt.Topic, mqtt["topic"] | MQTT_TOPIC, sizeof(config.Mqtt.Topic));
     config.Mqtt.Retain = mqtt["retain"] | MQTT_RETAIN;
     config.Mqtt.PublishInterval = mqtt["publish_interval"] | MQTT_PUBLISH_INTERVAL;
+    config.Mqtt.FullPublishInterval = mqtt["full_publish_interval"] | MQTT_FULL_PUBLISH_INTERVAL;
     config.Mqtt.CleanSession = mqtt["clean_session"] | MQTT_CLEAN_SESSION;
+    config.Mqtt.CompactJson = mqtt["compact_json"] | MQTT_COMPACT_JSON;
+    config.Mqtt.CompactJsonCompress = mqtt["compact_json_compress"] | MQTT_COMPACT_JSON_COMPRESS;
+    config.Mqtt.LimitCoalesceWindow = mqtt["limit_coalesce_window"] | MQTT_LIMIT_COALESCE_WINDOW;
 
     JsonObject mqtt_lwt = mqtt["lwt"];
     strlcpy(config.Mqtt.Lwt.Topic, mqtt_lwt["topic"] | MQTT_LWT_TOPIC, sizeof(config.Mqtt.Lwt.Topic));
@@ -358,9 +601,23 @@ bool ConfigurationClass::read()
         config.Logging.Modules[i].Level = module["level"] | ESP_LOG_VERBOSE;
     }
 
-    f.close();
+    rebuildInverterIndex();
+    ensureDtuSerial();
 
-    // Check for default DTU serial
+    if (monolithImport && config.Cfg.Version == CONFIG_VERSION) {
+        // The section files are authoritative from now on. When a
+        // version migration is pending, migrate() still needs the
+        // monolith and removes it itself.
+        write();
+        LittleFS.remove(CONFIG_FILENAME);
+    }
+
+    _snapshotDirty = true;
+    return true;
+}
+
+void ConfigurationClass::ensureDtuSerial()
+{
     if (config.Dtu.Serial == DTU_SERIAL) {
         const uint64_t dtuId = Utils::generateDtuSerial();
         config.Dtu.Serial = dtuId;
@@ -371,28 +628,12 @@ bool ConfigurationClass::read()
     } else {
         ESP_LOGI(TAG, "DTU serial check: Using existing serial");
     }
-
-    return true;
 }
 
 void ConfigurationClass::migrate()
 {
-    File f = LittleFS.open(CONFIG_FILENAME, "r", false);
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open file, cancel migration");
-        return;
-    }
-
-    Utils::skipBom(f);
-
     JsonDocument doc;
-
-    // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
-    if (error) {
-        ESP_LOGE(TAG, "Failed to read file, cancel migration: %s", error.c_str());
-        return;
-    }
+    loadDocument(doc);
 
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
         return;
@@ -461,10 +702,9 @@ void ConfigurationClass::migrate()
         config.Logging.Modules[0].Level = ESP_LOG_ERROR;
     }
 
-    f.close();
-
     config.Cfg.Version = CONFIG_VERSION;
     write();
+    LittleFS.remove(CONFIG_FILENAME);
     read();
 }
 
@@ -473,6 +713,33 @@ CONFIG_T const& ConfigurationClass::get()
     return config;
 }
 
+std::shared_ptr<const CONFIG_T> ConfigurationClass::getSnapshot() const
+{
+    auto snapshot = std::atomic_load_explicit(&_snapshot, std::memory_order_acquire);
+    if (!snapshot) {
+        // only reachable before the first read(); fall back to a copy
+        snapshot = std::make_shared<const CONFIG_T>(config);
+    }
+    return snapshot;
+}
+
+void ConfigurationClass::refreshSnapshot()
+{
+    std::shared_ptr<const CONFIG_T> next = std::make_shared<CONFIG_T>(config);
+    std::atomic_store_explicit(&_snapshot, std::move(next), std::memory_order_release);
+}
+
+const INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const CONFIG_T& cfg, const uint64_t serial)
+{
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        if (cfg.Inverter[i].Serial != 0 && cfg.Inverter[i].Serial == serial) {
+            return &cfg.Inverter[i];
+        }
+    }
+
+    return nullptr;
+}
+
 ConfigurationClass::WriteGuard ConfigurationClass::getWriteGuard()
 {
     return WriteGuard();
@@ -491,13 +758,32 @@ INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
 
 INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial)
 {
-    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
-        if (config.Inverter[i].Serial == serial) {
-            return &config.Inverter[i];
+    std::lock_guard<std::mutex> lock(_inverterIndexMutex);
+
+    const auto it = _inverterIndex.find(serial);
+    if (it == _inverterIndex.end() || config.Inverter[it->second].Serial != serial) {
+        return nullptr;
+    }
+
+    return &config.Inverter[it->second];
+}
+
+void ConfigurationClass::rebuildInverterIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(_inverterIndexMutex);
+
+        _inverterIndex.clear();
+        for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+            if (config.Inverter[i].Serial != 0) {
+                _inverterIndex.emplace(config.Inverter[i].Serial, i);
+            }
         }
     }
 
-    return nullptr;
+    // Every mutation path ends up here, so this is also where the
+    // copy-on-write snapshot picks up the new state
+    refreshSnapshot();
 }
 
 void ConfigurationClass::deleteInverterById(const uint8_t id)
@@ -520,6 +806,8 @@ void ConfigurationClass::deleteInverterById(const uint8_t id)
         config.Inverter[id].channel[c].YieldTotalOffset = 0.0f;
         strlcpy(config.Inverter[id].channel[c].Name, "", sizeof(config.Inverter[id].channel[c].Name));
     }
+
+    rebuildInverterIndex();
 }
 
 int8_t ConfigurationClass::getIndexForLogModule(const String& moduleName) const
@@ -533,15 +821,69 @@ int8_t ConfigurationClass::getIndexForLogModule(const String& moduleName) const
     return -1;
 }
 
+void ConfigurationClass::onConfigChanged(const ConfigChangeCallback& cb)
+{
+    _changeCallbacks.push_back(cb);
+}
+
+void ConfigurationClass::notifyConfigChanged(const ConfigScope scope, const int8_t index)
+{
+    for (auto& cb : _changeCallbacks) {
+        cb(scope, index);
+    }
+}
+
+void ConfigurationClass::requestWrite()
+{
+    // Callers request a write right after mutating the config, so this
+    // is also the hook that keeps the serial index current for edits
+    // made outside a WriteGuard (e.g. adding an inverter)
+    rebuildInverterIndex();
+
+    _lastWriteRequest = millis();
+    _writePending = true;
+}
+
+void ConfigurationClass::flushPendingWrites()
+{
+    if (_writePending.exchange(false)) {
+        write();
+    }
+}
+
 void ConfigurationClass::loop()
 {
-    std::unique_lock<std::mutex> lock(sWriterMutex);
-    if (sWriterCount == 0) {
-        return;
+    // Quick successive edits keep pushing the deadline, so a bulk UI
+    // edit ends up as one flash commit
+    static constexpr uint32_t writeDebounceMs = 1000;
+
+    {
+        std::unique_lock<std::mutex> lock(sWriterMutex);
+        if (sWriterCount > 0) {
+            sWriterCv.notify_all();
+            sWriterCv.wait(lock, [] { return sWriterCount == 0; });
+        }
+    }
+
+    // Flash commits run with the flash cache disabled and stall every
+    // task on the core for tens of milliseconds - long enough to miss
+    // fragments of an in-flight RF exchange. Defer the write until the
+    // radios are idle, bounded so a busy fleet cannot starve it; the
+    // radio gap between poll passes opens a window regularly.
+    static constexpr uint32_t writeDeferMaxMs = 5000;
+    const bool flashWindowOpen = Hoymiles.isAllRadioIdle();
+
+    if (_writePending && (millis() - _lastWriteRequest) >= writeDebounceMs) {
+        if (flashWindowOpen || (millis() - _lastWriteRequest) >= writeDebounceMs + writeDeferMaxMs) {
+            flushPendingWrites();
+        }
     }
 
-    sWriterCv.notify_all();
-    sWriterCv.wait(lock, [] { return sWriterCount == 0; });
+    if (_snapshotDirty && flashWindowOpen) {
+        if (_snapshotDirty.exchange(false)) {
+            writeSnapshot();
+        }
+    }
 }
 
 CONFIG_T& ConfigurationClass::WriteGuard::getConfig()
@@ -558,6 +900,9 @@ ConfigurationClass::WriteGuard::WriteGuard()
 
 ConfigurationClass::WriteGuard::~WriteGuard()
 {
+    // The writer may have changed inverter serials
+    Configuration.rebuildInverterIndex();
+
     sWriterCount--;
     if (sWriterCount == 0) {
         sWriterCv.notify_all();
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "CrashRecorder.h"
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <array>
+#include <string.h>
+
+#if __has_include(<esp_private/panic_internal.h>)
+#include <esp_private/panic_internal.h>
+#else
+// minimal mirror of IDF v4.4's panic_info_t (components/esp_system/
+// port/include/esp_private/panic_internal.h) for toolchains that do
+// not export the private header. the layout is stable within the IDF
+// version pinned by platformio.ini.
+typedef struct {
+    int core;
+    int exception;
+    const char* reason;
+    const char* description;
+    void (*details)(const void*);
+    void (*state)(const void*);
+    const void* addr;
+    const void* frame;
+    bool pseudo_excause;
+} panic_info_t;
+#endif
+
+#ifdef __XTENSA__
+#include <esp_cpu_utils.h>
+#include <esp_debug_helpers.h>
+#include <freertos/xtensa_context.h>
+#endif
+
+CrashRecorderClass CrashRecorder;
+
+static constexpr uint32_t crashRecordMagic = 0x4F445443; // "ODTC"
+
+// RTC noinit memory survives panics, watchdog and software resets (not
+// a power cycle), so the record written here can be read back on the
+// next boot
+RTC_NOINIT_ATTR static CrashRecorderClass::Record rtcCrashRecord;
+
+// runs in panic context: no heap, no locks, no logging - plain stores
+// into RTC memory only
+static void recordPanic(panic_info_t* info)
+{
+    if (rtcCrashRecord.magic != crashRecordMagic) {
+        return; // not initialized, nowhere sane to record into
+    }
+
+    rtcCrashRecord.flags |= CrashRecorderClass::FLAG_PANIC;
+    rtcCrashRecord.faultAddr = reinterpret_cast<uint32_t>(info->addr);
+    if (info->reason != nullptr) {
+        strlcpy(rtcCrashRecord.reason, info->reason, sizeof(rtcCrashRecord.reason));
+    }
+
+    rtcCrashRecord.backtraceDepth = 0;
+    rtcCrashRecord.backtraceCorrupt = false;
+
+#ifdef __XTENSA__
+    auto* exc = reinterpret_cast<XtExcFrame*>(const_cast<void*>(info->frame));
+    if (exc == nullptr) {
+        return;
+    }
+
+    esp_backtrace_frame_t frame;
+    frame.pc = exc->pc;
+    frame.sp = exc->a1;
+    frame.next_pc = exc->a0;
+    frame.exc_frame = exc;
+
+    uint8_t depth = 0;
+    rtcCrashRecord.backtrace[depth++] = esp_cpu_process_stack_pc(frame.pc);
+    while (depth < CRASH_RECORDER_BACKTRACE_DEPTH && frame.next_pc != 0) {
+        if (!esp_backtrace_get_next_frame(&frame)) {
+            rtcCrashRecord.backtraceCorrupt = true;
+            break;
+        }
+        rtcCrashRecord.backtrace[depth++] = esp_cpu_process_stack_pc(frame.pc);
+    }
+    rtcCrashRecord.backtraceDepth = depth;
+#endif
+}
+
+extern "C" void __real_esp_panic_handler(panic_info_t* info);
+
+extern "C" void __wrap_esp_panic_handler(panic_info_t* info)
+{
+    recordPanic(info);
+    __real_esp_panic_handler(info);
+}
+
+static void markCleanShutdown()
+{
+    rtcCrashRecord.flags |= CrashRecorderClass::FLAG_CLEAN_SHUTDOWN;
+}
+
+CrashRecorderClass::CrashRecorderClass()
+    : _snapshotTask(10 * TASK_SECOND, TASK_FOREVER, std::bind(&CrashRecorderClass::loop, this))
+{
+}
+
+void CrashRecorderClass::init(Scheduler& scheduler)
+{
+    // a record is only a crash report if the previous boot neither
+    // power cycled (magic gone) nor restarted deliberately
+    _previousValid = rtcCrashRecord.magic == crashRecordMagic
+        && (rtcCrashRecord.flags & FLAG_CLEAN_SHUTDOWN) == 0;
+    if (_previousValid) {
+        memcpy(&_previous, &rtcCrashRecord, sizeof(_previous));
+    }
+
+    memset(&rtcCrashRecord, 0, sizeof(rtcCrashRecord));
+    rtcCrashRecord.magic = crashRecordMagic;
+
+    esp_register_shutdown_handler(markCleanShutdown);
+
+    scheduler.addTask(_snapshotTask);
+    _snapshotTask.enable();
+}
+
+void CrashRecorderClass::note(const char* text)
+{
+    if (rtcCrashRecord.magic != crashRecordMagic) {
+        return;
+    }
+
+    Event& event = rtcCrashRecord.events[rtcCrashRecord.eventSequence % CRASH_RECORDER_EVENT_SLOTS];
+    event.uptimeMs = millis();
+    strlcpy(event.text, text, sizeof(event.text));
+    rtcCrashRecord.eventSequence++;
+}
+
+void CrashRecorderClass::loop()
+{
+    rtcCrashRecord.uptimeS = esp_timer_get_time() / 1000000;
+    rtcCrashRecord.heapFree = ESP.getFreeHeap();
+    rtcCrashRecord.heapMinFree = ESP.getMinFreeHeap();
+    rtcCrashRecord.heapMaxBlock = ESP.getMaxAllocHeap();
+
+    static std::array<char const*, 12> constexpr task_names = {
+        "IDLE0", "IDLE1", "wifi", "tiT", "loopTask", "async_tcp", "mqttclient",
+        "HUAWEI_CAN_0", "PM:SDM", "PM:HTTP+JSON", "PM:SML", "PM:HTTP+SML"
+    };
+
+    uint8_t count = 0;
+    for (char const* task_name : task_names) {
+        if (count >= CRASH_RECORDER_TASK_SLOTS) {
+            break;
+        }
+        TaskHandle_t const handle = xTaskGetHandle(task_name);
+        if (!handle) {
+            continue;
+        }
+        TaskWatermark& entry = rtcCrashRecord.tasks[count];
+        strlcpy(entry.name, task_name, sizeof(entry.name));
+        entry.stackWatermark = uxTaskGetStackHighWaterMark(handle);
+        count++;
+    }
+    rtcCrashRecord.taskCount = count;
+}
+
+void CrashRecorderClass::serialize(JsonObject root) const
+{
+    if (!_previousValid) {
+        return;
+    }
+
+    root["panic"] = (_previous.flags & FLAG_PANIC) != 0;
+    if (_previous.flags & FLAG_PANIC) {
+        root["reason"] = _previous.reason;
+        root["fault_addr"] = String(_previous.faultAddr, HEX);
+        root["backtrace_corrupt"] = _previous.backtraceCorrupt;
+
+        JsonArray backtrace = root["backtrace"].to<JsonArray>();
+        for (uint8_t i = 0; i < _previous.backtraceDepth && i < CRASH_RECORDER_BACKTRACE_DEPTH; i++) {
+            backtrace.add(String(_previous.backtrace[i], HEX));
+        }
+    }
+
+    root["uptime"] = _previous.uptimeS;
+    root["heap_free"] = _previous.heapFree;
+    root["heap_min_free"] = _previous.heapMinFree;
+    root["heap_max_block"] = _previous.heapMaxBlock;
+
+    JsonArray tasks = root["task_stack_watermarks"].to<JsonArray>();
+    for (uint8_t i = 0; i < _previous.taskCount && i < CRASH_RECORDER_TASK_SLOTS; i++) {
+        JsonObject task = tasks.add<JsonObject>();
+        task["name"] = _previous.tasks[i].name;
+        task["stack_watermark"] = _previous.tasks[i].stackWatermark;
+    }
+
+    JsonArray events = root["events"].to<JsonArray>();
+    const uint32_t total = _previous.eventSequence;
+    const uint32_t count = total < CRASH_RECORDER_EVENT_SLOTS ? total : CRASH_RECORDER_EVENT_SLOTS;
+    for (uint32_t i = total - count; i < total; i++) {
+        const Event& entry = _previous.events[i % CRASH_RECORDER_EVENT_SLOTS];
+        JsonObject event = events.add<JsonObject>();
+        event["uptime_ms"] = entry.uptimeMs;
+        event["text"] = entry.text;
+    }
+}
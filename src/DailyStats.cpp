@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "DailyStats.h"
+#include "FleetWalk.h"
+#include <algorithm>
+#include <cmath>
+
+DailyStatsClass DailyStats;
+
+// marker position increments of the P-squared estimator for p = 0.5
+static constexpr float MEDIAN_DN[5] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
+
+void DailyStatsClass::init()
+{
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+
+    FleetWalk.registerVisitor({ "dailystats",
+        std::bind(&DailyStatsClass::beginPass, this),
+        std::bind(&DailyStatsClass::visit, this, _1, _2),
+        nullptr });
+}
+
+bool DailyStatsClass::beginPass()
+{
+    struct tm timeinfo;
+    const bool timeSynced = getLocalTime(&timeinfo, 5);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (timeSynced && timeinfo.tm_yday != _lastDay) {
+        // Local midnight (or first sync): the accumulation day rolls
+        // over. The first observed day starts mid-day and is partial.
+        resetAll();
+        _lastDay = timeinfo.tm_yday;
+        struct tm dayStart = timeinfo;
+        dayStart.tm_hour = 0;
+        dayStart.tm_min = 0;
+        dayStart.tm_sec = 0;
+        _dayStart = mktime(&dayStart);
+    }
+
+    _passNow = time(nullptr);
+    return true;
+}
+
+void DailyStatsClass::visit(std::shared_ptr<InverterAbstract>& inv, const uint8_t pos)
+{
+    if (!inv->isReachable()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    InverterDaily_t* slot = getSlot(inv->serial());
+    if (slot == nullptr) {
+        return;
+    }
+
+    // one sample per received payload, not per scheduler pass
+    const uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
+    if (lastUpdate == 0 || lastUpdate == slot->lastUpdate) {
+        return;
+    }
+    slot->lastUpdate = lastUpdate;
+
+    for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+        ChannelDaily_t& channel = slot->channels[c];
+        const float power = inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+        const float voltage = inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_UDC);
+
+        const bool first = channel.samples == 0;
+        recordExtreme(channel.power, power, _passNow, first);
+        recordExtreme(channel.voltage, voltage, _passNow, first);
+        sketchAdd(channel.powerSketch, power);
+        channel.samples++;
+    }
+}
+
+bool DailyStatsClass::getChannelStats(const uint64_t serial, const uint8_t channel, ChannelDailyStats_t& stats)
+{
+    if (channel >= CH_CNT) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& slot : _slots) {
+        if (slot.serial != serial) {
+            continue;
+        }
+        const ChannelDaily_t& src = slot.channels[channel];
+        if (src.samples == 0) {
+            return false;
+        }
+        stats.samples = src.samples;
+        stats.powerMin = src.power.min;
+        stats.powerMax = src.power.max;
+        stats.powerMedian = sketchEstimate(src.powerSketch);
+        stats.powerMinAt = src.power.minAt;
+        stats.powerMaxAt = src.power.maxAt;
+        stats.voltageMin = src.voltage.min;
+        stats.voltageMax = src.voltage.max;
+        stats.voltageMinAt = src.voltage.minAt;
+        stats.voltageMaxAt = src.voltage.maxAt;
+        return true;
+    }
+    return false;
+}
+
+time_t DailyStatsClass::getDayStart()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _dayStart;
+}
+
+DailyStatsClass::InverterDaily_t* DailyStatsClass::getSlot(const uint64_t serial)
+{
+    InverterDaily_t* freeSlot = nullptr;
+    for (auto& slot : _slots) {
+        if (slot.serial == serial) {
+            return &slot;
+        }
+        if (slot.serial == 0 && freeSlot == nullptr) {
+            freeSlot = &slot;
+        }
+    }
+    if (freeSlot != nullptr) {
+        freeSlot->serial = serial;
+    }
+    return freeSlot;
+}
+
+void DailyStatsClass::resetAll()
+{
+    for (auto& slot : _slots) {
+        slot = InverterDaily_t();
+    }
+}
+
+void DailyStatsClass::recordExtreme(Extreme_t& extreme, const float value, const time_t now, const bool first)
+{
+    if (first || value < extreme.min) {
+        extreme.min = value;
+        extreme.minAt = now;
+    }
+    if (first || value > extreme.max) {
+        extreme.max = value;
+        extreme.maxAt = now;
+    }
+}
+
+void DailyStatsClass::sketchAdd(QuantileSketch_t& sketch, const float value)
+{
+    if (sketch.count < 5) {
+        // collect the first five observations, keep them sorted
+        sketch.q[sketch.count++] = value;
+        std::sort(sketch.q, sketch.q + sketch.count);
+        if (sketch.count == 5) {
+            for (uint8_t i = 0; i < 5; i++) {
+                sketch.n[i] = i + 1;
+                sketch.np[i] = 1.0f + 4.0f * MEDIAN_DN[i];
+            }
+        }
+        return;
+    }
+
+    // locate the cell of the new observation, clamping the outer
+    // markers to the observed extremes
+    uint8_t k;
+    if (value < sketch.q[0]) {
+        sketch.q[0] = value;
+        k = 0;
+    } else if (value >= sketch.q[4]) {
+        sketch.q[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && value >= sketch.q[k + 1]) {
+            k++;
+        }
+    }
+
+    for (uint8_t i = k + 1; i < 5; i++) {
+        sketch.n[i]++;
+    }
+    for (uint8_t i = 0; i < 5; i++) {
+        sketch.np[i] += MEDIAN_DN[i];
+    }
+    sketch.count++;
+
+    // move the inner markers towards their desired positions, with a
+    // parabolic height adjustment when possible, linear otherwise
+    for (uint8_t i = 1; i < 4; i++) {
+        const float d = sketch.np[i] - sketch.n[i];
+        if ((d >= 1.0f && sketch.n[i + 1] - sketch.n[i] > 1)
+            || (d <= -1.0f && sketch.n[i - 1] - sketch.n[i] < -1)) {
+            const int32_t ds = d >= 0 ? 1 : -1;
+            const float qParabolic = sketch.q[i]
+                + static_cast<float>(ds) / (sketch.n[i + 1] - sketch.n[i - 1])
+                    * ((sketch.n[i] - sketch.n[i - 1] + ds) * (sketch.q[i + 1] - sketch.q[i]) / (sketch.n[i + 1] - sketch.n[i])
+                        + (sketch.n[i + 1] - sketch.n[i] - ds) * (sketch.q[i] - sketch.q[i - 1]) / (sketch.n[i] - sketch.n[i - 1]));
+            if (sketch.q[i - 1] < qParabolic && qParabolic < sketch.q[i + 1]) {
+                sketch.q[i] = qParabolic;
+            } else {
+                sketch.q[i] += static_cast<float>(ds) * (sketch.q[i + ds] - sketch.q[i]) / (sketch.n[i + ds] - sketch.n[i]);
+            }
+            sketch.n[i] += ds;
+        }
+    }
+}
+
+float DailyStatsClass::sketchEstimate(const QuantileSketch_t& sketch)
+{
+    if (sketch.count == 0) {
+        return 0;
+    }
+    if (sketch.count < 5) {
+        // not enough observations for the markers yet; the collected
+        // values are sorted, take the middle one
+        return sketch.q[(sketch.count - 1) / 2];
+    }
+    return sketch.q[2];
+}
@@ -4,7 +4,15 @@
  */
 #include "Datastore.h"
 #include "Configuration.h"
+#include "SchedulerMonitor.h"
+#include "Utils.h"
 #include <Hoymiles.h>
+#include <LockMonitor.h>
+#include <algorithm>
+#include <esp_log.h>
+
+#undef TAG
+static const char* TAG = "datastore";
 
 DatastoreClass Datastore;
 
@@ -16,7 +24,28 @@ DatastoreClass::DatastoreClass()
 void DatastoreClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.enable();
+    SchedulerMonitor.instrument("datastore", _loopTask, std::bind(&DatastoreClass::loop, this));
+    Utils::enableStaggered(_loopTask);
+
+    // Recompute aggregates the moment fresh statistics arrive instead
+    // of waiting for the next periodic pass. The interval remains as a
+    // fallback for timeout-driven state (reachability decay).
+    InverterAbstract::onStatisticsUpdated([this](InverterAbstract&) {
+        _loopTask.forceNextIteration();
+    });
+
+    // Built-in derived metrics; previously computed off-device by the
+    // head-end poller from the published totals
+    registerDerivedMetric("conversion_efficiency", "%",
+        METRIC_INPUT_AC_POWER | METRIC_INPUT_DC_POWER,
+        [](const TotalsSnapshot_t& t) {
+            return t.DcPowerEnabled > 0 ? t.AcPowerEnabled / t.DcPowerEnabled * 100.0f : 0.0f;
+        });
+    registerDerivedMetric("specific_yield_day", "Wh/W",
+        METRIC_INPUT_AC_YIELD_DAY | METRIC_INPUT_DC_IRRADIATION,
+        [](const TotalsSnapshot_t& t) {
+            return t.DcIrradiationInstalled > 0 ? t.AcYieldDayEnabled / t.DcIrradiationInstalled : 0.0f;
+        });
 }
 
 void DatastoreClass::loop()
@@ -30,186 +59,292 @@ void DatastoreClass::loop()
     uint8_t isReachable = 0;
     uint8_t pollEnabledCount = 0;
 
-    std::lock_guard<std::mutex> lock(_mutex);
-
-    _totalAcYieldTotalEnabled = 0;
-    _totalAcYieldTotalDigits = 0;
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
 
-    _totalAcYieldDayEnabled = 0;
-    _totalAcYieldDayDigits = 0;
+    const bool wasAtLeastOneReachable = _isAtLeastOneReachable;
+    const bool wasAtLeastOneProducing = _isAtLeastOneProducing;
+    const bool wasAllEnabledProducing = _isAllEnabledProducing;
+    const bool wasAllEnabledReachable = _isAllEnabledReachable;
+    const bool wasAtLeastOnePollEnabled = _isAtLeastOnePollEnabled;
 
-    _totalAcPowerEnabled = 0;
-    _totalAcPowerDigits = 0;
-
-    _totalDcPowerEnabled = 0;
-    _totalDcPowerDigits = 0;
-
-    _totalDcPowerIrradiation = 0;
-    _totalDcIrradiationInstalled = 0;
+    const float wasAcPower = _totalAcPowerEnabled;
+    const float wasDcPower = _totalDcPowerEnabled;
+    const float wasAcYieldDay = _totalAcYieldDayEnabled;
+    const float wasAcYieldTotal = _totalAcYieldTotalEnabled;
+    const float wasDcPowerIrradiation = _totalDcPowerIrradiation;
+    const float wasDcIrradiationInstalled = _totalDcIrradiationInstalled;
 
     _isAllEnabledProducing = true;
     _isAllEnabledReachable = true;
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        if (inv == nullptr) {
-            continue;
-        }
+    // Walk the contiguous hot-state mirror instead of dereferencing
+    // every inverter through shared_ptr and parser objects each second
+    HoymilesClass::InverterSnapshot_t snapshots[INV_MAX_COUNT];
+    const size_t snapshotCount = Hoymiles.copyInverterSnapshots(snapshots, INV_MAX_COUNT);
+
+    // lock-free, consistent config view for the whole pass
+    const auto cfg = Configuration.getSnapshot();
+
+    for (size_t i = 0; i < snapshotCount; i++) {
+        const auto& s = snapshots[i];
 
-        auto cfg = Configuration.getInverterConfig(inv->serial());
-        if (cfg == nullptr) {
+        if (ConfigurationClass::getInverterConfig(*cfg, s.serial) == nullptr) {
             continue;
         }
 
-        if (inv->getEnablePolling()) {
+        if (s.pollEnabled) {
             pollEnabledCount++;
         }
 
-        if (inv->isProducing()) {
+        if (s.producing) {
             isProducing++;
         } else {
-            if (inv->getEnablePolling()) {
+            if (s.pollEnabled) {
                 _isAllEnabledProducing = false;
             }
         }
 
-        if (inv->isReachable()) {
+        if (s.reachable) {
             isReachable++;
         } else {
-            if (inv->getEnablePolling()) {
+            if (s.pollEnabled) {
                 _isAllEnabledReachable = false;
             }
         }
+    }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_INV)) {
-            if (cfg->Poll_Enable) {
-                _totalAcYieldTotalEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YT);
-                _totalAcYieldDayEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YD);
+    // Totals are aggregated from the columnar fleet store, which the
+    // statistics parsers keep current on payload completion, instead of
+    // walking every inverter and channel through parser calls.
+    auto& fleet = Hoymiles.getFleetStore();
 
-                _totalAcYieldTotalDigits = max<unsigned int>(_totalAcYieldTotalDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
-                _totalAcYieldDayDigits = max<unsigned int>(_totalAcYieldDayDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
-            }
-        }
+    _totalAcYieldTotalEnabled = fleet.sum(FLEET_COL_AC_YIELD_TOTAL);
+    _totalAcYieldDayEnabled = fleet.sum(FLEET_COL_AC_YIELD_DAY);
+    _totalAcPowerEnabled = fleet.sum(FLEET_COL_AC_POWER);
+    _totalDcPowerEnabled = fleet.sum(FLEET_COL_DC_POWER);
+    _totalDcPowerIrradiation = fleet.sum(FLEET_COL_DC_POWER_IRR);
+    _totalDcIrradiationInstalled = fleet.sum(FLEET_COL_DC_IRR_INSTALLED);
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_AC)) {
-            if (inv->getEnablePolling()) {
-                _totalAcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_AC, c, FLD_PAC);
-                _totalAcPowerDigits = max<unsigned int>(_totalAcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
-            }
+    _totalAcYieldTotalDigits = static_cast<uint32_t>(fleet.maxValue(FLEET_COL_AC_YIELD_TOTAL_DIGITS));
+    _totalAcYieldDayDigits = static_cast<uint32_t>(fleet.maxValue(FLEET_COL_AC_YIELD_DAY_DIGITS));
+    _totalAcPowerDigits = static_cast<uint32_t>(fleet.maxValue(FLEET_COL_AC_POWER_DIGITS));
+    _totalDcPowerDigits = static_cast<uint32_t>(fleet.maxValue(FLEET_COL_DC_POWER_DIGITS));
+
+    _isAtLeastOneProducing = isProducing > 0;
+    _isAtLeastOneReachable = isReachable > 0;
+    _isAtLeastOnePollEnabled = pollEnabledCount > 0;
+
+    _totalDcIrradiation = _totalDcIrradiationInstalled > 0 ? _totalDcPowerIrradiation / _totalDcIrradiationInstalled * 100.0f : 0;
+
+    // publish the lock-free snapshot: bump the sequence to odd while
+    // writing, back to even when the copy is consistent again
+    _snapshotSeq.fetch_add(1, std::memory_order_acq_rel);
+    _totalsSnapshot.AcPowerEnabled = _totalAcPowerEnabled;
+    _totalsSnapshot.AcYieldDayEnabled = _totalAcYieldDayEnabled;
+    _totalsSnapshot.AcYieldTotalEnabled = _totalAcYieldTotalEnabled;
+    _totalsSnapshot.DcPowerEnabled = _totalDcPowerEnabled;
+    _totalsSnapshot.DcIrradiation = _totalDcIrradiation;
+    _totalsSnapshot.DcPowerIrradiation = _totalDcPowerIrradiation;
+    _totalsSnapshot.DcIrradiationInstalled = _totalDcIrradiationInstalled;
+    _totalsSnapshot.AcPowerDigits = _totalAcPowerDigits;
+    _totalsSnapshot.AcYieldDayDigits = _totalAcYieldDayDigits;
+    _totalsSnapshot.AcYieldTotalDigits = _totalAcYieldTotalDigits;
+    _totalsSnapshot.DcPowerDigits = _totalDcPowerDigits;
+    _totalsSnapshot.IsAtLeastOneReachable = _isAtLeastOneReachable;
+    _totalsSnapshot.IsAtLeastOneProducing = _isAtLeastOneProducing;
+    _totalsSnapshot.IsAllEnabledReachable = _isAllEnabledReachable;
+    _totalsSnapshot.IsAllEnabledProducing = _isAllEnabledProducing;
+    _totalsSnapshot.IsAtLeastOnePollEnabled = _isAtLeastOnePollEnabled;
+    _snapshotSeq.fetch_add(1, std::memory_order_release);
+
+    const bool fleetStateChanged = wasAtLeastOneReachable != _isAtLeastOneReachable
+        || wasAtLeastOneProducing != _isAtLeastOneProducing
+        || wasAllEnabledProducing != _isAllEnabledProducing
+        || wasAllEnabledReachable != _isAllEnabledReachable
+        || wasAtLeastOnePollEnabled != _isAtLeastOnePollEnabled;
+
+    uint32_t changedInputs = 0;
+    if (wasAcPower != _totalAcPowerEnabled) {
+        changedInputs |= METRIC_INPUT_AC_POWER;
+    }
+    if (wasDcPower != _totalDcPowerEnabled) {
+        changedInputs |= METRIC_INPUT_DC_POWER;
+    }
+    if (wasAcYieldDay != _totalAcYieldDayEnabled) {
+        changedInputs |= METRIC_INPUT_AC_YIELD_DAY;
+    }
+    if (wasAcYieldTotal != _totalAcYieldTotalEnabled) {
+        changedInputs |= METRIC_INPUT_AC_YIELD_TOTAL;
+    }
+    if (wasDcPowerIrradiation != _totalDcPowerIrradiation
+        || wasDcIrradiationInstalled != _totalDcIrradiationInstalled) {
+        changedInputs |= METRIC_INPUT_DC_IRRADIATION;
+    }
+    if (fleetStateChanged) {
+        changedInputs |= METRIC_INPUT_FLEET_STATE;
+    }
+
+    for (auto& metric : _derivedMetrics) {
+        if (metric.valid && (metric.dependsOn & changedInputs) == 0) {
+            continue;
         }
+        metric.value = metric.compute(_totalsSnapshot);
+        metric.valid = true;
+    }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
-            if (inv->getEnablePolling()) {
-                _totalDcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                _totalDcPowerDigits = max<unsigned int>(_totalDcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
+    // notify without the lock held, listeners may call the getters
+    lock.unlock();
 
-                if (inv->Statistics()->getStringMaxPower(c) > 0) {
-                    _totalDcPowerIrradiation += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                    _totalDcIrradiationInstalled += inv->Statistics()->getStringMaxPower(c);
-                }
-            }
+    if (fleetStateChanged) {
+        for (auto& listener : _fleetStateListeners) {
+            listener();
         }
     }
+}
 
-    _isAtLeastOneProducing = isProducing > 0;
-    _isAtLeastOneReachable = isReachable > 0;
-    _isAtLeastOnePollEnabled = pollEnabledCount > 0;
+void DatastoreClass::onFleetStateChanged(std::function<void()> listener)
+{
+    _fleetStateListeners.push_back(std::move(listener));
+}
 
-    _totalDcIrradiation = _totalDcIrradiationInstalled > 0 ? _totalDcPowerIrradiation / _totalDcIrradiationInstalled * 100.0f : 0;
+void DatastoreClass::registerDerivedMetric(const char* name, const char* unit, const uint32_t dependsOn,
+    std::function<float(const TotalsSnapshot_t&)> compute)
+{
+    if (_derivedMetrics.size() >= MAX_DERIVED_METRICS) {
+        ESP_LOGW(TAG, "Derived metric limit reached, ignoring '%s'", name);
+        return;
+    }
+    _derivedMetrics.push_back({ name, unit, dependsOn, std::move(compute) });
+}
+
+size_t DatastoreClass::copyDerivedMetrics(DerivedMetricValue_t out[], const size_t maxCount)
+{
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
+    const size_t count = std::min(_derivedMetrics.size(), maxCount);
+    for (size_t i = 0; i < count; i++) {
+        const auto& metric = _derivedMetrics[i];
+        out[i] = { metric.name, metric.unit, metric.value, metric.valid };
+    }
+    return count;
+}
+
+DatastoreClass::TotalsSnapshot_t DatastoreClass::getTotalsSnapshot() const
+{
+    // The classic unbounded seqlock spin is unsafe here: readers run on
+    // the async_tcp task, which shares core 1 with the producer's
+    // loopTask at higher priority. Spinning while the sequence is odd
+    // would then keep the producer from ever closing its write window
+    // and starve the idle task until the task watchdog resets. After a
+    // few quick attempts the reader therefore blocks for a tick, giving
+    // the producer room to finish.
+    TotalsSnapshot_t copy;
+    for (uint8_t attempt = 0;; attempt++) {
+        const uint32_t seqBefore = _snapshotSeq.load(std::memory_order_acquire);
+        if ((seqBefore & 1) == 0) {
+            copy = _totalsSnapshot;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_snapshotSeq.load(std::memory_order_relaxed) == seqBefore) {
+                return copy;
+            }
+        }
+        if (attempt >= 3) {
+            delay(1);
+        }
+    }
 }
 
 float DatastoreClass::getTotalAcYieldTotalEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcYieldTotalEnabled;
 }
 
 float DatastoreClass::getTotalAcYieldDayEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcYieldDayEnabled;
 }
 
 float DatastoreClass::getTotalAcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalDcPowerEnabled;
 }
 
 float DatastoreClass::getTotalDcPowerIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalDcPowerIrradiation;
 }
 
 float DatastoreClass::getTotalDcIrradiationInstalled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalDcIrradiationInstalled;
 }
 
 float DatastoreClass::getTotalDcIrradiation()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalDcIrradiation;
 }
 
 uint32_t DatastoreClass::getTotalAcYieldTotalDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcYieldTotalDigits;
 }
 
 uint32_t DatastoreClass::getTotalAcYieldDayDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcYieldDayDigits;
 }
 
 uint32_t DatastoreClass::getTotalAcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalAcPowerDigits;
 }
 
 uint32_t DatastoreClass::getTotalDcPowerDigits()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _totalDcPowerDigits;
 }
 
 bool DatastoreClass::getIsAtLeastOneReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _isAtLeastOneReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOneProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _isAtLeastOneProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledProducing()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _isAllEnabledProducing;
 }
 
 bool DatastoreClass::getIsAllEnabledReachable()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _isAllEnabledReachable;
 }
 
 bool DatastoreClass::getIsAtLeastOnePollEnabled()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    LOCK_MONITOR_GUARD(lock, "datastore", _mutex);
     return _isAtLeastOnePollEnabled;
 }
@@ -7,10 +7,23 @@
 #include "Datastore.h"
 #include "I18n.h"
 #include "PinMapping.h"
+#include "SchedulerMonitor.h"
+#include "SunPosition.h"
+#include <Hoymiles.h>
 #include <NetworkSettings.h>
+#include <algorithm>
+#include <esp_timer.h>
 #include <map>
 #include <time.h>
 
+// CPU budget for composing the live data page; overruns are logged so
+// a future, more complex page shows up in the logs before it shows up
+// as radio timing jitter
+#define COMPOSE_BUDGET_US 20000
+
+#undef TAG
+static const char* TAG = "display";
+
 std::map<DisplayType_t, std::function<U8G2*(uint8_t, uint8_t, uint8_t, uint8_t)>> display_types = {
     { DisplayType_t::PCD8544, [](uint8_t reset, uint8_t clock, uint8_t data, uint8_t cs) { return new U8G2_PCD8544_84X48_F_4W_HW_SPI(U8G2_R0, cs, data, reset); } },
     { DisplayType_t::SSD1306, [](uint8_t reset, uint8_t clock, uint8_t data, uint8_t cs) { return new U8G2_SSD1306_128X64_NONAME_F_HW_I2C(U8G2_R0, reset, clock, data); } },
@@ -38,7 +51,8 @@ static const char* const i18n_yield_total_mwh[] = { "total: %.0f kWh", "Ges.: %.
 static const char* const i18n_date_format[] = { "%m/%d/%Y %H:%M", "%d.%m.%Y %H:%M", "%d/%m/%Y %H:%M" };
 
 DisplayGraphicClass::DisplayGraphicClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&DisplayGraphicClass::loop, this))
+    : _composeTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&DisplayGraphicClass::composeLoop, this))
+    , _blitTask(TASK_IMMEDIATE, TASK_ONCE, std::bind(&DisplayGraphicClass::blitLoop, this))
 {
 }
 
@@ -70,9 +84,39 @@ void DisplayGraphicClass::init(Scheduler& scheduler)
     setStatus(true);
     _diagram.init(scheduler, _display);
 
-    scheduler.addTask(_loopTask);
-    _loopTask.setInterval(_period);
-    _loopTask.enable();
+    scheduler.addTask(_composeTask);
+    SchedulerMonitor.instrument("display_compose", _composeTask, std::bind(&DisplayGraphicClass::composeLoop, this));
+    _composeTask.setInterval(_period);
+    _composeTask.enable();
+    scheduler.addTask(_blitTask);
+    SchedulerMonitor.instrument("display_blit", _blitTask, std::bind(&DisplayGraphicClass::blitLoop, this));
+
+    // Night blanking: with power save enabled the panel is blanked for
+    // the whole night period and the compose task is suspended, so its
+    // scheduler slot is free for nighttime work. Both listeners run on
+    // the main loop.
+    SunPosition.onDayPeriodChanged([this](const bool isDay) {
+        if (!isDay && enablePowerSafe) {
+            _nightBlank = true;
+            _display->setPowerSave(true);
+            _lastPowerSave = true;
+            _composeTask.disable();
+        } else if (isDay) {
+            wakeFromNightBlank();
+        }
+    });
+
+    // night polling can bring inverters back while blanked; wake the
+    // pipeline so fresh data shows up
+    Datastore.onFleetStateChanged([this]() {
+        wakeFromNightBlank();
+    });
+
+    // repaint right after fresh statistics instead of up to one period
+    // later; a no-op while the compose task is disabled
+    InverterAbstract::onStatisticsUpdated([this](InverterAbstract&) {
+        _composeTask.forceNextIteration();
+    });
 
     auto& config = Configuration.get();
     setDiagramMode(static_cast<DiagramMode_t>(config.Display.Diagram.Mode));
@@ -86,14 +130,19 @@ void DisplayGraphicClass::init(Scheduler& scheduler)
 
 void DisplayGraphicClass::calcLineHeights()
 {
+    // geometry changed, recompute the memoized text positions
+    memset(_layoutText, 0, sizeof(_layoutText));
+
     bool diagram = (_isLarge && _diagram_mode == DiagramMode_t::Small);
     // the diagram needs space. we need to keep
     // away from the y-axis label in particular.
     uint8_t yOff = (diagram ? 7 : 0);
     for (uint8_t i = 0; i < 4; i++) {
         setFont(i);
+        _lineTop[i] = yOff;
         yOff += _display->getAscent();
         _lineOffsets[i] = yOff;
+        _lineBottom[i] = yOff - _display->getDescent();
         yOff += ((!_isLarge || diagram) ? 2 : 3);
         // the descent is a negative value and moves the *next* line's
         // baseline. the first line never uses a letter with descent and
@@ -126,26 +175,27 @@ void DisplayGraphicClass::printText(const char* text, const uint8_t line)
 {
     setFont(line);
 
-    uint8_t dispX;
-    if (!_isLarge) {
-        dispX = (line == 0) ? 5 : 0;
-    } else {
-        if (line == 0 && _diagram_mode == DiagramMode_t::Small) {
-            // Center between left border and diagram
-            dispX = (CHART_POSX - _display->getStrWidth(text)) / 2;
+    if (strcmp(text, _layoutText[line]) != 0) {
+        uint8_t baseX;
+        if (!_isLarge) {
+            baseX = (line == 0) ? 5 : 0;
         } else {
-            // Center on screen
-            dispX = (_display->getDisplayWidth() - _display->getStrWidth(text)) / 2;
+            if (line == 0 && _diagram_mode == DiagramMode_t::Small) {
+                // Center between left border and diagram
+                baseX = (CHART_POSX - _display->getStrWidth(text)) / 2;
+            } else {
+                // Center on screen
+                baseX = (_display->getDisplayWidth() - _display->getStrWidth(text)) / 2;
+            }
         }
+        strlcpy(_layoutText[line], text, sizeof(_layoutText[line]));
+        _layoutX[line] = baseX;
     }
 
+    uint8_t dispX = _layoutX[line];
+
     if (enableScreensaver) {
-        unsigned maxOffset = (_isLarge ? 8 : 6);
-        unsigned period = 2 * maxOffset;
-        unsigned step = _mExtra % period;
-        int offset = (step <= maxOffset) ? step : (period - step);
-        offset -= (_isLarge ? 5 : 0); // oscillate around center on large screens
-        dispX += offset;
+        dispX += _screensaverOffsets[_mExtra % _screensaverPeriod];
     }
 
     if (dispX > _display->getDisplayWidth()) {
@@ -175,8 +225,22 @@ void DisplayGraphicClass::setOrientation(const uint8_t rotation)
         break;
     }
 
+    _rotation = rotation;
     _isLarge = (_display->getWidth() > 100);
     calcLineHeights();
+    rebuildScreensaverTable();
+    _forceFullRedraw = true;
+}
+
+void DisplayGraphicClass::rebuildScreensaverTable()
+{
+    const int maxOffset = (_isLarge ? 8 : 6);
+    _screensaverPeriod = 2 * maxOffset;
+    for (uint8_t step = 0; step < _screensaverPeriod; step++) {
+        int offset = (step <= maxOffset) ? step : (_screensaverPeriod - step);
+        offset -= (_isLarge ? 5 : 0); // oscillate around center on large screens
+        _screensaverOffsets[step] = offset;
+    }
 }
 
 void DisplayGraphicClass::setLocale(const String& locale)
@@ -213,6 +277,8 @@ void DisplayGraphicClass::setDiagramMode(DiagramMode_t mode)
 {
     if (mode < DiagramMode_t::DisplayMode_Max) {
         _diagram_mode = mode;
+        memset(_layoutText, 0, sizeof(_layoutText));
+        _forceFullRedraw = true;
     }
 }
 
@@ -225,6 +291,7 @@ void DisplayGraphicClass::setStartupDisplay()
     _display->clearBuffer();
     printText("OpenDTU!", 0);
     _display->sendBuffer();
+    _forceFullRedraw = true;
 }
 
 DisplayGraphicDiagramClass& DisplayGraphicClass::Diagram()
@@ -232,27 +299,85 @@ DisplayGraphicDiagramClass& DisplayGraphicClass::Diagram()
     return _diagram;
 }
 
-void DisplayGraphicClass::loop()
+void DisplayGraphicClass::wakeFromNightBlank()
+{
+    if (!_nightBlank) {
+        return;
+    }
+    _nightBlank = false;
+    _forceFullRedraw = true;
+    _composeTask.enableIfNot();
+}
+
+void DisplayGraphicClass::markRowsDirty(const uint8_t yTop, const uint8_t yBottom, uint8_t& rowMask)
 {
-    _loopTask.setInterval(_period);
+    for (uint8_t row = yTop / 8; row <= yBottom / 8 && row < 8; row++) {
+        rowMask |= (1 << row);
+    }
+}
+
+bool DisplayGraphicClass::supportsPartialUpdate()
+{
+    // updateDisplayArea() addresses the unrotated buffer layout and
+    // needs a controller with random page access, so restrict the
+    // partial path to the untransformed orientation and the I2C
+    // controllers. Everyone else keeps the full sendBuffer().
+    return _rotation == 0 && _display_type != DisplayType_t::PCD8544;
+}
+
+void DisplayGraphicClass::pushDirtyRows(const uint8_t rowMask)
+{
+    const uint8_t tileWidth = _display->getBufferTileWidth();
+    const uint8_t tileRows = std::min<uint8_t>(_display->getBufferTileHeight(), 8);
+
+    // transfer each contiguous run of dirty tile rows in one go
+    uint8_t row = 0;
+    while (row < tileRows) {
+        if (!(rowMask & (1 << row))) {
+            row++;
+            continue;
+        }
+        uint8_t count = 1;
+        while (row + count < tileRows && (rowMask & (1 << (row + count)))) {
+            count++;
+        }
+        _display->updateDisplayArea(0, row, tileWidth, count);
+        row += count;
+    }
+}
+
+void DisplayGraphicClass::composeLoop()
+{
+    _composeTask.setInterval(_period);
+
+    const int64_t composeStart = esp_timer_get_time();
 
-    _display->clearBuffer();
     bool displayPowerSave = false;
     bool showText = true;
+    bool showDiagram = false;
+    bool diagramFullscreen = false;
+
+    // compose the frame into per-line buffers first. comparing them
+    // against what is currently on the glass tells us which tile rows
+    // actually changed - on most ticks nothing does and both the redraw
+    // and the bus transfer are skipped entirely, so the display no
+    // longer competes with the radio for the shared bus every second.
+    char lines[4][sizeof(_renderedLines[0])] = {};
+
+    const auto totals = Datastore.getTotalsSnapshot();
 
     //=====> Actual Production ==========
-    if (Datastore.getIsAtLeastOneReachable()) {
-        displayPowerSave = false;
+    if (totals.IsAtLeastOneReachable) {
         if (_isLarge) {
-            uint8_t screenSaverOffsetX = enableScreensaver ? (_mExtra % 7) : 0;
             switch (_diagram_mode) {
             case DiagramMode_t::Small:
-                _diagram.redraw(screenSaverOffsetX, CHART_POSX, CHART_POSY, CHART_WIDTH, CHART_HEIGHT, false);
+                showDiagram = true;
                 break;
             case DiagramMode_t::Fullscreen:
                 // Every 10 seconds
                 if (_mExtra % (10 * 2) < 10) {
-                    _diagram.redraw(screenSaverOffsetX, 10, 0, _display->getDisplayWidth() - 12, _display->getDisplayHeight() - 3, true);
+                    showDiagram = true;
+                    diagramFullscreen = true;
                     showText = false;
                 }
                 break;
@@ -261,13 +386,12 @@ void DisplayGraphicClass::loop()
             }
         }
         if (showText) {
-            const float watts = Datastore.getTotalAcPowerEnabled();
+            const float watts = totals.AcPowerEnabled;
             if (watts > 999) {
-                snprintf(_fmtText, sizeof(_fmtText), _i18n_current_power_kw.c_str(), watts / 1000);
+                snprintf(lines[0], sizeof(lines[0]), _i18n_current_power_kw.c_str(), watts / 1000);
             } else {
-                snprintf(_fmtText, sizeof(_fmtText), _i18n_current_power_w.c_str(), watts);
+                snprintf(lines[0], sizeof(lines[0]), _i18n_current_power_w.c_str(), watts);
             }
-            printText(_fmtText, 0);
         }
         _previousMillis = millis();
     }
@@ -275,7 +399,7 @@ void DisplayGraphicClass::loop()
 
     //=====> Offline ===========
     else {
-        printText(_i18n_offline.c_str(), 0);
+        strlcpy(lines[0], _i18n_offline.c_str(), sizeof(lines[0]));
         // check if it's time to enter power saving mode
         if (millis() - _previousMillis >= (_interval * 2)) {
             displayPowerSave = enablePowerSafe;
@@ -285,33 +409,88 @@ void DisplayGraphicClass::loop()
 
     if (showText) {
         // Daily production
-        float wattsToday = Datastore.getTotalAcYieldDayEnabled();
+        const float wattsToday = totals.AcYieldDayEnabled;
         if (wattsToday >= 10000) {
-            snprintf(_fmtText, sizeof(_fmtText), _i18n_yield_today_kwh.c_str(), wattsToday / 1000);
+            snprintf(lines[1], sizeof(lines[1]), _i18n_yield_today_kwh.c_str(), wattsToday / 1000);
         } else {
-            snprintf(_fmtText, sizeof(_fmtText), _i18n_yield_today_wh.c_str(), wattsToday);
+            snprintf(lines[1], sizeof(lines[1]), _i18n_yield_today_wh.c_str(), wattsToday);
         }
-        printText(_fmtText, 1);
 
         // Total production
-        const float wattsTotal = Datastore.getTotalAcYieldTotalEnabled();
+        const float wattsTotal = totals.AcYieldTotalEnabled;
         auto const format = (wattsTotal >= 1000) ? _i18n_yield_total_mwh : _i18n_yield_total_kwh;
-        snprintf(_fmtText, sizeof(_fmtText), format.c_str(), wattsTotal);
-        printText(_fmtText, 2);
+        snprintf(lines[2], sizeof(lines[2]), format.c_str(), wattsTotal);
 
         //=====> IP or Date-Time ========
         // Change every 3 seconds
         if (!(_mExtra % (3 * 2) < 3) && NetworkSettings.localIP()) {
-            printText(NetworkSettings.localIP().toString().c_str(), 3);
+            strlcpy(lines[3], NetworkSettings.localIP().toString().c_str(), sizeof(lines[3]));
         } else {
             // Get current time
             time_t now = time(nullptr);
-            strftime(_fmtText, sizeof(_fmtText), _i18n_date_format.c_str(), localtime(&now));
-            printText(_fmtText, 3);
+            strftime(lines[3], sizeof(lines[3]), _i18n_date_format.c_str(), localtime(&now));
         }
     }
 
-    _display->sendBuffer();
+    // collect the 8-pixel tile rows touched by changed elements
+    uint8_t dirtyRows = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (strcmp(lines[i], _renderedLines[i]) != 0) {
+            markRowsDirty(_lineTop[i], _lineBottom[i], dirtyRows);
+        }
+    }
+    if (showDiagram && _diagram.getGeneration() != _renderedDiagramGeneration) {
+        // the small diagram including its scale label lives in the top
+        // tile rows; the fullscreen one covers the whole display
+        if (diagramFullscreen) {
+            dirtyRows = 0xff;
+        } else {
+            markRowsDirty(CHART_POSY, CHART_POSY + CHART_HEIGHT + 1, dirtyRows);
+        }
+    }
+
+    // structural changes (diagram appearing or disappearing, rotation,
+    // mode or locale switches) invalidate the whole frame. the
+    // screensaver shifts every element by a pixel each tick, so with it
+    // enabled there is nothing to track either.
+    const bool fullRedraw = _forceFullRedraw || enableScreensaver
+        || showDiagram != _renderedShowDiagram
+        || diagramFullscreen != _renderedDiagramFullscreen;
+
+    if (fullRedraw) {
+        dirtyRows = 0xff;
+    }
+
+    if (dirtyRows != 0) {
+        // redrawing the frame in RAM is cheap; what we save is pushing
+        // unchanged pages over I2C/SPI
+        _display->clearBuffer();
+        if (showDiagram) {
+            const uint8_t screenSaverOffsetX = enableScreensaver ? (_mExtra % 7) : 0;
+            if (diagramFullscreen) {
+                _diagram.redraw(screenSaverOffsetX, 10, 0, _display->getDisplayWidth() - 12, _display->getDisplayHeight() - 3, true);
+            } else {
+                _diagram.redraw(screenSaverOffsetX, CHART_POSX, CHART_POSY, CHART_WIDTH, CHART_HEIGHT, false);
+            }
+        }
+        for (uint8_t i = 0; i < 4; i++) {
+            if (lines[i][0] != '\0') {
+                printText(lines[i], i);
+            }
+        }
+
+        // hand the completed frame to the blit task; the bus transfer
+        // runs in its own slice of the schedule
+        _pendingRows |= dirtyRows;
+        _pendingFullPush |= fullRedraw || !supportsPartialUpdate();
+        _blitTask.restart();
+
+        memcpy(_renderedLines, lines, sizeof(_renderedLines));
+        _renderedShowDiagram = showDiagram;
+        _renderedDiagramFullscreen = diagramFullscreen;
+        _renderedDiagramGeneration = _diagram.getGeneration();
+        _forceFullRedraw = false;
+    }
 
     _mExtra++;
 
@@ -319,7 +498,35 @@ void DisplayGraphicClass::loop()
         displayPowerSave = true;
     }
 
-    _display->setPowerSave(displayPowerSave);
+    if (displayPowerSave != _lastPowerSave) {
+        _display->setPowerSave(displayPowerSave);
+        _lastPowerSave = displayPowerSave;
+    }
+
+    const int64_t composeMicros = esp_timer_get_time() - composeStart;
+    if (composeMicros > COMPOSE_BUDGET_US) {
+        static uint32_t lastOverrunLog = 0;
+        if (millis() - lastOverrunLog > 60000) {
+            lastOverrunLog = millis();
+            ESP_LOGW(TAG, "Page composition took %" PRId64 " us (budget %d us)", composeMicros, COMPOSE_BUDGET_US);
+        }
+    }
+}
+
+void DisplayGraphicClass::blitLoop()
+{
+    if (_pendingRows == 0 && !_pendingFullPush) {
+        return;
+    }
+
+    if (_pendingFullPush) {
+        _display->sendBuffer();
+    } else {
+        pushDirtyRows(_pendingRows);
+    }
+
+    _pendingRows = 0;
+    _pendingFullPush = false;
 }
 
 void DisplayGraphicClass::setContrast(const uint8_t contrast)
@@ -18,7 +18,7 @@ void DisplayGraphicDiagramClass::init(Scheduler& scheduler, U8G2* display)
     _display = display;
 
     scheduler.addTask(_averageTask);
-    _averageTask.enable();
+    Utils::enableStaggered(_averageTask);
 
     scheduler.addTask(_dataPointTask);
     updatePeriod();
@@ -27,7 +27,9 @@ void DisplayGraphicDiagramClass::init(Scheduler& scheduler, U8G2* display)
 
 void DisplayGraphicDiagramClass::averageLoop()
 {
-    const float currentWatts = Datastore.getTotalAcPowerEnabled(); // get the current AC production
+    // current AC production from the lock-free snapshot, this runs
+    // every second and must not serialize behind the aggregation loop
+    const float currentWatts = Datastore.getTotalsSnapshot().AcPowerEnabled;
     _iRunningAverage += currentWatts;
     _iRunningAverageCnt++;
 }
@@ -37,13 +39,34 @@ void DisplayGraphicDiagramClass::dataPointLoop()
     if (_graphValuesCount >= std::size(_graphValues)) {
         for (uint8_t i = 0; i < std::size(_graphValues) - 1; i++) {
             _graphValues[i] = _graphValues[i + 1];
+            _scaledValues[i] = _scaledValues[i + 1];
         }
         _graphValuesCount = std::size(_graphValues) - 1;
+        if (_scaledCount > 0) {
+            _scaledCount--;
+        }
+
+        // drop the evicted sample from the running maximum
+        const uint32_t evicted = _sampleNumber - std::size(_graphValues);
+        if (!_maxDeque.empty() && _maxDeque.front().first == evicted) {
+            _maxDeque.pop_front();
+        }
     }
     if (_iRunningAverageCnt != 0) {
-        _graphValues[_graphValuesCount++] = _iRunningAverage / _iRunningAverageCnt;
+        const float value = _iRunningAverage / _iRunningAverageCnt;
+        _graphValues[_graphValuesCount++] = value;
+
+        // samples dominated by the new value can never become the
+        // maximum again, so the deque stays sorted descending
+        while (!_maxDeque.empty() && _maxDeque.back().second <= value) {
+            _maxDeque.pop_back();
+        }
+        _maxDeque.emplace_back(_sampleNumber, value);
+        _sampleNumber++;
+
         _iRunningAverage = 0;
         _iRunningAverageCnt = 0;
+        _generation++;
     }
 }
 
@@ -56,6 +79,7 @@ void DisplayGraphicDiagramClass::updatePeriod()
 {
     //  Calculate seconds per datapoint
     _dataPointTask.setInterval(Configuration.get().Display.Diagram.Duration * TASK_SECOND / MAX_DATAPOINTS);
+    _generation++;
 }
 
 void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos, uint8_t yPos, uint8_t width, uint8_t height, bool isFullscreen)
@@ -83,7 +107,7 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
 
     // draw AC value
     char fmtText[7];
-    const float maxWatts = *std::max_element(_graphValues.begin(), _graphValues.end());
+    const float maxWatts = _maxDeque.empty() ? 0 : _maxDeque.front().second;
     if (maxWatts > 999) {
         snprintf(fmtText, sizeof(fmtText), "%2.1fkW", maxWatts / 1000);
     } else {
@@ -105,6 +129,18 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
     const float scaleFactorY = maxWatts / static_cast<float>(height);
     const float scaleFactorX = static_cast<float>(MAX_DATAPOINTS) / static_cast<float>(_chartWidth);
 
+    // scale only the samples that arrived since the last redraw; a new
+    // maximum or a different chart height rescales the whole history
+    if (maxWatts != _scaledMax || height != _scaledHeight) {
+        _scaledCount = 0;
+        _scaledMax = maxWatts;
+        _scaledHeight = height;
+    }
+    for (uint8_t i = _scaledCount; i < _graphValuesCount; i++) {
+        _scaledValues[i] = (scaleFactorY == 0) ? 0 : std::max<int16_t>(0, _graphValues[i] / scaleFactorY - 0.5);
+    }
+    _scaledCount = _graphValuesCount;
+
     if (maxWatts > 0 && isFullscreen) {
         // draw y axis ticks
         const uint16_t yAxisWattPerTick = maxWatts <= 100 ? 10 : maxWatts <= 1000 ? 100
@@ -130,7 +166,7 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
         }
 
         _display->drawLine(
-            graphPosX + (i - 1) / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i - 1] / scaleFactorY - 0.5),
-            graphPosX + i / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i] / scaleFactorY - 0.5));
+            graphPosX + (i - 1) / scaleFactorX, horizontal_line_y - _scaledValues[i - 1],
+            graphPosX + i / scaleFactorX, horizontal_line_y - _scaledValues[i]);
     }
 }
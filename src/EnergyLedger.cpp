@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "EnergyLedger.h"
+#include "Utils.h"
+#include <LockMonitor.h>
+
+EnergyLedgerClass EnergyLedger;
+
+EnergyLedgerClass::EnergyLedgerClass()
+    : _loopTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&EnergyLedgerClass::loop, this))
+{
+}
+
+void EnergyLedgerClass::init(Scheduler& scheduler)
+{
+    _prefs.begin("energy");
+
+    scheduler.addTask(_loopTask);
+    Utils::enableStaggered(_loopTask);
+}
+
+void EnergyLedgerClass::loop()
+{
+    const uint32_t now = millis();
+
+    LOCK_MONITOR_GUARD(lock, "energyledger", _mutex);
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        InverterLedger_t* ledger = getLedger(inv->serial());
+        if (ledger == nullptr) {
+            continue;
+        }
+
+        if (!ledger->loaded) {
+            load(*ledger);
+        }
+
+        const uint32_t dt = now - ledger->lastIntegration;
+        ledger->lastIntegration = now;
+
+        if (!inv->isReachable() || dt == 0 || dt > ENERGY_LEDGER_MAX_STEP_MS) {
+            continue;
+        }
+
+        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+            const float power = inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
+            if (!(power > 0)) {
+                continue;
+            }
+
+            ChannelLedger_t& channel = ledger->channels[c];
+            channel.energyWh += static_cast<double>(power) * dt / 3600000.0;
+
+            if (channel.energyWh - channel.committedWh >= ENERGY_LEDGER_COMMIT_DELTA_WH) {
+                commitChannel(*ledger, c);
+            }
+        }
+    }
+}
+
+double EnergyLedgerClass::getChannelEnergyWh(const uint64_t serial, const uint8_t channel) const
+{
+    if (channel >= CH_CNT) {
+        return 0;
+    }
+
+    LOCK_MONITOR_GUARD(lock, "energyledger", _mutex);
+    for (const auto& ledger : _ledgers) {
+        if (ledger.serial == serial && ledger.loaded) {
+            return ledger.channels[channel].energyWh;
+        }
+    }
+    return 0;
+}
+
+double EnergyLedgerClass::getInverterEnergyWh(const uint64_t serial) const
+{
+    double sum = 0;
+    LOCK_MONITOR_GUARD(lock, "energyledger", _mutex);
+    for (const auto& ledger : _ledgers) {
+        if (ledger.serial == serial && ledger.loaded) {
+            for (const auto& channel : ledger.channels) {
+                sum += channel.energyWh;
+            }
+        }
+    }
+    return sum;
+}
+
+void EnergyLedgerClass::commitAll()
+{
+    LOCK_MONITOR_GUARD(lock, "energyledger", _mutex);
+    for (auto& ledger : _ledgers) {
+        if (!ledger.loaded) {
+            continue;
+        }
+        for (uint8_t c = 0; c < CH_CNT; c++) {
+            if (ledger.channels[c].energyWh > ledger.channels[c].committedWh) {
+                commitChannel(ledger, c);
+            }
+        }
+    }
+}
+
+EnergyLedgerClass::InverterLedger_t* EnergyLedgerClass::getLedger(const uint64_t serial)
+{
+    InverterLedger_t* freeSlot = nullptr;
+    for (auto& ledger : _ledgers) {
+        if (ledger.serial == serial) {
+            return &ledger;
+        }
+        if (ledger.serial == 0 && freeSlot == nullptr) {
+            freeSlot = &ledger;
+        }
+    }
+
+    if (freeSlot != nullptr) {
+        freeSlot->serial = serial;
+    }
+    return freeSlot;
+}
+
+void EnergyLedgerClass::load(InverterLedger_t& ledger)
+{
+    for (uint8_t c = 0; c < CH_CNT; c++) {
+        char key[16];
+        makeKey(key, sizeof(key), ledger.serial, c);
+        ledger.channels[c].energyWh = _prefs.getDouble(key, 0);
+        ledger.channels[c].committedWh = ledger.channels[c].energyWh;
+    }
+    ledger.lastIntegration = millis();
+    ledger.loaded = true;
+}
+
+void EnergyLedgerClass::commitChannel(InverterLedger_t& ledger, const uint8_t channel)
+{
+    char key[16];
+    makeKey(key, sizeof(key), ledger.serial, channel);
+    _prefs.putDouble(key, ledger.channels[channel].energyWh);
+    ledger.channels[channel].committedWh = ledger.channels[channel].energyWh;
+}
+
+void EnergyLedgerClass::makeKey(char* buffer, const size_t size, const uint64_t serial, const uint8_t channel)
+{
+    // Hoymiles serials fit 12 hex digits; with the channel suffix the
+    // key stays within the 15 character NVS limit
+    snprintf(buffer, size, "%04" PRIx32 "%08" PRIx32 ".%" PRIu8,
+        static_cast<uint32_t>((serial >> 32) & 0xFFFF),
+        static_cast<uint32_t>(serial & 0xFFFFFFFF),
+        channel);
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "Federation.h"
+#include "Configuration.h"
+#include "NetworkSettings.h"
+#include <Arduino.h>
+#include <cstring>
+
+#undef TAG
+static const char* TAG = "federation";
+
+static constexpr uint32_t federationMagic = 0x4446444F; // "ODFD"
+static constexpr uint8_t federationVersion = 1;
+
+FederationClass Federation;
+
+FederationClass::FederationClass()
+    : _loopTask(100 * TASK_MILLISECOND, TASK_FOREVER, std::bind(&FederationClass::loop, this))
+{
+}
+
+void FederationClass::init(Scheduler& scheduler)
+{
+    const auto& config = Configuration.get().Federation;
+    if (!config.Enabled) {
+        return;
+    }
+
+    if (config.Role == 1 && strlen(config.PeerHostname) == 0) {
+        ESP_LOGW(TAG, "Secondary role without peer hostname, federation disabled");
+        return;
+    }
+
+    if (config.Role == 1) {
+        // Stream a snapshot as soon as an exchange completes instead of
+        // waiting for the next loop interval
+        InverterAbstract::onStatisticsUpdated([this](InverterAbstract&) {
+            _loopTask.forceNextIteration();
+        });
+        ESP_LOGI(TAG, "Streaming snapshots to %s:%" PRIu16 "", config.PeerHostname, config.Port);
+    } else {
+        ESP_LOGI(TAG, "Listening for snapshots on port %" PRIu16 "", config.Port);
+    }
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+}
+
+void FederationClass::loop()
+{
+    if (!NetworkSettings.isConnected()) {
+        return;
+    }
+
+    const auto& config = Configuration.get().Federation;
+    if (config.Role == 1) {
+        sendSnapshots();
+        return;
+    }
+
+    if (!_listening) {
+        if (!_udp.begin(config.Port)) {
+            ESP_LOGE(TAG, "No sockets available");
+            return;
+        }
+        _listening = true;
+    }
+    receiveSnapshots();
+}
+
+void FederationClass::sendSnapshots()
+{
+    const auto& config = Configuration.get().Federation;
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (!inv->getEnablePolling()) {
+            continue;
+        }
+
+        const uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
+        if (lastUpdate == 0 || _lastStreamed[inv->serial()] == lastUpdate) {
+            continue;
+        }
+
+        FederationDatagramHeader header;
+        header.magic = federationMagic;
+        header.version = federationVersion;
+        header.serial = inv->serial();
+        header.age = millis() - lastUpdate;
+        header.statisticLength = inv->Statistics()->getStatisticPayload(
+            _buffer + sizeof(header), STATISTIC_PACKET_SIZE);
+        if (header.statisticLength == 0) {
+            continue;
+        }
+        memcpy(_buffer, &header, sizeof(header));
+
+        if (_peerAddress != INADDR_NONE) {
+            if (!_udp.beginPacket(_peerAddress, config.Port)) {
+                return;
+            }
+        } else {
+            if (!_udp.beginPacket(config.PeerHostname, config.Port)) {
+                // Resolution or socket failure; retry on the next pass
+                return;
+            }
+            _peerAddress = _udp.remoteIP(); // Store resolved address.
+        }
+        _udp.write(_buffer, sizeof(header) + header.statisticLength);
+        if (_udp.endPacket()) {
+            _lastStreamed[inv->serial()] = lastUpdate;
+        }
+    }
+}
+
+void FederationClass::receiveSnapshots()
+{
+    int size;
+    while ((size = _udp.parsePacket()) > 0) {
+        if (size < static_cast<int>(sizeof(FederationDatagramHeader)) || size > static_cast<int>(sizeof(_buffer))) {
+            _udp.flush();
+            continue;
+        }
+        _udp.read(_buffer, size);
+
+        FederationDatagramHeader header;
+        memcpy(&header, _buffer, sizeof(header));
+        if (header.magic != federationMagic
+            || header.version != federationVersion
+            || header.statisticLength == 0
+            || header.statisticLength > STATISTIC_PACKET_SIZE
+            || size != static_cast<int>(sizeof(header)) + header.statisticLength) {
+            continue;
+        }
+
+        auto inv = Hoymiles.getInverterBySerial(header.serial);
+        if (inv == nullptr) {
+            continue;
+        }
+        if (inv->getEnablePolling()) {
+            // This inverter is polled locally; a datagram must never
+            // override radio data
+            continue;
+        }
+
+        const uint32_t age = min(header.age, millis());
+
+        auto stats = inv->Statistics();
+        stats->beginAppendFragment();
+        stats->clearBuffer();
+        stats->appendFragment(0, _buffer + sizeof(header), header.statisticLength);
+        stats->endAppendFragment();
+        stats->setLastUpdate(millis() - age);
+    }
+}
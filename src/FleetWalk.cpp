@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "FleetWalk.h"
+#include "SchedulerMonitor.h"
+#include "Utils.h"
+
+FleetWalkClass FleetWalk;
+
+FleetWalkClass::FleetWalkClass()
+    : _loopTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&FleetWalkClass::loop, this))
+{
+}
+
+void FleetWalkClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("fleetwalk", _loopTask, std::bind(&FleetWalkClass::loop, this));
+    Utils::enableStaggered(_loopTask);
+}
+
+void FleetWalkClass::registerVisitor(Visitor visitor)
+{
+    _visitors.push_back(std::move(visitor));
+}
+
+void FleetWalkClass::forceNextIteration()
+{
+    _loopTask.forceNextIteration();
+}
+
+void FleetWalkClass::loop()
+{
+    // Ask every visitor up front whether it wants this pass; the mask
+    // bounds us to 32 visitors, far above anything registered
+    uint32_t activeMask = 0;
+    for (size_t v = 0; v < _visitors.size() && v < 32; v++) {
+        if (_visitors[v].beginPass == nullptr || _visitors[v].beginPass()) {
+            activeMask |= 1u << v;
+        }
+    }
+    if (activeMask == 0) {
+        return;
+    }
+
+    // One consistent snapshot for the whole pass; concurrent list
+    // mutations swap in a new vector without disturbing this one
+    const auto inverters = Hoymiles.getInverterList();
+
+    for (uint8_t pos = 0; pos < inverters->size(); pos++) {
+        auto inv = (*inverters)[pos];
+        if (inv == nullptr) {
+            continue;
+        }
+        for (size_t v = 0; v < _visitors.size() && v < 32; v++) {
+            if (activeMask & (1u << v)) {
+                _visitors[v].visit(inv, pos);
+            }
+        }
+        yield();
+    }
+
+    for (size_t v = 0; v < _visitors.size() && v < 32; v++) {
+        if ((activeMask & (1u << v)) && _visitors[v].endPass != nullptr) {
+            _visitors[v].endPass();
+        }
+    }
+}
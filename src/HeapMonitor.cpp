@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "HeapMonitor.h"
+#include "CrashRecorder.h"
+#include <Arduino.h>
+#include <Hoymiles.h>
+#include <esp_log.h>
+
+#undef TAG
+static const char* TAG = "heapmonitor";
+
+HeapMonitorClass HeapMonitor;
+
+HeapMonitorClass::HeapMonitorClass()
+    : _loopTask(5 * TASK_SECOND, TASK_FOREVER, std::bind(&HeapMonitorClass::loop, this))
+{
+    for (auto& entry : _fleetMinFreeHeap) {
+        entry = UINT32_MAX;
+    }
+}
+
+void HeapMonitorClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    Utils::enableStaggered(_loopTask);
+}
+
+void HeapMonitorClass::registerConsumer(const char* name, std::function<size_t()> usage)
+{
+    _consumers.push_back({ name, std::move(usage) });
+}
+
+void HeapMonitorClass::registerLoadShedder(const char* name, std::function<void()> shed)
+{
+    _shedders.push_back({ name, std::move(shed) });
+}
+
+void HeapMonitorClass::loop()
+{
+    const uint32_t freeHeap = ESP.getFreeHeap();
+    const uint32_t maxBlock = ESP.getMaxAllocHeap();
+
+    _fragmentationPercent = freeHeap > 0
+        ? 100 - static_cast<uint8_t>(100U * maxBlock / freeHeap)
+        : 0;
+    if (maxBlock < _minMaxBlock) {
+        _minMaxBlock = maxBlock;
+    }
+
+    // watermark per fleet size, the scaling curve across devices
+    const size_t fleetSize = min<size_t>(Hoymiles.getNumInverters(), INV_MAX_COUNT);
+    if (freeHeap < _fleetMinFreeHeap[fleetSize]) {
+        _fleetMinFreeHeap[fleetSize] = freeHeap;
+    }
+
+    const bool low = freeHeap < HEAP_MONITOR_LOW_HEAP_BYTES
+        || maxBlock < HEAP_MONITOR_LOW_BLOCK_BYTES;
+
+    if (!low) {
+        // rearm only once comfortably above the thresholds, so a heap
+        // hovering at the limit does not shed on every other sample
+        if (_lowHeap && freeHeap > 2 * HEAP_MONITOR_LOW_HEAP_BYTES
+            && maxBlock > 2 * HEAP_MONITOR_LOW_BLOCK_BYTES) {
+            _lowHeap = false;
+        }
+        return;
+    }
+
+    if (_lowHeap) {
+        return; // already shed during this episode
+    }
+    _lowHeap = true;
+    _shedCount++;
+
+    ESP_LOGW(TAG, "Low heap: %" PRIu32 " bytes free, largest block %" PRIu32 ", fragmentation %u%%",
+        freeHeap, maxBlock, _fragmentationPercent);
+    for (const auto& consumer : _consumers) {
+        ESP_LOGW(TAG, "Consumer %s holds %u bytes", consumer.name, static_cast<unsigned>(consumer.usage()));
+    }
+
+    CrashRecorder.note("low heap: shedding load");
+
+    for (const auto& shedder : _shedders) {
+        ESP_LOGW(TAG, "Shedding load: %s", shedder.name);
+        shedder.shed();
+    }
+}
+
+void HeapMonitorClass::serialize(JsonObject root) const
+{
+    root["fragmentation_pct"] = _fragmentationPercent;
+    root["min_max_block"] = _minMaxBlock == UINT32_MAX ? 0 : _minMaxBlock;
+    root["shed_count"] = _shedCount;
+
+    JsonArray consumers = root["consumers"].to<JsonArray>();
+    for (const auto& consumer : _consumers) {
+        JsonObject entry = consumers.add<JsonObject>();
+        entry["name"] = consumer.name;
+        entry["bytes"] = consumer.usage();
+    }
+
+    JsonArray watermarks = root["fleet_watermarks"].to<JsonArray>();
+    for (size_t i = 0; i <= INV_MAX_COUNT; i++) {
+        if (_fleetMinFreeHeap[i] == UINT32_MAX) {
+            continue; // fleet size never observed on this device
+        }
+        JsonObject entry = watermarks.add<JsonObject>();
+        entry["inverters"] = i;
+        entry["min_free_heap"] = _fleetMinFreeHeap[i];
+    }
+}
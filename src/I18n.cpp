@@ -28,16 +28,18 @@ std::list<LanguageInfo_t> I18nClass::getAvailableLanguages()
 }
 
 String I18nClass::getFilenameByLocale(const String& locale) const
+{
+    const LanguageInfo_t* info = getLanguageInfoByLocale(locale);
+    return info != nullptr ? info->filename : String();
+}
+
+const LanguageInfo_t* I18nClass::getLanguageInfoByLocale(const String& locale) const
 {
     auto it = std::find_if(_availLanguages.begin(), _availLanguages.end(), [locale](const LanguageInfo_t& elem) {
         return elem.code == locale;
     });
 
-    if (it != _availLanguages.end()) {
-        return it->filename;
-    } else {
-        return String();
-    }
+    return it != _availLanguages.end() ? &(*it) : nullptr;
 }
 
 void I18nClass::readDisplayStrings(
@@ -48,65 +50,37 @@ void I18nClass::readDisplayStrings(
     String& yield_today_wh, String& yield_today_kwh,
     String& yield_total_kwh, String& yield_total_mwh)
 {
-    auto filename = getFilenameByLocale(locale);
-    if (filename == "") {
+    // Served from the strings resolved at pack scan time; the file is
+    // not touched and no JSON is parsed here
+    const LanguageInfo_t* info = getLanguageInfoByLocale(locale);
+    if (info == nullptr) {
         return;
     }
 
-    JsonDocument filter;
-    filter["display"] = true;
-
-    File f = LittleFS.open(filename, "r", false);
-
-    JsonDocument doc;
-
-    // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f, DeserializationOption::Filter(filter));
-    if (error) {
-        ESP_LOGE(TAG, "Failed to read file %s", filename.c_str());
-        f.close();
-        return;
+    if (info->displayDateFormat != "") {
+        date_format = info->displayDateFormat;
     }
-
-    if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
-        return;
+    if (info->displayOffline != "") {
+        offline = info->displayOffline;
     }
-
-    auto displayData = doc["display"];
-
-    if (displayData["date_format"].as<String>() != "null") {
-        date_format = displayData["date_format"].as<String>();
+    if (info->displayPowerW != "") {
+        power_w = info->displayPowerW;
     }
-
-    if (displayData["offline"].as<String>() != "null") {
-        offline = displayData["offline"].as<String>();
+    if (info->displayPowerKw != "") {
+        power_kw = info->displayPowerKw;
     }
-
-    if (displayData["power_w"].as<String>() != "null") {
-        power_w = displayData["power_w"].as<String>();
-    }
-
-    if (displayData["power_kw"].as<String>() != "null") {
-        power_kw = displayData["power_kw"].as<String>();
-    }
-
-    if (displayData["yield_today_wh"].as<String>() != "null") {
-        yield_today_wh = displayData["yield_today_wh"].as<String>();
+    if (info->displayYieldTodayWh != "") {
+        yield_today_wh = info->displayYieldTodayWh;
     }
-
-    if (displayData["yield_today_kwh"].as<String>() != "null") {
-        yield_today_kwh = displayData["yield_today_kwh"].as<String>();
+    if (info->displayYieldTodayKwh != "") {
+        yield_today_kwh = info->displayYieldTodayKwh;
     }
-
-    if (displayData["yield_total_kwh"].as<String>() != "null") {
-        yield_total_kwh = displayData["yield_total_kwh"].as<String>();
+    if (info->displayYieldTotalKwh != "") {
+        yield_total_kwh = info->displayYieldTotalKwh;
     }
-
-    if (displayData["yield_total_mwh"].as<String>() != "null") {
-        yield_total_mwh = displayData["yield_total_mwh"].as<String>();
+    if (info->displayYieldTotalMwh != "") {
+        yield_total_mwh = info->displayYieldTotalMwh;
     }
-
-    f.close();
 }
 
 void I18nClass::readLangPacks()
@@ -128,6 +102,7 @@ void I18nClass::readConfig(String file)
 {
     JsonDocument filter;
     filter["meta"] = true;
+    filter["display"] = true;
 
     File f = LittleFS.open(file, "r", false);
 
@@ -150,6 +125,19 @@ void I18nClass::readConfig(String file)
     lang.name = String(doc["meta"]["name"] | "");
     lang.filename = file;
 
+    // Hash once here instead of on every /api/i18n/language request
+    lang.etag = "\"" + Utils::generateMd5FromFile(file) + "\"";
+
+    auto displayData = doc["display"];
+    lang.displayDateFormat = String(displayData["date_format"] | "");
+    lang.displayOffline = String(displayData["offline"] | "");
+    lang.displayPowerW = String(displayData["power_w"] | "");
+    lang.displayPowerKw = String(displayData["power_kw"] | "");
+    lang.displayYieldTodayWh = String(displayData["yield_today_wh"] | "");
+    lang.displayYieldTodayKwh = String(displayData["yield_today_kwh"] | "");
+    lang.displayYieldTotalKwh = String(displayData["yield_total_kwh"] | "");
+    lang.displayYieldTotalMwh = String(displayData["yield_total_mwh"] | "");
+
     if (lang.code != "" && lang.name != "") {
         _availLanguages.push_back(lang);
     } else {
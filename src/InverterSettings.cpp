@@ -5,13 +5,21 @@
 #include "InverterSettings.h"
 #include "Configuration.h"
 #include "PinMapping.h"
+#include "SchedulerMonitor.h"
 #include "SunPosition.h"
 #include <Hoymiles.h>
+#include <ProfilingPins.h>
 #include <SpiManager.h>
+#include <parser/Timeseries.h>
 
 #undef TAG
 static const char* TAG = "invertersetup";
 
+// One day of AC power history per inverter, kept in RAM (PSRAM if
+// available) and served via /api/history
+#define INVERTER_HISTORY_INTERVAL 30 // seconds between samples
+#define INVERTER_HISTORY_SAMPLES (24 * 60 * 60 / INVERTER_HISTORY_INTERVAL)
+
 InverterSettingsClass InverterSettings;
 
 InverterSettingsClass::InverterSettingsClass()
@@ -20,7 +28,28 @@ InverterSettingsClass::InverterSettingsClass()
 {
 }
 
-void InverterSettingsClass::init(Scheduler& scheduler)
+void InverterSettingsClass::beginRadioInit()
+{
+    _radioInitDone = xSemaphoreCreateBinary();
+    if (_radioInitDone == nullptr) {
+        return; // init() falls back to the synchronous bring-up
+    }
+
+    if (xTaskCreate(radioInitTask, "invRadioInit", 4096, this, 1, nullptr) != pdPASS) {
+        vSemaphoreDelete(_radioInitDone);
+        _radioInitDone = nullptr;
+    }
+}
+
+void InverterSettingsClass::radioInitTask(void* arg)
+{
+    InverterSettingsClass* const instance = static_cast<InverterSettingsClass*>(arg);
+    instance->initRadios();
+    xSemaphoreGive(instance->_radioInitDone);
+    vTaskDelete(nullptr);
+}
+
+void InverterSettingsClass::initRadios()
 {
     const CONFIG_T& config = Configuration.get();
     const PinMapping_t& pin = PinMapping.get();
@@ -29,6 +58,9 @@ void InverterSettingsClass::init(Scheduler& scheduler)
     ESP_LOGI(TAG, "Initialize Hoymiles interface...");
     Hoymiles.init();
 
+    // No-op unless built with -DHOYMILES_PROFILING_PINS=1
+    HoymilesProfilingPins::init(pin.radio_profiling_tx, pin.radio_profiling_rx, pin.radio_profiling_fragment);
+
     if (!PinMapping.isValidNrf24Config() && !PinMapping.isValidCmt2300Config()) {
         ESP_LOGE(TAG, "Invalid pin config");
         return;
@@ -67,6 +99,26 @@ void InverterSettingsClass::init(Scheduler& scheduler)
     ESP_LOGI(TAG, "RF: Setting poll interval...");
     Hoymiles.setPollInterval(config.Dtu.PollInterval);
 
+    _radioInitSuccess = true;
+}
+
+void InverterSettingsClass::init(Scheduler& scheduler)
+{
+    const CONFIG_T& config = Configuration.get();
+
+    if (_radioInitDone != nullptr) {
+        // Join the radio bring-up worker started by beginRadioInit()
+        xSemaphoreTake(_radioInitDone, portMAX_DELAY);
+        vSemaphoreDelete(_radioInitDone);
+        _radioInitDone = nullptr;
+    } else {
+        initRadios();
+    }
+
+    if (!_radioInitSuccess) {
+        return;
+    }
+
     // Configure inverters
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
         const auto& inv_cfg = config.Inverter[i];
@@ -93,16 +145,24 @@ void InverterSettingsClass::init(Scheduler& scheduler)
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setStringMaxPower(c, inv_cfg.channel[c].MaxChannelPower);
             inv->Statistics()->setChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YT, inv_cfg.channel[c].YieldTotalOffset);
+            inv->Statistics()->setChannelName(c, inv_cfg.channel[c].Name);
         }
 
+        inv->Statistics()->addTimeseries(TYPE_AC, CH0, FLD_PAC, INVERTER_HISTORY_INTERVAL, INVERTER_HISTORY_SAMPLES);
+
         ESP_LOGI(TAG, "Adding complete");
     }
     ESP_LOGI(TAG, "Initialization complete");
 
+    // Answer fleet reachability in the first exchanges after boot
+    Hoymiles.startPresenceSweep();
+
     scheduler.addTask(_hoyTask);
+    SchedulerMonitor.instrument("hoymiles", _hoyTask, std::bind(&InverterSettingsClass::hoyLoop, this));
     _hoyTask.enable();
 
     scheduler.addTask(_settingsTask);
+    SchedulerMonitor.instrument("inverter_settings", _settingsTask, std::bind(&InverterSettingsClass::settingsLoop, this));
     _settingsTask.enable();
 }
 
@@ -111,6 +171,9 @@ void InverterSettingsClass::settingsLoop()
     const CONFIG_T& config = Configuration.get();
     const bool isDayPeriod = SunPosition.isDayPeriod();
 
+    bool nrfNeedsService = false;
+    bool cmtNeedsService = false;
+
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
         auto const& inv_cfg = config.Inverter[i];
         if (inv_cfg.Serial == 0) {
@@ -123,7 +186,25 @@ void InverterSettingsClass::settingsLoop()
 
         inv->setEnablePolling(inv_cfg.Poll_Enable && (isDayPeriod || inv_cfg.Poll_Enable_Night));
         inv->setEnableCommands(inv_cfg.Command_Enable && (isDayPeriod || inv_cfg.Command_Enable_Night));
+        inv->Statistics()->setFleetRowConfigEnabled(inv_cfg.Poll_Enable);
+
+        if (inv->getEnablePolling() || inv->getEnableCommands()) {
+            if (inv->getRadio() == Hoymiles.getRadioNrf()) {
+                nrfNeedsService = true;
+            } else {
+                cmtNeedsService = true;
+            }
+        }
     }
+
+    // Deep radio duty cycling: a band whose inverters are all disabled
+    // (typically between sunset and sunrise) has nothing to receive, so
+    // its transceiver is powered down and its loop task parked instead
+    // of spinning over SPI all night. Any enqueued command - a limit
+    // arriving via MQTT, or the sunrise pass re-enabling polling - wakes
+    // the band instantly.
+    Hoymiles.getRadioNrf()->setSleepAllowed(!nrfNeedsService);
+    Hoymiles.getRadioCmt()->setSleepAllowed(!cmtNeedsService);
 }
 
 void InverterSettingsClass::hoyLoop()
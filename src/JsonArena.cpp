@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "JsonArena.h"
+#include "Utils.h"
+#include <cstdlib>
+#include <cstring>
+
+// Each block is prefixed with its size so reallocate() can copy the old
+// contents when a block has to move
+#define BLOCK_HEADER_SIZE sizeof(uint32_t)
+
+JsonArena MqttPayloadArena(8192);
+JsonArena LivedataArena(8192);
+
+JsonArena::JsonArena(const size_t size)
+    : _size(size)
+{
+    // Bulk tier: PSRAM preferred, payload assembly does not need fast
+    // internal RAM
+    _buffer = static_cast<uint8_t*>(Utils::allocBulk(size));
+    if (_buffer == nullptr) {
+        _size = 0;
+    }
+}
+
+JsonArena::~JsonArena()
+{
+    free(_buffer);
+}
+
+bool JsonArena::ownsPointer(const void* pointer) const
+{
+    return pointer >= _buffer && pointer < _buffer + _size;
+}
+
+void* JsonArena::allocate(size_t size)
+{
+    // keep blocks aligned for the size prefix of the next one
+    const size_t aligned = (size + 3) & ~static_cast<size_t>(3);
+
+    if (_offset + BLOCK_HEADER_SIZE + aligned > _size) {
+        _heapFallbacks++;
+        return malloc(size);
+    }
+
+    uint8_t* block = _buffer + _offset;
+    *reinterpret_cast<uint32_t*>(block) = aligned;
+    _offset += BLOCK_HEADER_SIZE + aligned;
+    if (_offset > _highWater) {
+        _highWater = _offset;
+    }
+
+    _lastAllocation = block + BLOCK_HEADER_SIZE;
+    return _lastAllocation;
+}
+
+void JsonArena::deallocate(void* pointer)
+{
+    if (pointer == nullptr || ownsPointer(pointer)) {
+        // arena blocks are released collectively via reset()
+        return;
+    }
+    free(pointer);
+}
+
+void* JsonArena::reallocate(void* pointer, size_t new_size)
+{
+    if (pointer == nullptr) {
+        return allocate(new_size);
+    }
+
+    if (!ownsPointer(pointer)) {
+        return realloc(pointer, new_size);
+    }
+
+    uint8_t* block = static_cast<uint8_t*>(pointer) - BLOCK_HEADER_SIZE;
+    const uint32_t old_size = *reinterpret_cast<uint32_t*>(block);
+
+    // the topmost block can grow or shrink in place
+    if (pointer == _lastAllocation) {
+        const size_t aligned = (new_size + 3) & ~static_cast<size_t>(3);
+        const size_t base = block - _buffer;
+        if (base + BLOCK_HEADER_SIZE + aligned <= _size) {
+            *reinterpret_cast<uint32_t*>(block) = aligned;
+            _offset = base + BLOCK_HEADER_SIZE + aligned;
+            if (_offset > _highWater) {
+                _highWater = _offset;
+            }
+            return pointer;
+        }
+    }
+
+    if (new_size <= old_size) {
+        return pointer;
+    }
+
+    void* grown = allocate(new_size);
+    if (grown != nullptr) {
+        memcpy(grown, pointer, old_size);
+    }
+    return grown;
+}
+
+void JsonArena::reset()
+{
+    _offset = 0;
+    _lastAllocation = nullptr;
+}
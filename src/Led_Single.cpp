@@ -7,6 +7,7 @@
 #include "Datastore.h"
 #include "MqttSettings.h"
 #include "NetworkSettings.h"
+#include "NtpSettings.h"
 #include "PinMapping.h"
 #include <Hoymiles.h>
 
@@ -37,9 +38,17 @@ const uint8_t pwmTable[] = {
 
 #define LED_OFF 0
 
+// Static states run the channel at the analogWrite defaults. Blink is
+// generated by the LEDC timer itself at 1 Hz / 50 % duty, so no CPU is
+// spent per toggle; the divider cannot reach 1 Hz at 8 bit resolution,
+// hence the wider blink resolution.
+#define LED_STATIC_FREQUENCY 1000
+#define LED_STATIC_RESOLUTION 8
+#define LED_BLINK_FREQUENCY 1
+#define LED_BLINK_RESOLUTION 16
+
 LedSingleClass::LedSingleClass()
-    : _setTask(LEDSINGLE_UPDATE_INTERVAL * TASK_MILLISECOND, TASK_FOREVER, std::bind(&LedSingleClass::setLoop, this))
-    , _outputTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&LedSingleClass::outputLoop, this))
+    : _applyTask(100 * TASK_MILLISECOND, TASK_FOREVER, std::bind(&LedSingleClass::applyLoop, this))
 {
 }
 
@@ -47,7 +56,6 @@ void LedSingleClass::init(Scheduler& scheduler)
 {
     bool ledActive = false;
 
-    _blinkTimeout.set(500);
     turnAllOn();
 
     const auto& pin = PinMapping.get();
@@ -55,78 +63,117 @@ void LedSingleClass::init(Scheduler& scheduler)
 
         if (pin.led[i] > GPIO_NUM_NC) {
             pinMode(pin.led[i], OUTPUT);
-            setLed(i, false);
+            // attaches the pin to a LEDC channel at the default
+            // frequency and resolution
+            analogWrite(pin.led[i], LED_OFF);
             ledActive = true;
         }
 
         _ledMode[i] = LedState_t::Off;
     }
 
-    if (ledActive) {
-        scheduler.addTask(_outputTask);
-        _outputTask.enable();
+    if (!ledActive) {
+        return;
+    }
+
+    // seed the cached connectivity state once, events keep it current
+    _networkConnected = NetworkSettings.isConnected();
+    _mqttConnected = MqttSettings.getConnected();
+    struct tm timeinfo;
+    _timeSynced = getLocalTime(&timeinfo, 5);
+
+    NetworkSettings.onEvent([this](const network_event event) {
+        switch (event) {
+        case network_event::NETWORK_GOT_IP:
+            _networkConnected = true;
+            break;
+        case network_event::NETWORK_DISCONNECTED:
+        case network_event::NETWORK_LOST_IP:
+            _networkConnected = false;
+            break;
+        default:
+            return;
+        }
+        _dirty = true;
+    });
+
+    MqttSettings.onConnectionChanged([this](const bool connected) {
+        _mqttConnected = connected;
+        _dirty = true;
+    });
+
+    NtpSettings.onTimeSynced([this]() {
+        _timeSynced = true;
+        _dirty = true;
+    });
+
+    Datastore.onFleetStateChanged([this]() {
+        _dirty = true;
+    });
+
+    // brightness, MQTT enablement or the inverter set may have changed
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        _forceApply = true;
+        _dirty = true;
+    });
+
+    scheduler.addTask(_applyTask);
+    _applyTask.enable();
+}
 
-        scheduler.addTask(_setTask);
-        _setTask.enable();
+void LedSingleClass::applyLoop()
+{
+    if (_dirty.exchange(false)) {
+        recompute();
     }
 }
 
-void LedSingleClass::setLoop()
+void LedSingleClass::recompute()
 {
+    LedState_t desired[PINMAPPING_LED_COUNT];
+
     if (_allMode == LedState_t::On) {
         const CONFIG_T& config = Configuration.get();
 
-        // Update network status
-        _ledMode[0] = LedState_t::Off;
+        // Network status
+        desired[0] = LedState_t::Off;
 
-        if (NetworkSettings.isConnected()) {
-            _ledMode[0] = LedState_t::Blink;
+        if (_networkConnected) {
+            desired[0] = LedState_t::Blink;
         }
 
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo, 5) && (!config.Mqtt.Enabled || (config.Mqtt.Enabled && MqttSettings.getConnected()))) {
-            _ledMode[0] = LedState_t::On;
+        if (_timeSynced && (!config.Mqtt.Enabled || (config.Mqtt.Enabled && _mqttConnected))) {
+            desired[0] = LedState_t::On;
         }
 
-        // Update inverter status
-        _ledMode[1] = LedState_t::Off;
-        if (Hoymiles.getNumInverters() && Datastore.getIsAtLeastOnePollEnabled()) {
+        // Inverter status
+        desired[1] = LedState_t::Off;
+        const auto totals = Datastore.getTotalsSnapshot();
+        if (Hoymiles.getNumInverters() && totals.IsAtLeastOnePollEnabled) {
             // set LED status
-            if (Datastore.getIsAllEnabledReachable() && Datastore.getIsAllEnabledProducing()) {
-                _ledMode[1] = LedState_t::On;
+            if (totals.IsAllEnabledReachable && totals.IsAllEnabledProducing) {
+                desired[1] = LedState_t::On;
             }
-            if (Datastore.getIsAllEnabledReachable() && !Datastore.getIsAllEnabledProducing()) {
-                _ledMode[1] = LedState_t::Blink;
+            if (totals.IsAllEnabledReachable && !totals.IsAllEnabledProducing) {
+                desired[1] = LedState_t::Blink;
             }
         }
 
-    } else if (_allMode == LedState_t::Off) {
-        _ledMode[0] = LedState_t::Off;
-        _ledMode[1] = LedState_t::Off;
+    } else {
+        desired[0] = LedState_t::Off;
+        desired[1] = LedState_t::Off;
     }
-}
 
-void LedSingleClass::outputLoop()
-{
+    const bool force = _forceApply.exchange(false);
     for (uint8_t i = 0; i < PINMAPPING_LED_COUNT; i++) {
-        switch (_ledMode[i]) {
-        case LedState_t::Off:
-            setLed(i, false);
-            break;
-        case LedState_t::On:
-            setLed(i, true);
-            break;
-        case LedState_t::Blink:
-            if (_blinkTimeout.occured()) {
-                setLed(i, !_ledStateCurrent[i]);
-                _blinkTimeout.reset();
-            }
-            break;
+        if (force || desired[i] != _ledMode[i]) {
+            _ledMode[i] = desired[i];
+            applyMode(i, desired[i]);
         }
     }
 }
 
-void LedSingleClass::setLed(const uint8_t ledNo, const bool ledState)
+void LedSingleClass::applyMode(const uint8_t ledNo, const LedState_t state)
 {
     const auto& pin = PinMapping.get();
     const auto& config = Configuration.get();
@@ -136,27 +183,37 @@ void LedSingleClass::setLed(const uint8_t ledNo, const bool ledState)
     }
 
 #if ESP_ARDUINO_VERSION_MAJOR < 3
-    const uint32_t currentPWM = ledcRead(analogGetChannel(pin.led[ledNo]));
+    const uint8_t channel = analogGetChannel(pin.led[ledNo]);
 #else
-    const uint32_t currentPWM = ledcRead(pin.led[ledNo]);
+    const uint8_t channel = pin.led[ledNo];
 #endif
 
-    const uint32_t targetPWM = ledState ? pwmTable[config.Led_Single[ledNo].Brightness] : LED_OFF;
-
-    if (currentPWM == targetPWM) {
-        return;
+    switch (state) {
+    case LedState_t::Off:
+        ledcChangeFrequency(channel, LED_STATIC_FREQUENCY, LED_STATIC_RESOLUTION);
+        ledcWrite(channel, LED_OFF);
+        break;
+    case LedState_t::On:
+        ledcChangeFrequency(channel, LED_STATIC_FREQUENCY, LED_STATIC_RESOLUTION);
+        ledcWrite(channel, pwmTable[config.Led_Single[ledNo].Brightness]);
+        break;
+    case LedState_t::Blink:
+        // the timer duty encodes the on/off phase here, so blink runs
+        // at full brightness; 50 % matches the previous 500 ms toggle
+        ledcChangeFrequency(channel, LED_BLINK_FREQUENCY, LED_BLINK_RESOLUTION);
+        ledcWrite(channel, 1u << (LED_BLINK_RESOLUTION - 1));
+        break;
     }
-
-    analogWrite(pin.led[ledNo], targetPWM);
-    _ledStateCurrent[ledNo] = ledState;
 }
 
 void LedSingleClass::turnAllOff()
 {
     _allMode = LedState_t::Off;
+    _dirty = true;
 }
 
 void LedSingleClass::turnAllOn()
 {
     _allMode = LedState_t::On;
+    _dirty = true;
 }
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "Lzss.h"
+
+namespace {
+
+constexpr size_t WINDOW_SIZE = 256; // 2^8
+constexpr size_t LOOKAHEAD_SIZE = 16; // 2^4
+// a back-reference costs 13 bits against 9 bits per literal, so only
+// matches of three or more shrink the output
+constexpr size_t MIN_MATCH = 3;
+
+// MSB-first bit writer; overflow latches and is reported at the end
+struct BitWriter {
+    uint8_t* out;
+    size_t cap;
+    size_t pos = 0;
+    uint8_t current = 0;
+    uint8_t bitCount = 0;
+    bool overflow = false;
+
+    void putBits(uint32_t value, uint8_t bits)
+    {
+        while (bits-- > 0) {
+            current = (current << 1) | ((value >> bits) & 1);
+            if (++bitCount == 8) {
+                if (pos < cap) {
+                    out[pos++] = current;
+                } else {
+                    overflow = true;
+                }
+                current = 0;
+                bitCount = 0;
+            }
+        }
+    }
+
+    size_t finish()
+    {
+        if (bitCount > 0) {
+            // pad the final byte with zero bits
+            putBits(0, 8 - bitCount);
+        }
+        return overflow ? 0 : pos;
+    }
+};
+
+} // namespace
+
+size_t lzssCompress(const uint8_t* input, const size_t inputLen, uint8_t* output, const size_t outputCap)
+{
+    BitWriter writer { output, outputCap };
+
+    size_t pos = 0;
+    while (pos < inputLen && !writer.overflow) {
+        // greedy search for the longest match in the window behind pos
+        size_t bestLen = 0;
+        size_t bestDist = 0;
+        const size_t maxDist = pos < WINDOW_SIZE ? pos : WINDOW_SIZE;
+        const size_t maxLen = (inputLen - pos) < LOOKAHEAD_SIZE ? (inputLen - pos) : LOOKAHEAD_SIZE;
+
+        for (size_t dist = 1; dist <= maxDist; dist++) {
+            const uint8_t* candidate = input + pos - dist;
+            size_t len = 0;
+            while (len < maxLen && candidate[len] == input[pos + len]) {
+                len++;
+            }
+            if (len > bestLen) {
+                bestLen = len;
+                bestDist = dist;
+                if (len == maxLen) {
+                    break;
+                }
+            }
+        }
+
+        if (bestLen >= MIN_MATCH) {
+            writer.putBits(0, 1);
+            writer.putBits(bestDist - 1, 8);
+            writer.putBits(bestLen - 1, 4);
+            pos += bestLen;
+        } else {
+            writer.putBits(1, 1);
+            writer.putBits(input[pos], 8);
+            pos++;
+        }
+    }
+
+    return writer.finish();
+}
@@ -3,8 +3,10 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "MessageOutput.h"
+#include "SchedulerMonitor.h"
 #include "SyslogLogger.h"
 #include <HardwareSerial.h>
+#include <string.h>
 
 MessageOutputClass MessageOutput;
 
@@ -18,21 +20,268 @@ MessageOutputClass::MessageOutputClass()
 
 void MessageOutputClass::init(Scheduler& scheduler)
 {
+    _mainTask = xTaskGetCurrentTaskHandle();
     scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("messageoutput", _loopTask, std::bind(&MessageOutputClass::loop, this));
     _loopTask.enable();
     esp_log_set_vprintf(log_vprintf);
 }
 
-void MessageOutputClass::register_ws_output(AsyncWebSocket* output)
+void MessageOutputClass::register_line_sink(MessageOutputLineSink* sink)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    // called once during init on the main task, which is also the only
+    // task reading _sink (the consumer loop) - no locking required
+    _sink = sink;
+}
+
+// parses one conversion specification starting at p (pointing at '%'),
+// copies it to spec and classifies the argument it consumes. advances p
+// past the specification on success. conversions that cannot be
+// captured by value (%n, runtime widths, long doubles) are rejected.
+bool MessageOutputClass::parseSpec(const char*& p, char* spec, const size_t specSize, ArgClass& cls)
+{
+    const char* start = p;
+    p++;
+
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    uint8_t longs = 0;
+    if (*p == 'h') {
+        p++;
+        if (*p == 'h') {
+            p++;
+        }
+    } else if (*p == 'l') {
+        longs = 1;
+        p++;
+        if (*p == 'l') {
+            longs = 2;
+            p++;
+        }
+    } else if (*p == 'j') {
+        longs = 2;
+        p++;
+    } else if (*p == 'z' || *p == 't') {
+        p++;
+    } else if (*p == 'L') {
+        return false;
+    }
+
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+        // long is 32 bit on this target, only ll/j need 64 bit
+        cls = longs == 2 ? ArgClass::Int64 : ArgClass::Int32;
+        break;
+    case 'p':
+        cls = ArgClass::Pointer;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        cls = ArgClass::Double;
+        break;
+    case 's':
+        cls = ArgClass::String;
+        break;
+    default:
+        return false;
+    }
+
+    const size_t len = p - start + 1;
+    p++;
+    if (len + 1 > specSize) {
+        return false;
+    }
+    memcpy(spec, start, len);
+    spec[len] = '\0';
+    return true;
+}
+
+bool MessageOutputClass::captureLogArgs(const char* fmt, va_list args, message_t& packed)
+{
+    va_list ap;
+    va_copy(ap, args);
+
+    packed.reserve(48);
+
+    bool ok = true;
+    size_t argc = 0;
+    const char* p = fmt;
+    while (*p != '\0' && ok) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+
+        char spec[16];
+        ArgClass cls;
+        if (!parseSpec(p, spec, sizeof(spec), cls) || ++argc > DEFERRED_MAX_ARGS) {
+            ok = false;
+            break;
+        }
+
+        packed.push_back(static_cast<uint8_t>(cls));
+        switch (cls) {
+        case ArgClass::Int32: {
+            const uint32_t v = va_arg(ap, uint32_t);
+            packed.insert(packed.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof(v));
+            break;
+        }
+        case ArgClass::Pointer: {
+            const uintptr_t v = reinterpret_cast<uintptr_t>(va_arg(ap, void*));
+            packed.insert(packed.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof(v));
+            break;
+        }
+        case ArgClass::Int64: {
+            const uint64_t v = va_arg(ap, uint64_t);
+            packed.insert(packed.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof(v));
+            break;
+        }
+        case ArgClass::Double: {
+            const double v = va_arg(ap, double);
+            packed.insert(packed.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof(v));
+            break;
+        }
+        case ArgClass::String: {
+            const char* sv = va_arg(ap, const char*);
+            if (sv == nullptr) {
+                sv = "(null)";
+            }
+            const size_t len = strlen(sv);
+            if (len > DEFERRED_MAX_STRING) {
+                ok = false; // transient buffer may be gone at render time, copy would be large
+                break;
+            }
+            packed.push_back(static_cast<uint8_t>(len));
+            packed.insert(packed.end(), sv, sv + len + 1); // include the terminator
+            break;
+        }
+        }
+    }
+
+    va_end(ap);
+
+    if (!ok) {
+        packed.clear();
+    }
+    return ok;
+}
+
+void MessageOutputClass::renderDeferred(const char* fmt, const message_t& packed, message_t& line)
+{
+    line.reserve(128);
+
+    size_t pos = 0;
+    const char* p = fmt;
+    while (*p != '\0') {
+        if (*p != '%') {
+            line.push_back(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            line.push_back('%');
+            p += 2;
+            continue;
+        }
+
+        char spec[16];
+        ArgClass cls;
+        if (!parseSpec(p, spec, sizeof(spec), cls) || pos >= packed.size()
+            || static_cast<ArgClass>(packed[pos]) != cls) {
+            // cannot happen for records produced by captureLogArgs()
+            line.push_back(*p++);
+            continue;
+        }
+        pos++;
+
+        char rendered[LOG_LINE_SIZE_BYTES];
+        rendered[0] = '\0';
+        switch (cls) {
+        case ArgClass::Int32: {
+            uint32_t v;
+            memcpy(&v, &packed[pos], sizeof(v));
+            pos += sizeof(v);
+            snprintf(rendered, sizeof(rendered), spec, v);
+            break;
+        }
+        case ArgClass::Pointer: {
+            uintptr_t v;
+            memcpy(&v, &packed[pos], sizeof(v));
+            pos += sizeof(v);
+            snprintf(rendered, sizeof(rendered), spec, reinterpret_cast<void*>(v));
+            break;
+        }
+        case ArgClass::Int64: {
+            uint64_t v;
+            memcpy(&v, &packed[pos], sizeof(v));
+            pos += sizeof(v);
+            snprintf(rendered, sizeof(rendered), spec, v);
+            break;
+        }
+        case ArgClass::Double: {
+            double v;
+            memcpy(&v, &packed[pos], sizeof(v));
+            pos += sizeof(v);
+            snprintf(rendered, sizeof(rendered), spec, v);
+            break;
+        }
+        case ArgClass::String: {
+            const uint8_t len = packed[pos++];
+            snprintf(rendered, sizeof(rendered), spec, reinterpret_cast<const char*>(&packed[pos]));
+            pos += len + 1;
+            break;
+        }
+        }
 
-    _ws = output;
+        line.insert(line.end(), rendered, rendered + strlen(rendered));
+    }
 }
 
 int MessageOutputClass::log_vprintf(const char* fmt, va_list arguments)
 {
-    char log_buffer[WS_CHUNK_SIZE_BYTES];
+    // hot path: on worker tasks, enqueue the format pointer plus the
+    // packed argument values and let the consumer loop render the line.
+    // the main task renders immediately anyway (it writes its own lines
+    // to the serial port synchronously), and formats the capture cannot
+    // handle fall back to immediate rendering below.
+    if (xTaskGetCurrentTaskHandle() != MessageOutput._mainTask) {
+        TaskSlot* slot = MessageOutput.claimSlot();
+        if (slot != nullptr) {
+            message_t packed;
+            if (captureLogArgs(fmt, arguments, packed)) {
+                MessageOutput.pushDeferred(*slot, fmt, std::move(packed));
+                return 0;
+            }
+        }
+    }
+
+    char log_buffer[LOG_LINE_SIZE_BYTES];
     vsnprintf(log_buffer, sizeof(log_buffer), fmt, arguments);
     return MessageOutput.print(log_buffer);
 }
@@ -54,20 +303,77 @@ void MessageOutputClass::serialWrite(MessageOutputClass::message_t const& m)
     Serial.flush();
 }
 
-size_t MessageOutputClass::write(uint8_t c)
+MessageOutputClass::TaskSlot* MessageOutputClass::claimSlot()
+{
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    for (auto& slot : _slots) {
+        if (slot.owner.load(std::memory_order_acquire) == self) {
+            return &slot;
+        }
+    }
+
+    for (auto& slot : _slots) {
+        TaskHandle_t expected = nullptr;
+        if (slot.owner.compare_exchange_strong(expected, self, std::memory_order_acq_rel)) {
+            return &slot;
+        }
+    }
+
+    return nullptr;
+}
+
+void MessageOutputClass::pushLine(TaskSlot& slot)
+{
+    if (xTaskGetCurrentTaskHandle() == _mainTask) {
+        // the main task owns the serial port - write synchronously so
+        // boot messages show up before the scheduler starts running
+        serialWrite(slot.pending);
+    }
+
+    const uint32_t head = slot.head.load(std::memory_order_acquire);
+    const uint32_t tail = slot.tail.load(std::memory_order_relaxed);
+
+    if (tail - head >= LINE_QUEUE_DEPTH) {
+        slot.dropped.fetch_add(1, std::memory_order_relaxed);
+        slot.pending.clear();
+        return;
+    }
+
+    LineEntry& entry = slot.lines[tail % LINE_QUEUE_DEPTH];
+    entry.data = std::move(slot.pending);
+    entry.fmt = nullptr;
+    slot.pending = message_t();
+    slot.tail.store(tail + 1, std::memory_order_release);
+}
+
+void MessageOutputClass::pushDeferred(TaskSlot& slot, const char* fmt, message_t&& packed)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
+    const uint32_t head = slot.head.load(std::memory_order_acquire);
+    const uint32_t tail = slot.tail.load(std::memory_order_relaxed);
 
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+    if (tail - head >= LINE_QUEUE_DEPTH) {
+        slot.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
-    message.push_back(c);
+    LineEntry& entry = slot.lines[tail % LINE_QUEUE_DEPTH];
+    entry.data = std::move(packed);
+    entry.fmt = fmt;
+    slot.tail.store(tail + 1, std::memory_order_release);
+}
+
+size_t MessageOutputClass::write(uint8_t c)
+{
+    TaskSlot* slot = claimSlot();
+    if (slot == nullptr) {
+        return 1; // all slots taken, drop the output
+    }
+
+    slot->pending.push_back(c);
 
     if (c == '\n') {
-        serialWrite(message);
-        _lines.emplace(std::move(message));
-        _task_messages.erase(iter);
+        pushLine(*slot);
     }
 
     return 1;
@@ -75,12 +381,12 @@ size_t MessageOutputClass::write(uint8_t c)
 
 size_t MessageOutputClass::write(const uint8_t* buffer, size_t size)
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
-
-    auto res = _task_messages.emplace(xTaskGetCurrentTaskHandle(), message_t());
-    auto iter = res.first;
-    auto& message = iter->second;
+    TaskSlot* slot = claimSlot();
+    if (slot == nullptr) {
+        return size; // all slots taken, drop the output
+    }
 
+    auto& message = slot->pending;
     message.reserve(message.size() + size);
 
     for (size_t idx = 0; idx < size; ++idx) {
@@ -89,80 +395,70 @@ size_t MessageOutputClass::write(const uint8_t* buffer, size_t size)
         message.push_back(c);
 
         if (c == '\n') {
-            serialWrite(message);
-            _lines.emplace(std::move(message));
-            message.clear();
-            message.reserve(size - idx - 1);
+            pushLine(*slot);
         }
     }
 
-    if (message.empty()) {
-        _task_messages.erase(iter);
-    }
-
     return size;
 }
 
-void MessageOutputClass::send_ws_chunk(message_t&& line)
+void MessageOutputClass::drainSlot(TaskSlot& slot)
 {
-    if (!_ws) {
-        return;
-    }
+    // the main task already wrote its own lines to the serial port
+    const bool serialDone = slot.owner.load(std::memory_order_relaxed) == _mainTask;
 
-    if (nullptr == _ws_chunk) {
-        _ws_chunk = std::make_shared<message_t>(std::move(line));
-        _ws_chunk->reserve(WS_CHUNK_SIZE_BYTES + 128); // add room for one more line
-    } else {
-        _ws_chunk->insert(_ws_chunk->end(), line.begin(), line.end());
-    }
+    uint32_t head = slot.head.load(std::memory_order_relaxed);
+    const uint32_t tail = slot.tail.load(std::memory_order_acquire);
 
-    bool small = _ws_chunk->size() < WS_CHUNK_SIZE_BYTES;
-    bool recent = (millis() - _last_ws_chunk_sent) < WS_CHUNK_INTERVAL_MS;
-    if (small && recent) {
-        return;
-    }
+    while (head != tail) {
+        LineEntry entry = std::move(slot.lines[head % LINE_QUEUE_DEPTH]);
+        slot.head.store(++head, std::memory_order_release);
 
-    bool added_warning = false;
-    for (auto& client : _ws->getClients()) {
-        if (client.queueIsFull()) {
-            continue;
+        message_t line;
+        if (entry.fmt != nullptr) {
+            renderDeferred(entry.fmt, entry.data, line);
+        } else {
+            line = std::move(entry.data);
         }
 
-        client.text(_ws_chunk);
-
-        // note that all clients will see the warning, even if only one
-        // client is struggeling. however, this should be rare. we
-        // won't be copying chunks around to avoid this. we do however,
-        // avoid adding the warning multiple times.
-        if (client.queueIsFull() && !added_warning) {
-            static char const warningStr[] = "\nWARNING: websocket client's queue is full, expect log lines missing\n";
-            _ws_chunk->insert(_ws_chunk->end(), warningStr, warningStr + sizeof(warningStr) - 1);
-            added_warning = true;
+        if (!serialDone) {
+            serialWrite(line);
+        }
+        Syslog.write(line.data(), line.size());
+        if (_sink) {
+            _sink->writeLine(line.data(), line.size());
         }
     }
 
-    _ws_chunk = nullptr;
-    _last_ws_chunk_sent = millis();
+    const uint32_t droppedLines = slot.dropped.exchange(0, std::memory_order_relaxed);
+    if (droppedLines > 0) {
+        char warning[64];
+        const int len = snprintf(warning, sizeof(warning),
+            "WARNING: %u log lines dropped (line queue full)\n", static_cast<unsigned>(droppedLines));
+        message_t line(warning, warning + len);
+        serialWrite(line);
+        if (_sink) {
+            _sink->writeLine(line.data(), line.size());
+        }
+    }
 }
 
 void MessageOutputClass::loop()
 {
-    std::lock_guard<std::mutex> lock(_msgLock);
-
-    // clean up (possibly filled) buffers of deleted tasks
-    auto map_iter = _task_messages.begin();
-    while (map_iter != _task_messages.end()) {
-        if (eTaskGetState(map_iter->first) == eDeleted) {
-            map_iter = _task_messages.erase(map_iter);
+    for (auto& slot : _slots) {
+        const TaskHandle_t owner = slot.owner.load(std::memory_order_acquire);
+        if (owner == nullptr) {
             continue;
         }
 
-        ++map_iter;
-    }
+        drainSlot(slot);
 
-    while (!_lines.empty()) {
-        Syslog.write(_lines.front().data(), _lines.front().size());
-        send_ws_chunk(std::move(_lines.front()));
-        _lines.pop();
+        // release (possibly filled) slots of deleted tasks once drained.
+        // the pending buffer is safe to touch here, its owner is gone.
+        if (eTaskGetState(owner) == eDeleted
+            && slot.head.load(std::memory_order_relaxed) == slot.tail.load(std::memory_order_relaxed)) {
+            slot.pending = message_t();
+            slot.owner.store(nullptr, std::memory_order_release);
+        }
     }
 }
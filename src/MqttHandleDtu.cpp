@@ -6,6 +6,7 @@
 #include "Configuration.h"
 #include "MqttSettings.h"
 #include "NetworkSettings.h"
+#include "SchedulerMonitor.h"
 #include <CpuTemperature.h>
 #include <Hoymiles.h>
 
@@ -19,6 +20,7 @@ MqttHandleDtuClass::MqttHandleDtuClass()
 void MqttHandleDtuClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("mqtt_dtu", _loopTask, std::bind(&MqttHandleDtuClass::loop, this));
     _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
     _loopTask.enable();
 }
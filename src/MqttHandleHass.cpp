@@ -3,9 +3,13 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MqttHandleHass.h"
+#include "Configuration.h"
+#include "JsonArena.h"
 #include "MqttHandleInverter.h"
 #include "MqttSettings.h"
 #include "NetworkSettings.h"
+#include "SchedulerMonitor.h"
+#include "SunPosition.h"
 #include "Utils.h"
 #include "__compiled_constants.h"
 #include "defaults.h"
@@ -17,6 +21,25 @@ static const char* TAG = "mqtt";
 
 MqttHandleHassClass MqttHandleHass;
 
+std::map<uint32_t, uint32_t> MqttHandleHassClass::_sentConfigHashes;
+
+std::vector<MqttHandleHassClass::RenderedConfig> MqttHandleHassClass::_renderedConfigs;
+std::map<String, String> MqttHandleHassClass::_deviceBlockCache;
+bool MqttHandleHassClass::_renderedValid = false;
+bool MqttHandleHassClass::_rendering = false;
+bool MqttHandleHassClass::_renderSkippedEntities = false;
+String MqttHandleHassClass::_renderedDtuUrl;
+
+static uint32_t fnv1aHash(const String& data)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < data.length(); i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 MqttHandleHassClass::MqttHandleHassClass()
     : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleHassClass::loop, this))
 {
@@ -24,8 +47,30 @@ MqttHandleHassClass::MqttHandleHassClass()
 
 void MqttHandleHassClass::init(Scheduler& scheduler)
 {
+    // Discovery data depends on MQTT and inverter settings
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        if (scope == ConfigScope::Mqtt || scope == ConfigScope::Inverter || scope == ConfigScope::All) {
+            _renderedValid = false;
+            forceUpdate();
+        }
+    });
+
+    // Refresh the retained discovery configs in the nightly idle window
+    // instead of during the day, when ticks are needed for polling. The
+    // re-render is deliberate here: the window is idle anyway and it
+    // picks up drift the cache cannot see, like a renamed inverter model
+    SunPosition.onDayPeriodChanged([this](const bool isDay) {
+        if (!isDay) {
+            _renderedValid = false;
+            forceUpdate();
+        }
+    });
+
     scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("mqtt_hass", _loopTask, std::bind(&MqttHandleHassClass::loop, this));
     _loopTask.enable();
+
+    _publishWork.init(scheduler, "mqtt_hass_publish");
 }
 
 void MqttHandleHassClass::loop()
@@ -43,6 +88,47 @@ void MqttHandleHassClass::loop()
         publishConfig();
         _updateForced = false;
     }
+
+    if (!_publishWork.busy()) {
+        return;
+    }
+
+    if (!MqttSettings.getConnected()) {
+        // Drop pending configs, a fresh set is queued on reconnect. An
+        // interrupted builder pass leaves an incomplete cache behind
+        _publishWork.cancel();
+        _publishQueue.clear();
+        if (_rendering) {
+            _rendering = false;
+            _renderedValid = false;
+        }
+    }
+}
+
+void MqttHandleHassClass::startPublishWork()
+{
+    // Time-budgeted drain: each step publishes one discovery document,
+    // however long the queue is
+    _publishWork.start([this] {
+        if (_publishQueue.empty()) {
+            return false;
+        }
+
+        _publishQueue.front()();
+        _publishQueue.pop_front();
+
+        if (_publishQueue.empty()) {
+            if (_rendering) {
+                _rendering = false;
+                // Entities whose statistics had not arrived yet were
+                // skipped; keeping the cache invalid makes the next
+                // pass render them
+                _renderedValid = !_renderSkippedEntities;
+            }
+            return false;
+        }
+        return true;
+    });
 }
 
 void MqttHandleHassClass::forceUpdate()
@@ -60,54 +146,84 @@ void MqttHandleHassClass::publishConfig()
         return;
     }
 
-    ESP_LOGI(TAG, "Publish HA config");
     _publishConfigTimeout.set(MAX_CONFIG_PUBLISH_RATIO);
 
-    const CONFIG_T& config = Configuration.get();
+    // A valid cache means nothing the documents depend on changed since
+    // the last builder pass: replay the stored buffers. The URL check
+    // catches a DHCP lease handing out a different address, which is
+    // baked into every device block
+    if (_renderedValid && getDtuUrl() == _renderedDtuUrl) {
+        ESP_LOGI(TAG, "Queue HA config replay (%u rendered documents)", static_cast<unsigned>(_renderedConfigs.size()));
+        _publishQueue.clear();
+        _rendering = false;
+        for (size_t i = 0; i < _renderedConfigs.size(); i++) {
+            _publishQueue.emplace_back([i] { publish(_renderedConfigs[i].subtopic, _renderedConfigs[i].payload); });
+        }
+        startPublishWork();
+        return;
+    }
 
-    // publish DTU sensors
-    publishDtuSensor("IP", "dtu/ip", "", "mdi:network-outline", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("WiFi Signal", "dtu/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Uptime", "dtu/uptime", "s", "", DEVICE_CLS_DURATION, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Temperature", "dtu/temperature", "°C", "", DEVICE_CLS_TEMPERATURE, STATE_CLS_MEASUREMENT, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Heap Size", "dtu/heap/size", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Heap Free", "dtu/heap/free", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Largest Free Heap Block", "dtu/heap/maxalloc", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-    publishDtuSensor("Lifetime Minimum Free Heap", "dtu/heap/minfree", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    ESP_LOGI(TAG, "Queue HA config publish");
 
-    publishDtuSensor("Yield Total", "ac/yieldtotal", "kWh", "", DEVICE_CLS_ENERGY, STATE_CLS_TOTAL_INCREASING, CATEGORY_NONE);
-    publishDtuSensor("Yield Day", "ac/yieldday", "Wh", "", DEVICE_CLS_ENERGY, STATE_CLS_TOTAL_INCREASING, CATEGORY_NONE);
-    publishDtuSensor("AC Power", "ac/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE);
-    publishDtuSensor("DC Power", "dc/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE);
+    const CONFIG_T& config = Configuration.get();
 
-    publishDtuBinarySensor("Status", config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online, config.Mqtt.Lwt.Value_Offline, DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    // The configs are only queued here; the loop drains a few entries
+    // per tick so one invocation never blocks for the whole set. The
+    // builders record their serialized output into the render cache as
+    // a side effect of publishing
+    _publishQueue.clear();
+    _renderedConfigs.clear();
+    _deviceBlockCache.clear();
+    _renderedDtuUrl = getDtuUrl();
+    _renderedValid = false;
+    _rendering = true;
+    _renderSkippedEntities = false;
+
+    // queue DTU sensors
+    _publishQueue.emplace_back([] { publishDtuSensor("IP", "dtu/ip", "", "mdi:network-outline", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("WiFi Signal", "dtu/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Uptime", "dtu/uptime", "s", "", DEVICE_CLS_DURATION, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Temperature", "dtu/temperature", "°C", "", DEVICE_CLS_TEMPERATURE, STATE_CLS_MEASUREMENT, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Heap Size", "dtu/heap/size", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Heap Free", "dtu/heap/free", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Largest Free Heap Block", "dtu/heap/maxalloc", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Lifetime Minimum Free Heap", "dtu/heap/minfree", "Bytes", "mdi:memory", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+
+    _publishQueue.emplace_back([] { publishDtuSensor("Yield Total", "ac/yieldtotal", "kWh", "", DEVICE_CLS_ENERGY, STATE_CLS_TOTAL_INCREASING, CATEGORY_NONE); });
+    _publishQueue.emplace_back([] { publishDtuSensor("Yield Day", "ac/yieldday", "Wh", "", DEVICE_CLS_ENERGY, STATE_CLS_TOTAL_INCREASING, CATEGORY_NONE); });
+    _publishQueue.emplace_back([] { publishDtuSensor("AC Power", "ac/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE); });
+    _publishQueue.emplace_back([] { publishDtuSensor("DC Power", "dc/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE); });
+
+    _publishQueue.emplace_back([] {
+        const CONFIG_T& cfg = Configuration.get();
+        publishDtuBinarySensor("Status", cfg.Mqtt.Lwt.Topic, cfg.Mqtt.Lwt.Value_Online, cfg.Mqtt.Lwt.Value_Offline, DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    });
 
     // Loop all inverters
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
-        yield();
 
-        publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+        _publishQueue.emplace_back([inv] { publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG); });
+        _publishQueue.emplace_back([inv] { publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG); });
+        _publishQueue.emplace_back([inv] { publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG); });
+        _publishQueue.emplace_back([inv] { publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG); });
 
-        publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+        _publishQueue.emplace_back([inv] { publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG); });
+        _publishQueue.emplace_back([inv] { publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG); });
 
-        publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+        _publishQueue.emplace_back([inv] { publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG); });
+        _publishQueue.emplace_back([inv] { publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG); });
 
-        publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE);
+        _publishQueue.emplace_back([inv] { publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE); });
 
-        publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
+        _publishQueue.emplace_back([inv] { publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC); });
 
         // Loop all channels
         for (auto& t : inv->Statistics()->getChannelTypes()) {
@@ -117,17 +233,19 @@ void MqttHandleHassClass::publishConfig()
                     if (t == TYPE_DC && !config.Mqtt.Hass.IndividualPanels) {
                         clear = true;
                     }
-                    publishInverterField(inv, t, c, deviceFieldAssignment[f], clear);
-                    yield();
+                    _publishQueue.emplace_back([inv, t, c, f, clear] { publishInverterField(inv, t, c, deviceFieldAssignment[f], clear); });
                 }
             }
         }
     }
+
+    startPublishWork();
 }
 
 void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const byteAssign_fieldDeviceClass_t fieldType, const bool clear)
 {
     if (!inv->Statistics()->hasChannelFieldValue(type, channel, fieldType.fieldId)) {
+        _renderSkippedEntities = true;
         return;
     }
 
@@ -164,7 +282,8 @@ void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract>
 
         String unit_of_measure = inv->Statistics()->getChannelFieldUnit(type, channel, fieldType.fieldId);
 
-        JsonDocument root;
+        MqttPayloadArena.reset();
+        JsonDocument root(&MqttPayloadArena);
         createInverterInfo(root, inv);
         addCommonMetadata(root, unit_of_measure, "", fieldType.deviceClsId, fieldType.stateClsId, CATEGORY_NONE);
 
@@ -199,7 +318,8 @@ void MqttHandleHassClass::publishInverterButton(
 
     const String cmdTopic = MqttSettings.getPrefix() + serial + "/" + state_topic;
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createInverterInfo(root, inv);
     addCommonMetadata(root, "", icon, device_class, state_class, category);
 
@@ -231,7 +351,8 @@ void MqttHandleHassClass::publishInverterNumber(
     const String cmdTopic = MqttSettings.getPrefix() + serial + "/" + command_topic;
     const String statTopic = MqttSettings.getPrefix() + serial + "/" + stateTopic;
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createInverterInfo(root, inv);
     addCommonMetadata(root, unit_of_measure, icon, DEVICE_CLS_NONE, state_class, category);
 
@@ -248,47 +369,64 @@ void MqttHandleHassClass::publishInverterNumber(
 
 void MqttHandleHassClass::createInverterInfo(JsonDocument& root, std::shared_ptr<InverterAbstract> inv)
 {
-    createDeviceInfo(
-        root,
-        inv->name(),
-        inv->serialString(),
-        getDtuUrl(),
-        "OpenDTU",
-        inv->typeName(),
-        __COMPILED_GIT_HASH__,
-        getDtuUniqueId());
+    const String serial = inv->serialString();
+
+    auto it = _deviceBlockCache.find(serial);
+    if (it == _deviceBlockCache.end()) {
+        it = _deviceBlockCache.emplace(serial,
+            renderDeviceInfo(
+                inv->name(),
+                serial,
+                getDtuUrl(),
+                "OpenDTU",
+                inv->typeName(),
+                __COMPILED_GIT_HASH__,
+                getDtuUniqueId())).first;
+    }
+
+    root["dev"] = serialized(it->second);
 }
 
 void MqttHandleHassClass::createDtuInfo(JsonDocument& root)
 {
-    createDeviceInfo(
-        root,
-        NetworkSettings.getHostname(),
-        getDtuUniqueId(),
-        getDtuUrl(),
-        "OpenDTU",
-        "OpenDTU",
-        __COMPILED_GIT_HASH__);
+    const String dtuId = getDtuUniqueId();
+
+    auto it = _deviceBlockCache.find(dtuId);
+    if (it == _deviceBlockCache.end()) {
+        it = _deviceBlockCache.emplace(dtuId,
+            renderDeviceInfo(
+                NetworkSettings.getHostname(),
+                dtuId,
+                getDtuUrl(),
+                "OpenDTU",
+                "OpenDTU",
+                __COMPILED_GIT_HASH__)).first;
+    }
+
+    root["dev"] = serialized(it->second);
 }
 
-void MqttHandleHassClass::createDeviceInfo(
-    JsonDocument& root,
+String MqttHandleHassClass::renderDeviceInfo(
     const String& name, const String& identifiers, const String& configuration_url,
     const String& manufacturer, const String& model, const String& sw_version,
     const String& via_device)
 {
-    auto object = root["dev"].to<JsonObject>();
+    JsonDocument doc;
 
-    object["name"] = name;
-    object["ids"] = identifiers;
-    object["cu"] = configuration_url;
-    object["mf"] = manufacturer;
-    object["mdl"] = model;
-    object["sw"] = sw_version;
+    doc["name"] = name;
+    doc["ids"] = identifiers;
+    doc["cu"] = configuration_url;
+    doc["mf"] = manufacturer;
+    doc["mdl"] = model;
+    doc["sw"] = sw_version;
 
     if (via_device != "") {
-        object["via_device"] = via_device;
+        doc["via_device"] = via_device;
     }
+
+    String buffer;
+    serializeJson(doc, buffer);
+    return buffer;
 }
 
 String MqttHandleHassClass::getDtuUniqueId()
@@ -303,9 +441,31 @@ String MqttHandleHassClass::getDtuUrl()
 
 void MqttHandleHassClass::publish(const String& subtopic, const String& payload)
 {
+    // Capture the document for replay before any dedupe shortcut: the
+    // cache must hold the complete set even when the broker already
+    // retains parts of it
+    if (_rendering) {
+        _renderedConfigs.push_back({ subtopic, payload });
+    }
+
     String topic = Configuration.get().Mqtt.Hass.Topic;
     topic += subtopic;
-    MqttSettings.publishGeneric(topic, payload, Configuration.get().Mqtt.Hass.Retain);
+
+    const bool retain = Configuration.get().Mqtt.Hass.Retain;
+    const uint32_t topicHash = fnv1aHash(topic);
+    const uint32_t payloadHash = fnv1aHash(payload);
+
+    // With retain enabled the broker still holds the exact same config,
+    // so republishing identical payloads on reconnect is pure overhead
+    if (retain) {
+        auto it = _sentConfigHashes.find(topicHash);
+        if (it != _sentConfigHashes.end() && it->second == payloadHash) {
+            return;
+        }
+    }
+
+    MqttSettings.publishGeneric(topic, payload, retain);
+    _sentConfigHashes[topicHash] = payloadHash;
     yield();
 }
 
@@ -368,7 +528,8 @@ void MqttHandleHassClass::publishDtuBinarySensor(
 {
     const String dtuId = getDtuUniqueId();
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createDtuInfo(root);
     publishBinarySensor(root, dtuId, dtuId, name, state_topic, payload_on, payload_off, device_class, state_class, category);
 }
@@ -379,7 +540,8 @@ void MqttHandleHassClass::publishInverterBinarySensor(
 {
     const String serial = inv->serialString();
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createInverterInfo(root, inv);
     publishBinarySensor(root, "dtu_" + serial, serial, name, serial + "/" + state_topic, payload_on, payload_off, device_class, state_class, category);
 }
@@ -416,7 +578,8 @@ void MqttHandleHassClass::publishDtuSensor(
 {
     const String dtuId = getDtuUniqueId();
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createDtuInfo(root);
     publishSensor(root, dtuId, dtuId, name, state_topic, unit_of_measure, icon, device_class, state_class, category);
 }
@@ -428,7 +591,8 @@ void MqttHandleHassClass::publishInverterSensor(
 {
     const String serial = inv->serialString();
 
-    JsonDocument root;
+    MqttPayloadArena.reset();
+    JsonDocument root(&MqttPayloadArena);
     createInverterInfo(root, inv);
     publishSensor(root, "dtu_" + serial, serial, name, serial + "/" + state_topic, unit_of_measure, icon, device_class, state_class, category);
 }
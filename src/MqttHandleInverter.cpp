@@ -3,140 +3,284 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MqttHandleInverter.h"
+#include "FleetWalk.h"
+#include "JsonArena.h"
+#include "Lzss.h"
 #include "MqttSettings.h"
+#include "SchedulerMonitor.h"
+#include <ArduinoJson.h>
+#include <CyclePerf.h>
 #include <ctime>
+#include <vector>
 
 #undef TAG
 static const char* TAG = "mqtt";
 
-#define PUBLISH_MAX_INTERVAL 60000
-
 MqttHandleInverterClass MqttHandleInverter;
 
+std::map<std::pair<uint64_t, uint32_t>, String> MqttHandleInverterClass::_topicCache;
+
 MqttHandleInverterClass::MqttHandleInverterClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleInverterClass::loop, this))
+    : _coalesceTask(100 * TASK_MILLISECOND, TASK_FOREVER, std::bind(&MqttHandleInverterClass::coalesceLoop, this))
 {
 }
 
 void MqttHandleInverterClass::init(Scheduler& scheduler)
 {
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+
     subscribeTopics();
 
-    scheduler.addTask(_loopTask);
-    _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
-    _loopTask.enable();
+    // Inverter and channel renames change the published topic paths
+    Configuration.onConfigChanged([](const ConfigScope scope, const int8_t index) {
+        if (scope == ConfigScope::Inverter || scope == ConfigScope::All) {
+            clearTopicCache();
+        }
+    });
+
+    FleetWalk.registerVisitor({ "mqtt_inverter",
+        std::bind(&MqttHandleInverterClass::beginPass, this),
+        std::bind(&MqttHandleInverterClass::visit, this, _1, _2),
+        std::bind(&MqttHandleInverterClass::endPass, this) });
+
+    scheduler.addTask(_coalesceTask);
+    SchedulerMonitor.instrument("mqtt_inverter_coalesce", _coalesceTask, std::bind(&MqttHandleInverterClass::coalesceLoop, this));
+    _coalesceTask.enable();
 }
 
-void MqttHandleInverterClass::loop()
+bool MqttHandleInverterClass::beginPass()
 {
-    _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
+    // One consistent, lock-free view of the config for the whole pass
+    const auto cfg = Configuration.getSnapshot();
+
+    if (millis() - _lastPass < cfg->Mqtt.PublishInterval * 1000u && _lastPass != 0) {
+        return false;
+    }
 
+    // Not ready yet - the next fleet pass (one second away) retries,
+    // so a busy radio defers the publish instead of dropping it
     if (!MqttSettings.getConnected() || !Hoymiles.isAllRadioIdle()) {
-        _loopTask.forceNextIteration();
-        return;
+        return false;
     }
 
-    // Loop all inverters
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
+    _passCfg = cfg;
+    return true;
+}
 
-        const String subtopic = inv->serialString();
+void MqttHandleInverterClass::endPass()
+{
+    _lastPass = millis();
+    _passCfg.reset();
+}
 
-        // Name
-        MqttSettings.publish(subtopic + "/name", inv->name());
+void MqttHandleInverterClass::visit(std::shared_ptr<InverterAbstract>& inv, const uint8_t i)
+{
+    const auto& cfg = _passCfg;
 
-        // Radio Statistics
-        MqttSettings.publish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
-        MqttSettings.publish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
-        MqttSettings.publish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
-        MqttSettings.publish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
+    const String subtopic = inv->serialString();
 
-        if (inv->DevInfo()->getLastUpdate() > 0) {
-            // Bootloader Version
-            MqttSettings.publish(subtopic + "/device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
+    // Name
+    MqttSettings.queuePublish(subtopic + "/name", inv->name());
 
-            // Firmware Version
-            MqttSettings.publish(subtopic + "/device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
+    // Radio Statistics
+    MqttSettings.queuePublish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
+    MqttSettings.queuePublish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
+    MqttSettings.queuePublish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
+    MqttSettings.queuePublish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
+    MqttSettings.queuePublish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
+    MqttSettings.queuePublish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
+    MqttSettings.queuePublish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
 
-            // Firmware Build DateTime
-            MqttSettings.publish(subtopic + "/device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
+    if (inv->DevInfo()->getLastUpdate() > 0) {
+        // Bootloader Version
+        MqttSettings.queuePublish(subtopic + "/device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
 
-            // Hardware part number
-            MqttSettings.publish(subtopic + "/device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
+        // Firmware Version
+        MqttSettings.queuePublish(subtopic + "/device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
 
-            // Hardware version
-            MqttSettings.publish(subtopic + "/device/hwversion", inv->DevInfo()->getHwVersion());
-        }
+        // Firmware Build DateTime
+        MqttSettings.queuePublish(subtopic + "/device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
 
-        if (inv->SystemConfigPara()->getLastUpdate() > 0) {
-            // Limit
-            MqttSettings.publish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
+        // Hardware part number
+        MqttSettings.queuePublish(subtopic + "/device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
 
-            uint16_t maxpower = inv->DevInfo()->getMaxPower();
-            if (maxpower > 0) {
-                MqttSettings.publish(subtopic + "/status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100));
-            }
-        }
+        // Hardware version
+        MqttSettings.queuePublish(subtopic + "/device/hwversion", inv->DevInfo()->getHwVersion());
+    }
 
-        MqttSettings.publish(subtopic + "/status/reachable", String(inv->isReachable()));
-        MqttSettings.publish(subtopic + "/status/producing", String(inv->isProducing()));
+    // Unchanged values are skipped, but everything is republished
+    // from time to time so late subscribers still see all values
+    const bool fullPublish = (_lastPublishStats[i] == 0)
+        || (millis() - _lastFullPublishStats[i] > cfg->Mqtt.FullPublishInterval * 1000u);
+    if (fullPublish) {
+        _lastFullPublishStats[i] = millis();
+    }
 
-        if (inv->Statistics()->getLastUpdate() > 0) {
-            MqttSettings.publish(subtopic + "/status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
-        } else {
-            MqttSettings.publish(subtopic + "/status/last_update", String(0));
+    if (inv->SystemConfigPara()->getLastUpdate() > 0
+        && (fullPublish || inv->SystemConfigPara()->hasChangedSince(_lastPublishedLimitVersion[i]))) {
+        _lastPublishedLimitVersion[i] = inv->SystemConfigPara()->getLimitVersion();
+
+        // Limit
+        MqttSettings.queuePublish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()), PublishPriority::Control);
+
+        uint16_t maxpower = inv->DevInfo()->getMaxPower();
+        if (maxpower > 0) {
+            MqttSettings.queuePublish(subtopic + "/status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100), PublishPriority::Control);
         }
+    }
+
+    MqttSettings.queuePublish(subtopic + "/status/reachable", String(inv->isReachable()), PublishPriority::Control);
+    MqttSettings.queuePublish(subtopic + "/status/producing", String(inv->isProducing()), PublishPriority::Control);
+
+    if (inv->Statistics()->getLastUpdate() > 0) {
+        MqttSettings.queuePublish(subtopic + "/status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
+    } else {
+        MqttSettings.queuePublish(subtopic + "/status/last_update", String(0));
+    }
 
-        const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
-        if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i])) {
-            _lastPublishStats[i] = lastUpdateInternal;
+    const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
+    if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i])) {
+        const uint32_t previousPublish = _lastPublishStats[i];
+        _lastPublishStats[i] = lastUpdateInternal;
 
+        if (cfg->Mqtt.CompactJson) {
+            publishCompactJson(inv);
+        } else {
             // Loop all channels
             for (auto& t : inv->Statistics()->getChannelTypes()) {
                 for (auto& c : inv->Statistics()->getChannelsByType(t)) {
                     if (t == TYPE_DC) {
-                        INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-                        if (inv_cfg != nullptr) {
-                            // TODO(tbnobody)
-                            MqttSettings.publish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", inv_cfg->channel[c].Name);
-                        }
+                        // TODO(tbnobody)
+                        MqttSettings.queuePublish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", inv->Statistics()->getChannelName(c));
                     }
                     for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
+                        if (!fullPublish
+                            && static_cast<int32_t>(inv->Statistics()->getChannelFieldLastChange(t, c, _publishFields[f]) - previousPublish) <= 0) {
+                            // Value did not change since the last publish
+                            continue;
+                        }
                         publishField(inv, t, c, _publishFields[f]);
                     }
                 }
             }
         }
+    }
+
+    // Hand this inverter's messages to the client in one burst
+    MqttSettings.flushPublishQueue();
+}
 
-        yield();
+void MqttHandleInverterClass::publishCompactJson(std::shared_ptr<InverterAbstract> inv)
+{
+    const auto cfg = Configuration.getSnapshot();
+
+    MqttPayloadArena.reset();
+    JsonDocument doc(&MqttPayloadArena);
+
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        JsonObject typeObj = doc[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            String chanNum;
+            if (t == TYPE_DC) {
+                // TODO(tbnobody)
+                chanNum = static_cast<uint8_t>(c) + 1;
+            } else {
+                chanNum = c;
+            }
+            JsonObject chanObj = typeObj[chanNum].to<JsonObject>();
+
+            if (t == TYPE_DC) {
+                chanObj["name"] = inv->Statistics()->getChannelName(c);
+            }
+
+            for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
+                if (!inv->Statistics()->hasChannelFieldValue(t, c, _publishFields[f])) {
+                    continue;
+                }
+
+                // Interned keys: ArduinoJson links const char* without
+                // copying, so no temporary Strings per field
+                const char* chanName;
+                if (t == TYPE_INV && _publishFields[f] == FLD_PDC) {
+                    chanName = "powerdc";
+                } else {
+                    chanName = inv->Statistics()->getChannelFieldNameLower(t, c, _publishFields[f]);
+                }
+
+                // Values are pre-rendered with their field precision so the
+                // document stays as small as the per-topic payloads
+                chanObj[chanName] = serialized(inv->Statistics()->getChannelFieldValueString(t, c, _publishFields[f]));
+            }
+        }
     }
+
+    String buffer;
+    serializeJson(doc, buffer);
+
+    // Optional LZSS compression for metered backhaul; the ".hs" suffix
+    // marks a heatshrink (window 8, lookahead 4) payload so consumers
+    // can subscribe to either representation explicitly
+    if (cfg->Mqtt.CompactJsonCompress && buffer.length() > 0) {
+        std::vector<uint8_t> compressed(buffer.length());
+        const uint32_t start = micros();
+        const size_t compressedLen = lzssCompress(
+            reinterpret_cast<const uint8_t*>(buffer.c_str()), buffer.length(),
+            compressed.data(), compressed.size() - 1);
+        _compressionStats.cpuMicros.fetch_add(micros() - start, std::memory_order_relaxed);
+        _compressionStats.bytesIn.fetch_add(buffer.length(), std::memory_order_relaxed);
+
+        if (compressedLen > 0) {
+            _compressionStats.published.fetch_add(1, std::memory_order_relaxed);
+            _compressionStats.bytesOut.fetch_add(compressedLen, std::memory_order_relaxed);
+            MqttSettings.queuePublishBinary(inv->serialString() + "/json.hs", compressed.data(), compressedLen);
+            return;
+        }
+
+        // did not shrink below the original size; fall through to plain
+        _compressionStats.skipped.fetch_add(1, std::memory_order_relaxed);
+        _compressionStats.bytesOut.fetch_add(buffer.length(), std::memory_order_relaxed);
+    }
+
+    MqttSettings.queuePublish(inv->serialString() + "/json", buffer);
 }
 
 void MqttHandleInverterClass::publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
+    CYCLE_PERF_SCOPE("mqtt_publish_field");
+
     const String topic = getTopic(inv, type, channel, fieldId);
     if (topic == "") {
         return;
     }
 
-    MqttSettings.publish(topic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
+    MqttSettings.queuePublish(topic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
 }
 
-String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+const String& MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
+    static const String empty;
+
     if (!inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
-        return "";
+        return empty;
+    }
+
+    // Topics only depend on the serial and the static field layout of the
+    // inverter type, so each one is rendered exactly once and the publish
+    // loop gets away without any String concatenation
+    const auto key = std::make_pair(inv->serial(),
+        (static_cast<uint32_t>(type) << 16) | (static_cast<uint32_t>(channel) << 8) | fieldId);
+
+    auto it = _topicCache.find(key);
+    if (it != _topicCache.end()) {
+        return it->second;
     }
 
-    String chanName;
+    const char* chanName;
     if (type == TYPE_INV && fieldId == FLD_PDC) {
         chanName = "powerdc";
     } else {
-        chanName = inv->Statistics()->getChannelFieldName(type, channel, fieldId);
-        chanName.toLowerCase();
+        chanName = inv->Statistics()->getChannelFieldNameLower(type, channel, fieldId);
     }
 
     String chanNum;
@@ -147,7 +291,12 @@ String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv,
         chanNum = channel;
     }
 
-    return inv->serialString() + "/" + chanNum + "/" + chanName;
+    return _topicCache.emplace(key, inv->serialString() + "/" + chanNum + "/" + chanName).first->second;
+}
+
+void MqttHandleInverterClass::clearTopicCache()
+{
+    _topicCache.clear();
 }
 
 void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, const size_t len)
@@ -189,20 +338,20 @@ void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::M
     case Topic::LimitPersistentRelative:
         // Set inverter limit relative persistent
         ESP_LOGI(TAG, "Limit Persistent: %.1f %%", payload_val);
-        inv->sendActivePowerControlRequest(payload_val, PowerLimitControlType::RelativPersistent);
+        scheduleLimitCommand(inv, payload_val, PowerLimitControlType::RelativPersistent);
         break;
 
     case Topic::LimitPersistentAbsolute:
         // Set inverter limit absolute persistent
         ESP_LOGI(TAG, "Limit Persistent: %.1f W", payload_val);
-        inv->sendActivePowerControlRequest(payload_val, PowerLimitControlType::AbsolutPersistent);
+        scheduleLimitCommand(inv, payload_val, PowerLimitControlType::AbsolutPersistent);
         break;
 
     case Topic::LimitNonPersistentRelative:
         // Set inverter limit relative non persistent
         ESP_LOGI(TAG, "Limit Non-Persistent: %.1f %%", payload_val);
         if (!properties.retain) {
-            inv->sendActivePowerControlRequest(payload_val, PowerLimitControlType::RelativNonPersistent);
+            scheduleLimitCommand(inv, payload_val, PowerLimitControlType::RelativNonPersistent);
         } else {
             ESP_LOGW(TAG, "Ignored because retained");
         }
@@ -212,7 +361,7 @@ void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::M
         // Set inverter limit absolute non persistent
         ESP_LOGI(TAG, "Limit Non-Persistent: %.1f W", payload_val);
         if (!properties.retain) {
-            inv->sendActivePowerControlRequest(payload_val, PowerLimitControlType::AbsolutNonPersistent);
+            scheduleLimitCommand(inv, payload_val, PowerLimitControlType::AbsolutNonPersistent);
         } else {
             ESP_LOGW(TAG, "Ignored because retained");
         }
@@ -245,6 +394,53 @@ void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::M
     }
 }
 
+void MqttHandleInverterClass::scheduleLimitCommand(std::shared_ptr<InverterAbstract> inv, const float limit, const PowerLimitControlType type)
+{
+    const uint32_t window = Configuration.get().Mqtt.LimitCoalesceWindow;
+    if (window == 0) {
+        inv->sendActivePowerControlRequest(limit, type);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_pendingLimitsMutex);
+    auto& pending = _pendingLimits[inv->serial()];
+
+    // An isolated command is sent right away, only followers within the
+    // window are held back
+    if (!pending.armed && (millis() - pending.lastSent) >= window) {
+        pending.lastSent = millis();
+        inv->sendActivePowerControlRequest(limit, type);
+        return;
+    }
+
+    // Overwrite instead of queueing: only the freshest setpoint matters
+    pending.limit = limit;
+    pending.type = type;
+    pending.armed = true;
+}
+
+void MqttHandleInverterClass::coalesceLoop()
+{
+    const uint32_t window = Configuration.get().Mqtt.LimitCoalesceWindow;
+
+    std::lock_guard<std::mutex> lock(_pendingLimitsMutex);
+    for (auto& entry : _pendingLimits) {
+        auto& pending = entry.second;
+        if (!pending.armed || (millis() - pending.lastSent) < window) {
+            continue;
+        }
+
+        pending.armed = false;
+        pending.lastSent = millis();
+
+        auto inv = Hoymiles.getInverterBySerial(entry.first);
+        if (inv != nullptr) {
+            ESP_LOGI(TAG, "Sending coalesced limit: %.1f", pending.limit);
+            inv->sendActivePowerControlRequest(pending.limit, pending.type);
+        }
+    }
+}
+
 void MqttHandleInverterClass::subscribeTopics()
 {
     String const& prefix = MqttSettings.getPrefix();
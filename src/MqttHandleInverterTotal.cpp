@@ -6,6 +6,7 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "MqttSettings.h"
+#include "SchedulerMonitor.h"
 #include <Hoymiles.h>
 
 MqttHandleInverterTotalClass MqttHandleInverterTotal;
@@ -18,6 +19,7 @@ MqttHandleInverterTotalClass::MqttHandleInverterTotalClass()
 void MqttHandleInverterTotalClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("mqtt_inverter_total", _loopTask, std::bind(&MqttHandleInverterTotalClass::loop, this));
     _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
     _loopTask.enable();
 }
@@ -32,11 +34,25 @@ void MqttHandleInverterTotalClass::loop()
         return;
     }
 
-    MqttSettings.publish("ac/power", String(Datastore.getTotalAcPowerEnabled(), Datastore.getTotalAcPowerDigits()));
-    MqttSettings.publish("ac/yieldtotal", String(Datastore.getTotalAcYieldTotalEnabled(), Datastore.getTotalAcYieldTotalDigits()));
-    MqttSettings.publish("ac/yieldday", String(Datastore.getTotalAcYieldDayEnabled(), Datastore.getTotalAcYieldDayDigits()));
-    MqttSettings.publish("ac/is_valid", String(Datastore.getIsAllEnabledReachable()));
-    MqttSettings.publish("dc/power", String(Datastore.getTotalDcPowerEnabled(), Datastore.getTotalDcPowerDigits()));
-    MqttSettings.publish("dc/irradiation", String(Datastore.getTotalDcIrradiation(), 3));
-    MqttSettings.publish("dc/is_valid", String(Datastore.getIsAllEnabledReachable()));
+    // one coherent snapshot for all topics instead of taking the
+    // datastore mutex per value
+    const auto totals = Datastore.getTotalsSnapshot();
+
+    MqttSettings.publish("ac/power", String(totals.AcPowerEnabled, totals.AcPowerDigits));
+    MqttSettings.publish("ac/yieldtotal", String(totals.AcYieldTotalEnabled, totals.AcYieldTotalDigits));
+    MqttSettings.publish("ac/yieldday", String(totals.AcYieldDayEnabled, totals.AcYieldDayDigits));
+    MqttSettings.publish("ac/is_valid", String(totals.IsAllEnabledReachable));
+    MqttSettings.publish("dc/power", String(totals.DcPowerEnabled, totals.DcPowerDigits));
+    MqttSettings.publish("dc/irradiation", String(totals.DcIrradiation, 3));
+    MqttSettings.publish("dc/is_valid", String(totals.IsAllEnabledReachable));
+
+    // registered derived metrics, computed on the datastore pass
+    DatastoreClass::DerivedMetricValue_t metrics[DatastoreClass::MAX_DERIVED_METRICS];
+    const size_t metricCount = Datastore.copyDerivedMetrics(metrics, DatastoreClass::MAX_DERIVED_METRICS);
+    for (size_t i = 0; i < metricCount; i++) {
+        if (!metrics[i].valid) {
+            continue;
+        }
+        MqttSettings.publish(String("derived/") + metrics[i].name, String(metrics[i].value, 3));
+    }
 }
@@ -4,6 +4,8 @@
  */
 #include "MqttSettings.h"
 #include "Configuration.h"
+#include "CrashRecorder.h"
+#include <esp_rom_crc.h>
 #include <frozen/map.h>
 #include <frozen/string.h>
 
@@ -33,8 +35,13 @@ void MqttSettingsClass::NetworkEvent(network_event event)
 void MqttSettingsClass::onMqttConnect(const bool sessionPresent)
 {
     ESP_LOGI(TAG, "Connected to MQTT.");
+    CrashRecorder.note("mqtt connected");
+    _stats.connects.fetch_add(1, std::memory_order_relaxed);
+    for (auto& listener : _connectionListeners) {
+        listener(true);
+    }
     const CONFIG_T& config = Configuration.get();
-    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online);
+    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online, PublishPriority::Critical);
 
     std::lock_guard<std::mutex> lock(_clientLock);
     if (_mqttClient != nullptr) {
@@ -53,6 +60,11 @@ void MqttSettingsClass::subscribe(const String& topic, const uint8_t qos, const
     }
 }
 
+void MqttSettingsClass::onConnectionChanged(std::function<void(const bool connected)> listener)
+{
+    _connectionListeners.push_back(std::move(listener));
+}
+
 void MqttSettingsClass::unsubscribe(const String& topic)
 {
     _mqttSubscribeParser.unregister_callback(topic.c_str());
@@ -79,6 +91,11 @@ void MqttSettingsClass::onMqttDisconnect(espMqttClientTypes::DisconnectReason re
     const char* reasonStr = (it != reasons.end()) ? it->second.data() : "Unknown";
 
     ESP_LOGW(TAG, "Disconnected from MQTT. Reason: %s", reasonStr);
+    CrashRecorder.note("mqtt disconnected");
+    _stats.disconnects.fetch_add(1, std::memory_order_relaxed);
+    for (auto& listener : _connectionListeners) {
+        listener(false);
+    }
 
     _mqttReconnectTimer.once(
         2, +[](MqttSettingsClass* instance) { instance->performConnect(); }, this);
@@ -118,47 +135,15 @@ void MqttSettingsClass::onMqttMessage(const espMqttClientTypes::MessagePropertie
 void MqttSettingsClass::performConnect()
 {
     if (NetworkSettings.isConnected() && Configuration.get().Mqtt.Enabled) {
-        using std::placeholders::_1;
-        using std::placeholders::_2;
-        using std::placeholders::_3;
-        using std::placeholders::_4;
-        using std::placeholders::_5;
-        using std::placeholders::_6;
-
         std::lock_guard<std::mutex> lock(_clientLock);
         if (_mqttClient == nullptr) {
             return;
         }
 
+        // The client is fully configured since its creation, so the
+        // 2 s retry loop while the broker is down only pays for the
+        // connection attempt itself
         ESP_LOGI(TAG, "Connecting to MQTT...");
-        const CONFIG_T& config = Configuration.get();
-        const String willTopic = getPrefix() + config.Mqtt.Lwt.Topic;
-        String clientId = getClientId();
-        if (config.Mqtt.Tls.Enabled) {
-            static_cast<espMqttClientSecure*>(_mqttClient)->setCACert(config.Mqtt.Tls.RootCaCert);
-            static_cast<espMqttClientSecure*>(_mqttClient)->setServer(config.Mqtt.Hostname, config.Mqtt.Port);
-            if (config.Mqtt.Tls.CertLogin) {
-                static_cast<espMqttClientSecure*>(_mqttClient)->setCertificate(config.Mqtt.Tls.ClientCert);
-                static_cast<espMqttClientSecure*>(_mqttClient)->setPrivateKey(config.Mqtt.Tls.ClientKey);
-            } else {
-                static_cast<espMqttClientSecure*>(_mqttClient)->setCredentials(config.Mqtt.Username, config.Mqtt.Password);
-            }
-            static_cast<espMqttClientSecure*>(_mqttClient)->setWill(willTopic.c_str(), config.Mqtt.Lwt.Qos, config.Mqtt.Retain, config.Mqtt.Lwt.Value_Offline);
-            static_cast<espMqttClientSecure*>(_mqttClient)->setClientId(clientId.c_str());
-            static_cast<espMqttClientSecure*>(_mqttClient)->setCleanSession(config.Mqtt.CleanSession);
-            static_cast<espMqttClientSecure*>(_mqttClient)->onConnect(std::bind(&MqttSettingsClass::onMqttConnect, this, _1));
-            static_cast<espMqttClientSecure*>(_mqttClient)->onDisconnect(std::bind(&MqttSettingsClass::onMqttDisconnect, this, _1));
-            static_cast<espMqttClientSecure*>(_mqttClient)->onMessage(std::bind(&MqttSettingsClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
-        } else {
-            static_cast<espMqttClient*>(_mqttClient)->setServer(config.Mqtt.Hostname, config.Mqtt.Port);
-            static_cast<espMqttClient*>(_mqttClient)->setCredentials(config.Mqtt.Username, config.Mqtt.Password);
-            static_cast<espMqttClient*>(_mqttClient)->setWill(willTopic.c_str(), config.Mqtt.Lwt.Qos, config.Mqtt.Retain, config.Mqtt.Lwt.Value_Offline);
-            static_cast<espMqttClient*>(_mqttClient)->setClientId(clientId.c_str());
-            static_cast<espMqttClient*>(_mqttClient)->setCleanSession(config.Mqtt.CleanSession);
-            static_cast<espMqttClient*>(_mqttClient)->onConnect(std::bind(&MqttSettingsClass::onMqttConnect, this, _1));
-            static_cast<espMqttClient*>(_mqttClient)->onDisconnect(std::bind(&MqttSettingsClass::onMqttDisconnect, this, _1));
-            static_cast<espMqttClient*>(_mqttClient)->onMessage(std::bind(&MqttSettingsClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
-        }
         _mqttClient->connect();
     }
 }
@@ -166,7 +151,7 @@ void MqttSettingsClass::performConnect()
 void MqttSettingsClass::performDisconnect()
 {
     const CONFIG_T& config = Configuration.get();
-    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Offline);
+    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Offline, PublishPriority::Critical);
     std::lock_guard<std::mutex> lock(_clientLock);
     if (_mqttClient == nullptr) {
         return;
@@ -207,7 +192,7 @@ String MqttSettingsClass::getClientId() const
     return clientId;
 }
 
-void MqttSettingsClass::publish(const String& subtopic, const String& payload)
+void MqttSettingsClass::publish(const String& subtopic, const String& payload, const PublishPriority priority)
 {
     String topic = getPrefix();
     topic += subtopic;
@@ -215,16 +200,164 @@ void MqttSettingsClass::publish(const String& subtopic, const String& payload)
     String value = payload;
     value.trim();
 
-    publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0);
+    publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0, priority);
 }
 
-void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos)
+void MqttSettingsClass::queuePublish(const String& subtopic, const String& payload, const PublishPriority priority)
 {
+    QueuedPublish item;
+    item.topic = getPrefix();
+    item.topic += subtopic;
+    item.payload = payload;
+    item.payload.trim();
+    item.retain = Configuration.get().Mqtt.Retain;
+    item.qos = 0;
+    item.priority = priority;
+    item.enqueuedAt = millis();
+
+    _publishQueue.push_back(std::move(item));
+}
+
+void MqttSettingsClass::queuePublishBinary(const String& subtopic, const uint8_t* payload, const size_t len, const PublishPriority priority)
+{
+    QueuedPublish item;
+    item.topic = getPrefix();
+    item.topic += subtopic;
+    // String::concat with an explicit length copies the bytes verbatim
+    item.payload.concat(reinterpret_cast<const char*>(payload), len);
+    item.retain = Configuration.get().Mqtt.Retain;
+    item.qos = 0;
+    item.priority = priority;
+    item.enqueuedAt = millis();
+
+    _publishQueue.push_back(std::move(item));
+}
+
+void MqttSettingsClass::flushPublishQueue()
+{
+    if (_publishQueue.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_clientLock);
+        for (auto& item : _publishQueue) {
+            enqueueOutbox(std::move(item));
+        }
+        drainOutbox();
+    }
+
+    _publishQueue.clear();
+}
+
+void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos, const PublishPriority priority)
+{
+    QueuedPublish item;
+    item.topic = topic;
+    item.payload = payload;
+    item.retain = retain;
+    item.qos = qos;
+    item.priority = priority;
+    item.enqueuedAt = millis();
+
     std::lock_guard<std::mutex> lock(_clientLock);
+    enqueueOutbox(std::move(item));
+    drainOutbox();
+}
+
+void MqttSettingsClass::shedTelemetryBacklog()
+{
+    std::lock_guard<std::mutex> lock(_clientLock);
+
+    constexpr uint8_t prio = static_cast<uint8_t>(PublishPriority::Telemetry);
+    auto& queue = _outbox[prio];
+    if (queue.empty()) {
+        return;
+    }
+
+    _stats.dropped[prio].fetch_add(queue.size(), std::memory_order_relaxed);
+    queue.clear();
+    _outbox[prio].shrink_to_fit();
+    _stats.outboxDepth[prio].store(0, std::memory_order_relaxed);
+}
+
+void MqttSettingsClass::enqueueOutbox(QueuedPublish&& item)
+{
+    // Entries per priority class. The telemetry class is sized for a few
+    // full publish intervals, everything beyond that is stale anyway.
+    static constexpr size_t limits[3] = { 8, 32, 128 };
+
+    const uint8_t prio = static_cast<uint8_t>(item.priority);
+    auto& queue = _outbox[prio];
+
+    // Per-topic shedding: a newer sample replaces a queued stale one
+    // instead of lining up behind it
+    for (auto& queued : queue) {
+        if (queued.topic == item.topic) {
+            queued.payload = std::move(item.payload);
+            queued.retain = item.retain;
+            queued.qos = item.qos;
+            queued.enqueuedAt = item.enqueuedAt;
+            _stats.coalesced[prio].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if (queue.size() >= limits[prio]) {
+        if (item.priority != PublishPriority::Telemetry) {
+            ESP_LOGW(TAG, "MQTT outbox overflow, dropping oldest message of topic '%s'", queue.front().topic.c_str());
+        }
+        queue.pop_front();
+        _stats.dropped[prio].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    queue.push_back(std::move(item));
+    _stats.outboxDepth[prio].store(queue.size(), std::memory_order_relaxed);
+}
+
+void MqttSettingsClass::drainOutbox()
+{
     if (_mqttClient == nullptr) {
+        for (uint8_t prio = 0; prio < 3; prio++) {
+            _stats.dropped[prio].fetch_add(_outbox[prio].size(), std::memory_order_relaxed);
+            _outbox[prio].clear();
+            _stats.outboxDepth[prio].store(0, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    if (!_mqttClient->connected()) {
         return;
     }
-    _mqttClient->publish(topic.c_str(), qos, retain, payload.c_str());
+
+    for (uint8_t prio = 0; prio < 3; prio++) {
+        auto& queue = _outbox[prio];
+        while (!queue.empty()) {
+            const auto& item = queue.front();
+            // length-delimited overload: binary payloads (compressed
+            // JSON) must not be cut at the first NUL byte
+            if (_mqttClient->publish(item.topic.c_str(), item.qos, item.retain,
+                    reinterpret_cast<const uint8_t*>(item.payload.c_str()), item.payload.length())
+                == 0) {
+                // Client TX buffer is full, retry on the next publish
+                _stats.deferred.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            const uint32_t latency = millis() - item.enqueuedAt;
+            size_t bucket = 0;
+            while (bucket < 5 && latency > PublishStats::latencyBucketBoundsMs[bucket]) {
+                bucket++;
+            }
+            _stats.latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            _stats.latencySumMs.fetch_add(latency, std::memory_order_relaxed);
+            _stats.latencyCount.fetch_add(1, std::memory_order_relaxed);
+            _stats.published[prio].fetch_add(1, std::memory_order_relaxed);
+
+            queue.pop_front();
+            _stats.outboxDepth[prio].store(queue.size(), std::memory_order_relaxed);
+        }
+    }
 }
 
 void MqttSettingsClass::init()
@@ -232,9 +365,49 @@ void MqttSettingsClass::init()
     using std::placeholders::_1;
     NetworkSettings.onEvent(std::bind(&MqttSettingsClass::NetworkEvent, this, _1));
 
+    _connectionSettingsCrc = connectionSettingsCrc();
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        if (scope != ConfigScope::Mqtt && scope != ConfigScope::All) {
+            return;
+        }
+
+        const uint32_t crc = connectionSettingsCrc();
+        if (crc == _connectionSettingsCrc) {
+            // Broker connection unaffected - topics, intervals and
+            // Home Assistant settings are picked up live
+            return;
+        }
+
+        _connectionSettingsCrc = crc;
+        performReconnect();
+    });
+
     createMqttClientObject();
 }
 
+uint32_t MqttSettingsClass::connectionSettingsCrc() const
+{
+    const auto& config = Configuration.get();
+    uint32_t crc = 0;
+    const auto add = [&crc](const void* data, const size_t len) {
+        crc = esp_rom_crc32_le(crc, static_cast<const uint8_t*>(data), len);
+    };
+
+    add(&config.Mqtt.Enabled, sizeof(config.Mqtt.Enabled));
+    add(config.Mqtt.Hostname, strlen(config.Mqtt.Hostname));
+    add(&config.Mqtt.Port, sizeof(config.Mqtt.Port));
+    add(config.Mqtt.ClientId, strlen(config.Mqtt.ClientId));
+    add(config.Mqtt.Username, strlen(config.Mqtt.Username));
+    add(config.Mqtt.Password, strlen(config.Mqtt.Password));
+    add(&config.Mqtt.CleanSession, sizeof(config.Mqtt.CleanSession));
+    // the configured will topic embeds the prefix
+    add(config.Mqtt.Topic, strlen(config.Mqtt.Topic));
+    add(&config.Mqtt.Lwt, sizeof(config.Mqtt.Lwt));
+    add(&config.Mqtt.Tls, sizeof(config.Mqtt.Tls));
+
+    return crc;
+}
+
 void MqttSettingsClass::createMqttClientObject()
 {
     std::lock_guard<std::mutex> lock(_clientLock);
@@ -243,11 +416,56 @@ void MqttSettingsClass::createMqttClientObject()
         _mqttClient = nullptr;
     }
     const CONFIG_T& config = Configuration.get();
+    // The object is kept across broker reconnects and only rebuilt on
+    // connection-setting changes. TLS session resumption would shave
+    // the remaining handshake off true TLS reconnects, but neither
+    // espMqttClientSecure nor the underlying WiFiClientSecure expose
+    // the mbedTLS session, so every reconnect pays a full handshake.
     if (config.Mqtt.Tls.Enabled) {
         _mqttClient = static_cast<MqttClient*>(new espMqttClientSecure);
     } else {
         _mqttClient = static_cast<MqttClient*>(new espMqttClient);
     }
+    configureMqttClientObject();
+}
+
+void MqttSettingsClass::configureMqttClientObject()
+{
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    using std::placeholders::_3;
+    using std::placeholders::_4;
+    using std::placeholders::_5;
+    using std::placeholders::_6;
+
+    const CONFIG_T& config = Configuration.get();
+    _willTopic = getPrefix() + config.Mqtt.Lwt.Topic;
+    _clientId = getClientId();
+    if (config.Mqtt.Tls.Enabled) {
+        static_cast<espMqttClientSecure*>(_mqttClient)->setCACert(config.Mqtt.Tls.RootCaCert);
+        static_cast<espMqttClientSecure*>(_mqttClient)->setServer(config.Mqtt.Hostname, config.Mqtt.Port);
+        if (config.Mqtt.Tls.CertLogin) {
+            static_cast<espMqttClientSecure*>(_mqttClient)->setCertificate(config.Mqtt.Tls.ClientCert);
+            static_cast<espMqttClientSecure*>(_mqttClient)->setPrivateKey(config.Mqtt.Tls.ClientKey);
+        } else {
+            static_cast<espMqttClientSecure*>(_mqttClient)->setCredentials(config.Mqtt.Username, config.Mqtt.Password);
+        }
+        static_cast<espMqttClientSecure*>(_mqttClient)->setWill(_willTopic.c_str(), config.Mqtt.Lwt.Qos, config.Mqtt.Retain, config.Mqtt.Lwt.Value_Offline);
+        static_cast<espMqttClientSecure*>(_mqttClient)->setClientId(_clientId.c_str());
+        static_cast<espMqttClientSecure*>(_mqttClient)->setCleanSession(config.Mqtt.CleanSession);
+        static_cast<espMqttClientSecure*>(_mqttClient)->onConnect(std::bind(&MqttSettingsClass::onMqttConnect, this, _1));
+        static_cast<espMqttClientSecure*>(_mqttClient)->onDisconnect(std::bind(&MqttSettingsClass::onMqttDisconnect, this, _1));
+        static_cast<espMqttClientSecure*>(_mqttClient)->onMessage(std::bind(&MqttSettingsClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
+    } else {
+        static_cast<espMqttClient*>(_mqttClient)->setServer(config.Mqtt.Hostname, config.Mqtt.Port);
+        static_cast<espMqttClient*>(_mqttClient)->setCredentials(config.Mqtt.Username, config.Mqtt.Password);
+        static_cast<espMqttClient*>(_mqttClient)->setWill(_willTopic.c_str(), config.Mqtt.Lwt.Qos, config.Mqtt.Retain, config.Mqtt.Lwt.Value_Offline);
+        static_cast<espMqttClient*>(_mqttClient)->setClientId(_clientId.c_str());
+        static_cast<espMqttClient*>(_mqttClient)->setCleanSession(config.Mqtt.CleanSession);
+        static_cast<espMqttClient*>(_mqttClient)->onConnect(std::bind(&MqttSettingsClass::onMqttConnect, this, _1));
+        static_cast<espMqttClient*>(_mqttClient)->onDisconnect(std::bind(&MqttSettingsClass::onMqttDisconnect, this, _1));
+        static_cast<espMqttClient*>(_mqttClient)->onMessage(std::bind(&MqttSettingsClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
+    }
 }
 
 MqttSettingsClass MqttSettings;
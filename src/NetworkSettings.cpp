@@ -4,6 +4,8 @@
  */
 #include "NetworkSettings.h"
 #include "Configuration.h"
+#include "CrashRecorder.h"
+#include "SchedulerMonitor.h"
 #include "SyslogLogger.h"
 #include "PinMapping.h"
 #include "Utils.h"
@@ -11,12 +13,14 @@
 #include "defaults.h"
 #include <ESPmDNS.h>
 #include <ETH.h>
+#include <algorithm>
 
 #undef TAG
 static const char* TAG = "network";
 
 NetworkSettingsClass::NetworkSettingsClass()
     : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&NetworkSettingsClass::loop, this))
+    , _reconnectWatchdogDelay(WIFI_RECONNECT_WATCHDOG_MIN_TIMEOUT * 1000)
     , _apIp(192, 168, 4, 1)
     , _apNetmask(255, 255, 255, 0)
     , _dnsServer(std::make_unique<DNSServer>())
@@ -56,7 +60,16 @@ void NetworkSettingsClass::init(Scheduler& scheduler)
 
     setupMode();
 
+    // The hostname lives in the WiFi scope, the responder enable in the
+    // Mdns scope; everything else leaves the announced state untouched
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        if (scope == ConfigScope::Mdns || scope == ConfigScope::Wifi || scope == ConfigScope::All) {
+            _mdnsSettingsDirty = true;
+        }
+    });
+
     scheduler.addTask(_loopTask);
+    SchedulerMonitor.instrument("network", _loopTask, std::bind(&NetworkSettingsClass::loop, this));
     _loopTask.enable();
 
     Syslog.init(scheduler);
@@ -97,6 +110,7 @@ void NetworkSettingsClass::NetworkEvent(const WiFiEvent_t event, WiFiEventInfo_t
         break;
     case ARDUINO_EVENT_WIFI_STA_CONNECTED:
         ESP_LOGI(TAG, "WiFi connected");
+        CrashRecorder.note("wifi connected");
         if (_networkMode == network_mode::WiFi) {
             raiseEvent(network_event::NETWORK_CONNECTED);
         }
@@ -104,6 +118,7 @@ void NetworkSettingsClass::NetworkEvent(const WiFiEvent_t event, WiFiEventInfo_t
     case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
         // Reason codes can be found here: https://github.com/espressif/esp-idf/blob/5454d37d496a8c58542eb450467471404c606501/components/esp_wifi/include/esp_wifi_types_generic.h#L79-L141
         ESP_LOGW(TAG, "WiFi disconnected: %" PRIu8 "", info.wifi_sta_disconnected.reason);
+        CrashRecorder.note("wifi disconnected");
         if (_networkMode == network_mode::WiFi) {
             ESP_LOGI(TAG, "Try reconnecting");
             _lastReconnectAttempt = millis();
@@ -148,14 +163,21 @@ void NetworkSettingsClass::raiseEvent(const network_event event)
 
 void NetworkSettingsClass::handleMDNS()
 {
+    if (!_mdnsSettingsDirty.exchange(false)) {
+        return;
+    }
+
     const bool mdnsEnabled = Configuration.get().Mdns.Enabled;
+    const String hostname = getHostname();
 
-    // Return if no state change
-    if (_lastMdnsEnabled == mdnsEnabled) {
+    // Return if the announced state is unchanged - restarting the
+    // responder costs a burst of goodbye/announce packets
+    if (_lastMdnsEnabled == mdnsEnabled && _lastMdnsHostname == hostname) {
         return;
     }
 
     _lastMdnsEnabled = mdnsEnabled;
+    _lastMdnsHostname = hostname;
     MDNS.end();
 
     if (!mdnsEnabled) {
@@ -256,8 +278,16 @@ void NetworkSettingsClass::loop()
                 ESP_LOGI(TAG, "Admin AP remaining seconds: %" PRIu32 " / %" PRIu32 "", _adminTimeoutCounter, _adminTimeoutCounterMax);
             }
         }
-        if (_performConnection && !isConnected() && wifiConfigured() && millis() - _lastReconnectAttempt > 60000) {
+        // The watchdog escalates: the first radio reset comes quickly
+        // (covering the common stuck-after-AP-reboot case with little
+        // added outage), later resets back off towards the old 60 s
+        // cadence to avoid hammering a genuinely absent AP.
+        if (isConnected()) {
+            _reconnectWatchdogDelay = WIFI_RECONNECT_WATCHDOG_MIN_TIMEOUT * 1000;
+        }
+        if (_performConnection && !isConnected() && wifiConfigured() && millis() - _lastReconnectAttempt > _reconnectWatchdogDelay) {
             ESP_LOGW(TAG, "Wifi reconnect watchdog triggered... Resetting Wifi hardware");
+            _reconnectWatchdogDelay = std::min<uint32_t>(_reconnectWatchdogDelay * 2, WIFI_RECONNECT_WATCHDOG_MAX_TIMEOUT * 1000);
             WiFi.disconnect(true, false);
             WiFi.mode(WIFI_MODE_NULL);
             if (_adminEnabled) {
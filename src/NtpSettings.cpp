@@ -4,17 +4,50 @@
  */
 #include "NtpSettings.h"
 #include "Configuration.h"
+#include "NetworkSettings.h"
 #include <Arduino.h>
+#include <cmath>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
 #include <time.h>
 
+// Slew compensation cadence and estimator parameters. Drift is only
+// measured between regular syncs (spacing below the overdue threshold,
+// where no slew of ours polluted the interval) and only applied while
+// a sync is overdue, i.e. during an NTP outage.
+#define NTP_DRIFT_SLEW_INTERVAL_S 60
+#define NTP_DRIFT_ALPHA 0.2f
+#define NTP_DRIFT_MAX_PPM 500.0f
+#define NTP_DRIFT_MIN_SPACING_US (60 * 1000000LL)
+#define NTP_SYNC_OVERDUE_US (2LL * 3600 * 1000000) // 2x the lwIP default update delay
+
+// Margin on top of the drift estimate for the error bound; covers
+// crystal tolerance and temperature dependence
+#define NTP_ERROR_MARGIN_PPM 20.0f
+
 NtpSettingsClass::NtpSettingsClass()
+    : _driftTask(NTP_DRIFT_SLEW_INTERVAL_S * TASK_SECOND, TASK_FOREVER, std::bind(&NtpSettingsClass::driftLoop, this))
 {
 }
 
-void NtpSettingsClass::init()
+void NtpSettingsClass::init(Scheduler& scheduler)
 {
+    sntp_set_time_sync_notification_cb(&NtpSettingsClass::timeSyncCallback);
+
     setServer();
     setTimezone();
+
+    // Kick SNTP as soon as the link is back instead of waiting out the
+    // current update interval. Runs in the network event task, the same
+    // context MqttSettings reconnects from.
+    NetworkSettings.onEvent([this](const network_event event) {
+        resync();
+    },
+        network_event::NETWORK_GOT_IP);
+
+    scheduler.addTask(_driftTask);
+    _driftTask.enable();
 }
 
 void NtpSettingsClass::setServer()
@@ -28,4 +61,86 @@ void NtpSettingsClass::setTimezone()
     tzset();
 }
 
-NtpSettingsClass NtpSettings;
\ No newline at end of file
+void NtpSettingsClass::resync()
+{
+    // a stop/start cycle makes lwIP SNTP send its request immediately
+    sntp_stop();
+    sntp_init();
+}
+
+void NtpSettingsClass::onTimeSynced(std::function<void()> listener)
+{
+    _timeSyncedListeners.push_back(std::move(listener));
+}
+
+uint32_t NtpSettingsClass::getSecondsSinceSync() const
+{
+    const int64_t lastSync = _lastSyncUptimeUs;
+    if (lastSync == 0) {
+        return 0;
+    }
+    return (esp_timer_get_time() - lastSync) / 1000000;
+}
+
+uint32_t NtpSettingsClass::getEstimatedErrorMs() const
+{
+    const float ppm = (_driftValid ? fabsf(_driftPpm) : 0) + NTP_ERROR_MARGIN_PPM;
+    return getSecondsSinceSync() * ppm / 1000.0f;
+}
+
+void NtpSettingsClass::driftLoop()
+{
+    if (!_driftValid) {
+        return;
+    }
+
+    const int64_t lastSync = _lastSyncUptimeUs;
+    if (lastSync == 0 || esp_timer_get_time() - lastSync < NTP_SYNC_OVERDUE_US) {
+        // SNTP is (still) correcting the clock itself
+        return;
+    }
+
+    // Sync is overdue: nudge the clock by the drift predicted for one
+    // slew interval so time-stamped radio commands stay within the
+    // inverters' acceptance window through a multi-day outage
+    struct timeval delta = {
+        .tv_sec = 0,
+        .tv_usec = static_cast<suseconds_t>(_driftPpm * NTP_DRIFT_SLEW_INTERVAL_S),
+    };
+    adjtime(&delta, nullptr);
+}
+
+void NtpSettingsClass::timeSyncCallback(struct timeval* tv)
+{
+    auto& self = NtpSettings;
+
+    const int64_t uptimeUs = esp_timer_get_time();
+    const int64_t anchorUs = (static_cast<int64_t>(tv->tv_sec) * 1000000 + tv->tv_usec) - uptimeUs;
+
+    const int64_t prevAnchorUs = self._lastSyncAnchorUs;
+    const int64_t prevUptimeUs = self._lastSyncUptimeUs;
+
+    if (prevUptimeUs != 0) {
+        const int64_t intervalUs = uptimeUs - prevUptimeUs;
+        // Only intervals between regular syncs are clean measurements:
+        // overdue gaps were slew-compensated by driftLoop() already
+        if (intervalUs > NTP_DRIFT_MIN_SPACING_US && intervalUs < NTP_SYNC_OVERDUE_US) {
+            // positive means the local clock runs slow
+            const float ppm = static_cast<float>(anchorUs - prevAnchorUs) / intervalUs * 1e6f;
+            if (fabsf(ppm) < NTP_DRIFT_MAX_PPM) {
+                const float prev = self._driftPpm;
+                self._driftPpm = self._driftValid ? prev + NTP_DRIFT_ALPHA * (ppm - prev) : ppm;
+                self._driftValid = true;
+            }
+        }
+    }
+
+    self._lastSyncAnchorUs = anchorUs;
+    self._lastSyncUptimeUs = uptimeUs;
+
+    for (auto& listener : self._timeSyncedListeners) {
+        listener();
+    }
+}
+
+NtpSettingsClass NtpSettings;
@@ -188,6 +188,10 @@ PinMappingClass::PinMappingClass()
 
     _pinMapping.led[0] = LED0;
     _pinMapping.led[1] = LED1;
+
+    _pinMapping.radio_profiling_tx = GPIO_NUM_NC;
+    _pinMapping.radio_profiling_rx = GPIO_NUM_NC;
+    _pinMapping.radio_profiling_fragment = GPIO_NUM_NC;
 }
 
 PinMapping_t& PinMappingClass::get()
@@ -206,6 +210,13 @@ bool PinMappingClass::init(const String& deviceMapping)
 #endif
 #endif
 
+    // The compile-time defaults for the selected environment are already
+    // baked into _pinMapping by the constructor. Only hit the filesystem
+    // and the JSON parser when a custom mapping has actually been selected.
+    if (deviceMapping.isEmpty()) {
+        return false;
+    }
+
     File f = LittleFS.open(PINMAPPING_FILENAME, "r", false);
 
     if (!f) {
@@ -271,6 +282,10 @@ bool PinMappingClass::init(const String& deviceMapping)
             _pinMapping.led[0] = doc[i]["led"]["led0"] | LED0;
             _pinMapping.led[1] = doc[i]["led"]["led1"] | LED1;
 
+            _pinMapping.radio_profiling_tx = doc[i]["radio_profiling"]["tx"] | GPIO_NUM_NC;
+            _pinMapping.radio_profiling_rx = doc[i]["radio_profiling"]["rx"] | GPIO_NUM_NC;
+            _pinMapping.radio_profiling_fragment = doc[i]["radio_profiling"]["fragment"] | GPIO_NUM_NC;
+
             return true;
         }
     }
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "ResponseSchema.h"
+#include <cstring>
+
+void serializeWithSchema(JsonObject obj, const SchemaField* fields, const size_t fieldCount, const void* data)
+{
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < fieldCount; i++) {
+        const SchemaField& field = fields[i];
+        const uint8_t* src = base + field.offset;
+
+        // memcpy instead of a cast dereference - the snapshot structs are
+        // packed by their natural layout, but the table must not rely on it
+        switch (field.type) {
+        case SchemaFieldType::UInt8: {
+            uint8_t value;
+            memcpy(&value, src, sizeof(value));
+            obj[field.key] = value;
+            break;
+        }
+        case SchemaFieldType::UInt32: {
+            uint32_t value;
+            memcpy(&value, src, sizeof(value));
+            obj[field.key] = value;
+            break;
+        }
+        case SchemaFieldType::Int8: {
+            int8_t value;
+            memcpy(&value, src, sizeof(value));
+            obj[field.key] = value;
+            break;
+        }
+        case SchemaFieldType::Float: {
+            float value;
+            memcpy(&value, src, sizeof(value));
+            obj[field.key] = value;
+            break;
+        }
+        case SchemaFieldType::Bool: {
+            bool value;
+            memcpy(&value, src, sizeof(value));
+            obj[field.key] = value;
+            break;
+        }
+        }
+    }
+}
@@ -3,7 +3,9 @@
  * Copyright (C) 2024 Thomas Basler and others
  */
 #include "RestartHelper.h"
+#include "Configuration.h"
 #include "Display_Graphic.h"
+#include "EnergyLedger.h"
 #include "Led_Single.h"
 #include <Esp.h>
 
@@ -31,6 +33,10 @@ void RestartHelperClass::loop()
         LedSingle.turnAllOff();
         Display.setStatus(false);
     } else {
+        // A write-behind config save must not be lost over the reboot
+        Configuration.flushPendingWrites();
+        // Energy below the commit threshold would otherwise be lost
+        EnergyLedger.commitAll();
         ESP.restart();
     }
 }
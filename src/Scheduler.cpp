@@ -3,5 +3,58 @@
  * Copyright (C) 2023 Thomas Basler and others
  */
 #include "Scheduler.h"
+#include "SchedulerMonitor.h"
+#include <Arduino.h>
 
-Scheduler scheduler;
\ No newline at end of file
+Scheduler scheduler;
+
+ChunkedWork::ChunkedWork()
+    : _task(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&ChunkedWork::loop, this))
+{
+}
+
+void ChunkedWork::init(Scheduler& scheduler, const char* name, const uint32_t budgetUs)
+{
+    _budgetUs = budgetUs;
+    scheduler.addTask(_task);
+    // A single step may overshoot the budget; only invocations blowing
+    // twice of it count as overruns in the monitor
+    SchedulerMonitor.instrument(name, _task, std::bind(&ChunkedWork::loop, this), budgetUs * 2);
+}
+
+void ChunkedWork::start(std::function<bool()> step)
+{
+    _step = std::move(step);
+    _task.enable();
+}
+
+void ChunkedWork::cancel()
+{
+    _step = nullptr;
+    _task.disable();
+}
+
+bool ChunkedWork::busy() const
+{
+    return _step != nullptr;
+}
+
+void ChunkedWork::loop()
+{
+    const uint32_t start = micros();
+
+    while (_step != nullptr) {
+        if (!_step()) {
+            _step = nullptr;
+            _task.disable();
+            return;
+        }
+        if (micros() - start >= _budgetUs) {
+            // Budget spent - the remaining steps run on the next pass
+            _task.forceNextIteration();
+            return;
+        }
+    }
+
+    _task.disable();
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "SchedulerMonitor.h"
+#include <Arduino.h>
+
+#undef TAG
+static const char* TAG = "scheduler";
+
+// Cadence of the worst-offender report
+#define SCHEDULER_MONITOR_REPORT_INTERVAL 60 * TASK_SECOND
+
+SchedulerMonitorClass SchedulerMonitor;
+
+SchedulerMonitorClass::SchedulerMonitorClass()
+    : _reportTask(SCHEDULER_MONITOR_REPORT_INTERVAL, TASK_FOREVER, std::bind(&SchedulerMonitorClass::reportLoop, this))
+{
+}
+
+void SchedulerMonitorClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_reportTask);
+    _reportTask.enable();
+}
+
+void SchedulerMonitorClass::instrument(const char* name, Task& task, std::function<void()> callback, const uint32_t budgetUs)
+{
+    if (_slotCount >= SCHEDULER_MONITOR_SLOT_COUNT) {
+        ESP_LOGW(TAG, "No free slot for task %s", name);
+        return;
+    }
+
+    Slot& slot = _slots[_slotCount++];
+    slot.name = name;
+    slot.budgetUs = budgetUs;
+
+    task.setCallback([&slot, callback = std::move(callback)]() {
+        const uint32_t startUs = micros();
+        callback();
+        const uint32_t runUs = micros() - startUs;
+
+        slot.runs.fetch_add(1, std::memory_order_relaxed);
+        slot.totalUs.fetch_add(runUs, std::memory_order_relaxed);
+        if (runUs > slot.maxUs.load(std::memory_order_relaxed)) {
+            slot.maxUs.store(runUs, std::memory_order_relaxed);
+        }
+        if (runUs > slot.windowMaxUs) {
+            slot.windowMaxUs = runUs;
+        }
+        if (runUs > slot.budgetUs) {
+            slot.overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+}
+
+void SchedulerMonitorClass::loopTick()
+{
+    const uint32_t now = micros();
+    if (_lastTickUs == 0) {
+        _lastTickUs = now;
+        return;
+    }
+
+    const uint32_t gapUs = now - _lastTickUs;
+    _lastTickUs = now;
+
+    if (gapUs > _loopMaxGapUs.load(std::memory_order_relaxed)) {
+        _loopMaxGapUs.store(gapUs, std::memory_order_relaxed);
+    }
+    if (gapUs > _windowMaxGapUs) {
+        _windowMaxGapUs = gapUs;
+    }
+
+    if (gapUs > SCHEDULER_MONITOR_STALL_BUDGET_US) {
+        _loopStalls.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGE(TAG, "Scheduler stalled for %" PRIu32 " ms (budget %d ms)",
+            gapUs / 1000, SCHEDULER_MONITOR_STALL_BUDGET_US / 1000);
+    }
+}
+
+void SchedulerMonitorClass::reportLoop()
+{
+    // Runs on the main loop task, like the wrapped callbacks, so the
+    // window bookkeeping needs no synchronization
+    Slot* worst = nullptr;
+    for (size_t i = 0; i < _slotCount; i++) {
+        if (worst == nullptr || _slots[i].windowMaxUs > worst->windowMaxUs) {
+            worst = &_slots[i];
+        }
+    }
+
+    if (worst != nullptr && worst->windowMaxUs > worst->budgetUs) {
+        ESP_LOGW(TAG, "Worst offender: %s held the loop for %" PRIu32 " ms (budget %" PRIu32 " ms)",
+            worst->name, worst->windowMaxUs / 1000, worst->budgetUs / 1000);
+    }
+
+    for (size_t i = 0; i < _slotCount; i++) {
+        _slots[i].windowMaxUs = 0;
+    }
+    _windowMaxGapUs = 0;
+}
+
+void SchedulerMonitorClass::serialize(JsonObject root)
+{
+    root["budget_us"] = SCHEDULER_MONITOR_BUDGET_US;
+
+    JsonObject loop = root["loop"].to<JsonObject>();
+    loop["stall_budget_us"] = SCHEDULER_MONITOR_STALL_BUDGET_US;
+    loop["stalls"] = _loopStalls.load(std::memory_order_relaxed);
+    loop["max_gap_us"] = _loopMaxGapUs.load(std::memory_order_relaxed);
+    loop["window_max_gap_us"] = _windowMaxGapUs;
+
+    JsonArray tasks = root["tasks"].to<JsonArray>();
+    for (size_t i = 0; i < _slotCount; i++) {
+        const Slot& slot = _slots[i];
+        const uint32_t runs = slot.runs.load(std::memory_order_relaxed);
+
+        JsonObject task = tasks.add<JsonObject>();
+        task["name"] = slot.name;
+        task["budget_us"] = slot.budgetUs;
+        task["runs"] = runs;
+        task["overruns"] = slot.overruns.load(std::memory_order_relaxed);
+        task["max_us"] = slot.maxUs.load(std::memory_order_relaxed);
+        task["avg_us"] = runs > 0
+            ? static_cast<uint32_t>(slot.totalUs.load(std::memory_order_relaxed) / runs)
+            : 0;
+    }
+}
@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "SoakLog.h"
+#include "MqttSettings.h"
+#include <Arduino.h>
+#include <Hoymiles.h>
+#include <LittleFS.h>
+#include <cstring>
+#include <ctime>
+
+#undef TAG
+static const char* TAG = "soaklog";
+
+static constexpr uint32_t soakLogMagic = 0x4C53444F; // "ODSL"
+static constexpr uint32_t soakLogVersion = 1;
+
+SoakLogClass SoakLog;
+
+SoakLogClass::SoakLogClass()
+    : _sampleTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&SoakLogClass::sampleLoop, this))
+    , _flushTask(SOAKLOG_FLUSH_INTERVAL, TASK_FOREVER, std::bind(&SoakLogClass::flushLoop, this))
+{
+}
+
+void SoakLogClass::init(Scheduler& scheduler)
+{
+#if SOAKLOG_ENABLE
+    scheduler.addTask(_sampleTask);
+    scheduler.addTask(_flushTask);
+
+    // A soak run survives reboots: if a valid log file exists, resume
+    // appending to it so a week-long capture is not lost to a crash
+    File f = LittleFS.open(SOAKLOG_FILENAME, "r");
+    if (!f) {
+        return;
+    }
+
+    SoakLogHeader header;
+    const bool valid = f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && header.magic == soakLogMagic
+        && header.version == soakLogVersion
+        && header.recordSize == sizeof(SoakLogRecord)
+        && header.capacity == SOAKLOG_RECORD_COUNT;
+
+    if (valid && header.sequence > 0) {
+        // The boot counter continues from the last record written
+        SoakLogRecord last;
+        f.seek(sizeof(header) + ((header.sequence - 1) % SOAKLOG_RECORD_COUNT) * sizeof(last));
+        if (f.read(reinterpret_cast<uint8_t*>(&last), sizeof(last)) == sizeof(last)) {
+            _bootCount = last.bootCount + 1;
+        }
+    }
+    f.close();
+
+    if (!valid) {
+        ESP_LOGW(TAG, "Stale soak log discarded");
+        LittleFS.remove(SOAKLOG_FILENAME);
+        return;
+    }
+
+    _sequence = header.sequence;
+    _running = true;
+    _lastSampleUs = micros();
+    _sampleTask.enable();
+    _flushTask.enable();
+    ESP_LOGI(TAG, "Soak run resumed at record %" PRIu32, _sequence);
+#endif
+}
+
+bool SoakLogClass::start()
+{
+#if SOAKLOG_ENABLE
+    if (_running) {
+        return true;
+    }
+
+    _sequence = 0;
+    _bootCount = 0;
+    if (!writeHeader()) {
+        return false;
+    }
+
+    // Prime the delta baselines so the first record only covers its
+    // own hour instead of everything since boot
+    _lastRadioTxRequests = 0;
+    _lastRadioRxSuccess = 0;
+    _lastRadioRxFailures = 0;
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        _lastRadioTxRequests += inv->RadioStats.TxRequestData;
+        _lastRadioRxSuccess += inv->RadioStats.RxSuccess;
+        _lastRadioRxFailures += inv->RadioStats.RxFailPartialAnswer
+            + inv->RadioStats.RxFailNoAnswer + inv->RadioStats.RxFailCorruptData;
+    }
+
+    auto& mqtt = MqttSettings.getPublishStats();
+    _lastMqttPublished = 0;
+    _lastMqttDropped = 0;
+    for (size_t prio = 0; prio < 3; prio++) {
+        _lastMqttPublished += mqtt.published[prio].load(std::memory_order_relaxed);
+        _lastMqttDropped += mqtt.dropped[prio].load(std::memory_order_relaxed);
+    }
+
+    _loopIterations = 0;
+    _loopMaxUs = 0;
+    memset(_loopBins, 0, sizeof(_loopBins));
+
+    _running = true;
+    _lastSampleUs = micros();
+    _sampleTask.enable();
+    _flushTask.enableDelayed(SOAKLOG_FLUSH_INTERVAL);
+    ESP_LOGI(TAG, "Soak run started");
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SoakLogClass::stop()
+{
+    _sampleTask.disable();
+    _flushTask.disable();
+    _running = false;
+    ESP_LOGI(TAG, "Soak run stopped after %" PRIu32 " records", _sequence);
+}
+
+// Runs on every scheduler pass while soaking; the pass-to-pass gap is
+// the latency every other task sees. One micros() read and a bin
+// increment, cheap enough to leave on for a week.
+void SoakLogClass::sampleLoop()
+{
+    const uint32_t now = micros();
+    const uint32_t deltaUs = now - _lastSampleUs;
+    _lastSampleUs = now;
+
+    _loopIterations++;
+    if (deltaUs > _loopMaxUs) {
+        _loopMaxUs = deltaUs;
+    }
+
+    uint8_t bin = 0;
+    uint32_t scaled = deltaUs >> 5;
+    while (scaled != 0 && bin < SOAKLOG_LOOP_BIN_COUNT - 1) {
+        scaled >>= 1;
+        bin++;
+    }
+    _loopBins[bin]++;
+}
+
+void SoakLogClass::flushLoop()
+{
+    SoakLogRecord record = {};
+
+    const time_t now = time(nullptr);
+    record.timestamp = now > 1577836800 /* 2020-01-01 */ ? static_cast<uint32_t>(now) : 0;
+    record.uptimeSeconds = millis() / 1000;
+    record.freeHeap = ESP.getFreeHeap();
+    record.minFreeHeap = ESP.getMinFreeHeap();
+    record.maxAllocHeap = ESP.getMaxAllocHeap();
+    record.heapFragmentationPercent = record.freeHeap > 0
+        ? 100 - (record.maxAllocHeap * 100) / record.freeHeap
+        : 0;
+    record.inverterCount = Hoymiles.getNumInverters();
+    record.bootCount = _bootCount;
+
+    record.loopIterations = _loopIterations;
+    record.loopMaxUs = _loopMaxUs;
+
+    // p99 as the upper bound of the first bin covering 99% of passes
+    uint64_t cumulative = 0;
+    for (uint8_t bin = 0; bin < SOAKLOG_LOOP_BIN_COUNT; bin++) {
+        cumulative += _loopBins[bin];
+        if (cumulative * 100 >= static_cast<uint64_t>(_loopIterations) * 99) {
+            record.loopP99Us = 1UL << (bin + 5);
+            break;
+        }
+    }
+
+    _loopIterations = 0;
+    _loopMaxUs = 0;
+    memset(_loopBins, 0, sizeof(_loopBins));
+
+    uint32_t txRequests = 0;
+    uint32_t rxSuccess = 0;
+    uint32_t rxFailures = 0;
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        txRequests += inv->RadioStats.TxRequestData;
+        rxSuccess += inv->RadioStats.RxSuccess;
+        rxFailures += inv->RadioStats.RxFailPartialAnswer
+            + inv->RadioStats.RxFailNoAnswer + inv->RadioStats.RxFailCorruptData;
+    }
+
+    // Totals shrink when an inverter is deleted mid-hour; restart the
+    // baseline instead of producing a huge bogus delta
+    record.radioTxRequests = txRequests >= _lastRadioTxRequests ? txRequests - _lastRadioTxRequests : txRequests;
+    record.radioRxSuccess = rxSuccess >= _lastRadioRxSuccess ? rxSuccess - _lastRadioRxSuccess : rxSuccess;
+    record.radioRxFailures = rxFailures >= _lastRadioRxFailures ? rxFailures - _lastRadioRxFailures : rxFailures;
+    _lastRadioTxRequests = txRequests;
+    _lastRadioRxSuccess = rxSuccess;
+    _lastRadioRxFailures = rxFailures;
+
+    auto& mqtt = MqttSettings.getPublishStats();
+    uint32_t published = 0;
+    uint32_t dropped = 0;
+    for (size_t prio = 0; prio < 3; prio++) {
+        published += mqtt.published[prio].load(std::memory_order_relaxed);
+        dropped += mqtt.dropped[prio].load(std::memory_order_relaxed);
+    }
+    record.mqttPublished = published - _lastMqttPublished;
+    record.mqttDropped = dropped - _lastMqttDropped;
+    _lastMqttPublished = published;
+    _lastMqttDropped = dropped;
+
+    File f = LittleFS.open(SOAKLOG_FILENAME, "r+");
+    if (!f) {
+        ESP_LOGE(TAG, "Soak log file lost, stopping soak run");
+        stop();
+        return;
+    }
+
+    f.seek(sizeof(SoakLogHeader) + (_sequence % SOAKLOG_RECORD_COUNT) * sizeof(record));
+    f.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    f.close();
+
+    _sequence++;
+    writeHeader();
+}
+
+bool SoakLogClass::writeHeader()
+{
+    SoakLogHeader header;
+    header.magic = soakLogMagic;
+    header.version = soakLogVersion;
+    header.recordSize = sizeof(SoakLogRecord);
+    header.capacity = SOAKLOG_RECORD_COUNT;
+    header.sequence = _sequence;
+
+    File f = LittleFS.open(SOAKLOG_FILENAME, _sequence == 0 ? "w" : "r+");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open " SOAKLOG_FILENAME);
+        return false;
+    }
+    f.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    f.close();
+    return true;
+}
@@ -4,6 +4,7 @@
  */
 #include "SunPosition.h"
 #include "Configuration.h"
+#include "SchedulerMonitor.h"
 #include "Utils.h"
 #include <Arduino.h>
 
@@ -19,7 +20,8 @@ SunPositionClass::SunPositionClass()
 void SunPositionClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.enable();
+    SchedulerMonitor.instrument("sunposition", _loopTask, std::bind(&SunPositionClass::loop, this));
+    Utils::enableStaggered(_loopTask);
 }
 
 void SunPositionClass::loop()
@@ -27,6 +29,23 @@ void SunPositionClass::loop()
     if (_doRecalc || checkRecalcDayChanged()) {
         updateSunData();
     }
+
+    const bool isDay = isDayPeriod();
+    if (!_lastIsDayValid) {
+        // no transition on the very first evaluation after boot
+        _lastIsDay = isDay;
+        _lastIsDayValid = true;
+    } else if (isDay != _lastIsDay) {
+        _lastIsDay = isDay;
+        for (auto& listener : _dayPeriodListeners) {
+            listener(isDay);
+        }
+    }
+}
+
+void SunPositionClass::onDayPeriodChanged(std::function<void(const bool isDay)> listener)
+{
+    _dayPeriodListeners.push_back(std::move(listener));
 }
 
 bool SunPositionClass::isDayPeriod() const
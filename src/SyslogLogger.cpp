@@ -22,8 +22,9 @@ void SyslogLogger::init(Scheduler& scheduler)
     // PROCID change indicates a restart.
     _proc_id = String(esp_random(), HEX);
 
+    // The task only runs while the logger is enabled; with syslog off
+    // it occupies no scheduler slot (enable()/disable() drive it)
     scheduler.addTask(_loopTask);
-    _loopTask.enable();
 }
 
 void SyslogLogger::updateSettings(const String&& hostname)
@@ -60,37 +61,57 @@ void SyslogLogger::updateSettings(const String&& hostname)
 
 void SyslogLogger::write(const uint8_t* buffer, size_t size)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (!_enabled || !isResolved()) {
+    // fast path: with syslog off every log line returns here without
+    // touching the mutex
+    if (!_enabled) {
         return;
     }
 
-    String header = "<";
-    header += String(calculatePrival(1, buffer[0]));
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_enabled) {
+        return;
+    }
 
-    _udp.beginPacket(_address, _port);
-    _udp.print(header);
-    _udp.print(_header);
+    // Only format and queue here - never any UDP I/O, so the caller is
+    // never stalled by a congested WiFi link. Lines queued before the
+    // hostname is resolved are delivered once resolution succeeds.
+    String message = "<";
+    message += String(calculatePrival(1, buffer[0]));
+    message += _header;
 
-    for (int i = 0; i < size; i++) {
+    message.reserve(message.length() + size);
+    for (size_t i = 0; i < size; i++) {
         uint8_t c = buffer[i];
         if (c != '\r' && c != '\n') {
             // Replace control and non-ASCII characters with '?'.
-            _udp.write(c >= 0x20 && c < 0x7f ? c : '?');
+            message += static_cast<char>(c >= 0x20 && c < 0x7f ? c : '?');
         }
     }
-    _udp.endPacket();
+
+    if (_queueBytes + message.length() > QUEUE_MAX_BYTES) {
+        _droppedLines++;
+        _droppedPending++;
+        return;
+    }
+
+    _queueBytes += message.length();
+    _queue.emplace_back(std::move(message));
 }
 
 void SyslogLogger::disable()
 {
     ESP_LOGI(TAG, "Disable");
+    _loopTask.disable();
     std::lock_guard<std::mutex> lock(_mutex);
     if (_enabled) {
         _enabled = false;
         _address = INADDR_NONE;
         _udp.stop();
     }
+    _queue.clear();
+    _queueBytes = 0;
+    _droppedLines = 0;
+    _droppedPending = 0;
 }
 
 void SyslogLogger::enable()
@@ -101,8 +122,11 @@ void SyslogLogger::enable()
         return;
     }
 
-    std::lock_guard<std::mutex> lock(_mutex);
-    _enabled = true;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _enabled = true;
+    }
+    _loopTask.enable();
 }
 
 bool SyslogLogger::resolveAndStart()
@@ -142,12 +166,60 @@ uint8_t SyslogLogger::calculatePrival(uint8_t facility, char errorCode)
 
 void SyslogLogger::loop()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    if (!_enabled || !NetworkSettings.isConnected() || isResolved()) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_enabled) {
         return;
     }
-    if (!resolveAndStart()) {
-        _enabled = false;
+
+    if (!isResolved()) {
+        if (!NetworkSettings.isConnected()) {
+            return;
+        }
+        if (!resolveAndStart()) {
+            // dead until the next settings change re-enables the task
+            _enabled = false;
+            _loopTask.disable();
+        }
+        return;
+    }
+
+    // Coalesce queued lines into MTU-sized datagrams, newline-separated
+    // (RFC6587 non-transparent framing). A limited number of batches
+    // per pass drains bursts quickly without monopolizing the main loop.
+    for (uint8_t batch_count = 0; batch_count < MAX_BATCHES_PER_LOOP && !_queue.empty(); batch_count++) {
+        String batch = std::move(_queue.front());
+        _queue.pop_front();
+        _queueBytes -= batch.length();
+
+        while (!_queue.empty() && batch.length() + 1 + _queue.front().length() <= BATCH_SIZE_BYTES) {
+            _queueBytes -= _queue.front().length();
+            batch += '\n';
+            batch += _queue.front();
+            _queue.pop_front();
+        }
+
+        if (_droppedPending > 0) {
+            batch += '\n';
+            batch += "<";
+            batch += String(calculatePrival(1, 'W'));
+            batch += _header;
+            batch += "syslog: ";
+            batch += String(_droppedPending);
+            batch += " lines dropped (queue full)";
+            _droppedPending = 0;
+        }
+
+        // Send without holding the lock so writers are never blocked by
+        // the network
+        lock.unlock();
+        _udp.beginPacket(_address, _port);
+        _udp.print(batch);
+        _udp.endPacket();
+        lock.lock();
+
+        if (!_enabled || !isResolved()) {
+            return; // reconfigured while the lock was released
+        }
     }
 }
 
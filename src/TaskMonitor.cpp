@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "TaskMonitor.h"
+#include "Utils.h"
+#include <Arduino.h>
+#include <array>
+#include <string.h>
+#include <vector>
+
+TaskMonitorClass TaskMonitor;
+
+static hw_timer_t* sampleTimerHandle = nullptr;
+
+void TaskMonitorClass::sampleTimer()
+{
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const TaskHandle_t task = xTaskGetCurrentTaskHandleForCPU(core);
+
+        uint8_t slotIdx = 0xFF;
+        for (size_t s = 0; s < TASK_MONITOR_SLOT_COUNT; s++) {
+            SampleSlot& slot = TaskMonitor._slots[s];
+            TaskHandle_t current = slot.handle.load(std::memory_order_relaxed);
+            if (current == nullptr) {
+                if (!slot.handle.compare_exchange_strong(current, task, std::memory_order_relaxed)) {
+                    if (current != task) {
+                        continue;
+                    }
+                }
+                current = task;
+            }
+            if (current == task) {
+                slot.samples.fetch_add(1, std::memory_order_relaxed);
+                slotIdx = s;
+                break;
+            }
+        }
+
+        TaskMonitor._totalSamples.fetch_add(1, std::memory_order_relaxed);
+
+        if (TaskMonitor._traceActive.load(std::memory_order_relaxed)) {
+            const uint32_t pos = TaskMonitor._traceWriteIdx.fetch_add(1, std::memory_order_relaxed);
+            if (pos < TASK_MONITOR_TRACE_BYTES) {
+                TaskMonitor._traceBuffer[pos] = slotIdx;
+            } else {
+                // Buffer full, the capture ends itself
+                TaskMonitor._traceActive.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void TaskMonitorClass::init()
+{
+    // 80 MHz APB clock / 80 -> 1 us timer ticks. the arduino timer
+    // driver dispatches the callback from a non-IRAM interrupt, so
+    // sampling simply pauses while the flash cache is disabled (e.g.
+    // during config writes) instead of crashing.
+    sampleTimerHandle = timerBegin(3, 80, true);
+    timerAttachInterrupt(sampleTimerHandle, &TaskMonitorClass::sampleTimer, true);
+    timerAlarmWrite(sampleTimerHandle, TASK_MONITOR_SAMPLE_INTERVAL_US, true);
+    timerAlarmEnable(sampleTimerHandle);
+}
+
+size_t TaskMonitorClass::collect(TaskStats* stats, size_t maxCount, bool updateBaseline)
+{
+    size_t count = 0;
+    bool slotSeen[TASK_MONITOR_SLOT_COUNT] = {};
+
+#if configUSE_TRACE_FACILITY
+    const UBaseType_t numberOfTasks = uxTaskGetNumberOfTasks();
+    std::vector<TaskStatus_t> statuses(numberOfTasks + 4); // tasks may spawn meanwhile
+    const UBaseType_t taskCount = uxTaskGetSystemState(statuses.data(), statuses.size(), nullptr);
+
+    static constexpr char stateNames[] = { 'X', 'R', 'B', 'S', 'D', 'I' };
+
+    for (UBaseType_t i = 0; i < taskCount && count < maxCount; i++) {
+        const TaskStatus_t& status = statuses[i];
+        TaskStats& entry = stats[count++];
+        strlcpy(entry.name, status.pcTaskName, sizeof(entry.name));
+        entry.samples = 0;
+        entry.samplesDelta = 0;
+        entry.stackWatermark = status.usStackHighWaterMark;
+        entry.priority = status.uxCurrentPriority;
+        entry.state = status.eCurrentState <= eInvalid ? stateNames[status.eCurrentState] : '?';
+        entry.live = true;
+
+        for (size_t s = 0; s < TASK_MONITOR_SLOT_COUNT; s++) {
+            if (_slots[s].handle.load(std::memory_order_relaxed) == status.xHandle) {
+                entry.samples = _slots[s].samples.load(std::memory_order_relaxed);
+                entry.samplesDelta = entry.samples - _slotBaseline[s];
+                if (updateBaseline) {
+                    _slotBaseline[s] = entry.samples;
+                }
+                slotSeen[s] = true;
+                break;
+            }
+        }
+    }
+#else
+    // without the trace facility only well-known task names can be
+    // resolved safely (a sampled handle may belong to an exited task)
+    static std::array<char const*, 12> constexpr task_names = {
+        "IDLE0", "IDLE1", "wifi", "tiT", "loopTask", "async_tcp", "mqttclient",
+        "HUAWEI_CAN_0", "PM:SDM", "PM:HTTP+JSON", "PM:SML", "PM:HTTP+SML"
+    };
+
+    for (char const* task_name : task_names) {
+        if (count >= maxCount) {
+            break;
+        }
+        TaskHandle_t const handle = xTaskGetHandle(task_name);
+        if (!handle) {
+            continue;
+        }
+        TaskStats& entry = stats[count++];
+        strlcpy(entry.name, task_name, sizeof(entry.name));
+        entry.samples = 0;
+        entry.samplesDelta = 0;
+        entry.stackWatermark = uxTaskGetStackHighWaterMark(handle);
+        entry.priority = uxTaskPriorityGet(handle);
+        entry.state = '?';
+        entry.live = true;
+
+        for (size_t s = 0; s < TASK_MONITOR_SLOT_COUNT; s++) {
+            if (_slots[s].handle.load(std::memory_order_relaxed) == handle) {
+                entry.samples = _slots[s].samples.load(std::memory_order_relaxed);
+                entry.samplesDelta = entry.samples - _slotBaseline[s];
+                if (updateBaseline) {
+                    _slotBaseline[s] = entry.samples;
+                }
+                slotSeen[s] = true;
+                break;
+            }
+        }
+    }
+#endif
+
+    // samples attributed to tasks that no longer exist (or, without the
+    // trace facility, could not be resolved) are reported aggregated
+    uint32_t exitedSamples = 0;
+    uint32_t exitedDelta = 0;
+    for (size_t s = 0; s < TASK_MONITOR_SLOT_COUNT; s++) {
+        if (slotSeen[s] || _slots[s].handle.load(std::memory_order_relaxed) == nullptr) {
+            continue;
+        }
+        const uint32_t samples = _slots[s].samples.load(std::memory_order_relaxed);
+        exitedSamples += samples;
+        exitedDelta += samples - _slotBaseline[s];
+        if (updateBaseline) {
+            _slotBaseline[s] = samples;
+        }
+    }
+
+    if (exitedSamples > 0 && count < maxCount) {
+        TaskStats& entry = stats[count++];
+        strlcpy(entry.name, "exited", sizeof(entry.name));
+        entry.samples = exitedSamples;
+        entry.samplesDelta = exitedDelta;
+        entry.stackWatermark = 0;
+        entry.priority = 0;
+        entry.state = 'D';
+        entry.live = false;
+    }
+
+    return count;
+}
+
+void TaskMonitorClass::serialize(JsonObject root)
+{
+    TaskStats stats[TASK_MONITOR_SLOT_COUNT + 8];
+
+    const uint32_t total = getTotalSamples();
+    const uint32_t totalDelta = total - _totalBaseline;
+    _totalBaseline = total;
+
+    const size_t count = collect(stats, sizeof(stats) / sizeof(stats[0]), true);
+
+    root["sample_interval_us"] = TASK_MONITOR_SAMPLE_INTERVAL_US;
+    root["total_samples"] = total;
+
+    JsonArray tasks = root["tasks"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+        const TaskStats& entry = stats[i];
+        JsonObject task = tasks.add<JsonObject>();
+        task["name"] = entry.name;
+        task["state"] = String(entry.state);
+        task["priority"] = entry.priority;
+        task["stack_watermark"] = entry.stackWatermark;
+        task["cpu_samples"] = entry.samples;
+        task["cpu_percent"] = totalDelta > 0
+            ? static_cast<float>(100.0 * entry.samplesDelta / totalDelta)
+            : 0.0f;
+    }
+}
+
+bool TaskMonitorClass::startTrace()
+{
+    if (_traceBuffer == nullptr) {
+        _traceBuffer = static_cast<uint8_t*>(Utils::allocBulk(TASK_MONITOR_TRACE_BYTES));
+        if (_traceBuffer == nullptr) {
+            return false;
+        }
+    }
+
+    // Restarting simply overwrites the previous capture
+    _traceActive.store(false, std::memory_order_relaxed);
+    _traceWriteIdx.store(0, std::memory_order_relaxed);
+    _traceActive.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t TaskMonitorClass::getTraceBytes() const
+{
+    const uint32_t written = _traceWriteIdx.load(std::memory_order_relaxed);
+    return written < TASK_MONITOR_TRACE_BYTES ? written : TASK_MONITOR_TRACE_BYTES;
+}
+
+void TaskMonitorClass::getSlotTaskName(const size_t slot, char* name, const size_t len) const
+{
+    name[0] = '\0';
+    if (slot >= TASK_MONITOR_SLOT_COUNT) {
+        return;
+    }
+
+    const TaskHandle_t handle = _slots[slot].handle.load(std::memory_order_relaxed);
+    if (handle == nullptr) {
+        return;
+    }
+
+    // Only resolve handles of tasks that still exist; a stale handle
+    // of an exited task must not be dereferenced
+#if configUSE_TRACE_FACILITY
+    const UBaseType_t numberOfTasks = uxTaskGetNumberOfTasks();
+    std::vector<TaskStatus_t> statuses(numberOfTasks + 4);
+    const UBaseType_t taskCount = uxTaskGetSystemState(statuses.data(), statuses.size(), nullptr);
+    for (UBaseType_t i = 0; i < taskCount; i++) {
+        if (statuses[i].xHandle == handle) {
+            strlcpy(name, statuses[i].pcTaskName, len);
+            return;
+        }
+    }
+#else
+    static std::array<char const*, 12> constexpr task_names = {
+        "IDLE0", "IDLE1", "wifi", "tiT", "loopTask", "async_tcp", "mqttclient",
+        "HUAWEI_CAN_0", "PM:SDM", "PM:HTTP+JSON", "PM:SML", "PM:HTTP+SML"
+    };
+    for (char const* task_name : task_names) {
+        if (xTaskGetHandle(task_name) == handle) {
+            strlcpy(name, task_name, len);
+            return;
+        }
+    }
+#endif
+
+    strlcpy(name, "exited", len);
+}
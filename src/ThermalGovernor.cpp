@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "ThermalGovernor.h"
+#include "CrashRecorder.h"
+#include <CpuTemperature.h>
+#include <algorithm>
+#include <cmath>
+
+#undef TAG
+static const char* TAG = "thermal";
+
+#define SAMPLE_INTERVAL_MS 10000
+
+// smoothing factors for the temperature and trend estimates; the trend
+// is the noisier signal and gets the heavier filter
+#define TEMPERATURE_ALPHA 0.3f
+#define TREND_ALPHA 0.1f
+
+ThermalGovernorClass ThermalGovernor;
+
+ThermalGovernorClass::ThermalGovernorClass()
+    : _loopTask(SAMPLE_INTERVAL_MS * TASK_MILLISECOND, TASK_FOREVER, std::bind(&ThermalGovernorClass::loop, this))
+{
+}
+
+void ThermalGovernorClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+}
+
+void ThermalGovernorClass::registerThrottle(const char* name, std::function<void(const bool active)> apply)
+{
+    _throttles.push_back({ name, std::move(apply) });
+}
+
+void ThermalGovernorClass::loop()
+{
+    const float celsius = CpuTemperature.read();
+    if (std::isnan(celsius)) {
+        return;
+    }
+
+    if (!_haveSample) {
+        _filteredCelsius = celsius;
+        _lastCelsius = celsius;
+        _haveSample = true;
+        return;
+    }
+
+    _filteredCelsius += TEMPERATURE_ALPHA * (celsius - _filteredCelsius);
+
+    const float deltaPerMinute = (celsius - _lastCelsius) * (60000.0f / SAMPLE_INTERVAL_MS);
+    _trendCelsiusPerMinute += TREND_ALPHA * (deltaPerMinute - _trendCelsiusPerMinute);
+    _lastCelsius = celsius;
+
+    // engage on where we will be in a minute, not where we are; a
+    // falling trend must not keep us engaged below the clear level
+    const float predicted = _filteredCelsius + std::max(0.0f, _trendCelsiusPerMinute);
+
+    if (!_throttling && predicted >= THERMAL_GOVERNOR_HOT_CELSIUS) {
+        _throttling = true;
+        _activations++;
+        ESP_LOGW(TAG, "Die at %.1f C (trend %+.1f C/min), shedding optional load", _filteredCelsius, _trendCelsiusPerMinute);
+        CrashRecorder.note("thermal throttle engaged");
+        for (auto& throttle : _throttles) {
+            throttle.apply(true);
+        }
+    } else if (_throttling && predicted <= THERMAL_GOVERNOR_CLEAR_CELSIUS) {
+        _throttling = false;
+        ESP_LOGI(TAG, "Die back at %.1f C, restoring optional load", _filteredCelsius);
+        CrashRecorder.note("thermal throttle released");
+        for (auto& throttle : _throttles) {
+            throttle.apply(false);
+        }
+    }
+}
+
+void ThermalGovernorClass::serialize(JsonObject obj) const
+{
+    obj["temperature"] = _filteredCelsius;
+    obj["trend_per_minute"] = _trendCelsiusPerMinute;
+    obj["headroom"] = getHeadroomCelsius();
+    obj["throttling"] = _throttling;
+    obj["activations"] = _activations;
+}
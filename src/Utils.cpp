@@ -4,9 +4,14 @@
  */
 
 #include "Utils.h"
+#include "JsonArena.h"
 #include "PinMapping.h"
 #include <LittleFS.h>
 #include <MD5Builder.h>
+#include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <esp_heap_caps.h>
+#include <map>
 
 #undef TAG
 static const char* TAG = "utils";
@@ -71,6 +76,31 @@ bool Utils::checkJsonAlloc(const JsonDocument& doc, const char* function, const
 }
 
 /// @brief Remove all files but the PINMAPPING_FILENAME
+void Utils::enableStaggered(Task& task)
+{
+    // Counts enables per period: the n-th task of a period lands on
+    // the n-th step of a golden-ratio sequence, so offsets stay spread
+    // out evenly no matter how many tasks of that period follow later
+    static std::map<unsigned long, uint32_t> phaseCounters;
+
+    const unsigned long period = task.getInterval();
+    if (period == 0) {
+        task.enable();
+        return;
+    }
+
+    const uint32_t n = phaseCounters[period]++;
+    // Fibonacci hashing: the high bits of n * 2^32/phi walk the unit
+    // interval as a low-discrepancy sequence
+    const uint32_t phase = n * 2654435769u;
+    const unsigned long offset = (static_cast<uint64_t>(period) * phase) >> 32;
+    if (offset == 0) {
+        task.enable();
+    } else {
+        task.enableDelayed(offset);
+    }
+}
+
 void Utils::removeAllFiles()
 {
     auto root = LittleFS.open("/");
@@ -125,3 +155,94 @@ void Utils::skipBom(File& f)
         f.read();
     }
 }
+
+void* Utils::allocBulk(const size_t size)
+{
+    void* buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == nullptr) {
+        buffer = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return buffer;
+}
+
+// Number of documents that can be checked out concurrently: one for
+// the webserver handlers on the async_tcp task, one spare for a
+// main-loop user
+#ifndef JSON_DOC_POOL_SLOT_COUNT
+#define JSON_DOC_POOL_SLOT_COUNT 2
+#endif
+
+// Sized for the largest request body, an inverter settings edit with
+// all channels populated
+#ifndef JSON_DOC_POOL_ARENA_SIZE
+#define JSON_DOC_POOL_ARENA_SIZE 4096
+#endif
+
+static JsonArena* sPoolArenas[JSON_DOC_POOL_SLOT_COUNT];
+static std::atomic<bool> sPoolSlotInUse[JSON_DOC_POOL_SLOT_COUNT];
+static std::atomic<uint32_t> sPoolExhausted { 0 };
+
+// Fallback allocator when every arena is checked out; behaves like a
+// plain heap-backed JsonDocument
+class PoolHeapAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override { return malloc(size); }
+    void deallocate(void* pointer) override { free(pointer); }
+    void* reallocate(void* pointer, size_t new_size) override { return realloc(pointer, new_size); }
+};
+static PoolHeapAllocator sPoolHeapAllocator;
+
+static int8_t claimPoolSlot()
+{
+    for (int8_t i = 0; i < JSON_DOC_POOL_SLOT_COUNT; i++) {
+        bool expected = false;
+        if (sPoolSlotInUse[i].compare_exchange_strong(expected, true)) {
+            if (sPoolArenas[i] == nullptr) {
+                // allocated on first use, after setup() has configured
+                // the allocation tiers
+                sPoolArenas[i] = new JsonArena(JSON_DOC_POOL_ARENA_SIZE);
+            }
+            sPoolArenas[i]->reset();
+            return i;
+        }
+    }
+
+    sPoolExhausted++;
+    return -1;
+}
+
+static ArduinoJson::Allocator* allocatorForSlot(const int8_t slot)
+{
+    return slot >= 0 ? static_cast<ArduinoJson::Allocator*>(sPoolArenas[slot]) : &sPoolHeapAllocator;
+}
+
+Utils::PooledJsonDocument::PooledJsonDocument()
+    : _slot(claimPoolSlot())
+    , _doc(allocatorForSlot(_slot))
+{
+}
+
+Utils::PooledJsonDocument::~PooledJsonDocument()
+{
+    // release the document's memory while the arena is still ours; the
+    // member destructor that runs afterwards has nothing left to free
+    _doc.clear();
+
+    if (_slot >= 0) {
+        sPoolSlotInUse[_slot] = false;
+    }
+}
+
+void Utils::PooledJsonDocument::serializeStats(JsonObject root)
+{
+    root["arena_size"] = JSON_DOC_POOL_ARENA_SIZE;
+    root["exhausted"] = sPoolExhausted.load();
+
+    JsonArray slots = root["slots"].to<JsonArray>();
+    for (int8_t i = 0; i < JSON_DOC_POOL_SLOT_COUNT; i++) {
+        JsonObject entry = slots.add<JsonObject>();
+        entry["in_use"] = sPoolSlotInUse[i].load();
+        entry["high_water"] = sPoolArenas[i] != nullptr ? sPoolArenas[i]->highWaterMark() : 0;
+        entry["heap_fallbacks"] = sPoolArenas[i] != nullptr ? sPoolArenas[i]->heapFallbacks() : 0;
+    }
+}
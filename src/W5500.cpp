@@ -12,6 +12,27 @@
 void tcpipInit();
 void add_esp_interface_netif(esp_interface_t interface, esp_netif_t* esp_netif);
 
+// The frame path lives in the IDF MAC driver: its receive task already
+// drains every pending frame from the chip before re-arming the INT
+// line, so the per-wakeup burst size is bounded by how quickly that
+// task runs and how fast the bus moves the bytes. These are the knobs
+// this glue actually controls; Ethernet-heavy deployments can override
+// them per build.
+#ifndef W5500_SPI_FREQUENCY
+#define W5500_SPI_FREQUENCY 20000000 // stable with OpenDTU Fusion shield
+#endif
+#ifndef W5500_SPI_QUEUE_SIZE
+#define W5500_SPI_QUEUE_SIZE 20
+#endif
+#ifndef W5500_RX_TASK_STACK_SIZE
+#define W5500_RX_TASK_STACK_SIZE 4096
+#endif
+// Above the lwIP TCP/IP task so a pending frame burst is pulled off
+// the chip before the stack starts chewing on the previous one
+#ifndef W5500_RX_TASK_PRIORITY
+#define W5500_RX_TASK_PRIORITY 19
+#endif
+
 W5500::W5500(spi_device_handle_t spi, gpio_num_t pin_int)
     : eth_handle(nullptr)
     , eth_netif(nullptr)
@@ -25,7 +46,8 @@ W5500::W5500(spi_device_handle_t spi, gpio_num_t pin_int)
     w5500_config.int_gpio_num = pin_int;
 
     eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
-    mac_config.rx_task_stack_size = 4096;
+    mac_config.rx_task_stack_size = W5500_RX_TASK_STACK_SIZE;
+    mac_config.rx_task_prio = W5500_RX_TASK_PRIORITY;
     esp_eth_mac_t* mac = esp_eth_mac_new_w5500(&w5500_config, &mac_config);
 
     eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
@@ -76,11 +98,11 @@ std::unique_ptr<W5500> W5500::setup(gpio_num_t pin_mosi, gpio_num_t pin_miso, gp
         .duty_cycle_pos = 0,
         .cs_ena_pretrans = 0, // only 0 supported
         .cs_ena_posttrans = 0, // only 0 supported
-        .clock_speed_hz = 20000000, // stable with OpenDTU Fusion shield
+        .clock_speed_hz = W5500_SPI_FREQUENCY,
         .input_delay_ns = 0,
         .spics_io_num = pin_cs,
         .flags = 0,
-        .queue_size = 20,
+        .queue_size = W5500_SPI_QUEUE_SIZE,
         .pre_cb = nullptr,
         .post_cb = nullptr,
     };
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WarmStart.h"
+#include "Utils.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <cstring>
+#include <ctime>
+
+#undef TAG
+static const char* TAG = "warmstart";
+
+static constexpr uint32_t warmStartMagic = 0x5357444F; // "ODWS"
+static constexpr uint32_t warmStartVersion = 1;
+
+WarmStartClass WarmStart;
+
+WarmStartClass::WarmStartClass()
+    : _saveTask(WARMSTART_SAVE_INTERVAL, TASK_FOREVER, std::bind(&WarmStartClass::saveLoop, this))
+    , _yieldRestoreTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WarmStartClass::yieldRestoreLoop, this))
+{
+}
+
+void WarmStartClass::init(Scheduler& scheduler)
+{
+#if WARMSTART_ENABLE
+    restore();
+
+    scheduler.addTask(_saveTask);
+    _saveTask.enable();
+
+    if (!_pendingYieldRestore.empty()) {
+        scheduler.addTask(_yieldRestoreTask);
+        _yieldRestoreTask.enable();
+    }
+#endif
+}
+
+void WarmStartClass::restore()
+{
+    File f = LittleFS.open(WARMSTART_FILENAME, "r");
+    if (!f) {
+        return;
+    }
+
+    WarmStartHeader header;
+    const bool valid = f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && header.magic == warmStartMagic
+        && header.version == warmStartVersion
+        && header.recordSize == sizeof(WarmStartRecord);
+
+    if (!valid) {
+        f.close();
+        ESP_LOGW(TAG, "Stale warm start file discarded");
+        LittleFS.remove(WARMSTART_FILENAME);
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.count; i++) {
+        WarmStartRecord rec;
+        if (f.read(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)) != sizeof(rec)) {
+            break;
+        }
+
+        auto inv = Hoymiles.getInverterBySerial(rec.serial);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        auto stats = inv->Statistics();
+        if (rec.statisticLength > 0 && rec.statisticLength <= STATISTIC_PACKET_SIZE
+            && stats->getLastUpdate() == 0) {
+            // Same ingestion path a received statistics exchange takes
+            stats->beginAppendFragment();
+            stats->clearBuffer();
+            stats->appendFragment(0, rec.statistic, rec.statisticLength);
+            stats->endAppendFragment();
+            stats->setLastUpdate(millis());
+            stats->setWarmStart(true);
+
+            ESP_LOGI(TAG, "Restored statistics snapshot for %s", inv->serialString().c_str());
+        }
+
+        auto devInfo = inv->DevInfo();
+        if (rec.devInfoSimpleLength > 0 && rec.devInfoSimpleLength <= DEV_INFO_SIZE
+            && devInfo->getLastUpdateSimple() == 0) {
+            devInfo->beginAppendFragment();
+            devInfo->clearBufferSimple();
+            devInfo->appendFragmentSimple(0, rec.devInfoSimple, rec.devInfoSimpleLength);
+            devInfo->endAppendFragment();
+            devInfo->setLastUpdateSimple(millis());
+        }
+        if (rec.devInfoAllLength > 0 && rec.devInfoAllLength <= DEV_INFO_SIZE
+            && devInfo->getLastUpdateAll() == 0) {
+            devInfo->beginAppendFragment();
+            devInfo->clearBufferAll();
+            devInfo->appendFragmentAll(0, rec.devInfoAll, rec.devInfoAllLength);
+            devInfo->endAppendFragment();
+            devInfo->setLastUpdateAll(millis());
+        }
+
+        // Yield-day state needs wall clock time to judge whether the
+        // snapshot is from today; deferred until NTP has synced
+        if (rec.savedAt > 0) {
+            _pendingYieldRestore.push_back(rec);
+        }
+    }
+    f.close();
+}
+
+void WarmStartClass::yieldRestoreLoop()
+{
+    if (!Utils::getTimeAvailable()) {
+        return;
+    }
+
+    const time_t now = time(nullptr);
+    struct tm today;
+    localtime_r(&now, &today);
+
+    for (const auto& rec : _pendingYieldRestore) {
+        const time_t saved = rec.savedAt;
+        struct tm savedDay;
+        localtime_r(&saved, &savedDay);
+
+        if (savedDay.tm_yday != today.tm_yday || savedDay.tm_year != today.tm_year) {
+            // Different local day: the inverter started a new yield day
+            // anyway, restoring would inflate today's counter
+            continue;
+        }
+
+        auto inv = Hoymiles.getInverterBySerial(rec.serial);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        auto stats = inv->Statistics();
+        for (uint8_t c = 0; c < CH_CNT; c++) {
+            // Re-apply a persisted reset-bridging offset exactly once
+            if (rec.yieldDayOffset[c] != 0
+                && stats->getChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YD) == 0) {
+                stats->setChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YD, rec.yieldDayOffset[c]);
+            }
+            // The cached last yield day only matters while no real data
+            // arrived yet; afterwards the live tracking is authoritative
+            if (stats->isWarmStart()) {
+                stats->setLastYieldDay(c, rec.lastYieldDay[c]);
+            }
+        }
+        ESP_LOGI(TAG, "Restored yield day state for %s", inv->serialString().c_str());
+    }
+
+    _pendingYieldRestore.clear();
+    _yieldRestoreTask.disable();
+}
+
+void WarmStartClass::saveLoop()
+{
+    // Only rewrite the file when at least one inverter produced real
+    // data since the last save
+    bool fresh = false;
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        const uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
+        if (lastUpdate > 0 && !inv->Statistics()->isWarmStart()
+            && static_cast<int32_t>(lastUpdate - _lastSaveAt) > 0) {
+            fresh = true;
+            break;
+        }
+    }
+    if (!fresh) {
+        return;
+    }
+
+    std::vector<WarmStartRecord> records;
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        auto stats = inv->Statistics();
+
+        WarmStartRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.serial = inv->serial();
+        rec.savedAt = Utils::getTimeAvailable() ? time(nullptr) : 0;
+        rec.statisticLength = stats->getStatisticPayload(rec.statistic, sizeof(rec.statistic));
+        if (rec.statisticLength == 0) {
+            continue;
+        }
+
+        for (uint8_t c = 0; c < CH_CNT; c++) {
+            rec.lastYieldDay[c] = stats->getLastYieldDay(c);
+            rec.yieldDayOffset[c] = stats->getChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YD);
+        }
+
+        rec.devInfoSimpleLength = inv->DevInfo()->getPayloadSimple(rec.devInfoSimple, sizeof(rec.devInfoSimple));
+        rec.devInfoAllLength = inv->DevInfo()->getPayloadAll(rec.devInfoAll, sizeof(rec.devInfoAll));
+
+        records.push_back(rec);
+    }
+
+    if (records.empty()) {
+        return;
+    }
+
+    File f = LittleFS.open(WARMSTART_FILENAME, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s for writing", WARMSTART_FILENAME);
+        return;
+    }
+
+    WarmStartHeader header;
+    header.magic = warmStartMagic;
+    header.version = warmStartVersion;
+    header.recordSize = sizeof(WarmStartRecord);
+    header.count = records.size();
+    f.write(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+    for (const auto& rec : records) {
+        f.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+    }
+    f.close();
+
+    _lastSaveAt = millis();
+}
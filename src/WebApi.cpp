@@ -6,17 +6,96 @@
 #include "Configuration.h"
 #include "defaults.h"
 #include <AsyncJson.h>
+#include <esp_random.h>
 
 #undef TAG
 static const char* TAG = "webapi";
 
+// Keep-alive policy advertised to API clients. The async TCP stack
+// keeps connections open anyway; the header tells pollers how long a
+// socket may idle and how many requests it may carry before they
+// should expect a close, so they can size their reuse behavior against
+// the device instead of opening a fresh connection per poll.
+#ifndef WEBAPI_KEEPALIVE_TIMEOUT_SECONDS
+#define WEBAPI_KEEPALIVE_TIMEOUT_SECONDS 10
+#endif
+#ifndef WEBAPI_KEEPALIVE_MAX_REQUESTS
+#define WEBAPI_KEEPALIVE_MAX_REQUESTS 100
+#endif
+
+// Session-token fast path: verifying the Authorization header on every
+// request is pure overhead for clients that poll the API. A client runs
+// the handshake once against /api/security/authenticate, receives a
+// random token and presents it in the X-Auth-Token header afterwards;
+// checkCredentials() then only performs a constant-time string compare.
+// A handful of slots is enough for browser tabs plus a poller or two;
+// the oldest token is recycled when all slots are taken.
+#ifndef WEBAPI_AUTH_TOKEN_LIFETIME_MS
+#define WEBAPI_AUTH_TOKEN_LIFETIME_MS (60 * 60 * 1000)
+#endif
+#ifndef WEBAPI_AUTH_TOKEN_SLOTS
+#define WEBAPI_AUTH_TOKEN_SLOTS 4
+#endif
+
+struct AuthToken {
+    char value[33]; // 128 bit as hex, NUL terminated
+    uint32_t issuedAt = 0;
+    bool valid = false;
+};
+
+static AuthToken authTokens[WEBAPI_AUTH_TOKEN_SLOTS];
+static uint8_t authTokenNext = 0;
+
+// Constant-time compare: the runtime must not depend on how many
+// leading characters of the guess match, so every byte is always
+// visited and the differences are accumulated instead of branching
+static bool authTokenEquals(const char* expected, const String& provided)
+{
+    if (provided.length() != sizeof(authTokens[0].value) - 1) {
+        return false;
+    }
+
+    uint8_t diff = 0;
+    for (size_t i = 0; i < sizeof(authTokens[0].value) - 1; i++) {
+        diff |= static_cast<uint8_t>(expected[i]) ^ static_cast<uint8_t>(provided[i]);
+    }
+    return diff == 0;
+}
+
 WebApiClass::WebApiClass()
     : _server(HTTP_PORT)
+    , _statsMiddleware([this](AsyncWebServerRequest* request, ArMiddlewareNext next) {
+        trackConnection(request);
+        _activeRequests++;
+        const uint32_t start = ESP.getCycleCount();
+        next();
+        const uint32_t cycles = ESP.getCycleCount() - start;
+        _activeRequests--;
+
+        auto& stats = routeStats(request);
+        stats.invocations++;
+        const uint32_t durationUs = cycles / ESP.getCpuFreqMHz();
+        stats.durationSumUs += durationUs;
+        uint8_t bucket = 0;
+        while (bucket < 5 && durationUs > RouteStats::durationBucketBoundsUs[bucket]) {
+            bucket++;
+        }
+        stats.durationBuckets[bucket]++;
+    })
 {
 }
 
 void WebApiClass::init(Scheduler& scheduler)
 {
+    using std::placeholders::_1;
+
+    _server.addMiddleware(&_statsMiddleware);
+    _server.on("/api/webapi/stats", HTTP_GET, std::bind(&WebApiClass::onWebApiStats, this, _1));
+
+    DefaultHeaders::Instance().addHeader("Keep-Alive",
+        "timeout=" + String(WEBAPI_KEEPALIVE_TIMEOUT_SECONDS) + ", max=" + String(WEBAPI_KEEPALIVE_MAX_REQUESTS));
+
+    _webApiDailyStats.init(_server, scheduler);
     _webApiDevice.init(_server, scheduler);
     _webApiDevInfo.init(_server, scheduler);
     _webApiDtu.init(_server, scheduler);
@@ -24,6 +103,7 @@ void WebApiClass::init(Scheduler& scheduler)
     _webApiFile.init(_server, scheduler);
     _webApiFirmware.init(_server, scheduler);
     _webApiGridprofile.init(_server, scheduler);
+    _webApiHistory.init(_server, scheduler);
     _webApiI18n.init(_server, scheduler);
     _webApiInverter.init(_server, scheduler);
     _webApiLimit.init(_server, scheduler);
@@ -33,8 +113,13 @@ void WebApiClass::init(Scheduler& scheduler)
     _webApiNetwork.init(_server, scheduler);
     _webApiNtp.init(_server, scheduler);
     _webApiPower.init(_server, scheduler);
+    _webApiProfiler.init(_server, scheduler);
     _webApiPrometheus.init(_server, scheduler);
+    _webApiRadioStats.init(_server, scheduler);
+    _webApiRadioTrace.init(_server, scheduler);
+    _webApiTasks.init(_server, scheduler);
     _webApiSecurity.init(_server, scheduler);
+    _webApiSoakLog.init(_server, scheduler);
     _webApiSysstatus.init(_server, scheduler);
     _webApiWebapp.init(_server, scheduler);
     _webApiWsConsole.init(_server, scheduler);
@@ -45,12 +130,34 @@ void WebApiClass::init(Scheduler& scheduler)
 
 void WebApiClass::reload()
 {
+    // The password may just have changed - tokens issued against the
+    // old one must not outlive it
+    invalidateAuthTokens();
+
     _webApiWsConsole.reload();
     _webApiWsLive.reload();
+    _webApiEventlog.reload();
 }
 
 bool WebApiClass::checkCredentials(AsyncWebServerRequest* request)
 {
+    // Token fast path before the full credential verification
+    if (request->hasHeader("X-Auth-Token")) {
+        const String& token = request->getHeader("X-Auth-Token")->value();
+        for (auto& slot : authTokens) {
+            if (!slot.valid) {
+                continue;
+            }
+            if (millis() - slot.issuedAt > WEBAPI_AUTH_TOKEN_LIFETIME_MS) {
+                slot.valid = false;
+                continue;
+            }
+            if (authTokenEquals(slot.value, token)) {
+                return true;
+            }
+        }
+    }
+
     auto const& config = Configuration.get();
     if (request->authenticate(AUTH_USERNAME, config.Security.Password)) {
         return true;
@@ -77,6 +184,32 @@ bool WebApiClass::checkCredentialsReadonly(AsyncWebServerRequest* request)
     }
 }
 
+String WebApiClass::issueAuthToken()
+{
+    AuthToken& slot = authTokens[authTokenNext];
+    authTokenNext = (authTokenNext + 1) % WEBAPI_AUTH_TOKEN_SLOTS;
+
+    for (uint8_t i = 0; i < sizeof(slot.value) - 1; i += 8) {
+        snprintf(&slot.value[i], 9, "%08" PRIx32, esp_random());
+    }
+    slot.issuedAt = millis();
+    slot.valid = true;
+
+    return String(slot.value);
+}
+
+void WebApiClass::invalidateAuthTokens()
+{
+    for (auto& slot : authTokens) {
+        slot.valid = false;
+    }
+}
+
+uint32_t WebApiClass::getAuthTokenLifetimeSeconds()
+{
+    return WEBAPI_AUTH_TOKEN_LIFETIME_MS / 1000;
+}
+
 void WebApiClass::sendTooManyRequests(AsyncWebServerRequest* request)
 {
     auto response = request->beginResponse(429, "text/plain", "Too Many Requests");
@@ -86,14 +219,13 @@ void WebApiClass::sendTooManyRequests(AsyncWebServerRequest* request)
 
 void WebApiClass::writeConfig(JsonVariant& retMsg, const WebApiError code, const String& message)
 {
-    if (!Configuration.write()) {
-        retMsg["message"] = "Write failed!";
-        retMsg["code"] = WebApiError::GenericWriteFailed;
-    } else {
-        retMsg["type"] = "success";
-        retMsg["message"] = message;
-        retMsg["code"] = code;
-    }
+    // Write-behind: the commit happens on the configuration loop task,
+    // a failure there is logged instead of reported to this response
+    Configuration.requestWrite();
+
+    retMsg["type"] = "success";
+    retMsg["message"] = message;
+    retMsg["code"] = code;
 }
 
 bool WebApiClass::parseRequestData(AsyncWebServerRequest* request, AsyncJsonResponse* response, JsonDocument& json_document)
@@ -108,8 +240,15 @@ bool WebApiClass::parseRequestData(AsyncWebServerRequest* request, AsyncJsonResp
         return false;
     }
 
-    const String json = request->getParam("data", true)->value();
-    const DeserializationError error = deserializeJson(json_document, json);
+    // In-situ parse: the body stays in the request's parameter buffer,
+    // string values are unescaped in place and referenced instead of
+    // being copied into the document. This consumes the parameter (the
+    // buffer is mutated), which is fine - it has exactly this one
+    // reader. The document must not outlive the request, which holds
+    // for every handler since they parse and answer synchronously.
+    const String& json = request->getParam("data", true)->value();
+    char* buffer = const_cast<char*>(json.c_str());
+    const DeserializationError error = deserializeJson(json_document, buffer, json.length());
     if (error) {
         retMsg["message"] = "Failed to parse data!";
         retMsg["code"] = WebApiError::GenericParseError;
@@ -130,6 +269,56 @@ uint64_t WebApiClass::parseSerialFromRequest(AsyncWebServerRequest* request, Str
     return 0;
 }
 
+void WebApiClass::evictStalledClients(AsyncWebSocket& ws, std::map<uint32_t, uint32_t>& stalledSince)
+{
+    static constexpr uint32_t stallTimeoutMs = 10 * 1000;
+
+    for (auto& client : ws.getClients()) {
+        if (client.status() != WS_CONNECTED || !client.queueIsFull()) {
+            stalledSince.erase(client.id());
+            continue;
+        }
+
+        const auto it = stalledSince.find(client.id());
+        if (it == stalledSince.end()) {
+            stalledSince[client.id()] = millis();
+            continue;
+        }
+
+        if (millis() - it->second > stallTimeoutMs) {
+            ESP_LOGW(TAG, "Websocket: [%s][%" PRIu32 "] send queue stalled, closing client", ws.url(), client.id());
+            client.close();
+            stalledSince.erase(it);
+        }
+    }
+
+    // Forget clients that disconnected while being tracked
+    for (auto it = stalledSince.begin(); it != stalledSince.end();) {
+        if (ws.client(it->first) == nullptr) {
+            it = stalledSince.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool WebApiClass::checkETag(AsyncWebServerRequest* request, const String& etag)
+{
+    if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+        auto response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        request->send(response);
+        return true;
+    }
+    return false;
+}
+
+bool WebApiClass::sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line, const String& etag)
+{
+    response->addHeader("ETag", etag);
+    return sendJsonResponse(request, response, function, line);
+}
+
 bool WebApiClass::sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line)
 {
     bool ret_val = true;
@@ -145,9 +334,99 @@ bool WebApiClass::sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResp
         ret_val = false;
     }
 
+    WebApi.routeStats(request).bytesOut += measureJson(response->getRoot());
+
     response->setLength();
     request->send(response);
     return ret_val;
 }
 
+void WebApiClass::trackConnection(AsyncWebServerRequest* request)
+{
+    static constexpr size_t maxTrackedConnections = 16;
+
+    // The pool recycles client objects, so the pointer alone would
+    // alias a fresh connection with a closed one; the remote port
+    // disambiguates all practical cases
+    const uintptr_t key = reinterpret_cast<uintptr_t>(request->client())
+        ^ (static_cast<uintptr_t>(request->client()->remotePort()) << 16);
+    const uint32_t now = millis();
+
+    // Forget connections idle beyond the advertised keep-alive window
+    for (auto it = _connectionLastSeen.begin(); it != _connectionLastSeen.end();) {
+        if (now - it->second > (WEBAPI_KEEPALIVE_TIMEOUT_SECONDS + 1) * 1000) {
+            it = _connectionLastSeen.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const auto it = _connectionLastSeen.find(key);
+    if (it != _connectionLastSeen.end()) {
+        _reusedRequests++;
+        it->second = now;
+        return;
+    }
+
+    _connectionsOpened++;
+    if (_connectionLastSeen.size() < maxTrackedConnections) {
+        _connectionLastSeen[key] = now;
+    }
+}
+
+WebApiClass::RouteStats& WebApiClass::routeStats(AsyncWebServerRequest* request)
+{
+    // Unmatched probe URLs must not grow the map without bound
+    static constexpr size_t maxTrackedRoutes = 48;
+
+    String key = request->methodToString();
+    key += ' ';
+    key += request->url();
+
+    const auto it = _routeStats.find(key);
+    if (it != _routeStats.end()) {
+        return it->second;
+    }
+    if (_routeStats.size() >= maxTrackedRoutes) {
+        return _routeStats["other"];
+    }
+    return _routeStats[key];
+}
+
+void WebApiClass::onWebApiStats(AsyncWebServerRequest* request)
+{
+    if (!checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["active_requests"] = _activeRequests;
+    root["connections_opened"] = _connectionsOpened;
+    root["requests_on_reused_connections"] = _reusedRequests;
+
+    auto keepalive = root["keepalive"].to<JsonObject>();
+    keepalive["timeout"] = WEBAPI_KEEPALIVE_TIMEOUT_SECONDS;
+    keepalive["max"] = WEBAPI_KEEPALIVE_MAX_REQUESTS;
+
+    auto routes = root["routes"].to<JsonObject>();
+    for (const auto& entry : _routeStats) {
+        auto route = routes[entry.first].to<JsonObject>();
+        route["invocations"] = entry.second.invocations;
+        route["bytes_out"] = entry.second.bytesOut;
+
+        auto duration = route["duration_us"].to<JsonObject>();
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < 5; b++) {
+            cumulative += entry.second.durationBuckets[b];
+            duration[String(RouteStats::durationBucketBoundsUs[b])] = cumulative;
+        }
+        duration["inf"] = cumulative + entry.second.durationBuckets[5];
+        duration["sum"] = entry.second.durationSumUs;
+    }
+
+    sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
 WebApiClass WebApi;
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_dailystats.h"
+#include "DailyStats.h"
+#include "WebApi.h"
+#include <AsyncJson.h>
+#include <Hoymiles.h>
+
+void WebApiDailyStatsClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/statistics/daily", HTTP_GET, std::bind(&WebApiDailyStatsClass::onDailyStats, this, _1));
+}
+
+void WebApiDailyStatsClass::onDailyStats(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["day_start"] = DailyStats.getDayStart();
+
+    JsonArray invertersArray = root["inverters"].to<JsonArray>();
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        JsonObject invObject = invertersArray.add<JsonObject>();
+        invObject["serial"] = inv->serialString();
+        invObject["name"] = inv->name();
+
+        JsonArray channelsArray = invObject["channels"].to<JsonArray>();
+        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+            DailyStatsClass::ChannelDailyStats_t stats;
+            if (!DailyStats.getChannelStats(inv->serial(), c, stats)) {
+                continue;
+            }
+
+            JsonObject channelObject = channelsArray.add<JsonObject>();
+            channelObject["channel"] = c;
+            channelObject["samples"] = stats.samples;
+
+            JsonObject powerObject = channelObject["power"].to<JsonObject>();
+            powerObject["min"] = stats.powerMin;
+            powerObject["max"] = stats.powerMax;
+            powerObject["median"] = stats.powerMedian;
+            powerObject["min_at"] = stats.powerMinAt;
+            powerObject["max_at"] = stats.powerMaxAt;
+
+            JsonObject voltageObject = channelObject["voltage"].to<JsonObject>();
+            voltageObject["min"] = stats.voltageMin;
+            voltageObject["max"] = stats.voltageMax;
+            voltageObject["min_at"] = stats.voltageMinAt;
+            voltageObject["max_at"] = stats.voltageMaxAt;
+        }
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
@@ -7,6 +7,7 @@
 #include "Display_Graphic.h"
 #include "PinMapping.h"
 #include "RestartHelper.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
@@ -106,7 +107,8 @@ void WebApiDeviceClass::onDeviceAdminPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
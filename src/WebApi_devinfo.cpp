@@ -13,6 +13,7 @@ void WebApiDevInfoClass::init(AsyncWebServer& server, Scheduler& scheduler)
     using std::placeholders::_1;
 
     server.on("/api/devinfo/status", HTTP_GET, std::bind(&WebApiDevInfoClass::onDevInfoStatus, this, _1));
+    server.on("/api/devinfo/rawdata.bin", HTTP_GET, std::bind(&WebApiDevInfoClass::onDevInfoRawdataBin, this, _1));
 }
 
 void WebApiDevInfoClass::onDevInfoStatus(AsyncWebServerRequest* request)
@@ -40,3 +41,43 @@ void WebApiDevInfoClass::onDevInfoStatus(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
+
+void WebApiDevInfoClass::onDevInfoRawdataBin(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    auto serial = WebApi.parseSerialFromRequest(request);
+    auto inv = Hoymiles.getInverterBySerial(serial);
+
+    if (inv == nullptr) {
+        request->send(404);
+        return;
+    }
+
+    // "?type=simple" selects the simple record, everything else the
+    // full one - the same raw payloads the warm start persists
+    const bool simple = request->hasParam("type")
+        && request->getParam("type")->value() == "simple";
+
+    const String etag = "\"dib-" + inv->serialString() + "-" + String(simple ? "s" : "a") + "-"
+        + String(simple ? inv->DevInfo()->getLastUpdateSimple() : inv->DevInfo()->getLastUpdateAll()) + "\"";
+    if (WebApi.checkETag(request, etag)) {
+        return;
+    }
+
+    uint8_t payload[DEV_INFO_SIZE];
+    const uint8_t len = simple
+        ? inv->DevInfo()->getPayloadSimple(payload, sizeof(payload))
+        : inv->DevInfo()->getPayloadAll(payload, sizeof(payload));
+
+    if (len == 0) {
+        request->send(404);
+        return;
+    }
+
+    AsyncWebServerResponse* response = request->beginResponse(200, "application/octet-stream", payload, len);
+    response->addHeader("ETag", etag);
+    request->send(response);
+}
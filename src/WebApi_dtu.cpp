@@ -4,6 +4,7 @@
  */
 #include "WebApi_dtu.h"
 #include "Configuration.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include <AsyncJson.h>
@@ -21,6 +22,13 @@ void WebApiDtuClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/dtu/config", HTTP_GET, std::bind(&WebApiDtuClass::onDtuAdminGet, this, _1));
     server.on("/api/dtu/config", HTTP_POST, std::bind(&WebApiDtuClass::onDtuAdminPost, this, _1));
 
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        if (scope == ConfigScope::Dtu || scope == ConfigScope::All) {
+            _applyDataTask.enable();
+            _applyDataTask.restart();
+        }
+    });
+
     scheduler.addTask(_applyDataTask);
 }
 
@@ -83,7 +91,8 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -168,6 +177,5 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
-    _applyDataTask.enable();
-    _applyDataTask.restart();
+    Configuration.notifyConfigChanged(ConfigScope::Dtu);
 }
@@ -3,15 +3,281 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_eventlog.h"
+#include "Configuration.h"
+#include "Utils.h"
 #include "WebApi.h"
+#include "defaults.h"
 #include <AsyncJson.h>
 #include <Hoymiles.h>
+#include <algorithm>
+#include <esp_log.h>
+#include <vector>
+
+#undef TAG
+static const char* TAG = "webapi";
+
+// A grid sag raises the same alarm on every inverter, but the
+// exchanges delivering the logs complete over a few seconds. Pushes
+// are held back this long after the first update of a burst so the
+// whole fleet's alarms land in one aggregated pass instead of one
+// frame per inverter.
+#ifndef ALARM_AGGREGATION_WINDOW_MS
+#define ALARM_AGGREGATION_WINDOW_MS 3000
+#endif
+
+// An entry's cursor is the newer of its two timestamps: a fresh alarm
+// moves the cursor via its start time, an alarm that ended since the
+// last fetch via its end time, so both surface in an incremental fetch
+static time_t entryCursor(const AlarmLogEntry_t& entry)
+{
+    return entry.EndTime > entry.StartTime ? entry.EndTime : entry.StartTime;
+}
+
+WebApiEventlogClass::WebApiEventlogClass()
+    : _ws("/events")
+    , _wsCleanupTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiEventlogClass::wsCleanupTaskCb, this))
+    , _sendAlarmsTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiEventlogClass::sendAlarmsTaskCb, this))
+{
+}
 
 void WebApiEventlogClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
+    using std::placeholders::_2;
+    using std::placeholders::_3;
+    using std::placeholders::_4;
+    using std::placeholders::_5;
+    using std::placeholders::_6;
 
     server.on("/api/eventlog/status", HTTP_GET, std::bind(&WebApiEventlogClass::onEventlogStatus, this, _1));
+
+    server.addHandler(&_ws);
+    _ws.onEvent(std::bind(&WebApiEventlogClass::onWebsocketEvent, this, _1, _2, _3, _4, _5, _6));
+
+    scheduler.addTask(_wsCleanupTask);
+    Utils::enableStaggered(_wsCleanupTask);
+
+    scheduler.addTask(_sendAlarmsTask);
+    Utils::enableStaggered(_sendAlarmsTask);
+
+    // Mark the burst start; sendAlarmsTaskCb waits out the
+    // aggregation window before pushing, so alarms raised fleet-wide
+    // by one grid event coalesce into a single pass
+    InverterAbstract::onAlarmLogUpdated([this](InverterAbstract&) {
+        uint32_t expected = 0;
+        _alarmBurstSince.compare_exchange_strong(expected, millis() | 1);
+    });
+
+    _simpleDigestAuth.setUsername(AUTH_USERNAME);
+    _simpleDigestAuth.setRealm("events websocket");
+
+    reload();
+}
+
+void WebApiEventlogClass::reload()
+{
+    _ws.removeMiddleware(&_simpleDigestAuth);
+
+    auto const& config = Configuration.get();
+
+    if (config.Security.AllowReadonly) {
+        return;
+    }
+
+    _ws.enable(false);
+    _simpleDigestAuth.setPassword(config.Security.Password);
+    _ws.addMiddleware(&_simpleDigestAuth);
+    _ws.closeAll();
+    _ws.enable(true);
+}
+
+void WebApiEventlogClass::wsCleanupTaskCb()
+{
+    _ws.cleanupClients();
+    WebApi.evictStalledClients(_ws, _stalledClients);
+}
+
+void WebApiEventlogClass::sendAlarmsTaskCb()
+{
+    // With no client connected the cursors simply lag behind; the
+    // first push after a client (re)connects carries the backlog
+    if (_ws.count() == 0) {
+        return;
+    }
+
+    // Wait out the aggregation window so the whole burst is on hand
+    const uint32_t burstSince = _alarmBurstSince.load();
+    if (burstSince != 0 && millis() - burstSince < ALARM_AGGREGATION_WINDOW_MS) {
+        return;
+    }
+    _alarmBurstSince = 0;
+
+    struct FreshAlarm {
+        uint64_t serial;
+        String serialString;
+        AlarmLogEntry_t entry;
+        bool grouped;
+    };
+
+    std::vector<FreshAlarm> fresh;
+    std::map<uint64_t, time_t> newestCursor;
+
+    try {
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv == nullptr) {
+                continue;
+            }
+
+            const uint8_t logEntryCount = inv->EventLog()->getEntryCount();
+            if (logEntryCount == 0) {
+                continue;
+            }
+
+            const time_t since = _pushedCursor[inv->serial()];
+            time_t newest = since;
+
+            for (uint8_t logEntry = 0; logEntry < logEntryCount; logEntry++) {
+                AlarmLogEntry_t entry;
+                inv->EventLog()->getLogEntry(logEntry, entry);
+
+                const time_t cursor = entryCursor(entry);
+                if (cursor <= since) {
+                    continue;
+                }
+                if (cursor > newest) {
+                    newest = cursor;
+                }
+                fresh.push_back({ inv->serial(), inv->serialString(), entry, false });
+            }
+
+            if (newest > since) {
+                newestCursor[inv->serial()] = newest;
+            }
+        }
+
+        if (fresh.empty()) {
+            return;
+        }
+
+        // Serials with a dropped frame this pass keep their cursor and
+        // retry on the next tick
+        std::map<uint64_t, bool> failed;
+
+        auto sendFrame = [this](JsonDocument& root) -> bool {
+            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                return false;
+            }
+            const size_t len = measureJson(root);
+            auto buffer = _ws.makeBuffer(len);
+            if (buffer == nullptr) {
+                return false;
+            }
+            serializeJson(root, buffer->get(), len);
+            _ws.textAll(buffer);
+            return true;
+        };
+
+        // Fleet dedup: an alarm code fresh on two or more inverters
+        // goes out as one fleet frame with a count instead of being
+        // repeated per inverter, bounding the worst case (all
+        // inverters raise the same grid alarm) at a single frame
+        for (size_t i = 0; i < fresh.size(); i++) {
+            if (fresh[i].grouped) {
+                continue;
+            }
+
+            std::vector<size_t> members;
+            std::vector<uint64_t> serials;
+            for (size_t j = i; j < fresh.size(); j++) {
+                if (fresh[j].grouped || fresh[j].entry.MessageId != fresh[i].entry.MessageId) {
+                    continue;
+                }
+                members.push_back(j);
+                if (std::find(serials.begin(), serials.end(), fresh[j].serial) == serials.end()) {
+                    serials.push_back(fresh[j].serial);
+                }
+            }
+
+            if (serials.size() < 2) {
+                continue; // stays in its per-inverter frame below
+            }
+
+            time_t earliestStart = fresh[i].entry.StartTime;
+            time_t latestEnd = fresh[i].entry.EndTime;
+
+            JsonDocument root;
+            root["fleet"] = true;
+            root["message_id"] = fresh[i].entry.MessageId;
+            root["message"] = fresh[i].entry.Message;
+            root["count"] = serials.size();
+            JsonArray serialsArray = root["serials"].to<JsonArray>();
+            std::vector<uint64_t> added;
+            for (const size_t j : members) {
+                fresh[j].grouped = true;
+                earliestStart = std::min(earliestStart, fresh[j].entry.StartTime);
+                latestEnd = std::max(latestEnd, fresh[j].entry.EndTime);
+                if (std::find(added.begin(), added.end(), fresh[j].serial) == added.end()) {
+                    added.push_back(fresh[j].serial);
+                    serialsArray.add(fresh[j].serialString);
+                }
+            }
+            root["start_time"] = earliestStart;
+            root["end_time"] = latestEnd;
+
+            if (!sendFrame(root)) {
+                for (const uint64_t serial : serials) {
+                    failed[serial] = true;
+                }
+            }
+        }
+
+        // Everything ungrouped keeps the established per-inverter
+        // frame shape
+        for (const auto& cursor : newestCursor) {
+            JsonDocument root;
+            JsonArray eventsArray;
+
+            for (const auto& alarm : fresh) {
+                if (alarm.grouped || alarm.serial != cursor.first) {
+                    continue;
+                }
+                if (eventsArray.isNull()) {
+                    root["serial"] = alarm.serialString;
+                    eventsArray = root["events"].to<JsonArray>();
+                }
+                JsonObject eventsObject = eventsArray.add<JsonObject>();
+                eventsObject["message_id"] = alarm.entry.MessageId;
+                eventsObject["message"] = alarm.entry.Message;
+                eventsObject["start_time"] = alarm.entry.StartTime;
+                eventsObject["end_time"] = alarm.entry.EndTime;
+            }
+
+            if (!eventsArray.isNull()) {
+                root["cursor"] = cursor.second;
+                if (!sendFrame(root)) {
+                    failed[cursor.first] = true;
+                }
+            }
+        }
+
+        for (const auto& cursor : newestCursor) {
+            if (failed.find(cursor.first) == failed.end()) {
+                _pushedCursor[cursor.first] = cursor.second;
+            }
+        }
+    } catch (const std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Alarm push on /events temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+    }
+}
+
+void WebApiEventlogClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)
+{
+    if (type == WS_EVT_CONNECT) {
+        ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] connect", server->url(), client->id());
+    } else if (type == WS_EVT_DISCONNECT) {
+        ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] disconnect", server->url(), client->id());
+    }
 }
 
 void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
@@ -36,25 +302,46 @@ void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
         }
     }
 
+    // Incremental fetch: "?since=<cursor>" skips entries the client
+    // already holds. The response always reports the newest cursor, so
+    // a poller passes it back on the next request and receives empty
+    // responses while nothing changed
+    time_t since = 0;
+    if (request->hasParam("since")) {
+        since = request->getParam("since")->value().toInt();
+    }
+
     auto inv = Hoymiles.getInverterBySerial(serial);
 
     if (inv != nullptr) {
-        uint8_t logEntryCount = inv->EventLog()->getEntryCount();
+        const uint8_t logEntryCount = inv->EventLog()->getEntryCount();
 
-        root["count"] = logEntryCount;
+        time_t newest = 0;
+        uint8_t emitted = 0;
         JsonArray eventsArray = root["events"].to<JsonArray>();
 
         for (uint8_t logEntry = 0; logEntry < logEntryCount; logEntry++) {
-            JsonObject eventsObject = eventsArray.add<JsonObject>();
-
             AlarmLogEntry_t entry;
             inv->EventLog()->getLogEntry(logEntry, entry, locale);
 
+            const time_t cursor = entryCursor(entry);
+            if (cursor > newest) {
+                newest = cursor;
+            }
+            if (since > 0 && cursor <= since) {
+                continue;
+            }
+
+            JsonObject eventsObject = eventsArray.add<JsonObject>();
             eventsObject["message_id"] = entry.MessageId;
             eventsObject["message"] = entry.Message;
             eventsObject["start_time"] = entry.StartTime;
             eventsObject["end_time"] = entry.EndTime;
+            emitted++;
         }
+
+        root["count"] = emitted;
+        root["cursor"] = newest;
     }
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
@@ -11,6 +11,15 @@
 #include <AsyncJson.h>
 #include <LittleFS.h>
 
+// Read-ahead chunk per active download. One flash read of this size is
+// performed per main loop pass while the TCP window drains in parallel.
+static constexpr size_t FILE_STREAM_BUFFER_SIZE = 4096;
+
+WebApiFileClass::WebApiFileClass()
+    : _refillTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&WebApiFileClass::refillLoop, this))
+{
+}
+
 void WebApiFileClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
@@ -27,6 +36,8 @@ void WebApiFileClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/file/upload", HTTP_POST,
         std::bind(&WebApiFileClass::onFileUploadFinish, this, _1),
         std::bind(&WebApiFileClass::onFileUpload, this, _1, _2, _3, _4, _5, _6));
+
+    scheduler.addTask(_refillTask);
 }
 
 void WebApiFileClass::onFileListGet(AsyncWebServerRequest* request)
@@ -56,6 +67,43 @@ void WebApiFileClass::onFileListGet(AsyncWebServerRequest* request)
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
 
+bool WebApiFileClass::parseRangeHeader(const String& value, const size_t fileSize, size_t& start, size_t& end)
+{
+    if (!value.startsWith("bytes=") || value.indexOf(',') >= 0 || fileSize == 0) {
+        return false;
+    }
+
+    const String spec = value.substring(6);
+    const int dash = spec.indexOf('-');
+    if (dash < 0) {
+        return false;
+    }
+
+    const String first = spec.substring(0, dash);
+    const String last = spec.substring(dash + 1);
+
+    if (first.isEmpty()) {
+        // suffix form: the last N bytes of the file
+        const size_t suffix = strtoul(last.c_str(), nullptr, 10);
+        if (suffix == 0) {
+            return false;
+        }
+        start = (suffix >= fileSize) ? 0 : fileSize - suffix;
+        end = fileSize - 1;
+        return true;
+    }
+
+    start = strtoul(first.c_str(), nullptr, 10);
+    end = last.isEmpty() ? fileSize - 1 : strtoul(last.c_str(), nullptr, 10);
+    if (start >= fileSize || end < start) {
+        return false;
+    }
+    if (end >= fileSize) {
+        end = fileSize - 1;
+    }
+    return true;
+}
+
 void WebApiFileClass::onFileGet(AsyncWebServerRequest* request)
 {
     if (!WebApi.checkCredentials(request)) {
@@ -71,9 +119,132 @@ void WebApiFileClass::onFileGet(AsyncWebServerRequest* request)
             request->send(404);
             return;
         }
+    } else {
+        // The config persists as per-section files; the monolithic
+        // backup document has to be regenerated for the download. It is
+        // staged under the export name on purpose: a monolith at
+        // CONFIG_FILENAME would be re-imported on the next boot,
+        // rolling back every edit made since the download
+        if (!Configuration.writeExportFile()) {
+            request->send(500);
+            return;
+        }
+        requestFile = CONFIG_EXPORT_FILENAME;
     }
 
-    request->send(LittleFS, requestFile, String(), true);
+    File file = LittleFS.open(requestFile, "r");
+    if (!file) {
+        request->send(404);
+        return;
+    }
+
+    const size_t fileSize = file.size();
+    size_t rangeStart = 0;
+    size_t rangeEnd = (fileSize > 0) ? fileSize - 1 : 0;
+    bool isPartial = false;
+
+    if (request->hasHeader("Range")) {
+        if (!parseRangeHeader(request->header("Range"), fileSize, rangeStart, rangeEnd)) {
+            file.close();
+            AsyncWebServerResponse* response = request->beginResponse(416);
+            response->addHeader("Content-Range", "bytes */" + String(fileSize));
+            request->send(response);
+            return;
+        }
+        isPartial = true;
+    }
+
+    auto state = std::make_shared<FileStream>();
+    state->file = std::move(file);
+    state->file.seek(rangeStart);
+    state->remaining = (fileSize > 0) ? rangeEnd - rangeStart + 1 : 0;
+    state->buffer.resize(FILE_STREAM_BUFFER_SIZE);
+
+    request->onDisconnect([state]() {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->aborted = true;
+    });
+
+    // The callback only hands out what the refill task has already
+    // fetched from flash. When the buffer runs dry the response is told
+    // to try again on the next ack/poll, by which time the main loop
+    // has usually refilled it.
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [state](uint8_t* dst, size_t maxLen, size_t index) -> size_t {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->offset < state->fill) {
+                const size_t len = std::min(maxLen, state->fill - state->offset);
+                memcpy(dst, state->buffer.data() + state->offset, len);
+                state->offset += len;
+                return len;
+            }
+            if (state->remaining == 0) {
+                return 0;
+            }
+            return RESPONSE_TRY_AGAIN;
+        });
+
+    if (isPartial) {
+        response->setCode(206);
+        response->addHeader("Content-Range", "bytes " + String(rangeStart) + "-" + String(rangeEnd) + "/" + String(fileSize));
+    }
+    response->addHeader("Accept-Ranges", "bytes");
+    // The staged export still downloads as config.json, so backups
+    // round-trip through the restore upload unchanged
+    String filename = (requestFile == CONFIG_EXPORT_FILENAME) ? String(CONFIG_FILENAME) : requestFile;
+    filename.replace("/", "");
+    response->addHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+
+    {
+        std::lock_guard<std::mutex> lock(_streamsMutex);
+        _streams.push_back(state);
+    }
+    _refillTask.enableIfNot();
+
+    request->send(response);
+}
+
+void WebApiFileClass::refillLoop()
+{
+    std::lock_guard<std::mutex> lockStreams(_streamsMutex);
+
+    for (auto it = _streams.begin(); it != _streams.end();) {
+        bool finished = false;
+        {
+            auto& state = **it;
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.aborted) {
+                finished = true;
+            } else if (state.offset >= state.fill && state.remaining > 0) {
+                const size_t len = state.file.read(state.buffer.data(), std::min(state.buffer.size(), state.remaining));
+                if (len == 0) {
+                    // short read, end the download cleanly
+                    state.remaining = 0;
+                    finished = true;
+                } else {
+                    state.fill = len;
+                    state.offset = 0;
+                    state.remaining -= len;
+                    finished = (state.remaining == 0);
+                }
+            } else {
+                finished = (state.remaining == 0);
+            }
+        }
+
+        // The response callback keeps its own reference, so erasing
+        // here only stops refilling - buffered data stays valid until
+        // the response is destroyed.
+        if (finished) {
+            it = _streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (_streams.empty()) {
+        _refillTask.disable();
+    }
 }
 
 void WebApiFileClass::onFileDelete(AsyncWebServerRequest* request)
@@ -83,7 +254,8 @@ void WebApiFileClass::onFileDelete(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -119,7 +291,8 @@ void WebApiFileClass::onFileDeleteAll(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
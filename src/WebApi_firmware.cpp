@@ -5,10 +5,35 @@
 #include "WebApi_firmware.h"
 #include "Configuration.h"
 #include "RestartHelper.h"
+#include "Utils.h"
 #include "WebApi.h"
+#include "WebApi_errors.h"
 #include "helper.h"
 #include <AsyncJson.h>
+#include <HTTPClient.h>
+#include <Hoymiles.h>
 #include <Update.h>
+#include <algorithm>
+#include <esp_heap_caps.h>
+
+#undef TAG
+static const char* TAG = "webapi";
+
+// Double-buffered OTA pipeline: the async_tcp task fills one buffer
+// from the network while the previous one is erased/written by a
+// dedicated writer task, so flash latency no longer stalls the TCP
+// receive window (or the rest of the web server). Buffers must live in
+// internal RAM - flash writes run with the cache disabled and cannot
+// source data from PSRAM.
+#ifndef OTA_FLASH_BUFFER_SIZE
+#define OTA_FLASH_BUFFER_SIZE 16384
+#endif
+
+// Upper bound for any single wait between the two ends of the
+// pipeline; whoever hits it declares the transfer dead
+#ifndef OTA_FLASH_TIMEOUT_MS
+#define OTA_FLASH_TIMEOUT_MS 30000
+#endif
 
 void WebApiFirmwareClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
@@ -22,6 +47,12 @@ void WebApiFirmwareClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/firmware/update", HTTP_POST,
         std::bind(&WebApiFirmwareClass::onFirmwareUpdateFinish, this, _1),
         std::bind(&WebApiFirmwareClass::onFirmwareUpdateUpload, this, _1, _2, _3, _4, _5, _6));
+
+    // OTA pull: the device streams the image itself off a URL, so an
+    // orchestration tool can upgrade many devices in parallel from one
+    // HTTP server and poll per-device progress
+    server.on("/api/firmware/update_url", HTTP_POST, std::bind(&WebApiFirmwareClass::onFirmwareUpdateUrl, this, _1));
+    server.on("/api/firmware/status", HTTP_GET, std::bind(&WebApiFirmwareClass::onFirmwareUpdateStatus, this, _1));
 }
 
 void WebApiFirmwareClass::onFirmwareUpdateFinish(AsyncWebServerRequest* request)
@@ -48,10 +79,21 @@ void WebApiFirmwareClass::onFirmwareUpdateUpload(AsyncWebServerRequest* request,
 
     // Upload handler chunks in data
     if (!index) {
+        if (_pullActive) {
+            return request->send(409, "text/plain", "OTA pull in progress");
+        }
+
         if (!request->hasParam("MD5", true)) {
             return request->send(400, "text/plain", "MD5 parameter missing");
         }
 
+        // Reclaim the pipeline of an upload that died mid-flight
+        abortFlashPipeline();
+
+        // No new RF exchange while flash writes run with the cache
+        // disabled; an in-flight one drains before the first erase
+        Hoymiles.suspendPolling();
+
         if (!Update.setMD5(request->getParam("MD5", true)->value().c_str())) {
             return request->send(400, "text/plain", "MD5 parameter invalid");
         }
@@ -60,21 +102,401 @@ void WebApiFirmwareClass::onFirmwareUpdateUpload(AsyncWebServerRequest* request,
             Update.printError(Serial);
             return request->send(400, "text/plain", "OTA could not begin");
         }
-    }
 
-    // Write chunked data to the free sketch space
-    if (len) {
-        if (Update.write(data, len) != len) {
-            return request->send(400, "text/plain", "OTA could not begin");
+        if (!startFlashPipeline()) {
+            Update.abort();
+            return request->send(500, "text/plain", "OTA pipeline could not start");
         }
+
+        ESP_LOGI(TAG, "OTA started: %s", filename.c_str());
+    }
+
+    if (!_pipelineActive) {
+        // begin failed; drain the remaining chunks of this upload
+        return;
     }
 
+    // Stage chunked data into the fill buffer; full buffers travel to
+    // the writer task while the network keeps streaming into the other
+    stageData(data, len);
+
     if (final) { // if the final flag is set then this is the last frame of data
+        // Hand over the remainder and wait for the writer to drain,
+        // verify the MD5 and finalize the partition
+        if (!submitFillBuffer(true) || xSemaphoreTake(_flashDone, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "OTA flash writer did not finish");
+            Update.abort();
+        }
+        stopFlashPipeline();
+        // success or failure is reported by onFirmwareUpdateFinish via
+        // Update.hasError()
+    }
+}
+
+bool WebApiFirmwareClass::startFlashPipeline()
+{
+    _freeQueue = xQueueCreate(2, sizeof(uint8_t*));
+    _workQueue = xQueueCreate(2, sizeof(FlashChunk));
+    _flashDone = xSemaphoreCreateBinary();
+    for (auto& buffer : _buffers) {
+        buffer = static_cast<uint8_t*>(heap_caps_malloc(OTA_FLASH_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+
+    if (_freeQueue == nullptr || _workQueue == nullptr || _flashDone == nullptr
+        || _buffers[0] == nullptr || _buffers[1] == nullptr) {
+        stopFlashPipeline();
+        return false;
+    }
+
+    for (auto& buffer : _buffers) {
+        xQueueSend(_freeQueue, &buffer, 0);
+    }
+
+    _fillBuffer = nullptr;
+    _fillLen = 0;
+    _flashError = false;
+
+    if (xTaskCreate(flashWriterTask, "otaFlash", 4096, this, 2, nullptr) != pdPASS) {
+        stopFlashPipeline();
+        return false;
+    }
+
+    _pipelineActive = true;
+    return true;
+}
+
+void WebApiFirmwareClass::stopFlashPipeline()
+{
+    _pipelineActive = false;
+    Hoymiles.resumePolling();
+
+    if (_freeQueue != nullptr) {
+        vQueueDelete(_freeQueue);
+        _freeQueue = nullptr;
+    }
+    if (_workQueue != nullptr) {
+        vQueueDelete(_workQueue);
+        _workQueue = nullptr;
+    }
+    if (_flashDone != nullptr) {
+        vSemaphoreDelete(_flashDone);
+        _flashDone = nullptr;
+    }
+    for (auto& buffer : _buffers) {
+        heap_caps_free(buffer);
+        buffer = nullptr;
+    }
+    _fillBuffer = nullptr;
+    _fillLen = 0;
+}
+
+void WebApiFirmwareClass::abortFlashPipeline()
+{
+    if (!_pipelineActive) {
+        return;
+    }
+
+    // Wake the writer so it aborts the stale Update handle and exits,
+    // then tear the queues down
+    _flashError = true;
+    submitFillBuffer(true);
+    xSemaphoreTake(_flashDone, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS));
+    stopFlashPipeline();
+}
+
+bool WebApiFirmwareClass::stageData(const uint8_t* data, size_t len)
+{
+    size_t offset = 0;
+    while (offset < len && !_flashError) {
+        if (_fillBuffer == nullptr) {
+            if (xQueueReceive(_freeQueue, &_fillBuffer, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS)) != pdTRUE) {
+                ESP_LOGE(TAG, "OTA flash writer stalled");
+                _flashError = true;
+                break;
+            }
+            _fillLen = 0;
+        }
+
+        const size_t take = std::min(len - offset, static_cast<size_t>(OTA_FLASH_BUFFER_SIZE) - _fillLen);
+        memcpy(_fillBuffer + _fillLen, data + offset, take);
+        _fillLen += take;
+        offset += take;
+
+        if (_fillLen == OTA_FLASH_BUFFER_SIZE && !submitFillBuffer(false)) {
+            _flashError = true;
+        }
+    }
+    return !_flashError;
+}
+
+bool WebApiFirmwareClass::submitFillBuffer(const bool final)
+{
+    FlashChunk chunk = {
+        .data = _fillBuffer,
+        .len = _fillLen,
+        .final = final,
+    };
+    _fillBuffer = nullptr;
+    _fillLen = 0;
+    return xQueueSend(_workQueue, &chunk, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS)) == pdTRUE;
+}
+
+void WebApiFirmwareClass::flashWriterTask(void* arg)
+{
+    WebApiFirmwareClass* const instance = static_cast<WebApiFirmwareClass*>(arg);
+
+    bool final = false;
+    while (!final) {
+        FlashChunk chunk;
+        if (xQueueReceive(instance->_workQueue, &chunk, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS)) != pdTRUE) {
+            // the uploader went away; bail out so the next upload can
+            // reclaim the pipeline
+            instance->_flashError = true;
+            break;
+        }
+
+        if (chunk.len > 0 && !instance->_flashError) {
+            if (Update.write(chunk.data, chunk.len) != chunk.len) {
+                Update.printError(Serial);
+                instance->_flashError = true;
+            }
+        }
+
+        if (chunk.data != nullptr) {
+            xQueueSend(instance->_freeQueue, &chunk.data, 0);
+        }
+        final = chunk.final;
+    }
+
+    if (final && !instance->_flashError) {
         if (!Update.end(true)) { // true to set the size to the current progress
             Update.printError(Serial);
-            return request->send(400, "text/plain", "Could not end OTA");
+        } else {
+            ESP_LOGI(TAG, "OTA flash complete");
         }
     } else {
+        Update.abort();
+    }
+
+    xSemaphoreGive(instance->_flashDone);
+    vTaskDelete(nullptr);
+}
+
+void WebApiFirmwareClass::onFirmwareUpdateUrl(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
         return;
     }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
+    if (!WebApi.parseRequestData(request, response, root)) {
+        return;
+    }
+
+    auto& retMsg = response->getRoot();
+
+    if (!(root["url"].is<String>())
+        || !(root["md5"].is<String>())) {
+        retMsg["message"] = "Values are missing!";
+        retMsg["code"] = WebApiError::GenericValueMissing;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    const String url = root["url"].as<String>();
+    if (!url.startsWith("http://") && !url.startsWith("https://")) {
+        retMsg["message"] = "URL must start with http:// or https://!";
+        retMsg["code"] = WebApiError::FirmwarePullUrlInvalid;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    if (root["md5"].as<String>().length() != 32) {
+        retMsg["message"] = "MD5 parameter invalid!";
+        retMsg["code"] = WebApiError::FirmwarePullUrlInvalid;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    if (_pullActive || _pipelineActive) {
+        retMsg["message"] = "Firmware update already in progress!";
+        retMsg["code"] = WebApiError::FirmwarePullBusy;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    // _pullUrl/_pullMd5 are only touched here while no pull task runs
+    _pullUrl = url;
+    _pullMd5 = root["md5"].as<String>();
+    _pullError = "";
+    _pullBytesFetched = 0;
+    _pullBytesTotal = -1;
+    _pullState = PullState::Downloading;
+    _pullActive = true;
+
+    if (xTaskCreate(pullTask, "otaPull", 6144, this, 2, nullptr) != pdPASS) {
+        _pullState = PullState::Failed;
+        _pullError = "Task could not start";
+        _pullActive = false;
+        retMsg["message"] = "OTA pull could not start!";
+        retMsg["code"] = WebApiError::FirmwarePullBusy;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    ESP_LOGI(TAG, "OTA pull started: %s", url.c_str());
+
+    retMsg["type"] = "success";
+    retMsg["message"] = "OTA pull started!";
+    retMsg["code"] = WebApiError::FirmwarePullStarted;
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiFirmwareClass::onFirmwareUpdateStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["pull_state"] = pullStateName(_pullState);
+    root["pull_bytes_fetched"] = _pullBytesFetched.load();
+    root["pull_bytes_total"] = _pullBytesTotal.load();
+    root["pull_error"] = _pullError;
+    root["upload_active"] = _pipelineActive;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiFirmwareClass::pullTask(void* arg)
+{
+    WebApiFirmwareClass* const instance = static_cast<WebApiFirmwareClass*>(arg);
+
+    // Same flash pipeline as the upload path, fed from an HTTP stream
+    // instead of the async_tcp callback; this task takes the fill role
+    const String error = instance->runPull();
+
+    if (error.isEmpty()) {
+        instance->_pullState = PullState::Success;
+        ESP_LOGI(TAG, "OTA pull complete");
+        RestartHelper.triggerRestart();
+    } else {
+        instance->_pullError = error;
+        instance->_pullState = PullState::Failed;
+        ESP_LOGE(TAG, "OTA pull failed: %s", error.c_str());
+    }
+
+    instance->_pullActive = false;
+    vTaskDelete(nullptr);
+}
+
+String WebApiFirmwareClass::runPull()
+{
+    HTTPClient http;
+    http.setTimeout(OTA_FLASH_TIMEOUT_MS);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    if (!http.begin(_pullUrl)) {
+        return "URL could not be parsed";
+    }
+
+    const int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        http.end();
+        return String("HTTP error ") + httpCode;
+    }
+
+    _pullBytesTotal = http.getSize();
+
+    // No new RF exchange while flash writes run with the cache
+    // disabled; an in-flight one drains before the first erase
+    Hoymiles.suspendPolling();
+
+    if (!Update.setMD5(_pullMd5.c_str())) {
+        Hoymiles.resumePolling();
+        http.end();
+        return "MD5 parameter invalid";
+    }
+
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+        Update.printError(Serial);
+        Hoymiles.resumePolling();
+        http.end();
+        return "OTA could not begin";
+    }
+
+    if (!startFlashPipeline()) {
+        Update.abort();
+        http.end();
+        return "OTA pipeline could not start";
+    }
+
+    WiFiClient* const stream = http.getStreamPtr();
+    uint8_t chunk[1024];
+    int remaining = _pullBytesTotal;
+    uint32_t lastData = millis();
+
+    while (http.connected() && remaining != 0 && !_flashError) {
+        const size_t available = stream->available();
+        if (available == 0) {
+            if (millis() - lastData > OTA_FLASH_TIMEOUT_MS) {
+                _flashError = true;
+            }
+            delay(1);
+            continue;
+        }
+
+        const int read = stream->readBytes(chunk, std::min(available, sizeof(chunk)));
+        if (read <= 0) {
+            continue;
+        }
+        lastData = millis();
+
+        stageData(chunk, read);
+        _pullBytesFetched += read;
+        if (remaining > 0) {
+            remaining -= read;
+        }
+    }
+
+    if (remaining > 0 && !_flashError) {
+        // the server closed the connection short of Content-Length
+        _flashError = true;
+    }
+
+    _pullState = PullState::Finishing;
+
+    // Hand over the remainder and wait for the writer to drain, verify
+    // the MD5 and finalize the partition
+    if (!submitFillBuffer(true) || xSemaphoreTake(_flashDone, pdMS_TO_TICKS(OTA_FLASH_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "OTA flash writer did not finish");
+        Update.abort();
+    }
+    stopFlashPipeline();
+    http.end();
+
+    if (Update.hasError()) {
+        return "Download incomplete or image could not be flashed";
+    }
+    return "";
+}
+
+const char* WebApiFirmwareClass::pullStateName(const PullState state)
+{
+    switch (state) {
+    case PullState::Idle:
+        return "idle";
+    case PullState::Downloading:
+        return "downloading";
+    case PullState::Finishing:
+        return "finishing";
+    case PullState::Success:
+        return "success";
+    case PullState::Failed:
+        return "failed";
+    }
+    return "unknown";
 }
@@ -13,6 +13,7 @@ void WebApiGridProfileClass::init(AsyncWebServer& server, Scheduler& scheduler)
 
     server.on("/api/gridprofile/status", HTTP_GET, std::bind(&WebApiGridProfileClass::onGridProfileStatus, this, _1));
     server.on("/api/gridprofile/rawdata", HTTP_GET, std::bind(&WebApiGridProfileClass::onGridProfileRawdata, this, _1));
+    server.on("/api/gridprofile/rawdata.bin", HTTP_GET, std::bind(&WebApiGridProfileClass::onGridProfileRawdataBin, this, _1));
 }
 
 void WebApiGridProfileClass::onGridProfileStatus(AsyncWebServerRequest* request)
@@ -21,11 +22,22 @@ void WebApiGridProfileClass::onGridProfileStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
-    auto& root = response->getRoot();
     auto serial = WebApi.parseSerialFromRequest(request);
     auto inv = Hoymiles.getInverterBySerial(serial);
 
+    // The profile only changes when a new grid profile response is
+    // parsed, so its timestamp fully versions the payload
+    String etag;
+    if (inv != nullptr) {
+        etag = "\"gp-" + inv->serialString() + "-" + String(inv->GridProfile()->getLastUpdate()) + "\"";
+        if (WebApi.checkETag(request, etag)) {
+            return;
+        }
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
     if (inv != nullptr) {
         root["name"] = inv->GridProfile()->getProfileName();
         root["version"] = inv->GridProfile()->getProfileVersion();
@@ -47,6 +59,9 @@ void WebApiGridProfileClass::onGridProfileStatus(AsyncWebServerRequest* request)
                 jsonItem["v"] = profItem.Value;
             }
         }
+
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__, etag);
+        return;
     }
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
@@ -58,17 +73,59 @@ void WebApiGridProfileClass::onGridProfileRawdata(AsyncWebServerRequest* request
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
-    auto& root = response->getRoot();
     auto serial = WebApi.parseSerialFromRequest(request);
     auto inv = Hoymiles.getInverterBySerial(serial);
 
+    String etag;
+    if (inv != nullptr) {
+        etag = "\"gpr-" + inv->serialString() + "-" + String(inv->GridProfile()->getLastUpdate()) + "\"";
+        if (WebApi.checkETag(request, etag)) {
+            return;
+        }
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
     if (inv != nullptr) {
         auto raw = root["raw"].to<JsonArray>();
         auto data = inv->GridProfile()->getRawData();
 
         copyArray(&data[0], data.size(), raw);
+
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__, etag);
+        return;
     }
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
+
+void WebApiGridProfileClass::onGridProfileRawdataBin(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    auto serial = WebApi.parseSerialFromRequest(request);
+    auto inv = Hoymiles.getInverterBySerial(serial);
+
+    if (inv == nullptr) {
+        request->send(404);
+        return;
+    }
+
+    const String etag = "\"gpb-" + inv->serialString() + "-" + String(inv->GridProfile()->getLastUpdate()) + "\"";
+    if (WebApi.checkETag(request, etag)) {
+        return;
+    }
+
+    // Export path for provisioning tooling: one snapshot copy out of
+    // the parser buffer, handed out verbatim - no JsonDocument and no
+    // per-byte array rendering like the JSON path above, which stays
+    // for the web UI
+    const auto data = inv->GridProfile()->getRawData();
+
+    AsyncWebServerResponse* response = request->beginResponse(200, "application/octet-stream", data.data(), data.size());
+    response->addHeader("ETag", etag);
+    request->send(response);
+}
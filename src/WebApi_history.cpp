@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_history.h"
+#include "WebApi.h"
+#include <AsyncJson.h>
+#include <Hoymiles.h>
+#include <parser/Timeseries.h>
+
+void WebApiHistoryClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/history/status", HTTP_GET, std::bind(&WebApiHistoryClass::onHistoryStatus, this, _1));
+    server.on("/api/history/data", HTTP_GET, std::bind(&WebApiHistoryClass::onHistoryData, this, _1));
+}
+
+void WebApiHistoryClass::onHistoryStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+    auto serial = WebApi.parseSerialFromRequest(request);
+    auto inv = Hoymiles.getInverterBySerial(serial);
+
+    if (inv != nullptr) {
+        auto seriesArray = root["series"].to<JsonArray>();
+
+        uint8_t idx = 0;
+        for (auto& series : inv->Statistics()->getTimeseries()) {
+            auto seriesObject = seriesArray.add<JsonObject>();
+            seriesObject["id"] = idx++;
+            seriesObject["type"] = inv->Statistics()->getChannelTypeName(series->getChannelType());
+            seriesObject["channel"] = static_cast<uint8_t>(series->getChannel());
+            seriesObject["field"] = fields[series->getFieldId()];
+            seriesObject["interval"] = series->getSampleInterval();
+            seriesObject["capacity"] = series->getCapacity();
+            seriesObject["count"] = series->getSampleCount();
+        }
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiHistoryClass::onHistoryData(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    auto serial = WebApi.parseSerialFromRequest(request);
+    auto inv = Hoymiles.getInverterBySerial(serial);
+    if (inv == nullptr) {
+        request->send(404);
+        return;
+    }
+
+    size_t seriesIdx = 0;
+    if (request->hasParam("series")) {
+        seriesIdx = request->getParam("series")->value().toInt();
+    }
+
+    uint32_t since = 0;
+    if (request->hasParam("since")) {
+        since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    }
+
+    const auto& allSeries = inv->Statistics()->getTimeseries();
+    if (seriesIdx >= allSeries.size()) {
+        request->send(404);
+        return;
+    }
+    auto series = allSeries[seriesIdx];
+
+    // The requested window is copied into one contiguous buffer and
+    // streamed out as packed {uint32 timestamp, float value} records
+    auto buffer = std::make_shared<std::vector<timeseriesSample_t>>(series->getSampleCount());
+    const size_t count = series->copySamples(buffer->data(), buffer->size(), since);
+    const size_t totalLen = count * sizeof(timeseriesSample_t);
+
+    AsyncWebServerResponse* response = request->beginResponse("application/octet-stream", totalLen,
+        [buffer, totalLen](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+            const size_t len = min(maxLen, totalLen - index);
+            memcpy(out, reinterpret_cast<const uint8_t*>(buffer->data()) + index, len);
+            return len;
+        });
+    request->send(response);
+}
@@ -4,7 +4,6 @@
  */
 #include "WebApi_i18n.h"
 #include "I18n.h"
-#include "Utils.h"
 #include "WebApi.h"
 #include <AsyncJson.h>
 #include <LittleFS.h>
@@ -38,15 +37,12 @@ void WebApiI18nClass::onI18nLanguage(AsyncWebServerRequest* request)
     if (request->hasParam("code")) {
         String code = request->getParam("code")->value();
 
-        String filename = I18n.getFilenameByLocale(code);
+        const LanguageInfo_t* info = I18n.getLanguageInfoByLocale(code);
 
-        if (filename != "") {
-            String md5 = Utils::generateMd5FromFile(filename);
-
-            String expectedEtag;
-            expectedEtag = "\"";
-            expectedEtag += md5;
-            expectedEtag += "\"";
+        if (info != nullptr) {
+            // ETag was hashed once at pack scan time; conditional
+            // requests never touch the filesystem
+            const String& expectedEtag = info->etag;
 
             bool eTagMatch = false;
             if (request->hasHeader("If-None-Match")) {
@@ -59,7 +55,7 @@ void WebApiI18nClass::onI18nLanguage(AsyncWebServerRequest* request)
             if (eTagMatch) {
                 response = request->beginResponse(304);
             } else {
-                response = request->beginResponse(LittleFS, filename, asyncsrv::T_application_json);
+                response = request->beginResponse(LittleFS, info->filename, asyncsrv::T_application_json);
             }
 
             // HTTP requires cache headers in 200 and 304 to be identical
@@ -4,7 +4,7 @@
  */
 #include "WebApi_inverter.h"
 #include "Configuration.h"
-#include "MqttHandleHass.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "defaults.h"
@@ -22,6 +22,7 @@ void WebApiInverterClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/inverter/del", HTTP_POST, std::bind(&WebApiInverterClass::onInverterDelete, this, _1));
     server.on("/api/inverter/order", HTTP_POST, std::bind(&WebApiInverterClass::onInverterOrder, this, _1));
     server.on("/api/inverter/stats_reset", HTTP_GET, std::bind(&WebApiInverterClass::onInverterStatReset, this, _1));
+    server.on("/api/inverter/health", HTTP_GET, std::bind(&WebApiInverterClass::onInverterHealth, this, _1));
 }
 
 void WebApiInverterClass::onInverterList(AsyncWebServerRequest* request)
@@ -89,7 +90,8 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -146,10 +148,11 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
     if (inv != nullptr) {
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setStringMaxPower(c, inverter->channel[c].MaxChannelPower);
+            inv->Statistics()->setChannelName(c, inverter->channel[c].Name);
         }
     }
 
-    MqttHandleHass.forceUpdate();
+    Configuration.notifyConfigChanged(ConfigScope::Inverter);
 }
 
 void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
@@ -159,7 +162,8 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -270,10 +274,11 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setStringMaxPower(c, inverter.channel[c].MaxChannelPower);
             inv->Statistics()->setChannelFieldOffset(TYPE_DC, static_cast<ChannelNum_t>(c), FLD_YT, inverter.channel[c].YieldTotalOffset);
+            inv->Statistics()->setChannelName(c, inverter.channel[c].Name);
         }
     }
 
-    MqttHandleHass.forceUpdate();
+    Configuration.notifyConfigChanged(ConfigScope::Inverter);
 }
 
 void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
@@ -283,7 +288,8 @@ void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -315,7 +321,7 @@ void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
-    MqttHandleHass.forceUpdate();
+    Configuration.notifyConfigChanged(ConfigScope::Inverter);
 }
 
 void WebApiInverterClass::onInverterOrder(AsyncWebServerRequest* request)
@@ -325,7 +331,8 @@ void WebApiInverterClass::onInverterOrder(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -381,3 +388,45 @@ void WebApiInverterClass::onInverterStatReset(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
+
+void WebApiInverterClass::onInverterHealth(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+    JsonArray data = root["inverter"].to<JsonArray>();
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+
+        JsonObject obj = data.add<JsonObject>();
+        obj["serial"] = inv->serialString();
+        obj["name"] = inv->name();
+        obj["reachable"] = inv->isReachable();
+        obj["warm_start"] = inv->Statistics()->isWarmStart();
+
+        // Rolling figures maintained incrementally by the radio layer
+        obj["success_rate"] = 1.0f - inv->getLossRateEwma();
+        obj["exchange_duration_ms"] = inv->getExchangeDurationEwma();
+        obj["rssi"] = inv->getLastRssi();
+        obj["rssi_ewma"] = inv->getRssiEwma();
+        obj["rssi_trend"] = inv->getRssiTrend();
+        obj["activity"] = inv->getActivityEwma();
+
+        // Lifetime counters, same source as the radio_stats view
+        obj["tx_requests"] = inv->RadioStats.TxRequestData;
+        obj["rx_success"] = inv->RadioStats.RxSuccess;
+        obj["rx_fail_no_answer"] = inv->RadioStats.RxFailNoAnswer;
+        obj["rx_fail_partial"] = inv->RadioStats.RxFailPartialAnswer;
+        obj["rx_fail_corrupt"] = inv->RadioStats.RxFailCorruptData;
+        obj["retransmits"] = inv->RadioStats.TxReRequestFragment;
+        obj["retransmit_ratio"] = inv->RadioStats.TxRequestData > 0
+            ? static_cast<float>(inv->RadioStats.TxReRequestFragment) / inv->RadioStats.TxRequestData
+            : 0.0f;
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
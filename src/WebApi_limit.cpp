@@ -3,6 +3,7 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_limit.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "defaults.h"
@@ -10,12 +11,19 @@
 #include <AsyncJson.h>
 #include <Hoymiles.h>
 
+WebApiLimitClass::WebApiLimitClass()
+    : _intakeTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&WebApiLimitClass::intakeLoop, this))
+{
+}
+
 void WebApiLimitClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
 
     server.on("/api/limit/status", HTTP_GET, std::bind(&WebApiLimitClass::onLimitStatus, this, _1));
     server.on("/api/limit/config", HTTP_POST, std::bind(&WebApiLimitClass::onLimitPost, this, _1));
+
+    scheduler.addTask(_intakeTask);
 }
 
 void WebApiLimitClass::onLimitStatus(AsyncWebServerRequest* request)
@@ -45,6 +53,35 @@ void WebApiLimitClass::onLimitStatus(AsyncWebServerRequest* request)
             limitStatus = "Pending";
         }
         root[serial]["limit_set_status"] = limitStatus;
+
+        std::lock_guard<std::mutex> lock(_intakeMutex);
+        auto ticket = _lastTicket.find(inv->serial());
+        if (ticket != _lastTicket.end()) {
+            root[serial]["ticket"] = ticket->second.ticket;
+            String ticketStatus = "Queued";
+            if (ticket->second.state == TicketState::Submitted) {
+                ticketStatus = "Submitted";
+            } else if (ticket->second.state == TicketState::Rejected) {
+                ticketStatus = "Rejected";
+            }
+            root[serial]["ticket_status"] = ticketStatus;
+
+            // Per-command completion and measured actuation latency,
+            // for controllers tuning their loop against real timing
+            if (ticket->second.result != nullptr) {
+                const auto& result = *ticket->second.result;
+                String resultStatus = "Pending";
+                if (result.status == CMD_OK) {
+                    resultStatus = "Ok";
+                } else if (result.status == CMD_NOK) {
+                    resultStatus = "Failure";
+                }
+                root[serial]["ticket_result"] = resultStatus;
+                if (result.status != CMD_PENDING) {
+                    root[serial]["ticket_latency_ms"] = result.latencyMs();
+                }
+            }
+        }
     }
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
@@ -57,7 +94,8 @@ void WebApiLimitClass::onLimitPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -113,11 +151,47 @@ void WebApiLimitClass::onLimitPost(AsyncWebServerRequest* request)
         return;
     }
 
-    inv->sendActivePowerControlRequest(limit, type);
+    // Only acknowledge intake here. The command is handed to the
+    // inverter by the intake task on the main loop, so the HTTP
+    // round-trip stays independent of the radio exchange.
+    uint32_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(_intakeMutex);
+        ticket = _nextTicket++;
+        _intake.push_back({ ticket, serial, limit, type });
+        _lastTicket[serial] = { ticket, TicketState::Queued };
+    }
+    _intakeTask.enableIfNot();
 
     retMsg["type"] = "success";
     retMsg["message"] = "Settings saved!";
     retMsg["code"] = WebApiError::GenericSuccess;
+    retMsg["ticket"] = ticket;
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
+
+void WebApiLimitClass::intakeLoop()
+{
+    std::unique_lock<std::mutex> lock(_intakeMutex);
+
+    while (!_intake.empty()) {
+        const LimitOrder order = _intake.front();
+        _intake.pop_front();
+
+        // Submit without holding the intake lock so a slow command
+        // queue cannot back up onLimitPost.
+        lock.unlock();
+        auto inv = Hoymiles.getInverterBySerial(order.serial);
+        const bool submitted = (inv != nullptr) && inv->sendActivePowerControlRequest(order.limit, order.type);
+        lock.lock();
+
+        auto ticket = _lastTicket.find(order.serial);
+        if (ticket != _lastTicket.end() && ticket->second.ticket == order.ticket) {
+            ticket->second.state = submitted ? TicketState::Submitted : TicketState::Rejected;
+            ticket->second.result = submitted ? inv->getLastControlCommandResult() : nullptr;
+        }
+    }
+
+    _intakeTask.disable();
+}
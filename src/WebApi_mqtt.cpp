@@ -4,9 +4,9 @@
  */
 #include "WebApi_mqtt.h"
 #include "Configuration.h"
-#include "MqttHandleHass.h"
 #include "MqttHandleInverter.h"
 #include "MqttSettings.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
@@ -17,6 +17,7 @@ void WebApiMqttClass::init(AsyncWebServer& server, Scheduler& scheduler)
     using std::placeholders::_1;
 
     server.on("/api/mqtt/status", HTTP_GET, std::bind(&WebApiMqttClass::onMqttStatus, this, _1));
+    server.on("/api/mqtt/stats", HTTP_GET, std::bind(&WebApiMqttClass::onMqttStats, this, _1));
     server.on("/api/mqtt/config", HTTP_GET, std::bind(&WebApiMqttClass::onMqttAdminGet, this, _1));
     server.on("/api/mqtt/config", HTTP_POST, std::bind(&WebApiMqttClass::onMqttAdminPost, this, _1));
 }
@@ -45,7 +46,11 @@ void WebApiMqttClass::onMqttStatus(AsyncWebServerRequest* request)
     root["mqtt_client_cert_info"] = getTlsCertInfo(config.Mqtt.Tls.ClientCert);
     root["mqtt_lwt_topic"] = String(config.Mqtt.Topic) + config.Mqtt.Lwt.Topic;
     root["mqtt_publish_interval"] = config.Mqtt.PublishInterval;
+    root["mqtt_full_publish_interval"] = config.Mqtt.FullPublishInterval;
     root["mqtt_clean_session"] = config.Mqtt.CleanSession;
+    root["mqtt_compact_json"] = config.Mqtt.CompactJson;
+    root["mqtt_compact_json_compress"] = config.Mqtt.CompactJsonCompress;
+    root["mqtt_limit_coalesce_window"] = config.Mqtt.LimitCoalesceWindow;
     root["mqtt_hass_enabled"] = config.Mqtt.Hass.Enabled;
     root["mqtt_hass_expire"] = config.Mqtt.Hass.Expire;
     root["mqtt_hass_retain"] = config.Mqtt.Hass.Retain;
@@ -55,6 +60,41 @@ void WebApiMqttClass::onMqttStatus(AsyncWebServerRequest* request)
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
 
+void WebApiMqttClass::onMqttStats(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+    const auto& stats = MqttSettings.getPublishStats();
+
+    root["connected"] = MqttSettings.getConnected();
+    root["connects"] = stats.connects.load();
+    root["disconnects"] = stats.disconnects.load();
+    root["deferred"] = stats.deferred.load();
+
+    static constexpr const char* prioNames[3] = { "critical", "control", "telemetry" };
+    for (uint8_t prio = 0; prio < 3; prio++) {
+        JsonObject obj = root[prioNames[prio]].to<JsonObject>();
+        obj["published"] = stats.published[prio].load();
+        obj["coalesced"] = stats.coalesced[prio].load();
+        obj["dropped"] = stats.dropped[prio].load();
+        obj["outbox_depth"] = stats.outboxDepth[prio].load();
+    }
+
+    JsonObject latency = root["latency_ms"].to<JsonObject>();
+    for (uint8_t bucket = 0; bucket < 5; bucket++) {
+        latency[String(MqttSettingsClass::PublishStats::latencyBucketBoundsMs[bucket])] = stats.latencyBuckets[bucket].load();
+    }
+    latency["inf"] = stats.latencyBuckets[5].load();
+    latency["sum"] = stats.latencySumMs.load();
+    latency["count"] = stats.latencyCount.load();
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
 void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
 {
     if (!WebApi.checkCredentials(request)) {
@@ -83,7 +123,11 @@ void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
     root["mqtt_lwt_offline"] = config.Mqtt.Lwt.Value_Offline;
     root["mqtt_lwt_qos"] = config.Mqtt.Lwt.Qos;
     root["mqtt_publish_interval"] = config.Mqtt.PublishInterval;
+    root["mqtt_full_publish_interval"] = config.Mqtt.FullPublishInterval;
     root["mqtt_clean_session"] = config.Mqtt.CleanSession;
+    root["mqtt_compact_json"] = config.Mqtt.CompactJson;
+    root["mqtt_compact_json_compress"] = config.Mqtt.CompactJsonCompress;
+    root["mqtt_limit_coalesce_window"] = config.Mqtt.LimitCoalesceWindow;
     root["mqtt_hass_enabled"] = config.Mqtt.Hass.Enabled;
     root["mqtt_hass_expire"] = config.Mqtt.Hass.Expire;
     root["mqtt_hass_retain"] = config.Mqtt.Hass.Retain;
@@ -100,7 +144,8 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -124,7 +169,10 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             && root["mqtt_lwt_offline"].is<String>()
             && root["mqtt_lwt_qos"].is<uint8_t>()
             && root["mqtt_publish_interval"].is<uint32_t>()
+            && root["mqtt_full_publish_interval"].is<uint32_t>()
             && root["mqtt_clean_session"].is<bool>()
+            && root["mqtt_compact_json"].is<bool>()
+            && root["mqtt_limit_coalesce_window"].is<uint32_t>()
             && root["mqtt_hass_enabled"].is<bool>()
             && root["mqtt_hass_expire"].is<bool>()
             && root["mqtt_hass_retain"].is<bool>()
@@ -253,6 +301,24 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             return;
         }
 
+        if (root["mqtt_full_publish_interval"].as<uint32_t>() < 5 || root["mqtt_full_publish_interval"].as<uint32_t>() > 65535) {
+            retMsg["message"] = "Full publish interval must be a number between 5 and 65535!";
+            retMsg["code"] = WebApiError::MqttFullPublishInterval;
+            retMsg["param"]["min"] = 5;
+            retMsg["param"]["max"] = 65535;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
+        if (root["mqtt_limit_coalesce_window"].as<uint32_t>() > 60000) {
+            retMsg["message"] = "Limit coalesce window must be a number between 0 and 60000!";
+            retMsg["code"] = WebApiError::MqttLimitCoalesceWindow;
+            retMsg["param"]["min"] = 0;
+            retMsg["param"]["max"] = 60000;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
         if (root["mqtt_hass_enabled"].as<bool>()) {
             if (root["mqtt_hass_topic"].as<String>().length() > MQTT_MAX_TOPIC_STRLEN) {
                 retMsg["message"] = "Hass topic must not be longer than " STR(MQTT_MAX_TOPIC_STRLEN) " characters!";
@@ -292,7 +358,11 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
         strlcpy(config.Mqtt.Lwt.Value_Offline, root["mqtt_lwt_offline"].as<String>().c_str(), sizeof(config.Mqtt.Lwt.Value_Offline));
         config.Mqtt.Lwt.Qos = root["mqtt_lwt_qos"].as<uint8_t>();
         config.Mqtt.PublishInterval = root["mqtt_publish_interval"].as<uint32_t>();
+        config.Mqtt.FullPublishInterval = root["mqtt_full_publish_interval"].as<uint32_t>();
         config.Mqtt.CleanSession = root["mqtt_clean_session"].as<bool>();
+        config.Mqtt.CompactJson = root["mqtt_compact_json"].as<bool>();
+        config.Mqtt.CompactJsonCompress = root["mqtt_compact_json_compress"].as<bool>();
+        config.Mqtt.LimitCoalesceWindow = root["mqtt_limit_coalesce_window"].as<uint32_t>();
         config.Mqtt.Hass.Enabled = root["mqtt_hass_enabled"].as<bool>();
         config.Mqtt.Hass.Expire = root["mqtt_hass_expire"].as<bool>();
         config.Mqtt.Hass.Retain = root["mqtt_hass_retain"].as<bool>();
@@ -311,8 +381,9 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
-    MqttSettings.performReconnect();
-    MqttHandleHass.forceUpdate();
+    // Subscribers decide themselves whether the edit needs a broker
+    // reconnect or just a discovery republish
+    Configuration.notifyConfigChanged(ConfigScope::Mqtt);
 }
 
 String WebApiMqttClass::getTlsCertInfo(const char* cert)
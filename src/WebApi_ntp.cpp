@@ -6,6 +6,7 @@
 #include "Configuration.h"
 #include "NtpSettings.h"
 #include "SunPosition.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
@@ -46,6 +47,11 @@ void WebApiNtpClass::onNtpStatus(AsyncWebServerRequest* request)
     strftime(timeStringBuff, sizeof(timeStringBuff), "%A, %B %d %Y %H:%M:%S", &timeinfo);
     root["ntp_localtime"] = timeStringBuff;
 
+    root["ntp_sync_age"] = NtpSettings.getSecondsSinceSync();
+    root["ntp_drift_valid"] = NtpSettings.hasDriftEstimate();
+    root["ntp_drift_ppm"] = NtpSettings.hasDriftEstimate() ? NtpSettings.getDriftPpm() : 0;
+    root["ntp_estimated_error_ms"] = NtpSettings.getEstimatedErrorMs();
+
     if (SunPosition.sunriseTime(&timeinfo)) {
         strftime(timeStringBuff, sizeof(timeStringBuff), "%A, %B %d %Y %H:%M:%S", &timeinfo);
     } else {
@@ -93,7 +99,8 @@ void WebApiNtpClass::onNtpAdminPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -190,7 +197,8 @@ void WebApiNtpClass::onNtpTimePost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_profiler.h"
+#include "JsonArena.h"
+#include "TaskMonitor.h"
+#include "WebApi.h"
+#include "WebApi_errors.h"
+#include "WebApi_ws_live.h"
+#include <AsyncJson.h>
+#include <CyclePerf.h>
+#include <LockMonitor.h>
+#include <Hoymiles.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Dump format of /api/profiler/samples: this header, then slotCount
+// zero-padded task names of nameLen bytes each, then count sample
+// bytes (slot index per core per tick, cores interleaved in order).
+// Everything is little endian; tools/fold_task_samples.py folds a
+// dump into flamegraph input.
+struct __attribute__((packed)) TaskSampleDumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleIntervalUs;
+    uint32_t coreCount;
+    uint32_t slotCount;
+    uint32_t nameLen;
+    uint32_t count;
+};
+
+static constexpr uint32_t taskSampleDumpMagic = 0x53544F44; // "DOTS"
+static constexpr uint32_t taskSampleDumpVersion = 1;
+
+void WebApiProfilerClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/profiler", HTTP_GET, std::bind(&WebApiProfilerClass::onProfilerStatus, this, _1));
+    server.on("/api/profiler/locks", HTTP_GET, std::bind(&WebApiProfilerClass::onLockReport, this, _1));
+    server.on("/api/profiler/samples", HTTP_GET, std::bind(&WebApiProfilerClass::onSamplesDump, this, _1));
+    server.on("/api/profiler/samples/start", HTTP_POST, std::bind(&WebApiProfilerClass::onSamplesStart, this, _1));
+    server.on("/api/profiler/samples/stop", HTTP_POST, std::bind(&WebApiProfilerClass::onSamplesStop, this, _1));
+    server.on("/api/profiler/jsonbench", HTTP_GET, std::bind(&WebApiProfilerClass::onJsonBench, this, _1));
+}
+
+void WebApiProfilerClass::onProfilerStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    // Bin boundaries are cycle counts; convert with the CPU frequency
+    root["cpu_freq_mhz"] = getCpuFrequencyMhz();
+    root["bin_count"] = CYCLE_PERF_BIN_COUNT;
+
+    auto probesArray = root["probes"].to<JsonArray>();
+    for (size_t i = 0; i < CyclePerfProbe::getProbeCount(); i++) {
+        const auto* probe = CyclePerfProbe::getProbe(i);
+
+        auto probeObject = probesArray.add<JsonObject>();
+        probeObject["name"] = probe->getName();
+        probeObject["count"] = probe->getCount();
+        probeObject["max_cycles"] = probe->getMaxCycles();
+
+        auto binsArray = probeObject["bins"].to<JsonArray>();
+        for (size_t bin = 0; bin < CYCLE_PERF_BIN_COUNT; bin++) {
+            binsArray.add(probe->getBin(bin));
+        }
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiProfilerClass::onLockReport(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    // Empty tables simply mean the build has no instrumented guards
+    root["enabled"] = LOCKMONITOR_ENABLE != 0;
+
+    auto sitesArray = root["sites"].to<JsonArray>();
+    for (size_t i = 0; i < LockMonitorSite::getSiteCount(); i++) {
+        const auto* site = LockMonitorSite::getSite(i);
+
+        auto siteObject = sitesArray.add<JsonObject>();
+        siteObject["lock"] = site->getLockName();
+        siteObject["site"] = site->getSiteName();
+        siteObject["count"] = site->getCount();
+        siteObject["contended"] = site->getContended();
+        siteObject["wait_us_total"] = site->getTotalWaitUs();
+        siteObject["wait_us_max"] = site->getMaxWaitUs();
+        siteObject["hold_us_total"] = site->getTotalHoldUs();
+        siteObject["hold_us_max"] = site->getMaxHoldUs();
+    }
+
+    // An (A, B) edge paired with a (B, A) edge is a lock-order
+    // inversion candidate; the analysis stays on the consumer side
+    auto edgesArray = root["edges"].to<JsonArray>();
+    for (size_t i = 0; i < LockMonitor::getEdgeCount(); i++) {
+        const char* first;
+        const char* second;
+        uint32_t count;
+        if (!LockMonitor::getEdge(i, &first, &second, &count)) {
+            break;
+        }
+
+        auto edgeObject = edgesArray.add<JsonObject>();
+        edgeObject["held"] = first;
+        edgeObject["acquired"] = second;
+        edgeObject["count"] = count;
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiProfilerClass::onSamplesDump(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    // Snapshot the capture; a still-running trace keeps appending, the
+    // dump simply covers what was written up to this point
+    const uint32_t count = TaskMonitor.getTraceBytes();
+    const uint8_t* samples = TaskMonitor.getTraceBuffer();
+
+    // Header and name table are small, prebuild them into one block
+    // the chunk callback can serve alongside the sample buffer
+    std::vector<uint8_t> preamble(sizeof(TaskSampleDumpHeader) + TASK_MONITOR_SLOT_COUNT * configMAX_TASK_NAME_LEN);
+
+    TaskSampleDumpHeader header;
+    header.magic = taskSampleDumpMagic;
+    header.version = taskSampleDumpVersion;
+    header.sampleIntervalUs = TASK_MONITOR_SAMPLE_INTERVAL_US;
+    header.coreCount = portNUM_PROCESSORS;
+    header.slotCount = TASK_MONITOR_SLOT_COUNT;
+    header.nameLen = configMAX_TASK_NAME_LEN;
+    header.count = count;
+    memcpy(preamble.data(), &header, sizeof(header));
+
+    for (size_t s = 0; s < TASK_MONITOR_SLOT_COUNT; s++) {
+        char name[configMAX_TASK_NAME_LEN] = {};
+        TaskMonitor.getSlotTaskName(s, name, sizeof(name));
+        memcpy(preamble.data() + sizeof(header) + s * configMAX_TASK_NAME_LEN, name, configMAX_TASK_NAME_LEN);
+    }
+
+    const size_t totalSize = preamble.size() + count;
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [preamble = std::move(preamble), samples, totalSize](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t written = 0;
+
+            if (index < preamble.size()) {
+                written = std::min(maxLen, preamble.size() - index);
+                memcpy(buffer, preamble.data() + index, written);
+                index += written;
+            }
+
+            if (written < maxLen && index < totalSize) {
+                const size_t chunk = std::min(maxLen - written, totalSize - index);
+                memcpy(buffer + written, samples + (index - preamble.size()), chunk);
+                written += chunk;
+            }
+
+            return written;
+        });
+
+    response->addHeader("Content-Disposition", "attachment; filename=\"tasksamples.bin\"");
+    request->send(response);
+}
+
+void WebApiProfilerClass::onSamplesStart(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+
+    if (!TaskMonitor.startTrace()) {
+        retMsg["message"] = "Failed to allocate sample trace buffer!";
+        retMsg["code"] = WebApiError::GenericInternalServerError;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    retMsg["type"] = "success";
+    retMsg["capacity"] = TASK_MONITOR_TRACE_BYTES;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiProfilerClass::onSamplesStop(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+
+    TaskMonitor.stopTrace();
+
+    retMsg["type"] = "success";
+    retMsg["samples"] = TaskMonitor.getTraceBytes();
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+// --- JSON serialization benchmark -----------------------------------
+
+// Builds the real livedata payload shape for the given inverter, the
+// same composition the websocket frame builder uses
+static void buildLivedataPayload(JsonDocument& doc, std::shared_ptr<InverterAbstract> inv)
+{
+    JsonVariant var = doc.to<JsonVariant>();
+    auto invArray = var["inverters"].to<JsonArray>();
+    auto invObject = invArray.add<JsonObject>();
+
+    WebApiWsLiveClass::generateCommonJsonResponse(var);
+    WebApiWsLiveClass::generateInverterCommonJsonResponse(invObject, inv);
+    WebApiWsLiveClass::generateInverterChannelJsonResponse(invObject, inv);
+}
+
+// Structural copy with floats pre-rounded to three decimals, the
+// "format on the device instead of shipping full precision" strategy
+static void copyRounded(JsonVariant dst, JsonVariantConst src)
+{
+    if (src.is<JsonObjectConst>()) {
+        JsonObject obj = dst.to<JsonObject>();
+        for (JsonPairConst kv : src.as<JsonObjectConst>()) {
+            copyRounded(obj[kv.key()], kv.value());
+        }
+    } else if (src.is<JsonArrayConst>()) {
+        JsonArray arr = dst.to<JsonArray>();
+        for (JsonVariantConst v : src.as<JsonArrayConst>()) {
+            copyRounded(arr.add<JsonVariant>(), v);
+        }
+    } else if (src.is<float>() && !src.is<int>()) {
+        dst.set(serialized(String(src.as<float>(), 3)));
+    } else {
+        dst.set(src);
+    }
+}
+
+// Discards everything; isolates the serializer walk from sink cost
+struct NullPrint : public Print {
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t size) override { return size; }
+};
+
+void WebApiProfilerClass::onJsonBench(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    if (Hoymiles.getNumInverters() == 0) {
+        root["message"] = "No inverter configured, nothing to serialize!";
+        root["code"] = WebApiError::GenericInternalServerError;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    auto inv = Hoymiles.getInverterByPos(0);
+    constexpr int iterations = 10;
+
+    // Build cost: default heap allocator vs bump arena
+    uint32_t buildHeapUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        const uint32_t start = micros();
+        JsonDocument doc;
+        buildLivedataPayload(doc, inv);
+        buildHeapUs += micros() - start;
+    }
+
+    JsonArena arena(8 * 1024);
+    uint32_t buildArenaUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        arena.reset();
+        const uint32_t start = micros();
+        JsonDocument doc(&arena);
+        buildLivedataPayload(doc, inv);
+        buildArenaUs += micros() - start;
+    }
+
+    // Serialization cost on one arena-built document
+    arena.reset();
+    JsonDocument doc(&arena);
+    buildLivedataPayload(doc, inv);
+    const size_t payloadBytes = measureJson(doc);
+
+    std::vector<char> buffer(payloadBytes + 1);
+    uint32_t serializeBufferUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        const uint32_t start = micros();
+        serializeJson(doc, buffer.data(), buffer.size());
+        serializeBufferUs += micros() - start;
+    }
+
+    uint32_t serializeStringUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        String out;
+        const uint32_t start = micros();
+        serializeJson(doc, out);
+        serializeStringUs += micros() - start;
+    }
+
+    NullPrint sink;
+    uint32_t serializeStreamUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        const uint32_t start = micros();
+        serializeJson(doc, sink);
+        serializeStreamUs += micros() - start;
+    }
+
+    // Pre-rounded floats: smaller wire size at extra build cost
+    JsonDocument roundedDoc;
+    copyRounded(roundedDoc.as<JsonVariant>(), doc.as<JsonVariantConst>());
+    const size_t roundedBytes = measureJson(roundedDoc);
+    uint32_t serializeRoundedUs = 0;
+    for (int i = 0; i < iterations; i++) {
+        const uint32_t start = micros();
+        serializeJson(roundedDoc, sink);
+        serializeRoundedUs += micros() - start;
+    }
+
+    root["iterations"] = iterations;
+    root["payload_bytes"] = payloadBytes;
+    root["build_heap_us"] = buildHeapUs / iterations;
+    root["build_arena_us"] = buildArenaUs / iterations;
+    root["arena_high_water"] = arena.highWaterMark();
+    root["arena_heap_fallbacks"] = arena.heapFallbacks();
+    root["serialize_buffer_us"] = serializeBufferUs / iterations;
+    root["serialize_string_us"] = serializeStringUs / iterations;
+    root["serialize_stream_us"] = serializeStreamUs / iterations;
+    root["rounded_bytes"] = roundedBytes;
+    root["serialize_rounded_us"] = serializeRoundedUs / iterations;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
@@ -5,14 +5,164 @@
  */
 #include "WebApi_prometheus.h"
 #include "Configuration.h"
+#include "Datastore.h"
+#include "EnergyLedger.h"
+#include "MqttHandleInverter.h"
+#include "MqttSettings.h"
 #include "NetworkSettings.h"
+#include "SchedulerMonitor.h"
+#include "TaskMonitor.h"
+#include "ThermalGovernor.h"
 #include "WebApi.h"
 #include "__compiled_constants.h"
+#include <EventCounters.h>
 #include <Hoymiles.h>
+#include <cmath>
+#include <vector>
 
 #undef TAG
 static const char* TAG = "webapi";
 
+// Hand-rolled writer for the Prometheus protobuf exposition format: a
+// stream of length-delimited io.prometheus.client.MetricFamily
+// messages, negotiated by Prometheus via "scrape_protocols:
+// [PrometheusProto]". Field numbers follow metrics.proto; only the
+// subset this endpoint emits is implemented. Tags, lengths and
+// histogram counts are varints, sample values are 8-byte doubles as
+// the proto dictates - no decimal formatting happens at all on this
+// path.
+class PromProtoFamilies {
+public:
+    // io.prometheus.client.MetricType
+    enum class FamilyType : uint8_t {
+        Counter = 0,
+        Gauge = 1,
+        Histogram = 4,
+    };
+
+    explicit PromProtoFamilies(AsyncResponseStream* stream)
+        : _stream(stream)
+    {
+    }
+
+    void beginFamily(const char* name, const char* help, const FamilyType type)
+    {
+        _family.clear();
+        appendString(_family, 1, name);
+        appendString(_family, 2, help);
+        appendTag(_family, 3, 0);
+        appendVarint(_family, static_cast<uint64_t>(type));
+        _type = type;
+    }
+
+    // Labels apply to the next addSample()/addHistogram() call
+    void addLabel(const char* name, const char* value)
+    {
+        _scratch.clear();
+        appendString(_scratch, 1, name);
+        appendString(_scratch, 2, value);
+        appendMessage(_metric, 1, _scratch);
+    }
+
+    void addSample(const double value)
+    {
+        _scratch.clear();
+        appendDouble(_scratch, 1, value);
+        // gauge = 2, counter = 3 in io.prometheus.client.Metric
+        appendMessage(_metric, _type == FamilyType::Counter ? 3 : 2, _scratch);
+        finishMetric();
+    }
+
+    // counts are cumulative and must include the +Inf bucket
+    void addHistogram(const uint64_t sampleCount, const double sampleSum,
+        const double* bounds, const uint64_t* counts, const size_t bucketCount)
+    {
+        _scratch.clear();
+        appendTag(_scratch, 1, 0);
+        appendVarint(_scratch, sampleCount);
+        appendDouble(_scratch, 2, sampleSum);
+        for (size_t b = 0; b < bucketCount; b++) {
+            _bucket.clear();
+            appendTag(_bucket, 1, 0);
+            appendVarint(_bucket, counts[b]);
+            appendDouble(_bucket, 2, bounds[b]);
+            appendMessage(_scratch, 3, _bucket);
+        }
+        appendMessage(_metric, 7, _scratch);
+        finishMetric();
+    }
+
+    void endFamily()
+    {
+        // Delimited framing: a varint length ahead of every family
+        uint8_t prefix[10];
+        size_t prefixLen = 0;
+        uint64_t value = _family.size();
+        do {
+            prefix[prefixLen] = value & 0x7f;
+            value >>= 7;
+            if (value != 0) {
+                prefix[prefixLen] |= 0x80;
+            }
+            prefixLen++;
+        } while (value != 0);
+
+        _stream->write(prefix, prefixLen);
+        _stream->write(_family.data(), _family.size());
+    }
+
+private:
+    static void appendVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void appendTag(std::vector<uint8_t>& out, const uint32_t field, const uint8_t wireType)
+    {
+        appendVarint(out, (field << 3) | wireType);
+    }
+
+    static void appendString(std::vector<uint8_t>& out, const uint32_t field, const char* value)
+    {
+        const size_t len = strlen(value);
+        appendTag(out, field, 2);
+        appendVarint(out, len);
+        out.insert(out.end(), value, value + len);
+    }
+
+    static void appendDouble(std::vector<uint8_t>& out, const uint32_t field, const double value)
+    {
+        appendTag(out, field, 1);
+        uint8_t raw[sizeof(double)];
+        memcpy(raw, &value, sizeof(raw)); // doubles are little-endian IEEE 754 on this target
+        out.insert(out.end(), raw, raw + sizeof(raw));
+    }
+
+    static void appendMessage(std::vector<uint8_t>& out, const uint32_t field, const std::vector<uint8_t>& payload)
+    {
+        appendTag(out, field, 2);
+        appendVarint(out, payload.size());
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+
+    void finishMetric()
+    {
+        appendMessage(_family, 4, _metric);
+        _metric.clear();
+    }
+
+    AsyncResponseStream* _stream;
+    FamilyType _type = FamilyType::Gauge;
+    std::vector<uint8_t> _family;
+    std::vector<uint8_t> _metric;
+    std::vector<uint8_t> _scratch;
+    std::vector<uint8_t> _bucket;
+};
+
 void WebApiPrometheusClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
     using std::placeholders::_1;
@@ -28,6 +178,17 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
         return;
     }
 
+    // Scrapers configured for the protobuf exposition announce it in
+    // the Accept header; everyone else keeps getting the text format
+    if (request->hasHeader("Accept")) {
+        const String& accept = request->getHeader("Accept")->value();
+        if (accept.indexOf("application/vnd.google.protobuf") >= 0
+            && accept.indexOf("io.prometheus.client.MetricFamily") >= 0) {
+            sendProtobufMetrics(request);
+            return;
+        }
+    }
+
     try {
         auto stream = request->beginResponseStream("text/plain; charset=utf-8", initialResponseBufferSize);
 
@@ -68,32 +229,253 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
         stream->print("# TYPE wifi_station gauge\n");
         stream->printf("wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
 
+        TaskMonitorClass::TaskStats taskStats[TASK_MONITOR_SLOT_COUNT + 8];
+        const size_t taskStatsCount = TaskMonitor.collect(taskStats, sizeof(taskStats) / sizeof(taskStats[0]), false);
+
+        stream->print("# HELP opendtu_task_cpu_samples_total Statistical CPU samples attributed to the task\n");
+        stream->print("# TYPE opendtu_task_cpu_samples_total counter\n");
+        for (size_t t = 0; t < taskStatsCount; t++) {
+            stream->printf("opendtu_task_cpu_samples_total{task=\"%s\"} %" PRIu32 "\n", taskStats[t].name, taskStats[t].samples);
+        }
+
+        stream->print("# HELP opendtu_task_stack_watermark Minimum free stack of the task since boot\n");
+        stream->print("# TYPE opendtu_task_stack_watermark gauge\n");
+        for (size_t t = 0; t < taskStatsCount; t++) {
+            if (!taskStats[t].live) {
+                continue;
+            }
+            stream->printf("opendtu_task_stack_watermark{task=\"%s\"} %" PRIu32 "\n", taskStats[t].name, taskStats[t].stackWatermark);
+        }
+
+        stream->print("# HELP opendtu_loop_stalls_total Scheduler passes exceeding the stall budget\n");
+        stream->print("# TYPE opendtu_loop_stalls_total counter\n");
+        stream->printf("opendtu_loop_stalls_total %" PRIu32 "\n", SchedulerMonitor.getLoopStalls());
+
+        stream->print("# HELP opendtu_loop_gap_max_us Longest scheduler pass since boot\n");
+        stream->print("# TYPE opendtu_loop_gap_max_us gauge\n");
+        stream->printf("opendtu_loop_gap_max_us %" PRIu32 "\n", SchedulerMonitor.getLoopMaxGapUs());
+
+        stream->print("# HELP opendtu_task_budget_overruns_total Instrumented callback runs exceeding the task's latency budget\n");
+        stream->print("# TYPE opendtu_task_budget_overruns_total counter\n");
+        for (size_t t = 0; t < SchedulerMonitor.getTaskCount(); t++) {
+            stream->printf("opendtu_task_budget_overruns_total{task=\"%s\"} %" PRIu32 "\n",
+                SchedulerMonitor.getTaskName(t), SchedulerMonitor.getTaskOverruns(t));
+        }
+
+        stream->print("# HELP opendtu_hoymiles_events_total Radio and parser health events\n");
+        stream->print("# TYPE opendtu_hoymiles_events_total counter\n");
+        for (size_t e = 0; e < EventCountersClass::counterCount; e++) {
+            stream->printf("opendtu_hoymiles_events_total{event=\"%s\"} %" PRIu32 "\n",
+                EventCountersClass::name(e), EventCounters.get(e));
+        }
+
+        const auto& mqttStats = MqttSettings.getPublishStats();
+        static constexpr const char* prioLabels[3] = { "critical", "control", "telemetry" };
+
+        stream->print("# HELP opendtu_mqtt_published_total MQTT messages handed to the client\n");
+        stream->print("# TYPE opendtu_mqtt_published_total counter\n");
+        for (uint8_t p = 0; p < 3; p++) {
+            stream->printf("opendtu_mqtt_published_total{priority=\"%s\"} %" PRIu32 "\n", prioLabels[p], mqttStats.published[p].load());
+        }
+
+        stream->print("# HELP opendtu_mqtt_coalesced_total MQTT messages replaced by a newer payload while queued\n");
+        stream->print("# TYPE opendtu_mqtt_coalesced_total counter\n");
+        for (uint8_t p = 0; p < 3; p++) {
+            stream->printf("opendtu_mqtt_coalesced_total{priority=\"%s\"} %" PRIu32 "\n", prioLabels[p], mqttStats.coalesced[p].load());
+        }
+
+        stream->print("# HELP opendtu_mqtt_dropped_total MQTT messages shed on outbox overflow\n");
+        stream->print("# TYPE opendtu_mqtt_dropped_total counter\n");
+        for (uint8_t p = 0; p < 3; p++) {
+            stream->printf("opendtu_mqtt_dropped_total{priority=\"%s\"} %" PRIu32 "\n", prioLabels[p], mqttStats.dropped[p].load());
+        }
+
+        stream->print("# HELP opendtu_mqtt_outbox_depth MQTT messages currently queued\n");
+        stream->print("# TYPE opendtu_mqtt_outbox_depth gauge\n");
+        for (uint8_t p = 0; p < 3; p++) {
+            stream->printf("opendtu_mqtt_outbox_depth{priority=\"%s\"} %" PRIu32 "\n", prioLabels[p], mqttStats.outboxDepth[p].load());
+        }
+
+        stream->print("# HELP opendtu_mqtt_deferred_total MQTT publish attempts rejected by a full TX buffer\n");
+        stream->print("# TYPE opendtu_mqtt_deferred_total counter\n");
+        stream->printf("opendtu_mqtt_deferred_total %" PRIu32 "\n", mqttStats.deferred.load());
+
+        const auto& compressionStats = MqttHandleInverter.getCompressionStats();
+
+        stream->print("# HELP opendtu_mqtt_compressed_publishes_total Compact-JSON publishes sent compressed\n");
+        stream->print("# TYPE opendtu_mqtt_compressed_publishes_total counter\n");
+        stream->printf("opendtu_mqtt_compressed_publishes_total %" PRIu32 "\n", compressionStats.published.load());
+
+        stream->print("# HELP opendtu_mqtt_compression_skipped_total Compact-JSON publishes sent plain (incompressible)\n");
+        stream->print("# TYPE opendtu_mqtt_compression_skipped_total counter\n");
+        stream->printf("opendtu_mqtt_compression_skipped_total %" PRIu32 "\n", compressionStats.skipped.load());
+
+        stream->print("# HELP opendtu_mqtt_compression_bytes_in_total Payload bytes before compression\n");
+        stream->print("# TYPE opendtu_mqtt_compression_bytes_in_total counter\n");
+        stream->printf("opendtu_mqtt_compression_bytes_in_total %" PRIu64 "\n", compressionStats.bytesIn.load());
+
+        stream->print("# HELP opendtu_mqtt_compression_bytes_out_total Payload bytes actually published\n");
+        stream->print("# TYPE opendtu_mqtt_compression_bytes_out_total counter\n");
+        stream->printf("opendtu_mqtt_compression_bytes_out_total %" PRIu64 "\n", compressionStats.bytesOut.load());
+
+        stream->print("# HELP opendtu_mqtt_compression_cpu_microseconds_total CPU time spent compressing payloads\n");
+        stream->print("# TYPE opendtu_mqtt_compression_cpu_microseconds_total counter\n");
+        stream->printf("opendtu_mqtt_compression_cpu_microseconds_total %" PRIu64 "\n", compressionStats.cpuMicros.load());
+
+        stream->print("# HELP opendtu_mqtt_connects_total MQTT broker connections established\n");
+        stream->print("# TYPE opendtu_mqtt_connects_total counter\n");
+        stream->printf("opendtu_mqtt_connects_total %" PRIu32 "\n", mqttStats.connects.load());
+
+        stream->print("# HELP opendtu_mqtt_disconnects_total MQTT broker disconnects\n");
+        stream->print("# TYPE opendtu_mqtt_disconnects_total counter\n");
+        stream->printf("opendtu_mqtt_disconnects_total %" PRIu32 "\n", mqttStats.disconnects.load());
+
+        stream->print("# HELP opendtu_mqtt_publish_latency_milliseconds MQTT queue-to-wire latency\n");
+        stream->print("# TYPE opendtu_mqtt_publish_latency_milliseconds histogram\n");
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < 5; b++) {
+            cumulative += mqttStats.latencyBuckets[b].load();
+            stream->printf("opendtu_mqtt_publish_latency_milliseconds_bucket{le=\"%" PRIu32 "\"} %" PRIu32 "\n",
+                MqttSettingsClass::PublishStats::latencyBucketBoundsMs[b], cumulative);
+        }
+        cumulative += mqttStats.latencyBuckets[5].load();
+        stream->printf("opendtu_mqtt_publish_latency_milliseconds_bucket{le=\"+Inf\"} %" PRIu32 "\n", cumulative);
+        stream->printf("opendtu_mqtt_publish_latency_milliseconds_sum %" PRIu64 "\n", mqttStats.latencySumMs.load());
+        stream->printf("opendtu_mqtt_publish_latency_milliseconds_count %" PRIu32 "\n", mqttStats.latencyCount.load());
+
+        stream->print("# HELP opendtu_thermal_headroom_celsius Margin to the critical die temperature\n");
+        stream->print("# TYPE opendtu_thermal_headroom_celsius gauge\n");
+        stream->printf("opendtu_thermal_headroom_celsius %.1f\n", ThermalGovernor.getHeadroomCelsius());
+
+        stream->print("# HELP opendtu_thermal_throttling Whether the thermal governor is shedding optional load\n");
+        stream->print("# TYPE opendtu_thermal_throttling gauge\n");
+        stream->printf("opendtu_thermal_throttling %d\n", ThermalGovernor.isThrottling() ? 1 : 0);
+
+        stream->print("# HELP opendtu_thermal_activations_total Thermal throttle engagements since boot\n");
+        stream->print("# TYPE opendtu_thermal_activations_total counter\n");
+        stream->printf("opendtu_thermal_activations_total %" PRIu32 "\n", ThermalGovernor.getActivations());
+
+        const auto& routeStats = WebApi.getRouteStats();
+
+        stream->print("# HELP opendtu_http_active_requests HTTP handlers currently executing\n");
+        stream->print("# TYPE opendtu_http_active_requests gauge\n");
+        stream->printf("opendtu_http_active_requests %" PRIu32 "\n", WebApi.getActiveRequests());
+
+        stream->print("# HELP opendtu_http_connections_opened_total TCP connections that served their first request\n");
+        stream->print("# TYPE opendtu_http_connections_opened_total counter\n");
+        stream->printf("opendtu_http_connections_opened_total %" PRIu32 "\n", WebApi.getConnectionsOpened());
+
+        stream->print("# HELP opendtu_http_reused_connection_requests_total Requests served on an already-open connection\n");
+        stream->print("# TYPE opendtu_http_reused_connection_requests_total counter\n");
+        stream->printf("opendtu_http_reused_connection_requests_total %" PRIu32 "\n", WebApi.getReusedConnectionRequests());
+
+        stream->print("# HELP opendtu_http_requests_total HTTP requests handled per route\n");
+        stream->print("# TYPE opendtu_http_requests_total counter\n");
+        for (const auto& entry : routeStats) {
+            stream->printf("opendtu_http_requests_total{route=\"%s\"} %" PRIu32 "\n", entry.first.c_str(), entry.second.invocations);
+        }
+
+        stream->print("# HELP opendtu_http_response_bytes_total JSON response payload bytes per route\n");
+        stream->print("# TYPE opendtu_http_response_bytes_total counter\n");
+        for (const auto& entry : routeStats) {
+            stream->printf("opendtu_http_response_bytes_total{route=\"%s\"} %" PRIu64 "\n", entry.first.c_str(), entry.second.bytesOut);
+        }
+
+        stream->print("# HELP opendtu_http_handler_duration_microseconds HTTP handler execution time\n");
+        stream->print("# TYPE opendtu_http_handler_duration_microseconds histogram\n");
+        for (const auto& entry : routeStats) {
+            uint32_t routeCumulative = 0;
+            for (uint8_t b = 0; b < 5; b++) {
+                routeCumulative += entry.second.durationBuckets[b];
+                stream->printf("opendtu_http_handler_duration_microseconds_bucket{route=\"%s\",le=\"%" PRIu32 "\"} %" PRIu32 "\n",
+                    entry.first.c_str(), WebApiClass::RouteStats::durationBucketBoundsUs[b], routeCumulative);
+            }
+            routeCumulative += entry.second.durationBuckets[5];
+            stream->printf("opendtu_http_handler_duration_microseconds_bucket{route=\"%s\",le=\"+Inf\"} %" PRIu32 "\n", entry.first.c_str(), routeCumulative);
+            stream->printf("opendtu_http_handler_duration_microseconds_sum{route=\"%s\"} %" PRIu64 "\n", entry.first.c_str(), entry.second.durationSumUs);
+            stream->printf("opendtu_http_handler_duration_microseconds_count{route=\"%s\"} %" PRIu32 "\n", entry.first.c_str(), entry.second.invocations);
+        }
+
+        DatastoreClass::DerivedMetricValue_t derivedMetrics[DatastoreClass::MAX_DERIVED_METRICS];
+        const size_t derivedMetricCount = Datastore.copyDerivedMetrics(derivedMetrics, DatastoreClass::MAX_DERIVED_METRICS);
+
+        stream->print("# HELP opendtu_derived_metric Fleet metric derived on-device by the datastore\n");
+        stream->print("# TYPE opendtu_derived_metric gauge\n");
+        for (size_t m = 0; m < derivedMetricCount; m++) {
+            if (!derivedMetrics[m].valid) {
+                continue;
+            }
+            stream->printf("opendtu_derived_metric{name=\"%s\",unit=\"%s\"} %f\n",
+                derivedMetrics[m].name, derivedMetrics[m].unit, derivedMetrics[m].value);
+        }
+
         for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
             auto inv = Hoymiles.getInverterByPos(i);
 
             String serial = inv->serialString();
-            const char* name = inv->name();
+            auto& prefixes = getMetricPrefixes(inv, i);
+
             if (i == 0) {
                 stream->print("# HELP opendtu_last_update last update from inverter in s\n");
                 stream->print("# TYPE opendtu_last_update gauge\n");
             }
-            stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %" PRIu32 "\n",
-                serial.c_str(), i, name, inv->Statistics()->getLastUpdate() / 1000);
+            stream->printf("opendtu_last_update%s %" PRIu32 "\n",
+                prefixes.inverterLabels.c_str(), inv->Statistics()->getLastUpdate() / 1000);
+
+            if (i == 0) {
+                stream->print("# HELP opendtu_inverter_success_rate rolling radio exchange success rate (EWMA)\n");
+                stream->print("# TYPE opendtu_inverter_success_rate gauge\n");
+            }
+            stream->printf("opendtu_inverter_success_rate%s %f\n",
+                prefixes.inverterLabels.c_str(), 1.0f - inv->getLossRateEwma());
+
+            if (i == 0) {
+                stream->print("# HELP opendtu_inverter_exchange_duration_milliseconds rolling radio exchange duration (EWMA)\n");
+                stream->print("# TYPE opendtu_inverter_exchange_duration_milliseconds gauge\n");
+            }
+            stream->printf("opendtu_inverter_exchange_duration_milliseconds%s %f\n",
+                prefixes.inverterLabels.c_str(), inv->getExchangeDurationEwma());
+
+            if (i == 0) {
+                stream->print("# HELP opendtu_inverter_retransmit_ratio fragment re-requests per data request\n");
+                stream->print("# TYPE opendtu_inverter_retransmit_ratio gauge\n");
+            }
+            stream->printf("opendtu_inverter_retransmit_ratio%s %f\n",
+                prefixes.inverterLabels.c_str(),
+                inv->RadioStats.TxRequestData > 0
+                    ? static_cast<float>(inv->RadioStats.TxReRequestFragment) / inv->RadioStats.TxRequestData
+                    : 0.0f);
+
+            if (i == 0) {
+                stream->print("# HELP opendtu_inverter_rssi_trend_db fast minus slow RSSI EWMA, negative when the link degrades\n");
+                stream->print("# TYPE opendtu_inverter_rssi_trend_db gauge\n");
+            }
+            stream->printf("opendtu_inverter_rssi_trend_db%s %f\n",
+                prefixes.inverterLabels.c_str(), inv->getRssiTrend());
 
             if (i == 0) {
                 stream->print("# HELP opendtu_inverter_limit_relative current relative limit of the inverter\n");
                 stream->print("# TYPE opendtu_inverter_limit_relative gauge\n");
             }
-            stream->printf("opendtu_inverter_limit_relative{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() / 100.0);
+            stream->printf("opendtu_inverter_limit_relative%s %f\n",
+                prefixes.inverterLabels.c_str(), inv->SystemConfigPara()->getLimitPercent() / 100.0);
 
             if (inv->DevInfo()->getMaxPower() > 0) {
                 if (i == 0) {
                     stream->print("# HELP opendtu_inverter_limit_absolute current relative limit of the inverter\n");
                     stream->print("# TYPE opendtu_inverter_limit_absolute gauge\n");
                 }
-                stream->printf("opendtu_inverter_limit_absolute{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                    serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+                stream->printf("opendtu_inverter_limit_absolute%s %f\n",
+                    prefixes.inverterLabels.c_str(), inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+            }
+
+            if (i == 0) {
+                stream->print("# HELP opendtu_energy_ledger_watthours_total locally integrated DC channel energy, survives reboots\n");
+                stream->print("# TYPE opendtu_energy_ledger_watthours_total counter\n");
+            }
+            for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+                stream->printf("opendtu_energy_ledger_watthours_total{serial=\"%s\",unit=\"%d\",name=\"%s\",channel=\"%d\"} %f\n",
+                    serial.c_str(), i, inv->name(), c, EnergyLedger.getChannelEnergyWh(inv->serial(), c));
             }
 
             // Loop all channels if Statistics have been updated at least once since DTU boot
@@ -103,9 +485,9 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
                         addPanelInfo(stream, serial, i, inv, t, c);
                         for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(_publishFields[0]); f++) {
                             if (t == TYPE_INV && _publishFields[f].field == FLD_PDC) {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type], "PowerDC");
+                                addField(stream, prefixes, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type], "PowerDC");
                             } else {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type]);
+                                addField(stream, prefixes, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type]);
                             }
                         }
                     }
@@ -126,7 +508,439 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
     }
 }
 
-void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
+void WebApiPrometheusClass::sendProtobufMetrics(AsyncWebServerRequest* request)
+{
+    static size_t initialProtoBufferSize = 1024;
+
+    using FamilyType = PromProtoFamilies::FamilyType;
+
+    try {
+        auto stream = request->beginResponseStream(
+            "application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited",
+            initialProtoBufferSize);
+
+        PromProtoFamilies out(stream);
+
+        out.beginFamily("opendtu_build", "Build info", FamilyType::Gauge);
+        char version[16];
+        snprintf(version, sizeof(version), "%d.%d.%d", CONFIG_VERSION >> 24 & 0xff, CONFIG_VERSION >> 16 & 0xff, CONFIG_VERSION >> 8 & 0xff);
+        out.addLabel("name", NetworkSettings.getHostname().c_str());
+        out.addLabel("id", __COMPILED_GIT_HASH__);
+        out.addLabel("version", version);
+        out.addSample(1);
+        out.endFamily();
+
+        out.beginFamily("opendtu_platform", "Platform info", FamilyType::Gauge);
+        out.addLabel("arch", ESP.getChipModel());
+        out.addLabel("mac", NetworkSettings.macAddress().c_str());
+        out.addSample(1);
+        out.endFamily();
+
+        out.beginFamily("opendtu_uptime", "Uptime in seconds", FamilyType::Counter);
+        out.addSample(esp_timer_get_time() / 1000000);
+        out.endFamily();
+
+        out.beginFamily("opendtu_heap_size", "System memory size", FamilyType::Gauge);
+        out.addSample(ESP.getHeapSize());
+        out.endFamily();
+
+        out.beginFamily("opendtu_free_heap_size", "System free memory", FamilyType::Gauge);
+        out.addSample(ESP.getFreeHeap());
+        out.endFamily();
+
+        out.beginFamily("opendtu_biggest_heap_block", "Biggest free heap block", FamilyType::Gauge);
+        out.addSample(ESP.getMaxAllocHeap());
+        out.endFamily();
+
+        out.beginFamily("opendtu_heap_min_free", "Minimum free memory since boot", FamilyType::Gauge);
+        out.addSample(ESP.getMinFreeHeap());
+        out.endFamily();
+
+        out.beginFamily("wifi_rssi", "WiFi RSSI", FamilyType::Gauge);
+        out.addSample(WiFi.RSSI());
+        out.endFamily();
+
+        out.beginFamily("wifi_station", "WiFi Station info", FamilyType::Gauge);
+        out.addLabel("bssid", WiFi.BSSIDstr().c_str());
+        out.addSample(1);
+        out.endFamily();
+
+        TaskMonitorClass::TaskStats taskStats[TASK_MONITOR_SLOT_COUNT + 8];
+        const size_t taskStatsCount = TaskMonitor.collect(taskStats, sizeof(taskStats) / sizeof(taskStats[0]), false);
+
+        out.beginFamily("opendtu_task_cpu_samples_total", "Statistical CPU samples attributed to the task", FamilyType::Counter);
+        for (size_t t = 0; t < taskStatsCount; t++) {
+            out.addLabel("task", taskStats[t].name);
+            out.addSample(taskStats[t].samples);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_task_stack_watermark", "Minimum free stack of the task since boot", FamilyType::Gauge);
+        for (size_t t = 0; t < taskStatsCount; t++) {
+            if (!taskStats[t].live) {
+                continue;
+            }
+            out.addLabel("task", taskStats[t].name);
+            out.addSample(taskStats[t].stackWatermark);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_loop_stalls_total", "Scheduler passes exceeding the stall budget", FamilyType::Counter);
+        out.addSample(SchedulerMonitor.getLoopStalls());
+        out.endFamily();
+
+        out.beginFamily("opendtu_loop_gap_max_us", "Longest scheduler pass since boot", FamilyType::Gauge);
+        out.addSample(SchedulerMonitor.getLoopMaxGapUs());
+        out.endFamily();
+
+        out.beginFamily("opendtu_task_budget_overruns_total", "Instrumented callback runs exceeding the task's latency budget", FamilyType::Counter);
+        for (size_t t = 0; t < SchedulerMonitor.getTaskCount(); t++) {
+            out.addLabel("task", SchedulerMonitor.getTaskName(t));
+            out.addSample(SchedulerMonitor.getTaskOverruns(t));
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_hoymiles_events_total", "Radio and parser health events", FamilyType::Counter);
+        for (size_t e = 0; e < EventCountersClass::counterCount; e++) {
+            out.addLabel("event", EventCountersClass::name(e));
+            out.addSample(EventCounters.get(e));
+        }
+        out.endFamily();
+
+        const auto& mqttStats = MqttSettings.getPublishStats();
+        static constexpr const char* prioLabels[3] = { "critical", "control", "telemetry" };
+
+        out.beginFamily("opendtu_mqtt_published_total", "MQTT messages handed to the client", FamilyType::Counter);
+        for (uint8_t p = 0; p < 3; p++) {
+            out.addLabel("priority", prioLabels[p]);
+            out.addSample(mqttStats.published[p].load());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_coalesced_total", "MQTT messages replaced by a newer payload while queued", FamilyType::Counter);
+        for (uint8_t p = 0; p < 3; p++) {
+            out.addLabel("priority", prioLabels[p]);
+            out.addSample(mqttStats.coalesced[p].load());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_dropped_total", "MQTT messages shed on outbox overflow", FamilyType::Counter);
+        for (uint8_t p = 0; p < 3; p++) {
+            out.addLabel("priority", prioLabels[p]);
+            out.addSample(mqttStats.dropped[p].load());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_outbox_depth", "MQTT messages currently queued", FamilyType::Gauge);
+        for (uint8_t p = 0; p < 3; p++) {
+            out.addLabel("priority", prioLabels[p]);
+            out.addSample(mqttStats.outboxDepth[p].load());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_deferred_total", "MQTT publish attempts rejected by a full TX buffer", FamilyType::Counter);
+        out.addSample(mqttStats.deferred.load());
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_connects_total", "MQTT broker connections established", FamilyType::Counter);
+        out.addSample(mqttStats.connects.load());
+        out.endFamily();
+
+        out.beginFamily("opendtu_mqtt_disconnects_total", "MQTT broker disconnects", FamilyType::Counter);
+        out.addSample(mqttStats.disconnects.load());
+        out.endFamily();
+
+        {
+            double bounds[6];
+            uint64_t counts[6];
+            uint32_t cumulative = 0;
+            for (uint8_t b = 0; b < 5; b++) {
+                cumulative += mqttStats.latencyBuckets[b].load();
+                bounds[b] = MqttSettingsClass::PublishStats::latencyBucketBoundsMs[b];
+                counts[b] = cumulative;
+            }
+            cumulative += mqttStats.latencyBuckets[5].load();
+            bounds[5] = INFINITY;
+            counts[5] = cumulative;
+
+            out.beginFamily("opendtu_mqtt_publish_latency_milliseconds", "MQTT queue-to-wire latency", FamilyType::Histogram);
+            out.addHistogram(mqttStats.latencyCount.load(), mqttStats.latencySumMs.load(), bounds, counts, 6);
+            out.endFamily();
+        }
+
+        out.beginFamily("opendtu_thermal_headroom_celsius", "Margin to the critical die temperature", FamilyType::Gauge);
+        out.addSample(ThermalGovernor.getHeadroomCelsius());
+        out.endFamily();
+
+        out.beginFamily("opendtu_thermal_throttling", "Whether the thermal governor is shedding optional load", FamilyType::Gauge);
+        out.addSample(ThermalGovernor.isThrottling() ? 1 : 0);
+        out.endFamily();
+
+        out.beginFamily("opendtu_thermal_activations_total", "Thermal throttle engagements since boot", FamilyType::Counter);
+        out.addSample(ThermalGovernor.getActivations());
+        out.endFamily();
+
+        const auto& routeStats = WebApi.getRouteStats();
+
+        out.beginFamily("opendtu_http_active_requests", "HTTP handlers currently executing", FamilyType::Gauge);
+        out.addSample(WebApi.getActiveRequests());
+        out.endFamily();
+
+        out.beginFamily("opendtu_http_connections_opened_total", "TCP connections that served their first request", FamilyType::Counter);
+        out.addSample(WebApi.getConnectionsOpened());
+        out.endFamily();
+
+        out.beginFamily("opendtu_http_reused_connection_requests_total", "Requests served on an already-open connection", FamilyType::Counter);
+        out.addSample(WebApi.getReusedConnectionRequests());
+        out.endFamily();
+
+        out.beginFamily("opendtu_http_requests_total", "HTTP requests handled per route", FamilyType::Counter);
+        for (const auto& entry : routeStats) {
+            out.addLabel("route", entry.first.c_str());
+            out.addSample(entry.second.invocations);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_http_response_bytes_total", "JSON response payload bytes per route", FamilyType::Counter);
+        for (const auto& entry : routeStats) {
+            out.addLabel("route", entry.first.c_str());
+            out.addSample(entry.second.bytesOut);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_http_handler_duration_microseconds", "HTTP handler execution time", FamilyType::Histogram);
+        for (const auto& entry : routeStats) {
+            double bounds[6];
+            uint64_t counts[6];
+            uint32_t routeCumulative = 0;
+            for (uint8_t b = 0; b < 5; b++) {
+                routeCumulative += entry.second.durationBuckets[b];
+                bounds[b] = WebApiClass::RouteStats::durationBucketBoundsUs[b];
+                counts[b] = routeCumulative;
+            }
+            routeCumulative += entry.second.durationBuckets[5];
+            bounds[5] = INFINITY;
+            counts[5] = routeCumulative;
+
+            out.addLabel("route", entry.first.c_str());
+            out.addHistogram(entry.second.invocations, entry.second.durationSumUs, bounds, counts, 6);
+        }
+        out.endFamily();
+
+        const uint8_t numInverters = Hoymiles.getNumInverters();
+
+        auto addInverterLabels = [&out](std::shared_ptr<InverterAbstract>& inv, const uint8_t idx, const String& serial) {
+            out.addLabel("serial", serial.c_str());
+            out.addLabel("unit", String(idx).c_str());
+            out.addLabel("name", inv->name());
+        };
+
+        out.beginFamily("opendtu_last_update", "last update from inverter in s", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->Statistics()->getLastUpdate() / 1000);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_success_rate", "rolling radio exchange success rate (EWMA)", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(1.0f - inv->getLossRateEwma());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_exchange_duration_milliseconds", "rolling radio exchange duration (EWMA)", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->getExchangeDurationEwma());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_retransmit_ratio", "fragment re-requests per data request", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->RadioStats.TxRequestData > 0
+                    ? static_cast<double>(inv->RadioStats.TxReRequestFragment) / inv->RadioStats.TxRequestData
+                    : 0.0);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_rssi_trend_db", "fast minus slow RSSI EWMA, negative when the link degrades", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->getRssiTrend());
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_limit_relative", "current relative limit of the inverter", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->SystemConfigPara()->getLimitPercent() / 100.0);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_inverter_limit_absolute", "current relative limit of the inverter", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv->DevInfo()->getMaxPower() == 0) {
+                continue;
+            }
+            addInverterLabels(inv, i, inv->serialString());
+            out.addSample(inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_PanelInfo", "panel information", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv->Statistics()->getLastUpdate() == 0) {
+                continue;
+            }
+            const String serial = inv->serialString();
+            for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+                addInverterLabels(inv, i, serial);
+                out.addLabel("channel", String(c).c_str());
+                out.addLabel("panelname", inv->Statistics()->getChannelName(c));
+                out.addSample(1);
+            }
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_MaxPower", "panel maximum output power", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv->Statistics()->getLastUpdate() == 0) {
+                continue;
+            }
+            const String serial = inv->serialString();
+            for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+                addInverterLabels(inv, i, serial);
+                out.addLabel("channel", String(c).c_str());
+                out.addSample(inv->Statistics()->getStringMaxPower(c));
+            }
+        }
+        out.endFamily();
+
+        out.beginFamily("opendtu_YieldTotalOffset", "panel yield offset (for used inverters)", FamilyType::Gauge);
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv->Statistics()->getLastUpdate() == 0) {
+                continue;
+            }
+            const String serial = inv->serialString();
+            for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
+                addInverterLabels(inv, i, serial);
+                out.addLabel("channel", String(c).c_str());
+                out.addSample(inv->Statistics()->getChannelFieldOffset(TYPE_DC, c, FLD_YT));
+            }
+        }
+        out.endFamily();
+
+        // One family per statistics field: a MetricFamily must carry
+        // all its metrics in one message, so unlike the text path the
+        // channel loop runs field-major here. The field name for a
+        // given field id is the same on every channel type; only
+        // TYPE_INV FLD_PDC is renamed and gets its own family below.
+        for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(_publishFields[0]); f++) {
+            const FieldId_t fieldId = _publishFields[f].field;
+            const FamilyType familyType = _publishFields[f].type == MetricType_t::COUNTER ? FamilyType::Counter : FamilyType::Gauge;
+
+            bool familyOpen = false;
+            for (uint8_t i = 0; i < numInverters; i++) {
+                auto inv = Hoymiles.getInverterByPos(i);
+                if (inv->Statistics()->getLastUpdate() == 0) {
+                    continue;
+                }
+                const String serial = inv->serialString();
+                for (auto& t : inv->Statistics()->getChannelTypes()) {
+                    if (t == TYPE_INV && fieldId == FLD_PDC) {
+                        continue;
+                    }
+                    for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+                        if (!inv->Statistics()->hasChannelFieldValue(t, c, fieldId)) {
+                            continue;
+                        }
+                        if (!familyOpen) {
+                            const String name = String("opendtu_") + inv->Statistics()->getChannelFieldName(t, c, fieldId);
+                            const String help = String("in ") + inv->Statistics()->getChannelFieldUnit(t, c, fieldId);
+                            out.beginFamily(name.c_str(), help.c_str(), familyType);
+                            familyOpen = true;
+                        }
+                        addInverterLabels(inv, i, serial);
+                        out.addLabel("type", inv->Statistics()->getChannelTypeName(t));
+                        out.addLabel("channel", String(c).c_str());
+                        out.addSample(inv->Statistics()->getChannelFieldValue(t, c, fieldId));
+                    }
+                }
+            }
+            if (familyOpen) {
+                out.endFamily();
+            }
+        }
+
+        bool pdcFamilyOpen = false;
+        for (uint8_t i = 0; i < numInverters; i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv->Statistics()->getLastUpdate() == 0) {
+                continue;
+            }
+            const String serial = inv->serialString();
+            for (auto& c : inv->Statistics()->getChannelsByType(TYPE_INV)) {
+                if (!inv->Statistics()->hasChannelFieldValue(TYPE_INV, c, FLD_PDC)) {
+                    continue;
+                }
+                if (!pdcFamilyOpen) {
+                    const String help = String("in ") + inv->Statistics()->getChannelFieldUnit(TYPE_INV, c, FLD_PDC);
+                    out.beginFamily("opendtu_PowerDC", help.c_str(), FamilyType::Gauge);
+                    pdcFamilyOpen = true;
+                }
+                addInverterLabels(inv, i, serial);
+                out.addLabel("type", inv->Statistics()->getChannelTypeName(TYPE_INV));
+                out.addLabel("channel", String(c).c_str());
+                out.addSample(inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_PDC));
+            }
+        }
+        if (pdcFamilyOpen) {
+            out.endFamily();
+        }
+
+        stream->addHeader("Cache-Control", "no-cache");
+        if (stream->available() > initialProtoBufferSize) {
+            initialProtoBufferSize = stream->available();
+            ESP_LOGI(TAG, "Increased /api/prometheus/metrics initialProtoBufferSize to %" PRIu32 " bytes", initialProtoBufferSize);
+        }
+        request->send(stream);
+
+    } catch (std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Call to /api/prometheus/metrics temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+
+        WebApi.sendTooManyRequests(request);
+    }
+}
+
+WebApiPrometheusClass::MetricPrefixes& WebApiPrometheusClass::getMetricPrefixes(std::shared_ptr<InverterAbstract> inv, const uint8_t idx)
+{
+    auto& prefixes = _metricPrefixCache[inv->serial()];
+
+    if (prefixes.idx != idx || prefixes.name != inv->name()) {
+        prefixes.idx = idx;
+        prefixes.name = inv->name();
+        prefixes.inverterLabels = "{serial=\"" + inv->serialString()
+            + "\",unit=\"" + String(idx)
+            + "\",name=\"" + inv->name() + "\"}";
+        prefixes.fields.clear();
+    }
+
+    return prefixes;
+}
+
+void WebApiPrometheusClass::addField(AsyncResponseStream* stream, MetricPrefixes& prefixes, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
 {
     if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
         const char* chanName = (channelName == nullptr) ? inv->Statistics()->getChannelFieldName(type, channel, fieldId) : channelName;
@@ -134,14 +948,31 @@ void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String&
             stream->printf("# HELP opendtu_%s in %s\n", chanName, inv->Statistics()->getChannelFieldUnit(type, channel, fieldId));
             stream->printf("# TYPE opendtu_%s %s\n", chanName, metricName);
         }
-        stream->printf("opendtu_%s{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\",type=\"%s\",channel=\"%d\"} %s\n",
-            chanName,
-            serial.c_str(),
-            idx,
-            inv->name(),
-            inv->Statistics()->getChannelTypeName(type),
-            channel,
-            inv->Statistics()->getChannelFieldValueString(type, channel, fieldId).c_str());
+
+        // The full metric name and label set never changes between
+        // scrapes, only the value does
+        const uint32_t key = (static_cast<uint32_t>(type) << 16) | (static_cast<uint32_t>(channel) << 8) | fieldId;
+        auto it = prefixes.fields.find(key);
+        if (it == prefixes.fields.end()) {
+            String prefix = "opendtu_";
+            prefix += chanName;
+            prefix += "{serial=\"";
+            prefix += serial;
+            prefix += "\",unit=\"";
+            prefix += String(idx);
+            prefix += "\",name=\"";
+            prefix += inv->name();
+            prefix += "\",type=\"";
+            prefix += inv->Statistics()->getChannelTypeName(type);
+            prefix += "\",channel=\"";
+            prefix += String(channel);
+            prefix += "\"} ";
+            it = prefixes.fields.emplace(key, std::move(prefix)).first;
+        }
+
+        stream->print(it->second);
+        stream->print(inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
+        stream->print('\n');
     }
 }
 
@@ -151,8 +982,6 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         return;
     }
 
-    const auto& config = Configuration.getInverterConfig(inv->serial());
-
     const bool printHelp = (idx == 0 && channel == 0);
     if (printHelp) {
         stream->print("# HELP opendtu_PanelInfo panel information\n");
@@ -163,7 +992,7 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         idx,
         inv->name(),
         channel,
-        config->channel[channel].Name);
+        inv->Statistics()->getChannelName(channel));
 
     if (printHelp) {
         stream->print("# HELP opendtu_MaxPower panel maximum output power\n");
@@ -174,7 +1003,7 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         idx,
         inv->name(),
         channel,
-        config->channel[channel].MaxChannelPower);
+        inv->Statistics()->getStringMaxPower(channel));
 
     if (printHelp) {
         stream->print("# HELP opendtu_YieldTotalOffset panel yield offset (for used inverters)\n");
@@ -185,5 +1014,5 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         idx,
         inv->name(),
         channel,
-        config->channel[channel].YieldTotalOffset);
+        inv->Statistics()->getChannelFieldOffset(TYPE_DC, channel, FLD_YT));
 }
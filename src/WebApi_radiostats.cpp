@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_radiostats.h"
+#include "ResponseSchemas.h"
+#include "WebApi.h"
+#include <AsyncJson.h>
+#include <Hoymiles.h>
+
+void WebApiRadioStatsClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/radio/stats", HTTP_GET, std::bind(&WebApiRadioStatsClass::onRadioStats, this, _1));
+}
+
+void WebApiRadioStatsClass::onRadioStats(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["schema_version"] = RADIO_STATS_SCHEMA_VERSION;
+
+    auto radioNrf = Hoymiles.getRadioNrf();
+    JsonObject nrfObject = root["nrf"].to<JsonObject>();
+    nrfObject["initialized"] = radioNrf->isInitialized();
+
+    if (radioNrf->isInitialized()) {
+        HoymilesRadio_NRF::ChannelStats_t channelStats[10];
+        const uint8_t channelCount = radioNrf->getChannelStats(channelStats, sizeof(channelStats) / sizeof(channelStats[0]));
+
+        // Shape comes from the descriptor table; the webapp type is
+        // generated from the same table at build time
+        JsonArray channelsArray = nrfObject["channels"].to<JsonArray>();
+        for (uint8_t i = 0; i < channelCount; i++) {
+            serializeWithSchema(channelsArray.add<JsonObject>(), RADIO_STATS_CHANNEL_FIELDS,
+                sizeof(RADIO_STATS_CHANNEL_FIELDS) / sizeof(RADIO_STATS_CHANNEL_FIELDS[0]), &channelStats[i]);
+        }
+    }
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_radiotrace.h"
+#include "WebApi.h"
+#include "WebApi_errors.h"
+#include <AsyncJson.h>
+#include <LittleFS.h>
+#include <RadioTrace.h>
+#include <algorithm>
+#include <cstring>
+
+// Capture sessions saved via /api/radio/trace/save end up here and can
+// be fetched through the file API after a reboot
+#define RADIO_TRACE_FILENAME "/radiotrace.bin"
+
+// Dump format: this header followed by the trace records, oldest first.
+// Everything is little endian; the record layout is
+// RadioTraceClass::Record (see lib/Hoymiles/src/RadioTrace.h).
+struct __attribute__((packed)) RadioTraceDumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+    uint32_t sequence; // total records written since boot
+};
+
+static constexpr uint32_t radioTraceDumpMagic = 0x4F445254; // "ODRT"
+// Version 2: records carry full frame payloads (49 bytes per record)
+static constexpr uint32_t radioTraceDumpVersion = 2;
+
+void WebApiRadioTraceClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/radio/trace", HTTP_GET, std::bind(&WebApiRadioTraceClass::onRadioTraceDump, this, _1));
+    server.on("/api/radio/trace/save", HTTP_POST, std::bind(&WebApiRadioTraceClass::onRadioTraceSave, this, _1));
+}
+
+void WebApiRadioTraceClass::onRadioTraceDump(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    // Snapshot the write position; records appended by the radio tasks
+    // while the dump streams out are simply not part of this dump
+    const uint32_t sequence = RadioTrace.getSequence();
+    const uint32_t capacity = RadioTrace.getCapacity();
+    const uint32_t count = std::min(sequence, capacity);
+    const uint32_t oldest = sequence - count;
+    const auto* ring = RadioTrace.getRing();
+
+    const size_t totalSize = sizeof(RadioTraceDumpHeader) + count * sizeof(RadioTraceClass::Record);
+
+    // The ring lives in PSRAM, so the chunk callback can copy from it
+    // directly in the async_tcp context - no flash access involved
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+        [sequence, capacity, count, oldest, ring, totalSize](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t written = 0;
+
+            if (index < sizeof(RadioTraceDumpHeader)) {
+                RadioTraceDumpHeader header;
+                header.magic = radioTraceDumpMagic;
+                header.version = radioTraceDumpVersion;
+                header.recordSize = sizeof(RadioTraceClass::Record);
+                header.count = count;
+                header.sequence = sequence;
+
+                written = std::min(maxLen, sizeof(header) - index);
+                memcpy(buffer, reinterpret_cast<const uint8_t*>(&header) + index, written);
+                index += written;
+            }
+
+            while (written < maxLen && index < totalSize) {
+                const size_t recordPos = index - sizeof(RadioTraceDumpHeader);
+                const uint32_t logical = oldest + recordPos / sizeof(RadioTraceClass::Record);
+                const auto* record = reinterpret_cast<const uint8_t*>(&ring[logical % capacity]);
+                const size_t offset = recordPos % sizeof(RadioTraceClass::Record);
+                const size_t chunk = std::min(maxLen - written, sizeof(RadioTraceClass::Record) - offset);
+                memcpy(buffer + written, record + offset, chunk);
+                written += chunk;
+                index += chunk;
+            }
+
+            return written;
+        });
+
+    response->addHeader("Content-Disposition", "attachment; filename=\"radiotrace.bin\"");
+    request->send(response);
+}
+
+void WebApiRadioTraceClass::onRadioTraceSave(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+
+    if (!RadioTrace.isEnabled()) {
+        retMsg["message"] = "Radio trace not available (no PSRAM)!";
+        retMsg["code"] = WebApiError::GenericInternalServerError;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    // Same snapshot semantics as the live dump; records appended while
+    // the file is written are not part of this capture
+    const uint32_t sequence = RadioTrace.getSequence();
+    const uint32_t capacity = RadioTrace.getCapacity();
+    const uint32_t count = std::min(sequence, capacity);
+    const uint32_t oldest = sequence - count;
+    const auto* ring = RadioTrace.getRing();
+
+    File f = LittleFS.open(RADIO_TRACE_FILENAME, "w");
+    if (!f) {
+        retMsg["message"] = "Failed to open file for writing!";
+        retMsg["code"] = WebApiError::GenericInternalServerError;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    RadioTraceDumpHeader header;
+    header.magic = radioTraceDumpMagic;
+    header.version = radioTraceDumpVersion;
+    header.recordSize = sizeof(RadioTraceClass::Record);
+    header.count = count;
+    header.sequence = sequence;
+
+    size_t written = f.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    for (uint32_t i = 0; i < count; i++) {
+        written += f.write(reinterpret_cast<const uint8_t*>(&ring[(oldest + i) % capacity]),
+            sizeof(RadioTraceClass::Record));
+    }
+    f.close();
+
+    retMsg["type"] = "success";
+    retMsg["file"] = RADIO_TRACE_FILENAME;
+    retMsg["records"] = count;
+    retMsg["bytes"] = written;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
@@ -4,6 +4,7 @@
  */
 #include "WebApi_security.h"
 #include "Configuration.h"
+#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
@@ -41,7 +42,8 @@ void WebApiSecurityClass::onSecurityPost(AsyncWebServerRequest* request)
     }
 
     AsyncJsonResponse* response = new AsyncJsonResponse();
-    JsonDocument root;
+    Utils::PooledJsonDocument pooledDoc;
+    JsonDocument& root = pooledDoc;
     if (!WebApi.parseRequestData(request, response, root)) {
         return;
     }
@@ -91,5 +93,10 @@ void WebApiSecurityClass::onAuthenticateGet(AsyncWebServerRequest* request)
     retMsg["message"] = "Authentication successful!";
     retMsg["code"] = WebApiError::SecurityAuthSuccess;
 
+    // Hand out a session token so subsequent requests skip the
+    // credential verification (see WebApiClass::checkCredentials)
+    retMsg["token"] = WebApi.issueAuthToken();
+    retMsg["token_lifetime"] = WebApi.getAuthTokenLifetimeSeconds();
+
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
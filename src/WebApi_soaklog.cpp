@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_soaklog.h"
+#include "SoakLog.h"
+#include "WebApi.h"
+#include "WebApi_errors.h"
+#include <AsyncJson.h>
+
+void WebApiSoakLogClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/soaklog/status", HTTP_GET, std::bind(&WebApiSoakLogClass::onSoakLogStatus, this, _1));
+    server.on("/api/soaklog/start", HTTP_POST, std::bind(&WebApiSoakLogClass::onSoakLogStart, this, _1));
+    server.on("/api/soaklog/stop", HTTP_POST, std::bind(&WebApiSoakLogClass::onSoakLogStop, this, _1));
+}
+
+void WebApiSoakLogClass::onSoakLogStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["running"] = SoakLog.isRunning();
+    root["records"] = SoakLog.getSequence();
+    root["capacity"] = SOAKLOG_RECORD_COUNT;
+    root["file"] = SOAKLOG_FILENAME;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiSoakLogClass::onSoakLogStart(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+
+    if (!SoakLog.start()) {
+        retMsg["message"] = "Failed to start soak log!";
+        retMsg["code"] = WebApiError::GenericInternalServerError;
+        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        return;
+    }
+
+    retMsg["type"] = "success";
+    retMsg["file"] = SOAKLOG_FILENAME;
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
+
+void WebApiSoakLogClass::onSoakLogStop(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+
+    SoakLog.stop();
+
+    retMsg["type"] = "success";
+    retMsg["records"] = SoakLog.getSequence();
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
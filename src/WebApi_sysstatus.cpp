@@ -3,9 +3,15 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "WebApi_sysstatus.h"
+#include "BootProfiler.h"
 #include "Configuration.h"
+#include "CrashRecorder.h"
+#include "HeapMonitor.h"
+#include "JsonArena.h"
 #include "NetworkSettings.h"
 #include "PinMapping.h"
+#include "SyslogLogger.h"
+#include "ThermalGovernor.h"
 #include "WebApi.h"
 #include "__compiled_constants.h"
 #include <AsyncJson.h>
@@ -46,6 +52,13 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root["sketch_used"] = ESP.getSketchSize();
     root["littlefs_total"] = LittleFS.totalBytes();
     root["littlefs_used"] = LittleFS.usedBytes();
+    root["syslog_dropped_lines"] = Syslog.getDroppedLines();
+    HeapMonitor.serialize(root["heap_monitor"].to<JsonObject>());
+    ThermalGovernor.serialize(root["thermal"].to<JsonObject>());
+    root["jsonarena_mqtt_size"] = MqttPayloadArena.size();
+    root["jsonarena_mqtt_hwm"] = MqttPayloadArena.highWaterMark();
+    root["jsonarena_livedata_size"] = LivedataArena.size();
+    root["jsonarena_livedata_hwm"] = LivedataArena.highWaterMark();
 
     root["chiprevision"] = ESP.getChipRevision();
     root["chipmodel"] = ESP.getChipModel();
@@ -86,6 +99,12 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
 
     root["uptime"] = esp_timer_get_time() / 1000000;
 
+    BootProfiler.serialize(root["boot_profile"].to<JsonObject>());
+
+    if (CrashRecorder.hasReport()) {
+        CrashRecorder.serialize(root["crash_report"].to<JsonObject>());
+    }
+
     root["nrf_configured"] = PinMapping.isValidNrf24Config();
     root["nrf_connected"] = Hoymiles.getRadioNrf()->isConnected();
     root["nrf_pvariant"] = Hoymiles.getRadioNrf()->isPVariant();
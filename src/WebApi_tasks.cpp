@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_tasks.h"
+#include "AllocMonitor.h"
+#include "SchedulerMonitor.h"
+#include "TaskMonitor.h"
+#include "Utils.h"
+#include "WebApi.h"
+#include <AsyncJson.h>
+
+void WebApiTasksClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/system/tasks", HTTP_GET, std::bind(&WebApiTasksClass::onTasksGet, this, _1));
+}
+
+void WebApiTasksClass::onTasksGet(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    auto rootObj = root.to<JsonObject>();
+    TaskMonitor.serialize(rootObj);
+    SchedulerMonitor.serialize(rootObj["scheduler"].to<JsonObject>());
+    AllocMonitor.serialize(rootObj["allocations"].to<JsonObject>());
+    Utils::PooledJsonDocument::serializeStats(rootObj["json_pool"].to<JsonObject>());
+
+    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+}
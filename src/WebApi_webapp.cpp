@@ -3,45 +3,193 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "WebApi_webapp.h"
+#include "RestartHelper.h"
+#include "WebApi.h"
 #include <MD5Builder.h>
-#include <__compiled_constants.h>
-
-extern const uint8_t file_index_html_start[] asm("_binary_webapp_dist_index_html_gz_start");
-extern const uint8_t file_favicon_ico_start[] asm("_binary_webapp_dist_favicon_ico_start");
-extern const uint8_t file_favicon_png_start[] asm("_binary_webapp_dist_favicon_png_start");
-extern const uint8_t file_zones_json_start[] asm("_binary_webapp_dist_zones_json_gz_start");
-extern const uint8_t file_app_js_start[] asm("_binary_webapp_dist_js_app_js_gz_start");
-extern const uint8_t file_site_webmanifest_start[] asm("_binary_webapp_dist_site_webmanifest_start");
-
-extern const uint8_t file_index_html_end[] asm("_binary_webapp_dist_index_html_gz_end");
-extern const uint8_t file_favicon_ico_end[] asm("_binary_webapp_dist_favicon_ico_end");
-extern const uint8_t file_favicon_png_end[] asm("_binary_webapp_dist_favicon_png_end");
-extern const uint8_t file_zones_json_end[] asm("_binary_webapp_dist_zones_json_gz_end");
-extern const uint8_t file_app_js_end[] asm("_binary_webapp_dist_js_app_js_gz_end");
-extern const uint8_t file_site_webmanifest_end[] asm("_binary_webapp_dist_site_webmanifest_end");
-
-void WebApiWebappClass::responseBinaryDataWithETagCache(AsyncWebServerRequest* request, const String& contentType, const String& contentEncoding, const uint8_t* content, size_t len)
+#include <Update.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <string.h>
+
+#undef TAG
+static const char* TAG = "webapp";
+
+// Image layout produced by pio-scripts/build_webapp_image.py: this
+// header, the asset table and the concatenated payloads. All offsets
+// are relative to the start of the image, the CRC covers everything
+// after the header. Image version 2 reinterprets the former gzip flag
+// as an encoding id and may carry the same path once per encoding;
+// version 1 images remain readable since gzip's id matches the flag.
+struct WebappImageHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t size; // bytes following the header (table + payload)
+    uint32_t crc;
+};
+
+struct WebappImageEntry {
+    char path[32]; // route without leading slash, e.g. "js/app.js"
+    uint32_t offset;
+    uint32_t size;
+    uint8_t encoding; // AssetEncoding: 0 = identity, 1 = gzip, 2 = brotli
+    uint8_t reserved[3];
+};
+
+static constexpr uint32_t webappImageMagic = 0x4F574150; // "OWAP"
+static constexpr uint32_t webappImageMaxVersion = 2;
+// Brotli siblings double the worst-case entry count
+static constexpr uint32_t webappMaxAssets = 128;
+
+static const char webappMissingPage[] = "<!DOCTYPE html><html><head><title>OpenDTU</title></head><body>"
+    "<h1>OpenDTU</h1><p>The web application is not installed. Flash the webapp "
+    "partition or upload a webapp image via POST to /api/webapp/update.</p>"
+    "</body></html>";
+
+static String contentTypeFor(const String& path)
+{
+    if (path.endsWith(".html")) {
+        return "text/html";
+    }
+    if (path.endsWith(".js")) {
+        return "text/javascript";
+    }
+    if (path.endsWith(".json") || path.endsWith(".webmanifest")) {
+        return "application/json";
+    }
+    if (path.endsWith(".ico")) {
+        return "image/x-icon";
+    }
+    if (path.endsWith(".png")) {
+        return "image/png";
+    }
+    if (path.endsWith(".css")) {
+        return "text/css";
+    }
+    if (path.endsWith(".svg")) {
+        return "image/svg+xml";
+    }
+    return "application/octet-stream";
+}
+
+bool WebApiWebappClass::loadAssetTable()
 {
-    auto md5 = MD5Builder();
-    md5.begin();
-    md5.add(const_cast<uint8_t*>(content), len);
+    _assets.clear();
+    _imageBase = nullptr;
 
-    // ensure ETag uniqueness per version by including Git commit hash. force
-    // browsers to reload dependent resources like app.js and zones.json even
-    // when index.html content hasn't actually changed between versions.
-    md5.add(String(__COMPILED_GIT_HASH__));
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "webapp");
+    if (partition == nullptr) {
+        ESP_LOGW(TAG, "No webapp partition in the partition table");
+        return false;
+    }
 
-    md5.calculate();
+    // The mapping is kept for the lifetime of the firmware - responses
+    // reference the mapped flash directly, so it must never go away
+    const void* base = nullptr;
+    esp_partition_mmap_handle_t handle;
+    if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &base, &handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to memory-map the webapp partition");
+        return false;
+    }
 
-    String expectedEtag;
-    expectedEtag = "\"";
-    expectedEtag += md5.toString();
-    expectedEtag += "\"";
+    const uint8_t* image = static_cast<const uint8_t*>(base);
+    WebappImageHeader header;
+    memcpy(&header, image, sizeof(header));
+
+    if (header.magic != webappImageMagic
+        || header.version == 0
+        || header.version > webappImageMaxVersion
+        || header.count == 0
+        || header.count > webappMaxAssets
+        || header.size > partition->size - sizeof(header)
+        || header.size < header.count * sizeof(WebappImageEntry)) {
+        ESP_LOGW(TAG, "Webapp image header rejected");
+        esp_partition_munmap(handle);
+        return false;
+    }
 
+    if (esp_rom_crc32_le(0, image + sizeof(header), header.size) != header.crc) {
+        ESP_LOGE(TAG, "Webapp image checksum mismatch");
+        esp_partition_munmap(handle);
+        return false;
+    }
+
+    const uint32_t imageSize = sizeof(header) + header.size;
+    for (uint32_t i = 0; i < header.count; i++) {
+        WebappImageEntry entry;
+        memcpy(&entry, image + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        entry.path[sizeof(entry.path) - 1] = '\0';
+
+        if (entry.offset > imageSize || entry.size > imageSize - entry.offset) {
+            ESP_LOGW(TAG, "Webapp asset %s out of bounds, skipping", entry.path);
+            continue;
+        }
+        if (entry.encoding > static_cast<uint8_t>(AssetEncoding::Brotli)) {
+            ESP_LOGW(TAG, "Webapp asset %s has unknown encoding, skipping", entry.path);
+            continue;
+        }
+
+        // ensure ETag uniqueness per webapp image by including its
+        // checksum. force browsers to reload dependent resources like
+        // app.js and zones.json even when index.html content hasn't
+        // actually changed between versions.
+        auto md5 = MD5Builder();
+        md5.begin();
+        md5.add(const_cast<uint8_t*>(image + entry.offset), entry.size);
+        md5.add(String(header.crc, HEX));
+        md5.calculate();
+        String etag = "\"" + md5.toString() + "\"";
+
+        _assets.push_back({ String(entry.path), contentTypeFor(String(entry.path)),
+            static_cast<AssetEncoding>(entry.encoding), image + entry.offset, entry.size,
+            std::move(etag) });
+    }
+
+    _imageBase = image;
+    _imageCrc = header.crc;
+    ESP_LOGI(TAG, "Serving %u webapp assets from flash partition", static_cast<unsigned>(_assets.size()));
+    return true;
+}
+
+const WebApiWebappClass::WebappAsset* WebApiWebappClass::findAsset(const String& url, const bool acceptsBrotli) const
+{
+    String path = url;
+    if (path.startsWith("/")) {
+        path = path.substring(1);
+    }
+    if (path.isEmpty()) {
+        path = "index.html";
+    }
+
+    // The same path may exist once per encoding; brotli wins when the
+    // client accepts it, otherwise the gzip/identity variant is served
+    const WebappAsset* fallback = nullptr;
+    for (const auto& asset : _assets) {
+        if (asset.path != path) {
+            continue;
+        }
+        if (asset.encoding == AssetEncoding::Brotli) {
+            if (acceptsBrotli) {
+                return &asset;
+            }
+            continue;
+        }
+        fallback = &asset;
+        if (!acceptsBrotli) {
+            break;
+        }
+    }
+    return fallback;
+}
+
+void WebApiWebappClass::serveAsset(AsyncWebServerRequest* request, const WebappAsset& asset)
+{
     bool eTagMatch = false;
     if (request->hasHeader("If-None-Match")) {
         const AsyncWebHeader* h = request->getHeader("If-None-Match");
-        eTagMatch = h->value().equals(expectedEtag);
+        eTagMatch = h->value().equals(asset.etag);
     }
 
     // begin response 200 or 304
@@ -49,55 +197,118 @@ void WebApiWebappClass::responseBinaryDataWithETagCache(AsyncWebServerRequest* r
     if (eTagMatch) {
         response = request->beginResponse(304);
     } else {
-        response = request->beginResponse(200, contentType, content, len);
-        if (contentEncoding.length() > 0) {
-            response->addHeader("Content-Encoding", contentEncoding);
+        response = request->beginResponse(200, asset.contentType, asset.data, asset.size);
+        if (asset.encoding == AssetEncoding::Gzip) {
+            response->addHeader("Content-Encoding", "gzip");
+        } else if (asset.encoding == AssetEncoding::Brotli) {
+            response->addHeader("Content-Encoding", "br");
         }
     }
 
     // HTTP requires cache headers in 200 and 304 to be identical
     response->addHeader("Cache-Control", "public, must-revalidate");
-    response->addHeader("ETag", expectedEtag);
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Vary", "Accept-Encoding");
 
     request->send(response);
 }
 
 void WebApiWebappClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    using std::placeholders::_3;
+    using std::placeholders::_4;
+    using std::placeholders::_5;
+    using std::placeholders::_6;
+
+    if (!loadAssetTable()) {
+        ESP_LOGW(TAG, "Serving placeholder page until a webapp image is installed");
+    }
+
+    server.on("/api/webapp/update", HTTP_POST,
+        std::bind(&WebApiWebappClass::onWebappUpdateFinish, this, _1),
+        std::bind(&WebApiWebappClass::onWebappUpdateUpload, this, _1, _2, _3, _4, _5, _6));
+
     /*
-       We don't validate the request header "Accept-Encoding" if gzip compression is supported!
-       We just have the gzipped data available - so we ship them!
+       The asset table drives the routing: every request no other handler
+       claimed is looked up in the table, unknown paths fall back to
+       index.html so SPA routes keep working. Gzip is assumed to be
+       acceptable (every browser sends it), brotli is negotiated per
+       request via Accept-Encoding.
     */
+    server.onNotFound([&](AsyncWebServerRequest* request) {
+        bool acceptsBrotli = false;
+        if (request->hasHeader("Accept-Encoding")) {
+            acceptsBrotli = request->getHeader("Accept-Encoding")->value().indexOf("br") >= 0;
+        }
 
-    server.on("/", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
+        const WebappAsset* asset = findAsset(request->url(), acceptsBrotli);
+        if (asset == nullptr) {
+            asset = findAsset("/index.html", acceptsBrotli);
+        }
+        if (asset == nullptr) {
+            request->send(200, "text/html", webappMissingPage);
+            return;
+        }
+        serveAsset(request, *asset);
     });
+}
 
-    server.onNotFound([&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
-    });
+void WebApiWebappClass::onWebappUpdateFinish(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
 
-    server.on("/index.html", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
-    });
+    // the request handler is triggered after the upload has finished...
+    // create the response, add header, and send response
 
-    server.on("/favicon.ico", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "image/x-icon", "", file_favicon_ico_start, file_favicon_ico_end - file_favicon_ico_start);
-    });
+    AsyncWebServerResponse* response = request->beginResponse((Update.hasError()) ? 500 : 200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+    response->addHeader("Connection", "close");
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(response);
 
-    server.on("/favicon.png", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "image/png", "", file_favicon_png_start, file_favicon_png_end - file_favicon_png_start);
-    });
+    // Restart instead of remapping in place: in-flight responses may
+    // still reference the old mapping
+    RestartHelper.triggerRestart();
+}
 
-    server.on("/zones.json", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "application/json", "gzip", file_zones_json_start, file_zones_json_end - file_zones_json_start);
-    });
+void WebApiWebappClass::onWebappUpdateUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
 
-    server.on("/site.webmanifest", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "application/json", "", file_site_webmanifest_start, file_site_webmanifest_end - file_site_webmanifest_start);
-    });
+    // Upload handler chunks in data
+    if (!index) {
+        if (!request->hasParam("MD5", true)) {
+            return request->send(400, "text/plain", "MD5 parameter missing");
+        }
 
-    server.on("/js/app.js", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/javascript", "gzip", file_app_js_start, file_app_js_end - file_app_js_start);
-    });
+        if (!Update.setMD5(request->getParam("MD5", true)->value().c_str())) {
+            return request->send(400, "text/plain", "MD5 parameter invalid");
+        }
+
+        if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_SPIFFS, -1, LOW, "webapp")) {
+            Update.printError(Serial);
+            return request->send(400, "text/plain", "Webapp update could not begin");
+        }
+    }
+
+    // Write chunked data to the webapp partition
+    if (len) {
+        if (Update.write(data, len) != len) {
+            return request->send(400, "text/plain", "Webapp update could not begin");
+        }
+    }
+
+    if (final) { // if the final flag is set then this is the last frame of data
+        if (!Update.end(true)) { // true to set the size to the current progress
+            Update.printError(Serial);
+            return request->send(400, "text/plain", "Could not end webapp update");
+        }
+    } else {
+        return;
+    }
 }
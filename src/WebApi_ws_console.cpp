@@ -4,6 +4,7 @@
  */
 #include "WebApi_ws_console.h"
 #include "Configuration.h"
+#include "HeapMonitor.h"
 #include "MessageOutput.h"
 #include "WebApi.h"
 #include "defaults.h"
@@ -16,11 +17,21 @@ WebApiWsConsoleClass::WebApiWsConsoleClass()
 
 void WebApiWsConsoleClass::init(AsyncWebServer& server, Scheduler& scheduler)
 {
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    using std::placeholders::_3;
+    using std::placeholders::_4;
+    using std::placeholders::_5;
+    using std::placeholders::_6;
+
     server.addHandler(&_ws);
-    MessageOutput.register_ws_output(&_ws);
+    _ws.onEvent(std::bind(&WebApiWsConsoleClass::onEvent, this, _1, _2, _3, _4, _5, _6));
+    MessageOutput.register_line_sink(this);
 
     scheduler.addTask(_wsCleanupTask);
-    _wsCleanupTask.enable();
+    Utils::enableStaggered(_wsCleanupTask);
+
+    HeapMonitor.registerLoadShedder("ws_console", [this]() { _ws.closeAll(); });
 
     _simpleDigestAuth.setUsername(AUTH_USERNAME);
     _simpleDigestAuth.setRealm("console websocket");
@@ -45,8 +56,187 @@ void WebApiWsConsoleClass::reload()
     _ws.enable(true);
 }
 
+void WebApiWsConsoleClass::onEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
+    AwsEventType type, void* arg, uint8_t* data, size_t len)
+{
+    if (type == WS_EVT_CONNECT) {
+        auto* request = static_cast<AsyncWebServerRequest*>(arg);
+
+        ClientState state;
+        if (request->hasParam("level")) {
+            state.maxSeverity = severityRank(request->getParam("level")->value().charAt(0));
+        }
+        if (request->hasParam("tag")) {
+            state.tagFilter = request->getParam("tag")->value();
+        }
+
+        std::lock_guard<std::mutex> lock(_clientMutex);
+        _clients[client->id()] = std::move(state);
+    } else if (type == WS_EVT_DISCONNECT) {
+        std::lock_guard<std::mutex> lock(_clientMutex);
+        _clients.erase(client->id());
+    }
+}
+
+uint8_t WebApiWsConsoleClass::severityRank(char level)
+{
+    switch (level) {
+    case 'E':
+        return 1;
+    case 'W':
+        return 2;
+    case 'I':
+        return 3;
+    case 'D':
+        return 4;
+    case 'V':
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+bool WebApiWsConsoleClass::parseLine(const uint8_t* buffer, size_t size, uint8_t& severity, String& tag)
+{
+    size_t pos = 0;
+
+    // skip the optional ANSI color escape sequence ("\e[0;32m" etc.)
+    if (pos + 1 < size && buffer[pos] == 0x1b && buffer[pos + 1] == '[') {
+        pos += 2;
+        while (pos < size && buffer[pos] != 'm') {
+            pos++;
+        }
+        if (pos >= size) {
+            return false;
+        }
+        pos++;
+    }
+
+    // default esp_log format: "I (12345) tag: message"
+    if (pos >= size) {
+        return false;
+    }
+    severity = severityRank(static_cast<char>(buffer[pos]));
+    if (severity == 0) {
+        return false;
+    }
+    pos++;
+
+    if (pos + 1 >= size || buffer[pos] != ' ' || buffer[pos + 1] != '(') {
+        return false;
+    }
+    while (pos < size && buffer[pos] != ')') {
+        pos++;
+    }
+    pos += 2; // skip ") "
+
+    const size_t start = pos;
+    while (pos < size && buffer[pos] != ':') {
+        pos++;
+    }
+    if (pos >= size || pos == start) {
+        return false;
+    }
+
+    tag = "";
+    tag.concat(reinterpret_cast<const char*>(buffer + start), pos - start);
+    return true;
+}
+
+bool WebApiWsConsoleClass::tagMatches(const String& filter, const String& tag)
+{
+    String haystack = ",";
+    haystack += filter;
+    haystack += ",";
+
+    String needle = ",";
+    needle += tag;
+    needle += ",";
+
+    return haystack.indexOf(needle) >= 0;
+}
+
+void WebApiWsConsoleClass::writeLine(const uint8_t* buffer, size_t size)
+{
+    std::lock_guard<std::mutex> lock(_clientMutex);
+
+    if (_clients.empty()) {
+        return;
+    }
+
+    // lines that do not carry a severity/TAG (raw prints, internal
+    // warnings) always pass the filters
+    uint8_t severity = 0;
+    String tag;
+    const bool parsed = parseLine(buffer, size, severity, tag);
+
+    for (auto& client : _ws.getClients()) {
+        const auto it = _clients.find(client.id());
+        if (it == _clients.end()) {
+            continue;
+        }
+        auto& state = it->second;
+
+        if (parsed) {
+            if (state.maxSeverity != 0 && severity > state.maxSeverity) {
+                continue;
+            }
+            if (!state.tagFilter.isEmpty() && !tagMatches(state.tagFilter, tag)) {
+                continue;
+            }
+        }
+
+        if (!state.chunk) {
+            state.chunk = std::make_shared<message_t>();
+            state.chunk->reserve(WS_CHUNK_SIZE_BYTES + 128); // add room for one more line
+        }
+        state.chunk->insert(state.chunk->end(), buffer, buffer + size);
+
+        const bool small = state.chunk->size() < WS_CHUNK_SIZE_BYTES;
+        const bool recent = (millis() - state.lastSent) < WS_CHUNK_INTERVAL_MS;
+        if (!small || !recent) {
+            flushClient(client, state);
+        }
+    }
+}
+
+void WebApiWsConsoleClass::flushClient(AsyncWebSocketClient& client, ClientState& state)
+{
+    if (!state.chunk || state.chunk->empty()) {
+        return;
+    }
+
+    if (client.queueIsFull()) {
+        // the client is not draining its queue - drop the whole chunk
+        // rather than buffering unbounded amounts of log output
+        state.chunk = nullptr;
+        state.dropped = true;
+        return;
+    }
+
+    if (state.dropped) {
+        static char const warningStr[] = "\nWARNING: websocket client's queue ran full, log lines were dropped\n";
+        state.chunk->insert(state.chunk->end(), warningStr, warningStr + sizeof(warningStr) - 1);
+        state.dropped = false;
+    }
+
+    client.text(state.chunk);
+    state.chunk = nullptr;
+    state.lastSent = millis();
+}
+
 void WebApiWsConsoleClass::wsCleanupTaskCb()
 {
     // see: https://github.com/me-no-dev/ESPAsyncWebServer#limiting-the-number-of-web-socket-clients
     _ws.cleanupClients();
+    WebApi.evictStalledClients(_ws, _stalledClients);
+
+    // flush partial chunks that did not fill up within the send interval
+    std::lock_guard<std::mutex> lock(_clientMutex);
+    for (auto& client : _ws.getClients()) {
+        const auto it = _clients.find(client.id());
+        if (it != _clients.end()) {
+            flushClient(client, it->second);
+        }
+    }
 }
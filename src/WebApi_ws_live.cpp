@@ -4,10 +4,16 @@
  */
 #include "WebApi_ws_live.h"
 #include "Datastore.h"
+#include "HeapMonitor.h"
+#include "JsonArena.h"
+#include "SchedulerMonitor.h"
+#include "ThermalGovernor.h"
 #include "Utils.h"
 #include "WebApi.h"
 #include "defaults.h"
 #include <AsyncJson.h>
+#include <CyclePerf.h>
+#include <cmath>
 
 #undef TAG
 static const char* TAG = "webapi";
@@ -16,6 +22,50 @@ static const char* TAG = "webapi";
 #define PIN_MAPPING_REQUIRED 0
 #endif
 
+// Admission control for connect bursts (a classroom opening the
+// dashboard): how many queued clients receive snapshot frames per
+// tick, and how many inverter frames each of them gets per tick
+#ifndef WS_LIVE_SNAPSHOT_CONCURRENCY
+#define WS_LIVE_SNAPSHOT_CONCURRENCY 2
+#endif
+#ifndef WS_LIVE_SNAPSHOT_INVERTERS_PER_TICK
+#define WS_LIVE_SNAPSHOT_INVERTERS_PER_TICK 2
+#endif
+
+// Viewer counts above these thresholds drop the push cadence to the
+// reduced (2s) respectively degraded (5s) quality level
+#ifndef WS_LIVE_REDUCED_THRESHOLD
+#define WS_LIVE_REDUCED_THRESHOLD 6
+#endif
+#ifndef WS_LIVE_DEGRADED_THRESHOLD
+#define WS_LIVE_DEGRADED_THRESHOLD 12
+#endif
+
+static const char* qualityName(const uint8_t level)
+{
+    switch (level) {
+    case 1:
+        return "reduced";
+    case 2:
+        return "degraded";
+    default:
+        return "full";
+    }
+}
+
+// Fixed-precision value rendering: a float widened to double would
+// serialize as e.g. "20.10000038"; formatting at the field's digits
+// metadata ships "20.10" instead, matching the MQTT payload format.
+// Everything beyond the digits is measurement noise anyway
+static void setRoundedValue(JsonVariant dst, const float value, const uint8_t digits)
+{
+    if (std::isfinite(value)) {
+        dst.set(serialized(String(value, digits)));
+    } else {
+        dst.set(value);
+    }
+}
+
 WebApiWsLiveClass::WebApiWsLiveClass()
     : _ws("/livedata")
     , _wsCleanupTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiWsLiveClass::wsCleanupTaskCb, this))
@@ -38,10 +88,40 @@ void WebApiWsLiveClass::init(AsyncWebServer& server, Scheduler& scheduler)
     _ws.onEvent(std::bind(&WebApiWsLiveClass::onWebsocketEvent, this, _1, _2, _3, _4, _5, _6));
 
     scheduler.addTask(_wsCleanupTask);
-    _wsCleanupTask.enable();
+    Utils::enableStaggered(_wsCleanupTask);
 
     scheduler.addTask(_sendDataTask);
-    _sendDataTask.enable();
+    SchedulerMonitor.instrument("ws_live", _sendDataTask, std::bind(&WebApiWsLiveClass::sendDataTaskCb, this));
+    Utils::enableStaggered(_sendDataTask);
+
+    // Push frames the moment fresh data arrives; the per-inverter
+    // change detection in sendDataTaskCb keeps extra passes cheap and
+    // the interval remains as a heartbeat for data_age updates.
+    InverterAbstract::onStatisticsUpdated([this](InverterAbstract&) {
+        _sendDataTask.forceNextIteration();
+    });
+    InverterAbstract::onAlarmLogUpdated([this](InverterAbstract&) {
+        _sendDataTask.forceNextIteration();
+    });
+
+    // Compact clients decode data frames against a schema sent after
+    // connecting; panel names and the like live in that schema, so a
+    // changed inverter config means it has to go out again
+    Configuration.onConfigChanged([this](const ConfigScope scope, const int8_t index) {
+        if (scope == ConfigScope::Inverter || scope == ConfigScope::All) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _schemaPending = _compactClients;
+            _sendDataTask.forceNextIteration();
+        }
+    });
+    HeapMonitor.registerLoadShedder("ws_livedata", [this]() { _ws.closeAll(); });
+    // the governor runs on the main scheduler, so the flag is read and
+    // written from the same context; updatePushQuality folds it into
+    // the effective cadence
+    ThermalGovernor.registerThrottle("ws_live_rate", [this](const bool active) {
+        _thermalThrottled = active;
+    });
+
     _simpleDigestAuth.setUsername(AUTH_USERNAME);
     _simpleDigestAuth.setRealm("live websocket");
 
@@ -69,6 +149,106 @@ void WebApiWsLiveClass::wsCleanupTaskCb()
 {
     // see: https://github.com/me-no-dev/ESPAsyncWebServer#limiting-the-number-of-web-socket-clients
     _ws.cleanupClients();
+    WebApi.evictStalledClients(_ws, _stalledClients);
+}
+
+void WebApiWsLiveClass::updatePushQuality()
+{
+    const size_t viewers = _ws.count();
+
+    uint8_t level = 0;
+    if (viewers > WS_LIVE_DEGRADED_THRESHOLD) {
+        level = 2;
+    } else if (viewers > WS_LIVE_REDUCED_THRESHOLD) {
+        level = 1;
+    }
+    if (_thermalThrottled && level < 2) {
+        level = 2;
+    }
+
+    if (level != _qualityLevel) {
+        ESP_LOGI(TAG, "Websocket push quality now %s (%u viewers)",
+            qualityName(level), static_cast<unsigned>(viewers));
+        _qualityLevel = level;
+    }
+}
+
+bool WebApiWsLiveClass::isAdmitting(const uint32_t clientId) const
+{
+    for (const auto& pending : _admissionQueue) {
+        if (pending.id == clientId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WebApiWsLiveClass::admitClients()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_admissionQueue.empty()) {
+        return;
+    }
+
+    const uint8_t numInverters = Hoymiles.getNumInverters();
+
+    uint8_t active = 0;
+    for (auto it = _admissionQueue.begin();
+        it != _admissionQueue.end() && active < WS_LIVE_SNAPSHOT_CONCURRENCY;) {
+        AsyncWebSocketClient* client = _ws.client(it->id);
+        if (client == nullptr || client->status() != WS_CONNECTED) {
+            it = _admissionQueue.erase(it);
+            continue;
+        }
+        active++;
+
+        const bool compact = _compactClients.count(it->id) > 0;
+
+        uint8_t sent = 0;
+        while (it->nextInverter < numInverters && sent < WS_LIVE_SNAPSHOT_INVERTERS_PER_TICK) {
+            if (client->queueIsFull()) {
+                // the snapshot resumes where it stopped next tick
+                break;
+            }
+
+            auto inv = Hoymiles.getInverterByPos(it->nextInverter);
+            it->nextInverter++;
+            if (inv == nullptr) {
+                continue;
+            }
+
+            try {
+                LivedataArena.reset();
+                JsonDocument root(&LivedataArena);
+                JsonVariant var = root;
+
+                auto invArray = var["inverters"].to<JsonArray>();
+                auto invObject = invArray.add<JsonObject>();
+                generateCommonJsonResponse(var);
+                generateInverterCommonJsonResponse(invObject, inv);
+                generateInverterChannelJsonResponse(invObject, inv, 0, compact);
+                var["quality"] = qualityName(_qualityLevel);
+
+                if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                    break;
+                }
+
+                String buffer;
+                serializeJson(root, buffer);
+                client->text(buffer);
+                sent++;
+            } catch (const std::bad_alloc& bad_alloc) {
+                ESP_LOGE(TAG, "Snapshot frame for /livedata temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+                return;
+            }
+        }
+
+        if (it->nextInverter >= numInverters) {
+            it = _admissionQueue.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void WebApiWsLiveClass::sendDataTaskCb()
@@ -78,6 +258,24 @@ void WebApiWsLiveClass::sendDataTaskCb()
         return;
     }
 
+    updatePushQuality();
+
+    if (!_schemaPending.empty()) {
+        sendSchemaFrames();
+    }
+
+    // New viewers receive their initial snapshots in bounded slices
+    // regardless of how many connected at once
+    admitClients();
+
+    // Under reduced/degraded quality the statistics-update triggers
+    // keep firing, but full fleet passes run at the degraded cadence
+    const uint32_t minPassInterval = (_qualityLevel == 2 ? 5 : (_qualityLevel == 1 ? 2 : 0)) * 1000;
+    if (minPassInterval > 0 && millis() - _lastFleetPass < minPassInterval) {
+        return;
+    }
+    _lastFleetPass = millis();
+
     // Loop all inverters
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
@@ -94,24 +292,119 @@ void WebApiWsLiveClass::sendDataTaskCb()
 
         try {
             std::lock_guard<std::mutex> lock(_mutex);
-            JsonDocument root;
-            JsonVariant var = root;
 
-            auto invArray = var["inverters"].to<JsonArray>();
-            auto invObject = invArray.add<JsonObject>();
+            // Covers frame building and serialization for this inverter
+            CYCLE_PERF_SCOPE("ws_live_send");
 
-            generateCommonJsonResponse(var);
-            generateInverterCommonJsonResponse(invObject, inv);
-            generateInverterChannelJsonResponse(invObject, inv);
+            const uint32_t changedSince = _lastPublishedStatsVersion[i];
+            if (lastUpdateInternal > 0) {
+                _lastPublishedStatsVersion[i] = lastUpdateInternal;
+            }
+
+            auto buildFrame = [this, &inv](JsonDocument& root, const uint32_t since, const bool compact) {
+                JsonVariant var = root;
 
-            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                auto invArray = var["inverters"].to<JsonArray>();
+                auto invObject = invArray.add<JsonObject>();
+
+                generateCommonJsonResponse(var);
+                generateInverterCommonJsonResponse(invObject, inv);
+                generateInverterChannelJsonResponse(invObject, inv, since, compact);
+
+                if (since > 0) {
+                    var["delta"] = true;
+                }
+                var["quality"] = qualityName(_qualityLevel);
+            };
+
+            // Which of the four frame flavors (full/delta times
+            // verbose/compact) the connected audience actually needs. A
+            // delta frame needs a baseline, the first frame after a
+            // (re)connect is always a full snapshot
+            const bool deltaPossible = changedSince > 0;
+
+            bool wanted[2][2] = {};
+            for (auto& client : _ws.getClients()) {
+                if (client.status() != WS_CONNECTED || isAdmitting(client.id())) {
+                    // clients still receiving their initial snapshot
+                    // join the regular fan-out once it completed
+                    continue;
+                }
+                const bool delta = deltaPossible && _deltaClients.count(client.id()) > 0;
+                const bool compact = _compactClients.count(client.id()) > 0;
+                wanted[delta ? 1 : 0][compact ? 1 : 0] = true;
+            }
+
+            const uint8_t flavors = wanted[0][0] + wanted[0][1] + wanted[1][0] + wanted[1][1];
+            if (flavors == 0) {
+                continue;
+            }
+
+            if (flavors == 1 && _admissionQueue.empty()) {
+                // One flavor fits all clients
+                const bool delta = wanted[1][0] || wanted[1][1];
+                const bool compact = wanted[0][1] || wanted[1][1];
+
+                LivedataArena.reset();
+                JsonDocument root(&LivedataArena);
+                buildFrame(root, delta ? changedSince : 0, compact);
+
+                if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                    continue;
+                }
+
+                // Serialize once straight into the websocket's shared
+                // message buffer. All connected clients reference the
+                // same buffer, so fan-out cost no longer scales with
+                // the number of viewers.
+                const size_t len = measureJson(root);
+                auto buffer = _ws.makeBuffer(len);
+                if (buffer == nullptr) {
+                    continue;
+                }
+                serializeJson(root, buffer->get(), len);
+
+                _ws.textAll(buffer);
                 continue;
             }
 
-            String buffer;
-            serializeJson(root, buffer);
+            // Mixed audience: render each needed flavor once and
+            // address the clients individually. The documents share the
+            // arena, it is only reset before the next frame
+            LivedataArena.reset();
+            String buffers[2][2];
+            bool rendered = true;
+            for (uint8_t d = 0; d < 2 && rendered; d++) {
+                for (uint8_t k = 0; k < 2; k++) {
+                    if (!wanted[d][k]) {
+                        continue;
+                    }
+                    JsonDocument root(&LivedataArena);
+                    buildFrame(root, d != 0 ? changedSince : 0, k != 0);
+                    if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+                        rendered = false;
+                        break;
+                    }
+                    serializeJson(root, buffers[d][k]);
+                }
+            }
+            if (!rendered) {
+                continue;
+            }
 
-            _ws.textAll(buffer);
+            for (auto& client : _ws.getClients()) {
+                if (client.status() != WS_CONNECTED || client.queueIsFull()) {
+                    // Never enqueue behind a stalled client, the
+                    // cleanup task evicts it if it does not recover
+                    continue;
+                }
+                if (isAdmitting(client.id())) {
+                    continue;
+                }
+                const bool delta = deltaPossible && _deltaClients.count(client.id()) > 0;
+                const bool compact = _compactClients.count(client.id()) > 0;
+                client.text(buffers[delta ? 1 : 0][compact ? 1 : 0]);
+            }
 
         } catch (const std::bad_alloc& bad_alloc) {
             ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -124,9 +417,10 @@ void WebApiWsLiveClass::sendDataTaskCb()
 void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
 {
     auto totalObj = root["total"].to<JsonObject>();
-    addTotalField(totalObj, "Power", Datastore.getTotalAcPowerEnabled(), "W", Datastore.getTotalAcPowerDigits());
-    addTotalField(totalObj, "YieldDay", Datastore.getTotalAcYieldDayEnabled(), "Wh", Datastore.getTotalAcYieldDayDigits());
-    addTotalField(totalObj, "YieldTotal", Datastore.getTotalAcYieldTotalEnabled(), "kWh", Datastore.getTotalAcYieldTotalDigits());
+    const auto totals = Datastore.getTotalsSnapshot();
+    addTotalField(totalObj, "Power", totals.AcPowerEnabled, "W", totals.AcPowerDigits);
+    addTotalField(totalObj, "YieldDay", totals.AcYieldDayEnabled, "Wh", totals.AcYieldDayDigits);
+    addTotalField(totalObj, "YieldTotal", totals.AcYieldTotalEnabled, "kWh", totals.AcYieldTotalDigits);
 
     JsonObject hintObj = root["hints"].to<JsonObject>();
     struct tm timeinfo;
@@ -167,44 +461,76 @@ void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std
     root["radio_stats"]["rssi"] = inv->getLastRssi();
 }
 
-void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const uint32_t changedSince, const bool compact, const uint32_t fieldMask, const uint8_t maxPrecision)
 {
-    const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-    if (inv_cfg == nullptr) {
-        return;
-    }
+    const auto wanted = [fieldMask](const FieldId_t fieldId) {
+        return fieldMask == 0 || (fieldMask & (1ul << fieldId)) != 0;
+    };
 
     // Loop all channels
     for (auto& t : inv->Statistics()->getChannelTypes()) {
         auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
         for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-            if (t == TYPE_DC) {
-                chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv_cfg->channel[c].Name;
-            }
-            addField(chanTypeObj, inv, t, c, FLD_PAC);
-            addField(chanTypeObj, inv, t, c, FLD_UAC);
-            addField(chanTypeObj, inv, t, c, FLD_IAC);
-            if (t == TYPE_INV) {
-                addField(chanTypeObj, inv, t, c, FLD_PDC, "Power DC");
-            } else {
-                addField(chanTypeObj, inv, t, c, FLD_PDC);
-            }
-            addField(chanTypeObj, inv, t, c, FLD_UDC);
-            addField(chanTypeObj, inv, t, c, FLD_IDC);
-            addField(chanTypeObj, inv, t, c, FLD_YD);
-            addField(chanTypeObj, inv, t, c, FLD_YT);
-            addField(chanTypeObj, inv, t, c, FLD_F);
-            addField(chanTypeObj, inv, t, c, FLD_T);
-            addField(chanTypeObj, inv, t, c, FLD_PF);
-            addField(chanTypeObj, inv, t, c, FLD_Q);
-            addField(chanTypeObj, inv, t, c, FLD_EFF);
-            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
-                addField(chanTypeObj, inv, t, c, FLD_IRR);
-                chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+            if (t == TYPE_DC && changedSince == 0 && !compact && fieldMask == 0) {
+                chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv->Statistics()->getChannelName(c);
+            }
+            if (wanted(FLD_PAC)) {
+                addField(chanTypeObj, inv, t, c, FLD_PAC, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_UAC)) {
+                addField(chanTypeObj, inv, t, c, FLD_UAC, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_IAC)) {
+                addField(chanTypeObj, inv, t, c, FLD_IAC, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_PDC)) {
+                if (t == TYPE_INV) {
+                    addField(chanTypeObj, inv, t, c, FLD_PDC, changedSince, compact, maxPrecision, "Power DC");
+                } else {
+                    addField(chanTypeObj, inv, t, c, FLD_PDC, changedSince, compact, maxPrecision);
+                }
+            }
+            if (wanted(FLD_UDC)) {
+                addField(chanTypeObj, inv, t, c, FLD_UDC, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_IDC)) {
+                addField(chanTypeObj, inv, t, c, FLD_IDC, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_YD)) {
+                addField(chanTypeObj, inv, t, c, FLD_YD, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_YT)) {
+                addField(chanTypeObj, inv, t, c, FLD_YT, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_F)) {
+                addField(chanTypeObj, inv, t, c, FLD_F, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_T)) {
+                addField(chanTypeObj, inv, t, c, FLD_T, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_PF)) {
+                addField(chanTypeObj, inv, t, c, FLD_PF, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_Q)) {
+                addField(chanTypeObj, inv, t, c, FLD_Q, changedSince, compact, maxPrecision);
+            }
+            if (wanted(FLD_EFF)) {
+                addField(chanTypeObj, inv, t, c, FLD_EFF, changedSince, compact, maxPrecision);
+            }
+            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0 && wanted(FLD_IRR)) {
+                addField(chanTypeObj, inv, t, c, FLD_IRR, changedSince, compact, maxPrecision);
+                if (changedSince == 0 && !compact && fieldMask == 0) {
+                    chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+                }
             }
         }
     }
 
+    if (fieldMask != 0) {
+        // Projected queries get exactly the requested fields
+        return;
+    }
+
     if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
         root["events"] = inv->EventLog()->getEntryCount();
     } else {
@@ -212,9 +538,21 @@ void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, st
     }
 }
 
-void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic)
+void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const uint32_t changedSince, const bool compact, const uint8_t maxPrecision, String topic)
 {
     if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
+        if (changedSince > 0
+            && static_cast<int32_t>(inv->Statistics()->getChannelFieldLastChange(type, channel, fieldId) - changedSince) <= 0) {
+            // Delta frame and the value did not change since the baseline
+            return;
+        }
+        const uint8_t digits = min(inv->Statistics()->getChannelFieldDigits(type, channel, fieldId), maxPrecision);
+        if (compact) {
+            // The client resolves name, unit and digits from the
+            // schema frame; only the value travels per frame
+            setRoundedValue(root[String(channel)][String(fieldId)], inv->Statistics()->getChannelFieldValue(type, channel, fieldId), digits);
+            return;
+        }
         String chanName;
         if (topic == "") {
             chanName = inv->Statistics()->getChannelFieldName(type, channel, fieldId);
@@ -223,15 +561,98 @@ void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstr
         }
         String chanNum;
         chanNum = channel;
-        root[chanNum][chanName]["v"] = inv->Statistics()->getChannelFieldValue(type, channel, fieldId);
+        setRoundedValue(root[chanNum][chanName]["v"], inv->Statistics()->getChannelFieldValue(type, channel, fieldId), digits);
         root[chanNum][chanName]["u"] = inv->Statistics()->getChannelFieldUnit(type, channel, fieldId);
         root[chanNum][chanName]["d"] = inv->Statistics()->getChannelFieldDigits(type, channel, fieldId);
     }
 }
 
+void WebApiWsLiveClass::generateInverterSchemaJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+{
+    // Mirrors the field list of generateInverterChannelJsonResponse
+    static constexpr FieldId_t schemaFields[] = {
+        FLD_PAC, FLD_UAC, FLD_IAC, FLD_PDC, FLD_UDC, FLD_IDC,
+        FLD_YD, FLD_YT, FLD_F, FLD_T, FLD_PF, FLD_Q, FLD_EFF, FLD_IRR
+    };
+
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(t)].to<JsonObject>();
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            auto chanObj = chanTypeObj[String(static_cast<uint8_t>(c))].to<JsonObject>();
+            if (t == TYPE_DC) {
+                chanObj["name"] = inv->Statistics()->getChannelName(c);
+                if (inv->Statistics()->getStringMaxPower(c) > 0) {
+                    chanObj["max_power"] = inv->Statistics()->getStringMaxPower(c);
+                }
+            }
+            auto fieldsObj = chanObj["fields"].to<JsonObject>();
+            for (auto fieldId : schemaFields) {
+                if (!inv->Statistics()->hasChannelFieldValue(t, c, fieldId)) {
+                    continue;
+                }
+                if (fieldId == FLD_IRR && !(t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0)) {
+                    continue;
+                }
+                auto fieldObj = fieldsObj[String(fieldId)].to<JsonObject>();
+                if (t == TYPE_INV && fieldId == FLD_PDC) {
+                    fieldObj["n"] = "Power DC";
+                } else {
+                    fieldObj["n"] = inv->Statistics()->getChannelFieldName(t, c, fieldId);
+                }
+                fieldObj["u"] = inv->Statistics()->getChannelFieldUnit(t, c, fieldId);
+                fieldObj["d"] = inv->Statistics()->getChannelFieldDigits(t, c, fieldId);
+            }
+        }
+    }
+}
+
+void WebApiWsLiveClass::sendSchemaFrames()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_schemaPending.empty()) {
+        return;
+    }
+
+    try {
+        LivedataArena.reset();
+        JsonDocument root(&LivedataArena);
+        auto schemaObj = root["schema"].to<JsonObject>();
+
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv == nullptr) {
+                continue;
+            }
+            auto invObject = schemaObj[inv->serialString()].to<JsonObject>();
+            generateInverterSchemaJsonResponse(invObject, inv);
+        }
+
+        if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+            return;
+        }
+
+        String buffer;
+        serializeJson(root, buffer);
+
+        for (auto& client : _ws.getClients()) {
+            if (_schemaPending.count(client.id()) == 0) {
+                continue;
+            }
+            if (client.status() != WS_CONNECTED || client.queueIsFull()) {
+                continue;
+            }
+            client.text(buffer);
+        }
+        _schemaPending.clear();
+    } catch (const std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Schema frame for /livedata temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+    }
+}
+
 void WebApiWsLiveClass::addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits)
 {
-    root[name]["v"] = value;
+    setRoundedValue(root[name]["v"], value, digits);
     root[name]["u"] = unit;
     root[name]["d"] = digits;
 }
@@ -240,8 +661,36 @@ void WebApiWsLiveClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketC
 {
     if (type == WS_EVT_CONNECT) {
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] connect", server->url(), client->id());
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto request = static_cast<AsyncWebServerRequest*>(arg);
+        if (request != nullptr && request->hasParam("delta") && request->getParam("delta")->value() == "1") {
+            _deltaClients.insert(client->id());
+        }
+        if (request != nullptr && request->hasParam("compact") && request->getParam("compact")->value() == "1") {
+            _compactClients.insert(client->id());
+            _schemaPending.insert(client->id());
+        }
+
+        // Queue the client for its initial snapshot: it is served one
+        // inverter at a time by admitClients, so a burst of connects
+        // no longer triggers simultaneous fleet-wide full pushes
+        _admissionQueue.push_back({ client->id(), 0 });
+        _sendDataTask.forceNextIteration();
     } else if (type == WS_EVT_DISCONNECT) {
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] disconnect", server->url(), client->id());
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _deltaClients.erase(client->id());
+        _compactClients.erase(client->id());
+        _schemaPending.erase(client->id());
+        for (auto it = _admissionQueue.begin(); it != _admissionQueue.end(); ++it) {
+            if (it->id == client->id()) {
+                _admissionQueue.erase(it);
+                break;
+            }
+        }
     }
 }
 
@@ -253,34 +702,129 @@ void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
 
     try {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
-        auto invArray = root["inverters"].to<JsonArray>();
         auto serial = WebApi.parseSerialFromRequest(request);
 
+        // Field projection: "?fields=PAC,YD" restricts the channel
+        // output to the named fields, applied before serialization so
+        // unrequested fields never enter the document. Unknown tokens
+        // are ignored.
+        static const struct {
+            const char* token;
+            FieldId_t id;
+        } fieldTokens[] = {
+            { "UDC", FLD_UDC }, { "IDC", FLD_IDC }, { "PDC", FLD_PDC },
+            { "YD", FLD_YD }, { "YT", FLD_YT },
+            { "UAC", FLD_UAC }, { "IAC", FLD_IAC }, { "PAC", FLD_PAC },
+            { "F", FLD_F }, { "T", FLD_T }, { "PF", FLD_PF },
+            { "EFF", FLD_EFF }, { "IRR", FLD_IRR }, { "Q", FLD_Q }
+        };
+
+        uint32_t fieldMask = 0;
+        if (request->hasParam("fields")) {
+            String fields = request->getParam("fields")->value();
+            fields.toUpperCase();
+            int start = 0;
+            while (start <= static_cast<int>(fields.length())) {
+                int end = fields.indexOf(',', start);
+                if (end < 0) {
+                    end = fields.length();
+                }
+                const String token = fields.substring(start, end);
+                for (const auto& entry : fieldTokens) {
+                    if (token == entry.token) {
+                        fieldMask |= 1ul << entry.id;
+                    }
+                }
+                start = end + 1;
+            }
+        }
+
+        // "?precision=N" caps the decimals per value below the field's
+        // own digits metadata, for pollers that want even smaller
+        // payloads than the default display precision
+        uint8_t maxPrecision = 0xff;
+        if (request->hasParam("precision")) {
+            maxPrecision = min<long>(request->getParam("precision")->value().toInt(), 0xff);
+        }
+
+        // Cursor pagination over the inverter list: "?cursor=N" starts
+        // at position N, "?limit=M" caps the page size. The tail
+        // carries next_cursor while more inverters remain
+        const uint8_t numInverters = Hoymiles.getNumInverters();
+        uint8_t cursor = 0;
+        uint8_t limit = numInverters;
+        if (request->hasParam("cursor")) {
+            cursor = min<long>(request->getParam("cursor")->value().toInt(), numInverters);
+        }
+        if (request->hasParam("limit") && request->getParam("limit")->value().toInt() > 0) {
+            limit = min<long>(request->getParam("limit")->value().toInt(), numInverters);
+        }
+
+        // Emit the response inverter by inverter instead of
+        // materializing one fleet-sized document, so peak memory stays
+        // bounded at a single inverter regardless of fleet size
+        auto stream = request->beginResponseStream("application/json");
+
+        stream->print("{\"inverters\":[");
+
+        bool first = true;
+        auto emitInverter = [&first, &stream, fieldMask, maxPrecision](std::shared_ptr<InverterAbstract> inv, const bool withChannels) {
+            LivedataArena.reset();
+            JsonDocument doc(&LivedataArena);
+            JsonObject invObject = doc.to<JsonObject>();
+            generateInverterCommonJsonResponse(invObject, inv);
+            if (withChannels) {
+                generateInverterChannelJsonResponse(invObject, inv, 0, false, fieldMask, maxPrecision);
+            }
+
+            if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
+                return;
+            }
+
+            if (!first) {
+                stream->print(',');
+            }
+            first = false;
+            serializeJson(doc, *stream);
+        };
+
+        uint8_t next = 0;
         if (serial > 0) {
             auto inv = Hoymiles.getInverterBySerial(serial);
             if (inv != nullptr) {
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
-                generateInverterChannelJsonResponse(invObject, inv);
+                emitInverter(inv, true);
             }
         } else {
-            // Loop all inverters
-            for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-                auto inv = Hoymiles.getInverterByPos(i);
+            // Loop the requested page; a projected query is a
+            // monitoring query and gets its channel fields inline
+            uint8_t emitted = 0;
+            for (next = cursor; next < numInverters && emitted < limit; next++) {
+                auto inv = Hoymiles.getInverterByPos(next);
                 if (inv == nullptr) {
                     continue;
                 }
 
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
+                emitInverter(inv, fieldMask != 0);
+                emitted++;
             }
         }
 
-        generateCommonJsonResponse(root);
+        LivedataArena.reset();
+        JsonDocument commonDoc(&LivedataArena);
+        JsonVariant common = commonDoc.to<JsonVariant>();
+        generateCommonJsonResponse(common);
+
+        stream->print("],\"total\":");
+        serializeJson(common["total"], *stream);
+        stream->print(",\"hints\":");
+        serializeJson(common["hints"], *stream);
+        if (serial == 0 && next < numInverters) {
+            stream->printf(",\"next_cursor\":%u", static_cast<unsigned>(next));
+        }
+        stream->print('}');
 
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        stream->addHeader("Cache-Control", "no-cache");
+        request->send(stream);
 
     } catch (const std::bad_alloc& bad_alloc) {
         ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -2,8 +2,17 @@
 /*
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
+#include "AllocMonitor.h"
+#include "BootProfiler.h"
+#include "CrashRecorder.h"
 #include "Configuration.h"
+#include "DailyStats.h"
 #include "Datastore.h"
+#include "EnergyLedger.h"
+#include "Federation.h"
+#include "FleetWalk.h"
+#include "HeapMonitor.h"
+#include "JsonArena.h"
 #include "Display_Graphic.h"
 #include "I18n.h"
 #include "InverterSettings.h"
@@ -20,8 +29,13 @@
 #include "PinMapping.h"
 #include "RestartHelper.h"
 #include "Scheduler.h"
+#include "SchedulerMonitor.h"
+#include "SoakLog.h"
 #include "SunPosition.h"
+#include "TaskMonitor.h"
+#include "ThermalGovernor.h"
 #include "Utils.h"
+#include "WarmStart.h"
 #include "WebApi.h"
 #include "defaults.h"
 #include <Arduino.h>
@@ -46,6 +60,25 @@ void setup()
 #endif
     MessageOutput.init(scheduler);
 
+    BootProfiler.begin();
+    CrashRecorder.init(scheduler);
+    TaskMonitor.init();
+    SchedulerMonitor.init(scheduler);
+    AllocMonitor.init(scheduler);
+    HeapMonitor.init(scheduler);
+    HeapMonitor.registerConsumer("jsonarena_mqtt", []() { return MqttPayloadArena.highWaterMark(); });
+    HeapMonitor.registerConsumer("jsonarena_livedata", []() { return LivedataArena.highWaterMark(); });
+    ThermalGovernor.init(scheduler);
+    // drop to warnings while hot; applyLogLevels() restores the
+    // configured levels on release
+    ThermalGovernor.registerThrottle("log_verbosity", [](const bool active) {
+        if (active) {
+            esp_log_level_set("*", ESP_LOG_WARN);
+        } else {
+            Logging.applyLogLevels();
+        }
+    });
+
     // For now, the log levels are just hard coded
     esp_log_level_set("*", ESP_LOG_VERBOSE);
     esp_log_level_set("CORE", ESP_LOG_ERROR);
@@ -59,6 +92,7 @@ void setup()
         const bool success = LittleFS.begin(true);
         ESP_LOG_LEVEL_LOCAL((success ? ESP_LOG_INFO : ESP_LOG_ERROR), TAG, "FS reformat %s", success ? "successful" : "failed");
     }
+    BootProfiler.mark("filesystem");
 
     // Read configuration values
     ESP_LOGI(TAG, "Reading configuration...");
@@ -73,6 +107,7 @@ void setup()
             Configuration.get().Cfg.Version, CONFIG_VERSION);
         Configuration.migrate();
     }
+    BootProfiler.mark("configuration");
 
     // Set configured log levels
     Logging.applyLogLevels();
@@ -81,6 +116,7 @@ void setup()
     // Read languate pack
     ESP_LOGI(TAG, "Reading language pack...");
     I18n.init(scheduler);
+    BootProfiler.mark("i18n");
 
     // Load PinMapping
     ESP_LOGI(TAG, "Reading PinMapping...");
@@ -89,44 +125,73 @@ void setup()
     } else {
         ESP_LOGW(TAG, "Didn't found valid mapping. Using default.");
     }
+    BootProfiler.mark("pinmapping");
 
     // Initialize Network
     ESP_LOGI(TAG, "Initializing Network...");
     NetworkSettings.init(scheduler);
     NetworkSettings.applyConfig();
+    BootProfiler.mark("network");
+
+    // Start the inverter radio bring-up in parallel: the SPI probe is
+    // the slowest blocking I/O left in setup() and only depends on the
+    // pin mapping and configuration. It must start after the network
+    // init so the SpiManager bus claims stay ordered (the W5500 driver
+    // claims its bus in there); InverterSettings.init() joins the
+    // worker below.
+    InverterSettings.beginRadioInit();
 
     // Initialize NTP
     ESP_LOGI(TAG, "Initializing NTP...");
-    NtpSettings.init();
+    NtpSettings.init(scheduler);
+    BootProfiler.mark("ntp");
 
     // Initialize SunPosition
     ESP_LOGI(TAG, "Initializing SunPosition...");
     SunPosition.init(scheduler);
+    BootProfiler.mark("sunposition");
 
     // Initialize MqTT
     ESP_LOGI(TAG, "Initializing MQTT...");
     MqttSettings.init();
+    HeapMonitor.registerLoadShedder("mqtt_telemetry_backlog", []() { MqttSettings.shedTelemetryBacklog(); });
     MqttHandleDtu.init(scheduler);
     MqttHandleInverter.init(scheduler);
     MqttHandleInverterTotal.init(scheduler);
     MqttHandleHass.init(scheduler);
+    BootProfiler.mark("mqtt");
 
     // Initialize WebApi
     ESP_LOGI(TAG, "Initializing WebApi...");
     WebApi.init(scheduler);
+    BootProfiler.mark("webapi");
 
     // Initialize Display
     ESP_LOGI(TAG, "Initializing Display...");
     Display.init(scheduler);
+    ThermalGovernor.registerThrottle("display_contrast", [](const bool active) {
+        const uint8_t contrast = Configuration.get().Display.Contrast;
+        Display.setContrast(active ? contrast / 2 : contrast);
+    });
+    BootProfiler.mark("display");
 
     // Initialize Single LEDs
     ESP_LOGI(TAG, "Initializing LEDs...");
     LedSingle.init(scheduler);
+    BootProfiler.mark("leds");
 
     InverterSettings.init(scheduler);
+    WarmStart.init(scheduler);
+    Federation.init(scheduler);
+    BootProfiler.mark("inverter");
 
+    FleetWalk.init(scheduler);
     Datastore.init(scheduler);
+    DailyStats.init();
+    EnergyLedger.init(scheduler);
+    SoakLog.init(scheduler);
     RestartHelper.init(scheduler);
+    BootProfiler.mark("complete");
 
     ESP_LOGI(TAG, "Startup complete");
 }
@@ -134,4 +199,8 @@ void setup()
 void loop()
 {
     scheduler.execute();
+
+    // One tick per scheduler pass; the pass-to-pass gap is the latency
+    // every task in the cooperative loop experiences
+    SchedulerMonitor.loopTick();
 }
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Folds a task sample dump into flamegraph input.
+
+Fetch a capture from a device and render it:
+
+    curl -u admin:PASSWORD -X POST http://DTU/api/profiler/samples/start
+    sleep 30
+    curl -u admin:PASSWORD -o tasksamples.bin http://DTU/api/profiler/samples
+    ./fold_task_samples.py tasksamples.bin | flamegraph.pl > profile.svg
+
+The dump format is described in src/WebApi_profiler.cpp: a header,
+a slot-index-to-task-name table and one slot index byte per core per
+sampler tick. Output is one folded line per core/task combination
+("core0;loopTask 1234"), which flamegraph.pl or speedscope accept
+directly.
+"""
+
+import struct
+import sys
+from collections import Counter
+
+MAGIC = 0x53544F44  # "DOTS"
+HEADER = struct.Struct("<7I")
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"usage: {sys.argv[0]} tasksamples.bin")
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    magic, version, interval_us, cores, slots, name_len, count = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        sys.exit("not a task sample dump (bad magic)")
+    if version != 1:
+        sys.exit(f"unsupported dump version {version}")
+
+    names = []
+    offset = HEADER.size
+    for _ in range(slots):
+        raw = data[offset:offset + name_len]
+        names.append(raw.split(b"\0", 1)[0].decode() or "unknown")
+        offset += name_len
+
+    samples = data[offset:offset + count]
+    print(f"# {count} samples, {cores} cores, {interval_us} us interval "
+          f"({count // cores * interval_us / 1e6:.1f} s wall time)", file=sys.stderr)
+
+    folded = Counter()
+    for i, slot in enumerate(samples):
+        core = i % cores
+        name = names[slot] if slot < slots else "unknown"
+        folded[f"core{core};{name}"] += 1
+
+    for stack, n in folded.most_common():
+        print(f"{stack} {n}")
+
+
+if __name__ == "__main__":
+    main()
@@ -7,7 +7,11 @@ export interface MqttConfig {
     mqtt_password: string;
     mqtt_topic: string;
     mqtt_publish_interval: number;
+    mqtt_full_publish_interval: number;
     mqtt_clean_session: boolean;
+    mqtt_compact_json: boolean;
+    mqtt_compact_json_compress: boolean;
+    mqtt_limit_coalesce_window: number;
     mqtt_retain: boolean;
     mqtt_tls: boolean;
     mqtt_root_ca_cert: string;